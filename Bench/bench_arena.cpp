@@ -0,0 +1,226 @@
+//---------------------------------------------------------------------------
+// Load/teardown cost of a configuration-shaped tree: allocation count and
+// time for
+//
+//   - std::map children and values, one heap node per child (the layout
+//     before TFlatMap),
+//   - TFlatMap on the global heap (TArenaAllocator without an arena),
+//   - TFlatMap and nodes in a TConfigArena (what Anafestica::TConfig does).
+//
+// Portable (std-only):
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_arena.cpp -o bench_arena
+//   ./bench_arena
+//
+// std::wstring stands in for System::String; key strings are allocated in
+// all three layouts (a UnicodeString always owns a heap buffer), so the
+// drop in the count is entirely due to nodes and containers.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgArena.h>
+#include <anafestica/CfgFlatMap.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace {
+
+std::size_t AllocCount {};
+std::size_t FreeCount {};
+
+} // namespace
+
+void* operator new( std::size_t Size )
+{
+    ++AllocCount;
+    if ( auto p = std::malloc( Size ? Size : 1 ) ) { return p; }
+    throw std::bad_alloc{};
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    if ( Ptr ) { ++FreeCount; std::free( Ptr ); }
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    operator delete( Ptr );
+}
+
+namespace {
+
+using Anafestica::TArenaAllocator;
+using Anafestica::TConfigArena;
+using Anafestica::TFlatMap;
+using Anafestica::TKeyLess;
+
+constexpr int FanOut = 6;
+constexpr int Depth = 6;          // 1 + 6 + ... + 6^6 = 55987 nodes
+constexpr int ValuesPerNode = 4;
+
+// Pre-TFlatMap layout.
+struct MapNode {
+    std::map<std::wstring,int> Values;
+    std::map<std::wstring,std::unique_ptr<MapNode>> Children;
+};
+
+// Current layout.
+struct FlatNode;
+
+struct FlatNodeDeleter {
+    TConfigArena* Arena {};
+    void operator()( FlatNode* Node ) const noexcept;
+};
+
+using FlatNodePtr = std::unique_ptr<FlatNode,FlatNodeDeleter>;
+
+template<typename T>
+using Map =
+    TFlatMap<
+        std::wstring, T, TKeyLess,
+        TArenaAllocator<std::pair<std::wstring,T>>
+    >;
+
+struct FlatNode {
+    explicit FlatNode( TConfigArena* Arena )
+        : Values( Arena ), Children( Arena ) {}
+    Map<int> Values;
+    Map<FlatNodePtr> Children;
+};
+
+void FlatNodeDeleter::operator()( FlatNode* Node ) const noexcept
+{
+    Anafestica::ArenaDelete( Arena, Node );
+}
+
+// Keys are pre-built, so building them does not count towards any layout
+// (only the copies stored in the containers do).
+std::wstring const & ValueKey( int Idx )
+{
+    static std::wstring const Keys[] = {
+        L"Value_0", L"Value_1", L"Value_2", L"Value_3",
+        L"Value_4", L"Value_5", L"Value_6", L"Value_7",
+    };
+    return Keys[Idx];
+}
+
+std::wstring const & NodeKey( int Idx )
+{
+    static std::wstring const Keys[] = {
+        L"Node_00", L"Node_01", L"Node_02", L"Node_03",
+        L"Node_04", L"Node_05", L"Node_06", L"Node_07",
+    };
+    return Keys[Idx];
+}
+
+void Load( MapNode& Node, int Level )
+{
+    for ( int v = 0 ; v < ValuesPerNode ; ++v ) {
+        Node.Values.emplace( ValueKey( v ), v );
+    }
+    if ( Level == Depth ) { return; }
+    for ( int c = 0 ; c < FanOut ; ++c ) {
+        auto& Child =
+            *Node.Children.emplace(
+                NodeKey( c ), std::make_unique<MapNode>()
+            ).first->second;
+        Load( Child, Level + 1 );
+    }
+}
+
+void Load( FlatNode& Node, TConfigArena* Arena, int Level )
+{
+    for ( int v = 0 ; v < ValuesPerNode ; ++v ) {
+        Node.Values.try_emplace( ValueKey( v ), v );
+    }
+    if ( Level == Depth ) { return; }
+    for ( int c = 0 ; c < FanOut ; ++c ) {
+        auto& Child =
+            *Node.Children.try_emplace(
+                NodeKey( c ),
+                FlatNodePtr(
+                    Anafestica::ArenaNew<FlatNode>( Arena, Arena ),
+                    FlatNodeDeleter{ Arena }
+                )
+            ).first->second;
+        Load( Child, Arena, Level + 1 );
+    }
+}
+
+struct Result {
+    std::size_t LoadAllocs;
+    std::size_t TeardownFrees;
+    double LoadMs;
+    double TeardownMs;
+};
+
+template<typename LoadFn, typename TeardownFn>
+Result Measure( LoadFn&& DoLoad, TeardownFn&& DoTeardown )
+{
+    using Clock = std::chrono::steady_clock;
+    Result r {};
+    auto const a0 = AllocCount;
+    auto const t0 = Clock::now();
+    DoLoad();
+    auto const t1 = Clock::now();
+    r.LoadAllocs = AllocCount - a0;
+    auto const f0 = FreeCount;
+    DoTeardown();
+    auto const t2 = Clock::now();
+    r.TeardownFrees = FreeCount - f0;
+    r.LoadMs = std::chrono::duration<double,std::milli>( t1 - t0 ).count();
+    r.TeardownMs = std::chrono::duration<double,std::milli>( t2 - t1 ).count();
+    return r;
+}
+
+void Print( char const * Name, Result const & r )
+{
+    std::printf(
+        "%-22s | %9zu allocs %8.2f ms | %9zu frees %8.2f ms\n",
+        Name, r.LoadAllocs, r.LoadMs, r.TeardownFrees, r.TeardownMs
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "%-22s | %-26s | %s\n", "layout", "load", "teardown" );
+
+    std::unique_ptr<MapNode> MapRoot;
+    Print( "std::map", Measure(
+        [&]{ MapRoot = std::make_unique<MapNode>(); Load( *MapRoot, 0 ); },
+        [&]{ MapRoot.reset(); }
+    ) );
+
+    std::unique_ptr<FlatNode> HeapRoot;
+    Print( "TFlatMap, heap", Measure(
+        [&]{
+            HeapRoot = std::make_unique<FlatNode>( nullptr );
+            Load( *HeapRoot, nullptr, 0 );
+        },
+        [&]{ HeapRoot.reset(); }
+    ) );
+
+    std::unique_ptr<TConfigArena> Arena;
+    std::unique_ptr<FlatNode> ArenaRoot;
+    Print( "TFlatMap, TConfigArena", Measure(
+        [&]{
+            Arena = std::make_unique<TConfigArena>();
+            ArenaRoot = std::make_unique<FlatNode>( Arena.get() );
+            Load( *ArenaRoot, Arena.get(), 0 );
+        },
+        [&]{ ArenaRoot.reset(); Arena.reset(); }
+    ) );
+
+    std::printf(
+        "every layout also allocates %d value keys per node and %d child keys "
+        "per inner node\n", ValuesPerNode, FanOut
+    );
+    return 0;
+}
@@ -0,0 +1,811 @@
+//---------------------------------------------------------------------------
+// Eager BSON load and flush benchmark, against the JSON backend.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_bson.cpp -o bench_bson
+//   ./bench_bson
+//
+// "before" is what BSON::TConfig did: on load, render the file as JSON text
+// (TBsonReader into TJsonTextWriter), parse the text into a document (one
+// heap object per value, member and key, as TJSONObject does) and walk it
+// to build the tree; on flush, load the document that way, edit it, render
+// it as JSON text again and parse that text into a BSON writer (ToJSON,
+// TJsonTextReader, TBsonWriter).  "after" is what it does now: a
+// BSON::Wire::TCursor walk straight into the tree, and a walk copying the
+// file's elements to a BSON::Wire::TWriter with the edits merged in.
+// "json" is the JSON backend's eager path on the same configuration
+// (JSON::Sax::Parse into the tree, and into a TTextWriter), for scale.
+// One value per node is edited.  std::wstring stands in for
+// System::String and a std::map of std::variant for the node containers.
+// Allocation counts and the peak of live heap bytes come from a counting
+// operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgBSONWire.h>
+#include <anafestica/CfgJSONSax.h>
+#include <anafestica/CfgJSONWriter.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+std::size_t Live;
+std::size_t Peak;
+
+} // namespace
+
+// Every block carries its size in front, so that delete can account for it.
+void* operator new( std::size_t Size )
+{
+    auto const Block = static_cast<std::size_t*>( std::malloc( Size + 16 ) );
+    if ( !Block ) {
+        throw std::bad_alloc{};
+    }
+    *Block = Size;
+    ++Allocs;
+    Live += Size;
+    if ( Live > Peak ) { Peak = Live; }
+    return reinterpret_cast<char*>( Block ) + 16;
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    if ( Ptr ) {
+        auto const Block = reinterpret_cast<std::size_t*>( static_cast<char*>( Ptr ) - 16 );
+        Live -= *Block;
+        std::free( Block );
+    }
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    operator delete( Ptr );
+}
+
+namespace {
+
+namespace Sax = Anafestica::JSON::Sax;
+namespace Wire = Anafestica::BSON::Wire;
+using Anafestica::JSON::TTextWriter;
+using Anafestica::JSON::TMemorySink;
+
+using Value = std::variant<int,bool,double,long long,std::wstring,std::vector<std::wstring>>;
+
+struct Node {
+    std::map<std::wstring,Value> Values;
+    std::map<std::wstring,std::unique_ptr<Node>> Nodes;
+};
+
+// The value every node gets in place of its "Left".
+constexpr int Edited = 4321;
+
+volatile std::size_t Sink;
+
+std::wstring Widen( std::string_view Text )
+{
+    return std::wstring( Text.begin(), Text.end() );
+}
+
+void Quote( std::string_view Text, std::string& Out )
+{
+    Out.assign( 1, '"' );
+    Out.append( Text.begin(), Text.end() );
+    Out += '"';
+}
+
+// Synthetic configuration: Count nodes, three levels deep, each holding a
+// mix of implicit and tagged values (the file bench_json_sax reads), as
+// BSON and as JSON text.
+struct Files {
+    std::string Bson;
+    std::string Json;
+};
+
+Files MakeFiles( std::size_t Count )
+{
+    Files Result;
+    Wire::TWriter<> Out( Result.Bson );
+    auto& Doc = Result.Json;
+    std::size_t Made {};
+    auto AddNode = [&]( auto& Self, std::size_t Level ) -> void {
+        auto const Id = std::to_string( Made );
+        auto const Caption = "Window " + Id;
+        Out.BeginDocument();
+        Out.Key( "values" );
+        Out.BeginDocument();
+        Out.Key( "Left" ); Out.Int32( static_cast<int>( Made++ ) );
+        Out.Key( "Top" ); Out.Int32( 120 );
+        Out.Key( "Width" ); Out.Int32( 640 );
+        Out.Key( "Height" ); Out.Int32( 480 );
+        Out.Key( "Caption" ); Out.String( Caption );
+        Out.Key( "Visible" ); Out.Bool( true );
+        Out.Key( "Ratio" ); Out.BeginDocument(); Out.Key( "dbl" ); Out.Double( 0.75 ); Out.End();
+        Out.Key( "Stamp" ); Out.BeginDocument(); Out.Key( "ll" ); Out.Int64( 1700000000000 ); Out.End();
+        Out.Key( "Recent" ); Out.BeginDocument(); Out.Key( "sv" );
+        Out.BeginArray(); Out.String( "a.txt" ); Out.String( "b.txt" ); Out.String( "c.txt" ); Out.End();
+        Out.End();
+        Out.End();
+        Doc += R"({"values":{)";
+        Doc += R"("Left":)" + Id + R"(,"Top":120,"Width":640,"Height":480,)";
+        Doc += R"("Caption":")" + Caption + R"(","Visible":true,)";
+        Doc += R"("Ratio":{"dbl":0.75},"Stamp":{"ll":1700000000000},)";
+        Doc += R"("Recent":{"sv":["a.txt","b.txt","c.txt"]}})";
+        if ( Level < 2 ) {
+            Out.Key( "nodes" );
+            Out.BeginDocument();
+            Doc += R"(,"nodes":{)";
+            for ( int Idx = 0 ; Idx < 3 && Made < Count ; ++Idx ) {
+                auto const Name = "Child" + std::to_string( Idx );
+                if ( Idx ) { Doc += ','; }
+                Doc += '"' + Name + "\":";
+                Out.Key( Name );
+                Self( Self, Level + 1 );
+            }
+            Out.End();
+            Doc += '}';
+        }
+        Out.End();
+        Doc += '}';
+    };
+    Out.BeginDocument();
+    Out.Key( "nodes" );
+    Out.BeginDocument();
+    Doc += R"({"nodes":{)";
+    for ( std::size_t Idx {} ; Made < Count ; ++Idx ) {
+        auto const Name = "Form" + std::to_string( Idx );
+        if ( Idx ) { Doc += ','; }
+        Doc += '"' + Name + "\":";
+        Out.Key( Name );
+        AddNode( AddNode, 0 );
+    }
+    Out.End();
+    Out.End();
+    Doc += "}}";
+    return Result;
+}
+
+Value DecodeTagged( std::string_view Tag, std::string_view Text,
+                    std::vector<std::wstring>&& Strings )
+{
+    if ( Tag == "dbl" ) { return std::strtod( std::string( Text ).c_str(), nullptr ); }
+    if ( Tag == "ll" ) { return std::strtoll( std::string( Text ).c_str(), nullptr, 10 ); }
+    return std::move( Strings );
+}
+
+//---------------------------------------------------------------------------
+// before: BSON -> JSON text -> document, and back
+
+// TBsonReader feeding TJsonTextWriter.
+template<typename W>
+void RenderBson( std::string_view Document, bool IsArray, W& Out, std::string& Scratch )
+{
+    IsArray ? Out.BeginArray() : Out.BeginObject();
+    Wire::TCursor Cursor( Document );
+    for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+        if ( !IsArray ) {
+            Quote( Element.Name, Scratch );
+            Out.Name( Scratch );
+        }
+        switch ( Element.Type ) {
+            case Wire::TType::Document:
+            case Wire::TType::Array:
+                RenderBson(
+                    Element.GetDocument(), Element.Type == Wire::TType::Array,
+                    Out, Scratch
+                );
+                break;
+            case Wire::TType::String:
+                Quote( Element.GetString(), Scratch );
+                Out.Scalar( Scratch );
+                break;
+            case Wire::TType::Int32:
+                Out.Scalar( std::to_string( Element.GetInt32() ) );
+                break;
+            case Wire::TType::Int64:
+                Out.Scalar( std::to_string( Element.GetInt64() ) );
+                break;
+            case Wire::TType::Double: {
+                char Digits[32];
+                std::snprintf( Digits, sizeof Digits, "%.17g", Element.GetDouble() );
+                Out.Scalar( Digits );
+                break;
+            }
+            case Wire::TType::Bool:
+                Out.Scalar( Element.GetBool() ? "true" : "false" );
+                break;
+            default:
+                Out.Scalar( "null" );
+                break;
+        }
+    }
+    IsArray ? Out.EndArray() : Out.EndObject();
+}
+
+std::string BsonToJson( std::string const & Bson )
+{
+    std::string Text;
+    TMemorySink<> Sink{ Text };
+    TTextWriter<TMemorySink<>> Out{ Sink, 0 };
+    std::string Scratch;
+    RenderBson( Bson, false, Out, Scratch );
+    return Text;
+}
+
+struct Json {
+    enum Kind { Object, Array, String, Number, Bool, Null } Type;
+    std::string Text;
+    std::vector<std::pair<std::unique_ptr<Json>,std::unique_ptr<Json>>> Members;
+    std::vector<std::unique_ptr<Json>> Items;
+
+    Json* Find( std::string_view Name ) const {
+        for ( auto const & Member : Members ) {
+            if ( Member.first->Text == Name ) { return Member.second.get(); }
+        }
+        return nullptr;
+    }
+};
+
+class DomBuilder {
+public:
+    std::unique_ptr<Json> Root;
+
+    bool StartObject() { Push( Json::Object ); return true; }
+    bool Key( std::string_view Name ) {
+        auto& Top = *stack_.back();
+        Top.Members.emplace_back( Make( Json::String, Name ), nullptr );
+        return true;
+    }
+    void EndObject() { stack_.pop_back(); }
+    bool StartArray() { Push( Json::Array ); return true; }
+    void EndArray() { stack_.pop_back(); }
+    void String( std::string_view Text ) { Add( Make( Json::String, Text ) ); }
+    void Number( std::string_view Text ) { Add( Make( Json::Number, Text ) ); }
+    void Bool( bool Val ) { Add( Make( Json::Bool, Val ? "true" : "false" ) ); }
+    void Null() { Add( Make( Json::Null, "null" ) ); }
+private:
+    std::vector<Json*> stack_;
+
+    static std::unique_ptr<Json> Make( Json::Kind Type, std::string_view Text ) {
+        auto Item = std::make_unique<Json>();
+        Item->Type = Type;
+        Item->Text = Text;
+        return Item;
+    }
+
+    Json* Add( std::unique_ptr<Json> Item ) {
+        auto const Ptr = Item.get();
+        if ( stack_.empty() ) {
+            Root = std::move( Item );
+        }
+        else if ( stack_.back()->Type == Json::Array ) {
+            stack_.back()->Items.push_back( std::move( Item ) );
+        }
+        else {
+            stack_.back()->Members.back().second = std::move( Item );
+        }
+        return Ptr;
+    }
+
+    void Push( Json::Kind Type ) {
+        stack_.push_back( Add( Make( Type, {} ) ) );
+    }
+};
+
+std::unique_ptr<Json> LoadDocument( std::string const & Bson )
+{
+    auto const Text = BsonToJson( Bson );
+    DomBuilder Builder;
+    Sax::Parse( Text.data(), Text.data() + Text.size(), Builder );
+    return std::move( Builder.Root );
+}
+
+void Walk( Json const & Obj, Node& Into )
+{
+    if ( auto const Values = Obj.Find( "values" ) ) {
+        for ( auto const & Member : Values->Members ) {
+            auto const & Val = *Member.second;
+            auto Name = Widen( Member.first->Text );
+            switch ( Val.Type ) {
+                case Json::Number: Into.Values[Name] = std::atoi( Val.Text.c_str() ); break;
+                case Json::String: Into.Values[Name] = Widen( Val.Text ); break;
+                case Json::Bool:   Into.Values[Name] = Val.Text == "true"; break;
+                case Json::Object:
+                    if ( Val.Members.size() == 1 ) {
+                        auto const & Payload = *Val.Members[0].second;
+                        std::vector<std::wstring> Strings;
+                        for ( auto const & Item : Payload.Items ) {
+                            Strings.push_back( Widen( Item->Text ) );
+                        }
+                        Into.Values[Name] =
+                            DecodeTagged(
+                                Val.Members[0].first->Text, Payload.Text,
+                                std::move( Strings )
+                            );
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    if ( auto const Nodes = Obj.Find( "nodes" ) ) {
+        for ( auto const & Member : Nodes->Members ) {
+            if ( Member.second->Type == Json::Object ) {
+                auto& Child = Into.Nodes[Widen( Member.first->Text )];
+                Child = std::make_unique<Node>();
+                Walk( *Member.second, *Child );
+            }
+        }
+    }
+}
+
+std::unique_ptr<Node> LoadBefore( Files const & In )
+{
+    auto const Document = LoadDocument( In.Bson );
+    auto Root = std::make_unique<Node>();
+    Walk( *Document, *Root );
+    return Root;
+}
+
+void Edit( Json& Obj )
+{
+    if ( auto const Values = Obj.Find( "values" ) ) {
+        if ( auto const Left = Values->Find( "Left" ) ) {
+            Left->Text = std::to_string( Edited );
+        }
+    }
+    if ( auto const Nodes = Obj.Find( "nodes" ) ) {
+        for ( auto const & Member : Nodes->Members ) {
+            Edit( *Member.second );
+        }
+    }
+}
+
+template<typename W>
+void Render( Json const & Val, W& Out, std::string& Scratch )
+{
+    switch ( Val.Type ) {
+        case Json::Object:
+            Out.BeginObject();
+            for ( auto const & Member : Val.Members ) {
+                Quote( Member.first->Text, Scratch );
+                Out.Name( Scratch );
+                Render( *Member.second, Out, Scratch );
+            }
+            Out.EndObject();
+            break;
+        case Json::Array:
+            Out.BeginArray();
+            for ( auto const & Item : Val.Items ) {
+                Render( *Item, Out, Scratch );
+            }
+            Out.EndArray();
+            break;
+        case Json::String:
+            Quote( Val.Text, Scratch );
+            Out.Scalar( Scratch );
+            break;
+        default:
+            Out.Scalar( Val.Text );
+            break;
+    }
+}
+
+// TJsonTextReader feeding TBsonWriter.
+class BsonBuilder {
+public:
+    explicit BsonBuilder( std::string& Out ) : out_{ Out } {}
+
+    bool StartObject() { out_.BeginDocument(); return true; }
+    bool Key( std::string_view Name ) { key_ = Name; out_.Key( key_ ); return true; }
+    void EndObject() { out_.End(); }
+    bool StartArray() { out_.BeginArray(); return true; }
+    void EndArray() { out_.End(); }
+    void String( std::string_view Text ) { out_.String( Text ); }
+    void Number( std::string_view Text ) {
+        if ( Text.find_first_of( ".eE" ) != std::string_view::npos ) {
+            out_.Double( std::strtod( std::string( Text ).c_str(), nullptr ) );
+            return;
+        }
+        auto const Val = std::strtoll( std::string( Text ).c_str(), nullptr, 10 );
+        if ( Val >= INT32_MIN && Val <= INT32_MAX ) { out_.Int32( static_cast<int>( Val ) ); }
+        else { out_.Int64( Val ); }
+    }
+    void Bool( bool Val ) { out_.Bool( Val ); }
+    void Null() { out_.Null(); }
+private:
+    Wire::TWriter<> out_;
+    std::string key_;
+};
+
+std::size_t FlushBefore( Files const & In )
+{
+    auto const Document = LoadDocument( In.Bson );
+    Edit( *Document );
+    std::string Text;
+    {
+        TMemorySink<> Sink{ Text };
+        TTextWriter<TMemorySink<>> Out{ Sink, 0 };
+        std::string Scratch;
+        Render( *Document, Out, Scratch );
+    }
+    std::string Bytes;
+    BsonBuilder Builder{ Bytes };
+    Sax::Parse( Text.data(), Text.data() + Text.size(), Builder );
+    return Bytes.size();
+}
+
+//---------------------------------------------------------------------------
+// after: straight from and to the bytes
+
+void ReadValues( std::string_view Document, Node& Into )
+{
+    Wire::TCursor Cursor( Document );
+    for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+        auto Name = Widen( Element.Name );
+        switch ( Element.Type ) {
+            case Wire::TType::Int32:  Into.Values[Name] = Element.GetInt32(); break;
+            case Wire::TType::String: Into.Values[Name] = Widen( Element.GetString() ); break;
+            case Wire::TType::Bool:   Into.Values[Name] = Element.GetBool(); break;
+            case Wire::TType::Document: {
+                Wire::TCursor Inner( Element.GetDocument() );
+                Wire::TElement Payload;
+                if ( !Inner.Next( Payload ) ) { break; }
+                switch ( Payload.Type ) {
+                    case Wire::TType::Double: Into.Values[Name] = Payload.GetDouble(); break;
+                    case Wire::TType::Int64:  Into.Values[Name] = static_cast<long long>( Payload.GetInt64() ); break;
+                    case Wire::TType::Array: {
+                        std::vector<std::wstring> Strings;
+                        Wire::TCursor Items( Payload.GetDocument() );
+                        for ( Wire::TElement Item ; Items.Next( Item ) ; ) {
+                            Strings.push_back( Widen( Item.GetString() ) );
+                        }
+                        Into.Values[Name] = std::move( Strings );
+                        break;
+                    }
+                    default:
+                        break;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void ReadNode( std::string_view Document, Node& Into )
+{
+    Wire::TCursor Cursor( Document );
+    for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+        if ( Element.Name == "values" ) {
+            ReadValues( Element.GetDocument(), Into );
+        }
+        else if ( Element.Name == "nodes" ) {
+            Wire::TCursor Nodes( Element.GetDocument() );
+            for ( Wire::TElement Child ; Nodes.Next( Child ) ; ) {
+                auto& Ptr = Into.Nodes[Widen( Child.Name )];
+                Ptr = std::make_unique<Node>();
+                ReadNode( Child.GetDocument(), *Ptr );
+            }
+        }
+    }
+}
+
+std::unique_ptr<Node> LoadAfter( Files const & In )
+{
+    auto Root = std::make_unique<Node>();
+    ReadNode( In.Bson, *Root );
+    return Root;
+}
+
+void MergeNode( std::string_view Document, Wire::TWriter<>& Out )
+{
+    Wire::TCursor Cursor( Document );
+    for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+        if ( Element.Name == "values" ) {
+            Out.Key( Element.Name );
+            Out.BeginDocument();
+            Wire::TCursor Values( Element.GetDocument() );
+            for ( Wire::TElement Value ; Values.Next( Value ) ; ) {
+                if ( Value.Name == "Left" ) {
+                    Out.Key( Value.Name );
+                    Out.Int32( Edited );
+                }
+                else {
+                    Out.Copy( Value );
+                }
+            }
+            Out.End();
+        }
+        else if ( Element.Name == "nodes" ) {
+            Out.Key( Element.Name );
+            Out.BeginDocument();
+            Wire::TCursor Nodes( Element.GetDocument() );
+            for ( Wire::TElement Child ; Nodes.Next( Child ) ; ) {
+                Out.Key( Child.Name );
+                Out.BeginDocument();
+                MergeNode( Child.GetDocument(), Out );
+                Out.End();
+            }
+            Out.End();
+        }
+        else {
+            Out.Copy( Element );
+        }
+    }
+}
+
+std::size_t FlushAfter( Files const & In )
+{
+    std::string Bytes;
+    Wire::TWriter<> Out( Bytes );
+    Out.BeginDocument();
+    MergeNode( In.Bson, Out );
+    Out.End();
+    return Bytes.size();
+}
+
+//---------------------------------------------------------------------------
+// json: the JSON backend's eager load and flush
+
+class TreeBuilder {
+public:
+    Node Root;
+
+    bool StartObject() {
+        if ( states_.empty() ) {
+            nodes_.push_back( &Root );
+            states_.push_back( InNode );
+            return true;
+        }
+        switch ( states_.back() ) {
+            case InNode: states_.push_back( member_ ); return true;
+            case InValues: tag_.clear(); text_.clear(); strings_.clear();
+                           states_.push_back( InWrapper ); return true;
+            case InNodes: {
+                auto& Child = nodes_.back()->Nodes[name_];
+                Child = std::make_unique<Node>();
+                nodes_.push_back( Child.get() );
+                states_.push_back( InNode );
+                return true;
+            }
+            default: return false;
+        }
+    }
+
+    bool Key( std::string_view Name ) {
+        switch ( states_.back() ) {
+            case InNode:
+                if ( Name == "values" ) { member_ = InValues; return true; }
+                if ( Name == "nodes" ) { member_ = InNodes; return true; }
+                return false;
+            case InWrapper: tag_ = Name; return true;
+            default: name_ = Widen( Name ); return true;
+        }
+    }
+
+    void EndObject() {
+        auto const State = states_.back();
+        states_.pop_back();
+        if ( State == InWrapper ) {
+            nodes_.back()->Values[name_] = DecodeTagged( tag_, text_, std::move( strings_ ) );
+        }
+        else if ( State == InNode ) {
+            nodes_.pop_back();
+        }
+    }
+
+    bool StartArray() {
+        if ( states_.back() != InWrapper ) { return false; }
+        states_.push_back( InArray );
+        return true;
+    }
+
+    void EndArray() { states_.pop_back(); }
+
+    void String( std::string_view Text ) {
+        switch ( states_.back() ) {
+            case InValues: nodes_.back()->Values[name_] = Widen( Text ); break;
+            case InWrapper: text_ = Text; break;
+            case InArray: strings_.push_back( Widen( Text ) ); break;
+            default: break;
+        }
+    }
+
+    void Number( std::string_view Text ) {
+        if ( states_.back() == InValues ) {
+            nodes_.back()->Values[name_] = std::atoi( std::string( Text ).c_str() );
+        }
+        else if ( states_.back() == InWrapper ) {
+            text_ = Text;
+        }
+    }
+
+    void Bool( bool Val ) {
+        if ( states_.back() == InValues ) { nodes_.back()->Values[name_] = Val; }
+    }
+
+    void Null() {}
+private:
+    enum State { InNode, InValues, InNodes, InWrapper, InArray };
+
+    std::vector<Node*> nodes_;
+    std::vector<State> states_;
+    State member_ { InValues };
+    std::wstring name_;
+    std::string tag_;
+    std::string text_;
+    std::vector<std::wstring> strings_;
+};
+
+std::unique_ptr<Node> LoadJson( Files const & In )
+{
+    auto Builder = std::make_unique<TreeBuilder>();
+    Sax::Parse( In.Json.data(), In.Json.data() + In.Json.size(), *Builder );
+    auto Root = std::make_unique<Node>();
+    *Root = std::move( Builder->Root );
+    return Root;
+}
+
+class Flusher {
+public:
+    explicit Flusher( TMemorySink<>& Sink ) : out_{ Sink, 0 } {}
+
+    bool StartObject() {
+        states_.push_back( next_ );
+        next_ = Copy;
+        out_.BeginObject();
+        return true;
+    }
+
+    bool Key( std::string_view Name ) {
+        switch ( states_.back() ) {
+            case InNode:
+                if ( Name == "values" ) { next_ = InValues; }
+                else if ( Name == "nodes" ) { next_ = InNodes; }
+                break;
+            case InNodes:
+                next_ = InNode;
+                break;
+            case InValues:
+                if ( Name == "Left" ) {
+                    Quote( Name, scratch_ );
+                    out_.Name( scratch_ );
+                    out_.Scalar( std::to_string( Edited ) );
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+        Quote( Name, scratch_ );
+        out_.Name( scratch_ );
+        return true;
+    }
+
+    void EndObject() { states_.pop_back(); out_.EndObject(); }
+    bool StartArray() { states_.push_back( Copy ); next_ = Copy; out_.BeginArray(); return true; }
+    void EndArray() { states_.pop_back(); out_.EndArray(); }
+    void String( std::string_view Text ) { next_ = Copy; Quote( Text, scratch_ ); out_.Scalar( scratch_ ); }
+    void Number( std::string_view Text ) { next_ = Copy; out_.Scalar( Text ); }
+    void Bool( bool Val ) { next_ = Copy; out_.Scalar( Val ? "true" : "false" ); }
+    void Null() { next_ = Copy; out_.Scalar( "null" ); }
+private:
+    enum State { Copy, InNode, InValues, InNodes };
+
+    TTextWriter<TMemorySink<>> out_;
+    std::vector<State> states_;
+    State next_ { InNode };
+    std::string scratch_;
+};
+
+std::size_t FlushJson( Files const & In )
+{
+    std::string Text;
+    TMemorySink<> Sink{ Text };
+    Flusher Handler{ Sink };
+    Sax::Parse( In.Json.data(), In.Json.data() + In.Json.size(), Handler );
+    return Text.size();
+}
+
+//---------------------------------------------------------------------------
+
+std::size_t CountValues( Node const & N )
+{
+    auto Count = N.Values.size();
+    for ( auto const & Child : N.Nodes ) { Count += CountValues( *Child.second ); }
+    return Count;
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t PeakBytes;
+    std::size_t Result;     // values loaded or bytes written
+};
+
+template<typename F>
+Sample Measure( Files const & In, int Rounds, F&& Run )
+{
+    Sample Result {};
+    auto const Start = std::chrono::steady_clock::now();
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const BaseLive = Live;
+        Peak = Live;
+        if constexpr ( std::is_same_v<decltype( Run( In ) ),std::size_t> ) {
+            Result.Result = Run( In );
+        }
+        else {
+            Result.Result = CountValues( *Run( In ) );
+        }
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.PeakBytes = Peak - BaseLive;
+    }
+    auto const Stop = std::chrono::steady_clock::now();
+    Result.Us = std::chrono::duration<double,std::micro>( Stop - Start ).count() / Rounds;
+    Sink = Result.Result;
+    return Result;
+}
+
+void Print( char const * What, std::size_t Count, std::size_t Bytes,
+            Sample const & Before, Sample const & After, Sample const & Json )
+{
+    std::printf(
+        "%-5s %6zu nodes %6zu KiB | %8.0f / %8.0f / %8.0f us"
+        " | allocs %7zu / %7zu / %7zu | peak %6zu / %6zu / %6zu KiB\n",
+        What, Count, Bytes / 1024, Before.Us, After.Us, Json.Us,
+        Before.Allocs, After.Allocs, Json.Allocs,
+        Before.PeakBytes / 1024, After.PeakBytes / 1024, Json.PeakBytes / 1024
+    );
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const In = MakeFiles( Count );
+
+    auto const LoadB = Measure( In, Rounds, &LoadBefore );
+    auto const LoadA = Measure( In, Rounds, &LoadAfter );
+    auto const LoadJ = Measure( In, Rounds, &LoadJson );
+    if ( LoadB.Result != LoadA.Result || LoadA.Result != LoadJ.Result ) {
+        std::printf(
+            "mismatch: %zu / %zu / %zu values\n",
+            LoadB.Result, LoadA.Result, LoadJ.Result
+        );
+        std::exit( 1 );
+    }
+    Print( "load", Count, In.Bson.size(), LoadB, LoadA, LoadJ );
+
+    auto const FlushB = Measure( In, Rounds, &FlushBefore );
+    auto const FlushA = Measure( In, Rounds, &FlushAfter );
+    auto const FlushJ = Measure( In, Rounds, &FlushJson );
+    if ( FlushB.Result != FlushA.Result ) {
+        std::printf( "mismatch: %zu / %zu bytes\n", FlushB.Result, FlushA.Result );
+        std::exit( 1 );
+    }
+    Print( "flush", Count, FlushA.Result, FlushB, FlushA, FlushJ );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "eager BSON load and flush, before / after / JSON backend\n" );
+    Run( 100, 200 );
+    Run( 1000, 20 );
+    Run( 10000, 3 );
+    return 0;
+}
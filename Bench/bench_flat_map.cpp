@@ -0,0 +1,123 @@
+//---------------------------------------------------------------------------
+// std::map vs Anafestica::TFlatMap micro-benchmark.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_flat_map.cpp -o bench_flat_map
+//   ./bench_flat_map
+//
+// The value payload mimics ValuePairType (a variant plus an Operation) and
+// std::wstring stands in for System::String.  The std::map lookups build a
+// key object per call, exactly as TConfigNode did with its by-value
+// String parameters; the flat map is searched with the wchar_t pointer.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgFlatMap.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+
+enum class Operation { None, Write, Erase };
+
+using Payload = std::pair<std::variant<int,double,std::wstring>,Operation>;
+
+using StdMap = std::map<std::wstring,Payload>;
+using FlatMap = Anafestica::TFlatMap<std::wstring,Payload>;
+
+volatile std::size_t Sink;
+
+std::vector<std::wstring> MakeKeys( std::size_t Count )
+{
+    std::vector<std::wstring> Keys;
+    Keys.reserve( Count );
+    for ( std::size_t i = 0 ; i < Count ; ++i ) {
+        Keys.push_back( L"Column" + std::to_wstring( i ) + L"Width" );
+    }
+    std::sort( Keys.begin(), Keys.end() );
+    return Keys;
+}
+
+template<typename F>
+double TimeNs( std::size_t Ops, F&& Fn )
+{
+    auto const Start = std::chrono::steady_clock::now();
+    Fn();
+    auto const Stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>( Stop - Start ).count() / Ops;
+}
+
+template<typename M>
+void Fill( M& Map, std::vector<std::wstring> const & Keys )
+{
+    int v {};
+    for ( auto const & k : Keys ) {
+        Map.insert( std::make_pair( k, Payload( v++, Operation::None ) ) );
+    }
+}
+
+void Run( std::size_t Count, std::size_t Rounds )
+{
+    auto const Keys = MakeKeys( Count );
+
+    std::vector<wchar_t const *> Probes;
+    Probes.reserve( Count * Rounds );
+    std::mt19937 Rng( 42 );
+    std::uniform_int_distribution<std::size_t> Pick( 0, Count - 1 );
+    for ( std::size_t i = 0 ; i < Count * Rounds ; ++i ) {
+        Probes.push_back( Keys[Pick( Rng )].c_str() );
+    }
+
+    StdMap Std;
+    FlatMap Flat;
+
+    auto const StdFill = TimeNs( Count, [&]{ Fill( Std, Keys ); } );
+    auto const FlatFill = TimeNs( Count, [&]{ Fill( Flat, Keys ); } );
+
+    auto const StdFind = TimeNs( Probes.size(), [&]{
+        std::size_t Hits {};
+        for ( auto p : Probes ) { Hits += Std.find( std::wstring( p ) ) != Std.end(); }
+        Sink = Hits;
+    } );
+    auto const FlatFind = TimeNs( Probes.size(), [&]{
+        std::size_t Hits {};
+        for ( auto p : Probes ) { Hits += Flat.find( p ) != Flat.end(); }
+        Sink = Hits;
+    } );
+
+    auto const Walk = []( auto const & Map ) {
+        std::size_t Live {};
+        for ( auto const & v : Map ) { Live += v.second.second != Operation::Erase; }
+        Sink = Live;
+    };
+    auto const StdWalk = TimeNs( Count * Rounds, [&]{
+        for ( std::size_t r = 0 ; r < Rounds ; ++r ) { Walk( Std ); }
+    } );
+    auto const FlatWalk = TimeNs( Count * Rounds, [&]{
+        for ( std::size_t r = 0 ; r < Rounds ; ++r ) { Walk( Flat ); }
+    } );
+
+    std::printf(
+        "%7zu keys | fill %7.1f / %7.1f ns | find %7.1f / %7.1f ns | walk %6.2f / %6.2f ns\n",
+        Count, StdFill, FlatFill, StdFind, FlatFind, StdWalk, FlatWalk
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "per-operation cost, std::map / TFlatMap\n" );
+    Run( 8, 20000 );
+    Run( 64, 4000 );
+    Run( 1024, 200 );
+    Run( 16384, 10 );
+    return 0;
+}
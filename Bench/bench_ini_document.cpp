@@ -0,0 +1,429 @@
+//---------------------------------------------------------------------------
+// INI load and flush benchmark: a model of TMemIniFile against
+// INIFile::TDocument.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_ini_document.cpp -o bench_ini_document
+//   ./bench_ini_document
+//
+// The file has N sections of eight values, one of them non-ASCII.  The
+// load reads every value of every section, as INIFile::TConfig does
+// (the key names of a section, then each value by its key); the flush
+// opens the file again, rewrites one value and adds one per section, and
+// renders the file.  "before" is TMemIniFile as the backend used it: the
+// UTF-8 text decoded to UTF-16 and split into a list of lines, which are
+// trimmed into one list per section; sections and keys are found through
+// a name hash of the list (THashedStringList), upper-cased for case
+// insensitivity and rebuilt after every change to it; the file is
+// rendered by listing every line, joining them and encoding the text.
+// "after" parses the UTF-8 text into an INIFile::TDocument in one pass,
+// converts names and values only as they are read, and renders through
+// a buffered sink.  Both flushes must produce the same bytes.  Allocation
+// counts come from a counting operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgIniDocument.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+
+} // namespace
+
+void* operator new( std::size_t Size )
+{
+    if ( auto const Block = std::malloc( Size ) ) {
+        ++Allocs;
+        return Block;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    std::free( Ptr );
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    std::free( Ptr );
+}
+
+namespace {
+
+using namespace Anafestica::INIFile;
+
+volatile std::size_t Sink;
+
+// UTF-8 <-> std::wstring (a stand-in for System::String), as
+// TEncoding::UTF8 converts them.
+std::wstring Widen( std::string_view Text )
+{
+    std::wstring Result;
+    Result.reserve( Text.size() );
+    for ( std::size_t Pos {} ; Pos < Text.size() ; ) {
+        auto const Lead = static_cast<unsigned char>( Text[Pos] );
+        auto const Length = Lead < 0x80 ? 1 : Lead < 0xE0 ? 2 : Lead < 0xF0 ? 3 : 4;
+        char32_t Code = Length == 1 ? Lead : Lead & ( 0x3F >> ( Length - 1 ) );
+        for ( int Idx = 1 ; Idx < Length ; ++Idx ) {
+            Code = Code << 6 | ( static_cast<unsigned char>( Text[Pos + Idx] ) & 0x3F );
+        }
+        Result += static_cast<wchar_t>( Code );
+        Pos += Length;
+    }
+    return Result;
+}
+
+void AppendNarrow( std::string& Out, std::wstring_view Text )
+{
+    for ( auto Ch : Text ) {
+        auto const Code = static_cast<char32_t>( Ch );
+        if ( Code < 0x80 ) {
+            Out += static_cast<char>( Code );
+        }
+        else if ( Code < 0x800 ) {
+            Out += static_cast<char>( 0xC0 | Code >> 6 );
+            Out += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else {
+            Out += static_cast<char>( 0xE0 | Code >> 12 );
+            Out += static_cast<char>( 0x80 | ( Code >> 6 & 0x3F ) );
+            Out += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+    }
+}
+
+std::string MakeFile( std::size_t Count )
+{
+    std::string Text( Utf8Preamble );
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Id = std::to_string( Idx );
+        Text += "[config\\Node" + Id + "]\r\n";
+        Text += "port::(i)=" + Id + "\r\n";
+        Text += "host::(sz)=server" + Id + ".example.com\r\n";
+        Text += "debug::(b)=0\r\n";
+        Text += "ratio::(dbl)=0.25\r\n";
+        Text += "last_run::(dt)=2026-04-15T12:00:00.000\r\n";
+        Text += "items::(sv)=one|two|three\r\n";
+        Text += "caption::(sz)=Caf\xC3\xA9 " + Id + "\r\n";
+        Text += "size::(u64)=" + Id + "000\r\n";
+        Text += "\r\n";
+    }
+    return Text;
+}
+
+//---------------------------------------------------------------------------
+
+namespace Before {
+
+std::wstring Trim( std::wstring_view Text )
+{
+    while ( !Text.empty() && Text.front() <= L' ' ) { Text.remove_prefix( 1 ); }
+    while ( !Text.empty() && Text.back() <= L' ' ) { Text.remove_suffix( 1 ); }
+    return std::wstring( Text );
+}
+
+std::wstring Upper( std::wstring_view Text )
+{
+    std::wstring Result( Text );
+    for ( auto& Ch : Result ) { Ch = static_cast<wchar_t>( std::towupper( Ch ) ); }
+    return Result;
+}
+
+std::wstring NameOf( std::wstring const & Line )
+{
+    auto const Sep = Line.find( L'=' );
+    return Sep == std::wstring::npos ? std::wstring{} : Line.substr( 0, Sep );
+}
+
+// THashedStringList: a list of strings with a hash of the upper-cased
+// strings and one of their names, each rebuilt on the first lookup after
+// a change.
+struct HashedList {
+    std::vector<std::wstring> Strings;
+    std::vector<std::unique_ptr<HashedList>> Objects;
+    mutable std::unordered_map<std::wstring,std::size_t> Hash;
+    mutable std::unordered_map<std::wstring,std::size_t> NameHash;
+    mutable bool HashValid {};
+    mutable bool NameHashValid {};
+
+    void Changed() { HashValid = NameHashValid = false; }
+
+    std::size_t IndexOf( std::wstring_view S ) const {
+        if ( !HashValid ) {
+            Hash.clear();
+            for ( std::size_t Idx = 0 ; Idx < Strings.size() ; ++Idx ) {
+                Hash.emplace( Upper( Strings[Idx] ), Idx );
+            }
+            HashValid = true;
+        }
+        auto const It = Hash.find( Upper( S ) );
+        return It == Hash.end() ? std::wstring::npos : It->second;
+    }
+
+    std::size_t IndexOfName( std::wstring_view Name ) const {
+        if ( !NameHashValid ) {
+            NameHash.clear();
+            for ( std::size_t Idx = 0 ; Idx < Strings.size() ; ++Idx ) {
+                if ( Strings[Idx].find( L'=' ) != std::wstring::npos ) {
+                    NameHash.emplace( Upper( NameOf( Strings[Idx] ) ), Idx );
+                }
+            }
+            NameHashValid = true;
+        }
+        auto const It = NameHash.find( Upper( Name ) );
+        return It == NameHash.end() ? std::wstring::npos : It->second;
+    }
+};
+
+struct MemIniFile {
+    HashedList Sections;
+
+    explicit MemIniFile( std::string_view File ) {
+        if ( File.substr( 0, Utf8Preamble.size() ) == Utf8Preamble ) {
+            File.remove_prefix( Utf8Preamble.size() );
+        }
+        // TStringList::SetTextStr
+        auto const Text = Widen( File );
+        std::vector<std::wstring> Lines;
+        for ( std::size_t Pos = 0 ; Pos < Text.size() ; ) {
+            auto End = Text.find_first_of( L"\r\n", Pos );
+            if ( End == std::wstring::npos ) { End = Text.size(); }
+            Lines.push_back( Text.substr( Pos, End - Pos ) );
+            Pos = End;
+            if ( Pos < Text.size() && Text[Pos] == L'\r' ) { ++Pos; }
+            if ( Pos < Text.size() && Text[Pos] == L'\n' ) { ++Pos; }
+        }
+        // TMemIniFile::SetStrings
+        HashedList* Current {};
+        for ( auto const & Line : Lines ) {
+            auto const S = Trim( Line );
+            if ( S.empty() || S[0] == L';' ) { continue; }
+            if ( S[0] == L'[' && S.back() == L']' ) {
+                Current = AddSection( Trim( S.substr( 1, S.size() - 2 ) ) );
+            }
+            else if ( Current ) {
+                auto const Sep = S.find( L'=' );
+                Current->Strings.push_back(
+                    Sep == std::wstring::npos
+                        ? S
+                        : Trim( S.substr( 0, Sep ) ) + L"=" + Trim( S.substr( Sep + 1 ) )
+                );
+                Current->Changed();
+            }
+        }
+    }
+
+    HashedList* AddSection( std::wstring Name ) {
+        Sections.Strings.push_back( std::move( Name ) );
+        Sections.Objects.push_back( std::make_unique<HashedList>() );
+        Sections.Changed();
+        return Sections.Objects.back().get();
+    }
+
+    HashedList* Find( std::wstring_view Section ) const {
+        auto const Idx = Sections.IndexOf( Section );
+        return Idx == std::wstring::npos ? nullptr : Sections.Objects[Idx].get();
+    }
+
+    std::vector<std::wstring> ReadSection( std::wstring_view Section ) const {
+        std::vector<std::wstring> Names;
+        if ( auto const S = Find( Section ) ) {
+            for ( auto const & Line : S->Strings ) { Names.push_back( NameOf( Line ) ); }
+        }
+        return Names;
+    }
+
+    std::wstring ReadString( std::wstring_view Section, std::wstring const & Key ) const {
+        if ( auto const S = Find( Section ) ) {
+            auto const Idx = S->IndexOfName( Key );
+            if ( Idx != std::wstring::npos ) { return S->Strings[Idx].substr( Key.size() + 1 ); }
+        }
+        return {};
+    }
+
+    void WriteString( std::wstring_view Section, std::wstring const & Key,
+                      std::wstring const & Value ) {
+        auto S = Find( Section );
+        if ( !S ) { S = AddSection( std::wstring( Section ) ); }
+        auto const Idx = S->IndexOfName( Key );
+        if ( Idx == std::wstring::npos ) { S->Strings.push_back( Key + L"=" + Value ); }
+        else { S->Strings[Idx] = Key + L"=" + Value; }
+        S->Changed();
+    }
+
+    std::string Render() const {
+        // GetStrings, then TStrings::GetTextStr and TEncoding::GetBytes.
+        std::vector<std::wstring> Lines;
+        for ( std::size_t Idx = 0 ; Idx < Sections.Strings.size() ; ++Idx ) {
+            Lines.push_back( L"[" + Sections.Strings[Idx] + L"]" );
+            for ( auto const & Line : Sections.Objects[Idx]->Strings ) { Lines.push_back( Line ); }
+            Lines.push_back( {} );
+        }
+        std::wstring Text;
+        for ( auto const & Line : Lines ) { Text += Line; Text += L"\r\n"; }
+        std::string Result( Utf8Preamble );
+        AppendNarrow( Result, Text );
+        return Result;
+    }
+};
+
+std::size_t Load( std::string const & File )
+{
+    MemIniFile Ini{ File };
+    std::size_t Sum {};
+    for ( auto const & Section : Ini.Sections.Strings ) {
+        for ( auto const & Key : Ini.ReadSection( Section ) ) {
+            auto const Value = Ini.ReadString( Section, Key );
+            Sum += Key.size() + Value.size();
+        }
+    }
+    return Sum;
+}
+
+std::string Flush( std::string const & File, std::size_t Count )
+{
+    MemIniFile Ini{ File };
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Section = L"config\\Node" + std::to_wstring( Idx );
+        Ini.WriteString( Section, L"port::(i)", std::to_wstring( Idx + 1 ) );
+        Ini.WriteString( Section, L"note::(sz)", L"edited \u00e9" );
+    }
+    return Ini.Render();
+}
+
+} // namespace Before
+
+//---------------------------------------------------------------------------
+
+namespace After {
+
+struct StringWriter {
+    std::string& Out;
+
+    void Write( char const * Data, std::size_t Length ) { Out.append( Data, Length ); }
+};
+
+std::string Body( std::string const & File )
+{
+    std::string_view Text( File );
+    if ( Text.substr( 0, Utf8Preamble.size() ) == Utf8Preamble ) {
+        Text.remove_prefix( Utf8Preamble.size() );
+    }
+    return std::string( Text );
+}
+
+std::size_t Load( std::string const & File )
+{
+    TDocument Doc{ Body( File ) };
+    std::size_t Sum {};
+    std::vector<std::string_view> Sections;
+    Doc.ForEachSection( [&]( std::string_view Name ) { Sections.push_back( Name ); } );
+    for ( auto Section : Sections ) {
+        Doc.ForEachValue(
+            Section,
+            [&]( std::string_view Key, std::string_view Value ) {
+                Sum += Widen( Key ).size() + Widen( Value ).size();
+            }
+        );
+    }
+    return Sum;
+}
+
+std::string Flush( std::string const & File, std::size_t Count )
+{
+    TDocument Doc{ Body( File ) };
+    std::string Section;
+    std::string Value;
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        Section = "config\\Node";
+        AppendNarrow( Section, std::to_wstring( Idx ) );
+        Value.clear();
+        AppendNarrow( Value, std::to_wstring( Idx + 1 ) );
+        Doc.WriteString( Section, "port::(i)", Value );
+        Value.clear();
+        AppendNarrow( Value, L"edited \u00e9" );
+        Doc.WriteString( Section, "note::(sz)", Value );
+    }
+    std::string Result;
+    StringWriter Out{ Result };
+    TBufferedSink<StringWriter> Sink{ Out };
+    Sink.Append( Utf8Preamble.data(), Utf8Preamble.size() );
+    Doc.WriteTo( Sink );
+    Sink.Flush();
+    return Result;
+}
+
+} // namespace After
+
+//---------------------------------------------------------------------------
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+};
+
+template<typename F>
+Sample Measure( F&& Fn, int Rounds )
+{
+    Sample Result {};
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const Start = std::chrono::steady_clock::now();
+        Fn();
+        auto const Stop = std::chrono::steady_clock::now();
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.Us += std::chrono::duration<double,std::micro>( Stop - Start ).count();
+    }
+    Result.Us /= Rounds;
+    return Result;
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const File = MakeFile( Count );
+
+    if ( Before::Load( File ) != After::Load( File ) ||
+         Before::Flush( File, Count ) != After::Flush( File, Count ) )
+    {
+        std::printf( "mismatch at %zu sections\n", Count );
+        std::exit( 1 );
+    }
+
+    auto const LoadBefore = Measure( [&]{ Sink = Before::Load( File ); }, Rounds );
+    auto const LoadAfter = Measure( [&]{ Sink = After::Load( File ); }, Rounds );
+    auto const FlushBefore = Measure( [&]{ Sink = Before::Flush( File, Count ).size(); }, Rounds );
+    auto const FlushAfter = Measure( [&]{ Sink = After::Flush( File, Count ).size(); }, Rounds );
+    std::printf(
+        "%6zu sections | load %9.0f / %7.0f us, allocs %8zu / %7zu"
+        " | flush %9.0f / %7.0f us, allocs %8zu / %7zu\n",
+        Count,
+        LoadBefore.Us, LoadAfter.Us, LoadBefore.Allocs, LoadAfter.Allocs,
+        FlushBefore.Us, FlushAfter.Us, FlushBefore.Allocs, FlushAfter.Allocs
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "INI load and flush, TMemIniFile model / TDocument\n" );
+    Run( 100, 100 );
+    Run( 1000, 10 );
+    Run( 10000, 2 );
+    return 0;
+}
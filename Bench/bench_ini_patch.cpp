@@ -0,0 +1,182 @@
+//---------------------------------------------------------------------------
+// INI flush benchmark: a few changes to a large file, with the canonical
+// layout against TLayout::Preserve.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_ini_patch.cpp -o bench_ini_patch
+//   ./bench_ini_patch
+//
+// The file has N sections of eight values, with a comment ahead of each.
+// The flush opens the file, as INIFile::TConfig::DoFlush does, rewrites
+// one value in each of 16 sections spread over the file, erases one
+// value, adds one section and renders the file.  "before" is the
+// canonical layout: every line of every section is parsed, and the file
+// is rendered line by line through a buffered sink.  "after" is
+// TLayout::Preserve: the parse only finds the sections, the lines of the
+// sections changed are parsed when written, and the file is rendered as
+// the text read with the changed lines patched in.  The output of
+// "after" must read back into the same document as that of "before".
+// Allocation counts come from a counting operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgIniDocument.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace {
+
+std::size_t Allocs;
+
+} // namespace
+
+void* operator new( std::size_t Size )
+{
+    if ( auto const Block = std::malloc( Size ) ) {
+        ++Allocs;
+        return Block;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    std::free( Ptr );
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    std::free( Ptr );
+}
+
+namespace {
+
+using namespace Anafestica::INIFile;
+
+volatile std::size_t Sink;
+
+constexpr std::size_t Changes = 16;
+
+std::string MakeFile( std::size_t Count )
+{
+    std::string Text;
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Id = std::to_string( Idx );
+        Text += "; node " + Id + ", edited by hand\r\n";
+        Text += "[config\\Node" + Id + "]\r\n";
+        Text += "port::(i)=" + Id + "\r\n";
+        Text += "host::(sz)=server" + Id + ".example.com\r\n";
+        Text += "debug::(b)=0\r\n";
+        Text += "ratio::(dbl)=0.25\r\n";
+        Text += "last_run::(dt)=2026-04-15T12:00:00.000\r\n";
+        Text += "items::(sv)=one|two|three\r\n";
+        Text += "caption::(sz)=Caf\xC3\xA9 " + Id + "\r\n";
+        Text += "size::(u64)=" + Id + "000\r\n";
+        Text += "\r\n";
+    }
+    return Text;
+}
+
+struct StringWriter {
+    std::string& Out;
+
+    void Write( char const * Data, std::size_t Length ) { Out.append( Data, Length ); }
+};
+
+void Change( TDocument& Doc, std::size_t Count )
+{
+    std::string Section;
+    for ( std::size_t Idx = 0 ; Idx < Changes ; ++Idx ) {
+        Section = "config\\Node" + std::to_string( Idx * Count / Changes );
+        Doc.WriteString( Section, "port::(i)", std::to_string( Idx ) );
+    }
+    Doc.DeleteKey( "config\\Node0", "debug::(b)" );
+    Doc.WriteString( "config\\Added", "port::(i)", "1" );
+}
+
+std::string Canonical( std::string const & File, std::size_t Count )
+{
+    TDocument Doc{ File };
+    Change( Doc, Count );
+    std::string Result;
+    StringWriter Out{ Result };
+    TBufferedSink<StringWriter> Sink{ Out };
+    Doc.WriteTo( Sink );
+    Sink.Flush();
+    return Result;
+}
+
+std::string Preserve( std::string const & File, std::size_t Count )
+{
+    TDocument Doc{ File, TLayout::Preserve };
+    Change( Doc, Count );
+    std::string Result;
+    TMemorySink<> Sink{ Result };
+    Doc.WriteTo( Sink );
+    return Result;
+}
+
+std::string Reread( std::string Text )
+{
+    TDocument Doc{ std::move( Text ) };
+    std::string Result;
+    TMemorySink<> Sink{ Result };
+    Doc.WriteTo( Sink );
+    return Result;
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+};
+
+template<typename F>
+Sample Measure( F&& Fn, int Rounds )
+{
+    Sample Result {};
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const Start = std::chrono::steady_clock::now();
+        Fn();
+        auto const Stop = std::chrono::steady_clock::now();
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.Us += std::chrono::duration<double,std::micro>( Stop - Start ).count();
+    }
+    Result.Us /= Rounds;
+    return Result;
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const File = MakeFile( Count );
+
+    auto const Expected = Canonical( File, Count );
+    if ( Reread( Preserve( File, Count ) ) != Expected ) {
+        std::printf( "mismatch at %zu sections\n", Count );
+        std::exit( 1 );
+    }
+
+    auto const Before = Measure( [&]{ Sink = Canonical( File, Count ).size(); }, Rounds );
+    auto const After = Measure( [&]{ Sink = Preserve( File, Count ).size(); }, Rounds );
+    std::printf(
+        "%7zu sections, %6zu KB | flush %9.0f / %7.0f us | allocs %8zu / %6zu\n",
+        Count, File.size() / 1024, Before.Us, After.Us, Before.Allocs, After.Allocs
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "INI flush of %zu changes, canonical / preserved layout\n", Changes );
+    Run( 100, 100 );
+    Run( 1000, 10 );
+    Run( 10000, 2 );
+    Run( 100000, 1 );
+    return 0;
+}
@@ -0,0 +1,211 @@
+//---------------------------------------------------------------------------
+// INI load benchmark: child sections by prefix scan against TSectionIndex.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_ini_sections.cpp -o bench_ini_sections
+//   ./bench_ini_sections
+//
+// The file has N nodes under [config], each with three subnodes, one
+// section per node.  The load visits every node and lists its children;
+// then a tenth of the nodes are deleted with their subnodes.  "before" is
+// what INIFile::TConfig did for each of these: copy the section names out
+// (TMemIniFile::ReadSections into a TStringList) and scan them all for the
+// prefix "Section\", taking a substring of every match.  "after" reads the
+// names once into an INIFile::TSectionIndex and asks it.  Names are
+// UTF-8 std::string throughout.  Allocation counts come from a counting
+// operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgIniSections.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+
+} // namespace
+
+void* operator new( std::size_t Size )
+{
+    if ( auto const Block = std::malloc( Size ) ) {
+        ++Allocs;
+        return Block;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    std::free( Ptr );
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    std::free( Ptr );
+}
+
+namespace {
+
+using Anafestica::INIFile::TSectionIndex;
+
+volatile std::size_t Sink;
+
+// The sections of the file, in file order, as TMemIniFile keeps them.
+struct Ini {
+    std::vector<std::string> Sections;
+
+    std::vector<std::string> ReadSections() const { return Sections; }
+
+    void EraseSection( std::string_view Name ) {
+        auto const It = std::find( Sections.begin(), Sections.end(), Name );
+        if ( It != Sections.end() ) { Sections.erase( It ); }
+    }
+};
+
+Ini MakeIni( std::size_t Count )
+{
+    Ini Result;
+    Result.Sections.push_back( "config" );
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Node = "config\\Node" + std::to_string( Idx );
+        Result.Sections.push_back( Node );
+        for ( auto Sub : { "\\Position", "\\Columns", "\\Recent" } ) {
+            Result.Sections.push_back( Node + Sub );
+        }
+    }
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+
+struct Scanned {
+    Ini& File;
+
+    std::set<std::string> Children( std::string const & Section ) {
+        std::set<std::string> Nodes;
+        auto const Prefix = Section + "\\";
+        for ( auto const & S : File.ReadSections() ) {
+            if ( S.size() > Prefix.size() && S.substr( 0, Prefix.size() ) == Prefix ) {
+                auto const Remainder = S.substr( Prefix.size() );
+                auto const Sep = Remainder.find( '\\' );
+                auto const DirectChild = Remainder.substr( 0, Sep );
+                if ( !DirectChild.empty() ) { Nodes.insert( DirectChild ); }
+            }
+        }
+        return Nodes;
+    }
+
+    void Delete( std::string const & Section ) {
+        File.EraseSection( Section );
+        auto const Prefix = Section + "\\";
+        for ( auto const & S : File.ReadSections() ) {
+            if ( S.substr( 0, Prefix.size() ) == Prefix ) { File.EraseSection( S ); }
+        }
+    }
+};
+
+struct Indexed {
+    Ini& File;
+    TSectionIndex Index { "config" };
+
+    explicit Indexed( Ini& F ) : File{ F } {
+        for ( auto const & S : File.ReadSections() ) { Index.Add( S ); }
+    }
+
+    std::set<std::string> Children( std::string const & Section ) {
+        std::set<std::string> Nodes;
+        Index.ForEachChild(
+            Section, [&]( std::string_view Child ) { Nodes.emplace( Child ); }
+        );
+        return Nodes;
+    }
+
+    void Delete( std::string const & Section ) {
+        File.EraseSection( Section );
+        Index.Erase(
+            Section, [&]( std::string_view Name ) { File.EraseSection( Name ); }
+        );
+    }
+};
+
+template<typename Reader>
+std::size_t Visit( Reader& R, std::string const & Section )
+{
+    std::size_t Count = 1;
+    for ( auto const & Child : R.Children( Section ) ) {
+        Count += Visit( R, Section + "\\" + Child );
+    }
+    return Count;
+}
+
+template<typename Reader>
+std::size_t Run( Ini File, std::size_t Count )
+{
+    Reader R{ File };
+    auto const Visited = Visit( R, "config" );
+    for ( std::size_t Idx = 0 ; Idx < Count ; Idx += 10 ) {
+        R.Delete( "config\\Node" + std::to_string( Idx ) );
+    }
+    return Visited * 1000000 + File.Sections.size();
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t Result;     // nodes visited, sections left
+};
+
+template<typename Reader>
+Sample Measure( Ini const & File, std::size_t Count, int Rounds )
+{
+    Sample Result {};
+    double Us {};
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const Start = std::chrono::steady_clock::now();
+        Result.Result = Run<Reader>( File, Count );
+        auto const Stop = std::chrono::steady_clock::now();
+        Result.Allocs = Allocs - BaseAllocs;
+        Us += std::chrono::duration<double,std::micro>( Stop - Start ).count();
+    }
+    Result.Us = Us / Rounds;
+    Sink = Result.Result;
+    return Result;
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const File = MakeIni( Count );
+    auto const Before = Measure<Scanned>( File, Count, Rounds );
+    auto const After = Measure<Indexed>( File, Count, Rounds );
+    if ( Before.Result != After.Result ) {
+        std::printf( "mismatch: %zu / %zu\n", Before.Result, After.Result );
+        std::exit( 1 );
+    }
+    std::printf(
+        "%6zu sections | %10.0f / %7.0f us | allocs %9zu / %7zu\n",
+        File.Sections.size(), Before.Us, After.Us, Before.Allocs, After.Allocs
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "INI load and node deletion, prefix scan / section index\n" );
+    Run( 25, 100 );
+    Run( 250, 10 );
+    Run( 1000, 2 );
+    Run( 2500, 1 );
+    return 0;
+}
@@ -0,0 +1,420 @@
+//---------------------------------------------------------------------------
+// Eager JSON flush benchmark: configuration file + edits -> file text.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_json_flush.cpp -o bench_json_flush
+//   ./bench_json_flush
+//
+// "before" is what JSON::TConfig::DoFlush did: read the whole file,
+// parse it into a document (one heap object per value, member and key,
+// as TJSONObject does), replace the edited values in it, render the
+// whole text, then write it out.  "after" is JSON::Sax::ParseStream
+// feeding a TTextWriter, as the backend's stream flusher does: the file
+// is read into a 64 KiB input buffer and copied to a 64 KiB output
+// buffer as it is parsed, with the edited values replaced on the way.
+// One value per node is edited.  Allocation counts and the peak of live
+// heap bytes, input buffers included, come from a counting operator new;
+// the "file" both read is a string built beforehand.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgJSONSax.h>
+#include <anafestica/CfgJSONWriter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+std::size_t Live;
+std::size_t Peak;
+
+} // namespace
+
+// Every block carries its size in front, so that delete can account for it.
+void* operator new( std::size_t Size )
+{
+    auto const Block = static_cast<std::size_t*>( std::malloc( Size + 16 ) );
+    if ( !Block ) {
+        throw std::bad_alloc{};
+    }
+    *Block = Size;
+    ++Allocs;
+    Live += Size;
+    if ( Live > Peak ) { Peak = Live; }
+    return reinterpret_cast<char*>( Block ) + 16;
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    if ( Ptr ) {
+        auto const Block = reinterpret_cast<std::size_t*>( static_cast<char*>( Ptr ) - 16 );
+        Live -= *Block;
+        std::free( Block );
+    }
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    operator delete( Ptr );
+}
+
+namespace {
+
+namespace Sax = Anafestica::JSON::Sax;
+using Anafestica::JSON::TTextWriter;
+using Anafestica::JSON::TMemorySink;
+
+// The value every node gets in place of its "Left".
+constexpr std::string_view Edited = "4321";
+
+// Stands in for the file: counts what reaches it.
+struct Device {
+    std::size_t Bytes {};
+    void Write( char const *, std::size_t Length ) { Bytes += Length; }
+};
+
+// Output buffered as TFileSink buffers it.
+class BufferedSink {
+public:
+    explicit BufferedSink( Device& Out ) : out_{ Out } { buffer_.reserve( Capacity ); }
+
+    void Append( char const * Data, std::size_t Length ) {
+        if ( buffer_.size() + Length > Capacity ) {
+            Flush();
+            if ( Length >= Capacity ) {
+                out_.Write( Data, Length );
+                return;
+            }
+        }
+        buffer_.insert( buffer_.end(), Data, Data + Length );
+    }
+
+    void Flush() {
+        out_.Write( buffer_.data(), buffer_.size() );
+        buffer_.clear();
+    }
+private:
+    static constexpr std::size_t Capacity = 64 * 1024;
+
+    Device& out_;
+    std::vector<char> buffer_;
+};
+
+// Synthetic configuration: Count nodes, three levels deep, each holding a
+// mix of implicit and tagged values (the same file bench_json_sax reads).
+std::string MakeDocument( std::size_t Count )
+{
+    std::string Doc;
+    std::size_t Made {};
+    auto AddNode = [&]( auto& Self, std::size_t Level ) -> void {
+        auto const Id = std::to_string( Made++ );
+        Doc += R"({"values":{)";
+        Doc += R"("Left":)" + Id + R"(,"Top":120,"Width":640,"Height":480,)";
+        Doc += R"("Caption":"Window )" + Id + R"(","Visible":true,)";
+        Doc += R"("Ratio":{"dbl":0.75},"Stamp":{"ll":1700000000000},)";
+        Doc += R"("Recent":{"sv":["a.txt","b.txt","c.txt"]}})";
+        if ( Level < 2 ) {
+            Doc += R"(,"nodes":{)";
+            for ( int Idx = 0 ; Idx < 3 && Made < Count ; ++Idx ) {
+                if ( Idx ) { Doc += ','; }
+                Doc += "\"Child" + std::to_string( Idx ) + "\":";
+                Self( Self, Level + 1 );
+            }
+            Doc += '}';
+        }
+        Doc += '}';
+    };
+    Doc += R"({"nodes":{)";
+    for ( std::size_t Idx {} ; Made < Count ; ++Idx ) {
+        if ( Idx ) { Doc += ','; }
+        Doc += "\"Form" + std::to_string( Idx ) + "\":";
+        AddNode( AddNode, 0 );
+    }
+    Doc += "}}";
+    return Doc;
+}
+
+void Quote( std::string_view Text, std::string& Out )
+{
+    Out.assign( 1, '"' );
+    Out.append( Text.begin(), Text.end() );
+    Out += '"';
+}
+
+//---------------------------------------------------------------------------
+// before: document, edit, render, write
+
+struct Json {
+    enum Kind { Object, Array, String, Number, Bool, Null } Type;
+    std::string Text;
+    std::vector<std::pair<std::unique_ptr<Json>,std::unique_ptr<Json>>> Members;
+    std::vector<std::unique_ptr<Json>> Items;
+
+    Json* Find( std::string_view Name ) const {
+        for ( auto const & Member : Members ) {
+            if ( Member.first->Text == Name ) { return Member.second.get(); }
+        }
+        return nullptr;
+    }
+};
+
+class DomBuilder {
+public:
+    std::unique_ptr<Json> Root;
+
+    bool StartObject() { Push( Json::Object ); return true; }
+    bool Key( std::string_view Name ) {
+        auto& Top = *stack_.back();
+        Top.Members.emplace_back( Make( Json::String, Name ), nullptr );
+        return true;
+    }
+    void EndObject() { stack_.pop_back(); }
+    bool StartArray() { Push( Json::Array ); return true; }
+    void EndArray() { stack_.pop_back(); }
+    void String( std::string_view Text ) { Add( Make( Json::String, Text ) ); }
+    void Number( std::string_view Text ) { Add( Make( Json::Number, Text ) ); }
+    void Bool( bool Val ) { Add( Make( Json::Bool, Val ? "true" : "false" ) ); }
+    void Null() { Add( Make( Json::Null, "null" ) ); }
+private:
+    std::vector<Json*> stack_;
+
+    static std::unique_ptr<Json> Make( Json::Kind Type, std::string_view Text ) {
+        auto Item = std::make_unique<Json>();
+        Item->Type = Type;
+        Item->Text = Text;
+        return Item;
+    }
+
+    Json* Add( std::unique_ptr<Json> Item ) {
+        auto const Ptr = Item.get();
+        if ( stack_.empty() ) {
+            Root = std::move( Item );
+        }
+        else if ( stack_.back()->Type == Json::Array ) {
+            stack_.back()->Items.push_back( std::move( Item ) );
+        }
+        else {
+            stack_.back()->Members.back().second = std::move( Item );
+        }
+        return Ptr;
+    }
+
+    void Push( Json::Kind Type ) {
+        stack_.push_back( Add( Make( Type, {} ) ) );
+    }
+};
+
+void Edit( Json& Obj )
+{
+    if ( auto const Values = Obj.Find( "values" ) ) {
+        if ( auto const Left = Values->Find( "Left" ) ) {
+            Left->Text = Edited;
+        }
+    }
+    if ( auto const Nodes = Obj.Find( "nodes" ) ) {
+        for ( auto const & Member : Nodes->Members ) {
+            Edit( *Member.second );
+        }
+    }
+}
+
+template<typename W>
+void Render( Json const & Val, W& Out, std::string& Scratch )
+{
+    switch ( Val.Type ) {
+        case Json::Object:
+            Out.BeginObject();
+            for ( auto const & Member : Val.Members ) {
+                Quote( Member.first->Text, Scratch );
+                Out.Name( Scratch );
+                Render( *Member.second, Out, Scratch );
+            }
+            Out.EndObject();
+            break;
+        case Json::Array:
+            Out.BeginArray();
+            for ( auto const & Item : Val.Items ) {
+                Render( *Item, Out, Scratch );
+            }
+            Out.EndArray();
+            break;
+        case Json::String:
+            Quote( Val.Text, Scratch );
+            Out.Scalar( Scratch );
+            break;
+        default:
+            Out.Scalar( Val.Text );
+            break;
+    }
+}
+
+std::size_t FlushDom( std::string const & Doc, int Indentation )
+{
+    std::string const Input{ Doc };
+    DomBuilder Builder;
+    Sax::Parse( Input.data(), Input.data() + Input.size(), Builder );
+    Edit( *Builder.Root );
+    std::string Text;
+    {
+        TMemorySink<> Sink{ Text };
+        TTextWriter<TMemorySink<>> Out{ Sink, Indentation };
+        std::string Scratch;
+        Render( *Builder.Root, Out, Scratch );
+    }
+    Device File;
+    File.Write( Text.data(), Text.size() );
+    return File.Bytes;
+}
+
+//---------------------------------------------------------------------------
+// after: parse and write in one pass
+
+class Flusher {
+public:
+    Flusher( BufferedSink& Sink, int Indentation ) : out_{ Sink, Indentation } {}
+
+    bool StartObject() {
+        states_.push_back( next_ );
+        next_ = Copy;
+        out_.BeginObject();
+        return true;
+    }
+
+    bool Key( std::string_view Name ) {
+        switch ( states_.back() ) {
+            case InNode:
+                if ( Name == "values" ) { next_ = InValues; }
+                else if ( Name == "nodes" ) { next_ = InNodes; }
+                break;
+            case InNodes:
+                next_ = InNode;
+                break;
+            case InValues:
+                if ( Name == "Left" ) {
+                    Quote( Name, scratch_ );
+                    out_.Name( scratch_ );
+                    out_.Scalar( Edited );
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+        Quote( Name, scratch_ );
+        out_.Name( scratch_ );
+        return true;
+    }
+
+    void EndObject() { states_.pop_back(); out_.EndObject(); }
+    bool StartArray() { states_.push_back( Copy ); next_ = Copy; out_.BeginArray(); return true; }
+    void EndArray() { states_.pop_back(); out_.EndArray(); }
+    void String( std::string_view Text ) { next_ = Copy; Quote( Text, scratch_ ); out_.Scalar( scratch_ ); }
+    void Number( std::string_view Text ) { next_ = Copy; out_.Scalar( Text ); }
+    void Bool( bool Val ) { next_ = Copy; out_.Scalar( Val ? "true" : "false" ); }
+    void Null() { next_ = Copy; out_.Scalar( "null" ); }
+private:
+    enum State { Copy, InNode, InValues, InNodes };
+
+    TTextWriter<BufferedSink> out_;
+    std::vector<State> states_;
+    State next_ { InNode };
+    std::string scratch_;
+};
+
+// The file as Sax::ParseStream reads it.
+class Source {
+public:
+    explicit Source( std::string const & Text ) : text_{ Text } {}
+
+    std::size_t Read( char* Buffer, std::size_t Size ) {
+        auto const Count = std::min( Size, text_.size() - pos_ );
+        std::memcpy( Buffer, text_.data() + pos_, Count );
+        pos_ += Count;
+        return Count;
+    }
+private:
+    std::string const & text_;
+    std::size_t pos_ {};
+};
+
+std::size_t FlushStream( std::string const & Doc, int Indentation )
+{
+    Device File;
+    BufferedSink Sink{ File };
+    {
+        Source Input{ Doc };
+        Flusher Handler{ Sink, Indentation };
+        Sax::ParseStream( Input, Handler );
+    }
+    Sink.Flush();
+    return File.Bytes;
+}
+
+//---------------------------------------------------------------------------
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t PeakBytes;
+    std::size_t Written;
+};
+
+template<typename F>
+Sample Measure( std::string const & Doc, int Indentation, int Rounds, F&& Flush )
+{
+    Sample Result {};
+    auto const Start = std::chrono::steady_clock::now();
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const BaseLive = Live;
+        Peak = Live;
+        Result.Written = Flush( Doc, Indentation );
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.PeakBytes = Peak - BaseLive;
+    }
+    auto const Stop = std::chrono::steady_clock::now();
+    Result.Us = std::chrono::duration<double,std::micro>( Stop - Start ).count() / Rounds;
+    return Result;
+}
+
+void Run( std::size_t Count, int Indentation, int Rounds )
+{
+    auto const Doc = MakeDocument( Count );
+    auto const Dom = Measure( Doc, Indentation, Rounds, &FlushDom );
+    auto const Stream = Measure( Doc, Indentation, Rounds, &FlushStream );
+    if ( Dom.Written != Stream.Written ) {
+        std::printf( "mismatch: %zu / %zu bytes\n", Dom.Written, Stream.Written );
+        std::exit( 1 );
+    }
+    std::printf(
+        "%6zu nodes %8zu KiB | %9.0f / %9.0f us | allocs %8zu / %8zu | peak %7zu / %7zu KiB\n",
+        Count, Dom.Written / 1024, Dom.Us, Stream.Us, Dom.Allocs, Stream.Allocs,
+        Dom.PeakBytes / 1024, Stream.PeakBytes / 1024
+    );
+}
+
+} // namespace
+
+int main()
+{
+    for ( int Indentation : { 0, 2 } ) {
+        std::printf(
+            "eager flush, %s, document + render / stream\n",
+            Indentation ? "indented" : "compact"
+        );
+        Run( 100, Indentation, 200 );
+        Run( 1000, Indentation, 50 );
+        Run( 10000, Indentation, 5 );
+    }
+}
@@ -0,0 +1,408 @@
+//---------------------------------------------------------------------------
+// Eager JSON load benchmark: file text -> configuration tree.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_json_sax.cpp -o bench_json_sax
+//   ./bench_json_sax
+//
+// "before" is what JSON::TConfig did: parse the whole file into a document
+// (one heap object per value, member and key, as TJSONObject does), then
+// walk it node by node, looking up "values" and "nodes" by name, to build
+// the tree.  "after" is JSON::Sax::Parse feeding the tree directly, as the
+// backend's stream loader does.  Both use the same parser, so the gap is
+// the document itself.  std::wstring stands in for System::String and a
+// std::map of std::variant for the node containers.  Allocation counts and
+// the peak of live heap bytes come from a counting operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgJSONSax.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+std::size_t Live;
+std::size_t Peak;
+
+// Every block carries its size in front, so that Release can account for it.
+void* Acquire( std::size_t Size )
+{
+    auto const Block = static_cast<std::size_t*>( std::malloc( Size + 16 ) );
+    if ( !Block ) {
+        throw std::bad_alloc{};
+    }
+    *Block = Size;
+    ++Allocs;
+    Live += Size;
+    if ( Live > Peak ) { Peak = Live; }
+    return reinterpret_cast<char*>( Block ) + 16;
+}
+
+void Release( void* Ptr ) noexcept
+{
+    if ( Ptr ) {
+        auto const Block = reinterpret_cast<std::size_t*>( static_cast<char*>( Ptr ) - 16 );
+        Live -= *Block;
+        std::free( Block );
+    }
+}
+
+} // namespace
+
+// Every form of new and delete goes through the same pair, so a block is
+// always released by the counterpart of the function that allocated it.
+void* operator new( std::size_t Size ) { return Acquire( Size ); }
+void* operator new[]( std::size_t Size ) { return Acquire( Size ); }
+void operator delete( void* Ptr ) noexcept { Release( Ptr ); }
+void operator delete[]( void* Ptr ) noexcept { Release( Ptr ); }
+void operator delete( void* Ptr, std::size_t ) noexcept { Release( Ptr ); }
+void operator delete[]( void* Ptr, std::size_t ) noexcept { Release( Ptr ); }
+
+namespace {
+
+namespace Sax = Anafestica::JSON::Sax;
+
+using Value = std::variant<int,bool,double,long long,std::wstring,std::vector<std::wstring>>;
+
+struct Node {
+    std::map<std::wstring,Value> Values;
+    std::map<std::wstring,std::unique_ptr<Node>> Nodes;
+};
+
+volatile std::size_t Sink;
+
+std::wstring Widen( std::string_view Text )
+{
+    return std::wstring( Text.begin(), Text.end() );
+}
+
+// Synthetic configuration: Count nodes, three levels deep, each holding a
+// mix of implicit and tagged values.
+std::string MakeDocument( std::size_t Count )
+{
+    std::string Doc;
+    std::size_t Made {};
+    auto AddNode = [&]( auto& Self, std::size_t Level ) -> void {
+        auto const Id = std::to_string( Made++ );
+        Doc += R"({"values":{)";
+        Doc += R"("Left":)" + Id + R"(,"Top":120,"Width":640,"Height":480,)";
+        Doc += R"("Caption":"Window é )" + Id + R"(","Visible":true,)";
+        Doc += R"("Ratio":{"dbl":0.75},"Stamp":{"ll":1700000000000},)";
+        Doc += R"("Recent":{"sv":["a.txt","b.txt","c.txt"]}})";
+        if ( Level < 2 ) {
+            Doc += R"(,"nodes":{)";
+            for ( int Idx = 0 ; Idx < 3 && Made < Count ; ++Idx ) {
+                if ( Idx ) { Doc += ','; }
+                Doc += "\"Child" + std::to_string( Idx ) + "\":";
+                Self( Self, Level + 1 );
+            }
+            Doc += '}';
+        }
+        Doc += '}';
+    };
+    Doc += R"({"nodes":{)";
+    for ( std::size_t Idx {} ; Made < Count ; ++Idx ) {
+        if ( Idx ) { Doc += ','; }
+        Doc += "\"Form" + std::to_string( Idx ) + "\":";
+        AddNode( AddNode, 0 );
+    }
+    Doc += "}}";
+    return Doc;
+}
+
+Value DecodeTagged( std::string_view Tag, std::string_view Text,
+                    std::vector<std::wstring>&& Strings )
+{
+    if ( Tag == "dbl" ) { return std::strtod( std::string( Text ).c_str(), nullptr ); }
+    if ( Tag == "ll" ) { return std::strtoll( std::string( Text ).c_str(), nullptr, 10 ); }
+    return std::move( Strings );
+}
+
+//---------------------------------------------------------------------------
+// before: document, then walk
+
+struct Json {
+    enum Kind { Object, Array, String, Number, Bool, Null } Type;
+    std::string Text;
+    std::vector<std::pair<std::unique_ptr<Json>,std::unique_ptr<Json>>> Members;
+    std::vector<std::unique_ptr<Json>> Items;
+
+    Json const * Find( std::string_view Name ) const {
+        for ( auto const & Member : Members ) {
+            if ( Member.first->Text == Name ) { return Member.second.get(); }
+        }
+        return nullptr;
+    }
+};
+
+class DomBuilder {
+public:
+    std::unique_ptr<Json> Root;
+
+    bool StartObject() { Push( Json::Object ); return true; }
+    bool Key( std::string_view Name ) {
+        auto& Top = *stack_.back();
+        Top.Members.emplace_back( Make( Json::String, Name ), nullptr );
+        return true;
+    }
+    void EndObject() { stack_.pop_back(); }
+    bool StartArray() { Push( Json::Array ); return true; }
+    void EndArray() { stack_.pop_back(); }
+    void String( std::string_view Text ) { Add( Make( Json::String, Text ) ); }
+    void Number( std::string_view Text ) { Add( Make( Json::Number, Text ) ); }
+    void Bool( bool Val ) { Add( Make( Json::Bool, Val ? "true" : "false" ) ); }
+    void Null() { Add( Make( Json::Null, {} ) ); }
+private:
+    std::vector<Json*> stack_;
+
+    static std::unique_ptr<Json> Make( Json::Kind Type, std::string_view Text ) {
+        auto Item = std::make_unique<Json>();
+        Item->Type = Type;
+        Item->Text = Text;
+        return Item;
+    }
+
+    Json* Add( std::unique_ptr<Json> Item ) {
+        auto const Ptr = Item.get();
+        if ( stack_.empty() ) {
+            Root = std::move( Item );
+        }
+        else if ( stack_.back()->Type == Json::Array ) {
+            stack_.back()->Items.push_back( std::move( Item ) );
+        }
+        else {
+            stack_.back()->Members.back().second = std::move( Item );
+        }
+        return Ptr;
+    }
+
+    void Push( Json::Kind Type ) {
+        stack_.push_back( Add( Make( Type, {} ) ) );
+    }
+};
+
+void Walk( Json const & Obj, Node& Into )
+{
+    if ( auto const Values = Obj.Find( "values" ) ) {
+        for ( auto const & Member : Values->Members ) {
+            auto const & Val = *Member.second;
+            auto Name = Widen( Member.first->Text );
+            switch ( Val.Type ) {
+                case Json::Number: Into.Values[Name] = std::atoi( Val.Text.c_str() ); break;
+                case Json::String: Into.Values[Name] = Widen( Val.Text ); break;
+                case Json::Bool:   Into.Values[Name] = Val.Text == "true"; break;
+                case Json::Object:
+                    if ( Val.Members.size() == 1 ) {
+                        auto const & Payload = *Val.Members[0].second;
+                        std::vector<std::wstring> Strings;
+                        for ( auto const & Item : Payload.Items ) {
+                            Strings.push_back( Widen( Item->Text ) );
+                        }
+                        Into.Values[Name] =
+                            DecodeTagged(
+                                Val.Members[0].first->Text, Payload.Text,
+                                std::move( Strings )
+                            );
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    if ( auto const Nodes = Obj.Find( "nodes" ) ) {
+        for ( auto const & Member : Nodes->Members ) {
+            if ( Member.second->Type == Json::Object ) {
+                auto& Child = Into.Nodes[Widen( Member.first->Text )];
+                Child = std::make_unique<Node>();
+                Walk( *Member.second, *Child );
+            }
+        }
+    }
+}
+
+std::unique_ptr<Node> LoadDom( std::string const & Doc )
+{
+    DomBuilder Builder;
+    Sax::Parse( Doc.data(), Doc.data() + Doc.size(), Builder );
+    auto Root = std::make_unique<Node>();
+    Walk( *Builder.Root, *Root );
+    return Root;
+}
+
+//---------------------------------------------------------------------------
+// after: straight into the tree
+
+class TreeBuilder {
+public:
+    Node Root;
+
+    bool StartObject() {
+        if ( states_.empty() ) {
+            nodes_.push_back( &Root );
+            states_.push_back( InNode );
+            return true;
+        }
+        switch ( states_.back() ) {
+            case InNode: states_.push_back( member_ ); return true;
+            case InValues: tag_.clear(); text_.clear(); strings_.clear();
+                           states_.push_back( InWrapper ); return true;
+            case InNodes: {
+                auto& Child = nodes_.back()->Nodes[name_];
+                Child = std::make_unique<Node>();
+                nodes_.push_back( Child.get() );
+                states_.push_back( InNode );
+                return true;
+            }
+            default: return false;
+        }
+    }
+
+    bool Key( std::string_view Name ) {
+        switch ( states_.back() ) {
+            case InNode:
+                if ( Name == "values" ) { member_ = InValues; return true; }
+                if ( Name == "nodes" ) { member_ = InNodes; return true; }
+                return false;
+            case InWrapper: tag_ = Name; return true;
+            default: name_ = Widen( Name ); return true;
+        }
+    }
+
+    void EndObject() {
+        auto const State = states_.back();
+        states_.pop_back();
+        if ( State == InWrapper ) {
+            nodes_.back()->Values[name_] = DecodeTagged( tag_, text_, std::move( strings_ ) );
+        }
+        else if ( State == InNode ) {
+            nodes_.pop_back();
+        }
+    }
+
+    bool StartArray() {
+        if ( states_.back() != InWrapper ) { return false; }
+        states_.push_back( InArray );
+        return true;
+    }
+
+    void EndArray() { states_.pop_back(); }
+
+    void String( std::string_view Text ) {
+        switch ( states_.back() ) {
+            case InValues: nodes_.back()->Values[name_] = Widen( Text ); break;
+            case InWrapper: text_ = Text; break;
+            case InArray: strings_.push_back( Widen( Text ) ); break;
+            default: break;
+        }
+    }
+
+    void Number( std::string_view Text ) {
+        if ( states_.back() == InValues ) {
+            nodes_.back()->Values[name_] = std::atoi( std::string( Text ).c_str() );
+        }
+        else if ( states_.back() == InWrapper ) {
+            text_ = Text;
+        }
+    }
+
+    void Bool( bool Val ) {
+        if ( states_.back() == InValues ) { nodes_.back()->Values[name_] = Val; }
+    }
+
+    void Null() {}
+private:
+    enum State { InNode, InValues, InNodes, InWrapper, InArray };
+
+    std::vector<Node*> nodes_;
+    std::vector<State> states_;
+    State member_ { InValues };
+    std::wstring name_;
+    std::string tag_;
+    std::string text_;
+    std::vector<std::wstring> strings_;
+};
+
+std::unique_ptr<Node> LoadStream( std::string const & Doc )
+{
+    auto Builder = std::make_unique<TreeBuilder>();
+    Sax::Parse( Doc.data(), Doc.data() + Doc.size(), *Builder );
+    auto Root = std::make_unique<Node>();
+    *Root = std::move( Builder->Root );
+    return Root;
+}
+
+//---------------------------------------------------------------------------
+
+std::size_t CountValues( Node const & N )
+{
+    auto Count = N.Values.size();
+    for ( auto const & Child : N.Nodes ) { Count += CountValues( *Child.second ); }
+    return Count;
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t PeakBytes;
+    std::size_t Values;
+};
+
+template<typename F>
+Sample Measure( std::string const & Doc, int Rounds, F&& Load )
+{
+    Sample Result {};
+    auto const Start = std::chrono::steady_clock::now();
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const BaseLive = Live;
+        Peak = Live;
+        auto Root = Load( Doc );
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.PeakBytes = Peak - BaseLive;
+        Result.Values = CountValues( *Root );
+    }
+    auto const Stop = std::chrono::steady_clock::now();
+    Result.Us = std::chrono::duration<double,std::micro>( Stop - Start ).count() / Rounds;
+    Sink = Result.Values;
+    return Result;
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const Doc = MakeDocument( Count );
+    auto const Dom = Measure( Doc, Rounds, &LoadDom );
+    auto const Stream = Measure( Doc, Rounds, &LoadStream );
+    if ( Dom.Values != Stream.Values ) {
+        std::printf( "mismatch: %zu / %zu values\n", Dom.Values, Stream.Values );
+        std::exit( 1 );
+    }
+    std::printf(
+        "%6zu nodes %8zu KiB | %9.0f / %9.0f us | allocs %8zu / %8zu | peak %7zu / %7zu KiB\n",
+        Count, Doc.size() / 1024, Dom.Us, Stream.Us, Dom.Allocs, Stream.Allocs,
+        Dom.PeakBytes / 1024, Stream.PeakBytes / 1024
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "eager load, document + walk / stream\n" );
+    Run( 100, 200 );
+    Run( 1000, 20 );
+    Run( 10000, 3 );
+    return 0;
+}
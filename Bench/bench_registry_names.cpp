@@ -0,0 +1,199 @@
+//---------------------------------------------------------------------------
+// Registry value-name decoding benchmark: the work Registry::TConfig's
+// DoCreateValueList does for every value of a key before it can read it
+// ("Name:(tag)" -> name and TypeTag, or an untyped value).
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_registry_names.cpp -o bench_registry_names
+//   ./bench_registry_names
+//
+// "before" is what the backend did: build a std::wregex with one group per
+// tag for each key, regex_match every value name against it, and find the
+// first group that matched.  "after" is DecodeTagSuffix (one backward scan
+// for ":(" and FindTypeTag over the tag).  Both must agree on every name of
+// the corpus.  std::wstring stands in for System::String.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgTypeTag.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Anafestica::TypeTag;
+using Anafestica::TypeTagCount;
+using Anafestica::TypeTagNames;
+
+volatile std::size_t Sink;
+
+template<typename F>
+double TimeNs( std::size_t Ops, F&& Fn )
+{
+    auto const Start = std::chrono::steady_clock::now();
+    Fn();
+    auto const Stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>( Stop - Start ).count() / Ops;
+}
+
+std::wstring Widen( char const * Text )
+{
+    return std::wstring( Text, Text + std::char_traits<char>::length( Text ) );
+}
+
+struct Decoded {
+    std::wstring Name;
+    int Idx;   // -1: untyped
+
+    bool operator==( Decoded const & Rhs ) const {
+        return Idx == Rhs.Idx && Name == Rhs.Name;
+    }
+};
+
+// The pattern DoCreateValueList compiled, with the tags in TypeTag order.
+std::wstring Pattern()
+{
+    std::wstring Result( L"^(.*?)(?::(\\((?:" );
+    for ( std::size_t Idx {} ; Idx < TypeTagCount ; ++Idx ) {
+        Result += Idx ? L"|(" : L"(";
+        Result += Widen( TypeTagNames[Idx] );
+        Result += L")";
+    }
+    Result += L"))\\))?$";
+    return Result;
+}
+
+void DecodeRegex( std::vector<std::wstring> const & Names, std::vector<Decoded>& Out )
+{
+    std::wregex const re( Pattern() );
+    std::wcmatch ms;
+    for ( auto const & ValueName : Names ) {
+        if ( std::regex_match( ValueName.c_str(), ms, re ) ) {
+            auto It = std::begin( ms );
+            std::advance( It, 1 );
+            std::wstring Name = It->str();
+            std::advance( It, 2 );
+            It = std::find_if( It, std::end( ms ), []( auto const & m ) { return m.matched; } );
+            if ( It != std::end( ms ) ) {
+                Out.push_back( { std::move( Name ), static_cast<int>( std::distance( std::begin( ms ), It ) - 3 ) } );
+            }
+            else {
+                Out.push_back( { ValueName, -1 } );
+            }
+        }
+    }
+}
+
+void DecodeSuffix( std::vector<std::wstring> const & Names, std::vector<Decoded>& Out )
+{
+    for ( auto const & ValueName : Names ) {
+        std::wstring_view NameView( ValueName );
+        if ( auto const Tag = Anafestica::DecodeTagSuffix( NameView, ":(", NameView ) ) {
+            Out.push_back( { std::wstring( NameView ), static_cast<int>( *Tag ) } );
+        }
+        else {
+            Out.push_back( { ValueName, -1 } );
+        }
+    }
+}
+
+// Mostly names written by the backend, with some that are not: untyped
+// values, unknown or malformed suffixes, colons and parentheses in names.
+std::vector<std::vector<std::wstring>> Corpus( std::size_t Keys, std::size_t ValuesPerKey )
+{
+    static wchar_t const * const Stems[] = {
+        L"Left", L"Top", L"Width", L"Height", L"WindowState", L"RecentFiles",
+        L"LastOpenedProjectDirectoryOnThisMachine", L"a", L"Grid:Columns",
+        L"Font(Size)", L"Name:(x", L"C:\\Data\\Settings", L"Colour::Accent",
+    };
+    static wchar_t const * const Junk[] = {
+        L"", L":(xx)", L":(STR)", L":(i", L"(i)", L"::(i)x", L":()", L":(i)(u)",
+    };
+    std::mt19937 Rng( 42 );
+    std::uniform_int_distribution<std::size_t> PickStem( 0, std::size( Stems ) - 1 );
+    std::uniform_int_distribution<std::size_t> PickTag( 0, TypeTagCount - 1 );
+    std::uniform_int_distribution<std::size_t> PickJunk( 0, std::size( Junk ) - 1 );
+    std::uniform_int_distribution<int> Percent( 0, 99 );
+
+    std::vector<std::vector<std::wstring>> Result( Keys );
+    for ( auto& Names : Result ) {
+        for ( std::size_t Idx {} ; Idx < ValuesPerKey ; ++Idx ) {
+            std::wstring Name( Stems[PickStem( Rng )] );
+            Name += std::to_wstring( Idx );
+            if ( Percent( Rng ) < 85 ) {
+                Name += L":(";
+                Name += Widen( TypeTagNames[PickTag( Rng )] );
+                Name += L")";
+            }
+            else {
+                Name += Junk[PickJunk( Rng )];
+            }
+            Names.push_back( std::move( Name ) );
+        }
+    }
+    return Result;
+}
+
+void Run( std::size_t Keys, std::size_t ValuesPerKey )
+{
+    auto const Names = Corpus( Keys, ValuesPerKey );
+    auto const Count = Keys * ValuesPerKey;
+
+    for ( auto const & Key : Names ) {
+        std::vector<Decoded> Old, New;
+        DecodeRegex( Key, Old );
+        DecodeSuffix( Key, New );
+        if ( Old != New ) {
+            std::fprintf( stderr, "decoders disagree\n" );
+            std::exit( 1 );
+        }
+    }
+
+    std::vector<Decoded> Out;
+    Out.reserve( ValuesPerKey );
+    auto const Old = TimeNs( Count, [&]{
+        std::size_t Sum {};
+        for ( auto const & Key : Names ) {
+            Out.clear();
+            DecodeRegex( Key, Out );
+            Sum += Out.size();
+        }
+        Sink = Sum;
+    } );
+    auto const New = TimeNs( Count, [&]{
+        std::size_t Sum {};
+        for ( auto const & Key : Names ) {
+            Out.clear();
+            DecodeSuffix( Key, Out );
+            Sum += Out.size();
+        }
+        Sink = Sum;
+    } );
+
+    std::printf(
+        "%5zu keys x %4zu values | per value %8.1f / %6.1f ns | per key %9.2f / %7.2f us | x%.0f\n",
+        Keys, ValuesPerKey, Old, New,
+        Old * ValuesPerKey / 1000.0, New * ValuesPerKey / 1000.0, Old / New
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "value-name decoding, before / after\n" );
+    Run( 2000, 4 );
+    Run( 1000, 16 );
+    Run( 200, 128 );
+    Run( 20, 2048 );
+    return 0;
+}
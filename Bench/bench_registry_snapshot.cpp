@@ -0,0 +1,300 @@
+//---------------------------------------------------------------------------
+// Registry start-up with and without a snapshot: loading a subtree the way
+// Registry::TConfig does, straight from the store, vs through a
+// Store::TSnapshot loaded from the bytes the previous run saved.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_registry_snapshot.cpp -o bench_registry_snapshot
+//   ./bench_registry_snapshot
+//
+// The load opens every key, enumerates its values and its subkeys, and
+// descends.  "full" does that on the in-memory hive; "snapshot" loads the
+// image the previous run saved first, checks every key against its stamp
+// and reads only those whose stamp moved, then saves the image again when
+// it changed.  Between the two runs, the "1% changed" rows rewrite a
+// value in one key of a hundred: "by the app" through a snapshot, which
+// saves the image with the keys it wrote read again; "by another writer"
+// straight into the hive, so that the keys it wrote are read on their
+// own at the next start.  Both loads must see the same tree.
+//
+// The calls counted are those TWinStore makes for the same work on
+// Windows, each a system call: RegOpenKeyEx per key, RegQueryInfoKey plus
+// one RegEnumValue per value and one RegEnumKeyEx per subkey (each with
+// the call that ends the enumeration), RegQueryInfoKey for a stamp and
+// RegSetValueEx for each write.
+// The times, the best of five runs, leave those costs out: on the
+// in-memory hive a full read costs little more than opening the keys,
+// which the snapshot has to do as well.  The last column adds CallUs per
+// call, a low estimate of a registry round trip, to both.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgRegistryStore.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+namespace Store = Anafestica::Registry::Store;
+
+volatile std::size_t Sink;
+
+// Microseconds a registry system call is taken to cost.
+constexpr double CallUs = 1.0;
+
+template<typename F>
+double TimeNs( F&& Fn )
+{
+    auto const Start = std::chrono::steady_clock::now();
+    Fn();
+    auto const Stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>( Stop - Start ).count();
+}
+
+// Counts the system calls TWinStore would make for the calls it passes on.
+class TCountingStore final : public Store::TStore {
+public:
+    explicit TCountingStore( Store::TStore& Source ) noexcept : source_{ Source } {}
+
+    std::size_t Calls {};
+
+    std::unique_ptr<Store::TKey> Open( Store::TStringView Path ) override {
+        ++Calls;
+        auto Key = source_.Open( Path );
+        return Key ? std::make_unique<TKey>( *this, std::move( Key ) ) : nullptr;
+    }
+
+    std::unique_ptr<Store::TKey> Create( Store::TStringView Path ) override {
+        ++Calls;
+        return source_.Create( Path );
+    }
+
+    bool Delete( Store::TStringView Path ) override {
+        ++Calls;
+        return source_.Delete( Path );
+    }
+private:
+    class TKey final : public Store::TKey {
+    public:
+        TKey( TCountingStore& Owner, std::unique_ptr<Store::TKey> Key ) noexcept
+            : owner_{ Owner }, key_{ std::move( Key ) } {}
+
+        void EnumValues( Store::TValueVisitor& Visitor ) override {
+            owner_.Calls += 2;
+            Store::ForEachValue( *key_, [&]( Store::TValue const & Val ) {
+                ++owner_.Calls;
+                Visitor.Visit( Val );
+            } );
+        }
+
+        void EnumKeys( Store::TKeyVisitor& Visitor ) override {
+            owner_.Calls += 2;
+            Store::ForEachKey( *key_, [&]( Store::TStringView Name ) {
+                ++owner_.Calls;
+                Visitor.Visit( Name );
+            } );
+        }
+
+        bool Query( Store::TStringView Name, Store::TValueVisitor& Visitor ) override {
+            ++owner_.Calls;
+            return key_->Query( Name, Visitor );
+        }
+
+        void Apply( Store::TBatch const & Batch ) override {
+            owner_.Calls += Batch.Size();
+            key_->Apply( Batch );
+        }
+
+        Store::TStamp GetStamp() override {
+            ++owner_.Calls;
+            return key_->GetStamp();
+        }
+    private:
+        TCountingStore& owner_;
+        std::unique_ptr<Store::TKey> key_;
+    };
+
+    Store::TStore& source_;
+};
+
+Store::TString const Root = L"Software\\Vendor\\App";
+
+// Groups of nodes, each with values: the shape of a form-heavy app.
+void Fill( Store::TStore& Hive, std::size_t Groups, std::size_t Nodes, std::size_t Values )
+{
+    Store::TBatch Batch;
+    for ( std::size_t Group {} ; Group < Groups ; ++Group ) {
+        for ( std::size_t Node {} ; Node < Nodes ; ++Node ) {
+            Batch.Clear();
+            for ( std::size_t Idx {} ; Idx < Values ; ++Idx ) {
+                auto const Name = L"Value" + std::to_wstring( Idx );
+                if ( Idx % 3 ) {
+                    Batch.SetDword( Name + L":(i)", static_cast<std::uint32_t>( Idx + Node ) );
+                }
+                else {
+                    Batch.SetString( Name + L":(sz)", L"Some text for value " + std::to_wstring( Idx ) );
+                }
+            }
+            Hive.Create(
+                Root + L"\\Group" + std::to_wstring( Group ) + L"\\Node" + std::to_wstring( Node )
+            )->Apply( Batch );
+        }
+    }
+}
+
+// Every key of the subtree, as TConfig's eager load reads it; returns
+// a digest of what it saw.
+std::size_t Load( Store::TStore& From, Store::TString const & Path )
+{
+    auto Key = From.Open( Path );
+    if ( !Key ) {
+        return 0;
+    }
+    std::size_t Digest { Path.size() };
+    Store::ForEachValue( *Key, [&]( Store::TValue const & Val ) {
+        Digest = Digest * 31 + Val.Name.size() * 7 + Val.Size;
+        std::uint64_t Word;
+        for ( std::size_t Idx {} ; Idx + sizeof Word <= Val.Size ; Idx += sizeof Word ) {
+            std::memcpy( &Word, Val.Data + Idx, sizeof Word );
+            Digest = Digest * 3 + Word;
+        }
+        for ( auto Idx = Val.Size / sizeof Word * sizeof Word ; Idx < Val.Size ; ++Idx ) {
+            Digest = Digest * 3 + Val.Data[Idx];
+        }
+    } );
+    std::vector<Store::TString> Keys;
+    Store::ForEachKey( *Key, [&]( Store::TStringView Name ) { Keys.emplace_back( Name ); } );
+    Key.reset();
+    for ( auto const & Name : Keys ) {
+        Digest = Digest * 17 + Load( From, Path + L"\\" + Name );
+    }
+    return Digest;
+}
+
+enum class TChange { None, ByApp, ByOther };
+
+void Change( Store::TStore& Hive, std::size_t Groups, std::size_t Nodes )
+{
+    Store::TBatch Batch;
+    Batch.SetDword( L"Value1:(i)", 12345 );
+    for ( std::size_t Group {} ; Group < Groups ; ++Group ) {
+        for ( std::size_t Node {} ; Node < Nodes ; Node += 100 ) {
+            Hive.Open(
+                Root + L"\\Group" + std::to_wstring( Group ) + L"\\Node" + std::to_wstring( Node )
+            )->Apply( Batch );
+        }
+    }
+}
+
+// One start-up of each kind, on a hive filled and changed afresh.
+struct TRow {
+    std::size_t FullCalls {};
+    std::size_t CachedCalls {};
+    double FullTime {};
+    double CachedTime {};
+    std::size_t ImageSize {};
+    std::size_t Misses {};
+};
+
+TRow Measure( std::size_t Groups, std::size_t Nodes, std::size_t Values, TChange Changed )
+{
+    Store::TMemoryHive Hive;
+    Fill( Hive, Groups, Nodes, Values );
+    std::vector<unsigned char> Image;
+    {
+        Store::TSnapshot Snapshot( Hive, Root );
+        Load( Snapshot, Root );
+        Snapshot.Refresh();
+        Image = Snapshot.Save();
+    }
+    if ( Changed == TChange::ByApp ) {
+        Store::TSnapshot Snapshot( Hive, Root );
+        Snapshot.Load( Image );
+        Load( Snapshot, Root );
+        Change( Snapshot, Groups, Nodes );
+        Snapshot.Refresh();
+        Image = Snapshot.Save();
+    }
+    else if ( Changed == TChange::ByOther ) {
+        Change( Hive, Groups, Nodes );
+    }
+
+    TRow Row;
+    Row.ImageSize = Image.size();
+    TCountingStore Counted( Hive );
+    std::size_t Full {};
+    Row.FullTime = TimeNs( [&]{ Full = Load( Counted, Root ); } );
+    Row.FullCalls = Counted.Calls;
+
+    Counted.Calls = 0;
+    std::size_t Cached {};
+    Row.CachedTime = TimeNs( [&]{
+        Store::TSnapshot Snapshot( Counted, Root );
+        if ( !Snapshot.Load( std::move( Image ) ) ) {
+            std::fprintf( stderr, "image rejected\n" );
+            std::exit( 1 );
+        }
+        Cached = Load( Snapshot, Root );
+        Row.Misses = Snapshot.GetStats().Misses;
+        if ( Snapshot.IsModified() ) {
+            Sink = Snapshot.Save().size();
+        }
+    } );
+    Row.CachedCalls = Counted.Calls;
+
+    if ( Full != Cached ) {
+        std::fprintf( stderr, "loads disagree\n" );
+        std::exit( 1 );
+    }
+    return Row;
+}
+
+// The best time of a few runs of each.
+void Run( std::size_t Groups, std::size_t Nodes, std::size_t Values, TChange Changed )
+{
+    auto Row = Measure( Groups, Nodes, Values, Changed );
+    for ( int Repeat = 1 ; Repeat < 5 ; ++Repeat ) {
+        auto const Next = Measure( Groups, Nodes, Values, Changed );
+        Row.FullTime = std::min( Row.FullTime, Next.FullTime );
+        Row.CachedTime = std::min( Row.CachedTime, Next.CachedTime );
+    }
+
+    static char const * const Labels[] = {
+        "                         ",
+        ", 1% changed by the app  ",
+        ", 1% changed by another  "
+    };
+    auto const Keys = 1 + Groups + Groups * Nodes;
+    std::printf(
+        "%6zu keys x %3zu values%s | calls %8zu / %6zu | %7.0f / %7.0f us"
+        " | image %6zu KiB, %4zu keys read | with calls %7.0f / %7.0f us\n",
+        Keys, Values, Labels[static_cast<int>( Changed )],
+        Row.FullCalls, Row.CachedCalls, Row.FullTime / 1000.0, Row.CachedTime / 1000.0,
+        Row.ImageSize / 1024, Row.Misses,
+        Row.FullTime / 1000.0 + Row.FullCalls * CallUs,
+        Row.CachedTime / 1000.0 + Row.CachedCalls * CallUs
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "start-up, full read / through the snapshot\n" );
+    for ( auto const Changed : { TChange::None, TChange::ByApp, TChange::ByOther } ) {
+        Run( 10, 20, 8, Changed );
+    }
+    for ( auto const Changed : { TChange::None, TChange::ByApp, TChange::ByOther } ) {
+        Run( 20, 100, 16, Changed );
+    }
+    for ( auto const Changed : { TChange::None, TChange::ByApp, TChange::ByOther } ) {
+        Run( 10, 1000, 4, Changed );
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+//---------------------------------------------------------------------------
+// Registry load and flush over the Store interface, on the in-memory hive:
+// the calls Registry::TConfig makes per key and per value.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_registry_store.cpp -o bench_registry_store
+//   ./bench_registry_store
+//
+// Load "before" is the TRegistry pattern the backend used: list the value
+// names of a key, then for every value ask for its type and size and read
+// its data, two queries per value.  "after" is one EnumValues pass per key
+// that hands out name, type and data together.  Flush "before" sets each
+// value with a call of its own; "after" gathers a key's writes in a
+// TBatch applied with one call.  Both loads must build the same values.
+//
+// On Windows each store call is a system call (RegEnumValue,
+// RegQueryValueEx, RegSetValueEx), so the call counts matter more than
+// the in-process times measured here.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgRegistryStore.h>
+#include <anafestica/CfgTypeTag.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+namespace Store = Anafestica::Registry::Store;
+
+using Value = std::variant<long long,double,std::wstring,std::vector<std::wstring>,
+                           std::vector<unsigned char>>;
+using Values = std::vector<std::pair<std::wstring,Value>>;
+
+volatile std::size_t Sink;
+
+template<typename F>
+double TimeNs( std::size_t Ops, F&& Fn )
+{
+    auto const Start = std::chrono::steady_clock::now();
+    Fn();
+    auto const Stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>( Stop - Start ).count() / Ops;
+}
+
+std::wstring KeyPath( std::size_t Key )
+{
+    return L"Software\\Vendor\\App\\Node" + std::to_wstring( Key );
+}
+
+// A key's values as the backend writes them: tagged and untagged
+// integers, strings, doubles, string lists and bytes.
+void Fill( Store::TBatch& Batch, std::size_t Count, std::size_t Seed )
+{
+    for ( std::size_t Idx {} ; Idx < Count ; ++Idx ) {
+        auto const Name = L"Value" + std::to_wstring( Idx );
+        switch ( ( Idx + Seed ) % 6 ) {
+            case 0:
+                Batch.SetDword( Name, static_cast<std::uint32_t>( Idx * 7 + Seed ) );
+                break;
+            case 1:
+                Batch.SetDword( Name + L":(u)", static_cast<std::uint32_t>( Idx ) );
+                break;
+            case 2:
+                Batch.SetString( Name, L"C:\\Users\\someone\\Documents\\file" + std::to_wstring( Idx ) );
+                break;
+            case 3: {
+                double const Val = Idx * 0.5;
+                Batch.Set( Name + L":(dbl)", Store::TType::Binary, &Val, sizeof Val );
+                break;
+            }
+            case 4: {
+                std::wstring const Items[] = { L"alpha", L"beta", L"gamma" };
+                Batch.SetStrings(
+                    Name, std::begin( Items ), std::end( Items ),
+                    []( std::wstring const & Item ) { return Store::TStringView( Item ); }
+                );
+                break;
+            }
+            default:
+                Batch.SetQword( Name + L":(ull)", Idx * 1000003ULL );
+                break;
+        }
+    }
+}
+
+Value Decode( Store::TValue const & Val )
+{
+    switch ( Val.Type ) {
+        case Store::TType::Dword:
+            return static_cast<long long>( Val.GetDword() );
+        case Store::TType::Qword:
+            return static_cast<long long>( Val.GetQword() );
+        case Store::TType::Sz:
+            return std::wstring( Val.GetString() );
+        case Store::TType::MultiSz: {
+            std::vector<std::wstring> Items;
+            Val.ForEachString( [&]( Store::TStringView Item ) { Items.emplace_back( Item ); } );
+            return Items;
+        }
+        default:
+            if ( Val.Size == sizeof( double ) ) {
+                double Result;
+                std::memcpy( &Result, Val.Data, sizeof Result );
+                return Result;
+            }
+            return std::vector<unsigned char>( Val.Data, Val.Data + Val.Size );
+    }
+}
+
+void Put( Values& Out, Store::TStringView ValueName, Value Val )
+{
+    auto Name = ValueName;
+    (void)Anafestica::DecodeTagSuffix( Name, ":(", Name );
+    Out.emplace_back( std::wstring( Name ), std::move( Val ) );
+}
+
+// Names first, then a type-and-size query and a data query per value.
+std::size_t LoadByName( Store::TStore& Hive, std::size_t Keys, std::vector<Values>& Out )
+{
+    std::size_t Calls {};
+    std::vector<std::wstring> Names;
+    for ( std::size_t Key {} ; Key < Keys ; ++Key ) {
+        auto const Handle = Hive.Open( KeyPath( Key ) );
+        ++Calls;
+        Names.clear();
+        Store::ForEachValue( *Handle, [&]( Store::TValue const & Val ) {
+            Names.emplace_back( Val.Name );
+        } );
+        ++Calls;
+        auto& Vals = Out[Key];
+        for ( auto const & Name : Names ) {
+            Store::TType Type {};
+            std::size_t Size {};
+            Store::QueryValue( *Handle, Name, [&]( Store::TValue const & Val ) {
+                Type = Val.Type;
+                Size = Val.Size;
+            } );
+            Store::QueryValue( *Handle, Name, [&]( Store::TValue const & Val ) {
+                if ( Val.Type == Type && Val.Size == Size ) {
+                    Put( Vals, Val.Name, Decode( Val ) );
+                }
+            } );
+            Calls += 2;
+        }
+    }
+    return Calls;
+}
+
+// One pass per key.
+std::size_t LoadByEnum( Store::TStore& Hive, std::size_t Keys, std::vector<Values>& Out )
+{
+    std::size_t Calls {};
+    for ( std::size_t Key {} ; Key < Keys ; ++Key ) {
+        auto const Handle = Hive.Open( KeyPath( Key ) );
+        auto& Vals = Out[Key];
+        Store::ForEachValue( *Handle, [&]( Store::TValue const & Val ) {
+            Put( Vals, Val.Name, Decode( Val ) );
+        } );
+        Calls += 2;
+    }
+    return Calls;
+}
+
+// One call per value, as TRegistry's Write methods make.
+std::size_t FlushByValue( Store::TStore& Hive, std::size_t Keys, std::size_t Count )
+{
+    std::size_t Calls {};
+    Store::TBatch All;
+    Store::TBatch One;
+    for ( std::size_t Key {} ; Key < Keys ; ++Key ) {
+        auto const Handle = Hive.Create( KeyPath( Key ) );
+        ++Calls;
+        All.Clear();
+        Fill( All, Count, Key + 1 );
+        All.ForEach( [&]( Store::TValue const & Val, bool ) {
+            One.Clear();
+            One.Set( Val.Name, Val.Type, Val.Data, Val.Size );
+            Handle->Apply( One );
+            ++Calls;
+        } );
+    }
+    return Calls;
+}
+
+std::size_t FlushByKey( Store::TStore& Hive, std::size_t Keys, std::size_t Count )
+{
+    std::size_t Calls {};
+    Store::TBatch Batch;
+    for ( std::size_t Key {} ; Key < Keys ; ++Key ) {
+        auto const Handle = Hive.Create( KeyPath( Key ) );
+        Batch.Clear();
+        Fill( Batch, Count, Key + 1 );
+        Handle->Apply( Batch );
+        Calls += 2;
+    }
+    return Calls;
+}
+
+void Run( std::size_t Keys, std::size_t Count )
+{
+    Store::TMemoryHive Hive;
+    FlushByKey( Hive, Keys, Count );
+
+    std::vector<Values> Old( Keys );
+    std::vector<Values> New( Keys );
+    LoadByName( Hive, Keys, Old );
+    LoadByEnum( Hive, Keys, New );
+    if ( Old != New ) {
+        std::fprintf( stderr, "loads disagree\n" );
+        std::exit( 1 );
+    }
+
+    std::size_t OldLoadCalls {};
+    std::size_t NewLoadCalls {};
+    auto const OldLoad = TimeNs( Keys, [&]{
+        for ( auto& Vals : Old ) { Vals.clear(); }
+        OldLoadCalls = LoadByName( Hive, Keys, Old );
+        Sink = Old.back().size();
+    } );
+    auto const NewLoad = TimeNs( Keys, [&]{
+        for ( auto& Vals : New ) { Vals.clear(); }
+        NewLoadCalls = LoadByEnum( Hive, Keys, New );
+        Sink = New.back().size();
+    } );
+
+    std::size_t OldFlushCalls {};
+    std::size_t NewFlushCalls {};
+    auto const OldFlush = TimeNs( Keys, [&]{ OldFlushCalls = FlushByValue( Hive, Keys, Count ); } );
+    auto const NewFlush = TimeNs( Keys, [&]{ NewFlushCalls = FlushByKey( Hive, Keys, Count ); } );
+
+    std::printf(
+        "%5zu keys x %4zu values | load %8.2f / %7.2f us/key, calls %5zu / %zu"
+        " | flush %8.2f / %7.2f us/key, calls %5zu / %zu\n",
+        Keys, Count,
+        OldLoad / 1000.0, NewLoad / 1000.0, OldLoadCalls / Keys, NewLoadCalls / Keys,
+        OldFlush / 1000.0, NewFlush / 1000.0, OldFlushCalls / Keys, NewFlushCalls / Keys
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "per key, before / after\n" );
+    Run( 2000, 4 );
+    Run( 1000, 16 );
+    Run( 200, 128 );
+    Run( 20, 1024 );
+    return 0;
+}
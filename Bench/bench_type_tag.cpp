@@ -0,0 +1,180 @@
+//---------------------------------------------------------------------------
+// Type-tag decoding micro-benchmark: the per-value work a file backend does
+// before it can build a value (tag text -> TypeTag -> builder call).
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_type_tag.cpp -o bench_type_tag
+//   ./bench_type_tag
+//
+// "before" is what the backends did: std::lower_bound over the sorted tag
+// table, building a string object per comparison, then a call through a
+// function-local static std::array of std::function builders.  "after" is
+// FindTypeTag (compile-time perfect hash over the characters) followed by
+// a call through a constexpr table of function pointers, as
+// Codec::Decode does.  std::wstring stands in for System::String.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgTypeTag.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using Anafestica::TypeTag;
+using Anafestica::TypeTagCount;
+using Anafestica::TypeTagNames;
+
+using Value = std::variant<long long,double,std::wstring>;
+
+volatile std::size_t Sink;
+
+template<typename F>
+double TimeNs( std::size_t Ops, F&& Fn )
+{
+    auto const Start = std::chrono::steady_clock::now();
+    Fn();
+    auto const Stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::nano>( Stop - Start ).count() / Ops;
+}
+
+std::wstring Widen( char const * Text )
+{
+    return std::wstring( Text, Text + std::char_traits<char>::length( Text ) );
+}
+
+std::optional<TypeTag> LowerBoundTypeTag( std::wstring const & Val )
+{
+    using Entry = std::pair<wchar_t const *,TypeTag>;
+    static std::array<Entry,TypeTagCount> const TypeIds = []{
+        static std::array<std::wstring,TypeTagCount> Names;
+        std::array<Entry,TypeTagCount> Ids {};
+        for ( std::size_t Idx {} ; Idx < TypeTagCount ; ++Idx ) {
+            Names[Idx] = Widen( TypeTagNames[Idx] );
+            Ids[Idx] = Entry( Names[Idx].c_str(), static_cast<TypeTag>( Idx ) );
+        }
+        std::sort(
+            Ids.begin(), Ids.end(),
+            []( Entry const & Lhs, Entry const & Rhs ) {
+                return std::wstring( Lhs.first ) < Rhs.first;
+            }
+        );
+        return Ids;
+    }();
+
+    auto It =
+        std::lower_bound(
+            TypeIds.begin(), TypeIds.end(), Val,
+            []( Entry const & Lhs, std::wstring const & Rhs ) {
+                return std::wstring( Lhs.first ) < Rhs;
+            }
+        );
+    if ( It != TypeIds.end() && std::wstring( It->first ) == Val ) {
+        return It->second;
+    }
+    return std::nullopt;
+}
+
+template<std::size_t I>
+Value Build( std::wstring const & Text )
+{
+    if constexpr ( I % 3 == 0 ) {
+        return static_cast<long long>( Text.size() + I );
+    }
+    else if constexpr ( I % 3 == 1 ) {
+        return static_cast<double>( Text.size() ) * I;
+    }
+    else {
+        return Text;
+    }
+}
+
+template<std::size_t... I>
+std::array<std::function<Value(std::wstring const &)>,TypeTagCount>
+MakeFunctionBuilders( std::index_sequence<I...> )
+{
+    return { { &Build<I>... } };
+}
+
+template<std::size_t... I>
+Value DecodeThunks( TypeTag Tag, std::wstring const & Text, std::index_sequence<I...> )
+{
+    using Thunk = Value(*)( std::wstring const & );
+    static constexpr Thunk Table[] = { &Build<I>... };
+    return Table[static_cast<std::size_t>( Tag )]( Text );
+}
+
+void Run( std::size_t Count )
+{
+    std::vector<std::wstring> Tags;
+    Tags.reserve( Count );
+    std::mt19937 Rng( 42 );
+    std::uniform_int_distribution<std::size_t> Pick( 0, TypeTagCount - 1 );
+    for ( std::size_t i = 0 ; i < Count ; ++i ) {
+        Tags.push_back( Widen( TypeTagNames[Pick( Rng )] ) );
+    }
+    std::wstring const Payload( L"12345" );
+
+    auto const OldFind = TimeNs( Count, [&]{
+        std::size_t Hits {};
+        for ( auto const & Tag : Tags ) { Hits += LowerBoundTypeTag( Tag ).has_value(); }
+        Sink = Hits;
+    } );
+    auto const NewFind = TimeNs( Count, [&]{
+        std::size_t Hits {};
+        for ( auto const & Tag : Tags ) {
+            Hits += Anafestica::FindTypeTag( Tag.data(), Tag.size() ).has_value();
+        }
+        Sink = Hits;
+    } );
+
+    auto const OldDecode = TimeNs( Count, [&]{
+        static auto const Builders =
+            MakeFunctionBuilders( std::make_index_sequence<TypeTagCount>{} );
+        std::size_t Sum {};
+        for ( auto const & Tag : Tags ) {
+            if ( auto Id = LowerBoundTypeTag( Tag ) ) {
+                Sum += Builders[static_cast<std::size_t>( *Id )]( Payload ).index();
+            }
+        }
+        Sink = Sum;
+    } );
+    auto const NewDecode = TimeNs( Count, [&]{
+        std::size_t Sum {};
+        for ( auto const & Tag : Tags ) {
+            if ( auto Id = Anafestica::FindTypeTag( Tag.data(), Tag.size() ) ) {
+                Sum +=
+                    DecodeThunks(
+                        *Id, Payload, std::make_index_sequence<TypeTagCount>{}
+                    ).index();
+            }
+        }
+        Sink = Sum;
+    } );
+
+    std::printf(
+        "%8zu values | tag lookup %6.1f / %6.1f ns | lookup + build %6.1f / %6.1f ns\n",
+        Count, OldFind, NewFind, OldDecode, NewDecode
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "per-value cost, before / after\n" );
+    Run( 1000 );
+    Run( 100000 );
+    Run( 1000000 );
+    return 0;
+}
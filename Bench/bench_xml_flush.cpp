@@ -0,0 +1,343 @@
+//---------------------------------------------------------------------------
+// XML flush benchmark: sibling lookups and removals of the document
+// writer, scanned against indexed.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_xml_flush.cpp -o bench_xml_flush
+//   ./bench_xml_flush
+//
+// The document is modelled as IXMLDocument holds it: elements with a list
+// of children and a list of attributes, UTF-16 names and values.  It has
+// one node with N values and N children of three values each.  The flush
+// does what XML::TConfig::DoFlush does for an edit of every value, one
+// value per child, and the erasure of one value and one child in every
+// ten (or two): each child is resolved from its parent ("nodes", then the
+// "node" named so) and each value from its "values" element, creating
+// what is missing.  "scanned" finds each one by scanning the siblings and
+// reading their name attribute (a copy, as IXMLNode::GetAttribute returns
+// an OleVariant); "indexed" goes through a name index of each "nodes" or
+// "values" element, built on its first lookup.  Both remove an erased
+// element at once with IXMLNodeList::Remove, which finds it by a pointer
+// scan of the child list.  "batched" looks up as "indexed" does but
+// leaves the erased elements in place until the end of the flush, then
+// finds their positions in one pass over each child list and deletes
+// them by position, last first, as IXMLNodeList::Delete( Index ) does.
+// Allocation counts come from a counting operator new.
+//---------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+
+} // namespace
+
+void* operator new( std::size_t Size )
+{
+    if ( auto const Block = std::malloc( Size ) ) {
+        ++Allocs;
+        return Block;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    std::free( Ptr );
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    std::free( Ptr );
+}
+
+namespace {
+
+volatile std::size_t Sink;
+
+struct Element {
+    std::wstring Name;
+    std::vector<std::pair<std::wstring,std::wstring>> Attrs;
+    std::vector<std::unique_ptr<Element>> Children;
+    std::wstring Text;
+
+    Element* Add( std::wstring_view Tag ) {
+        Children.push_back( std::make_unique<Element>() );
+        Children.back()->Name = Tag;
+        return Children.back().get();
+    }
+
+    Element* Find( std::wstring_view Tag ) {
+        for ( auto& Child : Children ) {
+            if ( Child->Name == Tag ) { return Child.get(); }
+        }
+        return nullptr;
+    }
+
+    Element* Force( std::wstring_view Tag ) {
+        auto const Found = Find( Tag );
+        return Found ? Found : Add( Tag );
+    }
+
+    // An OleVariant: a copy, empty for a missing attribute.
+    std::wstring Attr( std::wstring_view AttrName ) const {
+        for ( auto const & A : Attrs ) {
+            if ( A.first == AttrName ) { return A.second; }
+        }
+        return {};
+    }
+
+    void Remove( Element const * Child ) {
+        for ( auto It = Children.begin() ; It != Children.end() ; ++It ) {
+            if ( It->get() == Child ) {
+                Children.erase( It );
+                return;
+            }
+        }
+    }
+
+    void Delete( std::size_t Idx ) {
+        Children.erase( Children.begin() + static_cast<std::ptrdiff_t>( Idx ) );
+    }
+};
+
+std::wstring Name( wchar_t Prefix, std::size_t Idx )
+{
+    return Prefix + std::to_wstring( Idx );
+}
+
+std::unique_ptr<Element> MakeDocument( std::size_t Count )
+{
+    auto Config = std::make_unique<Element>();
+    Config->Name = L"config";
+    auto const Values = Config->Add( L"values" );
+    auto const Nodes = Config->Add( L"nodes" );
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Value = Values->Add( L"value" );
+        Value->Attrs = { { L"name", Name( 'v', Idx ) }, { L"type", L"i" } };
+        Value->Text = std::to_wstring( Idx );
+        auto const Node = Nodes->Add( L"node" );
+        Node->Attrs = { { L"name", Name( 'n', Idx ) } };
+        auto const ChildValues = Node->Add( L"values" );
+        for ( auto Key : { L"Left", L"Top", L"Caption" } ) {
+            auto const ChildValue = ChildValues->Add( L"value" );
+            ChildValue->Attrs = { { L"name", Key }, { L"type", L"i" } };
+            ChildValue->Text = L"1";
+        }
+    }
+    return Config;
+}
+
+//---------------------------------------------------------------------------
+
+struct Scanned {
+    Element* Open( Element& Parent, std::wstring_view Tag, std::wstring const & Key ) {
+        for ( auto& Child : Parent.Children ) {
+            if ( Child->Name == Tag && Child->Attr( L"name" ) == Key ) {
+                return Child.get();
+            }
+        }
+        auto const Added = Parent.Add( Tag );
+        Added->Attrs = { { L"name", Key } };
+        return Added;
+    }
+
+    // The last "value", the first "node".
+    void Erase( Element& Parent, std::wstring_view Tag, std::wstring const & Key ) {
+        auto const Count = Parent.Children.size();
+        for ( std::size_t Step = 0 ; Step < Count ; ++Step ) {
+            auto const Idx = Tag == L"value" ? Count - 1 - Step : Step;
+            auto const Child = Parent.Children[Idx].get();
+            if ( Child->Name == Tag && Child->Attr( L"name" ) == Key ) {
+                Parent.Remove( Child );
+                return;
+            }
+        }
+    }
+
+    void Finish() {}
+};
+
+struct Indexed {
+    using Index = std::unordered_map<std::wstring,std::vector<Element*>>;
+
+    std::unordered_map<Element*,Index> Indexes;
+
+    Index& Get( Element& Parent, std::wstring_view Tag ) {
+        auto const Found = Indexes.find( &Parent );
+        if ( Found != Indexes.end() ) {
+            return Found->second;
+        }
+        auto& Result = Indexes[&Parent];
+        for ( auto& Child : Parent.Children ) {
+            if ( Child->Name == Tag ) {
+                Result[Child->Attr( L"name" )].push_back( Child.get() );
+            }
+        }
+        return Result;
+    }
+
+    Element* Open( Element& Parent, std::wstring_view Tag, std::wstring const & Key ) {
+        auto& Matches = Get( Parent, Tag )[Key];
+        if ( Matches.empty() ) {
+            auto const Added = Parent.Add( Tag );
+            Added->Attrs = { { L"name", Key } };
+            Matches.push_back( Added );
+        }
+        return Matches.front();
+    }
+
+    // Takes the erased element out of the index and hands it to Drop.
+    template<typename D>
+    void Erase( Element& Parent, std::wstring_view Tag, std::wstring const & Key, D Drop ) {
+        auto& Children = Get( Parent, Tag );
+        auto const It = Children.find( Key );
+        if ( It != Children.end() ) {
+            auto& Matches = It->second;
+            if ( Tag == L"value" ) {
+                Drop( Matches.back() );
+                Matches.pop_back();
+            }
+            else {
+                Drop( Matches.front() );
+                Matches.erase( Matches.begin() );
+            }
+            if ( Matches.empty() ) { Children.erase( It ); }
+        }
+    }
+
+    void Erase( Element& Parent, std::wstring_view Tag, std::wstring const & Key ) {
+        Erase( Parent, Tag, Key, [&Parent]( Element* Child ) { Parent.Remove( Child ); } );
+    }
+
+    void Finish() {}
+};
+
+struct Batched : Indexed {
+    std::unordered_map<Element*,std::vector<Element*>> Erased;
+
+    void Erase( Element& Parent, std::wstring_view Tag, std::wstring const & Key ) {
+        Indexed::Erase(
+            Parent, Tag, Key,
+            [&]( Element* Child ) { Erased[&Parent].push_back( Child ); }
+        );
+    }
+
+    void Finish() {
+        std::unordered_set<Element const *> Doomed;
+        std::vector<std::size_t> Positions;
+        for ( auto& Entry : Erased ) {
+            auto& Parent = *Entry.first;
+            Doomed.clear();
+            Doomed.insert( Entry.second.begin(), Entry.second.end() );
+            Positions.clear();
+            for ( std::size_t Idx = 0 ; Idx < Parent.Children.size() ; ++Idx ) {
+                if ( Doomed.count( Parent.Children[Idx].get() ) ) {
+                    Positions.push_back( Idx );
+                }
+            }
+            for ( auto It = Positions.rbegin() ; It != Positions.rend() ; ++It ) {
+                Parent.Delete( *It );
+            }
+        }
+        Erased.clear();
+    }
+};
+
+template<typename Writer>
+std::size_t Flush( Element& Config, std::size_t Count, std::size_t Every )
+{
+    Writer W;
+    auto& Values = *Config.Force( L"values" );
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Key = Name( 'v', Idx );
+        if ( Idx % Every == 0 ) {
+            W.Erase( Values, L"value", Key );
+        }
+        else {
+            W.Open( Values, L"value", Key )->Text = L"2";
+        }
+    }
+    auto& Nodes = *Config.Force( L"nodes" );
+    for ( std::size_t Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Key = Name( 'n', Idx );
+        if ( Idx % Every == Every / 2 ) {
+            W.Erase( Nodes, L"node", Key );
+        }
+        else {
+            auto& Node = *W.Open( Nodes, L"node", Key );
+            W.Open( *Node.Force( L"values" ), L"value", L"Left" )->Text = L"2";
+        }
+    }
+    W.Finish();
+    return Values.Children.size() + Nodes.Children.size();
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t Result;     // elements left
+};
+
+template<typename Writer>
+Sample Measure( std::size_t Count, std::size_t Every, int Rounds )
+{
+    Sample Result {};
+    double Us {};
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const Config = MakeDocument( Count );
+        auto const BaseAllocs = Allocs;
+        auto const Start = std::chrono::steady_clock::now();
+        Result.Result = Flush<Writer>( *Config, Count, Every );
+        auto const Stop = std::chrono::steady_clock::now();
+        Result.Allocs = Allocs - BaseAllocs;
+        Us += std::chrono::duration<double,std::micro>( Stop - Start ).count();
+    }
+    Result.Us = Us / Rounds;
+    Sink = Result.Result;
+    return Result;
+}
+
+void Run( std::size_t Count, std::size_t Every, int Rounds )
+{
+    auto const Before = Measure<Scanned>( Count, Every, Rounds );
+    auto const Index = Measure<Indexed>( Count, Every, Rounds );
+    auto const After = Measure<Batched>( Count, Every, Rounds );
+    if ( Before.Result != Index.Result || Before.Result != After.Result ) {
+        std::printf(
+            "mismatch: %zu / %zu / %zu elements\n",
+            Before.Result, Index.Result, After.Result
+        );
+        std::exit( 1 );
+    }
+    std::printf(
+        "%6zu values + %6zu nodes, 1 in %2zu erased | %10.0f / %7.0f / %7.0f us"
+        " | allocs %8zu / %7zu / %7zu\n",
+        Count, Count, Every, Before.Us, Index.Us, After.Us,
+        Before.Allocs, Index.Allocs, After.Allocs
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "XML flush of one wide node, scanned / indexed / batched\n" );
+    Run( 100, 10, 200 );
+    Run( 1000, 10, 20 );
+    Run( 10000, 10, 3 );
+    Run( 10000, 2, 3 );
+    return 0;
+}
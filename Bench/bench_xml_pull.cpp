@@ -0,0 +1,414 @@
+//---------------------------------------------------------------------------
+// Eager XML load benchmark: DOM walk against the pull parser.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_xml_pull.cpp -o bench_xml_pull
+//   ./bench_xml_pull
+//
+// "before" is what XML::TConfig did: read the file as UTF-16 text, search
+// it twice for "<!DOCTYPE" and "<!ENTITY", convert it back to UTF-8, parse
+// it into a document (one heap object per element, attribute and text
+// node, with UTF-16 names and values, as IXMLDocument holds them) and walk
+// it the way ReadRootNode does, each child node found again by a linear
+// FindNodeByNameAndAttrValue scan of its siblings.  The document is built
+// with the same Pull::TReader, so the cost of the DOM parser itself is, if
+// anything, understated.  "after" is XML::TConfig::TStreamLoader: one pass
+// of the reader straight into the tree.  "tree" nodes have ten children
+// each, "wide" ones all hang from the root.  std::wstring stands in for
+// System::String and a std::map of std::variant for the node containers.
+// Allocation counts and the peak of live heap bytes come from a counting
+// operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgXMLPull.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+std::size_t Live;
+std::size_t Peak;
+
+// Every block carries its size in front, so that Release can account for it.
+void* Acquire( std::size_t Size )
+{
+    auto const Block = static_cast<std::size_t*>( std::malloc( Size + 16 ) );
+    if ( !Block ) {
+        throw std::bad_alloc{};
+    }
+    *Block = Size;
+    ++Allocs;
+    Live += Size;
+    if ( Live > Peak ) { Peak = Live; }
+    return reinterpret_cast<char*>( Block ) + 16;
+}
+
+void Release( void* Ptr ) noexcept
+{
+    if ( Ptr ) {
+        auto const Block = reinterpret_cast<std::size_t*>( static_cast<char*>( Ptr ) - 16 );
+        Live -= *Block;
+        std::free( Block );
+    }
+}
+
+} // namespace
+
+// Every form of new and delete goes through the same pair, so a block is
+// always released by the counterpart of the function that allocated it.
+void* operator new( std::size_t Size ) { return Acquire( Size ); }
+void* operator new[]( std::size_t Size ) { return Acquire( Size ); }
+void operator delete( void* Ptr ) noexcept { Release( Ptr ); }
+void operator delete[]( void* Ptr ) noexcept { Release( Ptr ); }
+void operator delete( void* Ptr, std::size_t ) noexcept { Release( Ptr ); }
+void operator delete[]( void* Ptr, std::size_t ) noexcept { Release( Ptr ); }
+
+namespace {
+
+namespace Pull = Anafestica::XML::Pull;
+
+using Value = std::variant<int,bool,std::wstring>;
+
+struct Node {
+    std::map<std::wstring,Value> Values;
+    std::map<std::wstring,std::unique_ptr<Node>> Nodes;
+};
+
+volatile std::size_t Sink;
+
+// The samples are ASCII, as most configurations are.
+std::wstring Widen( std::string_view Text )
+{
+    return std::wstring( Text.begin(), Text.end() );
+}
+
+std::string Narrow( std::wstring_view Text )
+{
+    return std::string( Text.begin(), Text.end() );
+}
+
+Value Decode( std::wstring_view Type, std::wstring Text )
+{
+    if ( Type == L"i" ) { return static_cast<int>( std::wcstol( Text.c_str(), nullptr, 10 ) ); }
+    if ( Type == L"b" ) { return Text == L"true"; }
+    return Text;
+}
+
+void AddNode( std::string& Out, int Id, int Children, int Levels, std::size_t& Count )
+{
+    auto const Name = std::to_string( Id );
+    Out += "<node name=\"Node" + Name + "\"><values>";
+    Out += "<value name=\"Left\" type=\"i\">" + Name + "</value>";
+    Out += "<value name=\"Visible\" type=\"b\">true</value>";
+    Out += "<value name=\"Caption\" type=\"sz\">Form &amp; caption " + Name + "</value>";
+    Out += "</values>";
+    ++Count;
+    if ( Levels > 1 ) {
+        Out += "<nodes>";
+        for ( int Idx = 0 ; Idx < Children ; ++Idx ) {
+            AddNode( Out, Idx, Children, Levels - 1, Count );
+        }
+        Out += "</nodes>";
+    }
+    Out += "</node>";
+}
+
+// Levels of nodes with Children children each under the root.
+std::string MakeFile( int Children, int Levels, std::size_t& Count )
+{
+    std::string Out =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<application><config><nodes>";
+    Count = 0;
+    for ( int Idx = 0 ; Idx < Children ; ++Idx ) {
+        AddNode( Out, Idx, Children, Levels, Count );
+    }
+    Out += "</nodes></config></application>\n";
+    return Out;
+}
+
+//---------------------------------------------------------------------------
+// before
+
+struct DomNode {
+    std::wstring Name;
+    std::vector<std::pair<std::wstring,std::wstring>> Attrs;
+    std::vector<std::unique_ptr<DomNode>> Children;
+    std::wstring Text;
+
+    DomNode const * Find( std::wstring_view Tag ) const {
+        for ( auto const & Child : Children ) {
+            if ( Child->Name == Tag ) { return Child.get(); }
+        }
+        return nullptr;
+    }
+
+    std::wstring const * Attr( std::wstring_view AttrName ) const {
+        for ( auto const & A : Attrs ) {
+            if ( A.first == AttrName ) { return &A.second; }
+        }
+        return nullptr;
+    }
+};
+
+std::unique_ptr<DomNode> Parse( std::string const & Text )
+{
+    Pull::TReader Reader{ Text.data(), Text.data() + Text.size() };
+    std::unique_ptr<DomNode> Root;
+    std::vector<DomNode*> Path;
+    for ( ;; ) {
+        switch ( Reader.Next() ) {
+            case Pull::TToken::StartElement: {
+                auto Element = std::make_unique<DomNode>();
+                Element->Name = Widen( Reader.GetName() );
+                for ( auto AttrName : { "name", "type" } ) {
+                    if ( auto const Val = Reader.GetAttribute( AttrName ) ) {
+                        Element->Attrs.emplace_back( Widen( AttrName ), Widen( *Val ) );
+                    }
+                }
+                auto const Raw = Element.get();
+                if ( Path.empty() ) { Root = std::move( Element ); }
+                else { Path.back()->Children.push_back( std::move( Element ) ); }
+                Path.push_back( Raw );
+                break;
+            }
+            case Pull::TToken::EndElement:
+                Path.pop_back();
+                break;
+            case Pull::TToken::Text: {
+                auto Text = std::make_unique<DomNode>();
+                Text->Name = L"#text";
+                Text->Text = Widen( Reader.GetText() );
+                Path.back()->Children.push_back( std::move( Text ) );
+                break;
+            }
+            case Pull::TToken::End:
+                return Root;
+            case Pull::TToken::Error:
+                std::printf( "parse error: %s\n", Reader.GetError() );
+                std::exit( 1 );
+            default:
+                break;
+        }
+    }
+}
+
+DomNode const * FindNodeByNameAndAttrValue( DomNode const & Nodes, std::wstring const & Name )
+{
+    for ( auto const & Child : Nodes.Children ) {
+        if ( Child->Name == L"node" ) {
+            if ( auto const Attr = Child->Attr( L"name" ) ) {
+                if ( *Attr == Name ) { return Child.get(); }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void Walk( DomNode const & Element, Node& Into )
+{
+    if ( auto const Values = Element.Find( L"values" ) ) {
+        for ( auto const & Child : Values->Children ) {
+            if ( Child->Name == L"value" ) {
+                auto const Name = Child->Attr( L"name" );
+                auto const Type = Child->Attr( L"type" );
+                if ( Name && Type ) {
+                    auto Text = Child->Children.empty() ? std::wstring{} : Child->Children[0]->Text;
+                    Into.Values[*Name] = Decode( *Type, std::move( Text ) );
+                }
+            }
+        }
+    }
+    if ( auto const Nodes = Element.Find( L"nodes" ) ) {
+        // DoCreateNodeList, then a lookup per child to read it.
+        for ( auto const & Child : Nodes->Children ) {
+            if ( Child->Name == L"node" ) {
+                if ( auto const Attr = Child->Attr( L"name" ) ) {
+                    Into.Nodes[*Attr] = std::make_unique<Node>();
+                }
+            }
+        }
+        for ( auto& Child : Into.Nodes ) {
+            if ( auto const Found = FindNodeByNameAndAttrValue( *Nodes, Child.first ) ) {
+                Walk( *Found, *Child.second );
+            }
+        }
+    }
+}
+
+std::unique_ptr<Node> LoadBefore( std::string const & File )
+{
+    auto const Text = Widen( File );
+    if ( Text.find( L"<!DOCTYPE" ) != std::wstring::npos ||
+         Text.find( L"<!ENTITY" ) != std::wstring::npos )
+    {
+        std::exit( 1 );
+    }
+    auto const Dom = Parse( Narrow( Text ) );
+    auto Root = std::make_unique<Node>();
+    if ( auto const Config = Dom->Find( L"config" ) ) {
+        Walk( *Config, *Root );
+    }
+    return Root;
+}
+
+//---------------------------------------------------------------------------
+// after
+
+class Loader {
+public:
+    explicit Loader( std::string const & File )
+        : reader_{ File.data(), File.data() + File.size() } {}
+
+    std::unique_ptr<Node> Load() {
+        auto Root = std::make_unique<Node>();
+        Next();
+        for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+            if ( Token == Pull::TToken::StartElement ) {
+                if ( reader_.GetName() == "config" ) { ReadNode( *Root ); }
+                else { reader_.Skip(); }
+            }
+        }
+        while ( Next() != Pull::TToken::End ) {}
+        return Root;
+    }
+private:
+    Pull::TReader reader_;
+
+    Pull::TToken Next() {
+        auto const Token = reader_.Next();
+        if ( Token == Pull::TToken::Error ) {
+            std::printf( "parse error: %s\n", reader_.GetError() );
+            std::exit( 1 );
+        }
+        return Token;
+    }
+
+    void ReadNode( Node& Into ) {
+        for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+            if ( Token != Pull::TToken::StartElement ) { continue; }
+            if ( reader_.GetName() == "values" ) { ReadValues( Into ); }
+            else if ( reader_.GetName() == "nodes" ) { ReadNodes( Into ); }
+            else { reader_.Skip(); }
+        }
+    }
+
+    void ReadNodes( Node& Into ) {
+        for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+            if ( Token != Pull::TToken::StartElement ) { continue; }
+            if ( reader_.GetName() == "node" ) {
+                if ( auto const Attr = reader_.GetAttribute( "name" ) ) {
+                    auto Child = std::make_unique<Node>();
+                    auto Name = Widen( *Attr );
+                    ReadNode( *Child );
+                    Into.Nodes.try_emplace( std::move( Name ), std::move( Child ) );
+                    continue;
+                }
+            }
+            reader_.Skip();
+        }
+    }
+
+    void ReadValues( Node& Into ) {
+        for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+            if ( Token != Pull::TToken::StartElement ) { continue; }
+            auto const Name = reader_.GetAttribute( "name" );
+            auto const Type = reader_.GetAttribute( "type" );
+            if ( reader_.GetName() == "value" && Name && Type ) {
+                auto Key = Widen( *Name );
+                auto const TypeName = Widen( *Type );
+                std::wstring Text;
+                while ( Next() != Pull::TToken::EndElement ) {
+                    Text = Widen( reader_.GetText() );
+                }
+                Into.Values[std::move( Key )] = Decode( TypeName, std::move( Text ) );
+                continue;
+            }
+            reader_.Skip();
+        }
+    }
+};
+
+std::unique_ptr<Node> LoadAfter( std::string const & File )
+{
+    return Loader{ File }.Load();
+}
+
+//---------------------------------------------------------------------------
+
+std::size_t CountValues( Node const & N )
+{
+    auto Count = N.Values.size();
+    for ( auto const & Child : N.Nodes ) { Count += CountValues( *Child.second ); }
+    return Count;
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t PeakBytes;
+    std::size_t Result;     // values loaded
+};
+
+template<typename F>
+Sample Measure( std::string const & File, int Rounds, F&& Run )
+{
+    Sample Result {};
+    auto const Start = std::chrono::steady_clock::now();
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const BaseLive = Live;
+        Peak = Live;
+        Result.Result = CountValues( *Run( File ) );
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.PeakBytes = Peak - BaseLive;
+    }
+    auto const Stop = std::chrono::steady_clock::now();
+    Result.Us = std::chrono::duration<double,std::micro>( Stop - Start ).count() / Rounds;
+    Sink = Result.Result;
+    return Result;
+}
+
+void Run( char const * What, int Children, int Levels, int Rounds )
+{
+    std::size_t Count;
+    auto const File = MakeFile( Children, Levels, Count );
+    auto const Before = Measure( File, Rounds, &LoadBefore );
+    auto const After = Measure( File, Rounds, &LoadAfter );
+    if ( Before.Result != After.Result || After.Result != Count * 3 ) {
+        std::printf( "mismatch: %zu / %zu values\n", Before.Result, After.Result );
+        std::exit( 1 );
+    }
+    std::printf(
+        "%-5s %6zu nodes %6zu KiB | %9.0f / %7.0f us"
+        " | allocs %7zu / %7zu | peak %6zu / %6zu KiB\n",
+        What, Count, File.size() / 1024, Before.Us, After.Us,
+        Before.Allocs, After.Allocs,
+        Before.PeakBytes / 1024, After.PeakBytes / 1024
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "eager XML load, before / after\n" );
+    Run( "tree", 10, 2, 200 );
+    Run( "tree", 10, 3, 20 );
+    Run( "tree", 10, 4, 3 );
+    Run( "wide", 1000, 1, 20 );
+    Run( "wide", 10000, 1, 3 );
+    return 0;
+}
@@ -0,0 +1,573 @@
+//---------------------------------------------------------------------------
+// YAML flush benchmark: configuration tree -> file text.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_yaml_flush.cpp -o bench_yaml_flush
+//   ./bench_yaml_flush
+//
+// "before" is what YAML::TConfig::DoFlush did: build a document from the
+// tree (one heap node per scalar and collection, mappings ordered by key,
+// as fkYAML's are; ForcePath finds or adds each mapping on the way with a
+// contains() and an operator[]), serialize it to a string, copy that into
+// the byte vector handed to the file, and write the file.  "after" is the
+// backend's stream writer: the tree is walked once and the text laid out
+// by TTextWriter straight into a 64 KiB TBufferedSink.  The serialization
+// of "before" uses TTextWriter as well, so the gap is the document and the
+// copies.  The file is a writer that only counts bytes; both outputs are
+// read back with YAML::Sax::Parse and must give the tree flushed.
+// std::wstring stands in for System::String and a std::map of std::variant
+// for the node containers.  Allocation counts and the peak of live heap
+// bytes come from a counting operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgYAMLWriter.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+std::size_t Live;
+std::size_t Peak;
+
+} // namespace
+
+// Every block carries its size in front, so that delete can account for it.
+void* operator new( std::size_t Size )
+{
+    auto const Block = static_cast<std::size_t*>( std::malloc( Size + 16 ) );
+    if ( !Block ) {
+        throw std::bad_alloc{};
+    }
+    *Block = Size;
+    ++Allocs;
+    Live += Size;
+    if ( Live > Peak ) { Peak = Live; }
+    return reinterpret_cast<char*>( Block ) + 16;
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    if ( Ptr ) {
+        auto const Block = reinterpret_cast<std::size_t*>( static_cast<char*>( Ptr ) - 16 );
+        Live -= *Block;
+        std::free( Block );
+    }
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    operator delete( Ptr );
+}
+
+namespace {
+
+using namespace Anafestica::YAML;
+
+using Value = std::variant<int,bool,double,long long,std::wstring,std::vector<std::wstring>>;
+
+struct Node {
+    std::map<std::wstring,Value> Values;
+    std::map<std::wstring,std::unique_ptr<Node>> Nodes;
+};
+
+volatile std::size_t Sink;
+
+// Latin-1 only, which is all the tree holds.
+std::string Narrow( std::wstring const & Text )
+{
+    std::string Result;
+    for ( auto Ch : Text ) {
+        if ( Ch < 0x80 ) {
+            Result += static_cast<char>( Ch );
+        }
+        else {
+            Result += static_cast<char>( 0xC0 | ( Ch >> 6 ) );
+            Result += static_cast<char>( 0x80 | ( Ch & 0x3F ) );
+        }
+    }
+    return Result;
+}
+
+// Count nodes, three levels deep, each holding a mix of implicit and
+// tagged values.
+std::unique_ptr<Node> MakeTree( std::size_t Count )
+{
+    auto Root = std::make_unique<Node>();
+    std::size_t Made {};
+    auto AddNode = [&]( auto& Self, Node& Into, std::size_t Level ) -> void {
+        auto const Id = std::to_wstring( Made++ );
+        Into.Values[L"Left"] = static_cast<int>( Made );
+        Into.Values[L"Top"] = 120;
+        Into.Values[L"Width"] = 640;
+        Into.Values[L"Height"] = 480;
+        Into.Values[L"Caption"] = L"Window \xE9 " + Id;
+        Into.Values[L"Visible"] = true;
+        Into.Values[L"Ratio"] = 0.75;
+        Into.Values[L"Stamp"] = 1700000000000LL;
+        Into.Values[L"Recent"] = std::vector<std::wstring>{ L"a.txt", L"b: c.txt", L"" };
+        for ( int Idx = 0 ; Level < 2 && Idx < 3 && Made < Count ; ++Idx ) {
+            auto& Child = Into.Nodes[L"Child" + std::to_wstring( Idx )];
+            Child = std::make_unique<Node>();
+            Self( Self, *Child, Level + 1 );
+        }
+    };
+    for ( std::size_t Idx {} ; Made < Count ; ++Idx ) {
+        auto& Form = Root->Nodes[L"Form" + std::to_wstring( Idx )];
+        Form = std::make_unique<Node>();
+        AddNode( AddNode, *Form, 0 );
+    }
+    return Root;
+}
+
+std::string Number( double Val )
+{
+    char Buf[64];
+    std::snprintf( Buf, sizeof Buf, "%.*g", 17, Val );
+    return Buf;
+}
+
+struct CountingWriter {
+    std::size_t Bytes {};
+
+    void Write( char const *, std::size_t Length ) { Bytes += Length; }
+};
+
+//---------------------------------------------------------------------------
+// before: document, serialize, copy
+
+struct Yaml {
+    enum Kind { Mapping, Sequence, Scalar } Type;
+    bool Quoted {};
+    std::string Text;
+    std::map<std::string,std::unique_ptr<Yaml>> Members;
+    std::vector<std::unique_ptr<Yaml>> Items;
+
+    static std::unique_ptr<Yaml> Make( Kind Type, std::string Text = {}, bool Quoted = false ) {
+        auto Item = std::make_unique<Yaml>();
+        Item->Type = Type;
+        Item->Text = std::move( Text );
+        Item->Quoted = Quoted;
+        return Item;
+    }
+
+    bool contains( std::string const & Key ) const {
+        return Members.find( Key ) != Members.end();
+    }
+
+    Yaml& operator[]( std::string const & Key ) {
+        auto& Member = Members[Key];
+        if ( !Member ) {
+            Member = Make( Mapping );
+        }
+        return *Member;
+    }
+};
+
+Yaml& ForceChild( Yaml& Cur, std::wstring const & Name )
+{
+    if ( !Cur.contains( "nodes" ) ) {
+        Cur.Members["nodes"] = Yaml::Make( Yaml::Mapping );
+    }
+    auto& Inner = Cur["nodes"];
+    auto const Key = Narrow( Name );
+    if ( !Inner.contains( Key ) ) {
+        Inner.Members[Key] = Yaml::Make( Yaml::Mapping );
+    }
+    return Inner[Key];
+}
+
+std::unique_ptr<Yaml> Tagged( char const * Tag, std::unique_ptr<Yaml> Inner )
+{
+    auto Wrapper = Yaml::Make( Yaml::Mapping );
+    Wrapper->Members[Tag] = std::move( Inner );
+    return Wrapper;
+}
+
+std::unique_ptr<Yaml> Encode( Value const & Val )
+{
+    switch ( Val.index() ) {
+        case 0: return Yaml::Make( Yaml::Scalar, std::to_string( std::get<int>( Val ) ) );
+        case 1: return Yaml::Make( Yaml::Scalar, std::get<bool>( Val ) ? "true" : "false" );
+        case 2:
+            return Tagged( "dbl", Yaml::Make( Yaml::Scalar, Number( std::get<double>( Val ) ), true ) );
+        case 3:
+            return Tagged( "ll", Yaml::Make( Yaml::Scalar, std::to_string( std::get<long long>( Val ) ) ) );
+        case 4: return Yaml::Make( Yaml::Scalar, Narrow( std::get<std::wstring>( Val ) ), true );
+        default: {
+            auto Seq = Yaml::Make( Yaml::Sequence );
+            for ( auto const & Item : std::get<std::vector<std::wstring>>( Val ) ) {
+                Seq->Items.push_back( Yaml::Make( Yaml::Scalar, Narrow( Item ), true ) );
+            }
+            return Tagged( "sv", std::move( Seq ) );
+        }
+    }
+}
+
+// DoSaveValueList: ForceValues, then one member per value.
+void Build( Node const & From, Yaml& Cur )
+{
+    if ( !From.Values.empty() ) {
+        auto& Values = Cur["values"];
+        for ( auto const & Member : From.Values ) {
+            Values.Members[Narrow( Member.first )] = Encode( Member.second );
+        }
+    }
+    for ( auto const & Child : From.Nodes ) {
+        Build( *Child.second, ForceChild( Cur, Child.first ) );
+    }
+}
+
+template<typename S>
+void Serialize( Yaml const & Map, std::size_t Depth, TTextWriter<S>& Out )
+{
+    for ( auto const & Member : Map.Members ) {
+        Out.Key( Depth, Member.first );
+        auto const & Val = *Member.second;
+        if ( Val.Type == Yaml::Scalar ) {
+            if ( Val.Quoted ) { Out.String( Val.Text ); }
+            else { Out.Token( Val.Text ); }
+        }
+        else if ( Val.Type == Yaml::Mapping ) {
+            Out.Block();
+            Serialize( Val, Depth + 1, Out );
+        }
+        else if ( Val.Items.empty() ) {
+            Out.Token( "[]" );
+        }
+        else {
+            Out.Block();
+            for ( auto const & Item : Val.Items ) {
+                Out.Item( Depth + 1, Item->Text );
+            }
+        }
+    }
+}
+
+std::size_t FlushDom( Node const & Root, std::string* Text )
+{
+    auto Doc = Yaml::Make( Yaml::Mapping );
+    Build( Root, *Doc );
+    std::string Yaml;
+    TMemorySink<> Memory{ Yaml };
+    TTextWriter<TMemorySink<>> Writer{ Memory };
+    Serialize( *Doc, 0, Writer );
+    std::vector<unsigned char> Bytes( Yaml.begin(), Yaml.end() );
+    CountingWriter File;
+    File.Write( reinterpret_cast<char const *>( Bytes.data() ), Bytes.size() );
+    if ( Text ) { *Text = Yaml; }
+    return File.Bytes;
+}
+
+//---------------------------------------------------------------------------
+// after: straight into the buffered file
+
+template<typename S>
+class StreamWriter {
+public:
+    explicit StreamWriter( S& Sink ) : out_{ Sink } {}
+
+    void Write( Node const & From ) {
+        if ( !From.Values.empty() ) {
+            Open();
+            auto const Depth = 2 * ( frames_.size() - 1 );
+            out_.Key( Depth, "values" );
+            out_.Block();
+            for ( auto const & Member : From.Values ) {
+                out_.Key( Depth + 1, Utf8( Member.first ) );
+                Encode( Member.second, Depth + 1 );
+            }
+        }
+        for ( auto const & Child : From.Nodes ) {
+            frames_.push_back( Frame{ &Child.first } );
+            Write( *Child.second );
+            frames_.pop_back();
+        }
+    }
+private:
+    struct Frame {
+        std::wstring const * Name;
+        bool Written {};
+        bool NodesWritten {};
+    };
+
+    TTextWriter<S> out_;
+    std::vector<Frame> frames_ { Frame{ nullptr, true } };
+    std::string text_;
+
+    std::string_view Utf8( std::wstring const & Text ) {
+        text_.clear();
+        for ( auto Ch : Text ) {
+            if ( Ch < 0x80 ) {
+                text_ += static_cast<char>( Ch );
+            }
+            else {
+                text_ += static_cast<char>( 0xC0 | ( Ch >> 6 ) );
+                text_ += static_cast<char>( 0x80 | ( Ch & 0x3F ) );
+            }
+        }
+        return text_;
+    }
+
+    void Open() {
+        auto First = frames_.size();
+        while ( !frames_[First - 1].Written ) {
+            --First;
+        }
+        for ( auto Idx = First ; Idx < frames_.size() ; ++Idx ) {
+            auto& Parent = frames_[Idx - 1];
+            if ( !Parent.NodesWritten ) {
+                out_.Key( 2 * ( Idx - 1 ), "nodes" );
+                out_.Block();
+                Parent.NodesWritten = true;
+            }
+            out_.Key( 2 * Idx - 1, Utf8( *frames_[Idx].Name ) );
+            out_.Block();
+            frames_[Idx].Written = true;
+        }
+    }
+
+    void Tag( std::size_t Depth, char const * Name ) {
+        out_.Block();
+        out_.Key( Depth + 1, Name );
+    }
+
+    void Encode( Value const & Val, std::size_t Depth ) {
+        char Buf[64];
+        switch ( Val.index() ) {
+            case 0:
+                std::snprintf( Buf, sizeof Buf, "%d", std::get<int>( Val ) );
+                out_.Token( Buf );
+                break;
+            case 1:
+                out_.Token( std::get<bool>( Val ) ? "true" : "false" );
+                break;
+            case 2:
+                std::snprintf( Buf, sizeof Buf, "%.*g", 17, std::get<double>( Val ) );
+                Tag( Depth, "dbl" );
+                out_.String( Buf );
+                break;
+            case 3:
+                std::snprintf( Buf, sizeof Buf, "%lld", std::get<long long>( Val ) );
+                Tag( Depth, "ll" );
+                out_.Token( Buf );
+                break;
+            case 4:
+                out_.String( Utf8( std::get<std::wstring>( Val ) ) );
+                break;
+            default: {
+                auto const & Items = std::get<std::vector<std::wstring>>( Val );
+                Tag( Depth, "sv" );
+                if ( Items.empty() ) {
+                    out_.Token( "[]" );
+                    break;
+                }
+                out_.Block();
+                for ( auto const & Item : Items ) {
+                    out_.Item( Depth + 2, Utf8( Item ) );
+                }
+                break;
+            }
+        }
+    }
+};
+
+template<typename S>
+void Render( Node const & Root, S& Sink )
+{
+    StreamWriter<S> Writer{ Sink };
+    Writer.Write( Root );
+}
+
+std::size_t FlushStream( Node const & Root, std::string* Text )
+{
+    if ( Text ) {
+        TMemorySink<> Memory{ *Text };
+        Render( Root, Memory );
+    }
+    CountingWriter File;
+    TBufferedSink<CountingWriter> Buffer{ File };
+    Render( Root, Buffer );
+    Buffer.Flush();
+    return File.Bytes;
+}
+
+//---------------------------------------------------------------------------
+// check: the text read back
+
+class TreeBuilder {
+public:
+    Node Root;
+
+    bool StartMapping() {
+        if ( states_.empty() ) {
+            nodes_.push_back( &Root );
+            states_.push_back( InNode );
+            return true;
+        }
+        switch ( states_.back() ) {
+            case InNode: states_.push_back( member_ ); return true;
+            case InValues: strings_.clear(); states_.push_back( InWrapper ); return true;
+            case InNodes: {
+                auto& Child = nodes_.back()->Nodes[name_];
+                Child = std::make_unique<Node>();
+                nodes_.push_back( Child.get() );
+                states_.push_back( InNode );
+                return true;
+            }
+            default: return false;
+        }
+    }
+
+    bool Key( std::string_view Name, Anafestica::YAML::Sax::TKind ) {
+        switch ( states_.back() ) {
+            case InNode: member_ = Name == "values" ? InValues : InNodes; return true;
+            case InWrapper: tag_ = Name; return true;
+            default: name_ = Decode( Name ); return true;
+        }
+    }
+
+    void EndMapping() {
+        auto const State = states_.back();
+        states_.pop_back();
+        if ( State == InWrapper ) {
+            auto& Val = nodes_.back()->Values[name_];
+            if ( tag_ == "dbl" ) { Val = std::strtod( text_.c_str(), nullptr ); }
+            else if ( tag_ == "ll" ) { Val = std::strtoll( text_.c_str(), nullptr, 10 ); }
+            else { Val = std::move( strings_ ); }
+        }
+        else if ( State == InNode ) {
+            nodes_.pop_back();
+        }
+    }
+
+    bool StartSequence() { states_.push_back( InSequence ); return true; }
+
+    void EndSequence() { states_.pop_back(); }
+
+    void Scalar( std::string_view Text, Anafestica::YAML::Sax::TKind Kind ) {
+        using Anafestica::YAML::Sax::TKind;
+        switch ( states_.back() ) {
+            case InValues:
+                if ( Kind == TKind::Int ) { nodes_.back()->Values[name_] = std::atoi( std::string( Text ).c_str() ); }
+                else if ( Kind == TKind::Bool ) { nodes_.back()->Values[name_] = Text == "true"; }
+                else { nodes_.back()->Values[name_] = Decode( Text ); }
+                break;
+            case InWrapper: text_ = Text; break;
+            case InSequence: strings_.push_back( Decode( Text ) ); break;
+            default: break;
+        }
+    }
+private:
+    enum State { InNode, InValues, InNodes, InWrapper, InSequence };
+
+    std::vector<Node*> nodes_;
+    std::vector<State> states_;
+    State member_ { InValues };
+    std::wstring name_;
+    std::string tag_;
+    std::string text_;
+    std::vector<std::wstring> strings_;
+
+    static std::wstring Decode( std::string_view Text ) {
+        std::wstring Result;
+        for ( std::size_t Idx = 0 ; Idx < Text.size() ; ++Idx ) {
+            auto const Ch = static_cast<unsigned char>( Text[Idx] );
+            if ( Ch < 0x80 ) {
+                Result += Ch;
+            }
+            else {
+                Result += static_cast<wchar_t>( ( ( Ch & 0x1F ) << 6 ) | ( Text[++Idx] & 0x3F ) );
+            }
+        }
+        return Result;
+    }
+};
+
+bool Same( Node const & Lhs, Node const & Rhs )
+{
+    if ( Lhs.Values != Rhs.Values || Lhs.Nodes.size() != Rhs.Nodes.size() ) {
+        return false;
+    }
+    auto It = Rhs.Nodes.begin();
+    for ( auto const & Child : Lhs.Nodes ) {
+        if ( Child.first != It->first || !Same( *Child.second, *It->second ) ) {
+            return false;
+        }
+        ++It;
+    }
+    return true;
+}
+
+bool ReadsBack( Node const & Root, std::string const & Text )
+{
+    TreeBuilder Builder;
+    return Anafestica::YAML::Sax::Parse( Text.data(), Text.data() + Text.size(), Builder ) &&
+           Same( Root, Builder.Root );
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t PeakBytes;
+};
+
+template<typename F>
+Sample Measure( Node const & Root, int Rounds, F&& Flush )
+{
+    Sample Result {};
+    auto const Start = std::chrono::steady_clock::now();
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const BaseLive = Live;
+        Peak = Live;
+        Sink = Flush( Root, nullptr );
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.PeakBytes = Peak - BaseLive;
+    }
+    auto const Stop = std::chrono::steady_clock::now();
+    Result.Us = std::chrono::duration<double,std::micro>( Stop - Start ).count() / Rounds;
+    return Result;
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const Root = MakeTree( Count );
+    std::string Dom;
+    std::string Stream;
+    FlushDom( *Root, &Dom );
+    FlushStream( *Root, &Stream );
+    if ( !ReadsBack( *Root, Dom ) || !ReadsBack( *Root, Stream ) ) {
+        std::printf( "mismatch at %zu nodes\n", Count );
+        std::exit( 1 );
+    }
+    auto const Before = Measure( *Root, Rounds, &FlushDom );
+    auto const After = Measure( *Root, Rounds, &FlushStream );
+    std::printf(
+        "%6zu nodes %8zu KiB | %9.0f / %9.0f us | allocs %8zu / %8zu | peak %7zu / %7zu KiB\n",
+        Count, Stream.size() / 1024, Before.Us, After.Us, Before.Allocs, After.Allocs,
+        Before.PeakBytes / 1024, After.PeakBytes / 1024
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "YAML flush, document + serialize + copy / stream\n" );
+    Run( 100, 200 );
+    Run( 1000, 20 );
+    Run( 10000, 3 );
+    return 0;
+}
@@ -0,0 +1,445 @@
+//---------------------------------------------------------------------------
+// Eager YAML load benchmark: file text -> configuration tree.
+//
+// Portable (std-only) so it runs on any C++17 compiler, e.g.:
+//
+//   g++ -std=c++17 -O2 -I. Bench/bench_yaml_sax.cpp -o bench_yaml_sax
+//   ./bench_yaml_sax
+//
+// "before" is what YAML::TConfig did: deserialize the whole file into a
+// document (one heap node per scalar and collection, mappings ordered by
+// key, as fkYAML's are), then read it node by node: for each node the
+// path is converted back to UTF-8 and "nodes", "values" and the child are
+// found with a contains() followed by an operator[], as OpenPath and
+// OpenSection do.  "after" is YAML::Sax::Parse feeding the tree directly,
+// as the backend's stream loader does.  Both use the same parser, so the
+// gap is the document and its walk.  std::wstring stands in for
+// System::String and a std::map of std::variant for the node containers.
+// Allocation counts and the peak of live heap bytes come from a counting
+// operator new.
+//---------------------------------------------------------------------------
+
+#include <anafestica/CfgYAMLSax.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+std::size_t Allocs;
+std::size_t Live;
+std::size_t Peak;
+
+// Every block carries its size in front, so that Release can account for it.
+void* Acquire( std::size_t Size )
+{
+    auto const Block = static_cast<std::size_t*>( std::malloc( Size + 16 ) );
+    if ( !Block ) {
+        throw std::bad_alloc{};
+    }
+    *Block = Size;
+    ++Allocs;
+    Live += Size;
+    if ( Live > Peak ) { Peak = Live; }
+    return reinterpret_cast<char*>( Block ) + 16;
+}
+
+void Release( void* Ptr ) noexcept
+{
+    if ( Ptr ) {
+        auto const Block = reinterpret_cast<std::size_t*>( static_cast<char*>( Ptr ) - 16 );
+        Live -= *Block;
+        std::free( Block );
+    }
+}
+
+} // namespace
+
+// Every form of new and delete goes through the same pair, so a block is
+// always released by the counterpart of the function that allocated it.
+void* operator new( std::size_t Size ) { return Acquire( Size ); }
+void* operator new[]( std::size_t Size ) { return Acquire( Size ); }
+void operator delete( void* Ptr ) noexcept { Release( Ptr ); }
+void operator delete[]( void* Ptr ) noexcept { Release( Ptr ); }
+void operator delete( void* Ptr, std::size_t ) noexcept { Release( Ptr ); }
+void operator delete[]( void* Ptr, std::size_t ) noexcept { Release( Ptr ); }
+
+namespace {
+
+namespace Sax = Anafestica::YAML::Sax;
+
+using Value = std::variant<int,bool,double,long long,std::wstring,std::vector<std::wstring>>;
+
+struct Node {
+    std::map<std::wstring,Value> Values;
+    std::map<std::wstring,std::unique_ptr<Node>> Nodes;
+};
+
+volatile std::size_t Sink;
+
+std::wstring Widen( std::string_view Text )
+{
+    return std::wstring( Text.begin(), Text.end() );
+}
+
+std::string Narrow( std::wstring const & Text )
+{
+    return std::string( Text.begin(), Text.end() );
+}
+
+// Synthetic configuration, laid out as the backend writes it: Count
+// nodes, three levels deep, each holding a mix of implicit and tagged
+// values.
+std::string MakeDocument( std::size_t Count )
+{
+    std::string Doc;
+    std::size_t Made {};
+    auto AddNode = [&]( auto& Self, std::string const & Indent, std::size_t Level ) -> void {
+        auto const Id = std::to_string( Made++ );
+        auto const In = Indent + "  ";
+        auto const In2 = In + "  ";
+        Doc += In + "values:\n";
+        Doc += In2 + "Left: " + Id + "\n";
+        Doc += In2 + "Top: 120\n" + In2 + "Width: 640\n" + In2 + "Height: 480\n";
+        Doc += In2 + "Caption: Window \xC3\xA9 " + Id + "\n";
+        Doc += In2 + "Visible: true\n";
+        Doc += In2 + "Ratio:\n" + In2 + "  dbl: \"0.75\"\n";
+        Doc += In2 + "Stamp:\n" + In2 + "  ll: 1700000000000\n";
+        Doc += In2 + "Recent:\n" + In2 + "  sv:\n";
+        Doc += In2 + "    - a.txt\n" + In2 + "    - b.txt\n" + In2 + "    - c.txt\n";
+        if ( Level < 2 && Made < Count ) {
+            Doc += In + "nodes:\n";
+            for ( int Idx = 0 ; Idx < 3 && Made < Count ; ++Idx ) {
+                Doc += In2 + "Child" + std::to_string( Idx ) + ":\n";
+                Self( Self, In2, Level + 1 );
+            }
+        }
+    };
+    Doc += "nodes:\n";
+    for ( std::size_t Idx {} ; Made < Count ; ++Idx ) {
+        Doc += "  Form" + std::to_string( Idx ) + ":\n";
+        AddNode( AddNode, "  ", 0 );
+    }
+    return Doc;
+}
+
+Value DecodeTagged( std::string_view Tag, std::string_view Text,
+                    std::vector<std::wstring>&& Strings )
+{
+    if ( Tag == "dbl" ) { return std::strtod( std::string( Text ).c_str(), nullptr ); }
+    if ( Tag == "ll" ) { return std::strtoll( std::string( Text ).c_str(), nullptr, 10 ); }
+    return std::move( Strings );
+}
+
+//---------------------------------------------------------------------------
+// before: document, then walk
+
+struct Yaml {
+    enum Kind { Mapping, Sequence, Scalar } Type;
+    Sax::TKind Resolved;
+    std::string Text;
+    std::map<std::string,std::unique_ptr<Yaml>> Members;
+    std::vector<std::unique_ptr<Yaml>> Items;
+
+    bool contains( std::string const & Key ) const {
+        return Members.find( Key ) != Members.end();
+    }
+
+    Yaml& operator[]( std::string const & Key ) {
+        return *Members.find( Key )->second;
+    }
+};
+
+class DomBuilder {
+public:
+    std::unique_ptr<Yaml> Root;
+
+    bool StartMapping() { Push( Yaml::Mapping ); return true; }
+    bool Key( std::string_view Name, Sax::TKind ) {
+        key_ = Name;
+        return true;
+    }
+    void EndMapping() { stack_.pop_back(); }
+    bool StartSequence() { Push( Yaml::Sequence ); return true; }
+    void EndSequence() { stack_.pop_back(); }
+    void Scalar( std::string_view Text, Sax::TKind Kind ) {
+        Add( Make( Yaml::Scalar, Kind, Text ) );
+    }
+private:
+    std::vector<Yaml*> stack_;
+    std::string key_;
+
+    static std::unique_ptr<Yaml> Make( Yaml::Kind Type, Sax::TKind Kind,
+                                       std::string_view Text ) {
+        auto Item = std::make_unique<Yaml>();
+        Item->Type = Type;
+        Item->Resolved = Kind;
+        Item->Text = Text;
+        return Item;
+    }
+
+    Yaml* Add( std::unique_ptr<Yaml> Item ) {
+        auto const Ptr = Item.get();
+        if ( stack_.empty() ) {
+            Root = std::move( Item );
+        }
+        else if ( stack_.back()->Type == Yaml::Sequence ) {
+            stack_.back()->Items.push_back( std::move( Item ) );
+        }
+        else {
+            stack_.back()->Members.emplace( key_, std::move( Item ) );
+        }
+        return Ptr;
+    }
+
+    void Push( Yaml::Kind Type ) {
+        stack_.push_back( Add( Make( Type, Sax::TKind::String, {} ) ) );
+    }
+};
+
+// OpenPath: from the root, one contains() and operator[] per step, with
+// the name converted back to UTF-8.
+Yaml* OpenPath( Yaml& Root, std::vector<std::wstring> const & Path )
+{
+    auto Cur = &Root;
+    for ( auto const & Name : Path ) {
+        if ( !Cur->contains( "nodes" ) ) { return nullptr; }
+        auto& Inner = ( *Cur )["nodes"];
+        auto const Key = Narrow( Name );
+        if ( !Inner.contains( Key ) ) { return nullptr; }
+        Cur = &Inner[Key];
+    }
+    return Cur;
+}
+
+void Walk( Yaml& Root, std::vector<std::wstring>& Path, Node& Into )
+{
+    auto const Obj = OpenPath( Root, Path );
+    if ( Obj->contains( "values" ) ) {
+        for ( auto const & Member : ( *Obj )["values"].Members ) {
+            auto const & Val = *Member.second;
+            auto Name = Widen( Member.first );
+            if ( Val.Type == Yaml::Scalar ) {
+                switch ( Val.Resolved ) {
+                    case Sax::TKind::Int:    Into.Values[Name] = std::atoi( Val.Text.c_str() ); break;
+                    case Sax::TKind::String: Into.Values[Name] = Widen( Val.Text ); break;
+                    case Sax::TKind::Bool:   Into.Values[Name] = Val.Text == "true"; break;
+                    default: break;
+                }
+            }
+            else if ( Val.Type == Yaml::Mapping && Val.Members.size() == 1 ) {
+                auto const & Payload = *Val.Members.begin()->second;
+                std::vector<std::wstring> Strings;
+                for ( auto const & Item : Payload.Items ) {
+                    Strings.push_back( Widen( Item->Text ) );
+                }
+                Into.Values[Name] =
+                    DecodeTagged(
+                        Val.Members.begin()->first, Payload.Text, std::move( Strings )
+                    );
+            }
+        }
+    }
+    if ( Obj->contains( "nodes" ) ) {
+        std::vector<std::wstring> Names;
+        for ( auto const & Member : ( *Obj )["nodes"].Members ) {
+            if ( Member.second->Type == Yaml::Mapping ) {
+                Names.push_back( Widen( Member.first ) );
+            }
+        }
+        for ( auto& Name : Names ) {
+            auto& Child = Into.Nodes[Name];
+            Child = std::make_unique<Node>();
+            Path.push_back( std::move( Name ) );
+            Walk( Root, Path, *Child );
+            Path.pop_back();
+        }
+    }
+}
+
+std::unique_ptr<Node> LoadDom( std::string const & Doc )
+{
+    DomBuilder Builder;
+    Sax::Parse( Doc.data(), Doc.data() + Doc.size(), Builder );
+    auto Root = std::make_unique<Node>();
+    std::vector<std::wstring> Path;
+    Walk( *Builder.Root, Path, *Root );
+    return Root;
+}
+
+//---------------------------------------------------------------------------
+// after: straight into the tree
+
+class TreeBuilder {
+public:
+    Node Root;
+
+    bool StartMapping() {
+        if ( states_.empty() ) {
+            nodes_.push_back( &Root );
+            states_.push_back( InNode );
+            return true;
+        }
+        switch ( states_.back() ) {
+            case InNode: states_.push_back( member_ ); return true;
+            case InValues: tag_.clear(); text_.clear(); strings_.clear();
+                           states_.push_back( InWrapper ); return true;
+            case InNodes: {
+                auto& Child = nodes_.back()->Nodes[name_];
+                Child = std::make_unique<Node>();
+                nodes_.push_back( Child.get() );
+                states_.push_back( InNode );
+                return true;
+            }
+            default: return false;
+        }
+    }
+
+    bool Key( std::string_view Name, Sax::TKind ) {
+        switch ( states_.back() ) {
+            case InNode:
+                if ( Name == "values" ) { member_ = InValues; return true; }
+                if ( Name == "nodes" ) { member_ = InNodes; return true; }
+                return false;
+            case InWrapper: tag_ = Name; return true;
+            default: name_ = Widen( Name ); return true;
+        }
+    }
+
+    void EndMapping() {
+        auto const State = states_.back();
+        states_.pop_back();
+        if ( State == InWrapper ) {
+            nodes_.back()->Values[name_] = DecodeTagged( tag_, text_, std::move( strings_ ) );
+        }
+        else if ( State == InNode ) {
+            nodes_.pop_back();
+        }
+    }
+
+    bool StartSequence() {
+        if ( states_.back() != InWrapper ) { return false; }
+        states_.push_back( InSequence );
+        return true;
+    }
+
+    void EndSequence() { states_.pop_back(); }
+
+    void Scalar( std::string_view Text, Sax::TKind Kind ) {
+        switch ( states_.back() ) {
+            case InValues:
+                switch ( Kind ) {
+                    case Sax::TKind::Int:
+                        nodes_.back()->Values[name_] = std::atoi( std::string( Text ).c_str() );
+                        break;
+                    case Sax::TKind::String: nodes_.back()->Values[name_] = Widen( Text ); break;
+                    case Sax::TKind::Bool:   nodes_.back()->Values[name_] = Text == "true"; break;
+                    default: break;
+                }
+                break;
+            case InWrapper: text_ = Text; break;
+            case InSequence: strings_.push_back( Widen( Text ) ); break;
+            default: break;
+        }
+    }
+private:
+    enum State { InNode, InValues, InNodes, InWrapper, InSequence };
+
+    std::vector<Node*> nodes_;
+    std::vector<State> states_;
+    State member_ { InValues };
+    std::wstring name_;
+    std::string tag_;
+    std::string text_;
+    std::vector<std::wstring> strings_;
+};
+
+std::unique_ptr<Node> LoadStream( std::string const & Doc )
+{
+    auto Builder = std::make_unique<TreeBuilder>();
+    if ( !Sax::Parse( Doc.data(), Doc.data() + Doc.size(), *Builder ) ) {
+        std::printf( "parse error\n" );
+        std::exit( 1 );
+    }
+    auto Root = std::make_unique<Node>();
+    *Root = std::move( Builder->Root );
+    return Root;
+}
+
+//---------------------------------------------------------------------------
+
+bool Same( Node const & Lhs, Node const & Rhs )
+{
+    if ( Lhs.Values != Rhs.Values || Lhs.Nodes.size() != Rhs.Nodes.size() ) {
+        return false;
+    }
+    auto It = Rhs.Nodes.begin();
+    for ( auto const & Child : Lhs.Nodes ) {
+        if ( Child.first != It->first || !Same( *Child.second, *It->second ) ) {
+            return false;
+        }
+        ++It;
+    }
+    return true;
+}
+
+struct Sample {
+    double Us;
+    std::size_t Allocs;
+    std::size_t PeakBytes;
+};
+
+template<typename F>
+Sample Measure( std::string const & Doc, int Rounds, F&& Load )
+{
+    Sample Result {};
+    auto const Start = std::chrono::steady_clock::now();
+    for ( int Round = 0 ; Round < Rounds ; ++Round ) {
+        auto const BaseAllocs = Allocs;
+        auto const BaseLive = Live;
+        Peak = Live;
+        auto Root = Load( Doc );
+        Result.Allocs = Allocs - BaseAllocs;
+        Result.PeakBytes = Peak - BaseLive;
+        Sink = Root->Nodes.size();
+    }
+    auto const Stop = std::chrono::steady_clock::now();
+    Result.Us = std::chrono::duration<double,std::micro>( Stop - Start ).count() / Rounds;
+    return Result;
+}
+
+void Run( std::size_t Count, int Rounds )
+{
+    auto const Doc = MakeDocument( Count );
+    if ( !Same( *LoadDom( Doc ), *LoadStream( Doc ) ) ) {
+        std::printf( "mismatch at %zu nodes\n", Count );
+        std::exit( 1 );
+    }
+    auto const Dom = Measure( Doc, Rounds, &LoadDom );
+    auto const Stream = Measure( Doc, Rounds, &LoadStream );
+    std::printf(
+        "%6zu nodes %8zu KiB | %9.0f / %9.0f us | allocs %8zu / %8zu | peak %7zu / %7zu KiB\n",
+        Count, Doc.size() / 1024, Dom.Us, Stream.Us, Dom.Allocs, Stream.Allocs,
+        Dom.PeakBytes / 1024, Stream.PeakBytes / 1024
+    );
+}
+
+} // namespace
+
+int main()
+{
+    std::printf( "eager YAML load, document + walk / stream\n" );
+    Run( 100, 200 );
+    Run( 1000, 20 );
+    Run( 10000, 3 );
+    return 0;
+}
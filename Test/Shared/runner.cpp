@@ -61,7 +61,7 @@ private:
 
 extern int main( int, char** );
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
+#if defined( _WIN64 ) && __clang_major__ >= 15
 ::boost::unit_test::test_suite* init_unit_test( int, char*[] )
 {
     return nullptr;
@@ -101,7 +101,7 @@ int RunBoostUtf8Main( int argc, wchar_t* argv[] )
         }
     }
     setvbuf(stdout, nullptr, _IONBF, 0);
-#if defined( ANAFESTICA_USE_STD_VARIANT )
+#if defined( _WIN64 ) && __clang_major__ >= 15
     return ::boost::unit_test::unit_test_main( &init_unit_test, argc, UTF8argv.data() );
 #else
     return ::main( argc, &UTF8argv[0] );
@@ -2,10 +2,9 @@
 // TConfig roundtrip tests for the built-in backends (Registry, JSON, BSON,
 // INIFile, XML). The optional YAML backend is compiled only when
 // ANAFESTICA_TEST_YAML is defined and fkYAML is reachable through the active
-// toolchain include path. The 19 common variant alternatives are exercised on
-// every toolchain.
-// The std::variant-only std::string, std::wstring, and string_view coverage is
-// compiled only on the bcc64x path.
+// toolchain include path. All 21 value alternatives, including std::string,
+// std::wstring and the string_view write overloads, are exercised on every
+// toolchain.
 //---------------------------------------------------------------------------
 
 #pragma hdrstop
@@ -20,10 +19,10 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-# include <string_view>
-#endif
+#include <string_view>
+#include <cstdint>
+#include <cwchar>
+#include <iterator>
 
 #include <windows.h>
 #include <objbase.h>
@@ -100,10 +99,8 @@ inline BytesCont MakeVB() {
     return { 0xFE, 0xCA, 0x39, 0x43 };
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 const std::string  kSTR  = "Hello Anafestica (UTF-8)";
 const std::wstring kWSTR = L"Hello Anafestica (Wide)";
-#endif
 
 enum class ETestMode {
   Alpha = 1,
@@ -195,6 +192,46 @@ Anafestica::Crypt::TOptions MakeCryptOptions() {
     };
 }
 
+Anafestica::TConfigOptions LoadOptions( Anafestica::TLoadMode Mode ) {
+    Anafestica::TConfigOptions Options;
+    Options.LoadMode = Mode;
+    return Options;
+}
+
+// Flushes an object periodically in the given TDocumentMode while a second
+// object adds a node to the same file in between.  Checks that the final
+// file holds every change and returns its bytes.  Open( Path, Options )
+// constructs an object.
+template<typename F>
+std::vector<unsigned char> FlushPeriodically( Anafestica::TDocumentMode Mode,
+                                              String const& Path, F Open )
+{
+    {
+        Anafestica::TConfigOptions Options;
+        Options.DocumentMode = Mode;
+        auto c = Open( Path, Options );
+        auto& Root = c.GetRootNode();
+        Root.PutItem( L"a", 1 );
+        c.Flush();
+        Root[L"N"].PutItem( L"b", String( L"two" ) );
+        c.Flush();
+        {
+            auto Other = Open( Path, Anafestica::TConfigOptions{} );
+            Other.GetRootNode()[L"Ext"].PutItem( L"x", 9 );
+        }
+        Root.PutItem( L"a", 3 );
+        Root[L"N"].PutItem( L"c", 4 );
+        c.Flush();
+    }
+    auto Bytes = TFile::ReadAllBytes( Path );
+    auto c = Open( Path, Anafestica::TConfigOptions{} );
+    BOOST_TEST( c.GetRootNode().GetItem<int>( L"a" ) == 3 );
+    BOOST_TEST( c.GetRootNode()[L"N"].GetItem<String>( L"b" ) == String( L"two" ) );
+    BOOST_TEST( c.GetRootNode()[L"N"].GetItem<int>( L"c" ) == 4 );
+    BOOST_TEST( c.GetRootNode()[L"Ext"].GetItem<int>( L"x" ) == 9 );
+    return std::vector<unsigned char>( std::begin( Bytes ), std::end( Bytes ) );
+}
+
 bool FileContainsAscii( String const& Path, std::string const& Needle ) {
     auto Bytes = TFile::ReadAllBytes( Path );
     std::vector<unsigned char> Haystack( std::begin( Bytes ), std::end( Bytes ) );
@@ -411,7 +448,6 @@ BOOST_AUTO_TEST_CASE( Registry_bytevec_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<BytesCont>( L"val" ) == vb );
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 BOOST_AUTO_TEST_CASE( Registry_stdstring_roundtrip )
 {
     const auto key = MakeRegCfgKey(); ScopedRegKey g( key );
@@ -445,7 +481,6 @@ BOOST_AUTO_TEST_CASE( Registry_string_view_write )
     BOOST_CHECK( c.GetRootNode().GetItem<std::wstring>( L"wsv" ) == kWSTR );
 }
 
-#endif
 
 BOOST_AUTO_TEST_CASE( Registry_enum_roundtrip )
 {
@@ -468,6 +503,314 @@ BOOST_AUTO_TEST_CASE( Registry_subnode_roundtrip )
 
 BOOST_AUTO_TEST_SUITE_END()
 
+//---------------------------------------------------------------------------
+// *** Registry::TConfig over Store::TMemoryHive ***
+//---------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE( TConfig_Registry_MemoryHive )
+
+namespace Store = Anafestica::Registry::Store;
+
+BOOST_AUTO_TEST_CASE( Hive_all_types_roundtrip )
+{
+    Store::TMemoryHive hive;
+    const String key = L"Software\\Anafestica\\Hive";
+    { Anafestica::Registry::TConfig c( hive, key );
+      auto& r = c.GetRootNode();
+      r.PutItem( L"i", kI );     r.PutItem( L"u", kU );     r.PutItem( L"l", kL );
+      r.PutItem( L"ul", kUL );   r.PutItem( L"c", kC );     r.PutItem( L"uc", kUC );
+      r.PutItem( L"s", kS );     r.PutItem( L"us", kUS );   r.PutItem( L"ll", kLL );
+      r.PutItem( L"ull", kULL ); r.PutItem( L"b", kB );     r.PutItem( L"sz", String( kSZ ) );
+      r.PutItem( L"dt", kDT() ); r.PutItem( L"flt", kFLT ); r.PutItem( L"dbl", kDBL );
+      r.PutItem( L"cur", kCUR() );
+      r.PutItem( L"sv", MakeSV() );
+      r.PutItem( L"dab", MakeDAB() );
+      r.PutItem( L"vb", MakeVB() );
+      r.PutItem( L"str", kSTR );
+      r[L"Child"].PutItem( L"wstr", kWSTR ); }
+
+    // Laid out as TRegistry lays them out.
+    Store::TType type {};
+    std::vector<unsigned char> data;
+    BOOST_TEST( hive.Get( L"Software\\Anafestica\\Hive", L"u:(u)", type, data ) );
+    BOOST_TEST( ( type == Store::TType::Dword ) );
+    BOOST_TEST( data.size() == 4u );
+    BOOST_TEST( hive.Get( L"Software\\Anafestica\\Hive", L"sz", type, data ) );
+    BOOST_TEST( ( type == Store::TType::Sz ) );
+    BOOST_TEST( data.size() == ( std::wcslen( kSZ ) + 1 ) * sizeof( wchar_t ) );
+    BOOST_TEST( hive.Get( L"Software\\Anafestica\\Hive", L"cur:(cur)", type, data ) );
+    BOOST_TEST( ( type == Store::TType::Binary ) );
+    BOOST_TEST( hive.Get( L"Software\\Anafestica\\Hive\\Child", L"wstr:(wstr)", type, data ) );
+
+    Anafestica::Registry::TConfig c( hive, key );
+    auto& r = c.GetRootNode();
+    BOOST_TEST( r.GetItem<int>( L"i" ) == kI );
+    BOOST_TEST( r.GetItem<unsigned int>( L"u" ) == kU );
+    BOOST_TEST( r.GetItem<long>( L"l" ) == kL );
+    BOOST_TEST( r.GetItem<unsigned long>( L"ul" ) == kUL );
+    BOOST_TEST( r.GetItem<char>( L"c" ) == kC );
+    BOOST_TEST( r.GetItem<unsigned char>( L"uc" ) == kUC );
+    BOOST_TEST( r.GetItem<short>( L"s" ) == kS );
+    BOOST_TEST( r.GetItem<unsigned short>( L"us" ) == kUS );
+    BOOST_TEST( r.GetItem<long long>( L"ll" ) == kLL );
+    BOOST_TEST( r.GetItem<unsigned long long>( L"ull" ) == kULL );
+    BOOST_TEST( r.GetItem<bool>( L"b" ) == kB );
+    BOOST_TEST( r.GetItem<String>( L"sz" ) == String( kSZ ) );
+    BOOST_TEST( r.GetItem<System::TDateTime>( L"dt" ) == kDT() );
+    BOOST_TEST( r.GetItem<float>( L"flt" ) == kFLT );
+    BOOST_TEST( r.GetItem<double>( L"dbl" ) == kDBL );
+    BOOST_TEST( r.GetItem<System::Currency>( L"cur" ) == kCUR() );
+    BOOST_TEST( ( r.GetItem<StringCont>( L"sv" ) == MakeSV() ) );
+    BOOST_TEST( DABEqual( r.GetItem<System::Sysutils::TBytes>( L"dab" ), MakeDAB() ) );
+    BOOST_TEST( r.GetItem<BytesCont>( L"vb" ) == MakeVB() );
+    BOOST_TEST( r.GetItem<std::string>( L"str" ) == kSTR );
+    BOOST_CHECK( r[L"Child"].GetItem<std::wstring>( L"wstr" ) == kWSTR );
+}
+
+BOOST_AUTO_TEST_CASE( Hive_untagged_values_load_by_type )
+{
+    Store::TMemoryHive hive;
+    {
+        Store::TBatch batch;
+        std::uint64_t const big = 1ULL << 40;
+        unsigned char const bytes[] = { 1, 2, 3 };
+        std::wstring const items[] = { L"a", L"", L"c" };
+        batch.SetDword( L"dword", 7 );
+        batch.SetDword( L"other:(zz)", 8 );
+        batch.SetQword( L"qword", big );
+        batch.SetString( L"sz", L"text" );
+        batch.SetStrings(
+            L"multi", std::begin( items ), std::end( items ),
+            []( std::wstring const & Item ) { return Store::TStringView( Item ); }
+        );
+        batch.Set( L"bin", Store::TType::Binary, bytes, sizeof bytes );
+        hive.Create( L"Root" )->Apply( batch );
+    }
+
+    Anafestica::Registry::TConfig c( hive, L"Root" );
+    auto& r = c.GetRootNode();
+    BOOST_TEST( r.GetItem<int>( L"dword" ) == 7 );
+    BOOST_TEST( r.GetItem<int>( L"other:(zz)" ) == 8 );     // unknown tag: part of the name
+    BOOST_TEST( r.GetItem<long long>( L"qword" ) == ( 1LL << 40 ) );
+    BOOST_TEST( r.GetItem<String>( L"sz" ) == String( L"text" ) );
+    BOOST_TEST( ( r.GetItem<StringCont>( L"multi" ) == StringCont{ L"a", L"", L"c" } ) );
+    BOOST_TEST( r.GetItem<System::Sysutils::TBytes>( L"bin" ).Length == 3 );
+}
+
+BOOST_AUTO_TEST_CASE( Hive_names_are_case_insensitive )
+{
+    Store::TMemoryHive hive;
+    {
+        Store::TBatch batch;
+        batch.SetDword( L"Port", 1 );
+        hive.Create( L"Soft\\App" )->Apply( batch );
+        batch.Clear();
+        batch.SetDword( L"PORT", 2 );
+        hive.Create( L"SOFT\\app" )->Apply( batch );
+    }
+    BOOST_TEST( hive.KeyExists( L"soft\\APP" ) );
+
+    Anafestica::Registry::TConfig c( hive, L"Soft" );
+    auto& r = c.GetRootNode();
+    // One key and one value, with the case they were created with.
+    BOOST_TEST( r.GetNodeCount() == 1u );
+    BOOST_TEST( r.SubNodeExists( L"App" ) );
+    BOOST_TEST( r[L"App"].GetValueCount() == 1u );
+    BOOST_TEST( r[L"App"].GetItem<int>( L"Port" ) == 2 );
+}
+
+BOOST_AUTO_TEST_CASE( Hive_erase_and_delete_node_persist )
+{
+    Store::TMemoryHive hive;
+    { Anafestica::Registry::TConfig c( hive, L"Root" );
+      c.GetRootNode().PutItem( L"keep", 1 );
+      c.GetRootNode().PutItem( L"drop", 2 );
+      c.GetRootNode()[L"child"][L"grand"].PutItem( L"v", 99 ); }
+    BOOST_TEST( hive.KeyExists( L"Root\\child\\grand" ) );
+    { Anafestica::Registry::TConfig c( hive, L"Root" );
+      c.GetRootNode().DeleteItem( L"drop" );
+      c.GetRootNode().DeleteSubNode( L"child" ); }
+    BOOST_TEST( !hive.KeyExists( L"Root\\child" ) );
+
+    Anafestica::Registry::TConfig c( hive, L"Root" );
+    BOOST_TEST( c.GetRootNode().GetItem<int>( L"keep" ) == 1 );
+    BOOST_TEST( !c.GetRootNode().ItemExists( L"drop" ) );
+    BOOST_TEST( !c.GetRootNode().SubNodeExists( L"child" ) );
+}
+
+BOOST_AUTO_TEST_CASE( Hive_second_flush_writes_nothing )
+{
+    Store::TMemoryHive hive;
+    Anafestica::Registry::TConfig c( hive, L"Root" );
+    auto& r = c.GetRootNode();
+    r.PutItem( L"keep", 1 );
+    r.PutItem( L"drop", 2 );
+    r[L"child"].PutItem( L"v", 3 );
+    r[L"gone"].PutItem( L"v", 4 );
+    c.Flush();
+    BOOST_TEST( !r.IsModified() );
+    BOOST_TEST( !c.ShouldFlushOnDestruction() );
+
+    r.DeleteItem( L"drop" );
+    r[L"child"].PutItem( L"v", 5 );
+    r.DeleteSubNode( L"gone" );
+    c.Flush();
+    BOOST_TEST( !r.IsModified() );
+    BOOST_TEST( !r[L"gone"].IsDeleted() );
+    BOOST_TEST( !r.ItemExists( L"drop" ) );     // the erased entry went with it
+    BOOST_TEST( !hive.KeyExists( L"Root\\gone" ) );
+
+    auto const Root = hive.Open( L"Root" )->GetStamp();
+    auto const Child = hive.Open( L"Root\\child" )->GetStamp();
+    c.Flush();
+    BOOST_TEST( ( hive.Open( L"Root" )->GetStamp() == Root ) );
+    BOOST_TEST( ( hive.Open( L"Root\\child" )->GetStamp() == Child ) );
+    BOOST_TEST( !hive.KeyExists( L"Root\\gone" ) );
+    BOOST_TEST( r[L"child"].GetItem<int>( L"v" ) == 5 );
+}
+
+// Root with two values and nodes a, b (each with one value), b\c empty.
+static void FillSnapshotHive( Store::TMemoryHive& hive )
+{
+    { Anafestica::Registry::TConfig c( hive, L"Root" );
+      auto& r = c.GetRootNode();
+      r.PutItem( L"x", 1 );
+      r.PutItem( L"name", String( L"root" ) );
+      r[L"a"].PutItem( L"v", 10 );
+      r[L"b"].PutItem( L"v", 20 ); }
+    hive.Create( L"Root\\b\\c" );     // a flush leaves empty nodes out
+}
+
+BOOST_AUTO_TEST_CASE( Hive_snapshot_skips_unchanged_keys )
+{
+    const auto f = MakeTempPath( L".snapshot" ); TempFileGuard g( f );
+    Store::TMemoryHive hive;
+    FillSnapshotHive( hive );
+
+    // No file yet: every value, and nothing is added to the root.
+    auto reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      BOOST_TEST( c.GetRootNode().GetItem<int>( L"x" ) == 1 );
+      BOOST_TEST( c.GetRootNode().GetValueCount() == 2u ); }
+    BOOST_TEST( hive.GetValueReads() - reads == 4u );
+    BOOST_TEST( TFile::Exists( f ) );
+    BOOST_TEST( ( hive.Open( L"Root" )->GetStamp().Values == 2u ) );
+
+    // Every stamp matches: nothing is read.
+    reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      auto& r = c.GetRootNode();
+      BOOST_TEST( r.GetItem<String>( L"name" ) == String( L"root" ) );
+      BOOST_TEST( r[L"a"].GetItem<int>( L"v" ) == 10 );
+      BOOST_TEST( r[L"b"].SubNodeExists( L"c" ) );
+      BOOST_TEST( hive.GetValueReads() == reads );
+      r[L"a"].PutItem( L"v", 11 );
+      r[L"a"].PutItem( L"w", 12 ); }
+
+    // The flush read the key it wrote again.
+    reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      BOOST_TEST( c.GetRootNode()[L"a"].GetItem<int>( L"v" ) == 11 );
+      BOOST_TEST( c.GetRootNode()[L"a"].GetItem<int>( L"w" ) == 12 ); }
+    BOOST_TEST( hive.GetValueReads() == reads );
+
+    // Lazy loads read nothing either.
+    reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c(
+          hive, L"Root", false, false, f, LoadOptions( Anafestica::TLoadMode::Lazy )
+      );
+      BOOST_TEST( c.GetRootNode()[L"b"].GetItem<int>( L"v" ) == 20 ); }
+    BOOST_TEST( hive.GetValueReads() == reads );
+}
+
+BOOST_AUTO_TEST_CASE( Hive_snapshot_rereads_keys_changed_behind_it )
+{
+    const auto f = MakeTempPath( L".snapshot" ); TempFileGuard g( f );
+    Store::TMemoryHive hive;
+    FillSnapshotHive( hive );
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f ); }
+
+    // Another writer, straight into the hive: a value of b changes (the
+    // counts stay), b\c goes, d appears.
+    {
+        Store::TBatch batch;
+        batch.SetDword( L"v", 21 );
+        hive.Open( L"Root\\b" )->Apply( batch );
+        BOOST_TEST( hive.Delete( L"Root\\b\\c" ) );
+        batch.Clear();
+        batch.SetDword( L"v", 30 );
+        hive.Create( L"Root\\d" )->Apply( batch );
+    }
+
+    // Every key is checked against its stamp: the root (a subkey more),
+    // b and d are read, a is not.
+    auto reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      auto& r = c.GetRootNode();
+      BOOST_TEST( r.GetNodeCount() == 3u );
+      BOOST_TEST( r[L"a"].GetItem<int>( L"v" ) == 10 );
+      BOOST_TEST( r[L"b"].GetItem<int>( L"v" ) == 21 );
+      BOOST_TEST( !r[L"b"].SubNodeExists( L"c" ) );
+      BOOST_TEST( r[L"d"].GetItem<int>( L"v" ) == 30 );
+      BOOST_TEST( r.GetItem<int>( L"x" ) == 1 ); }
+    BOOST_TEST( hive.GetValueReads() - reads == 4u );
+
+    // An object without a snapshot: only the key it wrote is read again.
+    { Anafestica::Registry::TConfig c( hive, L"Root" );
+      c.GetRootNode()[L"a"].PutItem( L"v", 15 ); }
+    reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      BOOST_TEST( c.GetRootNode()[L"a"].GetItem<int>( L"v" ) == 15 ); }
+    BOOST_TEST( hive.GetValueReads() - reads == 1u );
+
+    // A deleted node leaves the snapshot too.
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      c.GetRootNode().DeleteSubNode( L"b" ); }
+    reads = hive.GetValueReads();
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f );
+      BOOST_TEST( !c.GetRootNode().SubNodeExists( L"b" ) );
+      BOOST_TEST( c.GetRootNode().GetNodeCount() == 2u ); }
+    BOOST_TEST( hive.GetValueReads() == reads );
+}
+
+BOOST_AUTO_TEST_CASE( Hive_snapshot_damaged_file_reads_everything )
+{
+    const auto f = MakeTempPath( L".snapshot" ); TempFileGuard g( f );
+    Store::TMemoryHive hive;
+    FillSnapshotHive( hive );
+    { Anafestica::Registry::TConfig c( hive, L"Root", false, false, f ); }
+    auto const image = TFile::ReadAllBytes( f );
+    BOOST_TEST_REQUIRE( image.Length > 16 );
+
+    // Truncated, one byte flipped, for another root, not one at all.
+    TBytes damaged = image.Copy();
+    damaged.Length = image.Length - 1;
+    TBytes flipped = image.Copy();
+    flipped[image.Length / 2] ^= 0x20;
+    TBytes junk;
+    junk.Length = 64;
+    std::fill( &junk[0], &junk[0] + junk.Length, Byte( 0x41 ) );
+    struct { TBytes bytes; String root; String name; int val; } const cases[] = {
+        { damaged, L"Root", L"x", 1 },
+        { flipped, L"Root", L"x", 1 },
+        { image, L"Root\\a", L"v", 10 },
+        { junk, L"Root", L"x", 1 },
+    };
+    for ( auto const & t : cases ) {
+        TFile::WriteAllBytes( f, t.bytes );
+        auto reads = hive.GetValueReads();
+        { Anafestica::Registry::TConfig c( hive, t.root, false, false, f );
+          BOOST_TEST( c.GetRootNode().GetItem<int>( t.name ) == t.val ); }
+        BOOST_TEST( hive.GetValueReads() > reads );
+        // ... and writes the file anew: then nothing is read.
+        reads = hive.GetValueReads();
+        { Anafestica::Registry::TConfig c( hive, t.root, false, false, f ); }
+        BOOST_TEST( hive.GetValueReads() == reads );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 
 //---------------------------------------------------------------------------
 // *** JSON::TConfig tests ***
@@ -670,7 +1013,6 @@ BOOST_AUTO_TEST_CASE( JSON_bytevec_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<BytesCont>( L"val" ) == vb );
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 BOOST_AUTO_TEST_CASE( JSON_stdstring_roundtrip )
 {
     const auto f = MakeTempPath( L".json" ); TempFileGuard g( f );
@@ -702,7 +1044,6 @@ BOOST_AUTO_TEST_CASE( JSON_string_view_write )
     BOOST_CHECK( c.GetRootNode().GetItem<std::wstring>( L"wsv" ) == kWSTR );
 }
 
-#endif
 
 BOOST_AUTO_TEST_CASE( JSON_enum_roundtrip )
 {
@@ -738,6 +1079,219 @@ BOOST_AUTO_TEST_CASE( JSON_explicit_types_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<String>( L"sz" ) == String( kSZ ) );
 }
 
+BOOST_AUTO_TEST_CASE( JSON_hand_written_file_loads_alike_eager_and_lazy )
+{
+    // Eager loads stream the file into the tree, lazy ones read the DOM:
+    // both must see the same tree.  Written as UTF-8 with a BOM.
+    const auto f = MakeTempPath( L".json" ); TempFileGuard g( f );
+    TFile::WriteAllText(
+        f,
+        L"{ \"junk\": { \"values\": { \"x\": 1 } },\n"
+        L"  \"values\": {\n"
+        L"    \"i\": -42, \"s\": \"caf\u00e9 \\\"q\\\" \\u00e9\\ud83d\\ude00\", \"b\": true,\n"
+        L"    \"n\": null, \"d\": { \"dbl\": 0.5 }, \"sv\": { \"sv\": [ \"a\", \"b\\n\" ] },\n"
+        L"    \"two\": { \"i\": 1, \"sz\": \"x\" }, \"unknown\": { \"nope\": 1 }\n"
+        L"  },\n"
+        L"  \"nodes\": {\n"
+        L"    \"A\": { \"values\": { \"a\": 1 },\n"
+        L"           \"nodes\": { \"Deep\": { \"values\": { \"z\": \"zz\" } } } },\n"
+        L"    \"NotANode\": 5,\n"
+        L"    \"A\": { \"values\": { \"a\": 2 } }\n"
+        L"  }\n"
+        L"}\n",
+        TEncoding::UTF8
+    );
+    for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        Anafestica::JSON::TConfig c(
+            f, /*ReadOnly*/true, true, false, false, {}, LoadOptions( Mode )
+        );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"i" ) == -42 );
+        BOOST_TEST( Root.GetItem<String>( L"s" ) ==
+                    String( L"caf\u00e9 \"q\" \u00e9\U0001F600" ) );
+        BOOST_TEST( Root.GetItem<bool>( L"b" ) == true );
+        BOOST_TEST( Root.GetItem<double>( L"d" ) == 0.5 );
+        BOOST_TEST( ( Root.GetItem<Anafestica::StringCont>( L"sv" ) ==
+                      Anafestica::StringCont{ L"a", L"b\n" } ) );
+        BOOST_TEST( !Root.ItemExists( L"n" ) );
+        BOOST_TEST( !Root.ItemExists( L"two" ) );
+        BOOST_TEST( !Root.ItemExists( L"unknown" ) );
+        BOOST_TEST( !Root.ItemExists( L"x" ) );
+        BOOST_TEST( !Root.SubNodeExists( L"NotANode" ) );
+        BOOST_TEST( Root[L"A"].GetItem<int>( L"a" ) == 1 );
+        BOOST_TEST( Root[L"A"][L"Deep"].GetItem<String>( L"z" ) == String( L"zz" ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( JSON_utf16_file_loads_through_the_dom )
+{
+    // The streaming reader only takes UTF-8; anything else is handed to the
+    // DOM reader, which detects the encoding from the BOM.
+    const auto f = MakeTempPath( L".json" ); TempFileGuard g( f );
+    TFile::WriteAllText(
+        f, L"{\"values\":{\"val\":7},\"nodes\":{\"Child\":{\"values\":{\"s\":\"x\"}}}}",
+        TEncoding::Unicode
+    );
+    Anafestica::JSON::TConfig c( f );
+    BOOST_TEST( c.GetRootNode().GetItem<int>( L"val" ) == 7 );
+    BOOST_TEST( c.GetRootNode()[L"Child"].GetItem<String>( L"s" ) == String( L"x" ) );
+}
+
+// Eager flushes stream the file, lazy ones rewrite it through the DOM:
+// both must leave the same bytes behind, which pins TTextWriter's layout
+// to the RTL's.  Returns the file as flushed in Mode after Edit has run
+// on its root; Source is the file's content before (none when empty).
+template<typename E>
+static String FlushJSONWith( Anafestica::TLoadMode Mode, String const & Source,
+                             bool Compact, bool ExplicitTypes, E&& Edit )
+{
+    const auto f = MakeTempPath( L".json" ); TempFileGuard g( f );
+    if ( !Source.IsEmpty() ) {
+        TFile::WriteAllText( f, Source );
+    }
+    // A file of the user's with the name of the old temporary one.
+    const auto Foreign = f + L".tmp"; TempFileGuard gf( Foreign );
+    TFile::WriteAllText( Foreign, L"mine" );
+    const auto Dir = TPath::GetDirectoryName( TPath::GetFullPath( f ) );
+    const auto Temps = TDirectory::GetFiles( Dir, L"ana*.tmp" ).Length;
+    {
+        Anafestica::JSON::TConfig c( f, /*ReadOnly*/false, Compact,
+                                     /*FlushAllItems*/false, ExplicitTypes,
+                                     {}, LoadOptions( Mode ) );
+        Edit( c.GetRootNode() );
+    }
+    // Streamed or not, the flush leaves no temporary file behind and
+    // touches no other file.
+    BOOST_TEST( TDirectory::GetFiles( Dir, L"ana*.tmp" ).Length == Temps );
+    BOOST_TEST( TFile::ReadAllText( Foreign ) == String( L"mine" ) );
+    return TFile::ReadAllText( f );
+}
+
+static String FlushJSONEdits( Anafestica::TLoadMode Mode, String const & Source,
+                              bool Compact, bool ExplicitTypes )
+{
+    return FlushJSONWith(
+        Mode, Source, Compact, ExplicitTypes,
+        []( Anafestica::TConfigNode& Root ) {
+            Root.PutItem( L"i", 7 );
+            Root.DeleteItem( L"b" );
+            Root.PutItem( L"new", String( L"a/b \"caf\u00e9\"" ) );
+            Root.PutItem( L"dbl", 2.5 );
+            Root.PutItem( L"list", Anafestica::StringCont{ L"x", L"y\tz" } );
+            Root[L"A"].PutItem( L"a", 3 );
+            Root[L"New"][L"Leaf"].PutItem( L"ll", 1234567890123LL );
+            Root.DeleteSubNode( L"Gone" );
+        }
+    );
+}
+
+BOOST_AUTO_TEST_CASE( JSON_streamed_flush_matches_the_document_writer )
+{
+    String const Source =
+        L"{ \"junk\": [ 1, { \"x\": null } ],\n"
+        L"  \"values\": { \"i\": 1, \"b\": true, \"s\": \"caf\u00e9 \\/ \\u0001\",\n"
+        L"              \"num\": 1.50e+1, \"b\": false },\n"
+        L"  \"nodes\": {\n"
+        L"    \"A\": { \"nodes\": {}, \"values\": { \"a\": 1, \"keep\": \"k\" } },\n"
+        L"    \"Gone\": { \"values\": { \"g\": 1 } },\n"
+        L"    \"NotANode\": 5\n"
+        L"  }\n"
+        L"}\n";
+    for ( bool Compact : { true, false } ) {
+        for ( bool ExplicitTypes : { false, true } ) {
+            BOOST_TEST(
+                FlushJSONEdits( Anafestica::TLoadMode::Eager, Source, Compact, ExplicitTypes ) ==
+                FlushJSONEdits( Anafestica::TLoadMode::Lazy, Source, Compact, ExplicitTypes )
+            );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( JSON_streamed_flush_of_a_new_file_matches_the_document_writer )
+{
+    for ( bool Compact : { true, false } ) {
+        BOOST_TEST(
+            FlushJSONEdits( Anafestica::TLoadMode::Eager, String(), Compact, false ) ==
+            FlushJSONEdits( Anafestica::TLoadMode::Lazy, String(), Compact, false )
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( JSON_streamed_flush_of_unusual_names_matches_the_document_writer )
+{
+    // Names a path cannot spell ('.', '[', ']', empty) and a node given
+    // twice, one of them deleted: whichever way the eager flush takes them,
+    // the bytes are the document writer's.  Value names are streamed; a
+    // node name of that kind hands the flush to the document writer.
+    String const Source =
+        L"{ \"values\": { \"v.w\": 1, \"[0]\": 2, \"\": 3 },\n"
+        L"  \"nodes\": {\n"
+        L"    \"a.b\": { \"values\": { \"x\": 1 } },\n"
+        L"    \"c[1]\": { \"values\": { \"]\": 1 } },\n"
+        L"    \"\": { \"values\": { \"e\": 1 } },\n"
+        L"    \"Dup\": { \"values\": { \"d\": 1 } },\n"
+        L"    \"Dup\": { \"values\": { \"d\": 2 } },\n"
+        L"    \"Plain\": { \"values\": { \"p.q\": 1 } }\n"
+        L"  }\n"
+        L"}\n";
+    auto const EditValues = []( Anafestica::TConfigNode& Root ) {
+        Root.PutItem( L"v.w", 10 );
+        Root.DeleteItem( L"[0]" );
+        Root.PutItem( L"", 30 );
+        Root.PutItem( L"new.[x]", 40 );
+        Root[L"Plain"].PutItem( L"p.q", 11 );
+        Root[L"Plain"].PutItem( L"]", 12 );
+        Root[L"Fresh"].PutItem( L"", 13 );
+    };
+    auto const EditNodes = [EditValues]( Anafestica::TConfigNode& Root ) {
+        EditValues( Root );
+        Root[L"a.b"].PutItem( L"x", 11 );
+        Root[L"c[1]"].PutItem( L"]", 12 );
+        Root[L""].PutItem( L"e", 13 );
+        Root[L"n.e[w]"][L""].PutItem( L"", 14 );
+        Root.DeleteSubNode( L"Dup" );
+    };
+    for ( bool Compact : { true, false } ) {
+        BOOST_TEST(
+            FlushJSONWith( Anafestica::TLoadMode::Eager, Source, Compact, false, EditValues ) ==
+            FlushJSONWith( Anafestica::TLoadMode::Lazy, Source, Compact, false, EditValues )
+        );
+        BOOST_TEST(
+            FlushJSONWith( Anafestica::TLoadMode::Eager, Source, Compact, false, EditNodes ) ==
+            FlushJSONWith( Anafestica::TLoadMode::Lazy, Source, Compact, false, EditNodes )
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( JSON_retained_document_flushes_like_a_reloaded_one )
+{
+    for ( auto LoadMode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        auto Open = [LoadMode]( String const& Path, Anafestica::TConfigOptions Options ) {
+            Options.LoadMode = LoadMode;
+            return Anafestica::JSON::TConfig( Path, false, true, false, false, {}, Options );
+        };
+        const auto f1 = MakeTempPath( L".json" ); TempFileGuard g1( f1 );
+        const auto f2 = MakeTempPath( L".json" ); TempFileGuard g2( f2 );
+        BOOST_TEST(
+            FlushPeriodically( Anafestica::TDocumentMode::Retain, f1, Open ) ==
+            FlushPeriodically( Anafestica::TDocumentMode::Reload, f2, Open )
+        );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( JSONCrypt_retained_document_picks_up_external_changes )
+{
+    const auto f = MakeTempPath( L".json.crypt" ); TempFileGuard g( f );
+    FlushPeriodically(
+        Anafestica::TDocumentMode::Retain, f,
+        []( String const& Path, Anafestica::TConfigOptions const& Options ) {
+            return Anafestica::JSONCrypt::TConfig(
+                Path, false, true, false, false, MakeCryptOptions(), Options
+            );
+        }
+    );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -938,7 +1492,6 @@ BOOST_AUTO_TEST_CASE( BSON_bytevec_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<BytesCont>( L"val" ) == vb );
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 BOOST_AUTO_TEST_CASE( BSON_stdstring_roundtrip )
 {
     const auto f = MakeTempPath( L".bson" ); TempFileGuard g( f );
@@ -970,7 +1523,6 @@ BOOST_AUTO_TEST_CASE( BSON_string_view_write )
     BOOST_CHECK( c.GetRootNode().GetItem<std::wstring>( L"wsv" ) == kWSTR );
 }
 
-#endif
 
 BOOST_AUTO_TEST_CASE( BSON_enum_roundtrip )
 {
@@ -1004,6 +1556,291 @@ BOOST_AUTO_TEST_CASE( BSON_explicit_types_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<String>( L"sz" ) == String( kSZ ) );
 }
 
+BOOST_AUTO_TEST_CASE( BSON_retained_document_flushes_like_a_reloaded_one )
+{
+    auto Open = []( String const& Path, Anafestica::TConfigOptions const& Options ) {
+        return Anafestica::BSON::TConfig(
+            Path, false, false, false, {}, Anafestica::BSON::TEncoding::Portable, Options
+        );
+    };
+    const auto f1 = MakeTempPath( L".bson" ); TempFileGuard g1( f1 );
+    const auto f2 = MakeTempPath( L".bson" ); TempFileGuard g2( f2 );
+    BOOST_TEST(
+        FlushPeriodically( Anafestica::TDocumentMode::Retain, f1, Open ) ==
+        FlushPeriodically( Anafestica::TDocumentMode::Reload, f2, Open )
+    );
+}
+
+static void WriteBSONFile( String const & Path, std::string const & Bytes )
+{
+    TBytes Data;
+    Data.Length = static_cast<int>( Bytes.size() );
+    std::copy( Bytes.begin(), Bytes.end(), &Data[0] );
+    TFile::WriteAllBytes( Path, Data );
+}
+
+// The layout the document writer leaves behind, with the oddities a
+// hand-edited or foreign file may hold.
+static std::string MakeBSONSource()
+{
+    std::string Bytes;
+    Anafestica::BSON::Wire::TWriter<> w( Bytes );
+    w.BeginDocument();
+    w.Key( "junk" ); w.BeginDocument();
+      w.Key( "values" ); w.BeginDocument(); w.Key( "x" ); w.Int32( 1 ); w.End();
+    w.End();
+    w.Key( "values" ); w.BeginDocument();
+      w.Key( "i" ); w.Int32( -42 );
+      w.Key( "i64" ); w.Int64( 7 );
+      w.Key( "s" ); w.String( "caf\xC3\xA9" );
+      w.Key( "b" ); w.Bool( true );
+      w.Key( "n" ); w.Null();
+      w.Key( "d" ); w.BeginDocument(); w.Key( "dbl" ); w.Double( 0.5 ); w.End();
+      w.Key( "ll" ); w.BeginDocument(); w.Key( "ll" ); w.Int32( 5 ); w.End();
+      w.Key( "u" ); w.BeginDocument(); w.Key( "uint" ); w.Int64( 4000000000LL ); w.End();
+      w.Key( "sv" ); w.BeginDocument(); w.Key( "sv" );
+        w.BeginArray(); w.String( "a" ); w.String( "b\n" ); w.End();
+      w.End();
+      w.Key( "two" ); w.BeginDocument(); w.Key( "int" ); w.Int32( 1 ); w.Key( "sz" ); w.String( "x" ); w.End();
+      w.Key( "unknown" ); w.BeginDocument(); w.Key( "nope" ); w.Int32( 1 ); w.End();
+    w.End();
+    w.Key( "nodes" ); w.BeginDocument();
+      w.Key( "A" ); w.BeginDocument();
+        w.Key( "values" ); w.BeginDocument(); w.Key( "a" ); w.Int32( 1 ); w.Key( "keep" ); w.String( "k" ); w.End();
+        w.Key( "nodes" ); w.BeginDocument();
+          w.Key( "Deep" ); w.BeginDocument();
+            w.Key( "values" ); w.BeginDocument(); w.Key( "z" ); w.String( "zz" ); w.End();
+          w.End();
+        w.End();
+      w.End();
+      w.Key( "Gone" ); w.BeginDocument();
+        w.Key( "values" ); w.BeginDocument(); w.Key( "g" ); w.Int32( 1 ); w.End();
+      w.End();
+      w.Key( "NotANode" ); w.Int32( 5 );
+      w.Key( "A" ); w.BeginDocument();
+        w.Key( "values" ); w.BeginDocument(); w.Key( "a" ); w.Int32( 2 ); w.End();
+      w.End();
+    w.End();
+    w.End();
+    return Bytes;
+}
+
+BOOST_AUTO_TEST_CASE( BSON_hand_built_file_loads_alike_eager_and_lazy )
+{
+    // Eager loads walk the bytes into the tree, lazy ones read the
+    // document the RTL builds of them: both must see the same tree.
+    const auto f = MakeTempPath( L".bson" ); TempFileGuard g( f );
+    WriteBSONFile( f, MakeBSONSource() );
+    for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        Anafestica::BSON::TConfig c(
+            f, /*ReadOnly*/true, false, false, {},
+            Anafestica::BSON::TEncoding::Portable, LoadOptions( Mode )
+        );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"i" ) == -42 );
+        BOOST_TEST( Root.GetItem<int>( L"i64" ) == 7 );
+        BOOST_TEST( Root.GetItem<String>( L"s" ) == String( L"caf\u00e9" ) );
+        BOOST_TEST( Root.GetItem<bool>( L"b" ) == true );
+        BOOST_TEST( Root.GetItem<double>( L"d" ) == 0.5 );
+        BOOST_TEST( Root.GetItem<long long>( L"ll" ) == 5 );
+        BOOST_TEST( Root.GetItem<unsigned int>( L"u" ) == 4000000000u );
+        BOOST_TEST( ( Root.GetItem<Anafestica::StringCont>( L"sv" ) ==
+                      Anafestica::StringCont{ L"a", L"b\n" } ) );
+        BOOST_TEST( !Root.ItemExists( L"n" ) );
+        BOOST_TEST( !Root.ItemExists( L"two" ) );
+        BOOST_TEST( !Root.ItemExists( L"unknown" ) );
+        BOOST_TEST( !Root.ItemExists( L"x" ) );
+        BOOST_TEST( !Root.SubNodeExists( L"NotANode" ) );
+        BOOST_TEST( Root[L"A"].GetItem<int>( L"a" ) == 1 );
+        BOOST_TEST( Root[L"A"][L"Deep"].GetItem<String>( L"z" ) == String( L"zz" ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( BSON_streamed_flush_reads_back_like_the_document_writer )
+{
+    // Eager flushes merge the edits into the file's bytes, lazy ones
+    // rewrite it through the document; either file must read back the
+    // same, whichever way it is read.
+    for ( bool ExplicitTypes : { false, true } ) {
+        for ( auto FlushMode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+            for ( bool HasFile : { true, false } ) {
+                const auto f = MakeTempPath( L".bson" ); TempFileGuard g( f );
+                if ( HasFile ) {
+                    WriteBSONFile( f, MakeBSONSource() );
+                }
+                {
+                    Anafestica::BSON::TConfig c(
+                        f, false, false, ExplicitTypes, {},
+                        Anafestica::BSON::TEncoding::Portable, LoadOptions( FlushMode )
+                    );
+                    auto& Root = c.GetRootNode();
+                    Root.PutItem( L"i", 7 );
+                    Root.DeleteItem( L"b" );
+                    Root.PutItem( L"new", String( L"a/b \"caf\u00e9\"" ) );
+                    Root.PutItem( L"dbl", 2.5 );
+                    Root.PutItem( L"list", Anafestica::StringCont{ L"x", L"y\tz" } );
+                    Root[L"A"].PutItem( L"a", 3 );
+                    Root[L"New"][L"Leaf"].PutItem( L"ll", 1234567890123LL );
+                    Root.DeleteSubNode( L"Gone" );
+                }
+                for ( auto ReadMode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+                    Anafestica::BSON::TConfig c(
+                        f, /*ReadOnly*/true, false, ExplicitTypes, {},
+                        Anafestica::BSON::TEncoding::Portable, LoadOptions( ReadMode )
+                    );
+                    auto& Root = c.GetRootNode();
+                    BOOST_TEST( Root.GetItem<int>( L"i" ) == 7 );
+                    BOOST_TEST( !Root.ItemExists( L"b" ) );
+                    BOOST_TEST( Root.GetItem<String>( L"new" ) == String( L"a/b \"caf\u00e9\"" ) );
+                    BOOST_TEST( Root.GetItem<double>( L"dbl" ) == 2.5 );
+                    BOOST_TEST( ( Root.GetItem<Anafestica::StringCont>( L"list" ) ==
+                                  Anafestica::StringCont{ L"x", L"y\tz" } ) );
+                    BOOST_TEST( Root[L"A"].GetItem<int>( L"a" ) == 3 );
+                    BOOST_TEST( Root[L"New"][L"Leaf"].GetItem<long long>( L"ll" ) == 1234567890123LL );
+                    BOOST_TEST( !Root.SubNodeExists( L"Gone" ) );
+                    if ( HasFile ) {
+                        BOOST_TEST( Root.GetItem<String>( L"s" ) == String( L"caf\u00e9" ) );
+                        BOOST_TEST( Root[L"A"].GetItem<String>( L"keep" ) == String( L"k" ) );
+                        BOOST_TEST( Root[L"A"][L"Deep"].GetItem<String>( L"z" ) == String( L"zz" ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+static std::string ReadBSONFile( String const & Path )
+{
+    auto const Data = TFile::ReadAllBytes( Path );
+    return std::string( reinterpret_cast<char const *>( &Data[0] ), Data.Length );
+}
+
+// The type of the element named Name in the root's "values" document
+// (Undefined when there is none).
+static Anafestica::BSON::Wire::TType FindBSONValue( std::string const & Bytes,
+                                                    std::string_view Name )
+{
+    using namespace Anafestica::BSON::Wire;
+    TCursor Root( Bytes );
+    for ( TElement e ; Root.Next( e ) ; ) {
+        if ( e.Name == "values" && e.IsDocument() ) {
+            TCursor Values( e.GetDocument() );
+            for ( TElement v ; Values.Next( v ) ; ) {
+                if ( v.Name == Name ) {
+                    return v.Type;
+                }
+            }
+        }
+    }
+    return TType::Undefined;
+}
+
+BOOST_AUTO_TEST_CASE( BSON_native_encoding_roundtrip )
+{
+    using Anafestica::BSON::Wire::TType;
+    const auto f = MakeTempPath( L".bson" ); TempFileGuard g( f );
+    auto const Native = Anafestica::BSON::TEncoding::Native;
+    { Anafestica::BSON::TConfig c( f, false, false, false, {}, Native );
+      auto& Root = c.GetRootNode();
+      Root.PutItem( L"i",    kI   );
+      Root.PutItem( L"u",    kU   );
+      Root.PutItem( L"l",    kL   );
+      Root.PutItem( L"ul",   kUL  );
+      Root.PutItem( L"c",    kC   );
+      Root.PutItem( L"uc",   kUC  );
+      Root.PutItem( L"s",    kS   );
+      Root.PutItem( L"us",   kUS  );
+      Root.PutItem( L"ll",   kLL  );
+      Root.PutItem( L"ull",  kULL );
+      Root.PutItem( L"b",    kB   );
+      Root.PutItem( L"sz",   String( kSZ ) );
+      Root.PutItem( L"dt",   kDT() );
+      Root.PutItem( L"flt",  kFLT );
+      Root.PutItem( L"dbl",  kDBL );
+      Root.PutItem( L"cur",  kCUR() );
+      Root.PutItem( L"sv",   MakeSV() );
+      Root.PutItem( L"dab",  MakeDAB() );
+      Root.PutItem( L"vb",   MakeVB() );
+      Root.PutItem( L"str",  kSTR );
+      Root.PutItem( L"wstr", kWSTR );
+      Root.PutItem( L"odd@dab", MakeDAB() );
+      Root[L"Sub"].PutItem( L"x", kLL ); }
+
+    // One BSON type per value type, the tag riding on the name.
+    auto const Bytes = ReadBSONFile( f );
+    BOOST_TEST( ( FindBSONValue( Bytes, "i" ) == TType::Int32 ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "b" ) == TType::Bool ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "sz" ) == TType::String ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "uc@uc" ) == TType::Int32 ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "ll@ll" ) == TType::Int64 ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "ull@ull" ) == TType::Decimal128 ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "cur@cur" ) == TType::Decimal128 ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "dt@dt" ) == TType::DateTime ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "flt@flt" ) == TType::Double ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "sv@sv" ) == TType::Array ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "dab@dab" ) == TType::Binary ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "vb@vb" ) == TType::Binary ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "wstr@wstr" ) == TType::String ) );
+    // A name with an '@' of its own keeps the portable layout.
+    BOOST_TEST( ( FindBSONValue( Bytes, "odd@dab" ) == TType::Document ) );
+
+    Anafestica::BSON::TConfig c( f, /*ReadOnly*/true, false, false, {}, Native );
+    auto& Root = c.GetRootNode();
+    BOOST_TEST( Root.GetItem<int>( L"i" ) == kI );
+    BOOST_TEST( Root.GetItem<unsigned int>( L"u" ) == kU );
+    BOOST_TEST( Root.GetItem<long>( L"l" ) == kL );
+    BOOST_TEST( Root.GetItem<unsigned long>( L"ul" ) == kUL );
+    BOOST_TEST( Root.GetItem<char>( L"c" ) == kC );
+    BOOST_TEST( Root.GetItem<unsigned char>( L"uc" ) == kUC );
+    BOOST_TEST( Root.GetItem<short>( L"s" ) == kS );
+    BOOST_TEST( Root.GetItem<unsigned short>( L"us" ) == kUS );
+    BOOST_TEST( Root.GetItem<long long>( L"ll" ) == kLL );
+    BOOST_TEST( Root.GetItem<unsigned long long>( L"ull" ) == kULL );
+    BOOST_TEST( Root.GetItem<bool>( L"b" ) == kB );
+    BOOST_TEST( Root.GetItem<String>( L"sz" ) == String( kSZ ) );
+    BOOST_TEST( Root.GetItem<System::TDateTime>( L"dt" ) == kDT() );
+    BOOST_TEST( Root.GetItem<float>( L"flt" ) == kFLT );
+    BOOST_TEST( Root.GetItem<double>( L"dbl" ) == kDBL );
+    BOOST_TEST( Root.GetItem<System::Currency>( L"cur" ) == kCUR() );
+    BOOST_TEST( Root.GetItem<StringCont>( L"sv" ) == MakeSV() );
+    BOOST_TEST( DABEqual( Root.GetItem<System::Sysutils::TBytes>( L"dab" ), MakeDAB() ) );
+    BOOST_TEST( Root.GetItem<BytesCont>( L"vb" ) == MakeVB() );
+    BOOST_TEST( Root.GetItem<std::string>( L"str" ) == kSTR );
+    BOOST_CHECK( Root.GetItem<std::wstring>( L"wstr" ) == kWSTR );
+    BOOST_TEST( DABEqual( Root.GetItem<System::Sysutils::TBytes>( L"odd@dab" ), MakeDAB() ) );
+    BOOST_TEST( Root[L"Sub"].GetItem<long long>( L"x" ) == kLL );
+}
+
+BOOST_AUTO_TEST_CASE( BSON_native_object_reads_and_rewrites_a_portable_file )
+{
+    const auto f = MakeTempPath( L".bson" ); TempFileGuard g( f );
+    WriteBSONFile( f, MakeBSONSource() );
+    auto const Before = ReadBSONFile( f ).size();
+    auto const Native = Anafestica::BSON::TEncoding::Native;
+    {
+        Anafestica::BSON::TConfig c( f, false, /*FlushAllItems*/true, false, {}, Native );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"i" ) == -42 );
+        BOOST_TEST( Root.GetItem<double>( L"d" ) == 0.5 );
+        BOOST_TEST( Root.GetItem<long long>( L"ll" ) == 5 );
+        BOOST_TEST( Root[L"A"][L"Deep"].GetItem<String>( L"z" ) == String( L"zz" ) );
+    }
+    // Every value is written back in its native form.
+    auto const Bytes = ReadBSONFile( f );
+    BOOST_TEST( Bytes.size() < Before );
+    BOOST_TEST( ( FindBSONValue( Bytes, "d@dbl" ) == Anafestica::BSON::Wire::TType::Double ) );
+    BOOST_TEST( ( FindBSONValue( Bytes, "d" ) == Anafestica::BSON::Wire::TType::Undefined ) );
+
+    Anafestica::BSON::TConfig c( f, /*ReadOnly*/true, false, false, {}, Native );
+    auto& Root = c.GetRootNode();
+    BOOST_TEST( Root.GetItem<int>( L"i" ) == -42 );
+    BOOST_TEST( Root.GetItem<double>( L"d" ) == 0.5 );
+    BOOST_TEST( Root.GetItem<long long>( L"ll" ) == 5 );
+    BOOST_TEST( ( Root.GetItem<StringCont>( L"sv" ) == StringCont{ L"a", L"b\n" } ) );
+    BOOST_TEST( Root[L"A"].GetItem<String>( L"keep" ) == String( L"k" ) );
+    BOOST_TEST( Root[L"Gone"].GetItem<int>( L"g" ) == 1 );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -1011,6 +1848,20 @@ BOOST_AUTO_TEST_SUITE_END()
 // *** INIFile::TConfig tests ***
 //---------------------------------------------------------------------------
 
+static void WriteFileString( String const & Path, std::string const & Bytes )
+{
+    TBytes Data;
+    Data.Length = static_cast<int>( Bytes.size() );
+    std::copy( Bytes.begin(), Bytes.end(), &Data[0] );
+    TFile::WriteAllBytes( Path, Data );
+}
+
+static std::string ReadFileString( String const & Path )
+{
+    auto const Bytes = TFile::ReadAllBytes( Path );
+    return std::string( std::begin( Bytes ), std::end( Bytes ) );
+}
+
 BOOST_AUTO_TEST_SUITE( TConfig_INIFile )
 
 BOOST_AUTO_TEST_CASE( INIFileCrypt_string_roundtrip )
@@ -1207,7 +2058,6 @@ BOOST_AUTO_TEST_CASE( INIFile_bytevec_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<BytesCont>( L"val" ) == vb );
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 BOOST_AUTO_TEST_CASE( INIFile_stdstring_roundtrip )
 {
     const auto f = MakeTempPath( L".ini" ); TempFileGuard g( f );
@@ -1239,7 +2089,6 @@ BOOST_AUTO_TEST_CASE( INIFile_string_view_write )
     BOOST_CHECK( c.GetRootNode().GetItem<std::wstring>( L"wsv" ) == kWSTR );
 }
 
-#endif
 
 BOOST_AUTO_TEST_CASE( INIFile_enum_roundtrip )
 {
@@ -1260,6 +2109,173 @@ BOOST_AUTO_TEST_CASE( INIFile_subnode_roundtrip )
     BOOST_TEST( c.GetRootNode()[L"Child"][L"GrandChild"].GetItem<int>( L"n" ) == kI );
 }
 
+BOOST_AUTO_TEST_CASE( INIFile_retained_document_flushes_like_a_reloaded_one )
+{
+    auto Open = []( String const& Path, Anafestica::TConfigOptions const& Options ) {
+        return Anafestica::INIFile::TConfig(
+            Path, false, false, {}, Anafestica::INIFile::TLayout::Canonical, Options
+        );
+    };
+    const auto f1 = MakeTempPath( L".ini" ); TempFileGuard g1( f1 );
+    const auto f2 = MakeTempPath( L".ini" ); TempFileGuard g2( f2 );
+    BOOST_TEST(
+        FlushPeriodically( Anafestica::TDocumentMode::Retain, f1, Open ) ==
+        FlushPeriodically( Anafestica::TDocumentMode::Reload, f2, Open )
+    );
+}
+
+BOOST_AUTO_TEST_CASE( INIFile_hand_written_sections_load_and_delete_alike_eager_and_lazy )
+{
+    // Child nodes and deleted subtrees come from the section index: nodes
+    // without a section of their own, empty path components and sections
+    // outside [config] must be read as the prefix scan read them.
+    const auto f = MakeTempPath( L".ini" ); TempFileGuard g( f );
+    for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        auto const Options = LoadOptions( Mode );
+        TFile::WriteAllText(
+            f,
+            L"[config]\r\nr::(i)=1\r\n"
+            L"[config\\A\\B]\r\nb::(i)=2\r\n"
+            L"[config\\A\\B\\C]\r\nc::(i)=3\r\n"
+            L"[config\\D\\]\r\nd::(i)=4\r\n"
+            L"[config\\\\E]\r\ne::(i)=5\r\n"
+            L"[other\\F]\r\nf::(i)=6\r\n"
+            L"[configG]\r\ng::(i)=7\r\n",
+            TEncoding::UTF8
+        );
+        {
+            Anafestica::INIFile::TConfig c(
+                f, false, false, {}, Anafestica::INIFile::TLayout::Canonical, Options
+            );
+            auto& Root = c.GetRootNode();
+            BOOST_TEST( Root.GetItem<int>( L"r" ) == 1 );
+            BOOST_TEST( Root[L"A"][L"B"].GetItem<int>( L"b" ) == 2 );
+            BOOST_TEST( Root[L"A"][L"B"][L"C"].GetItem<int>( L"c" ) == 3 );
+            BOOST_TEST( Root.SubNodeExists( L"D" ) );
+            BOOST_TEST( !Root[L"D"].ItemExists( L"d" ) );
+            BOOST_TEST( !Root.SubNodeExists( L"E" ) );
+            BOOST_TEST( !Root.SubNodeExists( L"F" ) );
+            BOOST_TEST( !Root.SubNodeExists( L"G" ) );
+            Root.DeleteSubNode( L"A" );
+            Root[L"H"].PutItem( L"h", 8 );
+        }
+        BOOST_TEST( !FileContainsAscii( f, "config\\A" ) );
+        Anafestica::INIFile::TConfig c(
+            f, /*ReadOnly*/true, false, {}, Anafestica::INIFile::TLayout::Canonical, Options
+        );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( !Root.SubNodeExists( L"A" ) );
+        BOOST_TEST( Root[L"H"].GetItem<int>( L"h" ) == 8 );
+        BOOST_TEST( Root.GetItem<int>( L"r" ) == 1 );
+        BOOST_TEST( Root.SubNodeExists( L"D" ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( INIFile_hand_written_file_flushes_in_the_TMemIniFile_layout )
+{
+    // As TMemIniFile read and wrote it: comments, empty lines and lines
+    // ahead of the first section dropped, spaces around '=' trimmed, lines
+    // without '=' kept, names matched regardless of ASCII case with the
+    // first duplicate winning; UTF-8 with a byte order mark, CR LF, an
+    // empty line after each section.
+    const auto f = MakeTempPath( L".ini" ); TempFileGuard g( f );
+    std::string const Source =
+        "; comment\n"
+        "orphan::(i)=0\n"
+        "[config]\r"
+        "  port::(i) = 5432  \r\n"
+        "PORT::(i)=1\n"
+        "loose line\n"
+        "\n"
+        "host::(sz)=caf\xC3\xA9\r\n"
+        "[config\\A]\r\n"
+        "x::(i)=1\r\n"
+        "[CONFIG\\a]\r\n"
+        "z::(i)=9";
+    std::string const Expected =
+        "\xEF\xBB\xBF"
+        "[config]\r\n"
+        "port::(i)=5432\r\n"
+        "PORT::(i)=1\r\n"
+        "loose line\r\n"
+        "host::(sz)=h\xC3\xB4te\r\n"
+        "\r\n"
+        "[config\\A]\r\n"
+        "x::(i)=1\r\n"
+        "y::(i)=2\r\n"
+        "\r\n"
+        "[CONFIG\\a]\r\n"
+        "z::(i)=9\r\n"
+        "\r\n";
+    for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        WriteFileString( f, Source );
+        {
+            Anafestica::INIFile::TConfig c(
+                f, false, false, {}, Anafestica::INIFile::TLayout::Canonical, LoadOptions( Mode )
+            );
+            auto& Root = c.GetRootNode();
+            BOOST_TEST( Root.GetItem<int>( L"port" ) == 5432 );
+            BOOST_TEST( Root.GetItem<int>( L"PORT" ) == 5432 );
+            BOOST_TEST( Root.GetItem<String>( L"host" ) == String( L"caf\u00e9" ) );
+            BOOST_TEST( !Root.ItemExists( L"orphan" ) );
+            BOOST_TEST( Root[L"A"].GetItem<int>( L"x" ) == 1 );
+            BOOST_TEST( !Root[L"A"].ItemExists( L"z" ) );
+            Root.PutItem( L"host", String( L"h\u00f4te" ) );
+            Root[L"A"].PutItem( L"y", 2 );
+        }
+        BOOST_TEST( ReadFileString( f ) == Expected );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( INIFile_preserve_layout_patches_only_the_changed_lines )
+{
+    // Comments, spacing, LF line ends and the missing byte order mark
+    // stay; the changed value is patched in place, the erased one removed,
+    // the new one inserted after its section's last line, the new section
+    // appended after an empty line.
+    const auto f = MakeTempPath( L".ini" ); TempFileGuard g( f );
+    std::string const Source =
+        "; edited by hand\n"
+        "[config]\n"
+        "  port::(i) = 5432\n"
+        "; the host\n"
+        "host::(sz)=localhost\n"
+        "debug::(b)=True\n"
+        "\n"
+        "[config\\A]\n"
+        "x::(i)=1\n";
+    std::string const Expected =
+        "; edited by hand\n"
+        "[config]\n"
+        "  port::(i) = 5433\n"
+        "; the host\n"
+        "host::(sz)=localhost\n"
+        "\n"
+        "[config\\A]\n"
+        "x::(i)=1\n"
+        "y::(i)=2\n"
+        "\n"
+        "[config\\B]\n"
+        "z::(i)=3\n"
+        "\n";
+    for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        WriteFileString( f, Source );
+        {
+            Anafestica::INIFile::TConfig c(
+                f, false, false, {}, Anafestica::INIFile::TLayout::Preserve, LoadOptions( Mode )
+            );
+            auto& Root = c.GetRootNode();
+            BOOST_TEST( Root.GetItem<int>( L"port" ) == 5432 );
+            BOOST_TEST( Root.GetItem<bool>( L"debug" ) );
+            Root.PutItem( L"port", 5433 );
+            Root.DeleteItem( L"debug" );
+            Root[L"A"].PutItem( L"y", 2 );
+            Root[L"B"].PutItem( L"z", 3 );
+        }
+        BOOST_TEST( ReadFileString( f ) == Expected );
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //---------------------------------------------------------------------------
@@ -1462,7 +2478,6 @@ BOOST_AUTO_TEST_CASE( XML_bytevec_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<BytesCont>( L"val" ) == vb );
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 BOOST_AUTO_TEST_CASE( XML_stdstring_roundtrip )
 {
     const auto f = MakeTempPath( L".xml" ); TempFileGuard g( f );
@@ -1494,7 +2509,6 @@ BOOST_AUTO_TEST_CASE( XML_string_view_write )
     BOOST_CHECK( c.GetRootNode().GetItem<std::wstring>( L"wsv" ) == kWSTR );
 }
 
-#endif
 
 BOOST_AUTO_TEST_CASE( XML_enum_roundtrip )
 {
@@ -1515,6 +2529,153 @@ BOOST_AUTO_TEST_CASE( XML_subnode_roundtrip )
     BOOST_TEST( c.GetRootNode()[L"Child"][L"GrandChild"].GetItem<int>( L"n" ) == kI );
 }
 
+// The document kept in memory and the one parsed back may differ in
+// whitespace nodes, so only the contents are compared here.
+BOOST_AUTO_TEST_CASE( XML_retained_document_picks_up_external_changes )
+{
+    const auto f = MakeTempPath( L".xml" ); TempFileGuard g( f );
+    FlushPeriodically(
+        Anafestica::TDocumentMode::Retain, f,
+        []( String const& Path, Anafestica::TConfigOptions const& Options ) {
+            return Anafestica::XML::TConfig( Path, false, false, {}, Options );
+        }
+    );
+}
+
+BOOST_AUTO_TEST_CASE( XML_hand_written_file_loads_alike_eager_and_lazy )
+{
+    // Eager loads pull the file into the tree, lazy ones read the DOM:
+    // both must see the same tree.  Written as UTF-8 with a BOM.
+    const auto f = MakeTempPath( L".xml" ); TempFileGuard g( f );
+    TFile::WriteAllText(
+        f,
+        L"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        L"<!-- written by hand -->\n"
+        L"<application>\n"
+        L"  <junk><values><value name=\"x\" type=\"i\">1</value></values></junk>\n"
+        L"  <config>\n"
+        L"    <values>\n"
+        L"      <value name=\"i\" type=\"i\">-42</value>\n"
+        L"      <value name=\"s\" type=\"sz\">caf\u00e9 &lt;&amp;&gt; &#x41;&#66;</value>\n"
+        L"      <value name=\"c\" type=\"sz\"><![CDATA[<not markup> & ]]></value>\n"
+        L"      <value name=\"e\" type=\"sz\"/>\n"
+        L"      <value name=\"sv\" type=\"sv\">a\nb</value>\n"
+        L"      <value name=\"two\" type=\"i\">1</value>\n"
+        L"      <value name=\"two\" type=\"i\">2</value>\n"
+        L"      <value name=\"q&quot;\" type=\"b\">true</value>\n"
+        L"      <value name=\"unknown\" type=\"nope\">1</value>\n"
+        L"      <value name=\"untyped\">1</value>\n"
+        L"      <?ignored instruction?>\n"
+        L"    </values>\n"
+        L"    <values><value name=\"late\" type=\"i\">1</value></values>\n"
+        L"    <nodes>\n"
+        L"      <node name=\"A\">\n"
+        L"        <values><value name=\"a\" type=\"i\">1</value></values>\n"
+        L"        <nodes><node name=\"Deep\"><values>"
+        L"<value name=\"z\" type=\"sz\">zz</value></values></node></nodes>\n"
+        L"      </node>\n"
+        L"      <node>no name</node>\n"
+        L"      <other name=\"NotANode\"/>\n"
+        L"      <node name=\"A\"><values><value name=\"a\" type=\"i\">2</value></values></node>\n"
+        L"    </nodes>\n"
+        L"  </config>\n"
+        L"</application>\n",
+        TEncoding::UTF8
+    );
+    for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+        Anafestica::XML::TConfig c( f, /*ReadOnly*/true, false, {}, LoadOptions( Mode ) );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"i" ) == -42 );
+        BOOST_TEST( Root.GetItem<String>( L"s" ) == String( L"caf\u00e9 <&> AB" ) );
+        BOOST_TEST( Root.GetItem<String>( L"c" ) == String( L"<not markup> & " ) );
+        BOOST_TEST( Root.GetItem<String>( L"e" ).IsEmpty() );
+        BOOST_TEST( ( Root.GetItem<Anafestica::StringCont>( L"sv" ) ==
+                      Anafestica::StringCont{ L"a", L"b" } ) );
+        BOOST_TEST( Root.GetItem<int>( L"two" ) == 2 );
+        BOOST_TEST( Root.GetItem<bool>( L"q\"" ) == true );
+        BOOST_TEST( !Root.ItemExists( L"unknown" ) );
+        BOOST_TEST( !Root.ItemExists( L"untyped" ) );
+        BOOST_TEST( !Root.ItemExists( L"late" ) );
+        BOOST_TEST( !Root.ItemExists( L"x" ) );
+        BOOST_TEST( !Root.SubNodeExists( L"NotANode" ) );
+        BOOST_TEST( Root[L"A"].GetItem<int>( L"a" ) == 1 );
+        BOOST_TEST( Root[L"A"][L"Deep"].GetItem<String>( L"z" ) == String( L"zz" ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( XML_wide_node_flush_roundtrip )
+{
+    // The writer finds siblings through a name index: many values and
+    // children in one node, erased and deleted in a second flush, and a
+    // duplicate value name, whose last element is the one erased.
+    const auto f = MakeTempPath( L".xml" ); TempFileGuard g( f );
+    constexpr int Count = 2000;
+    TFile::WriteAllText(
+        f,
+        L"<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        L"<application><config><values>"
+        L"<value name=\"dup\" type=\"i\">1</value>"
+        L"<value name=\"dup\" type=\"i\">2</value>"
+        L"</values></config></application>\n",
+        TEncoding::UTF8
+    );
+    {
+        Anafestica::XML::TConfig c( f );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"dup" ) == 2 );
+        Root.DeleteItem( L"dup" );
+        for ( int Idx = 0 ; Idx < Count ; ++Idx ) {
+            Root.PutItem( Format( _D( "v%d" ), ARRAYOFCONST(( Idx )) ), Idx );
+            Root[Format( _D( "n%d" ), ARRAYOFCONST(( Idx )) )].PutItem( L"i", Idx );
+        }
+    }
+    {
+        Anafestica::XML::TConfig c( f );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"dup" ) == 1 );
+        for ( int Idx = 0 ; Idx < Count ; Idx += 2 ) {
+            Root.DeleteItem( Format( _D( "v%d" ), ARRAYOFCONST(( Idx )) ) );
+            Root.DeleteSubNode( Format( _D( "n%d" ), ARRAYOFCONST(( Idx )) ) );
+        }
+    }
+    Anafestica::XML::TConfig c( f );
+    auto& Root = c.GetRootNode();
+    for ( int Idx = 0 ; Idx < Count ; ++Idx ) {
+        auto const Value = Format( _D( "v%d" ), ARRAYOFCONST(( Idx )) );
+        auto const Node = Format( _D( "n%d" ), ARRAYOFCONST(( Idx )) );
+        if ( Idx % 2 ) {
+            BOOST_TEST( Root.GetItem<int>( Value ) == Idx );
+            BOOST_TEST( Root[Node].GetItem<int>( L"i" ) == Idx );
+        }
+        else {
+            BOOST_TEST( !Root.ItemExists( Value ) );
+            BOOST_TEST( !Root.SubNodeExists( Node ) );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( XML_dtd_is_rejected_eager_and_lazy )
+{
+    // The pull parser rejects a DTD on its single pass as the DOM path
+    // rejected it before parsing: anywhere in the text, comments included.
+    const auto f = MakeTempPath( L".xml" ); TempFileGuard g( f );
+    for ( auto Text : {
+            L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            L"<!DOCTYPE application [ <!ENTITY lol \"lol\"> ]>\n"
+            L"<application><config/></application>\n",
+            L"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            L"<application><config><!-- <!ENTITY x \"y\"> --></config></application>\n" } )
+    {
+        TFile::WriteAllText( f, Text, TEncoding::UTF8 );
+        for ( auto Mode : { Anafestica::TLoadMode::Eager, Anafestica::TLoadMode::Lazy } ) {
+            BOOST_CHECK_THROW(
+                Anafestica::XML::TConfig( f, /*ReadOnly*/true, false, {}, LoadOptions( Mode ) ),
+                EXMLDocError
+            );
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 #endif
@@ -1523,8 +2684,6 @@ BOOST_AUTO_TEST_SUITE_END()
 // *** YAML::TConfig tests ***
 // Optional: compiled only when ANAFESTICA_TEST_YAML is defined and fkYAML is
 // visible in the active toolchain include path.
-// std::string / std::wstring / string_view tests apply on bcc64x only
-// (those alternatives are not present in the boost::variant configuration).
 //---------------------------------------------------------------------------
 
 #if defined( ANAFESTICA_TEST_YAML_AVAILABLE )
@@ -1722,7 +2881,6 @@ BOOST_AUTO_TEST_CASE( YAML_bytevec_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<BytesCont>( L"val" ) == vb );
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
 BOOST_AUTO_TEST_CASE( YAML_stdstring_roundtrip )
 {
     const auto f = MakeTempPath( L".yaml" ); TempFileGuard g( f );
@@ -1753,7 +2911,6 @@ BOOST_AUTO_TEST_CASE( YAML_string_view_write )
     BOOST_TEST( c.GetRootNode().GetItem<std::string> ( L"sv"  ) == kSTR  );
     BOOST_CHECK( c.GetRootNode().GetItem<std::wstring>( L"wsv" ) == kWSTR );
 }
-#endif
 
 BOOST_AUTO_TEST_CASE( YAML_enum_roundtrip )
 {
@@ -1789,6 +2946,94 @@ BOOST_AUTO_TEST_CASE( YAML_explicit_types_roundtrip )
     BOOST_TEST( c.GetRootNode().GetItem<String>( L"sz" ) == String( kSZ ) );
 }
 
+BOOST_AUTO_TEST_CASE( YAML_hand_written_file_loads_alike_streamed_and_through_fkYAML )
+{
+    // Loads stream the file into the tree unless it holds something the
+    // streaming reader leaves to fkYAML, like the anchor in the second
+    // variant: both must see the same tree.
+    String const Body =
+        L"values:\n"
+        L"  i: -42\n"
+        L"  s: \"caf\u00e9 \\\"q\\\" \\U0001F600\"\n"
+        L"  q: 'it''s'\n"
+        L"  p: plain text  # comment\n"
+        L"  b: true\n"
+        L"  n: ~\n"
+        L"  d: {dbl: \"0.5\"}\n"
+        L"  sv:\n"
+        L"    sv: [a, \"b\\n\"]\n"
+        L"  two: {i: 1, sz: x}\n"
+        L"  unknown:\n"
+        L"    nope: 1\n"
+        L"nodes:\n"
+        L"  A:\n"
+        L"    values:\n"
+        L"      a: 1\n"
+        L"    nodes:\n"
+        L"      Deep:\n"
+        L"        values: {z: zz}\n"
+        L"  NotANode: 5\n";
+    for ( String const Junk : { L"junk: {values: {x: 1}}\n", L"junk: &j {values: {x: 1}}\n" } ) {
+        const auto f = MakeTempPath( L".yaml" ); TempFileGuard g( f );
+        TFile::WriteAllText(
+            f, String( L"# hand-written\n---\n" ) + Junk + Body, TEncoding::UTF8
+        );
+        Anafestica::YAML::TConfig c( f, /*ReadOnly*/true );
+        auto& Root = c.GetRootNode();
+        BOOST_TEST( Root.GetItem<int>( L"i" ) == -42 );
+        BOOST_TEST( Root.GetItem<String>( L"s" ) ==
+                    String( L"caf\u00e9 \"q\" \U0001F600" ) );
+        BOOST_TEST( Root.GetItem<String>( L"q" ) == String( L"it's" ) );
+        BOOST_TEST( Root.GetItem<String>( L"p" ) == String( L"plain text" ) );
+        BOOST_TEST( Root.GetItem<bool>( L"b" ) == true );
+        BOOST_TEST( Root.GetItem<double>( L"d" ) == 0.5 );
+        BOOST_TEST( ( Root.GetItem<Anafestica::StringCont>( L"sv" ) ==
+                      Anafestica::StringCont{ L"a", L"b\n" } ) );
+        BOOST_TEST( !Root.ItemExists( L"n" ) );
+        BOOST_TEST( !Root.ItemExists( L"two" ) );
+        BOOST_TEST( !Root.ItemExists( L"unknown" ) );
+        BOOST_TEST( !Root.ItemExists( L"x" ) );
+        BOOST_TEST( !Root.SubNodeExists( L"NotANode" ) );
+        BOOST_TEST( Root[L"A"].GetItem<int>( L"a" ) == 1 );
+        BOOST_TEST( Root[L"A"][L"Deep"].GetItem<String>( L"z" ) == String( L"zz" ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( YAML_strings_needing_quotes_roundtrip )
+{
+    // The flush writes strings plain only when they read back as the same
+    // string; the rest, names included, are quoted and escaped.  A node
+    // without values anywhere below is left out of the file.
+    String const Texts[] = {
+        L"plain", L"", L"123", L"0x1F", L"1.5", L"true", L"null", L"~",
+        L"a: b", L"a #b", L"a#b", L" lead", L"trail ", L"x:", L"-x", L"<<",
+        L"tab\there", L"line\nbreak", L"q\"\\", L"caf\u00e9", L"c1\u0085",
+        L"sep\u2028", L"\ufeffbom", L"\U0001F600"
+    };
+    const auto f = MakeTempPath( L".yaml" ); TempFileGuard g( f );
+    {
+        Anafestica::YAML::TConfig c( f );
+        auto& Root = c.GetRootNode();
+        for ( auto const & Text : Texts ) {
+            Root[L"Names"].PutItem( String( L"k" ) + Text, Text );
+            Root[L"Path"][Text + L"!"][L"Leaf"].PutItem( L"v", Text );
+        }
+        Root.PutItem(
+            L"list", Anafestica::StringCont( std::begin( Texts ), std::end( Texts ) )
+        );
+        Root[L"Empty"][L"Inner"];
+    }
+    Anafestica::YAML::TConfig c( f );
+    auto& Root = c.GetRootNode();
+    for ( auto const & Text : Texts ) {
+        BOOST_TEST( Root[L"Names"].GetItem<String>( String( L"k" ) + Text ) == Text );
+        BOOST_TEST( Root[L"Path"][Text + L"!"][L"Leaf"].GetItem<String>( L"v" ) == Text );
+    }
+    BOOST_TEST( ( Root.GetItem<Anafestica::StringCont>( L"list" ) ==
+                  Anafestica::StringCont( std::begin( Texts ), std::end( Texts ) ) ) );
+    BOOST_TEST( !Root.SubNodeExists( L"Empty" ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
 
@@ -1,7 +1,6 @@
 //---------------------------------------------------------------------------
-// Simplified TConfig roundtrip tests for the 19-type subset shared by all
-// three toolchains. The std::variant-only std::string/std::wstring coverage
-// remains in test_config.cpp.
+// Simplified TConfig roundtrip tests for the 19 alternatives other than
+// std::string / std::wstring. Coverage for those two is in test_config.cpp.
 //---------------------------------------------------------------------------
 
 #pragma hdrstop
@@ -66,7 +65,7 @@ bool DABEqual( System::Sysutils::TBytes const& a,
     return true;
 }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
+#if defined( _WIN64 ) && __clang_major__ >= 15
 const String RegCfgRoot = L"Software\\Anafestica\\TestBcc64x\\ConfigSimplified";
 #elif defined( _WIN64 )
 const String RegCfgRoot = L"Software\\Anafestica\\TestBcc64\\Config";
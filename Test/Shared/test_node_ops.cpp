@@ -4,7 +4,13 @@
 // Covers members of TConfigNode that were previously untested:
 //   DeleteItem, DeleteSubNode, ItemExists, SubNodeExists,
 //   GetNodeCount, GetValueCount, EnumerateNodes, EnumerateValueNames,
-//   EnumerateValues, IsDeleted, IsModified, Clear.
+//   EnumerateValues, IsDeleted, IsModified, Clear, interned key atoms
+//   (ANA_KEY), the property macros, arena-backed nodes, incremental
+//   change tracking, generation counters, lazy loading (ReadLazy,
+//   Prefetch, TConfigOptions::LoadMode), the non-inserting read API (FindValue,
+//   Find, TryGet, Values, Nodes), the move-aware PutItem path, the
+//   copy-on-write value cell, the type-tag table and codec registry, and
+//   the node cursor protocol (EnterNode / LeaveNode, TNodeCursor).
 //
 // Plus round-trip tests for each backend verifying that DeleteItem /
 // DeleteSubNode cause the affected names to disappear from storage.
@@ -18,14 +24,21 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <cstdlib>
 #include <iterator>
 #include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include <windows.h>
 #include <objbase.h>
 
 #include <anafestica/CfgItems.h>
+#include <anafestica/CfgCodec.h>
+#include <anafestica/CfgNodeCursor.h>
 #include <anafestica/CfgRegistry.h>
 #include <anafestica/CfgJSON.h>
 #include <anafestica/CfgBSON.h>
@@ -122,8 +135,144 @@ struct DeepChainReader {
     }
 };
 
+// Three-level tree (children "A" and "B" below every node down to depth 3,
+// one "Depth" value per node) that counts how many nodes were read.
+struct LazyTreeReader : Anafestica::TConfigNodeLoader {
+    int ValueLists {};
+    int Loads {};
+
+    Anafestica::ValueContType CreateValueList( Anafestica::TConfigPath const & Path ) {
+        ++ValueLists;
+        Anafestica::ValueContType Values;
+        Values[L"Depth"] =
+            Anafestica::ValuePairType(
+                static_cast<int>( Path.size() ), Anafestica::Operation::None
+            );
+        return Values;
+    }
+
+    Anafestica::NodeContType CreateNodeList( Anafestica::TConfigPath const & Path ) {
+        Anafestica::NodeContType Nodes;
+        if ( Path.size() < 3 ) {
+            Nodes[L"A"] = std::make_unique<Anafestica::TConfigNode>();
+            Nodes[L"B"] = std::make_unique<Anafestica::TConfigNode>();
+        }
+        return Nodes;
+    }
+
+    void LoadNode( TConfigNode& Node, Anafestica::TConfigPath const & Path,
+                   std::size_t Levels ) override {
+        ++Loads;
+        Node.ReadLazy( *this, *this, Path, Levels );
+    }
+};
+
+struct RecordingWriter {
+    std::vector<String> Saved;
+    std::vector<String> Deleted;
+
+    static String Join( Anafestica::TConfigPath const & Path ) {
+        String s;
+        for ( auto const & Item : Path ) { s += L"/"; s += Item; }
+        return s;
+    }
+
+    bool GetAlwaysFlushNodeFlag() const noexcept { return false; }
+    void DeleteNode( Anafestica::TConfigPath const & Path ) {
+        Deleted.push_back( Join( Path ) );
+    }
+    void SaveValueList( Anafestica::TConfigPath const & Path,
+                        Anafestica::ValueContType const & ) {
+        Saved.push_back( Join( Path ) );
+    }
+};
+
+// Two-level tree read and written through the node cursor protocol.
+// Counts the hook calls whose Path differs from the cursor position.
+struct CursorTreeStorage {
+    Anafestica::TConfigPath Cursor;
+    int Enters {};
+    int Mismatches {};
+    std::vector<String> Saved;
+
+    void EnterNode( String const & Name ) { ++Enters; Cursor.push_back( Name ); }
+    void LeaveNode() { Cursor.pop_back(); }
+
+    void Check( Anafestica::TConfigPath const & Path ) {
+        if ( Path != Cursor ) { ++Mismatches; }
+    }
+
+    Anafestica::ValueContType CreateValueList( Anafestica::TConfigPath const & Path ) {
+        Check( Path );
+        return {};
+    }
+
+    Anafestica::NodeContType CreateNodeList( Anafestica::TConfigPath const & Path ) {
+        Check( Path );
+        Anafestica::NodeContType Nodes;
+        if ( Path.size() < 2 ) {
+            Nodes[L"A"] = std::make_unique<Anafestica::TConfigNode>();
+            Nodes[L"B"] = std::make_unique<Anafestica::TConfigNode>();
+        }
+        return Nodes;
+    }
+
+    bool GetAlwaysFlushNodeFlag() const noexcept { return true; }
+    void DeleteNode( Anafestica::TConfigPath const & Path ) { Check( Path ); }
+    void SaveValueList( Anafestica::TConfigPath const & Path,
+                        Anafestica::ValueContType const & ) {
+        Check( Path );
+        Saved.push_back( RecordingWriter::Join( Path ) );
+    }
+};
+
+// Two children "A" and "B" below the root, each with one value, built in
+// an arena the way a backend's DoCreate* hooks build them.
+struct ArenaTreeReader {
+    Anafestica::TConfigArena* Arena;
+
+    Anafestica::ValueContType CreateValueList( Anafestica::TConfigPath const & ) {
+        Anafestica::ValueContType Values( Arena );
+        Values[L"Loaded"] =
+            Anafestica::ValuePairType( 1, Anafestica::Operation::None );
+        return Values;
+    }
+
+    Anafestica::NodeContType CreateNodeList( Anafestica::TConfigPath const & Path ) {
+        Anafestica::NodeContType Nodes( Arena );
+        if ( Path.empty() ) {
+            Nodes[L"A"] = Anafestica::MakeConfigNode( Arena );
+            Nodes[L"B"] = Anafestica::MakeConfigNode( Arena );
+        }
+        return Nodes;
+    }
+};
+
+// Heap allocations made through the global operator new (see below).
+std::size_t NodeOpsAllocCount = 0;
+
 } // namespace
 
+// Counting replacement of the global allocation functions, so tests can
+// assert how many heap blocks an operation takes.  Forwards to malloc /
+// free, which is what the RTL's own operator new does.
+void* operator new( std::size_t Size )
+{
+    ++NodeOpsAllocCount;
+    if ( auto p = std::malloc( Size ? Size : 1 ) ) { return p; }
+    throw std::bad_alloc{};
+}
+
+void operator delete( void* Ptr ) noexcept
+{
+    std::free( Ptr );
+}
+
+void operator delete( void* Ptr, std::size_t ) noexcept
+{
+    std::free( Ptr );
+}
+
 //---------------------------------------------------------------------------
 // *** In-memory TConfigNode operations ***
 //---------------------------------------------------------------------------
@@ -314,6 +463,676 @@ BOOST_AUTO_TEST_CASE( IsModified_reacts_to_every_mutation )
     }
 }
 
+BOOST_AUTO_TEST_CASE( Modification_propagates_only_along_the_parent_chain )
+{
+    TConfigNode root;
+    auto& a = root[L"a"];
+    auto& b = root[L"b"];
+    auto& deep = a[L"x"][L"y"];
+
+    deep.PutItem( L"v", 1, Anafestica::Operation::None );
+    BOOST_TEST( !root.IsModified() );
+
+    deep.PutItem( L"v", 1 );                // same value: no change
+    BOOST_TEST( !root.IsModified() );
+
+    deep.PutItem( L"v", 2 );
+    BOOST_TEST( deep.IsModified() );
+    BOOST_TEST( a[L"x"].IsModified() );
+    BOOST_TEST( a.IsModified() );
+    BOOST_TEST( root.IsModified() );
+    BOOST_TEST( !b.IsModified() );
+}
+
+BOOST_AUTO_TEST_CASE( GetValueCount_tracks_every_mutation )
+{
+    TConfigNode n;
+    n.PutItem( L"a", 1 );
+    n.PutItem( L"b", 2 );
+    (void)n.GetItem<int>( L"c" );           // inserting read counts too
+    BOOST_TEST( n.GetValueCount() == 3u );
+
+    n.DeleteItem( L"a" );
+    n.DeleteItem( L"a" );                   // second delete is a no-op
+    BOOST_TEST( n.GetValueCount() == 2u );
+
+    n.PutItem( L"a", 5 );                   // revives the erased entry
+    BOOST_TEST( n.GetValueCount() == 3u );
+
+    n.Clear();
+    BOOST_TEST( n.GetValueCount() == 0u );
+}
+
+BOOST_AUTO_TEST_CASE( Generation_advances_for_changed_subtrees_only )
+{
+    TConfigNode root;
+    auto& a = root[L"a"];
+    auto& b = root[L"b"];
+    a.PutItem( L"v", 1 );
+
+    auto const RootGen = root.GetGeneration();
+    auto const AGen = a.GetGeneration();
+    auto const BGen = b.GetGeneration();
+
+    (void)a.GetItem<int>( L"v" );           // existing key: no change
+    a.PutItem( L"v", 1 );                   // same value: no change
+    BOOST_TEST( root.GetGeneration() == RootGen );
+    BOOST_TEST( a.GetGeneration() == AGen );
+
+    a.PutItem( L"v", 2 );
+    BOOST_TEST( a.GetGeneration() > AGen );
+    BOOST_TEST( root.GetGeneration() > RootGen );
+    BOOST_TEST( b.GetGeneration() == BGen );
+
+    auto const RootGen2 = root.GetGeneration();
+    (void)b.GetSubNode( L"child" );         // new child
+    BOOST_TEST( b.GetGeneration() > BGen );
+    BOOST_TEST( root.GetGeneration() > RootGen2 );
+
+    auto const AGen2 = a.GetGeneration();
+    root.DeleteSubNode( L"a" );
+    BOOST_TEST( a.GetGeneration() > AGen2 );
+}
+
+BOOST_AUTO_TEST_CASE( Lookups_accept_wide_literals_views_and_strings )
+{
+    TConfigNode n;
+    n.PutItem( L"Left", 10 );
+    auto& c = n.GetSubNode( std::wstring_view( L"Child" ) );
+
+    String const leftStr( L"Left" );
+    std::wstring const leftStd( L"Left" );
+
+    BOOST_TEST( n.ItemExists( L"Left" ) );
+    BOOST_TEST( n.ItemExists( leftStr ) );
+    BOOST_TEST( n.ItemExists( leftStd ) );
+    BOOST_TEST( n.ItemExists( std::wstring_view( L"LeftX", 4 ) ) );
+    BOOST_TEST( !n.ItemExists( std::wstring_view( L"Lef" ) ) );
+    BOOST_TEST( n.SubNodeExists( String( L"Child" ) ) );
+    BOOST_TEST( &n.GetSubNode( L"Child" ) == &c );
+    BOOST_TEST( n.GetNodeCount() == 1u );
+}
+
+BOOST_AUTO_TEST_CASE( Enumeration_order_is_ordinal )
+{
+    // The containers keep keys in code-unit order regardless of the
+    // insertion order, which is what every backend relies on when it
+    // writes values and sub-nodes out.
+    TConfigNode n;
+    for ( auto Id : { L"b", L"a", L"B", L"ab", L"_", L"A" } ) {
+        n.PutItem( Id, 1 );
+        (void)n.GetSubNode( Id );
+    }
+
+    std::vector<String> values;
+    n.EnumerateValueNames( std::back_inserter( values ) );
+    std::vector<String> nodes;
+    n.EnumerateNodes( std::back_inserter( nodes ) );
+
+    std::vector<String> const expected {
+        L"A", L"B", L"_", L"a", L"ab", L"b"
+    };
+    BOOST_TEST( values == expected, boost::test_tools::per_element() );
+    BOOST_TEST( nodes == expected, boost::test_tools::per_element() );
+}
+
+BOOST_AUTO_TEST_CASE( Key_atoms_are_interned_and_interchangeable_with_strings )
+{
+    using Anafestica::TKeyAtom;
+
+    auto const & Left = ANA_KEY( "Left" );
+    BOOST_TEST( &Left == &ANA_KEY( "Left" ) );
+    BOOST_TEST( Left == ANA_KEY( L"Left" ) );
+    BOOST_TEST( Left == TKeyAtom( std::wstring_view( L"Left" ) ) );
+    BOOST_TEST( Left != ANA_KEY( "Top" ) );
+    BOOST_TEST( Left.Str() == String( L"Left" ) );
+
+    TConfigNode n;
+    BOOST_TEST( n.PutItem( Left, 10 ) );
+    BOOST_TEST( n.ItemExists( L"Left" ) );
+    BOOST_TEST( n.GetItem<int>( String( L"Left" ) ) == 10 );
+    BOOST_TEST( !n.PutItem( String( L"Left" ), 11 ) );
+    BOOST_TEST( n.GetItem<int>( Left ) == 11 );
+
+    // A key put with a String takes the atom's buffer once the atom has
+    // found it, so that later searches match it by address.
+    TConfigNode m;
+    m.PutItem( String( L"Left" ), 1 );
+    std::vector<String> Names;
+    m.EnumerateValueNames( std::back_inserter( Names ) );
+    BOOST_TEST( Names.front().c_str() != Left.Str().c_str() );
+    BOOST_TEST( m.GetItem<int>( Left ) == 1 );
+    Names.clear();
+    m.EnumerateValueNames( std::back_inserter( Names ) );
+    BOOST_TEST( Names.front().c_str() == Left.Str().c_str() );
+
+    n.DeleteItem( Left );
+    BOOST_TEST( n.GetValueCount() == 0u );
+}
+
+BOOST_AUTO_TEST_CASE( Property_macros_use_the_property_text_as_key )
+{
+    struct { int Left { 7 }; int Width { 3 }; } Form;
+
+    TConfigNode n;
+    SAVE_PROPERTY( n, Form.Left );
+    SAVE_ID_PROPERTY( n, Width, Form.Width );
+    BOOST_TEST( n.ItemExists( L"Form.Left" ) );
+    BOOST_TEST( n.ItemExists( ANA_KEY( "Width" ) ) );
+
+    Form.Left = 0;
+    Form.Width = 0;
+    RESTORE_PROPERTY( n, Form.Left );
+    RESTORE_ID_PROPERTY( n, Width, Form.Width );
+    BOOST_TEST( Form.Left == 7 );
+    BOOST_TEST( Form.Width == 3 );
+}
+
+BOOST_AUTO_TEST_CASE( Arena_backed_nodes_allocate_children_from_the_same_arena )
+{
+    Anafestica::TConfigArena Arena;
+    {
+        TConfigNode root( &Arena );
+        auto& a = root[L"a"];
+        auto& b = a[L"b"];
+        for ( int i = 0 ; i < 100 ; ++i ) {
+            b.PutItem( String( L"v" ) + IntToStr( i ), i );
+        }
+
+        BOOST_TEST( a.GetArena() == &Arena );
+        BOOST_TEST( b.GetArena() == &Arena );
+        BOOST_TEST( Arena.GetBlockCount() > 0u );
+        BOOST_TEST( Arena.GetBytesUsed() > 0u );
+        BOOST_TEST( b.GetItem<int>( L"v42" ) == 42 );
+        BOOST_TEST( b.GetValueCount() == 100u );
+
+        // Heap-allocated children are still accepted next to arena ones.
+        Anafestica::NodeContType Nodes( &Arena );
+        Nodes[L"heap"] = std::make_unique<TConfigNode>();
+        Nodes[L"arena"] = Anafestica::MakeConfigNode( &Arena );
+        BOOST_TEST( Nodes.size() == 2u );
+    }
+    Arena.Release();
+    BOOST_TEST( Arena.GetBlockCount() == 0u );
+}
+
+BOOST_AUTO_TEST_CASE( Arena_reuses_storage_across_edit_and_flush_cycles )
+{
+    // Every round re-reads the tree (replacing both lists of the root and
+    // both children), grows a value list past several reallocations and
+    // flushes.  The storage given back must be reused, so the arena stops
+    // growing once the first rounds have sized it.
+    Anafestica::TConfigArena Arena;
+    TConfigNode root( &Arena );
+    ArenaTreeReader Reader{ &Arena };
+    NoOpWriter Writer;
+    std::size_t Used {};
+    std::size_t Reserved {};
+    for ( int Round = 0 ; Round < 20 ; ++Round ) {
+        root.Read( Reader, Anafestica::TConfigPath{} );
+        auto& a = root[L"A"];
+        for ( int i = 0 ; i < 100 ; ++i ) {
+            a.PutItem( String( L"v" ) + IntToStr( i ), Round + i );
+        }
+        root.Write( Writer, Anafestica::TConfigPath{} );
+        if ( Round == 2 ) {
+            Used = Arena.GetBytesUsed();
+            Reserved = Arena.GetBytesReserved();
+        }
+        else if ( Round > 2 ) {
+            BOOST_TEST( Arena.GetBytesUsed() == Used );
+            BOOST_TEST( Arena.GetBytesReserved() == Reserved );
+        }
+    }
+    BOOST_TEST( root[L"A"].GetValueCount() == 101u );
+}
+
+BOOST_AUTO_TEST_CASE( Find_and_TryGet_never_insert )
+{
+    TConfigNode n;
+    n.PutItem( L"i", 7 );
+    n.PutItem( L"s", String( L"text" ) );
+    n.PutItem( L"gone", 1 );
+    n.DeleteItem( L"gone" );
+    auto const Generation = n.GetGeneration();
+
+    auto const * i = n.Find<int>( L"i" );
+    BOOST_REQUIRE( i != nullptr );
+    BOOST_TEST( *i == 7 );
+    BOOST_TEST( n.Find<int>( L"i" ) == i );            // points into the node
+    BOOST_TEST( n.Find<String>( L"i" ) == nullptr );    // other alternative
+    BOOST_TEST( n.Find<int>( L"missing" ) == nullptr );
+    BOOST_TEST( n.Find<int>( L"gone" ) == nullptr );    // marked for deletion
+    BOOST_TEST( n.FindValue( L"s" ) != nullptr );
+
+    int v { -1 };
+    BOOST_TEST( !n.TryGet( L"missing", v ) );
+    BOOST_TEST( v == -1 );
+    BOOST_TEST( n.TryGet( L"i", v ) );
+    BOOST_TEST( v == 7 );
+    String str;
+    BOOST_TEST( n.TryGet( L"s", str ) );
+    BOOST_TEST( str == String( L"text" ) );
+
+    auto sl = std::make_unique<TStringList>();
+    BOOST_TEST( !n.TryGet( L"missing", *sl ) );
+
+    BOOST_TEST( !n.ItemExists( L"missing" ) );
+    BOOST_TEST( n.GetValueCount() == 2u );
+    BOOST_TEST( n.GetGeneration() == Generation );
+}
+
+BOOST_AUTO_TEST_CASE( Values_and_Nodes_ranges_hand_out_references )
+{
+    TConfigNode n;
+    n.PutItem( L"b", 2 );
+    n.PutItem( L"a", 1 );
+    n.PutItem( L"c", 3 );
+    n.DeleteItem( L"b" );
+    auto& x = n[L"x"];
+    auto& y = n[L"y"];
+
+    std::vector<String> names;
+    for ( auto [Name, Value] : n.Values() ) {
+        names.push_back( Name );
+        BOOST_TEST( &Value == n.FindValue( Name ) );
+    }
+    BOOST_TEST( names.size() == 2u );
+    BOOST_TEST( names[0] == String( L"a" ) );
+    BOOST_TEST( names[1] == String( L"c" ) );
+
+    std::vector<TConfigNode const *> nodes;
+    for ( auto [Name, Node] : n.Nodes() ) { nodes.push_back( &Node ); }
+    BOOST_TEST( n.Nodes().size() == 2u );
+    BOOST_TEST( nodes.size() == 2u );
+    BOOST_TEST( nodes[0] == &x );
+    BOOST_TEST( nodes[1] == &y );
+
+    TConfigNode empty;
+    BOOST_TEST( empty.Values().empty() );
+    BOOST_TEST( empty.Nodes().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( PutItem_moves_payloads_into_place )
+{
+    TConfigNode n;
+    Anafestica::BytesCont Blob( 1024 * 1024, 0x5A );
+    auto const * Data = Blob.data();
+    BOOST_TEST( n.PutItem( L"blob", std::move( Blob ) ) );
+    BOOST_REQUIRE( n.Find<Anafestica::BytesCont>( L"blob" ) != nullptr );
+    BOOST_TEST( n.Find<Anafestica::BytesCont>( L"blob" )->data() == Data );
+
+    // Overwriting an entry of the same type moves into the stored
+    // variant: no heap block for a copy, none for a new variant.
+    Anafestica::BytesCont Next( 1024 * 1024, 0x33 );
+    auto const * NextData = Next.data();
+    auto const Before = NodeOpsAllocCount;
+    BOOST_TEST( !n.PutItem( L"blob", std::move( Next ) ) );
+    BOOST_TEST( NodeOpsAllocCount - Before == 0u );
+    BOOST_TEST( n.Find<Anafestica::BytesCont>( L"blob" )->data() == NextData );
+    BOOST_TEST( n.IsModified() );
+
+    Anafestica::StringCont Strs( 100, String( L"line" ) );
+    auto const * StrsData = Strs.data();
+    BOOST_TEST( n.PutItem( L"strs", std::move( Strs ) ) );
+    BOOST_TEST( n.Find<Anafestica::StringCont>( L"strs" )->data() == StrsData );
+
+    Anafestica::ValueContType Values;
+    Anafestica::BytesCont Raw( 1000, 1 );
+    auto const * RawData = Raw.data();
+    Anafestica::PutItemTo(
+        Values, L"raw",
+        Anafestica::ValuePairType(
+            Anafestica::ValueType( std::move( Raw ) ), Anafestica::Operation::None
+        )
+    );
+    auto const * Stored = Anafestica::FindItemIn( Values, L"raw" );
+    BOOST_REQUIRE( Stored != nullptr );
+    BOOST_TEST(
+        Anafestica::GetIfValue<Anafestica::BytesCont>( Stored )->data() == RawData
+    );
+}
+
+BOOST_AUTO_TEST_CASE( Resaving_an_equal_payload_copies_nothing )
+{
+    TConfigNode n;
+    Anafestica::BytesCont Blob( 1024 * 1024, 0x5A );
+    // Seeded as a backend read would: present but not modified.
+    n.PutItem( L"blob", Blob, Anafestica::Operation::None );
+    n.PutItem( L"i", 5, Anafestica::Operation::None );
+    System::Sysutils::TBytes Bytes;
+    Bytes.Length = 4096;
+    n.PutItem( L"bytes", Bytes, Anafestica::Operation::None );
+    BOOST_REQUIRE( !n.IsModified() );
+    auto const * Data = n.Find<Anafestica::BytesCont>( L"blob" )->data();
+    auto const Generation = n.GetGeneration();
+
+    auto const Before = NodeOpsAllocCount;
+    BOOST_TEST( !n.PutItem( L"blob", Blob ) );
+    BOOST_TEST( !n.PutItem( L"i", 5 ) );
+    BOOST_TEST( NodeOpsAllocCount - Before == 0u );
+    BOOST_TEST( n.Find<Anafestica::BytesCont>( L"blob" )->data() == Data );
+    BOOST_TEST( !n.IsModified() );
+    BOOST_TEST( n.GetGeneration() == Generation );
+
+    // Payloads that share their data with the stored ones.
+    BOOST_TEST( !n.PutItem( L"bytes", n.GetItem<System::Sysutils::TBytes>( L"bytes" ) ) );
+    BOOST_TEST( !n.PutItem( L"blob", *n.Find<Anafestica::BytesCont>( L"blob" ) ) );
+    BOOST_TEST( NodeOpsAllocCount - Before == 0u );
+    BOOST_TEST( !n.IsModified() );
+
+    // Same size, different content: stored, reusing the existing buffer.
+    Blob.back() = 0x00;
+    BOOST_TEST( !n.PutItem( L"blob", Blob ) );
+    BOOST_TEST( NodeOpsAllocCount - Before == 0u );
+    BOOST_TEST( n.Find<Anafestica::BytesCont>( L"blob" )->back() == 0x00 );
+    BOOST_TEST( n.IsModified() );
+}
+
+BOOST_AUTO_TEST_CASE( Value_cells_share_payloads_until_modified )
+{
+    using Anafestica::ValueType;
+    using Anafestica::StringCont;
+
+    BOOST_TEST( sizeof( ValueType ) == 16u );
+
+    ValueType a( StringCont{ String( L"x" ), String( L"y" ) } );
+    auto const Before = NodeOpsAllocCount;
+    ValueType b( a );
+    BOOST_TEST( NodeOpsAllocCount - Before == 0u );      // shared, not copied
+    BOOST_TEST( !a.IsUnique() );
+    BOOST_TEST( ( a == b ) );
+
+    Anafestica::GetIfValue<StringCont>( &b )->push_back( String( L"z" ) );
+    BOOST_TEST( a.IsUnique() );                          // b detached
+    BOOST_TEST( Anafestica::GetIfValue<StringCont>( &std::as_const( a ) )->size() == 2u );
+    BOOST_TEST( Anafestica::GetIfValue<StringCont>( &std::as_const( b ) )->size() == 3u );
+
+    // Every toolchain carries all 21 alternatives; character pointers
+    // are stored as String.
+    BOOST_TEST( ValueType( std::string( "utf8" ) ).index() ==
+                static_cast<std::size_t>( Anafestica::TypeTag::TT_STR ) );
+    BOOST_TEST( ValueType( std::wstring( L"wide" ) ).index() ==
+                static_cast<std::size_t>( Anafestica::TypeTag::TT_WSTR ) );
+    BOOST_TEST( ValueType( L"text" ).index() ==
+                static_cast<std::size_t>( Anafestica::TypeTag::TT_SZ ) );
+}
+
+BOOST_AUTO_TEST_CASE( Type_tags_map_both_ways )
+{
+    using Anafestica::TypeTag;
+
+    for ( std::size_t Idx = 0 ; Idx < Anafestica::TypeTagCount ; ++Idx ) {
+        auto const Tag = static_cast<TypeTag>( Idx );
+        std::string const Narrow = Anafestica::GetTypeTagName( Tag );
+        String const Wide( Narrow.c_str() );
+        BOOST_TEST( ( Anafestica::GetTypeTag( Wide ) == Tag ) );
+        BOOST_TEST( ( Anafestica::FindTypeTag( Narrow.data(), Narrow.size() ) == Tag ) );
+    }
+
+    BOOST_TEST( ( Anafestica::Codec::TagOf<double> == TypeTag::TT_DBL ) );
+    BOOST_TEST( std::string( Anafestica::Codec::TagName<Anafestica::StringCont>() ) == "sv" );
+    BOOST_TEST(
+        std::string( Anafestica::Codec::TagName( Anafestica::ValueType( 1.5f ) ) ) == "flt"
+    );
+
+    for ( auto Unknown : { L"", L"I", L"x", L"dbx", L"wstrs", L"u\x00FC", L"s\x0131" } ) {
+        BOOST_TEST( !Anafestica::GetTypeTag( String( Unknown ) ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Type_tag_suffixes_split_at_the_last_separator )
+{
+    using Anafestica::TypeTag;
+    using View = std::wstring_view;
+
+    View Name;
+    auto Tag = Anafestica::DecodeTagSuffix( View( L"Grid:(x):(ull)" ), ":(", Name );
+    BOOST_TEST( ( Tag == TypeTag::TT_ULL ) );
+    BOOST_TEST( ( Name == View( L"Grid:(x)" ) ) );
+
+    Tag = Anafestica::DecodeTagSuffix( View( L":(b)" ), ":(", Name );
+    BOOST_TEST( ( Tag == TypeTag::TT_B ) );
+    BOOST_TEST( Name.empty() );
+
+    // No suffix, or one naming no tag: the whole key is the name.
+    for ( auto Key : { L"Port", L"Port:(x)", L"Port:(I)", L"Port:(u", L"Port(u)",
+                       L"Port:(u)x", L"Port:()", L"Port::(u" } ) {
+        Name = View( L"untouched" );
+        BOOST_TEST( !Anafestica::DecodeTagSuffix( View( Key ), ":(", Name ) );
+        BOOST_TEST( ( Name == View( L"untouched" ) ) );
+    }
+
+    // The INI backend's "Name::(Tag)" keys go through the same split.
+    std::string_view IniName, IniTag;
+    BOOST_TEST( Anafestica::INIFile::DecodeKey( "a::(b)::(dbl)", IniName, IniTag ) );
+    BOOST_TEST( IniName == "a::(b)" );
+    BOOST_TEST( IniTag == "dbl" );
+    BOOST_TEST( !Anafestica::INIFile::DecodeKey( "::(dbl)", IniName, IniTag ) );
+    BOOST_TEST( !Anafestica::INIFile::DecodeKey( "a::()", IniName, IniTag ) );
+    BOOST_TEST( !Anafestica::INIFile::DecodeKey( "a:(dbl)", IniName, IniTag ) );
+}
+
+namespace {
+
+// Text codec plus a format-specific StringCont layout, as the text
+// backends declare theirs.
+struct TestTextCodec : Anafestica::Codec::TTextCodec {
+    using TTextCodec::Encode;
+    using TTextCodec::Decode;
+
+    static String Encode( Anafestica::Codec::TAs<Anafestica::StringCont>,
+                          Anafestica::StringCont const & Val ) {
+        auto SL = std::make_unique<TStringList>();
+        for ( auto const & Item : Val ) { SL->Add( Item ); }
+        return SL->CommaText;
+    }
+
+    static Anafestica::StringCont Decode( Anafestica::Codec::TAs<Anafestica::StringCont>,
+                                          String const & Val ) {
+        auto SL = std::make_unique<TStringList>();
+        SL->CommaText = Val;
+        Anafestica::StringCont Items;
+        for ( int Idx = 0 ; Idx < SL->Count ; ++Idx ) { Items.push_back( SL->Strings[Idx] ); }
+        return Items;
+    }
+};
+
+// TBytes compares by identity, and the ISO 8601 round trip goes through the
+// local time zone: compare those by content / date.
+bool SameDecoded( Anafestica::ValueType const & Lhs, Anafestica::ValueType const & Rhs )
+{
+    using Anafestica::GetIfValue;
+
+    if ( auto L = GetIfValue<TBytes>( &Lhs ) ) {
+        auto R = GetIfValue<TBytes>( &Rhs );
+        if ( !R || L->Length != R->Length ) { return false; }
+        for ( int i = 0 ; i < L->Length ; ++i ) {
+            if ( (*L)[i] != (*R)[i] ) { return false; }
+        }
+        return true;
+    }
+    if ( auto L = GetIfValue<TDateTime>( &Lhs ) ) {
+        auto R = GetIfValue<TDateTime>( &Rhs );
+        return R && DateOf( *L ) == DateOf( *R );
+    }
+    return Lhs == Rhs;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( Codec_round_trips_every_alternative )
+{
+    using Anafestica::ValueType;
+
+    TBytes Bytes;
+    Bytes.Length = 3;
+    Bytes[0] = 0x01; Bytes[1] = 0x80; Bytes[2] = 0xFF;
+
+    std::vector<ValueType> const Values {
+        ValueType( -7 ), ValueType( 7u ), ValueType( -70L ), ValueType( 70UL ),
+        ValueType( 'c' ), ValueType( static_cast<unsigned char>( 200 ) ),
+        ValueType( static_cast<short>( -300 ) ),
+        ValueType( static_cast<unsigned short>( 60000 ) ),
+        ValueType( -9000000000LL ), ValueType( 18000000000000000000ULL ),
+        ValueType( true ), ValueType( String( L"text" ) ),
+        ValueType( EncodeDate( 2024, 2, 29 ) ), ValueType( 0.1f ), ValueType( 0.1 ),
+        ValueType( Currency( 12.3456 ) ),
+        ValueType( Anafestica::StringCont{ String( L"a" ), String( L"b c" ) } ),
+        ValueType( Bytes ), ValueType( Anafestica::BytesCont{ 0x00, 0x7F } ),
+        ValueType( std::string( "utf8" ) ), ValueType( std::wstring( L"wide" ) ),
+    };
+    BOOST_TEST( Values.size() == Anafestica::TypeTagCount );
+
+    for ( auto const & Val : Values ) {
+        String const Text = Anafestica::Codec::Encode( Val, TestTextCodec{} );
+        auto const Tag = Anafestica::GetTypeTag( Anafestica::Codec::TagName( Val ) );
+        BOOST_TEST( Tag.has_value() );
+        if ( !Tag ) { continue; }
+        BOOST_TEST( static_cast<std::size_t>( *Tag ) == Val.index() );
+        auto const Decoded = Anafestica::Codec::Decode( *Tag, TestTextCodec{}, Text );
+        BOOST_TEST( Decoded.index() == Val.index() );
+        BOOST_TEST( SameDecoded( Decoded, Val ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Read_and_Write_keep_the_node_cursor_on_the_current_node )
+{
+    CursorTreeStorage storage;
+    TConfigNode root;
+    root.Read( storage, Anafestica::TConfigPath{} );
+    BOOST_TEST( storage.Enters == 6 );
+    BOOST_TEST( storage.Cursor.empty() );
+
+    root[L"B"][L"A"].PutItem( L"x", 1 );
+    root.Write( storage, Anafestica::TConfigPath{} );
+    BOOST_TEST( storage.Enters == 12 );
+    BOOST_TEST( storage.Cursor.empty() );
+    BOOST_TEST( storage.Saved.size() == 7u );
+    BOOST_TEST( storage.Saved.back() == String( L"/B/B" ) );
+    BOOST_TEST( storage.Mismatches == 0 );
+}
+
+BOOST_AUTO_TEST_CASE( Node_cursor_resolves_each_level_once )
+{
+    // Handles are the resolved path as text; Step counts the lookups.
+    int Steps {};
+    auto Step =
+        [&Steps]( String& Node, String const & Name ) {
+            ++Steps;
+            if ( Name == String( L"missing" ) ) { return false; }
+            Node += L"/";
+            Node += Name;
+            return true;
+        };
+    auto Resolve =
+        [&]( Anafestica::TNodeCursor<String>& Cursor,
+             Anafestica::TConfigPath const & Path ) {
+            String Node;
+            return Cursor.Resolve( Node, Path, Step ) ? Node : String( L"?" );
+        };
+
+    Anafestica::TNodeCursor<String> cursor;
+    cursor.Enter( L"a" );
+    cursor.Enter( L"b" );
+    BOOST_TEST( Resolve( cursor, { L"a", L"b" } ) == String( L"/a/b" ) );
+    BOOST_TEST( Steps == 2 );
+
+    cursor.Enter( L"c" );
+    BOOST_TEST( Resolve( cursor, { L"a", L"b", L"c" } ) == String( L"/a/b/c" ) );
+    BOOST_TEST( Steps == 3 );
+    BOOST_TEST( Resolve( cursor, { L"a", L"b", L"c" } ) == String( L"/a/b/c" ) );
+    BOOST_TEST( Steps == 3 );
+
+    // Other paths are walked from the root and leave the frames alone.
+    BOOST_TEST( Resolve( cursor, { L"x", L"y" } ) == String( L"/x/y" ) );
+    BOOST_TEST( Steps == 5 );
+
+    String Parent;
+    BOOST_TEST( cursor.Resolve( Parent, { L"a", L"b", L"c" }, 2, Step ) );
+    BOOST_TEST( Parent == String( L"/a/b" ) );
+    BOOST_TEST( Steps == 5 );
+
+    cursor.Invalidate( { L"a", L"b", L"c" } );
+    BOOST_TEST( Resolve( cursor, { L"a", L"b", L"c" } ) == String( L"/a/b/c" ) );
+    BOOST_TEST( Steps == 6 );
+
+    // A failed lookup is not cached.
+    cursor.Leave();
+    cursor.Enter( L"missing" );
+    BOOST_TEST( Resolve( cursor, { L"a", L"b", L"missing" } ) == String( L"?" ) );
+    BOOST_TEST( Resolve( cursor, { L"a", L"b", L"missing" } ) == String( L"?" ) );
+    BOOST_TEST( Steps == 8 );
+    BOOST_TEST( cursor.GetDepth() == 3u );
+}
+
+BOOST_AUTO_TEST_CASE( Lazy_read_loads_children_on_first_access )
+{
+    LazyTreeReader reader;
+    TConfigNode root;
+    root.ReadLazy( reader, reader, Anafestica::TConfigPath{} );
+
+    BOOST_TEST( reader.ValueLists == 1 );
+    BOOST_TEST( root.GetNodeCount() == 2u );
+    BOOST_TEST( root.SubNodeExists( L"B" ) );
+
+    auto& a = root[L"A"];
+    BOOST_TEST( reader.Loads == 1 );
+    BOOST_TEST( a.IsLoaded() );
+    BOOST_TEST( a.GetItem<int>( L"Depth" ) == 1 );
+    BOOST_TEST( a.GetNodeCount() == 2u );
+    BOOST_TEST( a[L"B"].GetItem<int>( L"Depth" ) == 2 );
+    BOOST_TEST( reader.ValueLists == 3 );
+
+    // Loading is not a modification.
+    BOOST_TEST( !root.IsModified() );
+
+    // Second access: already in memory.
+    root[L"A"];
+    BOOST_TEST( reader.Loads == 2 );
+}
+
+BOOST_AUTO_TEST_CASE( Write_skips_pending_subtrees )
+{
+    LazyTreeReader reader;
+    TConfigNode root;
+    root.ReadLazy( reader, reader, Anafestica::TConfigPath{} );
+
+    root[L"A"][L"A"].PutItem( L"x", 1 );
+    root.DeleteSubNode( L"B" );         // still pending: dropped unread
+    BOOST_TEST( reader.Loads == 2 );
+
+    RecordingWriter writer;
+    root.Write( writer, Anafestica::TConfigPath{} );
+    BOOST_TEST( writer.Saved.size() == 1u );
+    BOOST_TEST( writer.Saved.front() == String( L"/A/A" ) );
+    BOOST_TEST( writer.Deleted.size() == 1u );
+    BOOST_TEST( writer.Deleted.front() == String( L"/B" ) );
+    BOOST_TEST( root[L"B"].IsDeleted() );
+    BOOST_TEST( reader.Loads == 2 );
+}
+
+BOOST_AUTO_TEST_CASE( Prefetch_loads_the_requested_levels )
+{
+    LazyTreeReader reader;
+    TConfigNode root;
+    root.ReadLazy( reader, reader, Anafestica::TConfigPath{} );
+
+    root[L"B"].Prefetch( 0 );           // B itself was loaded by operator[]
+    BOOST_TEST( reader.Loads == 1 );
+
+    root.Prefetch( 2 );                 // A; B's children
+    BOOST_TEST( reader.Loads == 4 );
+    BOOST_TEST( reader.ValueLists == 7 );
+
+    auto const Before = reader.Loads;
+    BOOST_TEST( root[L"B"][L"A"].GetItem<int>( L"Depth" ) == 2 );
+    BOOST_TEST( reader.Loads == Before );
+
+    root.Prefetch();                    // everything else
+    BOOST_TEST( reader.ValueLists == 15 );
+}
+
 BOOST_AUTO_TEST_CASE( Write_rejects_paths_deeper_than_persistence_limit )
 {
     TConfigNode root;
@@ -391,6 +1210,32 @@ BOOST_AUTO_TEST_CASE( Registry_delete_persists )
     AssertErasePersistence_RegistrySteps( key );
 }
 
+BOOST_AUTO_TEST_CASE( Registry_lazy_load_keeps_untouched_subtrees )
+{
+    auto const key = MakeNodeOpsRegKey();
+    NodeOpsScopedRegKey g( key );
+    {
+        Anafestica::Registry::TConfig c( HKEY_CURRENT_USER, key );
+        c.GetRootNode()[L"used"].PutItem( L"v", 1 );
+        c.GetRootNode()[L"untouched"][L"deep"].PutItem( L"v", 2 );
+    }
+    {
+        Anafestica::TConfigOptions Options;
+        Options.LoadMode = Anafestica::TLoadMode::Lazy;
+        Anafestica::Registry::TConfig c( HKEY_CURRENT_USER, key, false, false, String(), Options );
+        BOOST_TEST( c.GetLazyLoadFlag() );
+        BOOST_TEST( c.GetRootNode().SubNodeExists( L"untouched" ) );
+        auto& used = c.GetRootNode()[L"used"];
+        BOOST_TEST( used.GetItem<int>( L"v" ) == 1 );
+        used.PutItem( L"v", 3 );
+    }
+    {
+        Anafestica::Registry::TConfig c( HKEY_CURRENT_USER, key );
+        BOOST_TEST( c.GetRootNode()[L"used"].GetItem<int>( L"v" ) == 3 );
+        BOOST_TEST( c.GetRootNode()[L"untouched"][L"deep"].GetItem<int>( L"v" ) == 2 );
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //---------------------------------------------------------------------------
@@ -422,6 +1267,35 @@ BOOST_AUTO_TEST_CASE( JSON_delete_persists )
     }
 }
 
+BOOST_AUTO_TEST_CASE( JSON_lazy_load_keeps_untouched_subtrees )
+{
+    auto const path = MakeNodeOpsTempPath( L".json" );
+    NodeOpsTempGuard g( path );
+
+    {
+        Anafestica::JSON::TConfig c( path );
+        c.GetRootNode()[L"used"].PutItem( L"v", 1 );
+        c.GetRootNode()[L"untouched"][L"deep"].PutItem( L"v", 2 );
+    }
+    {
+        Anafestica::TConfigOptions Options;
+        Options.LoadMode = Anafestica::TLoadMode::Lazy;
+        Anafestica::JSON::TConfig c( path, false, true, false, false, {}, Options );
+        BOOST_TEST( c.GetLazyLoadFlag() );
+        c.GetRootNode()[L"used"].PutItem( L"v", 3 );
+        c.Flush();
+        // Still loadable after the flush.
+        BOOST_TEST(
+            c.GetRootNode()[L"untouched"][L"deep"].GetItem<int>( L"v" ) == 2
+        );
+    }
+    {
+        Anafestica::JSON::TConfig c( path );
+        BOOST_TEST( c.GetRootNode()[L"used"].GetItem<int>( L"v" ) == 3 );
+        BOOST_TEST( c.GetRootNode()[L"untouched"][L"deep"].GetItem<int>( L"v" ) == 2 );
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //---------------------------------------------------------------------------
@@ -3,17 +3,17 @@
 // (Registry, JSON, BSON, INI, XML).
 //
 // Each test stores a value of type A via PutItem<A>(), then reads it back
-// with GetItem<B>() where B != A.  Because the variant alternative written
+// with GetItem<B>() where B != A.  Because the alternative written
 // by the backend (determined by the type suffix) differs from B,
-// std::get_if<B> returns nullptr and GetItem silently returns T{}.
+// GetIfValue<B> returns nullptr and GetItem silently returns T{}.
 //
 // Five representative mismatch pairs are tested per backend:
 //
-//   1. int  -> double    (two numeric types, distinct variant alternatives)
+//   1. int  -> double    (two numeric types, distinct alternatives)
 //   2. String -> int     (string stored, code reads as integer)
 //   3. int  -> String    (integer stored, code reads as string)
 //   4. bool -> int       (bool/int freely convertible in C++ but distinct
-//                         variant alternatives)
+//                         alternatives)
 //   5. double -> float   (closely related FP types, distinct alternatives)
 //---------------------------------------------------------------------------
 
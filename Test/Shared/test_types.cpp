@@ -221,12 +221,12 @@ BOOST_AUTO_TEST_CASE(TRegistry_ExpandString_roundtrip)
 
 BOOST_AUTO_TEST_CASE(Variant_Usage_Info)
 {
-#ifdef ANAFESTICA_USE_STD_VARIANT
-    BOOST_TEST_MESSAGE("Using std::variant");
-#else
-    BOOST_TEST_MESSAGE("Using boost::variant");
-#endif
-    BOOST_TEST(true); // Always pass
+    BOOST_TEST_MESSAGE(
+        "TConfigNodeValueType: " << sizeof(Anafestica::TConfigNodeValueType)
+        << " bytes, " << Anafestica::TConfigNodeValueType::AlternativeCount
+        << " alternatives"
+    );
+    BOOST_TEST(sizeof(Anafestica::TConfigNodeValueType) == 16u);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
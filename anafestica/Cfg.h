@@ -11,6 +11,68 @@
 namespace Anafestica {
 //---------------------------------------------------------------------------
 
+/// How a configuration object populates its tree at construction (see
+/// @ref TConfigOptions::LoadMode).
+enum class TLoadMode {
+    Eager,  ///< the whole tree is read by the constructor (default)
+    Lazy    ///< only the root; every other node on first access
+};
+
+/// What a file-based configuration object keeps between flushes (see
+/// @ref TConfigOptions::DocumentMode).
+enum class TDocumentMode {
+    Reload,  ///< every flush re-reads the file it patches (default)
+    Retain   ///< the document stays loaded; re-read only if the file changed
+};
+
+/// Options common to every backend, taken as the last argument of each
+/// backend constructor.
+///
+/// @code
+/// std::pmr::unsynchronized_pool_resource Pool;
+/// TConfigOptions Options;
+/// Options.Upstream = &Pool;
+/// JSON::TConfig Cfg( FileName, false, true, false, false, {}, Options );
+/// @endcode
+struct TConfigOptions {
+    /// Where the tree's arena gets its blocks (@c nullptr: the global
+    /// heap).  The resource must outlive the configuration object.
+    TMemoryResource* Upstream {};
+
+    /// @ref TLoadMode::Lazy reads only the root in the constructor:
+    ///
+    /// @code
+    /// TConfigOptions Options;
+    /// Options.LoadMode = TLoadMode::Lazy;
+    /// Registry::TConfig Cfg( HKEY_CURRENT_USER, Key, false, false, String(), Options );
+    /// auto& Form = Cfg.GetRootNode()[L"MainForm"];   // opens MainForm now
+    /// @endcode
+    ///
+    /// Ignored by objects that flush every item (the @c FlushAllItems
+    /// option, the migration constructors and YAML), since those must
+    /// hold the whole tree anyway.
+    TLoadMode LoadMode { TLoadMode::Eager };
+
+    /// @ref TDocumentMode::Retain keeps the parsed file between flushes:
+    ///
+    /// @code
+    /// TConfigOptions Options;
+    /// Options.DocumentMode = TDocumentMode::Retain;
+    /// JSON::TConfig Cfg( FileName, false, true, false, false, {}, Options );
+    /// Cfg.Flush();   // patches the text kept from loading
+    /// @endcode
+    ///
+    /// A flush patches the parsed file (JSON, XML, INI, BSON).  Retained,
+    /// the document, or the text a streamed JSON flush merges into, is
+    /// kept after loading and after each flush along with the file's size
+    /// and last write time (see @ref TDocumentStamp).  The next flush
+    /// reuses it when the file still matches them, and reads the file as
+    /// usual when something else has rewritten it.  The price is the
+    /// memory the document takes while the object lives.  Registry and
+    /// YAML objects do not re-read anything on a flush, so they ignore it.
+    TDocumentMode DocumentMode { TDocumentMode::Reload };
+};
+
 /// Abstract base for all configuration backends.
 ///
 /// Owns a root @ref TConfigNode and delegates storage I/O to pure-virtual
@@ -27,10 +89,17 @@ namespace Anafestica {
 /// regardless of which backend is in use.
 ///
 /// @par RAII lifecycle
-/// Concrete constructors call @c GetRootNode().Read(*this, ...) to
-/// populate the in-memory tree from storage.  Destructors call
-/// @c DoFlush() to write dirty nodes back.  If the process crashes
-/// before the destructor runs, the storage medium is left unchanged.
+/// Concrete constructors call @c ReadRootNode() to populate the in-memory
+/// tree from storage.  Destructors call @c DoFlush() to write dirty nodes
+/// back.  If the process crashes before the destructor runs, the storage
+/// medium is left unchanged.
+///
+/// @par Lazy loading
+/// In @ref TLoadMode::Lazy, @c ReadRootNode reads the root only and every
+/// other node is read through @c DoCreateValueList / @c DoCreateNodeList
+/// the first time it is accessed (see @ref TConfigNode::ReadLazy).  Each
+/// such load is bracketed by @c DoBeginLazyRead / @c DoEndLazyRead, which
+/// backends override to make their storage handle available.
 ///
 /// @par Backend contract
 /// Subclasses must implement the following @c protected virtual hooks:
@@ -39,15 +108,58 @@ namespace Anafestica {
 /// - @c DoSaveValueList   — serialise one node's values to storage.
 /// - @c DoDeleteNode      — remove a node and its children.
 /// - @c DoFlush           — commit all pending changes.
-class TConfig {
+/// Optionally, for lazy mode:
+/// - @c DoBeginLazyRead / @c DoEndLazyRead — open/close the storage
+///   around an on-demand load.
+/// Optionally, to keep a position in the storage:
+/// - @c DoEnterNode / @c DoLeaveNode — see below.
+///
+/// @par Node cursor
+/// Loads and flushes walk the tree depth first.  Before descending into a
+/// child, @ref TConfigNode::Read and @ref TConfigNode::Write call
+/// @c DoEnterNode with its name, and @c DoLeaveNode after it, so during a
+/// traversal the @c Path passed to the other hooks always names the node
+/// the cursor is on.  A backend that tracks the cursor (see @ref TNodeCursor)
+/// resolves each node once from its parent rather than walking every
+/// path from the root.  The defaults do nothing, so backends that resolve
+/// @c Path themselves keep working unchanged.
+///
+/// @par Memory
+/// The in-memory tree (nodes and their value/child containers) is
+/// allocated from a @ref TConfigArena owned by the configuration object
+/// and released in one go by its destructor.  Arena blocks come from
+/// @ref TConfigOptions::Upstream when given, otherwise from the global
+/// heap.
+class TConfig : private TConfigNodeLoader {
 public:
-    TConfig( bool ReadOnly, bool FlushAllItems )
+    TConfig( bool ReadOnly, bool FlushAllItems,
+             TConfigOptions const & Options = {} )
       : readOnly_{ ReadOnly }
       , flushAllItems_{ FlushAllItems }
-      , root_{ new TConfigNode{} }
+      , lazyLoad_{
+          !FlushAllItems && Options.LoadMode == TLoadMode::Lazy
+        }
+      , retainDocument_{
+          Options.DocumentMode == TDocumentMode::Retain
+        }
+      , arena_{ Options.Upstream }
+      , root_{ new TConfigNode{ &arena_ } }
     {}
     TConfigNode& GetRootNode() { return DoGetRootNode(); }
-    void Flush() { DoFlush(); }
+
+    /// The arena holding this configuration's tree (for statistics).
+    [[nodiscard]] TConfigArena const & GetArena() const noexcept { return arena_; }
+
+    /// Writes the pending changes.  Once @c DoFlush returns they are in
+    /// storage, so the tree is marked clean (see
+    /// @ref TConfigNode::CommitWrite): the next flush writes only what
+    /// changes after this one, and a destructor with nothing new to write
+    /// skips its flush.
+    void Flush() {
+        DoFlush();
+        root_->CommitWrite();
+        markedForFlush_ = false;
+    }
     ValueContType CreateValueList( TConfigPath const & Path ) {
         return DoCreateValueList( Path );
     }
@@ -62,6 +174,9 @@ public:
 
     void DeleteNode( TConfigPath const & Path ) { DoDeleteNode( Path ); }
 
+    void EnterNode( String const & Name ) { DoEnterNode( Name ); }
+    void LeaveNode() noexcept { DoLeaveNode(); }
+
     [[nodiscard]] bool GetReadOnlyFlag() const noexcept { return readOnly_; }
 
     /// When true, @ref TConfigNode::Write flushes every node regardless
@@ -69,6 +184,14 @@ public:
     /// because they rewrite the entire file atomically.
     [[nodiscard]] bool GetAlwaysFlushNodeFlag() const noexcept { return flushAllItems_; }
 
+    /// @c true when the tree is loaded on demand (see
+    /// @ref TConfigOptions::LoadMode).
+    [[nodiscard]] bool GetLazyLoadFlag() const noexcept { return lazyLoad_; }
+
+    /// @c true when file backends keep their document between flushes
+    /// (see @ref TConfigOptions::DocumentMode).
+    [[nodiscard]] bool GetRetainDocumentFlag() const noexcept { return retainDocument_; }
+
     /// Decides whether a backend's destructor should call @c DoFlush().
     ///
     /// Returns @c true when the object is writable AND either:
@@ -98,6 +221,24 @@ protected:
     /// ctor calls @ref MarkForFlush so the dtor writes to the destination.
     void MarkForFlush() noexcept { markedForFlush_ = true; }
 
+    /// Populates the root node from storage, eagerly or lazily according
+    /// to @ref GetLazyLoadFlag.  Called by the backend constructors with
+    /// the storage open.
+    void ReadRootNode() {
+        if ( lazyLoad_ ) {
+            GetRootNode().ReadLazy( *this, *this, TConfigPath{} );
+        }
+        else {
+            GetRootNode().Read( *this, TConfigPath{} );
+        }
+    }
+
+    /// Containers and nodes for the @c DoCreate* hooks, allocated from this
+    /// configuration's arena.
+    [[nodiscard]] ValueContType NewValueList() { return ValueContType( &arena_ ); }
+    [[nodiscard]] NodeContType NewNodeList() { return NodeContType( &arena_ ); }
+    [[nodiscard]] TConfigNodePtr NewNode() { return MakeConfigNode( &arena_ ); }
+
 
     /// Deserialises the values stored at @p Path into a value map.
     ///
@@ -110,13 +251,45 @@ protected:
     virtual TConfigNode& DoGetRootNode() { return *root_; }
     virtual void DoDeleteNode( TConfigPath const & Path ) = 0;
     virtual void DoFlush() = 0;
-private:
-    using TConfigNodePtr = std::unique_ptr<TConfigNode>;
 
+    /// Bracket every on-demand load in lazy mode.  Backends that release
+    /// their storage handle after construction reopen it here.
+    virtual void DoBeginLazyRead() {}
+    virtual void DoEndLazyRead() {}
+
+    /// Move the storage cursor to child @p Name of the node it is on, and
+    /// back to the parent.  Calls are balanced and never span a
+    /// @c DoFlush or an on-demand load; the cursor starts at the root.
+    virtual void DoEnterNode( String const & /*Name*/ ) {}
+    virtual void DoLeaveNode() noexcept {}
+private:
     bool readOnly_ {};
     bool flushAllItems_ {};
+    bool lazyLoad_ {};
+    bool retainDocument_ {};
     bool markedForFlush_ {};
+    TConfigArena arena_;   // must outlive root_
     TConfigNodePtr root_;
+
+    void LoadNode( TConfigNode& Node, TConfigPath const & Path,
+                   std::size_t Levels ) override {
+        DoBeginLazyRead();
+        std::size_t Entered {};
+        try {
+            for ( auto const & Name : Path ) {
+                EnterNode( Name );
+                ++Entered;
+            }
+            Node.ReadLazy( *this, *this, Path, Levels );
+        }
+        catch ( ... ) {
+            while ( Entered-- ) { LeaveNode(); }
+            DoEndLazyRead();
+            throw;
+        }
+        while ( Entered-- ) { LeaveNode(); }
+        DoEndLazyRead();
+    }
 };
 
 //---------------------------------------------------------------------------
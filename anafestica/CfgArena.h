@@ -0,0 +1,344 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgArenaH
+#define CfgArenaH
+
+// Portable, std-only header (see Bench/bench_arena.cpp).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined( __has_include )
+# if __has_include( <memory_resource> )
+#  include <memory_resource>
+# endif
+#endif
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+#if defined( __cpp_lib_memory_resource )
+using TMemoryResource = std::pmr::memory_resource;
+#else
+/// Stand-in for @c std::pmr::memory_resource on standard libraries that do
+/// not ship @c <memory_resource>.  Same public interface and the same
+/// virtual hooks, so a resource written against one compiles against the
+/// other.
+class TMemoryResource {
+public:
+    virtual ~TMemoryResource() = default;
+
+    void* allocate( std::size_t Bytes,
+                    std::size_t Alignment = alignof( std::max_align_t ) ) {
+        return do_allocate( Bytes, Alignment );
+    }
+
+    void deallocate( void* Ptr, std::size_t Bytes,
+                     std::size_t Alignment = alignof( std::max_align_t ) ) {
+        do_deallocate( Ptr, Bytes, Alignment );
+    }
+
+    bool is_equal( TMemoryResource const & Other ) const noexcept {
+        return do_is_equal( Other );
+    }
+private:
+    virtual void* do_allocate( std::size_t Bytes, std::size_t Alignment ) = 0;
+    virtual void do_deallocate( void* Ptr, std::size_t Bytes,
+                                std::size_t Alignment ) = 0;
+    virtual bool do_is_equal( TMemoryResource const & Other ) const noexcept = 0;
+};
+#endif
+
+/// Arena backing one configuration tree.
+///
+/// Memory is carved out of large blocks by bumping a pointer.  Requests
+/// are rounded up to a size class (16-byte steps up to 256 bytes, powers
+/// of two above), and a block handed back goes onto the free list of its
+/// class, where the next request of that class picks it up; the most
+/// recent allocation is simply given back to the bump pointer.  A tree
+/// that keeps regrowing containers, re-reading nodes and replacing
+/// children therefore reuses its own storage instead of growing the
+/// arena.  Every block is released at once when the arena is destroyed,
+/// so tearing down a tree of N nodes costs a handful of frees instead of
+/// several per node.
+///
+/// Blocks come from @p Upstream when one is supplied (any
+/// @c std::pmr::memory_resource, or @ref TMemoryResource where
+/// @c <memory_resource> is unavailable), otherwise from the global
+/// @c operator new.
+///
+/// Objects placed in the arena must still be destroyed by their owner:
+/// the arena only reclaims storage.  Value payloads (@c String, @c TBytes,
+/// vectors) keep their own storage; only nodes and their containers live
+/// here.
+class TConfigArena {
+public:
+    static constexpr std::size_t InitialBlockSize = 4 * 1024;
+    static constexpr std::size_t MaxBlockSize = 1024 * 1024;
+
+    explicit TConfigArena( TMemoryResource* Upstream = nullptr ) noexcept
+        : upstream_{ Upstream } {}
+
+    TConfigArena( TConfigArena const & ) = delete;
+    TConfigArena& operator=( TConfigArena const & ) = delete;
+
+    ~TConfigArena() { Release(); }
+
+    [[nodiscard]] void* Allocate( std::size_t Bytes, std::size_t Alignment ) {
+        auto const Class = ClassOf( Bytes );
+        auto const Size = ClassSize( Class, Bytes );
+        if ( Class < ClassCount ) {
+            auto& Free = free_[Class];
+            if ( Free && IsAligned( Free, Alignment ) ) {
+                auto p = reinterpret_cast<std::byte*>( Free );
+                Free = Free->Next;
+                bytesUsed_ += Size;
+                return p;
+            }
+        }
+        Alignment = std::max( Alignment, alignof( FreeEntry ) );
+        auto p = AlignUp( cur_, Alignment );
+        if ( !head_ || p + Size > end_ ) {
+            NewBlock( Size + Alignment );
+            p = AlignUp( cur_, Alignment );
+        }
+        last_ = p;
+        cur_ = p + Size;
+        bytesUsed_ += Size;
+        return p;
+    }
+
+    /// Gives back @p Ptr, which @ref Allocate returned for @p Bytes.
+    void Deallocate( void* Ptr, std::size_t Bytes ) noexcept {
+        if ( !Ptr ) {
+            return;
+        }
+        auto const Class = ClassOf( Bytes );
+        auto const Size = ClassSize( Class, Bytes );
+        bytesUsed_ -= Size;
+        if ( Ptr == last_ && last_ + Size == cur_ ) {
+            cur_ = last_;
+            last_ = nullptr;
+        }
+        else if ( Class < ClassCount ) {
+            free_[Class] = ::new( Ptr ) FreeEntry{ free_[Class] };
+        }
+    }
+
+    /// Frees every block.  Anything still living in the arena is left
+    /// dangling, so this is only for owners that have already destroyed
+    /// their objects.
+    void Release() noexcept {
+        while ( head_ ) {
+            auto Next = head_->Next;
+            auto const Size = head_->Size;
+            FreeBlock( head_, Size );
+            head_ = Next;
+        }
+        cur_ = end_ = last_ = nullptr;
+        std::fill( std::begin( free_ ), std::end( free_ ), nullptr );
+        blockCount_ = 0;
+        bytesReserved_ = 0;
+        bytesUsed_ = 0;
+    }
+
+    [[nodiscard]] TMemoryResource* GetUpstream() const noexcept { return upstream_; }
+
+    /// Number of blocks obtained from the upstream resource.
+    [[nodiscard]] std::size_t GetBlockCount() const noexcept { return blockCount_; }
+
+    /// Total size of those blocks, in bytes.
+    [[nodiscard]] std::size_t GetBytesReserved() const noexcept { return bytesReserved_; }
+
+    /// Bytes handed out and not given back (rounded to their size class).
+    [[nodiscard]] std::size_t GetBytesUsed() const noexcept { return bytesUsed_; }
+
+private:
+    struct BlockHeader {
+        BlockHeader* Next;
+        std::size_t Size;
+    };
+
+    // Link of a free list, written over the block it stands for.
+    struct FreeEntry {
+        FreeEntry* Next;
+    };
+
+    static constexpr std::size_t SmallStep = 16;
+    static constexpr std::size_t SmallLimit = 256;
+    static constexpr std::size_t SmallClasses = SmallLimit / SmallStep;
+    // Power-of-two classes from 512 bytes up to MaxBlockSize; larger
+    // requests get no free list.
+    static constexpr std::size_t ClassCount = SmallClasses + 12;
+
+    TMemoryResource* upstream_;
+    BlockHeader* head_ {};
+    std::byte* cur_ {};
+    std::byte* end_ {};
+    std::byte* last_ {};
+    FreeEntry* free_[ClassCount] {};
+    std::size_t nextBlockSize_ { InitialBlockSize };
+    std::size_t blockCount_ {};
+    std::size_t bytesReserved_ {};
+    std::size_t bytesUsed_ {};
+
+    static std::byte* AlignUp( std::byte* Ptr, std::size_t Alignment ) noexcept {
+        auto const v = reinterpret_cast<std::uintptr_t>( Ptr );
+        return reinterpret_cast<std::byte*>(
+            ( v + Alignment - 1 ) & ~( static_cast<std::uintptr_t>( Alignment ) - 1 )
+        );
+    }
+
+    static bool IsAligned( void const * Ptr, std::size_t Alignment ) noexcept {
+        return ( reinterpret_cast<std::uintptr_t>( Ptr ) & ( Alignment - 1 ) ) == 0;
+    }
+
+    static std::size_t ClassOf( std::size_t Bytes ) noexcept {
+        if ( Bytes <= SmallLimit ) {
+            return Bytes ? ( Bytes - 1 ) / SmallStep : 0;
+        }
+        std::size_t Class { SmallClasses };
+        for ( auto Size = SmallLimit * 2 ; Size < Bytes && Class < ClassCount ; Size *= 2 ) {
+            ++Class;
+        }
+        return Class;
+    }
+
+    // Bytes taken by a request of @p Bytes in @p Class (unrounded past
+    // the last class).
+    static std::size_t ClassSize( std::size_t Class, std::size_t Bytes ) noexcept {
+        if ( Class < SmallClasses ) {
+            return ( Class + 1 ) * SmallStep;
+        }
+        return Class < ClassCount ? SmallLimit * 2 << ( Class - SmallClasses ) : Bytes;
+    }
+
+    void NewBlock( std::size_t MinPayload ) {
+        auto const Size =
+            std::max( nextBlockSize_, MinPayload + sizeof( BlockHeader ) );
+        auto Raw = static_cast<std::byte*>(
+            upstream_ ?
+              upstream_->allocate( Size, alignof( std::max_align_t ) )
+            :
+              ::operator new( Size )
+        );
+        auto Header = reinterpret_cast<BlockHeader*>( Raw );
+        Header->Next = head_;
+        Header->Size = Size;
+        head_ = Header;
+        cur_ = Raw + sizeof( BlockHeader );
+        end_ = Raw + Size;
+        last_ = nullptr;
+        ++blockCount_;
+        bytesReserved_ += Size;
+        nextBlockSize_ = std::min( nextBlockSize_ * 2, MaxBlockSize );
+    }
+
+    void FreeBlock( BlockHeader* Block, std::size_t Size ) noexcept {
+        if ( upstream_ ) {
+            upstream_->deallocate( Block, Size, alignof( std::max_align_t ) );
+        }
+        else {
+            ::operator delete( Block );
+        }
+    }
+};
+
+/// Allocator drawing from a @ref TConfigArena, or from the global heap when
+/// constructed without one (the default, so containers that are not part
+/// of an arena-backed tree behave exactly like @c std::allocator).
+///
+/// The arena follows the container on move and swap.  A copy-constructed
+/// container goes to the global heap, so copying values out of a tree
+/// never leaves them tied to the lifetime of the owning @c TConfig.
+template<typename T>
+class TArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using is_always_equal = std::false_type;
+
+    TArenaAllocator() noexcept = default;
+    TArenaAllocator( TConfigArena* Arena ) noexcept : arena_{ Arena } {}
+
+    template<typename U>
+    TArenaAllocator( TArenaAllocator<U> const & Other ) noexcept
+        : arena_{ Other.GetArena() } {}
+
+    [[nodiscard]] T* allocate( std::size_t Count ) {
+        if ( arena_ ) {
+            return static_cast<T*>(
+                arena_->Allocate( Count * sizeof( T ), alignof( T ) )
+            );
+        }
+        return std::allocator<T>{}.allocate( Count );
+    }
+
+    void deallocate( T* Ptr, std::size_t Count ) noexcept {
+        if ( arena_ ) {
+            arena_->Deallocate( Ptr, Count * sizeof( T ) );
+        }
+        else {
+            std::allocator<T>{}.deallocate( Ptr, Count );
+        }
+    }
+
+    TArenaAllocator select_on_container_copy_construction() const noexcept {
+        return {};
+    }
+
+    [[nodiscard]] TConfigArena* GetArena() const noexcept { return arena_; }
+
+    template<typename U>
+    friend bool operator==( TArenaAllocator const & Lhs,
+                            TArenaAllocator<U> const & Rhs ) noexcept {
+        return Lhs.GetArena() == Rhs.GetArena();
+    }
+
+    template<typename U>
+    friend bool operator!=( TArenaAllocator const & Lhs,
+                            TArenaAllocator<U> const & Rhs ) noexcept {
+        return !( Lhs == Rhs );
+    }
+
+private:
+    TConfigArena* arena_ {};
+};
+
+/// Creates a @c T in @p Arena (or on the heap when @p Arena is null).
+/// Pair with @ref ArenaDelete.
+template<typename T, typename... A>
+T* ArenaNew( TConfigArena* Arena, A&&... Args )
+{
+    if ( !Arena ) {
+        return new T( std::forward<A>( Args )... );
+    }
+    auto Mem = Arena->Allocate( sizeof( T ), alignof( T ) );
+    return ::new( Mem ) T( std::forward<A>( Args )... );
+}
+
+template<typename T>
+void ArenaDelete( TConfigArena* Arena, T* Ptr ) noexcept
+{
+    if ( !Arena ) {
+        delete Ptr;
+    }
+    else if ( Ptr ) {
+        Ptr->~T();
+        Arena->Deallocate( Ptr, sizeof( T ) );
+    }
+}
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
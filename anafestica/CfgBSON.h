@@ -13,14 +13,23 @@
 #include <System.SysUtils.hpp>
 #include <System.Classes.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
-#include <array>
-#include <functional>
 #include <iterator>
 
 #include <anafestica/Cfg.h>
+#include <anafestica/CfgCodec.h>
+#include <anafestica/CfgNodeCursor.h>
 #include <anafestica/CfgCrypt.h>
+#include <anafestica/CfgFileStamp.h>
+#include <anafestica/CfgFlushPlan.h>
+#include <anafestica/CfgBSONWire.h>
 
 //---------------------------------------------------------------------------
 namespace Anafestica {
@@ -28,6 +37,28 @@ namespace Anafestica {
 namespace BSON {
 //---------------------------------------------------------------------------
 
+/// How a BSON configuration object stores its values, chosen with the
+/// constructor's @c Encoding argument.
+///
+/// @code
+/// BSON::TConfig Cfg( FileName, false, false, false, {}, BSON::TEncoding::Native );
+/// Cfg.GetRootNode().PutItem( _D( "Thumb" ), Bytes );  // "Thumb@dab": binary
+/// @endcode
+///
+/// In @ref TEncoding::Native a tagged value is stored under
+/// <tt>"<name>@<tag>"</tt> with a BSON payload instead of a
+/// <tt>{ "<tag>": <payload> }</tt> document: byte arrays as binary
+/// (subtype 0), @c TDateTime as a UTC datetime holding the value's
+/// fields as they are, @c Currency and <tt>unsigned long long</tt> as
+/// Decimal128, the other integers as Int32 or Int64.  Such files are read
+/// and written by the object alone, never through the RTL document, so
+/// the object loads eagerly whatever the @ref TLoadMode.  Portable files
+/// load as well, and the values a flush writes take the native form.
+enum class TEncoding {
+    Portable,   ///< the layout of the JSON backend (default)
+    Native      ///< BSON types, with the type tag as a name suffix
+};
+
 class TConfig : public Anafestica::TConfig {
 private:
     static constexpr LPCTSTR ValuesNodeName = _D( "values" );
@@ -35,15 +66,17 @@ private:
 public:
     TConfig( String FileName, bool ReadOnly = false,
              bool FlushAllItems = false, bool ExplicitTypes = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, FlushAllItems )
+             Crypt::TOptions CryptOptions = {},
+             TEncoding Encoding = TEncoding::Portable,
+             TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, FlushAllItems, Options )
         , fileName_{ FileName }, loadFileName_{ FileName }
         , explicitTypes_{ ExplicitTypes }
+        , native_{ Encoding == TEncoding::Native }
         , cryptOptions_{ CryptOptions }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
-            BSONObjRAII BSON{ *this };
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
         }
     }
 
@@ -54,18 +87,20 @@ public:
     /// wrapper that makes the load/save direction unambiguous.
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false, bool ExplicitTypes = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true )
+             Crypt::TOptions CryptOptions = {},
+             TEncoding Encoding = TEncoding::Portable,
+             TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true, Options )
         , fileName_{ SaveFileName }
         , loadFileName_{
             TFile::Exists( SaveFileName ) ? SaveFileName : LoadFileName
           }
         , explicitTypes_{ ExplicitTypes }
+        , native_{ Encoding == TEncoding::Native }
         , cryptOptions_{ CryptOptions }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
-            BSONObjRAII BSON{ *this };
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
             if ( loadFileName_ != fileName_ ) {
                 MarkForFlush();
             }
@@ -74,10 +109,13 @@ public:
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false, bool ExplicitTypes = false,
-                            Crypt::TOptions CryptOptions = {} )
+                            Crypt::TOptions CryptOptions = {},
+                            TEncoding Encoding = TEncoding::Portable,
+                            TConfigOptions Options = {} )
     {
         return TConfig(
-            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, CryptOptions
+            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, CryptOptions,
+            Encoding, Options
         );
     }
 
@@ -98,7 +136,11 @@ private:
     public:
         BSONObjRAII( TConfig& Cfg ) : cfg_{ Cfg } { Cfg.CreateBSONDocument(); }
         ~BSONObjRAII() {
-            try { cfg_.DestroyAndCloseBSONDocument(); } catch ( ... ) {}
+            // In lazy mode the document stays open for on-demand loads,
+            // in retain mode for the next flush.
+            if ( !cfg_.GetLazyLoadFlag() && !cfg_.GetRetainDocumentFlag() ) {
+                try { cfg_.DestroyAndCloseBSONDocument(); } catch ( ... ) {}
+            }
         }
         BSONObjRAII( BSONObjRAII const & ) = delete;
         BSONObjRAII& operator=( BSONObjRAII const & ) = delete;
@@ -110,7 +152,12 @@ private:
     String fileName_;
     String loadFileName_;
     bool explicitTypes_;
+    bool native_;                       // TEncoding::Native
     Crypt::TOptions cryptOptions_;
+    TNodeCursor<TJSONObject*> cursor_;
+    TDocumentStamp documentStamp_;
+    Crypt::Bytes text_;                 // retained bytes of the streamed path
+    TDocumentStamp textStamp_;
 
     std::unique_ptr<TStream> OpenReadStream( String const & FileName ) const {
         if ( cryptOptions_.Enabled ) {
@@ -142,6 +189,14 @@ private:
     }
 
     void CreateBSONDocument() {
+        // Retain mode: the document left by the last load or flush is
+        // reused while the file is as it was then.
+        if ( document_ && documentStamp_.Matches( loadFileName_ ) ) {
+            return;
+        }
+        if ( GetRetainDocumentFlag() ) {
+            documentStamp_.Take( loadFileName_ );
+        }
         document_.reset();
         if ( TFile::Exists( loadFileName_ ) ) {
             auto Stream = OpenReadStream( loadFileName_ );
@@ -171,26 +226,35 @@ private:
         document_.reset();
     }
 
-    TJSONObject* OpenPath( TConfigPath const & Path ) {
-        if ( auto Node = dynamic_cast<TJSONObject*>( document_.get() ) ) {
-            for ( auto const & NodeName : Path ) {
-                if ( auto NodesInner = Node->FindValue( NodesNodeName ) ) {
-                    if ( auto Inner = NodesInner->FindValue( NodeName ) ) {
-                        if ( auto NodeObj = dynamic_cast<TJSONObject*>( Inner ) ) {
-                            Node = NodeObj;
-                            continue;
-                        }
-                    }
+    // Replaces Node with its child node Name; false when there is none.
+    static bool OpenChild( TJSONObject*& Node, String const & Name ) {
+        if ( auto NodesInner = Node->FindValue( NodesNodeName ) ) {
+            if ( auto Inner = NodesInner->FindValue( Name ) ) {
+                if ( auto NodeObj = dynamic_cast<TJSONObject*>( Inner ) ) {
+                    Node = NodeObj;
+                    return true;
                 }
-                return nullptr;
             }
-            return Node;
+        }
+        return false;
+    }
+
+    // Opens the first Levels components of Path.
+    TJSONObject* OpenPath( TConfigPath const & Path, std::size_t Levels ) {
+        if ( auto Node = dynamic_cast<TJSONObject*>( document_.get() ) ) {
+            if ( cursor_.Resolve( Node, Path, Levels, &OpenChild ) ) {
+                return Node;
+            }
         }
         return nullptr;
     }
 
-    TJSONObject* OpenNodes( TConfigPath const & Path ) {
-        if ( auto Node = OpenPath( Path ) ) {
+    TJSONObject* OpenPath( TConfigPath const & Path ) {
+        return OpenPath( Path, Path.size() );
+    }
+
+    TJSONObject* OpenNodes( TConfigPath const & Path, std::size_t Levels ) {
+        if ( auto Node = OpenPath( Path, Levels ) ) {
             if ( auto Inner = Node->FindValue( NodesNodeName ) ) {
                 return dynamic_cast<TJSONObject*>( Inner );
             }
@@ -198,6 +262,10 @@ private:
         return nullptr;
     }
 
+    TJSONObject* OpenNodes( TConfigPath const & Path ) {
+        return OpenNodes( Path, Path.size() );
+    }
+
     TJSONObject* OpenValues( TConfigPath const & Path ) {
         if ( auto Node = OpenPath( Path ) ) {
             if ( auto Inner = Node->FindValue( ValuesNodeName ) ) {
@@ -207,26 +275,29 @@ private:
         return nullptr;
     }
 
+    // Returns member Name of Node, adding an empty object when it is
+    // missing.  A member that is not an object is stepped over.
+    static TJSONObject* ForceObject( TJSONObject* Node, String const & Name ) {
+        if ( auto Inner = Node->FindValue( Name ) ) {
+            if ( auto ANode = dynamic_cast<TJSONObject*>( Inner ) ) {
+                return ANode;
+            }
+            return Node;
+        }
+        auto InnerObj = std::make_unique<TJSONObject>();
+        Node->AddPair( Name, InnerObj.get() );
+        return InnerObj.release();
+    }
+
+    // Replaces Node with its child node Name, creating it when missing.
+    static bool ForceChild( TJSONObject*& Node, String const & Name ) {
+        Node = ForceObject( ForceObject( Node, NodesNodeName ), Name );
+        return true;
+    }
+
     TJSONObject* ForcePath( TConfigPath const & Path ) {
         if ( auto Node = dynamic_cast<TJSONObject*>( document_.get() ) ) {
-            TConfigPath FPath;
-            FPath.reserve( Path.size() * 2 );
-            for ( auto const & NodeName : Path ) {
-                FPath.push_back( NodesNodeName );
-                FPath.push_back( NodeName );
-            }
-            for ( auto const & NodeName : FPath ) {
-                if ( auto Inner = Node->FindValue( NodeName ) ) {
-                    if ( auto ANode = dynamic_cast<TJSONObject*>( Inner ) ) {
-                        Node = ANode;
-                    }
-                }
-                else {
-                    auto InnerObj = std::make_unique<TJSONObject>();
-                    Node->AddPair( NodeName, InnerObj.get() );
-                    Node = InnerObj.release();
-                }
-            }
+            cursor_.Resolve( Node, Path, &ForceChild );
             return Node;
         }
         return nullptr;
@@ -294,404 +365,1526 @@ private:
         }
     }
 
-    template<class...>
-    static constexpr bool always_false_v = false;
+    std::unique_ptr<TBase64Encoding> base64_ { new TBase64Encoding{ 0 } };
 
-    template<class... Ts>
-    struct overload : Ts...
-    {
-      using Ts::operator()...;
+    // Value codec.  A value is written as { "<tag>": <payload> }, except an
+    // int, bool or String when explicit types are off; the alternatives
+    // without a native JSON form are stored as their text form.
+    struct TValueCodec {
+        TConfig& Cfg;
 
-      template<typename T>
-      constexpr void operator()(T) const
-      {
-        static_assert(always_false_v<T>, "Unsupported type");
-      }
-    };
+        template<typename C, typename T>
+        static void EncodeNumber( TJSONObject& Obj, String const & Name, T Val ) {
+            WriteNumber<C>( Obj, Codec::TagName<T>(), Name, Val );
+        }
 
-    template<class... Ts>
-    overload(Ts...) -> overload<Ts...>;
+        template<typename T>
+        static void EncodeText( TJSONObject& Obj, String const & Name, T const & Val ) {
+            Write(
+                Obj, Codec::TagName<T>(), Name,
+                std::make_unique<TJSONString>(
+                    Codec::TTextCodec::Encode( Codec::TAs<T>{}, Val )
+                )
+            );
+        }
 
-    std::unique_ptr<TBase64Encoding> base64_ { new TBase64Encoding{ 0 } };
+        template<typename T>
+        static T DecodeText( TJSONValue& Value ) {
+            return
+                Codec::TTextCodec::Decode(
+                    Codec::TAs<T>{}, Value.GetValue<String>()
+                );
+        }
 
-    void SaveValue( TJSONObject& Obj, ValueContType::value_type const & v ) {
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::visit(
-#else
-        boost::apply_visitor(
-#endif
-            overload {
-                [this, &Obj, &v]( int Val ) {
-                    if ( explicitTypes_ ) {
-                        WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_I ), v.first, Val );
-                    }
-                    else {
-                        Write(
-                            Obj, v.first,
-                            std::make_unique<TJSONNumber>( Val )
-                        );
-                    }
-                },
-
-                [&Obj, &v]( unsigned int Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_U ), v.first, Val );
-                },
-
-                [&Obj, &v]( long Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_L ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned long Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_UL ), v.first, Val );
-                },
-
-                [&Obj, &v]( char Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_C ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned char Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_UC ), v.first, Val );
-                },
-
-                [&Obj, &v]( short Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_S ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned short Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_US ), v.first, Val );
-                },
-
-                [&Obj, &v]( long long Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_LL ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned long long Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_ULL ), v.first,
-                        std::make_unique<TJSONString>(
-#if defined( _UNICODE )
-                            std::to_wstring( Val ).c_str()
-#else
-                            std::to_string( Val ).c_str()
-#endif
-                        )
-                    );
-                },
-
-                [this, &Obj, &v]( bool Val ) {
-                    if ( explicitTypes_ ) {
-                        Write(
-                            Obj, ana_cnv_xstr( ANA_TT_B ), v.first,
-                            std::make_unique<TJSONBool>( Val )
-                        );
-                    }
-                    else {
-                        Write(
-                            Obj, v.first,
-                            std::make_unique<TJSONBool>( Val )
-                        );
-                    }
-                },
-
-                [this, &Obj, &v]( System::UnicodeString Val ) {
-                    if ( explicitTypes_ ) {
-                        Write(
-                            Obj, ana_cnv_xstr( ANA_TT_SZ ), v.first,
-                            std::make_unique<TJSONString>( Val )
-                        );
-                    }
-                    else {
-                        Write(
-                            Obj, v.first,
-                            std::make_unique<TJSONString>( Val )
-                        );
-                    }
-                },
-
-                [&Obj, &v]( System::TDateTime Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_DT ), v.first,
-                        std::make_unique<TJSONString>(
-                            DateToISO8601( Val, false )
-                        )
-                    );
-                },
-
-                [&Obj, &v]( float Val ) {
-                    WriteNumber<double>( Obj, ana_cnv_xstr( ANA_TT_FLT ), v.first, Val );
-                },
-
-                [&Obj, &v]( double Val ) {
-                    WriteNumber<double>( Obj, ana_cnv_xstr( ANA_TT_DBL ), v.first, Val );
-                },
-
-                [&Obj, &v]( System::Currency Val ) {
-                    TFormatSettings FS;
-                    FS.DecimalSeparator = _D( '.' );
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_CUR ), v.first,
-                        std::make_unique<TJSONString>( CurrToStr( Val, FS ) )
-                    );
-                },
-
-                [&Obj, &v]( StringCont const & Val ) {
-                    WriteStrings( Obj, ana_cnv_xstr( ANA_TT_SV ), v.first, Val );
-                },
-
-                [this, &Obj, &v]( TBytes Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_DAB ), v.first,
-                        std::make_unique<TJSONString>(
-                            Val.Length == 0 ?
-                              String()
-                            :
-                              base64_->EncodeBytesToString(
-                                  &Val[0], Val.High
-                              )
-                        )
-                    );
-                },
-
-                [this, &Obj, &v]( std::vector<Byte> const & Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_VB ), v.first,
-                        std::make_unique<TJSONString>(
-                            Val.empty() ?
-                              String()
-                            :
-                              base64_->EncodeBytesToString(
-                                  Val.data(), Val.size() - 1
-                              )
-                        )
-                    );
-                },
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                [&Obj, &v]( std::string const & Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_STR ), v.first,
-                        std::make_unique<TJSONString>(
-                            UTF8ToString( Val.c_str() )
-                        )
-                    );
-                },
-
-                [&Obj, &v]( std::wstring const & Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_WSTR ), v.first,
-                        std::make_unique<TJSONString>(
-                            String( Val.c_str() )
-                        )
-                    );
-                }
-#endif
-            },
-            v.second.first
-        );
-    }
+        String EncodeBytes( Byte const * Data, int High ) const {
+            return Cfg.base64_->EncodeBytesToString( Data, High );
+        }
 
-protected:
-    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+        void Encode( Codec::TAs<int>, int Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            if ( Cfg.explicitTypes_ ) {
+                EncodeNumber<int>( Obj, Name, Val );
+            }
+            else {
+                Write( Obj, Name, std::make_unique<TJSONNumber>( Val ) );
+            }
+        }
 
-        using Fn = std::function<TConfigNodeValueType(TJSONValue&)>;
+        void Encode( Codec::TAs<unsigned int>, unsigned int Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
 
-        static std::array<Fn,
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::variant_size<TConfigNodeValueType>::value
-#else
-            TConfigNodeValueType::types::size::value
-#endif
-        > Builders {
-            []( TJSONValue& Value ) { return Value.GetValue<int>(); },
-            []( TJSONValue& Value ) { return Value.GetValue<unsigned>(); },
-            []( TJSONValue& Value ) { return static_cast<long>( Value.GetValue<__int64>() ); },
-            []( TJSONValue& Value ) { return static_cast<unsigned long>( Value.GetValue<__int64>() ); },
-            []( TJSONValue& Value ) { return static_cast<char>( Value.GetValue<int>() ); },
-            []( TJSONValue& Value ) { return Value.GetValue<unsigned char>(); },
-            []( TJSONValue& Value ) { return Value.GetValue<short>(); },
-            []( TJSONValue& Value ) { return Value.GetValue<unsigned short>(); },
-            []( TJSONValue& Value ) { return Value.GetValue<__int64>(); },
-            []( TJSONValue& Value ) { return std::stoull( Value.GetValue<String>().c_str() ); },
-            []( TJSONValue& Value ) { return Value.GetValue<bool>(); },
-            []( TJSONValue& Value ) { return Value.GetValue<String>(); },
-            []( TJSONValue& Value ) { return ISO8601ToDate( Value.GetValue<String>(), false ); },
-            []( TJSONValue& Value ) { return Value.GetValue<float>(); },
-            []( TJSONValue& Value ) { return Value.GetValue<double>(); },
-            []( TJSONValue& Value ) {
-                TFormatSettings FS;
-                FS.DecimalSeparator = _D( '.' );
-                return StrToCurr( Value.GetValue<String>(), FS );
-            },
-            []( TJSONValue& Value ) {
-                StringCont Strings;
-                if ( auto JSONArr = dynamic_cast<TJSONArray*>( &Value ) ) {
-                    Strings.reserve( JSONArr->Count );
-                    std::transform(
-                        System::begin( JSONArr ), System::end( JSONArr ),
-                        std::back_inserter( Strings ),
-                        []( auto Val ){ return Val->template GetValue<String>(); }
-                    );
-                }
-                return Strings;
-            },
-            []( TJSONValue& Value ) {
-                return
-                    TNetEncoding::Base64->DecodeStringToBytes(
-                        Value.GetValue<String>()
-                    );
-            },
-            []( TJSONValue& Value ) {
-                auto Bytes = TNetEncoding::Base64->DecodeStringToBytes(
-                    Value.GetValue<String>()
-                );
-                std::vector<Byte> VBytes;
-                VBytes.reserve( Bytes.Length );
-                std::copy(
-                    std::begin( Bytes ),
-                    std::end( Bytes ),
-                    std::back_inserter( VBytes )
-                );
-                return VBytes;
-            },
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            []( TJSONValue& Value ) {
-                return std::string(
-                    UTF8Encode( Value.GetValue<String>() ).c_str()
-                );
-            },
-            []( TJSONValue& Value ) {
-                auto s = Value.GetValue<String>();
-                return std::wstring( s.c_str() );
-            },
-#endif
-        };
+        void Encode( Codec::TAs<long>, long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
 
-        ValueContType Values;
+        void Encode( Codec::TAs<unsigned long>, unsigned long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
 
-        if ( auto Key = OpenValues( Path ) ) {
-            for ( int Idx = 0 ; Idx < Key->Count ; ++Idx ) {
-                auto const & Pair = Key->Pairs[Idx];
-                if ( dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
-                    if ( auto InnerObj = dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
-                        if ( InnerObj->Count == 1 ) {
-                            auto const & InnerPair = InnerObj->Pairs[0];
-                            auto TypeName = InnerPair->JsonString->Value();
-                            if ( auto Result = GetTypeTag( TypeName ) ) {
-                                PutItemTo(
-                                    Values, Pair->JsonString->Value(),
-                                    {
-                                        Builders[static_cast<size_t>( Result.value() )](
-                                            *InnerPair->JsonValue
-                                        ),
-                                        Operation::None
-                                    }
-                                );
-                            }
-                        }
-                    }
-                }
-                else if ( auto Ptr = dynamic_cast<TJSONNumber*>( Pair->JsonValue ) ) {
-                    PutItemTo(
-                        Values, Pair->JsonString->Value(),
-                        {
-                            TConfigNodeValueType{ Ptr->AsInt },
-                            Operation::None
-                        }
-                    );
-                }
-                else if ( auto Ptr = dynamic_cast<TJSONString*>( Pair->JsonValue ) ) {
-                    PutItemTo(
-                        Values, Pair->JsonString->Value(),
-                        {
-                            TConfigNodeValueType{ Ptr->Value() },
-                            Operation::None
-                        }
-                    );
-                }
-                else if ( auto Ptr = dynamic_cast<TJSONBool*>( Pair->JsonValue ) ) {
-                    PutItemTo(
-                        Values, Pair->JsonString->Value(),
-                        {
-                            TConfigNodeValueType{ Ptr->AsBoolean },
-                            Operation::None
-                        }
-                    );
-                }
-            }
+        void Encode( Codec::TAs<char>, char Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
         }
-        return Values;
-    }
 
-    virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
-        NodeContType Nodes;
+        void Encode( Codec::TAs<unsigned char>, unsigned char Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
+        }
 
-        if ( auto Node = OpenNodes( Path ) ) {
-            for ( int Idx = 0 ; Idx < Node->Count ; ++Idx ) {
-                auto const & Pair = Node->Pairs[Idx];
-                if ( dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
-                    auto NodeName = Pair->JsonString->Value();
-                    Nodes[NodeName] = std::move( std::make_unique<TConfigNode>() );
-                }
-            }
+        void Encode( Codec::TAs<short>, short Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
         }
-        return Nodes;
-    }
 
-    virtual void DoSaveValueList( TConfigPath const & Path, ValueContType const & Values ) override {
-        if ( !Values.empty() ) {
-            if ( auto Node = ForceValues( Path ) ) {
-                for ( auto& v : Values ) {
-                    auto const ValueState = v.second.second;
-                    if ( GetAlwaysFlushNodeFlag() || ValueState == Operation::Write ) {
-                        SaveValue( *Node, v );
-                    }
-                    else if ( v.second.second == Operation::Erase ) {
-                        Node->RemovePair( v.first );
-                    }
-                }
+        void Encode( Codec::TAs<unsigned short>, unsigned short Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<long long>, long long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<unsigned long long>, unsigned long long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<bool>, bool Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            if ( Cfg.explicitTypes_ ) {
+                Write(
+                    Obj, Codec::TagName<bool>(), Name,
+                    std::make_unique<TJSONBool>( Val )
+                );
+            }
+            else {
+                Write( Obj, Name, std::make_unique<TJSONBool>( Val ) );
             }
         }
-    }
 
-    virtual void DoDeleteNode( TConfigPath const & Path ) override {
-        if ( !Path.empty() ) {
-            auto Last = std::end( Path );
-            std::advance( Last, -1 );
-            TConfigPath TmpPath( std::begin( Path ), Last );
-            if ( auto Node = OpenNodes( TmpPath ) ) {
-                Node->RemovePair( Path.back() );
+        void Encode( Codec::TAs<String>, String const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            if ( Cfg.explicitTypes_ ) {
+                Write(
+                    Obj, Codec::TagName<String>(), Name,
+                    std::make_unique<TJSONString>( Val )
+                );
+            }
+            else {
+                Write( Obj, Name, std::make_unique<TJSONString>( Val ) );
             }
         }
-    }
 
-    virtual void DoFlush() override {
-        BSONObjRAII BSON{ *this };
-        GetRootNode().Write( *this, TConfigPath{} );
+        void Encode( Codec::TAs<TDateTime>, TDateTime Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
 
-        if ( !TFile::Exists( fileName_ ) ) {
-            auto Path = TPath::GetFullPath( TPath::GetDirectoryName( fileName_ ) );
-            if ( !TDirectory::Exists( Path ) ) {
-                TDirectory::CreateDirectory( Path );
-            }
+        void Encode( Codec::TAs<float>, float Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<double>( Obj, Name, Val );
         }
 
-        std::unique_ptr<TStream> Stream =
-            cryptOptions_.Enabled
-                ? std::unique_ptr<TStream>( new TMemoryStream() )
-                : std::unique_ptr<TStream>( new TFileStream( fileName_, fmCreate ) );
-        auto StringReader =
-            std::make_unique<TStringReader>( document_->ToJSON() );
-        auto Writer =
-            std::make_unique<System::Json::Bson::TBsonWriter>( Stream.get() );
-        auto Reader =
-            std::make_unique<System::Json::Readers::TJsonTextReader>(
-                StringReader.get()
+        void Encode( Codec::TAs<double>, double Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<double>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<Currency>, Currency Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<StringCont>, StringCont const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            WriteStrings( Obj, Codec::TagName<StringCont>(), Name, Val );
+        }
+
+        void Encode( Codec::TAs<TBytes>, TBytes Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            Write(
+                Obj, Codec::TagName<TBytes>(), Name,
+                std::make_unique<TJSONString>(
+                    Val.Length == 0 ? String() : EncodeBytes( &Val[0], Val.High )
+                )
             );
-        if ( Reader->Read() ) {
-            Writer->WriteToken( Reader.get(), true );
         }
-        Writer->Flush();
-        SaveBSONStream( std::move( Stream ) );
+
+        void Encode( Codec::TAs<BytesCont>, BytesCont const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            Write(
+                Obj, Codec::TagName<BytesCont>(), Name,
+                std::make_unique<TJSONString>(
+                    Val.empty() ? String() : EncodeBytes( Val.data(), Val.size() - 1 )
+                )
+            );
+        }
+
+        void Encode( Codec::TAs<std::string>, std::string const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<std::wstring>, std::wstring const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        static int Decode( Codec::TAs<int>, TJSONValue& Value ) {
+            return Value.GetValue<int>();
+        }
+
+        static unsigned int Decode( Codec::TAs<unsigned int>, TJSONValue& Value ) {
+            return Value.GetValue<unsigned>();
+        }
+
+        static long Decode( Codec::TAs<long>, TJSONValue& Value ) {
+            return static_cast<long>( Value.GetValue<__int64>() );
+        }
+
+        static unsigned long Decode( Codec::TAs<unsigned long>, TJSONValue& Value ) {
+            return static_cast<unsigned long>( Value.GetValue<__int64>() );
+        }
+
+        static char Decode( Codec::TAs<char>, TJSONValue& Value ) {
+            return static_cast<char>( Value.GetValue<int>() );
+        }
+
+        static unsigned char Decode( Codec::TAs<unsigned char>, TJSONValue& Value ) {
+            return Value.GetValue<unsigned char>();
+        }
+
+        static short Decode( Codec::TAs<short>, TJSONValue& Value ) {
+            return Value.GetValue<short>();
+        }
+
+        static unsigned short Decode( Codec::TAs<unsigned short>, TJSONValue& Value ) {
+            return Value.GetValue<unsigned short>();
+        }
+
+        static long long Decode( Codec::TAs<long long>, TJSONValue& Value ) {
+            return Value.GetValue<__int64>();
+        }
+
+        static unsigned long long Decode( Codec::TAs<unsigned long long>, TJSONValue& Value ) {
+            return DecodeText<unsigned long long>( Value );
+        }
+
+        static bool Decode( Codec::TAs<bool>, TJSONValue& Value ) {
+            return Value.GetValue<bool>();
+        }
+
+        static String Decode( Codec::TAs<String>, TJSONValue& Value ) {
+            return Value.GetValue<String>();
+        }
+
+        static TDateTime Decode( Codec::TAs<TDateTime>, TJSONValue& Value ) {
+            return DecodeText<TDateTime>( Value );
+        }
+
+        static float Decode( Codec::TAs<float>, TJSONValue& Value ) {
+            return Value.GetValue<float>();
+        }
+
+        static double Decode( Codec::TAs<double>, TJSONValue& Value ) {
+            return Value.GetValue<double>();
+        }
+
+        static Currency Decode( Codec::TAs<Currency>, TJSONValue& Value ) {
+            return DecodeText<Currency>( Value );
+        }
+
+        static StringCont Decode( Codec::TAs<StringCont>, TJSONValue& Value ) {
+            StringCont Strings;
+            if ( auto JSONArr = dynamic_cast<TJSONArray*>( &Value ) ) {
+                Strings.reserve( JSONArr->Count );
+                std::transform(
+                    System::begin( JSONArr ), System::end( JSONArr ),
+                    std::back_inserter( Strings ),
+                    []( auto Val ){ return Val->template GetValue<String>(); }
+                );
+            }
+            return Strings;
+        }
+
+        static TBytes Decode( Codec::TAs<TBytes>, TJSONValue& Value ) {
+            return DecodeText<TBytes>( Value );
+        }
+
+        static BytesCont Decode( Codec::TAs<BytesCont>, TJSONValue& Value ) {
+            return DecodeText<BytesCont>( Value );
+        }
+
+        static std::string Decode( Codec::TAs<std::string>, TJSONValue& Value ) {
+            return DecodeText<std::string>( Value );
+        }
+
+        static std::wstring Decode( Codec::TAs<std::wstring>, TJSONValue& Value ) {
+            return DecodeText<std::wstring>( Value );
+        }
+    };
+
+    void SaveValue( TJSONObject& Obj, ValueContType::value_type const & v ) {
+        Codec::Encode( v.second.first, TValueCodec{ *this }, Obj, v.first );
+    }
+
+    static String FromUtf8( std::string_view Text ) {
+        auto const Length = static_cast<int>( Text.size() );
+        if ( std::all_of(
+                Text.begin(), Text.end(),
+                []( char Ch ){ return static_cast<unsigned char>( Ch ) < 0x80; }
+             ) )
+        {
+            String Result;
+            Result.SetLength( Length );
+            std::copy( Text.begin(), Text.end(), Result.c_str() );
+            return Result;
+        }
+        return UTF8ToString( RawByteString( Text.data(), Length ) );
+    }
+
+    static std::string_view ToUtf8( String const & Text, std::string& Buffer ) {
+        auto const First = Text.c_str();
+        auto const Last = First + Text.Length();
+        if ( std::all_of( First, Last, []( WideChar Ch ){ return Ch < 0x80; } ) ) {
+            Buffer.resize( Last - First );
+            std::transform(
+                First, Last, Buffer.begin(),
+                []( WideChar Ch ){ return static_cast<char>( Ch ); }
+            );
+        }
+        else {
+            auto const Utf8 = UTF8Encode( Text );
+            Buffer.assign( Utf8.c_str(), Utf8.Length() );
+        }
+        return Buffer;
+    }
+
+    static std::string_view View( Crypt::Bytes const & Bytes ) {
+        return std::string_view(
+            reinterpret_cast<char const *>( Bytes.data() ), Bytes.size()
+        );
+    }
+
+    // Node names TJSONValue::FindValue would read as a JSON path; the
+    // document reader and writer mishandle them (see TFlushPlanner).
+    static bool IsPortableName( std::string_view Name ) {
+        return
+            !Name.empty() &&
+            Name.find_first_of( ".[]" ) == std::string_view::npos;
+    }
+
+    // The BSON type of a tagged value's payload in native mode: one per
+    // tag, so that a name suffix is only taken for a tag with it.
+    static Wire::TType NativeType( TypeTag Tag ) noexcept {
+        switch ( Tag ) {
+            case TypeTag::TT_I:
+            case TypeTag::TT_C:
+            case TypeTag::TT_UC:
+            case TypeTag::TT_S:
+            case TypeTag::TT_US:   return Wire::TType::Int32;
+            case TypeTag::TT_U:
+            case TypeTag::TT_L:
+            case TypeTag::TT_UL:
+            case TypeTag::TT_LL:   return Wire::TType::Int64;
+            case TypeTag::TT_ULL:
+            case TypeTag::TT_CUR:  return Wire::TType::Decimal128;
+            case TypeTag::TT_B:    return Wire::TType::Bool;
+            case TypeTag::TT_DT:   return Wire::TType::DateTime;
+            case TypeTag::TT_FLT:
+            case TypeTag::TT_DBL:  return Wire::TType::Double;
+            case TypeTag::TT_SV:   return Wire::TType::Array;
+            case TypeTag::TT_DAB:
+            case TypeTag::TT_VB:   return Wire::TType::Binary;
+            default:               return Wire::TType::String;
+        }
+    }
+
+    // The tag of a value stored natively, as "<name>@<tag>" with the
+    // tag's payload type; Name is set to <name>.  Any other element is
+    // read as in the portable layout.
+    static std::optional<TypeTag> NativeTag( Wire::TElement const & Element,
+                                             std::string_view& Name ) {
+        auto const At = Element.Name.rfind( '@' );
+        if ( At == std::string_view::npos ) {
+            return {};
+        }
+        auto const Suffix = Element.Name.substr( At + 1 );
+        auto const Tag = FindTypeTag( Suffix.data(), Suffix.size() );
+        if ( !Tag || NativeType( *Tag ) != Element.Type ) {
+            return {};
+        }
+        Name = Element.Name.substr( 0, At );
+        return Tag;
+    }
+
+    // TDateTime <-> milliseconds since 1970-01-01T00:00.  The fields are
+    // taken as they are, with no zone conversion, as the ISO 8601 text
+    // form takes them.
+    static constexpr long long MSecsInDay = 86400000;
+    static constexpr long long UnixEpochDate = 719163;  // TTimeStamp::Date
+    static constexpr long long MaxTimeStampDate = 3652059;  // 9999-12-31
+
+    // 0001-01-01 to 9999-12-31, the range of TTimeStamp.
+    static bool HasUnixMSecs( TDateTime Val ) noexcept {
+        return Val.Val > -693594.0 && Val.Val < 2958466.0;
+    }
+
+    static long long ToUnixMSecs( TDateTime Val ) {
+        auto const Stamp = DateTimeToTimeStamp( Val );
+        return ( Stamp.Date - UnixEpochDate ) * MSecsInDay + Stamp.Time;
+    }
+
+    static bool FromUnixMSecs( long long Val, TDateTime& Result ) {
+        auto Date = Val / MSecsInDay;
+        auto Time = Val % MSecsInDay;
+        if ( Time < 0 ) {
+            Time += MSecsInDay;
+            --Date;
+        }
+        Date += UnixEpochDate;
+        if ( Date < 1 || Date > MaxTimeStampDate ) {
+            return false;
+        }
+        TTimeStamp Stamp;
+        Stamp.Time = static_cast<int>( Time );
+        Stamp.Date = static_cast<int>( Date );
+        Result = TimeStampToDateTime( Stamp );
+        return true;
+    }
+
+    // Thrown by TStreamLoader and TStreamFlusher on input whose meaning
+    // they leave to the document reader or writer (see StreamRootNode and
+    // StreamFlush).
+    struct EStreamFallback {};
+
+    static void CheckCursor( Wire::TCursor const & Cursor ) {
+        if ( Cursor.GetError() ) {
+            throw EStreamFallback{};
+        }
+    }
+
+    // Builds the tree of an eager load from the file's bytes, with the
+    // rules of DoCreateValueList / DoCreateNodeList applied to the
+    // document CreateBSONDocument would make of them: the first "values"
+    // and "nodes" members of a node count, and only when they are
+    // documents; a node's content is the first member of its name.
+    class TStreamLoader {
+    public:
+        explicit TStreamLoader( TConfig& Cfg ) : cfg_{ Cfg } {}
+
+        void Load( std::string_view Document ) {
+            auto Values = cfg_.NewValueList();
+            auto Nodes = cfg_.NewNodeList();
+            ReadNode( Document, Values, Nodes, 0 );
+            cfg_.GetRootNode().Populate( std::move( Values ), std::move( Nodes ) );
+        }
+    private:
+        TConfig& cfg_;
+
+        void ReadNode( std::string_view Document, ValueContType& Values,
+                       NodeContType& Nodes, std::size_t Depth ) {
+            bool SeenValues {};
+            bool SeenNodes {};
+            Wire::TCursor Cursor{ Document };
+            for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+                if ( Element.Name == "values" && !SeenValues ) {
+                    SeenValues = true;
+                    if ( Element.IsDocument() ) {
+                        ReadValues( Element.GetDocument(), Values );
+                    }
+                }
+                else if ( Element.Name == "nodes" && !SeenNodes ) {
+                    SeenNodes = true;
+                    if ( Element.IsDocument() ) {
+                        ReadNodes( Element.GetDocument(), Nodes, Depth );
+                    }
+                }
+            }
+            CheckCursor( Cursor );
+        }
+
+        void ReadNodes( std::string_view Document, NodeContType& Nodes,
+                        std::size_t Depth ) {
+            // Names whose first member is not a document: such a node is
+            // listed, but opens empty.
+            std::vector<std::string_view> Hollow;
+            Wire::TCursor Cursor{ Document };
+            for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+                bool const IsNode = Element.IsDocument();
+                if ( IsNode && !cfg_.native_ && !IsPortableName( Element.Name ) ) {
+                    throw EStreamFallback{};
+                }
+                auto Name = FromUtf8( Element.Name );
+                if ( Nodes.contains( Name ) ) {
+                    continue;
+                }
+                bool const IsHollow =
+                    std::find( Hollow.begin(), Hollow.end(), Element.Name ) != Hollow.end();
+                if ( !IsNode ) {
+                    if ( !IsHollow ) {
+                        Hollow.push_back( Element.Name );
+                    }
+                    continue;
+                }
+                TConfigNode::CheckPersistenceDepth( Depth + 1 );
+                auto Values = cfg_.NewValueList();
+                auto Children = cfg_.NewNodeList();
+                if ( !IsHollow ) {
+                    ReadNode( Element.GetDocument(), Values, Children, Depth + 1 );
+                }
+                auto Node = cfg_.NewNode();
+                Node->Populate( std::move( Values ), std::move( Children ) );
+                Nodes.try_emplace( std::move( Name ), std::move( Node ) );
+            }
+            CheckCursor( Cursor );
+        }
+
+        // In native mode there is no document reader to leave values
+        // to: a bare Int64 beyond int range is a long long, a bare double
+        // a double, and the other elements it cannot take are skipped.
+        void ReadValues( std::string_view Document, ValueContType& Values ) {
+            bool const Native = cfg_.native_;
+            Wire::TCursor Cursor{ Document };
+            for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+                std::string_view Name;
+                if ( Native ) {
+                    if ( auto const Tag = NativeTag( Element, Name ) ) {
+                        ReadNative( *Tag, Element, Name, Values );
+                        continue;
+                    }
+                }
+                switch ( Element.Type ) {
+                    case Wire::TType::Document:
+                        ReadTagged( Element, Values );
+                        break;
+                    case Wire::TType::Int32:
+                        Put( Values, Element.Name, TConfigNodeValueType{ Element.GetInt32() } );
+                        break;
+                    case Wire::TType::Int64: {
+                        // TJSONNumber::AsInt beyond int range is left to
+                        // the document reader.
+                        auto const Value = Element.GetInt64();
+                        if ( IsInRange<int>( Value ) ) {
+                            Put( Values, Element.Name, TConfigNodeValueType{ static_cast<int>( Value ) } );
+                        }
+                        else if ( Native ) {
+                            Put( Values, Element.Name, TConfigNodeValueType{ static_cast<long long>( Value ) } );
+                        }
+                        else {
+                            throw EStreamFallback{};
+                        }
+                        break;
+                    }
+                    case Wire::TType::String:
+                        Put( Values, Element.Name, TConfigNodeValueType{ FromUtf8( Element.GetString() ) } );
+                        break;
+                    case Wire::TType::Bool:
+                        Put( Values, Element.Name, TConfigNodeValueType{ Element.GetBool() } );
+                        break;
+                    case Wire::TType::Double:
+                        if ( !Native ) {
+                            throw EStreamFallback{};
+                        }
+                        Put( Values, Element.Name, TConfigNodeValueType{ Element.GetDouble() } );
+                        break;
+                    case Wire::TType::Array:
+                    case Wire::TType::Null:
+                        break;
+                    default:
+                        if ( !Native ) {
+                            throw EStreamFallback{};
+                        }
+                        break;
+                }
+            }
+            CheckCursor( Cursor );
+        }
+
+        // A "<name>@<tag>" element; a payload that does not decode (an
+        // integer out of range, a binary of another subtype, ...) is
+        // skipped.
+        void ReadNative( TypeTag Tag, Wire::TElement const & Element,
+                         std::string_view Name, ValueContType& Values ) {
+            try {
+                Put( Values, Name, Codec::Decode( Tag, TNativeCodec{}, Element ) );
+            }
+            catch ( EStreamFallback const & ) {
+            }
+        }
+
+        // A { "<tag>": <payload> } document; anything else is skipped.
+        void ReadTagged( Wire::TElement const & Element, ValueContType& Values ) {
+            Wire::TCursor Cursor{ Element.GetDocument() };
+            Wire::TElement Payload;
+            Wire::TElement Extra;
+            if ( !Cursor.Next( Payload ) || Cursor.Next( Extra ) ) {
+                CheckCursor( Cursor );
+                return;
+            }
+            CheckCursor( Cursor );
+            if ( auto const Tag = FindTypeTag( Payload.Name.data(), Payload.Name.size() ) ) {
+                try {
+                    Put( Values, Element.Name, Codec::Decode( *Tag, TStreamCodec{}, Payload ) );
+                }
+                catch ( EStreamFallback const & ) {
+                    if ( !cfg_.native_ ) {
+                        throw;
+                    }
+                }
+            }
+        }
+
+        static void Put( ValueContType& Values, std::string_view Name,
+                         TConfigNodeValueType Value ) {
+            PutItemTo(
+                Values, FromUtf8( Name ),
+                { std::move( Value ), Operation::None }
+            );
+        }
+
+        template<typename T>
+        static bool IsInRange( long long Value ) noexcept {
+            if constexpr ( std::is_signed_v<T> ) {
+                return
+                    Value >= static_cast<long long>( std::numeric_limits<T>::min() ) &&
+                    Value <= static_cast<long long>( std::numeric_limits<T>::max() );
+            }
+            else {
+                return
+                    Value >= 0 &&
+                    static_cast<unsigned long long>( Value ) <= std::numeric_limits<T>::max();
+            }
+        }
+
+        // Decodes a payload as TValueCodec decodes the value the document
+        // holds for it; the combinations it does not handle are left to
+        // the document reader.
+        struct TStreamCodec {
+            template<typename T>
+            T Decode( Codec::TAs<T> Tag, Wire::TElement const & Payload ) const {
+                switch ( Payload.Type ) {
+                    case Wire::TType::String:
+                        return Codec::TTextCodec::Decode( Tag, FromUtf8( Payload.GetString() ) );
+                    case Wire::TType::Int32:
+                        return FromInteger( Tag, Payload.GetInt32() );
+                    case Wire::TType::Int64:
+                        return FromInteger( Tag, Payload.GetInt64() );
+                    case Wire::TType::Double:
+                        if constexpr ( std::is_floating_point_v<T> ) {
+                            return static_cast<T>( Payload.GetDouble() );
+                        }
+                        break;
+                    case Wire::TType::Bool:
+                        if constexpr ( std::is_same_v<T,bool> ) {
+                            return Payload.GetBool();
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                throw EStreamFallback{};
+            }
+
+            StringCont Decode( Codec::TAs<StringCont>, Wire::TElement const & Payload ) const {
+                switch ( Payload.Type ) {
+                    case Wire::TType::Array: {
+                        StringCont Strings;
+                        Wire::TCursor Cursor{ Payload.GetDocument() };
+                        for ( Wire::TElement Item ; Cursor.Next( Item ) ; ) {
+                            switch ( Item.Type ) {
+                                case Wire::TType::String:
+                                    Strings.push_back( FromUtf8( Item.GetString() ) );
+                                    break;
+                                case Wire::TType::Int32:
+                                    Strings.push_back( IntToStr( Item.GetInt32() ) );
+                                    break;
+                                case Wire::TType::Int64:
+                                    Strings.push_back( IntToStr( static_cast<__int64>( Item.GetInt64() ) ) );
+                                    break;
+                                default:
+                                    throw EStreamFallback{};
+                            }
+                        }
+                        CheckCursor( Cursor );
+                        return Strings;
+                    }
+                    case Wire::TType::String:
+                    case Wire::TType::Int32:
+                    case Wire::TType::Int64:
+                    case Wire::TType::Double:
+                    case Wire::TType::Bool:
+                        return StringCont{};
+                    default:
+                        throw EStreamFallback{};
+                }
+            }
+
+            // An integer in range is taken as is; the rest, the value's
+            // text is decoded as TTextCodec decodes it.
+            template<typename T>
+            static T FromInteger( Codec::TAs<T> Tag, long long Value ) {
+                if constexpr ( std::is_floating_point_v<T> ) {
+                    return static_cast<T>( Value );
+                }
+                else if constexpr ( std::is_integral_v<T> && !std::is_same_v<T,bool> ) {
+                    if ( IsInRange<T>( Value ) ) {
+                        return static_cast<T>( Value );
+                    }
+                }
+                return Codec::TTextCodec::Decode( Tag, IntToStr( Value ) );
+            }
+        };
+
+        // Decodes the payload of a "<name>@<tag>" element, whose type is
+        // NativeType of the tag; throws EStreamFallback when it holds no
+        // value of the tag's alternative.
+        struct TNativeCodec {
+            template<typename T>
+            T Decode( Codec::TAs<T> Tag, Wire::TElement const & Payload ) const {
+                if constexpr ( std::is_same_v<T,bool> ) {
+                    return Payload.GetBool();
+                }
+                else if constexpr ( std::is_same_v<T,unsigned long long> ) {
+                    Wire::TDecimal Decimal;
+                    std::uint64_t Value {};
+                    if ( Payload.GetDecimal( Decimal ) &&
+                         Decimal.Rescale( 0, Value ) &&
+                         ( !Decimal.Negative || !Value ) )
+                    {
+                        return Value;
+                    }
+                }
+                else if constexpr ( std::is_integral_v<T> ) {
+                    long long const Value =
+                        Payload.Type == Wire::TType::Int32
+                            ? Payload.GetInt32()
+                            : Payload.GetInt64();
+                    if ( IsInRange<T>( Value ) ) {
+                        return static_cast<T>( Value );
+                    }
+                }
+                else if constexpr ( std::is_floating_point_v<T> ) {
+                    return static_cast<T>( Payload.GetDouble() );
+                }
+                else if constexpr ( std::is_same_v<T,TDateTime> ) {
+                    TDateTime Value;
+                    if ( FromUnixMSecs( Payload.GetInt64(), Value ) ) {
+                        return Value;
+                    }
+                }
+                else if constexpr ( std::is_same_v<T,Currency> ) {
+                    // The raw value, in units of 1/10000.
+                    Wire::TDecimal Decimal;
+                    std::uint64_t Value {};
+                    if ( Payload.GetDecimal( Decimal ) &&
+                         Decimal.Rescale( -4, Value ) &&
+                         Value <= ( Decimal.Negative ? 1ULL << 63 : ( 1ULL << 63 ) - 1 ) )
+                    {
+                        Currency Result;
+                        Result.Val = static_cast<__int64>( Decimal.Negative ? 0 - Value : Value );
+                        return Result;
+                    }
+                }
+                else if constexpr ( std::is_same_v<T,TBytes> ||
+                                    std::is_same_v<T,BytesCont> ) {
+                    if ( Payload.GetSubtype() == 0 ) {
+                        return ToBytes( Tag, Payload.GetBinary() );
+                    }
+                }
+                else if constexpr ( std::is_same_v<T,StringCont> ) {
+                    return TStreamCodec{}.Decode( Tag, Payload );
+                }
+                else {
+                    return Codec::TTextCodec::Decode( Tag, FromUtf8( Payload.GetString() ) );
+                }
+                throw EStreamFallback{};
+            }
+
+            static TBytes ToBytes( Codec::TAs<TBytes>, std::string_view Data ) {
+                TBytes Bytes;
+                Bytes.Length = static_cast<int>( Data.size() );
+                if ( !Data.empty() ) {
+                    std::copy( Data.begin(), Data.end(), &Bytes[0] );
+                }
+                return Bytes;
+            }
+
+            static BytesCont ToBytes( Codec::TAs<BytesCont>, std::string_view Data ) {
+                return BytesCont( Data.begin(), Data.end() );
+            }
+        };
+    };
+
+    // Copies the file's bytes out with the plan applied as
+    // DoSaveValueList and DoDeleteNode apply it to the document: the first
+    // element of a value or node name is the one replaced or removed,
+    // what is missing is appended.  Elements it has nothing to do with
+    // are copied as they are.  In native mode, where the document writer
+    // is out of the picture, the cases it is left with are settled here:
+    // every duplicate of a deleted node goes with it, and a "values",
+    // "nodes" or node member that is not a document is replaced.
+    class TStreamFlusher {
+    public:
+        TStreamFlusher( TConfig& Cfg, TFlushPlan const & Plan, Crypt::Bytes& Out )
+            : cfg_{ Cfg }, plan_{ Plan }, out_{ Out } {}
+
+        /// Writes the plan as a new document (there is no file yet).
+        void WriteDocument() { WriteNode( plan_ ); }
+
+        void Merge( std::string_view Document ) {
+            out_.BeginDocument();
+            MergeNode( plan_, Document );
+            out_.End();
+        }
+    private:
+        // Marks of a child in MergeNodes.
+        static constexpr unsigned char Seen = 1;
+        static constexpr unsigned char Merged = 2;
+
+        // States of a value in MergeValues.
+        static constexpr unsigned char Copied = 1;
+        static constexpr unsigned char Replaced = 2;
+
+        TConfig& cfg_;
+        TFlushPlan const & plan_;
+        Wire::TWriter<Crypt::Bytes> out_;
+        std::string key_;
+        std::string token_;
+        std::string tagged_;
+
+        void MergeNode( TFlushPlan const & Plan, std::string_view Document ) {
+            bool SeenValues {};
+            bool SeenNodes {};
+            Wire::TCursor Cursor{ Document };
+            for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+                if ( Element.Name == "values" && !SeenValues ) {
+                    SeenValues = true;
+                    if ( Plan.Values ) {
+                        if ( Element.IsDocument() ) {
+                            out_.Key( Element.Name );
+                            out_.BeginDocument();
+                            MergeValues( Plan, Element.GetDocument() );
+                            out_.End();
+                            continue;
+                        }
+                        // Otherwise the document writer saves nothing
+                        // (ForceValues returns null).
+                        if ( cfg_.native_ ) {
+                            WriteValues( Plan );
+                            continue;
+                        }
+                    }
+                }
+                else if ( Element.Name == "nodes" && !SeenNodes ) {
+                    SeenNodes = true;
+                    if ( !Plan.Children.empty() ) {
+                        if ( Element.IsDocument() ) {
+                            out_.Key( Element.Name );
+                            out_.BeginDocument();
+                            MergeNodes( Plan, Element.GetDocument() );
+                            out_.End();
+                            continue;
+                        }
+                        // Where the document writer would force a "nodes"
+                        // document and finds another kind of value, it
+                        // goes astray.
+                        if ( Plan.ChildForces ) {
+                            if ( !cfg_.native_ ) {
+                                throw EStreamFallback{};
+                            }
+                            WriteNodes( Plan );
+                            continue;
+                        }
+                    }
+                }
+                out_.Copy( Element );
+            }
+            CheckCursor( Cursor );
+            if ( Plan.Values && !SeenValues ) {
+                WriteValues( Plan );
+            }
+            if ( Plan.ChildForces && !SeenNodes ) {
+                WriteNodes( Plan );
+            }
+        }
+
+        void MergeValues( TFlushPlan const & Plan, std::string_view Document ) {
+            auto const & Values = *Plan.Values;
+            std::vector<unsigned char> Done( Values.size() );
+            Wire::TCursor Cursor{ Document };
+            for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+                auto Name = Element.Name;
+                if ( cfg_.native_ ) {
+                    NativeTag( Element, Name );
+                }
+                auto const It = Values.find( FromUtf8( Name ) );
+                if ( It != Values.end() ) {
+                    auto& State = Done[It - Values.begin()];
+                    if ( !State ) {
+                        State = Copied;
+                        if ( IsWritten( *It ) ) {
+                            State = Replaced;
+                            Encode( Name, It->second.first );
+                            continue;
+                        }
+                        if ( It->second.second == Operation::Erase ) {
+                            State = Replaced;
+                            continue;
+                        }
+                    }
+                    // The loader lets the last duplicate win: in native
+                    // mode it goes once the first one is replaced.
+                    else if ( State == Replaced && cfg_.native_ ) {
+                        continue;
+                    }
+                }
+                out_.Copy( Element );
+            }
+            CheckCursor( Cursor );
+            auto It = Values.begin();
+            for ( auto Consumed : Done ) {
+                if ( !Consumed ) { WriteValue( *It ); }
+                ++It;
+            }
+        }
+
+        void MergeNodes( TFlushPlan const & Plan, std::string_view Document ) {
+            auto const & Children = Plan.Children;
+            std::vector<unsigned char> Marks( Children.size() );
+            Wire::TCursor Cursor{ Document };
+            for ( Wire::TElement Element ; Cursor.Next( Element ) ; ) {
+                auto const Name = FromUtf8( Element.Name );
+                auto const It =
+                    std::lower_bound(
+                        Children.begin(), Children.end(), Name,
+                        []( TFlushPlan const & Lhs, String const & Rhs ) {
+                            return TKeyLess{}( Lhs.Name, Rhs );
+                        }
+                    );
+                if ( It == Children.end() || TKeyLess{}( Name, It->Name ) ) {
+                    out_.Copy( Element );
+                    continue;
+                }
+                auto& Mark = Marks[It - Children.begin()];
+                if ( Mark & Seen ) {
+                    // Once the first element is removed, the document
+                    // writer takes this one for the rest of a deleted
+                    // child's changes.
+                    if ( It->Deleted ) {
+                        if ( cfg_.native_ ) {
+                            continue;
+                        }
+                        if ( It->Forces || !It->Children.empty() ) {
+                            throw EStreamFallback{};
+                        }
+                    }
+                    out_.Copy( Element );
+                    continue;
+                }
+                Mark |= Seen;
+                if ( It->Deleted ) {
+                    continue;
+                }
+                Mark |= Merged;
+                if ( Element.IsDocument() ) {
+                    out_.Key( Element.Name );
+                    out_.BeginDocument();
+                    MergeNode( *It, Element.GetDocument() );
+                    out_.End();
+                }
+                else if ( It->Forces ) {
+                    if ( !cfg_.native_ ) {
+                        throw EStreamFallback{};
+                    }
+                    out_.Key( Element.Name );
+                    WriteNode( *It );
+                }
+                else {
+                    out_.Copy( Element );
+                }
+            }
+            CheckCursor( Cursor );
+            for ( std::size_t Idx = 0 ; Idx < Marks.size() ; ++Idx ) {
+                auto const & Child = Children[Idx];
+                if ( Child.Forces && !( Marks[Idx] & Merged ) ) {
+                    out_.Key( Utf8Name( Child.Name ) );
+                    WriteNode( Child );
+                }
+            }
+        }
+
+        bool IsWritten( ValueContType::value_type const & Value ) const {
+            return cfg_.GetAlwaysFlushNodeFlag() ||
+                   Value.second.second == Operation::Write;
+        }
+
+        // The UTF-8 form of a value or node name; BSON names cannot hold
+        // a NUL.
+        std::string_view Utf8Name( String const & Name ) {
+            auto const Utf8 = ToUtf8( Name, key_ );
+            if ( Utf8.find( '\0' ) != std::string_view::npos ) {
+                if ( cfg_.native_ ) {
+                    throw Exception(
+                        _D( "A BSON element name cannot contain a NUL character" )
+                    );
+                }
+                throw EStreamFallback{};
+            }
+            return Utf8;
+        }
+
+        void Encode( std::string_view Name, TConfigNodeValueType const & Value ) {
+            Codec::Encode( Value, TWireCodec{ *this, Name } );
+        }
+
+        void WriteValue( ValueContType::value_type const & Value ) {
+            if ( IsWritten( Value ) ) {
+                Encode( Utf8Name( Value.first ), Value.second.first );
+            }
+        }
+
+        void WriteValues( TFlushPlan const & Plan ) {
+            out_.Key( "values" );
+            out_.BeginDocument();
+            for ( auto const & Value : *Plan.Values ) {
+                WriteValue( Value );
+            }
+            out_.End();
+        }
+
+        void WriteNodes( TFlushPlan const & Plan ) {
+            out_.Key( "nodes" );
+            out_.BeginDocument();
+            for ( auto const & Child : Plan.Children ) {
+                if ( Child.Forces ) {
+                    out_.Key( Utf8Name( Child.Name ) );
+                    WriteNode( Child );
+                }
+            }
+            out_.End();
+        }
+
+        void WriteNode( TFlushPlan const & Plan ) {
+            out_.BeginDocument();
+            if ( Plan.Values ) {
+                WriteValues( Plan );
+            }
+            if ( Plan.ChildForces ) {
+                WriteNodes( Plan );
+            }
+            out_.End();
+        }
+
+        // Writes a value as TValueCodec encodes it, or in native mode as
+        // the "<name>@<tag>" element NativeType describes.  A name with
+        // an '@' of its own keeps the portable layout, with every value
+        // tagged, so that it cannot be read back as a suffix.
+        struct TWireCodec {
+            TStreamFlusher& F;
+            std::string_view Name;      // UTF-8
+            bool Native;
+            bool Explicit;              // int, bool and String tagged too
+
+            TWireCodec( TStreamFlusher& Flusher, std::string_view ValueName )
+                : F{ Flusher }, Name{ ValueName }
+                , Native{
+                    Flusher.cfg_.native_ &&
+                    ValueName.find( '@' ) == std::string_view::npos
+                  }
+                , Explicit{
+                    Flusher.cfg_.explicitTypes_ ||
+                    ( Flusher.cfg_.native_ && !Native )
+                  }
+            {}
+
+            Wire::TWriter<Crypt::Bytes>& Bare() const {
+                F.out_.Key( Name );
+                return F.out_;
+            }
+
+            // Names the value and opens its tagged form, closed by
+            // EndTagged: "<name>@<tag>" in native mode, otherwise
+            // "<name>" holding a { "<tag>": <payload> } document.
+            template<typename T>
+            Wire::TWriter<Crypt::Bytes>& Tagged() const {
+                if ( Native ) {
+                    F.tagged_.assign( Name.data(), Name.size() );
+                    F.tagged_ += '@';
+                    F.tagged_ += Codec::TagName<T>();
+                    F.out_.Key( F.tagged_ );
+                }
+                else {
+                    F.out_.Key( Name );
+                    F.out_.BeginDocument();
+                    F.out_.Key( Codec::TagName<T>() );
+                }
+                return F.out_;
+            }
+
+            void EndTagged() const {
+                if ( !Native ) {
+                    F.out_.End();
+                }
+            }
+
+            template<typename T>
+            void EncodeInt32( T Val ) const {
+                Tagged<T>().Int32( Val );
+                EndTagged();
+            }
+
+            template<typename T>
+            void EncodeInt64( T Val ) const {
+                Tagged<T>().Int64( static_cast<long long>( Val ) );
+                EndTagged();
+            }
+
+            template<typename T>
+            void EncodeDecimal( T const & Val, Wire::TDecimal const & Decimal ) const {
+                if ( Native ) {
+                    Tagged<T>().Decimal128( Decimal );
+                }
+                else {
+                    EncodeText( Val );
+                }
+            }
+
+            template<typename T>
+            void EncodeText( T const & Val ) const {
+                EncodeString<T>( Codec::TTextCodec::Encode( Codec::TAs<T>{}, Val ) );
+            }
+
+            template<typename T>
+            void EncodeString( String const & Val ) const {
+                Tagged<T>().String( ToUtf8( Val, F.token_ ) );
+                EndTagged();
+            }
+
+            template<typename T>
+            void EncodeBytes( Byte const * Data, std::size_t Size ) const {
+                if ( Native ) {
+                    Tagged<T>().Binary( 0, Data, Size );
+                }
+                else {
+                    EncodeString<T>(
+                        Size
+                            ? TValueCodec{ F.cfg_ }.EncodeBytes(
+                                  Data, static_cast<int>( Size ) - 1
+                              )
+                            : String()
+                    );
+                }
+            }
+
+            void Encode( Codec::TAs<int>, int Val ) const {
+                if ( Explicit ) { EncodeInt32( Val ); }
+                else { Bare().Int32( Val ); }
+            }
+
+            void Encode( Codec::TAs<unsigned int>, unsigned int Val ) const {
+                EncodeInt64( Val );
+            }
+
+            void Encode( Codec::TAs<long>, long Val ) const {
+                EncodeInt64( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned long>, unsigned long Val ) const {
+                EncodeInt64( Val );
+            }
+
+            void Encode( Codec::TAs<char>, char Val ) const {
+                EncodeInt32( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned char>, unsigned char Val ) const {
+                EncodeInt32( Val );
+            }
+
+            void Encode( Codec::TAs<short>, short Val ) const {
+                EncodeInt32( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned short>, unsigned short Val ) const {
+                EncodeInt32( Val );
+            }
+
+            void Encode( Codec::TAs<long long>, long long Val ) const {
+                EncodeInt64( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned long long>, unsigned long long Val ) const {
+                EncodeDecimal( Val, Wire::TDecimal{ false, Val, 0 } );
+            }
+
+            void Encode( Codec::TAs<bool>, bool Val ) const {
+                if ( Explicit ) {
+                    Tagged<bool>().Bool( Val );
+                    EndTagged();
+                }
+                else {
+                    Bare().Bool( Val );
+                }
+            }
+
+            void Encode( Codec::TAs<String>, String const & Val ) const {
+                if ( Explicit ) {
+                    EncodeString<String>( Val );
+                }
+                else {
+                    Bare().String( ToUtf8( Val, F.token_ ) );
+                }
+            }
+
+            void Encode( Codec::TAs<TDateTime>, TDateTime Val ) const {
+                if ( Native && HasUnixMSecs( Val ) ) {
+                    Tagged<TDateTime>().DateTime( ToUnixMSecs( Val ) );
+                }
+                else {
+                    // Out of range: the portable layout, which reads back
+                    // in native mode as well.
+                    auto Portable = *this;
+                    Portable.Native = false;
+                    Portable.EncodeText( Val );
+                }
+            }
+
+            void Encode( Codec::TAs<float>, float Val ) const {
+                Tagged<float>().Double( Val );
+                EndTagged();
+            }
+
+            void Encode( Codec::TAs<double>, double Val ) const {
+                Tagged<double>().Double( Val );
+                EndTagged();
+            }
+
+            void Encode( Codec::TAs<Currency>, Currency Val ) const {
+                // The raw value, in units of 1/10000.
+                auto const Raw = static_cast<unsigned long long>( Val.Val );
+                EncodeDecimal(
+                    Val, Wire::TDecimal{ Val.Val < 0, Val.Val < 0 ? 0 - Raw : Raw, -4 }
+                );
+            }
+
+            void Encode( Codec::TAs<StringCont>, StringCont const & Val ) const {
+                Tagged<StringCont>().BeginArray();
+                for ( auto const & Item : Val ) {
+                    F.out_.String( ToUtf8( Item, F.token_ ) );
+                }
+                F.out_.End();
+                EndTagged();
+            }
+
+            void Encode( Codec::TAs<TBytes>, TBytes Val ) const {
+                EncodeBytes<TBytes>(
+                    Val.Length ? &Val[0] : nullptr,
+                    static_cast<std::size_t>( Val.Length )
+                );
+            }
+
+            void Encode( Codec::TAs<BytesCont>, BytesCont const & Val ) const {
+                EncodeBytes<BytesCont>( Val.data(), Val.size() );
+            }
+
+            void Encode( Codec::TAs<std::string>, std::string const & Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<std::wstring>, std::wstring const & Val ) const {
+                EncodeText( Val );
+            }
+        };
+    };
+
+    Crypt::Bytes ReadFileBytes( String const & FileName ) const {
+        if ( cryptOptions_.Enabled ) {
+            return Crypt::LoadBytes( FileName, cryptOptions_ );
+        }
+        auto const Bytes = TFile::ReadAllBytes( FileName );
+        Crypt::Bytes Result( Bytes.Length );
+        if ( Bytes.Length ) {
+            std::copy( &Bytes[0], &Bytes[0] + Bytes.Length, Result.data() );
+        }
+        return Result;
+    }
+
+    void WriteFileBytes( Crypt::Bytes const & Bytes ) const {
+        if ( cryptOptions_.Enabled ) {
+            Crypt::SaveBytes( fileName_, Bytes, cryptOptions_ );
+        }
+        else {
+            auto Stream = std::make_unique<TFileStream>( fileName_, fmCreate );
+            Stream->WriteBuffer( Bytes.data(), static_cast<NativeInt>( Bytes.size() ) );
+        }
+    }
+
+    void ForceFileDirectory() const {
+        if ( !TFile::Exists( fileName_ ) ) {
+            auto Path = TPath::GetFullPath( TPath::GetDirectoryName( fileName_ ) );
+            if ( !TDirectory::Exists( Path ) ) {
+                TDirectory::CreateDirectory( Path );
+            }
+        }
+    }
+
+    // Eager load: walks the file's bytes straight into the tree, without
+    // the BSON -> JSON text -> TJSONObject round trip.  Returns false,
+    // with the root left empty, when the file holds something it leaves
+    // to the document reader; the caller then loads it through the
+    // document.  In retain mode the bytes read are kept for StreamFlush.
+    // In native mode there is no such caller: it returns true or throws.
+    bool StreamRootNode() {
+        if ( GetRetainDocumentFlag() ) {
+            textStamp_.Take( loadFileName_ );
+        }
+        auto Bytes = ReadFileBytes( loadFileName_ );
+        // Any failure, EStreamFallback or a decoding error, is
+        // reproduced (or handled) by the document reader.
+        try {
+            TStreamLoader{ *this }.Load( View( Bytes ) );
+            if ( GetRetainDocumentFlag() ) {
+                text_ = std::move( Bytes );
+            }
+            return true;
+        }
+        catch ( EStreamFallback const & ) {
+            // Left with nothing else, only a malformed file gets here.
+            if ( native_ ) {
+                throw Exception( _D( "Invalid BSON configuration file" ) );
+            }
+        }
+        catch ( ... ) {
+            if ( native_ ) {
+                throw;
+            }
+        }
+        GetRootNode().Populate( NewValueList(), NewNodeList() );
+        textStamp_.Reset();
+        return false;
+    }
+
+    void LoadRootNode() {
+        // The RTL reader knows nothing of native names, so a native
+        // object loads eagerly, lazy mode or not.
+        if ( native_ ) {
+            StreamRootNode();
+        }
+        else if ( GetLazyLoadFlag() || !StreamRootNode() ) {
+            BSONObjRAII BSON{ *this };
+            ReadRootNode();
+        }
+    }
+
+    // Eager flush: writes the file as DoFlush through the document would,
+    // without building the document: the file as loaded is copied out
+    // element by element with the changes merged in.  Returns false,
+    // with nothing written, when it leaves the flush to the document
+    // writer.  In retain mode the bytes written are kept as the next
+    // flush's input, which then reads the file only if it has changed
+    // since.  In native mode it never leaves the flush to the document
+    // writer: it returns true or throws.
+    bool StreamFlush() {
+        TFlushPlanner Planner{ GetAlwaysFlushNodeFlag() };
+        GetRootNode().Write( Planner, TConfigPath{} );
+        if ( !Planner.IsPortable() && !native_ ) {
+            return false;
+        }
+
+        Crypt::Bytes Loaded;
+        std::string_view Document;
+        bool const HasFile = TFile::Exists( loadFileName_ );
+        if ( textStamp_.Matches( loadFileName_ ) ) {
+            Document = View( text_ );
+        }
+        else if ( HasFile ) {
+            Loaded = ReadFileBytes( loadFileName_ );
+            Document = View( Loaded );
+        }
+
+        // The new file is built in memory (each document's length comes
+        // first), so the file is only touched once the merge went through.
+        Crypt::Bytes Bytes;
+        try {
+            TStreamFlusher Flusher{ *this, Planner.GetPlan(), Bytes };
+            if ( HasFile ) {
+                Flusher.Merge( Document );
+            }
+            else {
+                Flusher.WriteDocument();
+            }
+        }
+        catch ( EStreamFallback const & ) {
+            if ( native_ ) {
+                throw Exception( _D( "Invalid BSON configuration file" ) );
+            }
+            return false;
+        }
+
+        // From here on the file no longer matches anything retained.
+        textStamp_.Reset();
+        documentStamp_.Reset();
+        ForceFileDirectory();
+        WriteFileBytes( Bytes );
+        if ( GetRetainDocumentFlag() ) {
+            document_.reset();
+            text_ = std::move( Bytes );
+            textStamp_.Take( fileName_ );
+        }
+        return true;
+    }
+
+protected:
+    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+
+        auto Values = NewValueList();
+
+        if ( auto Key = OpenValues( Path ) ) {
+            for ( int Idx = 0 ; Idx < Key->Count ; ++Idx ) {
+                auto const & Pair = Key->Pairs[Idx];
+                if ( dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
+                    if ( auto InnerObj = dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
+                        if ( InnerObj->Count == 1 ) {
+                            auto const & InnerPair = InnerObj->Pairs[0];
+                            auto TypeName = InnerPair->JsonString->Value();
+                            if ( auto Result = GetTypeTag( TypeName ) ) {
+                                PutItemTo(
+                                    Values, Pair->JsonString->Value(),
+                                    {
+                                        Codec::Decode(
+                                            Result.value(), TValueCodec{ *this },
+                                            *InnerPair->JsonValue
+                                        ),
+                                        Operation::None
+                                    }
+                                );
+                            }
+                        }
+                    }
+                }
+                else if ( auto Ptr = dynamic_cast<TJSONNumber*>( Pair->JsonValue ) ) {
+                    PutItemTo(
+                        Values, Pair->JsonString->Value(),
+                        {
+                            TConfigNodeValueType{ Ptr->AsInt },
+                            Operation::None
+                        }
+                    );
+                }
+                else if ( auto Ptr = dynamic_cast<TJSONString*>( Pair->JsonValue ) ) {
+                    PutItemTo(
+                        Values, Pair->JsonString->Value(),
+                        {
+                            TConfigNodeValueType{ Ptr->Value() },
+                            Operation::None
+                        }
+                    );
+                }
+                else if ( auto Ptr = dynamic_cast<TJSONBool*>( Pair->JsonValue ) ) {
+                    PutItemTo(
+                        Values, Pair->JsonString->Value(),
+                        {
+                            TConfigNodeValueType{ Ptr->AsBoolean },
+                            Operation::None
+                        }
+                    );
+                }
+            }
+        }
+        return Values;
+    }
+
+    virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
+        auto Nodes = NewNodeList();
+
+        if ( auto Node = OpenNodes( Path ) ) {
+            for ( int Idx = 0 ; Idx < Node->Count ; ++Idx ) {
+                auto const & Pair = Node->Pairs[Idx];
+                if ( dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
+                    auto NodeName = Pair->JsonString->Value();
+                    Nodes[NodeName] = NewNode();
+                }
+            }
+        }
+        return Nodes;
+    }
+
+    virtual void DoSaveValueList( TConfigPath const & Path, ValueContType const & Values ) override {
+        if ( !Values.empty() ) {
+            if ( auto Node = ForceValues( Path ) ) {
+                for ( auto& v : Values ) {
+                    auto const ValueState = v.second.second;
+                    if ( GetAlwaysFlushNodeFlag() || ValueState == Operation::Write ) {
+                        SaveValue( *Node, v );
+                    }
+                    else if ( v.second.second == Operation::Erase ) {
+                        Node->RemovePair( v.first );
+                    }
+                }
+            }
+        }
+    }
+
+    virtual void DoDeleteNode( TConfigPath const & Path ) override {
+        if ( !Path.empty() ) {
+            if ( auto Node = OpenNodes( Path, Path.size() - 1 ) ) {
+                Node->RemovePair( Path.back() );
+            }
+            cursor_.Invalidate( Path );
+        }
+    }
+
+    virtual void DoEnterNode( String const & Name ) override {
+        cursor_.Enter( Name );
+    }
+
+    virtual void DoLeaveNode() noexcept override { cursor_.Leave(); }
+
+    virtual void DoBeginLazyRead() override {
+        if ( !document_ ) { CreateBSONDocument(); }
+    }
+
+    virtual void DoFlush() override {
+        if ( ( native_ || !GetLazyLoadFlag() ) && StreamFlush() ) {
+            return;
+        }
+
+        BSONObjRAII BSON{ *this };
+        // Until it is saved, the document no longer mirrors the file.
+        documentStamp_.Reset();
+        GetRootNode().Write( *this, TConfigPath{} );
+
+        ForceFileDirectory();
+
+        std::unique_ptr<TStream> Stream =
+            cryptOptions_.Enabled
+                ? std::unique_ptr<TStream>( new TMemoryStream() )
+                : std::unique_ptr<TStream>( new TFileStream( fileName_, fmCreate ) );
+        auto StringReader =
+            std::make_unique<TStringReader>( document_->ToJSON() );
+        auto Writer =
+            std::make_unique<System::Json::Bson::TBsonWriter>( Stream.get() );
+        auto Reader =
+            std::make_unique<System::Json::Readers::TJsonTextReader>(
+                StringReader.get()
+            );
+        if ( Reader->Read() ) {
+            Writer->WriteToken( Reader.get(), true );
+        }
+        Writer->Flush();
+        SaveBSONStream( std::move( Stream ) );
+        if ( GetRetainDocumentFlag() ) {
+            textStamp_.Reset();
+            text_ = Crypt::Bytes{};
+            documentStamp_.Take( fileName_ );
+        }
     }
 };
 
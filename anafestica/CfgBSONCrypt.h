@@ -15,26 +15,35 @@ class TConfig : public BSON::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false,
              bool FlushAllItems = false, bool ExplicitTypes = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             BSON::TEncoding Encoding = BSON::TEncoding::Portable,
+             TConfigOptions CfgOptions = {} )
         : BSON::TConfig(
-            FileName, ReadOnly, FlushAllItems, ExplicitTypes, Options
+            FileName, ReadOnly, FlushAllItems, ExplicitTypes, Options,
+            Encoding, CfgOptions
           )
     {}
 
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false, bool ExplicitTypes = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             BSON::TEncoding Encoding = BSON::TEncoding::Portable,
+             TConfigOptions CfgOptions = {} )
         : BSON::TConfig(
-            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options
+            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options,
+            Encoding, CfgOptions
           )
     {}
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false, bool ExplicitTypes = false,
-                            Crypt::TOptions Options = Crypt::TOptions::Default() )
+                            Crypt::TOptions Options = Crypt::TOptions::Default(),
+                            BSON::TEncoding Encoding = BSON::TEncoding::Portable,
+                            TConfigOptions CfgOptions = {} )
     {
         return TConfig(
-            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options
+            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options,
+            Encoding, CfgOptions
         );
     }
 };
@@ -0,0 +1,465 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgBSONWireH
+#define CfgBSONWireH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_bson.cpp).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace BSON {
+//---------------------------------------------------------------------------
+namespace Wire {
+//---------------------------------------------------------------------------
+
+/// Element types of the BSON 1.1 specification (bsonspec.org).
+enum class TType : unsigned char {
+    Double = 0x01, String = 0x02, Document = 0x03, Array = 0x04,
+    Binary = 0x05, Undefined = 0x06, ObjectId = 0x07, Bool = 0x08,
+    DateTime = 0x09, Null = 0x0A, Regex = 0x0B, DBPointer = 0x0C,
+    Code = 0x0D, Symbol = 0x0E, CodeWithScope = 0x0F, Int32 = 0x10,
+    Timestamp = 0x11, Int64 = 0x12, Decimal128 = 0x13,
+    MinKey = 0xFF, MaxKey = 0x7F
+};
+
+namespace Detail {
+
+inline std::uint32_t LoadU32( char const * Data ) noexcept {
+    auto const Bytes = reinterpret_cast<unsigned char const *>( Data );
+    return
+        static_cast<std::uint32_t>( Bytes[0] ) |
+        static_cast<std::uint32_t>( Bytes[1] ) << 8 |
+        static_cast<std::uint32_t>( Bytes[2] ) << 16 |
+        static_cast<std::uint32_t>( Bytes[3] ) << 24;
+}
+
+inline std::uint64_t LoadU64( char const * Data ) noexcept {
+    return
+        static_cast<std::uint64_t>( LoadU32( Data ) ) |
+        static_cast<std::uint64_t>( LoadU32( Data + 4 ) ) << 32;
+}
+
+// IEEE 754-2008 decimal128, binary integer decimal encoding: sign, 14-bit
+// exponent biased by 6176, 113-bit coefficient (the form where the two
+// bits after the sign are not both set).
+inline constexpr int DecimalBias = 6176;
+inline constexpr int DecimalExponentShift = 49;
+inline constexpr std::uint64_t DecimalSpecial = 3ULL << 61;
+
+} // End of namespace Detail
+
+/// A Decimal128 whose coefficient fits 64 bits:
+/// (-1)^Negative * Coefficient * 10^Exponent.
+struct TDecimal {
+    bool Negative {};
+    std::uint64_t Coefficient {};
+    int Exponent {};
+
+    /// The coefficient of the same value at exponent @p Target; @c false
+    /// when it does not fit 64 bits or would lose digits.
+    [[nodiscard]] bool Rescale( int Target, std::uint64_t& Result ) const noexcept {
+        auto Coeff = Coefficient;
+        if ( Coeff ) {
+            for ( auto Exp = Exponent ; Exp > Target ; --Exp ) {
+                if ( Coeff > UINT64_MAX / 10 ) { return false; }
+                Coeff *= 10;
+            }
+            for ( auto Exp = Exponent ; Exp < Target ; ++Exp ) {
+                if ( Coeff % 10 ) { return false; }
+                Coeff /= 10;
+            }
+        }
+        Result = Coeff;
+        return true;
+    }
+};
+
+/// One element of a document, as views into the document's bytes.
+struct TElement {
+    TType Type {};
+    std::string_view Name;      ///< UTF-8, without the terminator
+    std::string_view Value;     ///< the payload
+    std::string_view Bytes;     ///< type, name and payload
+
+    [[nodiscard]] double GetDouble() const noexcept {
+        auto const Bits = Detail::LoadU64( Value.data() );
+        double Result;
+        std::memcpy( &Result, &Bits, sizeof Result );
+        return Result;
+    }
+
+    [[nodiscard]] std::int32_t GetInt32() const noexcept {
+        return static_cast<std::int32_t>( Detail::LoadU32( Value.data() ) );
+    }
+
+    /// Payload of an Int64, DateTime or Timestamp element.
+    [[nodiscard]] std::int64_t GetInt64() const noexcept {
+        return static_cast<std::int64_t>( Detail::LoadU64( Value.data() ) );
+    }
+
+    [[nodiscard]] bool GetBool() const noexcept { return Value[0] != 0; }
+
+    /// Payload of a Decimal128 element; @c false for infinities, NaNs
+    /// and coefficients wider than 64 bits.
+    [[nodiscard]] bool GetDecimal( TDecimal& Result ) const noexcept {
+        auto const Low = Detail::LoadU64( Value.data() );
+        auto const High = Detail::LoadU64( Value.data() + 8 );
+        if ( ( High & Detail::DecimalSpecial ) == Detail::DecimalSpecial ||
+             ( High & ( ( 1ULL << Detail::DecimalExponentShift ) - 1 ) ) )
+        {
+            return false;
+        }
+        Result.Negative = High >> 63 != 0;
+        Result.Coefficient = Low;
+        Result.Exponent =
+            static_cast<int>( High >> Detail::DecimalExponentShift & 0x3FFF ) -
+            Detail::DecimalBias;
+        return true;
+    }
+
+    /// UTF-8 text of a String, Code or Symbol element.
+    [[nodiscard]] std::string_view GetString() const noexcept {
+        return Value.substr( 4, Value.size() - 5 );
+    }
+
+    /// Subtype and bytes of a Binary element.
+    [[nodiscard]] unsigned char GetSubtype() const noexcept {
+        return static_cast<unsigned char>( Value[4] );
+    }
+
+    [[nodiscard]] std::string_view GetBinary() const noexcept {
+        return Value.substr( 5 );
+    }
+
+    /// The nested document of a Document or Array element.
+    [[nodiscard]] std::string_view GetDocument() const noexcept { return Value; }
+
+    [[nodiscard]] bool IsDocument() const noexcept { return Type == TType::Document; }
+};
+
+/// Walks the elements of one document, checking the bounds of each.
+///
+/// @code
+/// TCursor Cursor( Bytes );
+/// for ( TElement Element ; Cursor.Next( Element ) ; ) { ... }
+/// if ( Cursor.GetError() ) { ... }
+/// @endcode
+///
+/// Nested documents are walked with a cursor of their own over
+/// @ref TElement::GetDocument, so the caller decides how deep to go.
+class TCursor {
+public:
+    /// @p Document must hold the document exactly: length prefix, elements
+    /// and terminator.
+    explicit TCursor( std::string_view Document ) noexcept {
+        if ( Document.size() < 5 ||
+             Detail::LoadU32( Document.data() ) != Document.size() ||
+             Document.back() != 0 )
+        {
+            error_ = "malformed document header";
+            return;
+        }
+        cur_ = Document.data() + 4;
+        last_ = Document.data() + Document.size() - 1;
+    }
+
+    /// Reads the next element; @c false at the end or on malformed input.
+    bool Next( TElement& Element ) noexcept {
+        if ( error_ || cur_ == last_ ) {
+            return false;
+        }
+        auto const Start = cur_;
+        Element.Type = static_cast<TType>( *cur_++ );
+        auto const NameEnd =
+            static_cast<char const *>( std::memchr( cur_, 0, last_ - cur_ ) );
+        if ( !NameEnd ) {
+            return Fail( "unterminated element name" );
+        }
+        Element.Name = std::string_view( cur_, NameEnd - cur_ );
+        cur_ = NameEnd + 1;
+        std::size_t Size {};
+        if ( !PayloadSize( Element.Type, Size ) ) {
+            return false;
+        }
+        Element.Value = std::string_view( cur_, Size );
+        cur_ += Size;
+        Element.Bytes = std::string_view( Start, cur_ - Start );
+        return true;
+    }
+
+    /// Static message; @c nullptr unless the input was malformed.
+    [[nodiscard]] char const * GetError() const noexcept { return error_; }
+private:
+    char const * cur_ {};
+    char const * last_ {};
+    char const * error_ {};
+
+    bool Fail( char const * Error ) noexcept {
+        error_ = Error;
+        return false;
+    }
+
+    std::size_t Left() const noexcept { return last_ - cur_; }
+
+    bool Fixed( std::size_t Want, std::size_t& Size ) noexcept {
+        if ( Left() < Want ) {
+            return Fail( "truncated element" );
+        }
+        Size = Want;
+        return true;
+    }
+
+    // A payload behind a 32-bit length.  Bias is 4 where the length counts
+    // itself (documents), Extra the bytes between the length and the data
+    // it counts (the subtype of a binary); strings end with a NUL.
+    bool Prefixed( std::size_t Bias, std::size_t Extra, bool Terminated,
+                   std::size_t& Size ) noexcept {
+        if ( Left() < 4 ) {
+            return Fail( "truncated element" );
+        }
+        auto const Length = static_cast<std::size_t>( Detail::LoadU32( cur_ ) );
+        if ( Length < Bias || Length - Bias > Left() ) {
+            return Fail( "element length out of bounds" );
+        }
+        Size = Length - Bias + 4 + Extra;
+        if ( Size > Left() ) {
+            return Fail( "element length out of bounds" );
+        }
+        if ( Terminated && ( Length == Bias || cur_[Size - 1] != 0 ) ) {
+            return Fail( "unterminated string" );
+        }
+        return true;
+    }
+
+    bool CString( std::size_t From, std::size_t& Size ) noexcept {
+        auto const End =
+            static_cast<char const *>( std::memchr( cur_ + From, 0, Left() - From ) );
+        if ( !End ) {
+            return Fail( "unterminated string" );
+        }
+        Size = End + 1 - cur_;
+        return true;
+    }
+
+    bool PayloadSize( TType Type, std::size_t& Size ) noexcept {
+        switch ( Type ) {
+            case TType::Double:
+            case TType::DateTime:
+            case TType::Timestamp:
+            case TType::Int64:      return Fixed( 8, Size );
+            case TType::Int32:      return Fixed( 4, Size );
+            case TType::Bool:
+                if ( !Fixed( 1, Size ) ) { return false; }
+                return
+                    static_cast<unsigned char>( *cur_ ) <= 1 ||
+                    Fail( "invalid boolean" );
+            case TType::ObjectId:   return Fixed( 12, Size );
+            case TType::Decimal128: return Fixed( 16, Size );
+            case TType::Undefined:
+            case TType::Null:
+            case TType::MinKey:
+            case TType::MaxKey:     return Fixed( 0, Size );
+            case TType::String:
+            case TType::Code:
+            case TType::Symbol:     return Prefixed( 0, 0, true, Size );
+            case TType::Binary:     return Prefixed( 0, 1, false, Size );
+            case TType::Document:
+            case TType::Array:
+            case TType::CodeWithScope:
+                if ( !Prefixed( 4, 0, false, Size ) ) { return false; }
+                return
+                    ( Size >= 5 && cur_[Size - 1] == 0 ) ||
+                    Fail( "malformed document" );
+            case TType::Regex: {
+                std::size_t Pattern {};
+                if ( !CString( 0, Pattern ) ) { return false; }
+                return CString( Pattern, Size );
+            }
+            case TType::DBPointer: {
+                std::size_t Text {};
+                if ( !Prefixed( 0, 0, true, Text ) ) { return false; }
+                if ( Left() - Text < 12 ) {
+                    return Fail( "truncated element" );
+                }
+                Size = Text + 12;
+                return true;
+            }
+            default:
+                return Fail( "unknown element type" );
+        }
+    }
+};
+
+/// Builds a document into a byte container, little-endian whatever the
+/// host, patching the length of each document when it is closed.
+///
+/// Elements of a document are named with @ref Key before they are
+/// written; the elements of an array are numbered by the writer.
+///
+/// @tparam C  Contiguous container of @c char or byte-sized integers.
+template<typename C = std::string>
+class TWriter {
+public:
+    explicit TWriter( C& Out ) noexcept : out_{ Out } {}
+
+    /// Names the next element.  @p Name must not contain a NUL.
+    void Key( std::string_view Name ) { key_ = Name; }
+
+    /// Opens the root document, or a document value.
+    void BeginDocument() { Open( TType::Document ); }
+    void BeginArray() { Open( TType::Array ); }
+
+    /// Closes the innermost open document or array.
+    void End() {
+        Put( '\0' );
+        auto const Start = frames_.back().Start;
+        frames_.pop_back();
+        StoreU32( Start, static_cast<std::uint32_t>( out_.size() - Start ) );
+    }
+
+    void Double( double Val ) {
+        std::uint64_t Bits;
+        std::memcpy( &Bits, &Val, sizeof Bits );
+        Header( TType::Double );
+        PutU64( Bits );
+    }
+
+    void Int32( std::int32_t Val ) {
+        Header( TType::Int32 );
+        PutU32( static_cast<std::uint32_t>( Val ) );
+    }
+
+    void Int64( std::int64_t Val ) {
+        Header( TType::Int64 );
+        PutU64( static_cast<std::uint64_t>( Val ) );
+    }
+
+    /// Milliseconds since the Unix epoch, UTC.
+    void DateTime( std::int64_t Val ) {
+        Header( TType::DateTime );
+        PutU64( static_cast<std::uint64_t>( Val ) );
+    }
+
+    /// @p Val.Exponent must lie within the decimal128 range, -6176 to 6111.
+    void Decimal128( TDecimal const & Val ) {
+        Header( TType::Decimal128 );
+        PutU64( Val.Coefficient );
+        PutU64(
+            static_cast<std::uint64_t>( Val.Negative ) << 63 |
+            static_cast<std::uint64_t>( Val.Exponent + Detail::DecimalBias ) <<
+                Detail::DecimalExponentShift
+        );
+    }
+
+    void Bool( bool Val ) {
+        Header( TType::Bool );
+        Put( Val ? '\1' : '\0' );
+    }
+
+    void Null() { Header( TType::Null ); }
+
+    /// @p Text is UTF-8.
+    void String( std::string_view Text ) {
+        Header( TType::String );
+        PutU32( static_cast<std::uint32_t>( Text.size() + 1 ) );
+        Append( Text );
+        Put( '\0' );
+    }
+
+    void Binary( unsigned char Subtype, void const * Data, std::size_t Size ) {
+        Header( TType::Binary );
+        PutU32( static_cast<std::uint32_t>( Size ) );
+        Put( static_cast<char>( Subtype ) );
+        Append( std::string_view( static_cast<char const *>( Data ), Size ) );
+    }
+
+    /// Copies @p Element, name included, as it was read.
+    void Copy( TElement const & Element ) {
+        if ( !frames_.empty() ) { ++frames_.back().Count; }
+        Append( Element.Bytes );
+    }
+private:
+    struct TFrame {
+        std::size_t Start;
+        bool IsArray;
+        std::size_t Count;
+    };
+
+    C& out_;
+    std::vector<TFrame> frames_;
+    std::string_view key_;
+
+    void Put( char Ch ) { out_.push_back( static_cast<typename C::value_type>( Ch ) ); }
+
+    void Append( std::string_view Text ) {
+        out_.insert( out_.end(), Text.begin(), Text.end() );
+    }
+
+    void PutU32( std::uint32_t Val ) {
+        for ( int Shift = 0 ; Shift < 32 ; Shift += 8 ) {
+            Put( static_cast<char>( Val >> Shift & 0xFF ) );
+        }
+    }
+
+    void PutU64( std::uint64_t Val ) {
+        PutU32( static_cast<std::uint32_t>( Val ) );
+        PutU32( static_cast<std::uint32_t>( Val >> 32 ) );
+    }
+
+    void StoreU32( std::size_t At, std::uint32_t Val ) {
+        for ( int Shift = 0 ; Shift < 32 ; Shift += 8, ++At ) {
+            out_[At] = static_cast<typename C::value_type>( Val >> Shift & 0xFF );
+        }
+    }
+
+    // Type and name of the next element (nothing for the root document).
+    void Header( TType Type ) {
+        if ( frames_.empty() ) {
+            return;
+        }
+        auto& Frame = frames_.back();
+        Put( static_cast<char>( Type ) );
+        if ( Frame.IsArray ) {
+            char Digits[24];
+            auto const Last = std::end( Digits );
+            auto First = Last;
+            auto Index = Frame.Count;
+            do {
+                *--First = static_cast<char>( '0' + Index % 10 );
+                Index /= 10;
+            } while ( Index );
+            Append( std::string_view( First, Last - First ) );
+        }
+        else {
+            Append( key_ );
+        }
+        Put( '\0' );
+        ++Frame.Count;
+    }
+
+    void Open( TType Type ) {
+        Header( Type );
+        frames_.push_back( TFrame{ out_.size(), Type == TType::Array, 0 } );
+        PutU32( 0 );
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Wire
+//---------------------------------------------------------------------------
+} // End of namespace BSON
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
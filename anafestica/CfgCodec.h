@@ -0,0 +1,331 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgCodecH
+#define CfgCodecH
+
+// Codec registry shared by the file backends.
+//
+// The alternatives of TConfigNodeValueType, their TypeTag and their text tag
+// are all fixed at compile time (TValueAlternatives and CfgTypeTag.h), so a
+// backend only supplies per-format traits: one Encode and one Decode
+// overload per alternative, selected by a Codec::TAs<T> tag argument.
+// Codec::Encode and Codec::Decode bind those overloads to the value cell
+// through constexpr thunk tables (one indirect call, no std::function and
+// no function-local static initialisation).  A missing overload is a
+// compile error in every backend that lacks it.
+//
+// TTextCodec holds the String form of every alternative except StringCont
+// (whose layout is format specific); the text backends use it as is and
+// the structured ones reuse it for their string-encoded alternatives.
+
+#include <System.DateUtils.hpp>
+#include <System.NetEncoding.hpp>
+#include <System.SysUtils.hpp>
+#include <System.Classes.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <anafestica/CfgNodeValueType.h>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace Codec {
+//---------------------------------------------------------------------------
+
+/// Tag argument that selects the overload for alternative @p T in a
+/// format's traits, e.g. <tt>String Encode( TAs<int>, int Val )</tt>.
+/// Being a distinct type per alternative, it rules out implicit
+/// conversions between alternatives during overload resolution.
+template<typename T>
+using TAs = Detail::TTypeId<T>;
+
+/// The @ref TypeTag of alternative @p T.
+template<typename T>
+inline constexpr TypeTag TagOf =
+    static_cast<TypeTag>( Detail::TIndexOf<T,TValueAlternatives>::value );
+
+/// The alternative identified by @p Tag.
+template<TypeTag Tag>
+using TypeOf =
+    typename Detail::TTypeAt<
+        static_cast<std::size_t>( Tag ), TValueAlternatives
+    >::type;
+
+/// The text tag of alternative @p T (e.g. @c "dbl" for @c double).
+template<typename T>
+[[nodiscard]] constexpr char const * TagName() noexcept
+{
+    return GetTypeTagName( TagOf<T> );
+}
+
+/// The text tag of the alternative held by @p Val.
+[[nodiscard]] inline char const * TagName( TConfigNodeValueType const & Val ) noexcept
+{
+    return TypeTagNames[Val.index()];
+}
+
+/// Calls <tt>Format.Encode( TAs<T>{}, Payload, Dst... )</tt> for the
+/// alternative @c T held by @p Val and returns its result.
+template<typename F, typename... A>
+decltype( auto ) Encode( TConfigNodeValueType const & Val, F&& Format, A&&... Dst )
+{
+    return Val.Visit(
+        [&]( auto const & Payload ) -> decltype( auto ) {
+            using T = std::decay_t<decltype( Payload )>;
+            return Format.Encode( TAs<T>{}, Payload, Dst... );
+        }
+    );
+}
+
+namespace Detail {
+
+template<typename T, typename F, typename... A>
+TConfigNodeValueType DecodeThunk( F& Format, A&... Src )
+{
+    T Value = Format.Decode( TAs<T>{}, Src... );
+    return TConfigNodeValueType( std::move( Value ) );
+}
+
+template<typename F, typename... A, std::size_t... I>
+TConfigNodeValueType DecodeImpl( TypeTag Tag, F& Format, A&... Src,
+                                 std::index_sequence<I...> )
+{
+    using Thunks = TConfigNodeValueType(*)( F&, A&... );
+    static constexpr Thunks Table[] = {
+        &DecodeThunk<
+            typename Anafestica::Detail::TTypeAt<I,TValueAlternatives>::type,
+            F, A...
+        >...
+    };
+    return Table[static_cast<std::size_t>( Tag )]( Format, Src... );
+}
+
+} // End of namespace Detail
+
+/// Builds the cell for @p Tag from <tt>Format.Decode( TAs<T>{}, Src... )</tt>,
+/// @c T being the alternative @p Tag identifies.
+template<typename F, typename... A>
+[[nodiscard]] TConfigNodeValueType Decode( TypeTag Tag, F&& Format, A&&... Src )
+{
+    return
+        Detail::DecodeImpl<std::remove_reference_t<F>,std::remove_reference_t<A>...>(
+            Tag, Format, Src...,
+            std::make_index_sequence<TConfigNodeValueType::AlternativeCount>{}
+        );
+}
+
+/// String form of every alternative but @c StringCont.
+///
+/// Integers are decimal, floating point uses '.' and enough digits to
+/// round-trip, dates are ISO 8601, byte arrays are Base64 and
+/// @c std::string holds UTF-8.
+struct TTextCodec {
+    static String Encode( TAs<int>, int Val ) {
+        return IntToStr( Val );
+    }
+
+    static String Encode( TAs<unsigned int>, unsigned int Val ) {
+        return IntToStr( static_cast<__int64>( Val ) );
+    }
+
+    static String Encode( TAs<long>, long Val ) {
+        return IntToStr( static_cast<__int64>( Val ) );
+    }
+
+    static String Encode( TAs<unsigned long>, unsigned long Val ) {
+        return IntToStr( static_cast<__int64>( Val ) );
+    }
+
+    static String Encode( TAs<char>, char Val ) {
+        return IntToStr( static_cast<int>( Val ) );
+    }
+
+    static String Encode( TAs<unsigned char>, unsigned char Val ) {
+        return IntToStr( static_cast<int>( Val ) );
+    }
+
+    static String Encode( TAs<short>, short Val ) {
+        return IntToStr( static_cast<int>( Val ) );
+    }
+
+    static String Encode( TAs<unsigned short>, unsigned short Val ) {
+        return IntToStr( static_cast<int>( Val ) );
+    }
+
+    static String Encode( TAs<long long>, long long Val ) {
+        return IntToStr( static_cast<__int64>( Val ) );
+    }
+
+    static String Encode( TAs<unsigned long long>, unsigned long long Val ) {
+#if defined( _UNICODE )
+        return String( std::to_wstring( Val ).c_str() );
+#else
+        return String( std::to_string( Val ).c_str() );
+#endif
+    }
+
+    static String Encode( TAs<bool>, bool Val ) {
+        return BoolToStr( Val, true );
+    }
+
+    static String Encode( TAs<String>, String const & Val ) {
+        return Val;
+    }
+
+    static String Encode( TAs<TDateTime>, TDateTime Val ) {
+        return DateToISO8601( Val, false );
+    }
+
+    static String Encode( TAs<float>, float Val ) {
+        return
+            FloatToStrF(
+                static_cast<double>( Val ), TFloatFormat::ffGeneral, 9, 0,
+                InvariantFormat()
+            );
+    }
+
+    static String Encode( TAs<double>, double Val ) {
+        return
+            FloatToStrF(
+                Val, TFloatFormat::ffGeneral, 17, 0, InvariantFormat()
+            );
+    }
+
+    static String Encode( TAs<Currency>, Currency Val ) {
+        return CurrToStr( Val, InvariantFormat() );
+    }
+
+    static String Encode( TAs<TBytes>, TBytes Val ) {
+        return
+            Val.Length == 0 ?
+              String()
+            :
+              TNetEncoding::Base64->EncodeBytesToString( &Val[0], Val.High );
+    }
+
+    static String Encode( TAs<BytesCont>, BytesCont const & Val ) {
+        return
+            Val.empty() ?
+              String()
+            :
+              TNetEncoding::Base64->EncodeBytesToString(
+                  Val.data(), Val.size() - 1
+              );
+    }
+
+    static String Encode( TAs<std::string>, std::string const & Val ) {
+        return UTF8ToString( Val.c_str() );
+    }
+
+    static String Encode( TAs<std::wstring>, std::wstring const & Val ) {
+        return String( Val.c_str() );
+    }
+
+    static int Decode( TAs<int>, String const & Val ) {
+        return std::stoi( Val.c_str() );
+    }
+
+    static unsigned int Decode( TAs<unsigned int>, String const & Val ) {
+        return static_cast<unsigned int>( std::stoul( Val.c_str() ) );
+    }
+
+    static long Decode( TAs<long>, String const & Val ) {
+        return std::stol( Val.c_str() );
+    }
+
+    static unsigned long Decode( TAs<unsigned long>, String const & Val ) {
+        return std::stoul( Val.c_str() );
+    }
+
+    static char Decode( TAs<char>, String const & Val ) {
+        return static_cast<char>( std::stoi( Val.c_str() ) );
+    }
+
+    static unsigned char Decode( TAs<unsigned char>, String const & Val ) {
+        return static_cast<unsigned char>( std::stoul( Val.c_str() ) );
+    }
+
+    static short Decode( TAs<short>, String const & Val ) {
+        return static_cast<short>( std::stoi( Val.c_str() ) );
+    }
+
+    static unsigned short Decode( TAs<unsigned short>, String const & Val ) {
+        return static_cast<unsigned short>( std::stoul( Val.c_str() ) );
+    }
+
+    static long long Decode( TAs<long long>, String const & Val ) {
+        return std::stoll( Val.c_str() );
+    }
+
+    static unsigned long long Decode( TAs<unsigned long long>, String const & Val ) {
+        return std::stoull( Val.c_str() );
+    }
+
+    static bool Decode( TAs<bool>, String const & Val ) {
+        return StrToBool( Val );
+    }
+
+    static String Decode( TAs<String>, String const & Val ) {
+        return Val;
+    }
+
+    static TDateTime Decode( TAs<TDateTime>, String const & Val ) {
+        return ISO8601ToDate( Val, false );
+    }
+
+    static float Decode( TAs<float>, String const & Val ) {
+        return std::stof( Val.c_str() );
+    }
+
+    static double Decode( TAs<double>, String const & Val ) {
+        return std::stod( Val.c_str() );
+    }
+
+    static Currency Decode( TAs<Currency>, String const & Val ) {
+        return StrToCurr( Val, InvariantFormat() );
+    }
+
+    static TBytes Decode( TAs<TBytes>, String const & Val ) {
+        return TNetEncoding::Base64->DecodeStringToBytes( Val );
+    }
+
+    static BytesCont Decode( TAs<BytesCont>, String const & Val ) {
+        auto Bytes = TNetEncoding::Base64->DecodeStringToBytes( Val );
+        BytesCont VBytes;
+        VBytes.reserve( Bytes.Length );
+        std::copy(
+            std::begin( Bytes ), std::end( Bytes ),
+            std::back_inserter( VBytes )
+        );
+        return VBytes;
+    }
+
+    static std::string Decode( TAs<std::string>, String const & Val ) {
+        return std::string( UTF8Encode( Val ).c_str() );
+    }
+
+    static std::wstring Decode( TAs<std::wstring>, String const & Val ) {
+        return std::wstring( Val.c_str() );
+    }
+
+    // Invariant format: '.' as decimal separator whatever the user locale.
+    static TFormatSettings InvariantFormat() {
+        TFormatSettings FS;
+        FS.DecimalSeparator = _D( '.' );
+        return FS;
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Codec
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
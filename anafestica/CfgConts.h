@@ -3,10 +3,18 @@
 #ifndef CfgContsH
 #define CfgContsH
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <anafestica/CfgNodeValueType.h>
+#include <anafestica/CfgArena.h>
+#include <anafestica/CfgFlatMap.h>
+#include <anafestica/CfgKeyAtom.h>
 
 //---------------------------------------------------------------------------
 namespace Anafestica {
@@ -23,57 +31,285 @@ enum class Operation { None, Write, Erase };
 
 using KeyType = String;
 
+/// Ordinal view of a @c String key, used by @ref TKeyLess.
+template<>
+struct TKeyView<String> {
+    static std::wstring_view Get( String const & Key ) noexcept {
+        return {
+            Key.c_str(),
+            static_cast<std::wstring_view::size_type>( Key.Length() )
+        };
+    }
+};
+
+/// Borrowed key argument for @ref TConfigNode members.
+///
+/// Implicitly constructible from @c String, @ref TKeyAtom, @c wchar_t
+/// literals and pointers, @c std::wstring and @c std::wstring_view, so a
+/// call such as @c Node.ItemExists( L"Left" ) searches the container
+/// without building a @c String first; a @c String is only built when a
+/// new entry has to be inserted (and not even then for a @c String or a
+/// @c TKeyAtom, whose buffer is shared).  Narrow literals are still
+/// accepted (they are converted once, as before).  A @c TKeyRef never
+/// outlives the full expression it was created in: do not store it.
+class TKeyRef {
+public:
+    TKeyRef( String const & Id ) noexcept
+        : view_( TKeyView<String>::Get( Id ) ), str_( &Id ) {}
+    TKeyRef( TKeyAtom const & Id ) noexcept
+        : view_( Id.View() ), str_( &Id.Str() ), atom_( true ) {}
+    TKeyRef( wchar_t const * Id ) noexcept : view_( Id ? Id : L"" ) {}
+    TKeyRef( std::wstring const & Id ) noexcept : view_( Id ) {}
+    TKeyRef( std::wstring_view Id ) noexcept : view_( Id ) {}
+    TKeyRef( char const * Id )
+        : own_( Id ), view_( TKeyView<String>::Get( own_ ) ) {}
+
+    [[nodiscard]] std::wstring_view View() const noexcept { return view_; }
+
+    /// Returns the key as a @c String, sharing the caller's buffer when
+    /// the key was passed as a @c String.
+    [[nodiscard]] String ToString() const {
+        if ( str_ ) { return *str_; }
+        if ( !own_.IsEmpty() ) { return own_; }
+        return String( view_.data(), static_cast<int>( view_.size() ) );
+    }
+
+    /// Makes @p Stored, a key found equal to this one, share the buffer
+    /// of the atom this key was passed as, so that the next search with
+    /// the atom matches it by address (see @ref TKeyLess).
+    void ShareWith( String& Stored ) const {
+        if ( atom_ && Stored.c_str() != str_->c_str() ) {
+            Stored = *str_;
+        }
+    }
+private:
+    String own_;
+    std::wstring_view view_;
+    String const * str_ {};
+    bool atom_ {};
+};
+
+template<>
+struct TKeyView<TKeyRef> {
+    static std::wstring_view Get( TKeyRef const & Key ) noexcept {
+        return Key.View();
+    }
+};
+
 using ValueType = TConfigNodeValueType;
 
 using ValuePairType = std::pair<ValueType,Operation>;
-using TConfigNodePtr = std::unique_ptr<TConfigNode>;
 
-using ValueContType = std::map<KeyType,ValuePairType>;
-using NodeContType = std::map<KeyType,TConfigNodePtr>;
+/// Deleter of @ref TConfigNodePtr: destroys the node and hands its storage
+/// back to the arena it was made in, or deletes it when it was made on
+/// the heap (null @c Arena).
+struct TConfigNodeDeleter {
+    TConfigArena* Arena {};
+
+    TConfigNodeDeleter() noexcept = default;
+    TConfigNodeDeleter( TConfigArena* NodeArena ) noexcept : Arena{ NodeArena } {}
+
+    /// Lets a plain @c std::unique_ptr<TConfigNode> (e.g. from
+    /// @c std::make_unique) be stored in a @ref NodeContType.
+    TConfigNodeDeleter( std::default_delete<TConfigNode> ) noexcept {}
+
+    void operator()( TConfigNode* Node ) const noexcept;
+};
+
+using TConfigNodePtr = std::unique_ptr<TConfigNode,TConfigNodeDeleter>;
+
+/// Sorted contiguous containers (see @ref TFlatMap): enumeration order is
+/// the same ordinal order @c std::map<String,...> produced.  Their storage
+/// comes from the owning configuration's @ref TConfigArena when they are
+/// built with one, from the heap otherwise.
+using ValueContType =
+    TFlatMap<
+        KeyType, ValuePairType, TKeyLess,
+        TArenaAllocator<std::pair<KeyType,ValuePairType>>
+    >;
+using NodeContType =
+    TFlatMap<
+        KeyType, TConfigNodePtr, TKeyLess,
+        TArenaAllocator<std::pair<KeyType,TConfigNodePtr>>
+    >;
 
 //---------------------------------------------------------------------------
 
+/// Equality of two payloads of the same alternative.  A shared payload
+/// is equal to itself without a look at its elements: a @c String or a
+/// @c TBytes whose buffer is the other's (both are reference-counted
+/// handles, so this is the usual case when a value read from a node is
+/// saved back), or a container that is the other one (the payload of a
+/// box shared by two cells, or the stored payload passed back as is).
+/// Otherwise sizes are compared before elements.
+template<typename T>
+[[nodiscard]] bool SamePayload( T const & Lhs, T const & Rhs )
+{
+    return Lhs == Rhs;
+}
+
+[[nodiscard]] inline
+bool SamePayload( String const & Lhs, String const & Rhs )
+{
+    return
+        Lhs.Length() == Rhs.Length() &&
+        ( Lhs.c_str() == Rhs.c_str() || Lhs == Rhs );
+}
+
+[[nodiscard]] inline
+bool SamePayload( System::Sysutils::TBytes const & Lhs,
+                  System::Sysutils::TBytes const & Rhs )
+{
+    return
+        Lhs.Length == Rhs.Length &&
+        (
+            Lhs.Length == 0 || &Lhs[0] == &Rhs[0] ||
+            std::equal( &Lhs[0], &Lhs[0] + Lhs.Length, &Rhs[0] )
+        );
+}
+
+template<typename T, typename A>
+[[nodiscard]] bool SamePayload( std::vector<T,A> const & Lhs,
+                                std::vector<T,A> const & Rhs )
+{
+    return
+        Lhs.size() == Rhs.size() &&
+        ( Lhs.data() == Rhs.data() || Lhs == Rhs );
+}
+
+template<typename C, typename T, typename A>
+[[nodiscard]] bool SamePayload( std::basic_string<C,T,A> const & Lhs,
+                                std::basic_string<C,T,A> const & Rhs )
+{
+    return
+        Lhs.size() == Rhs.size() &&
+        ( Lhs.data() == Rhs.data() || Lhs == Rhs );
+}
+//---------------------------------------------------------------------------
+
+/// Compares two stored values (same alternative and equal content).
+[[nodiscard]] inline
+bool SameValue( ValueType const & Lhs, ValueType const & Rhs )
+{
+    return
+        Lhs.index() == Rhs.index() &&
+        Lhs.Visit(
+            [&]( auto const & Val ) {
+                using T = std::decay_t<decltype( Val )>;
+                return SamePayload( Val, *GetIfValue<T>( &Rhs ) );
+            }
+        );
+}
+
+/// Compares a stored value with a payload of one of the alternatives,
+/// without building a value cell from it.
+template<typename T,
+         typename = std::enable_if_t<is_value_alternative_v<T>>>
+[[nodiscard]] bool SameValue( ValueType const & Lhs, T const & Rhs )
+{
+    auto p = GetIfValue<T>( &Lhs );
+    return p && SamePayload( *p, Rhs );
+}
+//---------------------------------------------------------------------------
+
+/// Stores @p Val into @p Dst, moving it when it is an rvalue.  When @p Dst
+/// already holds the same alternative, and does not share it with other
+/// cells, the payload is assigned in place so a container can reuse its
+/// storage.
+template<typename T>
+void AssignValue( ValueType& Dst, T&& Val )
+{
+    using U = std::decay_t<T>;
+    if constexpr ( is_value_alternative_v<U> ) {
+        if ( Dst.template Holds<U>() && Dst.IsUnique() ) {
+            *GetIfValue<U>( &Dst ) = std::forward<T>( Val );
+            return;
+        }
+    }
+    Dst = std::forward<T>( Val );
+}
+//---------------------------------------------------------------------------
+
 /// Inserts or updates a value in the container.
 ///
 /// If @p Id does not exist, inserts the pair as-is and returns @c true.
-/// If @p Id already exists and the stored variant differs from @p Val,
+/// If @p Id already exists and the stored value differs from @p Val,
 /// overwrites it and marks the entry as @c Operation::Write.
 /// Returns @c false when the key was already present (regardless of
-/// whether the value changed).
+/// whether the value changed).  The rvalue overload moves the payload
+/// into the container instead of copying it.
 inline
-bool PutItemTo( ValueContType& Values, String Id,
+bool PutItemTo( ValueContType& Values, TKeyRef Id,
                 ValuePairType const & Val )
 {
-    auto r = Values.insert( std::make_pair( Id, Val ) );
-    if ( !r.second ) {
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        if ( !( r.first->second.first == Val.first ) ) {
-#else
-        if ( r.first->second.first != Val.first ) {
-#endif
-            r.first->second = ValuePairType( Val.first, Operation::Write );
-        }
+    auto i = Values.lower_bound( Id );
+    if ( i == std::end( Values ) || TKeyLess{}( Id, i->first ) ) {
+        Values.try_emplace( i, Id.ToString(), Val );
+        return true;
+    }
+    Id.ShareWith( i->first );
+    if ( !SameValue( i->second.first, Val.first ) ) {
+        AssignValue( i->second.first, Val.first );
+        i->second.second = Operation::Write;
     }
-    return r.second;
+    return false;
+}
+
+inline
+bool PutItemTo( ValueContType& Values, TKeyRef Id, ValuePairType&& Val )
+{
+    auto i = Values.lower_bound( Id );
+    if ( i == std::end( Values ) || TKeyLess{}( Id, i->first ) ) {
+        Values.try_emplace( i, Id.ToString(), std::move( Val ) );
+        return true;
+    }
+    Id.ShareWith( i->first );
+    if ( !SameValue( i->second.first, Val.first ) ) {
+        AssignValue( i->second.first, std::move( Val.first ) );
+        i->second.second = Operation::Write;
+    }
+    return false;
 }
 //---------------------------------------------------------------------------
 
 /// Retrieves (or lazily creates) a value entry by key.
 ///
-/// Attempts to insert @p DefVal under @p Id.  If the key already exists
-/// the insert is a no-op and the *existing* variant is returned — this
-/// is how values loaded from storage survive a subsequent @c GetItem
-/// call with a different default.  The returned reference points into
-/// the map and remains valid until the map is modified.
+/// If @p Id is absent, @p DefVal is inserted under it with state @p Op.
+/// If the key already exists nothing is inserted and the *existing*
+/// value is returned — this is how values loaded from storage survive
+/// a subsequent @c GetItem call with a different default.  The returned
+/// reference points into the map and remains valid until the map is
+/// modified.
 inline
-ValueType& GetItemFrom( ValueContType& Values, String Id, ValueType DefVal,
+ValueType& GetItemFrom( ValueContType& Values, TKeyRef Id, ValueType DefVal,
                         Operation Op )
 {
-    auto r =
-        Values.insert(
-            std::make_pair( Id, std::make_pair( DefVal, Op ) )
-        );
-    return r.first->second.first;
+    auto i = Values.lower_bound( Id );
+    if ( i == std::end( Values ) || TKeyLess{}( Id, i->first ) ) {
+        i = Values.try_emplace(
+                i, Id.ToString(), std::move( DefVal ), Op
+            ).first;
+    }
+    else {
+        Id.ShareWith( i->first );
+    }
+    return i->second.first;
+}
+
+//---------------------------------------------------------------------------
+
+/// Looks up a value entry without inserting anything.
+///
+/// Returns the stored value, or @c nullptr when @p Id is absent or
+/// marked for deletion.
+[[nodiscard]] inline
+ValueType const * FindItemIn( ValueContType const & Values, TKeyRef Id ) noexcept
+{
+    auto i = Values.find( Id );
+    if ( i == std::end( Values ) || i->second.second == Operation::Erase ) {
+        return nullptr;
+    }
+    return &i->second.first;
 }
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,92 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgFileStampH
+#define CfgFileStampH
+
+#include <System.SysUtils.hpp>
+
+#include <windows.h>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+/// What the file system tells about a file without opening it: whether it
+/// exists, its size and its last write time.
+///
+/// Two stamps of a file are equal when, as far as the file system can
+/// tell, it was not rewritten in between.  A rewrite that keeps the size
+/// and lands within the resolution of the write time (100 ns on NTFS, 2 s
+/// on FAT) goes unnoticed.
+class TFileStamp {
+public:
+    /// The stamp of @p FileName now.
+    [[nodiscard]] static TFileStamp Query( String const & FileName ) {
+        TFileStamp Stamp;
+        WIN32_FILE_ATTRIBUTE_DATA Data {};
+        if ( ::GetFileAttributesExW( FileName.c_str(), GetFileExInfoStandard, &Data ) &&
+             !( Data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) )
+        {
+            Stamp.exists_ = true;
+            Stamp.size_ =
+                static_cast<unsigned long long>( Data.nFileSizeHigh ) << 32 |
+                Data.nFileSizeLow;
+            Stamp.writeTime_ =
+                static_cast<unsigned long long>( Data.ftLastWriteTime.dwHighDateTime ) << 32 |
+                Data.ftLastWriteTime.dwLowDateTime;
+        }
+        return Stamp;
+    }
+
+    [[nodiscard]] bool Exists() const noexcept { return exists_; }
+
+    friend bool operator==( TFileStamp const & Lhs, TFileStamp const & Rhs ) noexcept {
+        return
+            Lhs.exists_ == Rhs.exists_ && Lhs.size_ == Rhs.size_ &&
+            Lhs.writeTime_ == Rhs.writeTime_;
+    }
+
+    friend bool operator!=( TFileStamp const & Lhs, TFileStamp const & Rhs ) noexcept {
+        return !( Lhs == Rhs );
+    }
+private:
+    bool exists_ {};
+    unsigned long long size_ {};
+    unsigned long long writeTime_ {};
+};
+
+/// Ties a document kept in memory to the file it mirrors (see
+/// @ref TDocumentMode::Retain).
+///
+/// A backend takes the stamp before it reads the file, so that a change
+/// racing with the read shows up as a mismatch later, and again after it
+/// has written the file.  A flush resets it as soon as it starts patching
+/// the document, so that after a failed flush the next one reloads.
+class TDocumentStamp {
+public:
+    /// Records that the document mirrors @p FileName as it is now.
+    void Take( String const & FileName ) {
+        fileName_ = FileName;
+        stamp_ = TFileStamp::Query( FileName );
+        valid_ = true;
+    }
+
+    void Reset() noexcept { valid_ = false; }
+
+    /// @c true when the document mirrors @p FileName and the file has not
+    /// changed since the stamp was taken.
+    [[nodiscard]] bool Matches( String const & FileName ) const {
+        return
+            valid_ && fileName_ == FileName &&
+            TFileStamp::Query( FileName ) == stamp_;
+    }
+private:
+    String fileName_;
+    TFileStamp stamp_;
+    bool valid_ {};
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,307 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgFlatMapH
+#define CfgFlatMapH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_flat_map.cpp).
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+/// Maps a key-like object to a @c std::wstring_view for ordinal comparison.
+///
+/// The primary template covers everything that is already convertible to
+/// @c std::wstring_view (@c std::wstring, @c wchar_t literals and pointers,
+/// views).  Other key types (e.g. @c System::String in CfgConts.h) provide
+/// an explicit specialisation.
+template<typename K>
+struct TKeyView {
+    static std::wstring_view Get( K const & Key ) noexcept {
+        return std::wstring_view( Key );
+    }
+};
+
+/// Transparent ordinal "less" over anything @ref TKeyView understands.
+///
+/// Comparison is by UTF-16 code unit, which is the same ordering
+/// @c System::String::operator< uses, so switching a container from
+/// @c std::map<String,...> to @ref TFlatMap does not change enumeration
+/// order (and therefore does not change the layout of written files).
+///
+/// Two views of the same characters (a key that shares its buffer with
+/// the one searched for, e.g. an interned key atom) are ordered by their
+/// lengths alone, so the match of a search is found without reading it.
+struct TKeyLess {
+    using is_transparent = void;
+
+    template<typename L, typename R>
+    bool operator()( L const & Lhs, R const & Rhs ) const noexcept {
+        auto const l = TKeyView<L>::Get( Lhs );
+        auto const r = TKeyView<R>::Get( Rhs );
+        return l.data() == r.data() ? l.size() < r.size() : l < r;
+    }
+};
+
+/// Sorted-vector associative container, drop-in for the subset of
+/// @c std::map used by Anafestica.
+///
+/// Elements are stored contiguously as @c std::pair<Key,T> ordered by
+/// @p Compare, so lookups are a binary search over a single allocation and
+/// enumeration is a linear walk.  Lookup members are templates: when
+/// @p Compare is transparent (the default @ref TKeyLess is) a caller can
+/// search with a @c wchar_t literal or a @c std::wstring_view without first
+/// building a @c Key.
+///
+/// Differences from @c std::map that callers must keep in mind:
+/// - the key in @c value_type is not @c const; modifying it through an
+///   iterator breaks the ordering invariant;
+/// - insertion and erasure invalidate iterators and references to
+///   elements (store @c std::unique_ptr in @c T when stable addresses are
+///   required, as @ref NodeContType does).
+///
+/// Insertion after the current last key is amortised O(1), so loading
+/// already-sorted data (every file backend writes its keys in order) does
+/// not pay the O(n) shift of a mid-vector insert.
+template<
+    typename Key,
+    typename T,
+    typename Compare = TKeyLess,
+    typename Allocator = std::allocator<std::pair<Key,T>>
+>
+class TFlatMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key,T>;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+    using container_type = std::vector<value_type,Allocator>;
+    using size_type = typename container_type::size_type;
+    using difference_type = typename container_type::difference_type;
+    using reference = value_type&;
+    using const_reference = value_type const &;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    TFlatMap() = default;
+
+    explicit TFlatMap( Allocator const & Alloc ) : items_( Alloc ) {}
+
+    TFlatMap( std::initializer_list<value_type> Init,
+              Allocator const & Alloc = Allocator() )
+        : items_( Alloc )
+    {
+        items_.reserve( Init.size() );
+        for ( auto const & v : Init ) { insert( v ); }
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const {
+        return items_.get_allocator();
+    }
+
+    iterator begin() noexcept { return items_.begin(); }
+    iterator end() noexcept { return items_.end(); }
+    const_iterator begin() const noexcept { return items_.begin(); }
+    const_iterator end() const noexcept { return items_.end(); }
+    const_iterator cbegin() const noexcept { return items_.cbegin(); }
+    const_iterator cend() const noexcept { return items_.cend(); }
+
+    [[nodiscard]] bool empty() const noexcept { return items_.empty(); }
+    [[nodiscard]] size_type size() const noexcept { return items_.size(); }
+    [[nodiscard]] size_type capacity() const noexcept { return items_.capacity(); }
+
+    void reserve( size_type Count ) { items_.reserve( Count ); }
+    void clear() noexcept { items_.clear(); }
+    void shrink_to_fit() { items_.shrink_to_fit(); }
+    void swap( TFlatMap& Other ) noexcept { items_.swap( Other.items_ ); }
+
+    template<typename K>
+    iterator lower_bound( K const & Id ) {
+        return LowerBound( begin(), end(), MakeProbe( Id ) );
+    }
+
+    template<typename K>
+    const_iterator lower_bound( K const & Id ) const {
+        return LowerBound( begin(), end(), MakeProbe( Id ) );
+    }
+
+    template<typename K>
+    iterator find( K const & Id ) {
+        return Find( begin(), end(), MakeProbe( Id ) );
+    }
+
+    template<typename K>
+    const_iterator find( K const & Id ) const {
+        return Find( begin(), end(), MakeProbe( Id ) );
+    }
+
+    template<typename K>
+    [[nodiscard]] size_type count( K const & Id ) const {
+        return find( Id ) != end() ? 1 : 0;
+    }
+
+    template<typename K>
+    [[nodiscard]] bool contains( K const & Id ) const {
+        return find( Id ) != end();
+    }
+
+    std::pair<iterator,bool> insert( value_type const & Val ) {
+        return emplace_unique( Val.first, Val.second );
+    }
+
+    std::pair<iterator,bool> insert( value_type&& Val ) {
+        return emplace_unique( std::move( Val.first ), std::move( Val.second ) );
+    }
+
+    template<typename P>
+    std::pair<iterator,bool> insert( P&& Val ) {
+        return emplace_unique(
+            std::forward<P>( Val ).first, std::forward<P>( Val ).second
+        );
+    }
+
+    template<typename... A>
+    std::pair<iterator,bool> emplace( A&&... Args ) {
+        value_type Val( std::forward<A>( Args )... );
+        return insert( std::move( Val ) );
+    }
+
+    template<typename... A>
+    std::pair<iterator,bool> try_emplace( key_type const & Id, A&&... Args ) {
+        return emplace_unique( Id, std::forward<A>( Args )... );
+    }
+
+    template<typename... A>
+    std::pair<iterator,bool> try_emplace( key_type&& Id, A&&... Args ) {
+        return emplace_unique( std::move( Id ), std::forward<A>( Args )... );
+    }
+
+    /// Hinted insertion: when @p Hint is the position @c lower_bound
+    /// would return for @p Id (the usual find-then-insert pattern) no
+    /// second search is made.  A wrong hint is detected and ignored.
+    template<typename... A>
+    std::pair<iterator,bool> try_emplace( const_iterator Hint, key_type&& Id,
+                                          A&&... Args ) {
+        if ( IsInsertPosition( Hint, Id ) ) {
+            auto It = items_.emplace(
+                Hint,
+                std::piecewise_construct,
+                std::forward_as_tuple( std::move( Id ) ),
+                std::forward_as_tuple( std::forward<A>( Args )... )
+            );
+            return { It, true };
+        }
+        return emplace_unique( std::move( Id ), std::forward<A>( Args )... );
+    }
+
+    mapped_type& operator[]( key_type const & Id ) {
+        return try_emplace( Id ).first->second;
+    }
+
+    mapped_type& operator[]( key_type&& Id ) {
+        return try_emplace( std::move( Id ) ).first->second;
+    }
+
+    iterator erase( const_iterator Pos ) { return items_.erase( Pos ); }
+
+    iterator erase( const_iterator First, const_iterator Last ) {
+        return items_.erase( First, Last );
+    }
+
+    template<typename K>
+    size_type erase( K const & Id ) {
+        auto It = find( Id );
+        if ( It == end() ) { return 0; }
+        items_.erase( It );
+        return 1;
+    }
+
+private:
+    // Adapts Compare for std::lower_bound, whose predicate receives the
+    // element first and the searched key second.
+    struct KeyCompare {
+        template<typename K>
+        bool operator()( value_type const & Lhs, K const & Rhs ) const {
+            return Compare{}( Lhs.first, Rhs );
+        }
+    };
+
+    container_type items_;
+
+    // With the default comparator the searched key is turned into a
+    // wstring_view once, instead of once per probe (which would mean a
+    // wcslen per comparison for wchar_t pointers).
+    template<typename K>
+    static decltype(auto) MakeProbe( K const & Id ) noexcept {
+        if constexpr ( std::is_same_v<Compare,TKeyLess> ) {
+            return TKeyView<K>::Get( Id );
+        }
+        else {
+            return ( Id );
+        }
+    }
+
+    template<typename It, typename K>
+    static It LowerBound( It First, It Last, K const & Probe ) {
+        return std::lower_bound( First, Last, Probe, KeyCompare{} );
+    }
+
+    template<typename It, typename K>
+    static It Find( It First, It Last, K const & Probe ) {
+        auto i = LowerBound( First, Last, Probe );
+        return i != Last && !Compare{}( Probe, i->first ) ? i : Last;
+    }
+
+    template<typename K>
+    bool IsInsertPosition( const_iterator Hint, K const & Id ) const {
+        return
+            ( Hint == begin() || Compare{}( std::prev( Hint )->first, Id ) ) &&
+            ( Hint == end() || Compare{}( Id, Hint->first ) );
+    }
+
+    template<typename K, typename... A>
+    std::pair<iterator,bool> emplace_unique( K&& Id, A&&... Args ) {
+        // Fast path: appending past the current last key (sorted input).
+        if ( items_.empty() || Compare{}( items_.back().first, Id ) ) {
+            items_.emplace_back(
+                std::piecewise_construct,
+                std::forward_as_tuple( std::forward<K>( Id ) ),
+                std::forward_as_tuple( std::forward<A>( Args )... )
+            );
+            return { std::prev( items_.end() ), true };
+        }
+        auto It = lower_bound( Id );
+        if ( It != end() && !Compare{}( Id, It->first ) ) {
+            return { It, false };
+        }
+        It = items_.emplace(
+            It,
+            std::piecewise_construct,
+            std::forward_as_tuple( std::forward<K>( Id ) ),
+            std::forward_as_tuple( std::forward<A>( Args )... )
+        );
+        return { It, true };
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
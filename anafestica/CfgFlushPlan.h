@@ -0,0 +1,99 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgFlushPlanH
+#define CfgFlushPlanH
+
+#include <System.SysUtils.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <anafestica/CfgItems.h>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+/// What a flush changes: the nodes @ref TConfigNode::Write visits with
+/// something to do, in the order it visits them (the ordinal order of
+/// @c NodeContType).  Streamed flushes (JSON, BSON) merge it into the file
+/// as it is copied out.
+struct TFlushPlan {
+    String Name;
+    ValueContType const * Values {};    ///< saved value list, when not empty
+    std::vector<TFlushPlan> Children;
+    bool Deleted {};
+    bool ChildForces {};                ///< a child has to be forced
+    bool Forces {};                     ///< Values or ChildForces
+};
+
+/// Writer for @ref TConfigNode::Write recording a @ref TFlushPlan.  A node
+/// is forced (created when missing) where the document writers of the
+/// JSON and BSON backends would call @c ForceValues: for each non-empty
+/// value list it is handed.
+class TFlushPlanner {
+public:
+    explicit TFlushPlanner( bool AlwaysFlush )
+        : alwaysFlush_{ AlwaysFlush }, path_{ &root_ } {}
+
+    bool GetAlwaysFlushNodeFlag() const noexcept { return alwaysFlush_; }
+
+    void DeleteNode( TConfigPath const & Path ) {
+        if ( !Path.empty() ) {
+            path_.back()->Deleted = true;
+        }
+    }
+
+    void SaveValueList( TConfigPath const &, ValueContType const & Values ) {
+        if ( !Values.empty() ) {
+            path_.back()->Values = &Values;
+            path_.back()->Forces = true;
+        }
+    }
+
+    void EnterNode( String const & Name ) {
+        // The document writers look nodes up with TJSONValue::FindValue,
+        // which reads these characters as a JSON path.
+        auto const First = Name.c_str();
+        auto const Last = First + Name.Length();
+        if ( First == Last ||
+             std::any_of(
+                 First, Last,
+                 []( WideChar Ch ){ return Ch == '.' || Ch == '[' || Ch == ']'; }
+             ) )
+        {
+            portable_ = false;
+        }
+        auto& Children = path_.back()->Children;
+        Children.push_back( TFlushPlan{ Name } );
+        path_.push_back( &Children.back() );
+    }
+
+    void LeaveNode() noexcept {
+        auto const & Child = *path_.back();
+        path_.pop_back();
+        auto& Parent = *path_.back();
+        if ( Child.Forces ) {
+            Parent.ChildForces = Parent.Forces = true;
+        }
+        else if ( !Child.Deleted && Child.Children.empty() ) {
+            Parent.Children.pop_back();
+        }
+    }
+
+    TFlushPlan const & GetPlan() const noexcept { return root_; }
+
+    /// @c false when a node name would be misread by the document writers,
+    /// which then have to do the flush.
+    bool IsPortable() const noexcept { return portable_; }
+private:
+    bool alwaysFlush_;
+    bool portable_ { true };
+    TFlushPlan root_;
+    std::vector<TFlushPlan*> path_;
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,994 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgIniDocumentH
+#define CfgIniDocumentH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_ini_document.cpp).
+
+#include <anafestica/CfgTypeTag.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace INIFile {
+//---------------------------------------------------------------------------
+
+/// The UTF-8 byte order mark: written ahead of an INI file, skipped when
+/// one is read (as @c TMemIniFile does with @c TEncoding::UTF8).
+inline constexpr std::string_view Utf8Preamble { "\xEF\xBB\xBF", 3 };
+
+/// Sets @p Key to the key of the value @p Name of type @p Tag:
+/// <tt>Name::(Tag)</tt>.
+inline std::string& EncodeKey( std::string& Key, std::string_view Name,
+                               std::string_view Tag )
+{
+    Key.assign( Name );
+    Key += "::(";
+    Key += Tag;
+    Key += ')';
+    return Key;
+}
+
+/// Splits @p Key, <tt>Name::(Tag)</tt>, at its last @c "::(" into @p Name
+/// and @p Tag.  Returns @c false when @p Key does not end with @c ')'
+/// after such a separator, or when either part is empty.
+inline bool DecodeKey( std::string_view Key, std::string_view& Name,
+                       std::string_view& Tag ) noexcept
+{
+    return SplitTagSuffix( Key, "::(", Name, Tag ) && !Name.empty() && !Tag.empty();
+}
+
+namespace Detail {
+
+constexpr char FoldCase( char Ch ) noexcept
+{
+    return Ch >= 'A' && Ch <= 'Z' ? static_cast<char>( Ch - 'A' + 'a' ) : Ch;
+}
+
+/// 32-bit FNV-1a over the case-folded bytes of @p Name.
+constexpr std::uint32_t FoldHash( std::string_view Name ) noexcept
+{
+    std::uint32_t h = 2166136261u;
+    for ( auto c : Name ) {
+        h ^= static_cast<unsigned char>( FoldCase( c ) );
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr bool FoldEqual( std::string_view Lhs, std::string_view Rhs ) noexcept
+{
+    if ( Lhs.size() != Rhs.size() ) {
+        return false;
+    }
+    for ( std::size_t Idx {} ; Idx < Lhs.size() ; ++Idx ) {
+        if ( FoldCase( Lhs[Idx] ) != FoldCase( Rhs[Idx] ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Strips what @c System::SysUtils::Trim strips: the characters up to
+/// and including the space at both ends.
+constexpr std::string_view Trim( std::string_view Text ) noexcept
+{
+    while ( !Text.empty() && static_cast<unsigned char>( Text.front() ) <= ' ' ) {
+        Text.remove_prefix( 1 );
+    }
+    while ( !Text.empty() && static_cast<unsigned char>( Text.back() ) <= ' ' ) {
+        Text.remove_suffix( 1 );
+    }
+    return Text;
+}
+
+/// Length of the UTF-8 sequence at @p Pos of @p Text.  When it is
+/// malformed, @p Valid is set to @c false and the length is that of its
+/// maximal subpart (at least one byte), which a decoder replaces with
+/// U+FFFD.
+inline std::size_t ScanUtf8( std::string_view Text, std::size_t Pos,
+                             bool& Valid ) noexcept
+{
+    auto const Byte = [&]( std::size_t Idx ) {
+        return static_cast<unsigned char>( Text[Idx] );
+    };
+    auto const Lead = Byte( Pos );
+    Valid = true;
+    if ( Lead < 0x80 ) {
+        return 1;
+    }
+    std::size_t Length {};
+    unsigned char Low = 0x80;
+    unsigned char High = 0xBF;
+    if ( Lead >= 0xC2 && Lead <= 0xDF ) {
+        Length = 2;
+    }
+    else if ( Lead >= 0xE0 && Lead <= 0xEF ) {
+        Length = 3;
+        if ( Lead == 0xE0 ) { Low = 0xA0; }             // overlong
+        else if ( Lead == 0xED ) { High = 0x9F; }       // surrogates
+    }
+    else if ( Lead >= 0xF0 && Lead <= 0xF4 ) {
+        Length = 4;
+        if ( Lead == 0xF0 ) { Low = 0x90; }             // overlong
+        else if ( Lead == 0xF4 ) { High = 0x8F; }       // above U+10FFFF
+    }
+    else {
+        Valid = false;
+        return 1;
+    }
+    for ( std::size_t Idx = 1 ; Idx < Length ; ++Idx ) {
+        if ( Pos + Idx >= Text.size() ||
+             Byte( Pos + Idx ) < Low || Byte( Pos + Idx ) > High )
+        {
+            Valid = false;
+            return Idx;
+        }
+        Low = 0x80;
+        High = 0xBF;
+    }
+    return Length;
+}
+
+inline bool IsValidUtf8( std::string_view Text ) noexcept
+{
+    for ( std::size_t Pos {} ; Pos < Text.size() ; ) {
+        // ASCII eight bytes at a time
+        std::uint64_t Block;
+        if ( Pos + sizeof Block <= Text.size() ) {
+            std::memcpy( &Block, Text.data() + Pos, sizeof Block );
+            if ( !( Block & 0x8080808080808080u ) ) {
+                Pos += sizeof Block;
+                continue;
+            }
+        }
+        if ( static_cast<unsigned char>( Text[Pos] ) < 0x80 ) {
+            ++Pos;
+            continue;
+        }
+        bool Valid;
+        Pos += ScanUtf8( Text, Pos, Valid );
+        if ( !Valid ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @p Text with every malformed sequence replaced by U+FFFD.
+inline std::string ToValidUtf8( std::string_view Text )
+{
+    std::string Result;
+    Result.reserve( Text.size() );
+    for ( std::size_t Pos {} ; Pos < Text.size() ; ) {
+        bool Valid;
+        auto const Length = ScanUtf8( Text, Pos, Valid );
+        if ( Valid ) {
+            Result.append( Text.data() + Pos, Length );
+        }
+        else {
+            Result += "\xEF\xBF\xBD";
+        }
+        Pos += Length;
+    }
+    return Result;
+}
+
+/// Open-addressing hash table from case-folded names to items numbered
+/// by their owner.  Each name maps to the first of the items with that
+/// name; the owner links the others behind it.  Names are not stored:
+/// @c NameOf( Item ) gives the name of an item.  Their hashes are, so
+/// that a probe only looks at a name when its hash matches.
+class TFoldIndex {
+public:
+    static constexpr std::uint32_t None = UINT32_MAX;
+
+    /// The item @p Name maps to, or @ref None.
+    template<typename N>
+    std::uint32_t Find( std::string_view Name, N const & NameOf ) const {
+        if ( slots_.empty() ) {
+            return None;
+        }
+        auto const Hash = FoldHash( Name );
+        auto const Mask = slots_.size() - 1;
+        for ( auto Idx = Hash & Mask ;; Idx = ( Idx + 1 ) & Mask ) {
+            auto const & Slot = slots_[Idx];
+            if ( Slot.Item == None ) {
+                return None;
+            }
+            if ( Slot.Hash == Hash && Slot.Item != Erased &&
+                 FoldEqual( NameOf( Slot.Item ), Name ) )
+            {
+                return Slot.Item;
+            }
+        }
+    }
+
+    /// Maps the name of @p Item to @p Item unless it is mapped already;
+    /// returns the item it was mapped to, or @ref None.
+    template<typename N>
+    std::uint32_t Insert( std::uint32_t Item, N const & NameOf ) {
+        if ( ( used_ + 1 ) * 4 > slots_.size() * 3 ) {
+            Rehash();
+        }
+        auto const Name = NameOf( Item );
+        auto const Hash = FoldHash( Name );
+        auto const Mask = slots_.size() - 1;
+        auto Free = slots_.size();
+        for ( auto Idx = Hash & Mask ;; Idx = ( Idx + 1 ) & Mask ) {
+            auto const & Slot = slots_[Idx];
+            if ( Slot.Item == None ) {
+                if ( Free == slots_.size() ) {
+                    Free = Idx;
+                    ++used_;
+                }
+                slots_[Free] = { Item, Hash };
+                ++live_;
+                return None;
+            }
+            if ( Slot.Item == Erased ) {
+                if ( Free == slots_.size() ) {
+                    Free = Idx;
+                }
+            }
+            else if ( Slot.Hash == Hash && FoldEqual( NameOf( Slot.Item ), Name ) ) {
+                return Slot.Item;
+            }
+        }
+    }
+
+    /// Maps the name @p Item is mapped under to @p Next instead, or
+    /// unmaps it when @p Next is @ref None.
+    void Replace( std::string_view Name, std::uint32_t Item, std::uint32_t Next ) {
+        auto const Mask = slots_.size() - 1;
+        for ( auto Idx = FoldHash( Name ) & Mask ;; Idx = ( Idx + 1 ) & Mask ) {
+            if ( slots_[Idx].Item == Item ) {
+                slots_[Idx].Item = Next == None ? Erased : Next;
+                live_ -= Next == None;
+                return;
+            }
+        }
+    }
+
+    void Clear() noexcept {
+        slots_.clear();
+        used_ = 0;
+        live_ = 0;
+    }
+private:
+    static constexpr std::uint32_t Erased = UINT32_MAX - 1;
+
+    struct TSlot {
+        std::uint32_t Item;
+        std::uint32_t Hash;
+    };
+
+    std::vector<TSlot> slots_;
+    std::size_t used_ {};       // slots not empty, erased ones included
+    std::size_t live_ {};
+
+    void Rehash() {
+        std::size_t Size = 16;
+        while ( Size * 3 < ( live_ + 1 ) * 8 ) {
+            Size *= 2;
+        }
+        std::vector<TSlot> Slots( Size, TSlot{ None, 0 } );
+        Slots.swap( slots_ );
+        used_ = live_;
+        auto const Mask = Size - 1;
+        for ( auto const & Slot : Slots ) {
+            if ( Slot.Item != None && Slot.Item != Erased ) {
+                auto Idx = Slot.Hash & Mask;
+                while ( slots_[Idx].Item != None ) {
+                    Idx = ( Idx + 1 ) & Mask;
+                }
+                slots_[Idx] = Slot;
+            }
+        }
+    }
+};
+
+} // End of namespace Detail
+
+/// How a TDocument lays out the text it writes.
+enum class TLayout {
+    /// As @c TMemIniFile::UpdateFile does; the text read only gives the
+    /// values.
+    Canonical,
+    /// As the text read, with the lines of the values written or erased
+    /// since patched, new values inserted after the last line of their
+    /// section and new sections appended.
+    Preserve
+};
+
+/// An INI file in memory, read and written the way @c TMemIniFile does.
+///
+/// The text is parsed in one pass: lines end at CR, LF or CR LF and are
+/// trimmed; empty lines, lines starting with @c ';' and lines ahead of
+/// the first section are dropped; <tt>[Name]</tt> starts a section;
+/// other lines are kept as <tt>Name=Value</tt> with the spaces around the
+/// first @c '=' removed, or as they are when they have none.  Malformed
+/// UTF-8 is read as U+FFFD.  Names and values stay views into the text
+/// until they are written.
+///
+/// Section names and, once a section is looked into, its value names are
+/// kept in hash tables.  Both compare with ASCII letters folded to lower
+/// case (@c TMemIniFile folds every letter); the first of several
+/// sections, or values in a section, with the same name is the one found,
+/// read, replaced and erased.  Writing an unknown value appends it to its
+/// section, writing an unknown section appends it to the file.
+///
+/// @ref WriteTo lays the document out as @c TMemIniFile::UpdateFile does:
+/// each section, then its lines, then an empty line, all ending in CR LF.
+/// All text is UTF-8.
+///
+/// With TLayout::Preserve the parse only finds the sections, and the
+/// lines of a section are parsed when it is first looked into; the lines
+/// written or erased are recorded.  @ref WriteTo then copies the text
+/// read, comments, spacing and line ends included, and only writes the
+/// recorded lines (just the value, when the name is unchanged), with the
+/// line end of the text: its cost beyond the copy follows the number of
+/// changes, not the size of the file.  Erasing a section removes the text
+/// from its header to the next one.
+class TDocument {
+public:
+    TDocument() = default;
+
+    /// Parses @p Text, without its byte order mark.
+    explicit TDocument( std::string Text, TLayout Layout = TLayout::Canonical )
+        : text_{ std::move( Text ) }, layout_{ Layout }
+    {
+        if ( !Detail::IsValidUtf8( text_ ) ) {
+            text_ = Detail::ToValidUtf8( text_ );
+        }
+        Parse();
+    }
+
+    // Not movable either: names and values are views into text_, which
+    // may be held in the string object itself.
+    TDocument( TDocument const & ) = delete;
+    TDocument& operator=( TDocument const & ) = delete;
+
+    /// Calls @p Fn with the name of each section, in file order.
+    template<typename F>
+    void ForEachSection( F&& Fn ) const {
+        for ( auto const & Section : sections_ ) {
+            if ( !Section.Erased ) {
+                Fn( Section.Name );
+            }
+        }
+    }
+
+    /// Calls @p Fn with the name and the value of each <tt>Name=Value</tt>
+    /// line of section @p Section, in file order.  The value is that of
+    /// the first line with the name.
+    template<typename F>
+    void ForEachValue( std::string_view Section, F&& Fn ) {
+        auto const Idx = FindSection( Section );
+        if ( Idx == None ) {
+            return;
+        }
+        auto& S = sections_[Idx];
+        auto const & Keys = GetKeys( S );
+        for ( auto const & Line : S.Lines ) {
+            if ( Line.Pair && !Line.Erased ) {
+                Fn( Line.Name, S.Lines[Keys.Find( Line.Name, LineNames( S ) )].Value );
+            }
+        }
+    }
+
+    /// Sets value @p Name of section @p Section to @p Value.  Neither may
+    /// refer to the text of the document.
+    void WriteString( std::string_view Section, std::string_view Name,
+                      std::string_view Value )
+    {
+        auto Idx = FindSection( Section );
+        if ( Idx == None ) {
+            Idx = AddSection( Section );
+        }
+        auto& S = sections_[Idx];
+        auto& Keys = GetKeys( S );
+        auto Item = Keys.Find( Name, LineNames( S ) );
+        if ( Item == None ) {
+            Item = static_cast<std::uint32_t>( S.Lines.size() );
+            S.Lines.emplace_back();
+            S.Lines.back().Pair = true;
+            Store( S.Lines.back(), Name, Value );
+            Keys.Insert( Item, LineNames( S ) );
+        }
+        else {
+            Store( S.Lines[Item], Name, Value );
+        }
+        Changed( Idx, Item );
+    }
+
+    /// Removes value @p Name of section @p Section.
+    void DeleteKey( std::string_view Section, std::string_view Name ) {
+        auto const Idx = FindSection( Section );
+        if ( Idx == None ) {
+            return;
+        }
+        auto& S = sections_[Idx];
+        auto& Keys = GetKeys( S );
+        auto const Item = Keys.Find( Name, LineNames( S ) );
+        if ( Item == None ) {
+            return;
+        }
+        auto& Line = S.Lines[Item];
+        Keys.Replace( Name, Item, Line.NextSame );
+        Line.Erased = true;
+        Release( Line.Own );
+        Changed( Idx, Item );
+    }
+
+    /// Removes section @p Section with its lines.
+    void EraseSection( std::string_view Section ) {
+        auto const Idx = FindSection( Section );
+        if ( Idx == None ) {
+            return;
+        }
+        auto& S = sections_[Idx];
+        sectionIndex_.Replace( Section, Idx, S.NextSame );
+        S.Erased = true;
+        Release( S.Own );
+        for ( auto& Line : S.Lines ) {
+            Release( Line.Own );
+        }
+        S.Lines = std::vector<TLine>{};
+        S.Keys.Clear();
+        S.Parsed = true;
+        if ( layout_ == TLayout::Preserve && S.Start != npos ) {
+            erased_.push_back( Idx );
+        }
+    }
+
+    /// Writes the document to @p Sink, which has
+    /// <tt>void Append( char const *, std::size_t )</tt>.
+    template<typename S>
+    void WriteTo( S& Sink ) const {
+        if ( layout_ == TLayout::Preserve ) {
+            WritePatched( Sink );
+            return;
+        }
+        for ( auto const & Section : sections_ ) {
+            if ( Section.Erased ) {
+                continue;
+            }
+            Sink.Append( "[", 1 );
+            Sink.Append( Section.Name.data(), Section.Name.size() );
+            Sink.Append( "]\r\n", 3 );
+            for ( auto const & Line : Section.Lines ) {
+                if ( Line.Erased ) {
+                    continue;
+                }
+                Sink.Append( Line.Name.data(), Line.Name.size() );
+                if ( Line.Pair ) {
+                    Sink.Append( "=", 1 );
+                    Sink.Append( Line.Value.data(), Line.Value.size() );
+                }
+                Sink.Append( "\r\n", 2 );
+            }
+            Sink.Append( "\r\n", 2 );
+        }
+    }
+private:
+    static constexpr std::uint32_t None = Detail::TFoldIndex::None;
+    static constexpr std::size_t npos = std::string_view::npos;
+
+    // Start and End are offsets into text_, npos for what was written.
+    // End is past the line end.
+
+    struct TLine {
+        std::string_view Name;      // the whole line unless Pair
+        std::string_view Value;
+        std::uint32_t Own = None;   // slot of owned_ holding Name and Value
+        std::uint32_t NextSame = None;
+        std::size_t Start = npos;
+        std::size_t End = npos;
+        bool Pair {};
+        bool Erased {};
+        bool Listed {};             // in changed_
+    };
+
+    struct TSection {
+        std::string_view Name;
+        std::uint32_t Own = None;   // slot of owned_ holding Name
+        std::uint32_t NextSame = None;
+        std::size_t Start = npos;   // of the header
+        std::size_t Body = npos;    // past the header
+        std::size_t End = npos;     // the next header, or the end of text_
+        std::size_t Anchor = npos;  // past the last line kept, or the header
+        bool Erased {};
+        bool Parsed = true;         // Lines is built
+        bool Indexed {};            // Keys is built
+        std::vector<TLine> Lines;
+        Detail::TFoldIndex Keys;
+    };
+
+    // A change to text_ for WriteTo with TLayout::Preserve: Length bytes
+    // at Offset are replaced by line Line of section Section, or removed
+    // with the section when Line is None.
+    struct TPatch {
+        std::size_t Offset;
+        std::size_t Length;
+        std::uint32_t Section;
+        std::uint32_t Line;
+        std::uint32_t Order;
+        bool ValueOnly;             // Length bytes are the value of Line
+        bool Inserted;              // Line is new
+    };
+
+    std::string text_;
+    TLayout layout_ {};
+    std::vector<TSection> sections_;
+    Detail::TFoldIndex sectionIndex_;
+    // Text written into the document; a deque, so that the strings never
+    // move and views into them stay valid.
+    std::deque<std::string> owned_;
+    std::vector<std::uint32_t> free_;
+    // The number of sections read from text_; with TLayout::Preserve, the
+    // lines of these written or erased and those of these erased.
+    std::uint32_t parsed_ {};
+    std::vector<std::pair<std::uint32_t,std::uint32_t>> changed_;
+    std::vector<std::uint32_t> erased_;
+    std::string_view eol_ { "\r\n" };
+
+    struct TSectionNames {
+        std::vector<TSection> const & Sections;
+
+        std::string_view operator()( std::uint32_t Idx ) const {
+            return Sections[Idx].Name;
+        }
+    };
+
+    struct TLineNames {
+        TSection const & Section;
+
+        std::string_view operator()( std::uint32_t Idx ) const {
+            return Section.Lines[Idx].Name;
+        }
+    };
+
+    TSectionNames SectionNames() const { return { sections_ }; }
+
+    static TLineNames LineNames( TSection const & S ) { return { S }; }
+
+    // Passes its input on to Sink, keeping the last bytes of it.
+    template<typename S>
+    struct TTailSink {
+        S& Sink;
+        char Tail[4] {};
+        std::size_t Size {};
+
+        void Append( char const * Data, std::size_t Length ) {
+            Sink.Append( Data, Length );
+            for ( auto Idx = Length > 4 ? Length - 4 : 0 ; Idx < Length ; ++Idx ) {
+                Tail[0] = Tail[1];
+                Tail[1] = Tail[2];
+                Tail[2] = Tail[3];
+                Tail[3] = Data[Idx];
+            }
+            Size += Length;
+        }
+
+        // The line ends the input ends with, up to two.
+        int Breaks() const noexcept {
+            auto Text = std::string_view( Tail, 4 ).substr( Size < 4 ? 4 - Size : 0 );
+            int Count {};
+            while ( Count < 2 && !Text.empty() ) {
+                if ( Text.size() >= 2 && Text.substr( Text.size() - 2 ) == "\r\n" ) {
+                    Text.remove_suffix( 2 );
+                }
+                else if ( Text.back() == '\r' || Text.back() == '\n' ) {
+                    Text.remove_suffix( 1 );
+                }
+                else {
+                    break;
+                }
+                ++Count;
+            }
+            return Count;
+        }
+    };
+
+    template<typename S>
+    void WritePatched( S& Sink ) const {
+        std::vector<TPatch> Patches;
+        Patches.reserve( changed_.size() + erased_.size() );
+        for ( auto const & [Idx, Item] : changed_ ) {
+            auto const & Section = sections_[Idx];
+            if ( Section.Erased ) {
+                continue;
+            }
+            auto const & Line = Section.Lines[Item];
+            auto const Order = static_cast<std::uint32_t>( Patches.size() );
+            if ( Line.Start == npos ) {
+                if ( !Line.Erased ) {
+                    Patches.push_back( { Section.Anchor, 0, Idx, Item, Order, false, true } );
+                }
+            }
+            else if ( Line.Erased ) {
+                Patches.push_back( { Line.Start, Line.End - Line.Start, Idx, Item, Order, false, false } );
+            }
+            else {
+                // What the line had: the name is kept when it is unchanged,
+                // and what is around the value in any case.
+                std::size_t Break {};
+                NextLine( Line.Start, Break );
+                auto const Text = Detail::Trim( View( Line.Start, Break ) );
+                auto const Sep = Text.find( '=' );
+                auto const Name = Detail::Trim( Text.substr( 0, Sep ) );
+                auto const Value = Detail::Trim( Text.substr( Sep + 1 ) );
+                auto const Same = Name == Line.Name;
+                auto const From = Same ? Value.data() : Name.data();
+                Patches.push_back( {
+                    static_cast<std::size_t>( From - text_.data() ),
+                    static_cast<std::size_t>( Value.data() + Value.size() - From ),
+                    Idx, Item, Order, Same, false
+                } );
+            }
+        }
+        for ( auto const Idx : erased_ ) {
+            auto const & Section = sections_[Idx];
+            Patches.push_back( {
+                Section.Start, Section.End - Section.Start, Idx, None,
+                static_cast<std::uint32_t>( Patches.size() ), false, false
+            } );
+        }
+        std::sort(
+            Patches.begin(), Patches.end(),
+            // New lines after the patches of the text at their offset
+            // (an empty value on a last line without a line end).
+            []( TPatch const & Lhs, TPatch const & Rhs ) {
+                if ( Lhs.Offset != Rhs.Offset ) {
+                    return Lhs.Offset < Rhs.Offset;
+                }
+                if ( Lhs.Inserted != Rhs.Inserted ) {
+                    return Rhs.Inserted;
+                }
+                return Lhs.Order < Rhs.Order;
+            }
+        );
+
+        TTailSink<S> Out{ Sink };
+        std::size_t Pos {};
+        for ( auto const & Patch : Patches ) {
+            if ( Patch.Offset > Pos ) {
+                Out.Append( text_.data() + Pos, Patch.Offset - Pos );
+                Pos = Patch.Offset;
+            }
+            if ( Patch.Line != None ) {
+                auto const & Line = sections_[Patch.Section].Lines[Patch.Line];
+                if ( Patch.ValueOnly ) {
+                    Out.Append( Line.Value.data(), Line.Value.size() );
+                }
+                else if ( !Line.Erased ) {
+                    // New lines go after a line end, which the last line of
+                    // the text may lack.
+                    auto const Ahead = Patch.Inserted && Out.Size && !Out.Breaks();
+                    if ( Ahead ) {
+                        Out.Append( eol_.data(), eol_.size() );
+                    }
+                    Out.Append( Line.Name.data(), Line.Name.size() );
+                    Out.Append( "=", 1 );
+                    Out.Append( Line.Value.data(), Line.Value.size() );
+                    if ( Patch.Inserted && !Ahead ) {
+                        Out.Append( eol_.data(), eol_.size() );
+                    }
+                }
+            }
+            Pos = std::max( Pos, Patch.Offset + Patch.Length );
+        }
+        Out.Append( text_.data() + Pos, text_.size() - Pos );
+
+        auto Separated = false;
+        for ( auto Idx = parsed_ ; Idx < sections_.size() ; ++Idx ) {
+            auto const & Section = sections_[Idx];
+            if ( Section.Erased ) {
+                continue;
+            }
+            // New sections follow an empty line, as they do in the layout
+            // of TMemIniFile.
+            if ( !Separated && Out.Size ) {
+                for ( auto Count = Out.Breaks() ; Count < 2 ; ++Count ) {
+                    Out.Append( eol_.data(), eol_.size() );
+                }
+            }
+            Separated = true;
+            Out.Append( "[", 1 );
+            Out.Append( Section.Name.data(), Section.Name.size() );
+            Out.Append( "]", 1 );
+            Out.Append( eol_.data(), eol_.size() );
+            for ( auto const & Line : Section.Lines ) {
+                if ( Line.Erased ) {
+                    continue;
+                }
+                Out.Append( Line.Name.data(), Line.Name.size() );
+                Out.Append( "=", 1 );
+                Out.Append( Line.Value.data(), Line.Value.size() );
+                Out.Append( eol_.data(), eol_.size() );
+            }
+            Out.Append( eol_.data(), eol_.size() );
+        }
+    }
+
+    // With TLayout::Preserve, only the headers are looked for (see
+    // FindSections) and the lines of each section are left to ParseLines.
+    void Parse() {
+        if ( layout_ == TLayout::Preserve ) {
+            FindSections();
+        }
+        else {
+            auto Section = None;
+            std::size_t Pos {};
+            while ( Pos < text_.size() ) {
+                std::size_t Break {};
+                auto const End = NextLine( Pos, Break );
+                auto const Line = Detail::Trim( View( Pos, Break ) );
+                if ( IsHeader( Line ) ) {
+                    Section = AddHeader( Line, Pos, End );
+                }
+                else if ( Section != None ) {
+                    AddLine( sections_[Section], Line, Pos, End );
+                }
+                Pos = End;
+            }
+        }
+        if ( !sections_.empty() ) {
+            sections_.back().End = text_.size();
+        }
+        parsed_ = static_cast<std::uint32_t>( sections_.size() );
+        auto const Break = text_.find_first_of( "\r\n" );
+        if ( Break != npos && text_.compare( Break, 2, "\r\n" ) ) {
+            eol_ = View( Break, Break + 1 );
+        }
+    }
+
+    // Finds the headers by their '[', which only starts other lines
+    // when they are read as a name or as a value.
+    void FindSections() {
+        char const * const First = text_.data();
+        char const * const Last = First + text_.size();
+        for ( auto Ch = First ; ; ++Ch ) {
+            Ch = static_cast<char const *>( std::memchr( Ch, '[', Last - Ch ) );
+            if ( !Ch ) {
+                return;
+            }
+            auto Start = static_cast<std::size_t>( Ch - First );
+            while ( Start && static_cast<unsigned char>( text_[Start - 1] ) <= ' ' &&
+                    text_[Start - 1] != '\r' && text_[Start - 1] != '\n' )
+            {
+                --Start;
+            }
+            if ( Start && text_[Start - 1] != '\r' && text_[Start - 1] != '\n' ) {
+                continue;
+            }
+            std::size_t Break {};
+            auto const End = NextLine( Ch - First, Break );
+            auto const Line = Detail::Trim( View( Start, Break ) );
+            if ( IsHeader( Line ) ) {
+                AddHeader( Line, Start, End );
+                Ch = First + End - 1;
+            }
+        }
+    }
+
+    static bool IsHeader( std::string_view Line ) noexcept {
+        return !Line.empty() && Line.front() == '[' && Line.back() == ']';
+    }
+
+    // Adds the section of header Line, trimmed, of text_ from Start to End.
+    std::uint32_t AddHeader( std::string_view Line, std::size_t Start, std::size_t End ) {
+        auto const Idx = static_cast<std::uint32_t>( sections_.size() );
+        if ( Idx ) {
+            sections_.back().End = Start;
+        }
+        auto& S = sections_.emplace_back();
+        S.Name = Detail::Trim( Line.substr( 1, Line.size() - 2 ) );
+        S.Start = Start;
+        S.Body = S.Anchor = End;
+        S.Parsed = layout_ != TLayout::Preserve;
+        Chain( sections_, sectionIndex_.Insert( Idx, SectionNames() ), Idx );
+        return Idx;
+    }
+
+    void ParseLines( TSection& S ) {
+        for ( auto Pos = S.Body ; Pos < S.End ; ) {
+            std::size_t Break {};
+            auto const End = NextLine( Pos, Break );
+            AddLine( S, Detail::Trim( View( Pos, Break ) ), Pos, End );
+            Pos = End;
+        }
+        S.Parsed = true;
+    }
+
+    // Adds Line, trimmed, of text_ from Start to End to S, unless it is
+    // empty or a comment.
+    static void AddLine( TSection& S, std::string_view Line, std::size_t Start,
+                         std::size_t End )
+    {
+        if ( Line.empty() || Line.front() == ';' ) {
+            return;
+        }
+        auto& L = S.Lines.emplace_back();
+        auto const Sep = Line.find( '=' );
+        if ( Sep == std::string_view::npos ) {
+            L.Name = Line;
+        }
+        else {
+            L.Name = Detail::Trim( Line.substr( 0, Sep ) );
+            L.Value = Detail::Trim( Line.substr( Sep + 1 ) );
+            L.Pair = true;
+        }
+        L.Start = Start;
+        L.End = S.Anchor = End;
+    }
+
+    // Returns the end of the line at Pos, past its line end, and sets
+    // Break to where the line end starts.
+    std::size_t NextLine( std::size_t Pos, std::size_t& Break ) const noexcept {
+        while ( Pos < text_.size() && text_[Pos] != '\r' && text_[Pos] != '\n' ) {
+            ++Pos;
+        }
+        Break = Pos;
+        if ( Pos < text_.size() && text_[Pos] == '\r' ) {
+            ++Pos;
+        }
+        if ( Pos < text_.size() && text_[Pos] == '\n' ) {
+            ++Pos;
+        }
+        return Pos;
+    }
+
+    std::string_view View( std::size_t Start, std::size_t End ) const noexcept {
+        return std::string_view( text_ ).substr( Start, End - Start );
+    }
+
+    // Links Item behind First, the item its name is mapped to, if any.
+    template<typename C>
+    static void Chain( C& Items, std::uint32_t First, std::uint32_t Item ) {
+        if ( First != None ) {
+            while ( Items[First].NextSame != None ) {
+                First = Items[First].NextSame;
+            }
+            Items[First].NextSame = Item;
+        }
+    }
+
+    std::uint32_t FindSection( std::string_view Name ) const {
+        return sectionIndex_.Find( Name, SectionNames() );
+    }
+
+    std::uint32_t AddSection( std::string_view Name ) {
+        auto const Idx = static_cast<std::uint32_t>( sections_.size() );
+        auto& S = sections_.emplace_back();
+        S.Own = Acquire();
+        auto& Text = owned_[S.Own];
+        Text.assign( Name );
+        S.Name = Text;
+        sectionIndex_.Insert( Idx, SectionNames() );
+        return Idx;
+    }
+
+    Detail::TFoldIndex& GetKeys( TSection& S ) {
+        if ( !S.Parsed ) {
+            ParseLines( S );
+        }
+        if ( !S.Indexed ) {
+            auto const Names = LineNames( S );
+            for ( std::uint32_t Idx {} ; Idx < S.Lines.size() ; ++Idx ) {
+                auto const & Line = S.Lines[Idx];
+                if ( Line.Pair && !Line.Erased ) {
+                    Chain( S.Lines, S.Keys.Insert( Idx, Names ), Idx );
+                }
+            }
+            S.Indexed = true;
+        }
+        return S.Keys;
+    }
+
+    // With TLayout::Preserve, records a change to line Item of section
+    // Idx when the section is in text_.
+    void Changed( std::uint32_t Idx, std::uint32_t Item ) {
+        auto& S = sections_[Idx];
+        if ( layout_ == TLayout::Preserve && S.Start != npos && !S.Lines[Item].Listed ) {
+            S.Lines[Item].Listed = true;
+            changed_.emplace_back( Idx, Item );
+        }
+    }
+
+    void Store( TLine& Line, std::string_view Name, std::string_view Value ) {
+        if ( Line.Own == None ) {
+            Line.Own = Acquire();
+        }
+        auto& Text = owned_[Line.Own];
+        Text.assign( Name );
+        Text += Value;
+        Line.Name = std::string_view( Text ).substr( 0, Name.size() );
+        Line.Value = std::string_view( Text ).substr( Name.size() );
+    }
+
+    std::uint32_t Acquire() {
+        if ( !free_.empty() ) {
+            auto const Slot = free_.back();
+            free_.pop_back();
+            return Slot;
+        }
+        owned_.emplace_back();
+        return static_cast<std::uint32_t>( owned_.size() - 1 );
+    }
+
+    void Release( std::uint32_t& Slot ) {
+        if ( Slot != None ) {
+            owned_[Slot].clear();
+            free_.push_back( Slot );
+            Slot = None;
+        }
+    }
+};
+
+/// Sink that collects its input in memory.
+template<typename C = std::string>
+struct TMemorySink {
+    C& Out;
+
+    void Append( char const * Data, std::size_t Length ) {
+        Out.insert( Out.end(), Data, Data + Length );
+    }
+};
+
+/// Sink that gathers its input into blocks and passes each on to
+/// @p Out, with <tt>void Write( char const *, std::size_t )</tt>; input
+/// larger than a block goes straight through.  @ref Flush passes on what
+/// is left (the destructor does not).
+template<typename W>
+class TBufferedSink {
+public:
+    explicit TBufferedSink( W& Out, std::size_t Capacity = 64 * 1024 )
+        : out_{ Out }, capacity_{ Capacity }
+    {
+        buffer_.reserve( Capacity );
+    }
+
+    void Append( char const * Data, std::size_t Length ) {
+        if ( buffer_.size() + Length > capacity_ ) {
+            Flush();
+            if ( Length >= capacity_ ) {
+                out_.Write( Data, Length );
+                return;
+            }
+        }
+        buffer_.insert( buffer_.end(), Data, Data + Length );
+    }
+
+    void Flush() {
+        if ( !buffer_.empty() ) {
+            out_.Write( buffer_.data(), buffer_.size() );
+            buffer_.clear();
+        }
+    }
+private:
+    W& out_;
+    std::size_t capacity_;
+    std::vector<char> buffer_;
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace INIFile
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
@@ -3,28 +3,36 @@
 #ifndef CfgIniFileH
 #define CfgIniFileH
 
-// NOTE: TMemIniFile (System.IniFiles) is used here, NOT TRegIniFile.
-// TRegIniFile stores data in the Windows Registry using an INI-like API –
-// that role is already covered by Anafestica::Registry::TConfig.
-// TMemIniFile reads the whole file into memory on construction and writes
-// it back atomically via UpdateFile(), matching the RAII lifecycle used by
-// the XML and JSON backends.
-
-#include <System.IniFiles.hpp>
+// NOTE: the file is read and written by INIFile::TDocument (CfgIniDocument.h),
+// a portable engine that reads and lays out INI text as TMemIniFile did, so
+// files written by earlier versions come out the same.  It reads the whole
+// file into memory when the document is opened and writes it back in one go
+// on flush, matching the RAII lifecycle used by the XML and JSON backends.
+// Constructed with TLayout::Preserve, an object's flush keeps the file as it
+// was and only patches the lines of the values it writes or erases.
+
 #include <System.IOUtils.hpp>
 #include <System.NetEncoding.hpp>
 #include <System.DateUtils.hpp>
 #include <System.SysUtils.hpp>
 #include <System.Classes.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <vector>
-#include <array>
-#include <functional>
 #include <string>
+#include <string_view>
 
 #include <anafestica/Cfg.h>
+#include <anafestica/CfgCodec.h>
+#include <anafestica/CfgNodeCursor.h>
 #include <anafestica/CfgCrypt.h>
+#include <anafestica/CfgFileStamp.h>
+#include <anafestica/CfgIniDocument.h>
+#include <anafestica/CfgIniSections.h>
 
 //---------------------------------------------------------------------------
 namespace Anafestica {
@@ -51,19 +59,35 @@ namespace INIFile {
 //
 // StringCont is encoded as items joined by '|', with '\' → '\\' and
 // '|' → '\|' escaping.  Binary types (TBytes, BytesCont) are base-64.
-// The file is written in UTF-8 encoding.
+// The file is written in UTF-8 encoding, with a byte order mark.
+//
+// The constructors' Layout argument selects the TLayout of the files an
+// object writes:
+//
+//   INIFile::TConfig Cfg( FileName, false, false, {}, INIFile::TLayout::Preserve );
+//   Cfg.GetRootNode().PutItem( _D( "Port" ), 5433 );
+//   Cfg.Flush();    // rewrites the port line only; comments stay
+//
+// With TLayout::Preserve a flush writes the text of the file back as it
+// read it, with the lines of the values written or erased patched in
+// place, new values after the last line of their section and new sections
+// at the end, all with the line end the file uses.  The file is written in
+// a single call, and keeps or lacks its byte order mark.  Reading is the
+// same in both layouts.
 
 class TConfig : public Anafestica::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false, bool FlushAllItems = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, FlushAllItems )
+             Crypt::TOptions CryptOptions = {},
+             TLayout Layout = TLayout::Canonical, TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, FlushAllItems, Options )
         , fileName_( FileName ), loadFileName_( FileName )
         , cryptOptions_( CryptOptions )
+        , layout_{ Layout }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
             IniFileRAII Ini( *this, loadFileName_ );
-            GetRootNode().Read( *this, TConfigPath{} );
+            ReadRootNode();
         }
     }
 
@@ -73,17 +97,19 @@ public:
     /// still written to the destination.  See @ref Migrate for a named
     /// wrapper that makes the load/save direction unambiguous.
     TConfig( String LoadFileName, String SaveFileName, bool ReadOnly = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true )
+             Crypt::TOptions CryptOptions = {},
+             TLayout Layout = TLayout::Canonical, TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true, Options )
         , fileName_( SaveFileName )
         , loadFileName_(
             TFile::Exists( SaveFileName ) ? SaveFileName : LoadFileName
           )
         , cryptOptions_( CryptOptions )
+        , layout_{ Layout }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
             IniFileRAII Ini( *this, loadFileName_ );
-            GetRootNode().Read( *this, TConfigPath{} );
+            ReadRootNode();
             if ( loadFileName_ != fileName_ ) {
                 MarkForFlush();
             }
@@ -92,9 +118,13 @@ public:
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false,
-                            Crypt::TOptions CryptOptions = {} )
+                            Crypt::TOptions CryptOptions = {},
+                            TLayout Layout = TLayout::Canonical,
+                            TConfigOptions Options = {} )
     {
-        return TConfig( LoadFileName, SaveFileName, ReadOnly, CryptOptions );
+        return TConfig(
+            LoadFileName, SaveFileName, ReadOnly, CryptOptions, Layout, Options
+        );
     }
 
     ~TConfig() {
@@ -111,7 +141,7 @@ public:
 
 private:
     // -----------------------------------------------------------------------
-    // RAII wrapper that opens/closes the TMemIniFile around each operation
+    // RAII wrapper that opens/closes the document around each operation
     // -----------------------------------------------------------------------
     class IniFileRAII {
     public:
@@ -120,17 +150,33 @@ private:
         {
             Cfg.CreateIniObject( FilePath );
         }
-        ~IniFileRAII() { try { cfg_.DestroyIniObject(); } catch ( ... ) {} }
+        ~IniFileRAII() {
+            // In lazy mode the file stays loaded for on-demand loads, in
+            // retain mode for the next flush.
+            if ( !cfg_.GetLazyLoadFlag() && !cfg_.GetRetainDocumentFlag() ) {
+                try { cfg_.DestroyIniObject(); } catch ( ... ) {}
+            }
+        }
         IniFileRAII( IniFileRAII const & ) = delete;
         IniFileRAII& operator=( IniFileRAII const & ) = delete;
     private:
         TConfig& cfg_;
     };
 
-    std::unique_ptr<TMemIniFile> ini_;
+    std::optional<TDocument> document_;
     String fileName_;
     String loadFileName_;
     Crypt::TOptions cryptOptions_;
+    TLayout layout_;
+    bool preamble_ { true };            // the file has a byte order mark
+    TNodeCursor<std::string> cursor_;
+    TDocumentStamp documentStamp_;
+    // The section names of document_, read on first use and kept in step
+    // with the sections written and erased.
+    std::optional<TSectionIndex> sections_;
+    std::string name_;                  // UTF-8 conversion buffers
+    std::string key_;
+    std::string value_;
 
     static void ValidatePathComponent( String const & Component ) {
         if ( Component.Pos( _D( "\\" ) ) > 0 ||
@@ -145,77 +191,133 @@ private:
         }
     }
 
-    // Opens (and implicitly loads) the underlying TMemIniFile against the
-    // given path.  Constructors pass loadFileName_; DoFlush passes
-    // fileName_ — TMemIniFile::UpdateFile writes back to its construction
-    // path, so this is how the load/save split is realised.
+    // Opens (and loads) the document from the given path, empty when there
+    // is no file.  Constructors pass loadFileName_; DoFlush passes
+    // fileName_, so that a flush rewrites the destination's own text —
+    // this is how the load/save split is realised.  In retain mode the
+    // document left by the last load or flush is reused while it was
+    // opened against FilePath and the file is as it was then.
     void CreateIniObject( String FilePath ) {
-        // Specify UTF-8 so that Unicode strings survive the disk roundtrip.
-        if ( cryptOptions_.Enabled ) {
-            ini_ = std::make_unique<TMemIniFile>( String{}, TEncoding::UTF8 );
-            if ( TFile::Exists( FilePath ) ) {
-                auto SL = std::make_unique<TStringList>();
-                SL->Text = Crypt::LoadText( FilePath, TEncoding::UTF8, cryptOptions_ );
-                ini_->SetStrings( SL.get() );
-            }
+        if ( document_ && documentStamp_.Matches( FilePath ) ) {
+            return;
+        }
+        sections_.reset();
+        document_.reset();
+        if ( GetRetainDocumentFlag() ) {
+            documentStamp_.Take( FilePath );
+        }
+        if ( !TFile::Exists( FilePath ) ) {
+            preamble_ = true;
+            document_.emplace( std::string{}, layout_ );
+        }
+        else if ( cryptOptions_.Enabled ) {
+            // The plain text is written without a byte order mark; one in
+            // it is not skipped, as it was not by Crypt::LoadText.
+            auto const Bytes = Crypt::LoadBytes( FilePath, cryptOptions_ );
+            document_.emplace( std::string( Bytes.begin(), Bytes.end() ), layout_ );
         }
         else {
-            ini_ = std::make_unique<TMemIniFile>( FilePath, TEncoding::UTF8 );
+            document_.emplace( ReadText( FilePath, preamble_ ), layout_ );
         }
     }
 
     void DestroyIniObject() {
-        ini_.reset();
+        sections_.reset();
+        document_.reset();
     }
 
-    // -----------------------------------------------------------------------
-    // Section / key encoding helpers
-    // -----------------------------------------------------------------------
-
-    // Build the INI section name from a TConfigPath.
-    // {}           -> "config"
-    // {"A","B"}    -> "config\A\B"
-    String GetSectionName( TConfigPath const & Path ) const {
-        String Result( _D("config") );
-        for ( auto const & Component : Path ) {
-            ValidatePathComponent( Component );
-            Result += _D("\\");
-            Result += Component;
+    // The UTF-8 text of file FilePath, without its byte order mark;
+    // Preamble tells whether it had one.
+    static std::string ReadText( String const & FilePath, bool& Preamble ) {
+        auto Stream = std::make_unique<TFileStream>(
+            FilePath, fmOpenRead | fmShareDenyWrite
+        );
+        std::string Text( static_cast<std::size_t>( Stream->Size ), '\0' );
+        if ( !Text.empty() ) {
+            Stream->ReadBuffer( &Text[0], static_cast<NativeInt>( Text.size() ) );
         }
-        return Result;
+        Preamble = Text.compare( 0, Utf8Preamble.size(), Utf8Preamble ) == 0;
+        if ( Preamble ) {
+            Text.erase( 0, Utf8Preamble.size() );
+        }
+        return Text;
     }
 
-    // Encode a value key as  "Name::(TypeTag)"
-    static String EncodeKey( String const & Name, String const & Tag ) {
-        return Name + _D("::(") + Tag + _D(")");
-    }
+    // TBufferedSink output to a file stream.
+    struct TFileWriter {
+        TStream& Stream;
 
-    // Find the 1-based position of the first ':' in the LAST "::(" pattern
-    // in Key, searching from the right.  Returns 0 if not found.
-    static int FindTypeSepPos( String const & Key ) {
-        for ( int i = Key.Length() - 2; i >= 1; --i ) {
-            if ( Key[i] == _D(':') && Key[i + 1] == _D(':') && Key[i + 2] == _D('(') ) {
-                return i;
-            }
+        void Write( char const * Data, std::size_t Length ) {
+            Stream.WriteBuffer( Data, static_cast<NativeInt>( Length ) );
+        }
+    };
+
+    static String FromUtf8( std::string_view Text ) {
+        auto const Length = static_cast<int>( Text.size() );
+        if ( std::all_of(
+                Text.begin(), Text.end(),
+                []( char Ch ){ return static_cast<unsigned char>( Ch ) < 0x80; }
+             ) )
+        {
+            String Result;
+            Result.SetLength( Length );
+            std::copy( Text.begin(), Text.end(), Result.c_str() );
+            return Result;
         }
-        return 0;
+        return UTF8ToString( RawByteString( Text.data(), Length ) );
     }
 
-    // Decode "Name::(TypeTag)" → Name and Tag strings.
-    // Returns false when no valid type suffix is found.
-    static bool DecodeKey( String const & Key, String & Name, String & Tag ) {
-        if ( Key.IsEmpty() || Key[Key.Length()] != _D(')') ) {
-            return false;
+    static void AppendUtf8( std::string& Out, String const & Text ) {
+        auto const First = Text.c_str();
+        auto const Last = First + Text.Length();
+        if ( std::all_of( First, Last, []( WideChar Ch ){ return Ch < 0x80; } ) ) {
+            std::transform(
+                First, Last, std::back_inserter( Out ),
+                []( WideChar Ch ){ return static_cast<char>( Ch ); }
+            );
         }
-        int const SepPos = FindTypeSepPos( Key );
-        if ( SepPos == 0 ) {
-            return false;
+        else {
+            auto const Utf8 = UTF8Encode( Text );
+            Out.append( Utf8.c_str(), Utf8.Length() );
+        }
+    }
+
+    TSectionIndex& GetSections() {
+        if ( !sections_ ) {
+            sections_.emplace( "config" );
+            document_->ForEachSection(
+                [this]( std::string_view Section ) { sections_->Add( Section ); }
+            );
         }
-        Name = Key.SubString( 1, SepPos - 1 );
-        Tag  = Key.SubString( SepPos + 3, Key.Length() - SepPos - 3 );
-        return !Name.IsEmpty() && !Tag.IsEmpty();
+        return *sections_;
+    }
+
+    // -----------------------------------------------------------------------
+    // Section / key encoding helpers
+    // -----------------------------------------------------------------------
+
+    // Build the (UTF-8) INI section name from a TConfigPath.
+    // {}           -> "config"
+    // {"A","B"}    -> "config\A\B"
+    // During a traversal the name of the parent section is kept by the
+    // node cursor, so each level appends one component.
+    std::string GetSectionName( TConfigPath const & Path ) {
+        std::string Result( "config" );
+        cursor_.Resolve(
+            Result, Path,
+            []( std::string& Section, String const & Component ) {
+                ValidatePathComponent( Component );
+                Section += '\\';
+                AppendUtf8( Section, Component );
+                return true;
+            }
+        );
+        return Result;
     }
 
+    // Keys are encoded as "Name::(TypeTag)" by INIFile::EncodeKey and
+    // decoded by INIFile::DecodeKey (CfgIniDocument.h).
+
     // -----------------------------------------------------------------------
     // StringCont codec  (items joined by '|', with '\' and '|' escaped)
     // -----------------------------------------------------------------------
@@ -266,181 +368,35 @@ private:
     }
 
     // -----------------------------------------------------------------------
-    // Visitor helpers (same pattern as CfgXML.h)
+    // Value codec: the shared text form, plus the StringCont layout above
     // -----------------------------------------------------------------------
+    struct TValueCodec : Codec::TTextCodec {
+        using TTextCodec::Encode;
+        using TTextCodec::Decode;
 
-    template<class...>
-    static constexpr bool always_false_v = false;
+        static String Encode( Codec::TAs<StringCont>, StringCont const & Val ) {
+            return EncodeStringCont( Val );
+        }
 
-    template<class... Ts>
-    struct overload : Ts...
-    {
-        using Ts::operator()...;
-        template<typename T>
-        constexpr void operator()( T ) const {
-            static_assert( always_false_v<T>, "Unsupported type" );
+        static StringCont Decode( Codec::TAs<StringCont>, String const & Val ) {
+            return DecodeStringCont( Val );
         }
     };
 
-    template<class... Ts>
-    overload( Ts... ) -> overload<Ts...>;
-
-    // Return the type-tag string for a variant value (used when erasing keys).
-    static String GetTagStr( TConfigNodeValueType const & Val ) {
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        return std::visit(
-#else
-        return boost::apply_visitor(
-#endif
-            overload {
-                []( int                          ) -> String { return String( ana_cnv_xstr( ANA_TT_I    ) ); },
-                []( unsigned int                 ) -> String { return String( ana_cnv_xstr( ANA_TT_U    ) ); },
-                []( long                         ) -> String { return String( ana_cnv_xstr( ANA_TT_L    ) ); },
-                []( unsigned long                ) -> String { return String( ana_cnv_xstr( ANA_TT_UL   ) ); },
-                []( char                         ) -> String { return String( ana_cnv_xstr( ANA_TT_C    ) ); },
-                []( unsigned char                ) -> String { return String( ana_cnv_xstr( ANA_TT_UC   ) ); },
-                []( short                        ) -> String { return String( ana_cnv_xstr( ANA_TT_S    ) ); },
-                []( unsigned short               ) -> String { return String( ana_cnv_xstr( ANA_TT_US   ) ); },
-                []( long long                    ) -> String { return String( ana_cnv_xstr( ANA_TT_LL   ) ); },
-                []( unsigned long long           ) -> String { return String( ana_cnv_xstr( ANA_TT_ULL  ) ); },
-                []( bool                         ) -> String { return String( ana_cnv_xstr( ANA_TT_B    ) ); },
-                []( System::UnicodeString const& ) -> String { return String( ana_cnv_xstr( ANA_TT_SZ   ) ); },
-                []( System::TDateTime            ) -> String { return String( ana_cnv_xstr( ANA_TT_DT   ) ); },
-                []( float                        ) -> String { return String( ana_cnv_xstr( ANA_TT_FLT  ) ); },
-                []( double                       ) -> String { return String( ana_cnv_xstr( ANA_TT_DBL  ) ); },
-                []( System::Currency             ) -> String { return String( ana_cnv_xstr( ANA_TT_CUR  ) ); },
-                []( StringCont const&            ) -> String { return String( ana_cnv_xstr( ANA_TT_SV   ) ); },
-                []( TBytes                       ) -> String { return String( ana_cnv_xstr( ANA_TT_DAB  ) ); },
-                []( std::vector<Byte> const&     ) -> String { return String( ana_cnv_xstr( ANA_TT_VB   ) ); },
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                []( std::string const&           ) -> String { return String( ana_cnv_xstr( ANA_TT_STR  ) ); },
-                []( std::wstring const&          ) -> String { return String( ana_cnv_xstr( ANA_TT_WSTR ) ); },
-#endif
-            },
-            Val
-        );
-    }
-
     // -----------------------------------------------------------------------
     // Write a single key=value pair into the INI section
     // -----------------------------------------------------------------------
-    void SaveValue( String const & Section, ValueContType::value_type const & v ) {
-        auto const Key = EncodeKey( v.first, GetTagStr( v.second.first ) );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::visit(
-#else
-        boost::apply_visitor(
-#endif
-            overload {
-                [&]( int Val ) {
-                    ini_->WriteString( Section, Key, IntToStr( Val ) );
-                },
-                [&]( unsigned int Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<__int64>( Val ) ) );
-                },
-                [&]( long Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<__int64>( Val ) ) );
-                },
-                [&]( unsigned long Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<__int64>( Val ) ) );
-                },
-                [&]( char Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<int>( Val ) ) );
-                },
-                [&]( unsigned char Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<int>( Val ) ) );
-                },
-                [&]( short Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<int>( Val ) ) );
-                },
-                [&]( unsigned short Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<int>( Val ) ) );
-                },
-                [&]( long long Val ) {
-                    ini_->WriteString( Section, Key,
-                        IntToStr( static_cast<__int64>( Val ) ) );
-                },
-                [&]( unsigned long long Val ) {
-                    ini_->WriteString( Section, Key,
-#if defined( _UNICODE )
-                        String( std::to_wstring( Val ).c_str() )
-#else
-                        String( std::to_string( Val ).c_str() )
-#endif
-                    );
-                },
-                [&]( bool Val ) {
-                    ini_->WriteString( Section, Key, BoolToStr( Val, true ) );
-                },
-                [&]( System::UnicodeString Val ) {
-                    ini_->WriteString( Section, Key, Val );
-                },
-                [&]( System::TDateTime Val ) {
-                    ini_->WriteString( Section, Key, DateToISO8601( Val, false ) );
-                },
-                [&]( float Val ) {
-                    TFormatSettings FS;
-                    FS.DecimalSeparator = _D( '.' );
-                    ini_->WriteString( Section, Key,
-                        FloatToStrF(
-                            static_cast<double>( Val ),
-                            TFloatFormat::ffGeneral, 9, 0, FS
-                        )
-                    );
-                },
-                [&]( double Val ) {
-                    TFormatSettings FS;
-                    FS.DecimalSeparator = _D( '.' );
-                    ini_->WriteString( Section, Key,
-                        FloatToStrF( Val, TFloatFormat::ffGeneral, 17, 0, FS )
-                    );
-                },
-                [&]( System::Currency Val ) {
-                    TFormatSettings FS;
-                    FS.DecimalSeparator = _D( '.' );
-                    ini_->WriteString( Section, Key, CurrToStr( Val, FS ) );
-                },
-                [&]( StringCont const & Val ) {
-                    ini_->WriteString( Section, Key, EncodeStringCont( Val ) );
-                },
-                [&]( TBytes Val ) {
-                    ini_->WriteString( Section, Key,
-                        Val.Length == 0 ?
-                            String{}
-                        :
-                            TNetEncoding::Base64->EncodeBytesToString(
-                                &Val[0], Val.High
-                            )
-                    );
-                },
-                [&]( std::vector<Byte> const & Val ) {
-                    ini_->WriteString( Section, Key,
-                        Val.empty() ?
-                            String{}
-                        :
-                            TNetEncoding::Base64->EncodeBytesToString(
-                                Val.data(), Val.size() - 1
-                            )
-                    );
-                },
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                [&]( std::string const & Val ) {
-                    ini_->WriteString( Section, Key, UTF8ToString( Val.c_str() ) );
-                },
-                [&]( std::wstring const & Val ) {
-                    ini_->WriteString( Section, Key, String( Val.c_str() ) );
-                },
-#endif
-            },
-            v.second.first
-        );
+    void SaveValue( std::string_view Section, ValueContType::value_type const & v ) {
+        auto const & Val = v.second.first;
+        value_.clear();
+        AppendUtf8( value_, Codec::Encode( Val, TValueCodec{} ) );
+        document_->WriteString( Section, GetKey( v.first, Val ), value_ );
+    }
+
+    std::string const & GetKey( String const & Name, TConfigNodeValueType const & Val ) {
+        name_.clear();
+        AppendUtf8( name_, Name );
+        return EncodeKey( key_, name_, Codec::TagName( Val ) );
     }
 
 protected:
@@ -448,135 +404,29 @@ protected:
     // DoCreateValueList – read all typed key=value pairs for the given path
     // -----------------------------------------------------------------------
     virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
-        using Fn = std::function<TConfigNodeValueType( String )>;
-
-        static std::array<Fn,
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::variant_size<TConfigNodeValueType>::value
-#else
-            TConfigNodeValueType::types::size::value
-#endif
-        > Builders {
-            // TT_I
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stoi( Value.c_str() );
-            },
-            // TT_U
-            []( String Value ) -> TConfigNodeValueType {
-                return static_cast<unsigned>( std::stoul( Value.c_str() ) );
-            },
-            // TT_L
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stol( Value.c_str() );
-            },
-            // TT_UL
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stoul( Value.c_str() );
-            },
-            // TT_C
-            []( String Value ) -> TConfigNodeValueType {
-                return static_cast<char>( std::stoi( Value.c_str() ) );
-            },
-            // TT_UC
-            []( String Value ) -> TConfigNodeValueType {
-                return static_cast<unsigned char>( std::stoul( Value.c_str() ) );
-            },
-            // TT_S
-            []( String Value ) -> TConfigNodeValueType {
-                return static_cast<short>( std::stoi( Value.c_str() ) );
-            },
-            // TT_US
-            []( String Value ) -> TConfigNodeValueType {
-                return static_cast<unsigned short>( std::stoul( Value.c_str() ) );
-            },
-            // TT_LL
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stoll( Value.c_str() );
-            },
-            // TT_ULL
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stoull( Value.c_str() );
-            },
-            // TT_B
-            []( String Value ) -> TConfigNodeValueType {
-                return StrToBool( Value );
-            },
-            // TT_SZ
-            []( String Value ) -> TConfigNodeValueType {
-                return Value;
-            },
-            // TT_DT
-            []( String Value ) -> TConfigNodeValueType {
-                return ISO8601ToDate( Value, false );
-            },
-            // TT_FLT
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stof( Value.c_str() );
-            },
-            // TT_DBL
-            []( String Value ) -> TConfigNodeValueType {
-                return std::stod( Value.c_str() );
-            },
-            // TT_CUR
-            []( String Value ) -> TConfigNodeValueType {
-                TFormatSettings FS;
-                FS.DecimalSeparator = _D( '.' );
-                return StrToCurr( Value, FS );
-            },
-            // TT_SV
-            []( String Value ) -> TConfigNodeValueType {
-                return TConfig::DecodeStringCont( Value );
-            },
-            // TT_DAB
-            []( String Value ) -> TConfigNodeValueType {
-                return TNetEncoding::Base64->DecodeStringToBytes( Value );
-            },
-            // TT_VB
-            []( String Value ) -> TConfigNodeValueType {
-                auto Bytes = TNetEncoding::Base64->DecodeStringToBytes( Value );
-                std::vector<Byte> VBytes;
-                VBytes.reserve( Bytes.Length );
-                std::copy(
-                    std::begin( Bytes ), std::end( Bytes ),
-                    std::back_inserter( VBytes )
-                );
-                return VBytes;
-            },
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            // TT_STR  (UTF-8 std::string)  — bcc64x only
-            []( String Value ) -> TConfigNodeValueType {
-                return std::string( UTF8Encode( Value ).c_str() );
-            },
-            // TT_WSTR (UTF-16 std::wstring) — bcc64x only
-            []( String Value ) -> TConfigNodeValueType {
-                return std::wstring( Value.c_str() );
-            },
-#endif
-        };
-
-        ValueContType Values;
-        auto const Section = GetSectionName( Path );
-        auto SL = std::make_unique<TStringList>();
-        ini_->ReadSection( Section, SL.get() );
-        for ( int i = 0; i < SL->Count; ++i ) {
-            String const & Key = SL->Strings[i];
-            String Name, Tag;
-            if ( DecodeKey( Key, Name, Tag ) ) {
-                if ( auto const TypeOpt = GetTypeTag( Tag ) ) {
-                    String const Val = ini_->ReadString( Section, Key, String{} );
-                    PutItemTo(
-                        Values, Name,
-                        {
-                            Builders[static_cast<size_t>( TypeOpt.value() )]( Val ),
-                            Operation::None
-                        }
-                    );
+        auto Values = NewValueList();
+        document_->ForEachValue(
+            GetSectionName( Path ),
+            [&]( std::string_view Key, std::string_view Val ) {
+                std::string_view Name, Tag;
+                if ( DecodeKey( Key, Name, Tag ) ) {
+                    if ( auto const TypeOpt = FindTypeTag( Tag.data(), Tag.size() ) ) {
+                        PutItemTo(
+                            Values, FromUtf8( Name ),
+                            {
+                                Codec::Decode(
+                                    TypeOpt.value(), TValueCodec{}, FromUtf8( Val )
+                                ),
+                                Operation::None
+                            }
+                        );
+                    }
                 }
+                // Keys without a recognised ::(TypeTag) suffix are silently
+                // ignored; they may have been placed there manually and are
+                // not managed by Anafestica.
             }
-            // Keys without a recognised ::(TypeTag) suffix are silently ignored;
-            // they may have been placed there manually and are not managed by
-            // Anafestica.
-        }
+        );
         return Values;
     }
 
@@ -584,34 +434,15 @@ protected:
     // DoCreateNodeList – enumerate direct child sections for the given path
     // -----------------------------------------------------------------------
     virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
-        NodeContType Nodes;
-        auto const Section = GetSectionName( Path );
-        auto const Prefix  = Section + _D("\\");
-        auto SL = std::make_unique<TStringList>();
-        ini_->ReadSections( SL.get() );
-        for ( int i = 0; i < SL->Count; ++i ) {
-            String const & S = SL->Strings[i];
-            if ( S.Length() > Prefix.Length() &&
-                 S.SubString( 1, Prefix.Length() ) == Prefix )
-            {
-                String const Remainder = S.SubString(
-                    Prefix.Length() + 1,
-                    S.Length() - Prefix.Length()
-                );
-                // Extract the first path component (before any '\').
-                // This handles both direct children ("Child") and deeper
-                // sections ("Child\GrandChild") whose intermediate ancestor
-                // sections may not have been written (e.g. when Child has
-                // no values of its own).
-                int const Sep = Remainder.Pos( _D("\\") );
-                String const DirectChild =
-                    Sep > 0 ? Remainder.SubString( 1, Sep - 1 ) : Remainder;
-                if ( !DirectChild.IsEmpty() &&
-                     Nodes.find( DirectChild ) == std::end( Nodes ) ) {
-                    Nodes[DirectChild] = std::make_unique<TConfigNode>();
-                }
-            }
-        }
+        auto Nodes = NewNodeList();
+        // The first component below the section of every section under it.
+        // This covers both direct children ("Child") and deeper sections
+        // ("Child\GrandChild") whose intermediate ancestor sections may not
+        // have been written (e.g. when Child has no values of its own).
+        GetSections().ForEachChild(
+            GetSectionName( Path ),
+            [&]( std::string_view Child ) { Nodes[FromUtf8( Child )] = NewNode(); }
+        );
         return Nodes;
     }
 
@@ -621,18 +452,20 @@ protected:
     virtual void DoSaveValueList( TConfigPath const & Path,
                                   ValueContType const & Values ) override {
         auto const Section = GetSectionName( Path );
+        bool Written {};
         for ( auto const & v : Values ) {
             auto const ValueState = v.second.second;
             if ( GetAlwaysFlushNodeFlag() || ValueState == Operation::Write ) {
                 SaveValue( Section, v );
+                Written = true;
             }
             else if ( ValueState == Operation::Erase ) {
-                ini_->DeleteKey(
-                    Section,
-                    EncodeKey( v.first, GetTagStr( v.second.first ) )
-                );
+                document_->DeleteKey( Section, GetKey( v.first, v.second.first ) );
             }
         }
+        if ( Written && sections_ ) {
+            sections_->Add( Section );
+        }
     }
 
     // -----------------------------------------------------------------------
@@ -640,26 +473,36 @@ protected:
     // -----------------------------------------------------------------------
     virtual void DoDeleteNode( TConfigPath const & Path ) override {
         auto const Section = GetSectionName( Path );
-        ini_->EraseSection( Section );
+        document_->EraseSection( Section );
         // Also erase all descendants (subsections whose name starts with
         // "Section\").
-        auto const Prefix = Section + _D("\\");
-        auto SL = std::make_unique<TStringList>();
-        ini_->ReadSections( SL.get() );
-        for ( int i = 0; i < SL->Count; ++i ) {
-            if ( SL->Strings[i].SubString( 1, Prefix.Length() ) == Prefix ) {
-                ini_->EraseSection( SL->Strings[i] );
+        GetSections().Erase(
+            Section,
+            [this]( std::string_view Descendant ) {
+                document_->EraseSection( Descendant );
             }
-        }
+        );
+    }
+
+    virtual void DoBeginLazyRead() override {
+        if ( !document_ ) { CreateIniObject( loadFileName_ ); }
+    }
+
+    virtual void DoEnterNode( String const & Name ) override {
+        cursor_.Enter( Name );
     }
 
+    virtual void DoLeaveNode() noexcept override { cursor_.Leave(); }
+
     // -----------------------------------------------------------------------
     // DoFlush – write the in-memory tree back to the INI file
     // -----------------------------------------------------------------------
     virtual void DoFlush() override {
-        // Open the TMemIniFile against fileName_ so that UpdateFile writes
-        // to the destination, regardless of where the initial load came from.
+        // Open the document against fileName_ so that the flush rewrites the
+        // destination, regardless of where the initial load came from.
         IniFileRAII Ini{ *this, fileName_ };
+        // Until it is saved, the document no longer mirrors the file.
+        documentStamp_.Reset();
         GetRootNode().Write( *this, TConfigPath{} );
 
         if ( !TFile::Exists( fileName_ ) ) {
@@ -669,13 +512,50 @@ protected:
                 TDirectory::CreateDirectory( DirPath );
             }
         }
+        if ( layout_ == TLayout::Preserve ) {
+            FlushPatched();
+        }
+        else if ( cryptOptions_.Enabled ) {
+            Crypt::Bytes Text;
+            TMemorySink<Crypt::Bytes> Sink{ Text };
+            document_->WriteTo( Sink );
+            Crypt::SaveBytes( fileName_, Text, cryptOptions_ );
+        }
+        else {
+            auto Stream = std::make_unique<TFileStream>( fileName_, fmCreate );
+            TFileWriter Out{ *Stream };
+            TBufferedSink<TFileWriter> Sink{ Out };
+            Sink.Append( Utf8Preamble.data(), Utf8Preamble.size() );
+            document_->WriteTo( Sink );
+            Sink.Flush();
+        }
+        if ( GetRetainDocumentFlag() ) {
+            documentStamp_.Take( fileName_ );
+        }
+    }
+
+    // Writes the text of the document with its changes patched in, in a
+    // single call.  In retain mode the document is then parsed again from
+    // that text, as the changes are recorded against the text it had.
+    void FlushPatched() {
+        auto const Preamble =
+            preamble_ && !cryptOptions_.Enabled ? Utf8Preamble.size() : 0;
+        std::string Text( Utf8Preamble.substr( 0, Preamble ) );
+        TMemorySink<> Sink{ Text };
+        document_->WriteTo( Sink );
         if ( cryptOptions_.Enabled ) {
-            auto SL = std::make_unique<TStringList>();
-            ini_->GetStrings( SL.get() );
-            Crypt::SaveText( fileName_, SL->Text, TEncoding::UTF8, cryptOptions_ );
+            Crypt::SaveBytes(
+                fileName_, Crypt::Bytes( Text.begin(), Text.end() ), cryptOptions_
+            );
         }
         else {
-            ini_->UpdateFile();
+            auto Stream = std::make_unique<TFileStream>( fileName_, fmCreate );
+            Stream->WriteBuffer( Text.data(), static_cast<NativeInt>( Text.size() ) );
+        }
+        if ( GetRetainDocumentFlag() ) {
+            Text.erase( 0, Preamble );
+            sections_.reset();
+            document_.emplace( std::move( Text ), layout_ );
         }
     }
 };
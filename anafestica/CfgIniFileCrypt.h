@@ -15,21 +15,33 @@ class TConfig : public INIFile::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false,
              bool FlushAllItems = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
-        : INIFile::TConfig( FileName, ReadOnly, FlushAllItems, Options )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             INIFile::TLayout Layout = INIFile::TLayout::Canonical,
+             TConfigOptions CfgOptions = {} )
+        : INIFile::TConfig(
+            FileName, ReadOnly, FlushAllItems, Options, Layout, CfgOptions
+          )
     {}
 
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
-        : INIFile::TConfig( LoadFileName, SaveFileName, ReadOnly, Options )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             INIFile::TLayout Layout = INIFile::TLayout::Canonical,
+             TConfigOptions CfgOptions = {} )
+        : INIFile::TConfig(
+            LoadFileName, SaveFileName, ReadOnly, Options, Layout, CfgOptions
+          )
     {}
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false,
-                            Crypt::TOptions Options = Crypt::TOptions::Default() )
+                            Crypt::TOptions Options = Crypt::TOptions::Default(),
+                            INIFile::TLayout Layout = INIFile::TLayout::Canonical,
+                            TConfigOptions CfgOptions = {} )
     {
-        return TConfig( LoadFileName, SaveFileName, ReadOnly, Options );
+        return TConfig(
+            LoadFileName, SaveFileName, ReadOnly, Options, Layout, CfgOptions
+        );
     }
 };
 
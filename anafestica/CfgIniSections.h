@@ -0,0 +1,186 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgIniSectionsH
+#define CfgIniSectionsH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_ini_sections.cpp).
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace INIFile {
+//---------------------------------------------------------------------------
+
+/// The (UTF-8) section names of an INI file under its root section, as a
+/// tree of their '\'-separated components: @c "config\A\B" is the node
+/// @c B of the node @c A of the root @c "config".
+///
+/// It answers what INIFile::TConfig used to find by scanning every section
+/// name for a prefix, with the same case-sensitive comparison: the
+/// children of a section and the sections below it.  A node is kept while
+/// a section exists at it or below it, so the children of a section are
+/// exactly the first components after its name that some section has
+/// (empty components aside, which no node can be named).  Names outside
+/// the root are ignored.
+class TSectionIndex {
+public:
+    explicit TSectionIndex( std::string_view Root ) : rootName_{ Root } {}
+
+    TSectionIndex( TSectionIndex const & ) = delete;
+    TSectionIndex& operator=( TSectionIndex const & ) = delete;
+    TSectionIndex( TSectionIndex&& ) = default;
+    TSectionIndex& operator=( TSectionIndex&& ) = default;
+
+    /// Records that section @p Section exists.
+    void Add( std::string_view Section ) {
+        if ( !Split( Section ) ) {
+            return;
+        }
+        auto Node = &root_;
+        for ( auto Component : components_ ) {
+            auto It = Node->Children.find( Component );
+            if ( It == Node->Children.end() ) {
+                It = Node->Children.emplace(
+                    std::string( Component ), std::make_unique<TNode>()
+                ).first;
+            }
+            Node = It->second.get();
+        }
+        Node->Exists = true;
+    }
+
+    /// @c true when section @p Section exists.
+    [[nodiscard]] bool Contains( std::string_view Section ) {
+        auto const Node = Find( Section );
+        return Node && Node->Exists;
+    }
+
+    /// Calls @p Fn with the name of each child of @p Section: the
+    /// component after @c Section\ of the sections below it.
+    template<typename F>
+    void ForEachChild( std::string_view Section, F&& Fn ) {
+        if ( auto const Node = Find( Section ) ) {
+            for ( auto const & Child : Node->Children ) {
+                if ( !Child.first.empty() ) {
+                    Fn( std::string_view( Child.first ) );
+                }
+            }
+        }
+    }
+
+    /// Forgets @p Section and every section below it, calling @p Fn with
+    /// the full name of each of the latter (not with @p Section itself).
+    template<typename F>
+    void Erase( std::string_view Section, F&& Fn ) {
+        if ( !Split( Section ) ) {
+            return;
+        }
+        std::vector<std::pair<TNode*,TNode::TChildren::iterator>> Path;
+        Path.reserve( components_.size() );
+        auto Node = &root_;
+        for ( auto Component : components_ ) {
+            auto const It = Node->Children.find( Component );
+            if ( It == Node->Children.end() ) {
+                return;
+            }
+            Path.emplace_back( Node, It );
+            Node = It->second.get();
+        }
+        std::string Name( Section );
+        Visit( *Node, Name, Fn );
+        Node->Children.clear();
+        Node->Exists = false;
+        // Drop the nodes left without a section at or below them.
+        while ( !Path.empty() ) {
+            auto const [Parent, It] = Path.back();
+            if ( It->second->Exists || !It->second->Children.empty() ) {
+                break;
+            }
+            Parent->Children.erase( It );
+            Path.pop_back();
+        }
+    }
+private:
+    struct TNode {
+        using TChildren = std::map<std::string,std::unique_ptr<TNode>,std::less<>>;
+
+        TChildren Children;
+        bool Exists {};
+    };
+
+    std::string rootName_;
+    TNode root_;
+    std::vector<std::string_view> components_;
+
+    // Fills components_ with the components of Section after the root;
+    // false when Section is not the root or below it.
+    bool Split( std::string_view Section ) {
+        components_.clear();
+        if ( Section.substr( 0, rootName_.size() ) != rootName_ ) {
+            return false;
+        }
+        Section.remove_prefix( rootName_.size() );
+        if ( Section.empty() ) {
+            return true;
+        }
+        if ( Section.front() != '\\' ) {
+            return false;
+        }
+        for ( ;; ) {
+            Section.remove_prefix( 1 );
+            auto const Sep = Section.find( '\\' );
+            components_.push_back( Section.substr( 0, Sep ) );
+            if ( Sep == std::string_view::npos ) {
+                return true;
+            }
+            Section.remove_prefix( Sep );
+        }
+    }
+
+    TNode* Find( std::string_view Section ) {
+        if ( !Split( Section ) ) {
+            return nullptr;
+        }
+        auto Node = &root_;
+        for ( auto Component : components_ ) {
+            auto const It = Node->Children.find( Component );
+            if ( It == Node->Children.end() ) {
+                return nullptr;
+            }
+            Node = It->second.get();
+        }
+        return Node;
+    }
+
+    template<typename F>
+    static void Visit( TNode const & Node, std::string& Name, F& Fn ) {
+        for ( auto const & Child : Node.Children ) {
+            auto const Length = Name.size();
+            Name += '\\';
+            Name += Child.first;
+            if ( Child.second->Exists ) {
+                Fn( std::string_view( Name ) );
+            }
+            Visit( *Child.second, Name, Fn );
+            Name.resize( Length );
+        }
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace INIFile
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
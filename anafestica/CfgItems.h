@@ -18,29 +18,136 @@
 
 #include <anafestica/CfgConts.h>
 
+#include <cstdint>
+
 //---------------------------------------------------------------------------
 namespace Anafestica {
 //---------------------------------------------------------------------------
 
 using TConfigPath = std::vector<String>;
 
+class TConfigNode;
+
+/// Source of on-demand loads for nodes read with @ref TConfigNode::ReadLazy.
+///
+/// A node read lazily keeps a pointer to its loader until it is first
+/// accessed; @c LoadNode is then asked to populate it (values, child names
+/// and, down to @p Levels further levels, the children themselves).
+/// @c Anafestica::TConfig implements it for every backend.
+class TConfigNodeLoader {
+public:
+    virtual void LoadNode( TConfigNode& Node, TConfigPath const & Path,
+                           std::size_t Levels ) = 0;
+protected:
+    ~TConfigNodeLoader() = default;
+};
+
+namespace Detail {
+
+// True when S implements the optional node cursor (EnterNode / LeaveNode,
+// see Anafestica::TConfig); the mock readers and writers of the tests
+// do not.
+template<typename S, typename = void>
+struct THasNodeCursor : std::false_type {};
+
+template<typename S>
+struct THasNodeCursor<
+    S,
+    std::void_t<
+        decltype( std::declval<S&>().EnterNode( std::declval<String const &>() ) ),
+        decltype( std::declval<S&>().LeaveNode() )
+    >
+> : std::true_type {};
+
+// Descends into child Name for the lifetime of the scope: appends it to
+// Path and, when S has one, enters it with the storage cursor.
+template<typename S>
+class TChildScope {
+public:
+    TChildScope( S& Storage, TConfigPath& Path, String const & Name )
+      : storage_{ Storage }, path_{ Path }
+    {
+        path_.push_back( Name );
+        if constexpr ( THasNodeCursor<S>::value ) {
+            try {
+                storage_.EnterNode( Name );
+            }
+            catch ( ... ) {
+                path_.pop_back();
+                throw;
+            }
+        }
+    }
+
+    ~TChildScope() {
+        if constexpr ( THasNodeCursor<S>::value ) {
+            storage_.LeaveNode();
+        }
+        path_.pop_back();
+    }
+
+    TChildScope( TChildScope const & ) = delete;
+    TChildScope& operator=( TChildScope const & ) = delete;
+private:
+    S& storage_;
+    TConfigPath& path_;
+};
+
+} // End of namespace Detail
+
+/// Creates an empty node in @p Arena (on the heap when @p Arena is null).
+/// Children created through @ref TConfigNode::GetSubNode live in the same
+/// arena as their parent.
+[[nodiscard]] TConfigNodePtr MakeConfigNode( TConfigArena* Arena );
+
 /// In-memory hierarchical node that stores typed configuration values.
 ///
 /// Mirrors a registry key (or an XML/JSON/INI section): it owns a map of
 /// named values (@ref ValueContType) and a map of named child nodes
 /// (@ref NodeContType).  Values are stored as @ref TConfigNodeValueType
-/// variants; the variant alternative is chosen at write time and checked
-/// at read time via @c std::get_if / @c boost::get.
+/// cells; the alternative is chosen at write time and checked at read
+/// time via @ref GetIfValue.
 ///
 /// @par Type dispatch
 /// @c GetItem and @c PutItem use a compile-time tag dispatch
 /// (@c is_other_tag / @c is_enum_tag) to route enum types through
-/// Delphi RTTI serialisation and all other types through the variant
+/// Delphi RTTI serialisation and all other types through the value cell
 /// directly.
 ///
+/// @par Keys
+/// Every member that takes a key accepts a @ref TKeyRef, i.e. a
+/// @c String, a @ref TKeyAtom (see @ref ANA_KEY), a @c wchar_t literal
+/// or a @c std::wstring / @c std::wstring_view.  Looking up an existing
+/// key never allocates; inserting a new one builds its @c String only
+/// when the caller did not already pass a @c String or an atom.
+///
+/// @par Change tracking
+/// Every mutation (@c PutItem, @c DeleteItem, @c Clear, inserting reads,
+/// new children) updates the node's state incrementally and propagates
+/// upwards through the parent chain, so @c IsModified and
+/// @c GetValueCount are O(1) and @c Write never rescans a subtree to
+/// decide whether to descend into it.  @c GetGeneration is a counter
+/// that advances whenever the node or any of its descendants changes.
+///
+/// @par Reading without side effects
+/// @c GetItem inserts the caller's default when a key is missing (so that
+/// a later flush can persist it).  @c FindValue, @c Find, @c TryGet and
+/// the @c Values / @c Nodes ranges are @c const: they never insert,
+/// never build a default and hand out references into the node, which
+/// stay valid until the node is next modified.
+///
+/// @par Lazy loading
+/// A node populated with @c ReadLazy reads only its own values and the
+/// names of its children; each child stays @e pending (see @c IsLoaded)
+/// until it is first returned by @c GetSubNode / @c operator[], at which
+/// point it fetches its values and the names of its own children from the
+/// loader.  @c Prefetch loads several levels in one go.  Pending subtrees
+/// are unmodified by definition and are skipped by @c Write, so storage
+/// keeps whatever it held for them.
+///
 /// @par Type-mismatch behaviour
-/// If @c GetItem<T> is called but the stored variant alternative is not
-/// @c T, the @c get_if probe returns @c nullptr, the assignment is
+/// If @c GetItem<T> is called but the stored alternative is not
+/// @c T, the @c GetIfValue probe returns @c nullptr, the assignment is
 /// skipped, and the caller receives @c T{} (the default-initialised
 /// value).  This is by design — no exception is thrown.
 class TConfigNode
@@ -69,6 +176,12 @@ public:
     static constexpr std::size_t MaxPersistenceDepth = 128;
 
     TConfigNode() = default;
+
+    /// Creates a node whose containers and children are allocated from
+    /// @p Arena.  The arena must outlive the node.
+    explicit TConfigNode( TConfigArena* Arena )
+        : arena_{ Arena }, valueItems_( Arena ), nodeItems_( Arena ) {}
+
     TConfigNode( TConfigNode const & ) = delete;
     TConfigNode& operator=( TConfigNode const & ) = delete;
 
@@ -76,35 +189,93 @@ public:
     ///
     /// If a child named @p Id does not exist yet, a new empty node is
     /// inserted and returned.  Subsequent calls with the same @p Id
-    /// return the same node.
-    TConfigNode& GetSubNode( String Id ) {
-        auto p =
-            nodeItems_.insert( NodeContType::value_type( Id, TConfigNodePtr{} ) );
-        if ( p.second ) {
-            p.first->second = std::move( std::make_unique<TConfigNode>() );
+    /// return the same node.  A pending child (see @ref ReadLazy) is
+    /// loaded before it is returned.
+    TConfigNode& GetSubNode( TKeyRef Id ) {
+        auto i = nodeItems_.lower_bound( Id );
+        if ( i == std::end( nodeItems_ ) || TKeyLess{}( Id, i->first ) ) {
+            i = nodeItems_.try_emplace(
+                    i, Id.ToString(), MakeConfigNode( arena_ )
+                ).first;
+            i->second->parent_ = this;
+            i->second->name_ = i->first;
+            BumpGeneration();
         }
-        return *p.first->second;
+        auto& Node = *i->second;
+        Node.Load( 0 );
+        return Node;
     }
 
-    TConfigNode& operator[]( String Id ) {
+    TConfigNode& operator[]( TKeyRef Id ) {
         return GetSubNode( Id );
     }
 
     template<typename R>
     void Read( R& Reader, TConfigPath const & Path );
 
+    template<typename R>
+    void ReadLazy( R& Reader, TConfigNodeLoader& Loader,
+                   TConfigPath const & Path, std::size_t Levels = 0 );
+
+    /// Prefetch hint: loads the pending nodes of this subtree down to
+    /// @p Levels levels below this node (0: this node only), so that later
+    /// accesses find them in memory.  A no-op for nodes that were read
+    /// eagerly.
+    void Prefetch( std::size_t Levels = MaxPersistenceDepth ) {
+        if ( loader_ ) {
+            Load( Levels );
+        }
+        else if ( Levels ) {
+            for ( auto& n : nodeItems_ ) { n.second->Prefetch( Levels - 1 ); }
+        }
+    }
+
+    /// @c false while the node is pending, i.e. it was discovered by a
+    /// lazy read and has not been accessed (or prefetched) yet.
+    [[nodiscard]] bool IsLoaded() const noexcept { return !loader_; }
+
     template<typename W>
     void Write( W& Writer, TConfigPath const & Path ) const;
 
+    /// Records that a @ref Write of this subtree reached storage: entries
+    /// in @c Write state go back to @c None, entries in @c Erase state are
+    /// dropped and deleted nodes become ordinary (empty) nodes, so the
+    /// subtree is no longer modified.  Only the modified part of the tree
+    /// is visited.  Called by @c Anafestica::TConfig once a flush
+    /// succeeded.
+    void CommitWrite();
+
+    /// Replaces the content of this node with @p Values and the already
+    /// built children @p Nodes, as @ref Read would have left it.  For
+    /// backends that build the tree while parsing the file instead of
+    /// answering @c CreateValueList / @c CreateNodeList calls.
+    void Populate( ValueContType Values, NodeContType Nodes );
+
+    /// Throws when a node @p Depth levels below the root could not be
+    /// persisted (see @ref MaxPersistenceDepth).
+    static void CheckPersistenceDepth( std::size_t Depth ) {
+        if ( Depth > MaxPersistenceDepth ) {
+            throw Exception(
+                Format(
+                    _D( "Configuration path depth %d exceeds the supported maximum of %d" ),
+                    ARRAYOFCONST((
+                        static_cast<int>( Depth ),
+                        static_cast<int>( MaxPersistenceDepth )
+                    ))
+                )
+            );
+        }
+    }
+
     /// Reads a value by key, writing the result into @p Val.
     ///
     /// Dispatches to @c GetItemAs with either @c is_other_tag or
     /// @c is_enum_tag depending on whether @c T is an enum type.
-    /// If the stored variant alternative does not match @c T, @p Val is
+    /// If the stored alternative does not match @c T, @p Val is
     /// left at its incoming value (typically @c T{} when called from the
     /// single-argument overload).
     template<typename T>
-    void GetItem( String Id, T& Val, Operation Op = Operation::None ) {
+    void GetItem( TKeyRef Id, T& Val, Operation Op = Operation::None ) {
         GetItemAs(
             enum_tag<type_to_enum_v<std::remove_reference_t<decltype( Val )>>>{},
             Id, Val, Op
@@ -115,47 +286,101 @@ public:
     ///
     /// Convenience overload that default-constructs @c T, calls the
     /// two-argument form, and returns the result.  Because @c Val starts
-    /// as @c T{}, a type mismatch (stored variant alternative != @c T)
+    /// as @c T{}, a type mismatch (stored alternative != @c T)
     /// produces the default value with no exception.
     template<typename T>
-    [[nodiscard]] T GetItem( String Id, Operation Op = Operation::None ) {
+    [[nodiscard]] T GetItem( TKeyRef Id, Operation Op = Operation::None ) {
         T Val {};
         GetItem( Id, Val, Op );
         return Val;
     }
 
-    void GetItem( String Id, TStrings& Val, Operation Op = Operation::None ) {
-        StringCont Strs;
-        std::copy(
-            System::begin( &Val ), System::end( &Val ),
-            std::back_inserter( Strs )
-        );
-        auto& Result = GetItemFrom( valueItems_, Id, Strs, Op );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        if ( auto* p = std::get_if<StringCont>( &Result ) ) {
-#else
-        if ( auto* p = boost::get<StringCont>( &Result ) ) {
-#endif
-            Val.Clear();
+    void GetItem( TKeyRef Id, TStrings& Val, Operation Op = Operation::None ) {
+        if ( !valueItems_.contains( Id ) ) {
+            // Miss: store the current content as the default; Val is
+            // already what a read-back would produce.
+            StringCont Strs;
+            Strs.reserve( Val.Count );
             std::copy(
-                std::begin( *p ), std::end( *p ),
-                System::back_inserter( &Val )
+                System::begin( &Val ), System::end( &Val ),
+                std::back_inserter( Strs )
             );
+            GetValue( Id, std::move( Strs ), Op );
+            return;
+        }
+        auto const & Result = GetValue( Id, StringCont{}, Op );
+        if ( auto p = GetIfValue<StringCont>( &Result ) ) {
+            AssignStrings( Val, *p );
         }
     }
 
-    void GetItem( String Id, TStrings* const Val, Operation Op = Operation::None ) {
+    void GetItem( TKeyRef Id, TStrings* const Val, Operation Op = Operation::None ) {
         GetItem( Id, *Val, Op );
     }
 
+    /// Stored value for @p Id, or @c nullptr when the key is absent or
+    /// marked for deletion.  Never inserts.
+    [[nodiscard]] ValueType const * FindValue( TKeyRef Id ) const noexcept {
+        return FindItemIn( valueItems_, Id );
+    }
+
+    /// Stored value for @p Id if it holds a @c T, otherwise @c nullptr.
+    ///
+    /// Never inserts, allocates or copies: the pointer refers to the
+    /// value inside the node.  Enums are stored as their name or as
+    /// @c int, so use @ref TryGet for them.
+    template<typename T>
+    [[nodiscard]] T const * Find( TKeyRef Id ) const noexcept {
+        static_assert(
+            !std::is_enum_v<T>, "Find cannot return an enum; use TryGet"
+        );
+        if ( auto v = FindValue( Id ) ) {
+            return GetIfValue<T>( v );
+        }
+        return nullptr;
+    }
+
+    /// Copies the value stored under @p Id into @p Val when it exists and
+    /// holds a @c T (for enums: the same encodings @c GetItem accepts).
+    /// Returns @c false, leaving @p Val untouched, otherwise.  Unlike
+    /// @c GetItem it never inserts a default.
+    template<typename T>
+    bool TryGet( TKeyRef Id, T& Val ) const {
+        return TryGetAs( enum_tag<type_to_enum_v<T>>{}, Id, Val );
+    }
+
+    bool TryGet( TKeyRef Id, TStrings& Val ) const {
+        if ( auto p = Find<StringCont>( Id ) ) {
+            AssignStrings( Val, *p );
+            return true;
+        }
+        return false;
+    }
+
+    class TValueRange;
+    class TNodeRange;
+
+    /// The values of this node (entries marked for deletion excluded),
+    /// in key order, as @c std::pair<String const&,ValueType const&>.
+    ///
+    /// @code
+    /// for ( auto [Name, Value] : Node.Values() ) { ... }
+    /// @endcode
+    [[nodiscard]] TValueRange Values() const noexcept;
+
+    /// The children of this node, in key order, as
+    /// @c std::pair<String const&,TConfigNode const&>.  Pending children
+    /// (see @ref IsLoaded) are listed but not loaded.
+    [[nodiscard]] TNodeRange Nodes() const noexcept;
+
     /// Stores a value under the given key.
     ///
-    /// The variant alternative is determined by @c T at compile time;
+    /// The stored alternative is determined by @c T at compile time;
     /// backends will encode the corresponding type tag when flushing.
     /// Enum types are routed through Delphi RTTI (stored as @c String
     /// name when RTTI is available, otherwise as @c int).
     template<typename T>
-    bool PutItem( String Id, T&& Val, Operation Op = Operation::Write ) {
+    bool PutItem( TKeyRef Id, T&& Val, Operation Op = Operation::Write ) {
         return PutItem(
             Id, std::forward<T>( Val ),
             enum_tag<type_to_enum_v<std::remove_reference_t<decltype( Val )>>>{},
@@ -163,47 +388,37 @@ public:
         );
     }
 
-    bool PutItem( String Id, TStrings& Val, Operation Op = Operation::Write ) {
+    bool PutItem( TKeyRef Id, TStrings& Val, Operation Op = Operation::Write ) {
         StringCont Strs;
         Strs.reserve( Val.Count );
         std::copy(
             System::begin( &Val ), System::end( &Val ),
             std::back_inserter( Strs )
         );
-        return PutItem( Id, Strs, Op );
+        return PutItem( Id, std::move( Strs ), Op );
     }
 
-    bool PutItem( String Id, TStrings* const Val, Operation Op = Operation::Write ) {
+    bool PutItem( TKeyRef Id, TStrings* const Val, Operation Op = Operation::Write ) {
         return PutItem( Id, *Val, Op );
     }
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
     // Convenience overloads: string_view/wstring_view are non-owning, so they
-    // are materialised to string/wstring before being stored in the variant.
-    // Only available on bcc64x: boost::variant on bcc64/bcc32c does not carry
-    // std::string or std::wstring as alternatives (Boost 1.70 mpl::list limit).
-    bool PutItem( String Id, std::string_view Val, Operation Op = Operation::Write ) {
+    // are materialised to string/wstring before being stored.
+    bool PutItem( TKeyRef Id, std::string_view Val, Operation Op = Operation::Write ) {
         return PutItem( Id, std::string( Val ), Op );
     }
 
-    bool PutItem( String Id, std::wstring_view Val, Operation Op = Operation::Write ) {
+    bool PutItem( TKeyRef Id, std::wstring_view Val, Operation Op = Operation::Write ) {
         return PutItem( Id, std::wstring( Val ), Op );
     }
-#endif
 
     [[nodiscard]] size_t GetNodeCount() const noexcept { return nodeItems_.size(); }
 
     template<typename OutputIterator>
     void EnumerateNodes( OutputIterator Output ) const;
 
-    [[nodiscard]] size_t GetValueCount() const noexcept {
-        return std::count_if(
-            std::begin( valueItems_ ), std::end( valueItems_ ),
-            []( auto const & Val ) {
-                return Val.second.second != Operation::Erase;
-            }
-        );
-    }
+    /// Number of values not marked for deletion.  O(1).
+    [[nodiscard]] size_t GetValueCount() const noexcept { return valueCount_; }
 
     template<typename OutputIterator>
     void EnumeratePairs( OutputIterator Out ) const;
@@ -214,165 +429,449 @@ public:
     template<typename OutputIterator>
     void EnumerateValues( OutputIterator Out ) const;
 
-    void DeleteItem( String Id ) noexcept {
+    void DeleteItem( TKeyRef Id ) noexcept {
         auto i = valueItems_.find( Id );
-        if ( i != std::end( valueItems_ ) ) {
+        if ( i != std::end( valueItems_ ) &&
+             i->second.second != Operation::Erase ) {
             i->second.second = Operation::Erase;
+            --valueCount_;
+            valuesModified_ = true;
+            Changed();
         }
     }
 
-    void DeleteSubNode( String Id ) {
+    void DeleteSubNode( TKeyRef Id ) {
         auto i = nodeItems_.find( Id );
         if ( i != std::end( nodeItems_ ) ) { i->second->Clear(); }
     }
 
     [[nodiscard]] bool IsDeleted() const noexcept { return deleted_; }
 
+    /// @c true when this node was deleted, holds a value in @c Write or
+    /// @c Erase state, or has a modified descendant.  O(1).
     [[nodiscard]] bool IsModified() const noexcept {
-        return IsDeleted() || ValueListModified() || NodesModified();
+        return deleted_ || valuesModified_ || nodesModified_;
     }
 
+    /// Change counter of this subtree.
+    ///
+    /// Advances whenever a value of this node or of any descendant is
+    /// inserted, changed or deleted, when a child is added, and when the
+    /// subtree is cleared or re-read.  Poll it and compare with a value
+    /// saved earlier to tell whether anything below this node changed.
+    [[nodiscard]] std::uint64_t GetGeneration() const noexcept { return generation_; }
+
     void Clear() noexcept {
-        deleted_ = true;
-        valueItems_.clear();
-        for ( auto& v : nodeItems_ ) { v.second->Clear(); }
+        ClearSubtree();
+        Changed();
     }
 
-    [[nodiscard]] bool ItemExists( String Id ) const noexcept {
+    [[nodiscard]] bool ItemExists( TKeyRef Id ) const noexcept {
         return valueItems_.find( Id ) != std::end( valueItems_ );
     }
 
-    [[nodiscard]] bool SubNodeExists( String Id ) const noexcept {
+    [[nodiscard]] bool SubNodeExists( TKeyRef Id ) const noexcept {
         return nodeItems_.find( Id ) != std::end( nodeItems_ );
     }
 
+    /// The arena this node allocates from (@c nullptr: heap).
+    [[nodiscard]] TConfigArena* GetArena() const noexcept { return arena_; }
+
 private:
+    TConfigArena* arena_ {};
+    TConfigNode* parent_ {};
+    TConfigNodeLoader* loader_ {};  // non-null while pending
+    String name_;                   // key in the parent's node list
     ValueContType valueItems_;
     NodeContType nodeItems_;
+    std::size_t valueCount_ {};     // entries not in Erase state
+    std::uint64_t generation_ {};
     bool deleted_ {};
+    bool valuesModified_ {};        // some entry in Write/Erase state
+    bool nodesModified_ {};         // some child IsModified()
 
-    static void CheckPersistencePathDepth( TConfigPath const & Path ) {
-        if ( Path.size() > MaxPersistenceDepth ) {
-            throw Exception(
-                Format(
-                    _D( "Configuration path depth %d exceeds the supported maximum of %d" ),
-                    ARRAYOFCONST((
-                        static_cast<int>( Path.size() ),
-                        static_cast<int>( MaxPersistenceDepth )
-                    ))
-                )
+    /// Advances the generation of this node and of all its ancestors.
+    void BumpGeneration() noexcept {
+        for ( auto n = this ; n ; n = n->parent_ ) { ++n->generation_; }
+    }
+
+    /// Records a change of this node: bumps the generations and, if the
+    /// node is now modified, flags the ancestors.  Modification flags are
+    /// never cleared by a mutation, so propagation stops at the first
+    /// ancestor that is already flagged.
+    void Changed() noexcept {
+        BumpGeneration();
+        if ( IsModified() ) {
+            for ( auto p = parent_ ; p && !p->nodesModified_ ; p = p->parent_ ) {
+                p->nodesModified_ = true;
+            }
+        }
+    }
+
+    /// Loads a pending node (see @ref Prefetch for @p Levels).
+    void Load( std::size_t Levels ) {
+        if ( auto Loader = loader_ ) {
+            Loader->LoadNode( *this, GetPath(), Levels );
+        }
+    }
+
+    /// Path of this node from the root of its tree.
+    TConfigPath GetPath() const {
+        std::size_t Depth {};
+        for ( auto n = this ; n->parent_ ; n = n->parent_ ) { ++Depth; }
+        TConfigPath Path( Depth );
+        for ( auto n = this ; n->parent_ ; n = n->parent_ ) {
+            Path[--Depth] = n->name_;
+        }
+        return Path;
+    }
+
+    void ClearSubtree() noexcept {
+        deleted_ = true;
+        loader_ = nullptr;
+        valueItems_.clear();
+        valueCount_ = 0;
+        valuesModified_ = false;
+        nodesModified_ = !nodeItems_.empty();
+        ++generation_;
+        for ( auto& v : nodeItems_ ) { v.second->ClearSubtree(); }
+    }
+
+    // Path is extended in place while descending (see Detail::TChildScope).
+    template<typename R>
+    void ReadSubtree( R& Reader, TConfigPath& Path,
+                      TConfigNodeLoader* Loader, std::size_t Levels );
+
+    template<typename W>
+    void WriteSubtree( W& Writer, TConfigPath& Path ) const;
+
+    /// Recomputes the cached state after the value list was replaced.
+    void RecountValues() noexcept {
+        valueCount_ = 0;
+        valuesModified_ = false;
+        for ( auto const & v : valueItems_ ) {
+            auto const Op = v.second.second;
+            if ( Op != Operation::Erase ) { ++valueCount_; }
+            if ( Op != Operation::None ) { valuesModified_ = true; }
+        }
+    }
+
+    /// Looks up @p Id, inserting @p DefVal with state @p Op on a miss
+    /// (see @ref GetItemFrom).  The value cell is only built on a miss.
+    template<typename D>
+    ValueType& GetValue( TKeyRef Id, D&& DefVal, Operation Op ) {
+        auto i = valueItems_.lower_bound( Id );
+        if ( i == std::end( valueItems_ ) || TKeyLess{}( Id, i->first ) ) {
+            i = valueItems_.try_emplace(
+                    i, Id.ToString(),
+                    ValueType( std::forward<D>( DefVal ) ), Op
+                ).first;
+            OnInserted( Op );
+        }
+        else {
+            Id.ShareWith( i->first );
+        }
+        return i->second.first;
+    }
+
+    /// Inserts or updates @p Id (see @ref PutItemTo).
+    ///
+    /// @p Val is either a @c ValueType or a payload of one of its
+    /// alternatives.  A payload is compared with the stored value as is
+    /// and only ever moved (rvalue) or copied (lvalue) once, straight
+    /// into the node; saving a value equal to the stored one copies
+    /// nothing.
+    template<typename V>
+    bool PutValue( TKeyRef Id, V&& Val, Operation Op ) {
+        auto i = valueItems_.lower_bound( Id );
+        if ( i == std::end( valueItems_ ) || TKeyLess{}( Id, i->first ) ) {
+            valueItems_.try_emplace(
+                i, Id.ToString(), ValueType( std::forward<V>( Val ) ), Op
             );
+            OnInserted( Op );
+            return true;
+        }
+        Id.ShareWith( i->first );
+        auto& Stored = i->second;
+        if ( !SameValue( Stored.first, Val ) ) {
+            if ( Stored.second == Operation::Erase ) { ++valueCount_; }
+            AssignValue( Stored.first, std::forward<V>( Val ) );
+            Stored.second = Operation::Write;
+            valuesModified_ = true;
+            Changed();
         }
+        return false;
     }
 
-    bool ValueListModified() const noexcept {
-        return
-            std::find_if(
-                std::begin( valueItems_ ), std::end( valueItems_ ),
-                []( auto const & v ) {
-                    switch ( v.second.second ) {
-                        case Operation::Write:
-                        case Operation::Erase:
-                            return true;
-                        default:
-                            return false;
-                    }
-                }
-            ) != std::end( valueItems_ );
+    void OnInserted( Operation Op ) noexcept {
+        if ( Op != Operation::Erase ) { ++valueCount_; }
+        if ( Op != Operation::None ) { valuesModified_ = true; }
+        Changed();
     }
 
-    bool NodesModified() const noexcept {
-        return
-            std::find_if(
-                std::begin( nodeItems_ ), std::end( nodeItems_ ),
-                []( auto const & n ) { return n.second->IsModified(); }
-            ) != std::end( nodeItems_ );
+    static void CheckPersistencePathDepth( TConfigPath const & Path ) {
+        CheckPersistenceDepth( Path.size() );
     }
 
     static bool IsValueDeleted( ValueContType::value_type const & Val ) noexcept {
         return Val.second.second == Operation::Erase;
     }
 
-    /// Non-enum read path: probes the variant with @c get_if<T>.
+    /// Non-enum read path: probes the stored cell with @c GetIfValue<T>.
     ///
     /// If the stored alternative matches @c T, @p Val is overwritten.
-    /// Otherwise @c get_if returns @c nullptr and @p Val is left
+    /// Otherwise @c GetIfValue returns @c nullptr and @p Val is left
     /// unchanged — this is the silent-default-on-mismatch contract.
     template<typename T>
-    void GetItemAs( is_other_tag, String Id, T& Val, Operation Op ) {
-        auto& Result = GetItemFrom( valueItems_, Id, Val, Op );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        if ( auto* p = std::get_if<std::remove_reference_t<T>>( &Result ) ) {
+    void GetItemAs( is_other_tag, TKeyRef Id, T& Val, Operation Op ) {
+        auto const & Result = GetValue( Id, Val, Op );
+        if ( auto p = GetIfValue<std::remove_reference_t<T>>( &Result ) ) {
             Val = *p;
         }
-#else
-        if ( auto* p = boost::get<std::remove_reference_t<T>>( &Result ) ) {
+    }
+
+    static void AssignStrings( TStrings& Dst, StringCont const & Src ) {
+        Dst.Clear();
+        std::copy(
+            std::begin( Src ), std::end( Src ), System::back_inserter( &Dst )
+        );
+    }
+
+    template<typename T>
+    bool TryGetAs( is_other_tag, TKeyRef Id, T& Val ) const {
+        if ( auto p = Find<T>( Id ) ) {
             Val = *p;
+            return true;
         }
-#endif
+        return false;
     }
 
+    template<typename T>
+    bool TryGetAs( is_enum_tag, TKeyRef Id, T& Val ) const;
+
     /// Enum read path: uses Delphi RTTI when available.
     ///
     /// If @c __delphirtti(T) returns a valid type-info pointer the
     /// stored @c String name is converted back via @c GetEnumValue.
     /// Otherwise the enum is read as a plain @c int and @c static_cast
-    /// to @c T.  In both cases the same @c get_if mismatch rule applies.
+    /// to @c T.  In both cases the same @c GetIfValue mismatch rule applies.
     template<typename T>
-    void GetItemAs( is_enum_tag, String Id, T& Val, Operation Op );
+    void GetItemAs( is_enum_tag, TKeyRef Id, T& Val, Operation Op );
 
     template<typename T>
-    bool PutItem( String Id, T&& Val, is_other_tag, Operation Op = Operation::Write ) {
-        return
-            PutItemTo(
-                valueItems_, Id,
-                std::make_pair( ValueType{ std::forward<T>( Val ) }, Op )
-            );
+    bool PutItem( TKeyRef Id, T&& Val, is_other_tag, Operation Op = Operation::Write ) {
+        using U = std::decay_t<T>;
+        if constexpr ( is_value_alternative_v<U> || std::is_same_v<U,ValueType> ) {
+            return PutValue( Id, std::forward<T>( Val ), Op );
+        }
+        else {
+            // Converted to whichever alternative the value cell selects.
+            return PutValue( Id, ValueType( std::forward<T>( Val ) ), Op );
+        }
     }
 
     template<typename T>
-    bool PutItem( String Id, T Val, is_enum_tag, Operation Op = Operation::Write );
+    bool PutItem( TKeyRef Id, T Val, is_enum_tag, Operation Op = Operation::Write );
+
+};
+//---------------------------------------------------------------------------
+
+/// Forward range over the live values of a node (see
+/// @ref TConfigNode::Values).  Entries marked for deletion are skipped.
+class TConfigNode::TValueRange {
+public:
+    using value_type = std::pair<String const &, ValueType const &>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TValueRange::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        const_iterator() = default;
+
+        const_iterator( ValueContType::const_iterator It,
+                        ValueContType::const_iterator End ) noexcept
+            : it_{ It }, end_{ End }
+        {
+            SkipErased();
+        }
+
+        reference operator*() const noexcept {
+            return { it_->first, it_->second.first };
+        }
+
+        const_iterator& operator++() noexcept {
+            ++it_;
+            SkipErased();
+            return *this;
+        }
+
+        const_iterator operator++( int ) noexcept {
+            auto Tmp = *this;
+            ++*this;
+            return Tmp;
+        }
+
+        friend bool operator==( const_iterator const & Lhs,
+                                const_iterator const & Rhs ) noexcept {
+            return Lhs.it_ == Rhs.it_;
+        }
+
+        friend bool operator!=( const_iterator const & Lhs,
+                                const_iterator const & Rhs ) noexcept {
+            return !( Lhs == Rhs );
+        }
+    private:
+        ValueContType::const_iterator it_ {};
+        ValueContType::const_iterator end_ {};
+
+        void SkipErased() noexcept {
+            while ( it_ != end_ && it_->second.second == Operation::Erase ) {
+                ++it_;
+            }
+        }
+    };
+
+    using iterator = const_iterator;
+
+    explicit TValueRange( ValueContType const & Values ) noexcept
+        : values_{ &Values } {}
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return { std::begin( *values_ ), std::end( *values_ ) };
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        return { std::end( *values_ ), std::end( *values_ ) };
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return begin() == end(); }
+private:
+    ValueContType const * values_;
+};
+//---------------------------------------------------------------------------
+
+/// Forward range over the children of a node (see
+/// @ref TConfigNode::Nodes).
+class TConfigNode::TNodeRange {
+public:
+    using value_type = std::pair<String const &, TConfigNode const &>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TNodeRange::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        const_iterator() = default;
+
+        explicit const_iterator( NodeContType::const_iterator It ) noexcept
+            : it_{ It } {}
+
+        reference operator*() const noexcept {
+            return { it_->first, *it_->second };
+        }
+
+        const_iterator& operator++() noexcept {
+            ++it_;
+            return *this;
+        }
+
+        const_iterator operator++( int ) noexcept {
+            auto Tmp = *this;
+            ++it_;
+            return Tmp;
+        }
+
+        friend bool operator==( const_iterator const & Lhs,
+                                const_iterator const & Rhs ) noexcept {
+            return Lhs.it_ == Rhs.it_;
+        }
+
+        friend bool operator!=( const_iterator const & Lhs,
+                                const_iterator const & Rhs ) noexcept {
+            return !( Lhs == Rhs );
+        }
+    private:
+        NodeContType::const_iterator it_ {};
+    };
+
+    using iterator = const_iterator;
 
+    explicit TNodeRange( NodeContType const & Nodes ) noexcept
+        : nodes_{ &Nodes } {}
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return const_iterator{ std::begin( *nodes_ ) };
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        return const_iterator{ std::end( *nodes_ ) };
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return nodes_->size(); }
+    [[nodiscard]] bool empty() const noexcept { return nodes_->empty(); }
+private:
+    NodeContType const * nodes_;
 };
 //---------------------------------------------------------------------------
 
+inline TConfigNode::TValueRange TConfigNode::Values() const noexcept
+{
+    return TValueRange{ valueItems_ };
+}
+//---------------------------------------------------------------------------
+
+inline TConfigNode::TNodeRange TConfigNode::Nodes() const noexcept
+{
+    return TNodeRange{ nodeItems_ };
+}
+//---------------------------------------------------------------------------
+
+inline void TConfigNodeDeleter::operator()( TConfigNode* Node ) const noexcept
+{
+    ArenaDelete( Arena, Node );
+}
+//---------------------------------------------------------------------------
+
+inline TConfigNodePtr MakeConfigNode( TConfigArena* Arena )
+{
+    return
+        TConfigNodePtr(
+            ArenaNew<TConfigNode>( Arena, Arena ), TConfigNodeDeleter{ Arena }
+        );
+}
+//---------------------------------------------------------------------------
+
 template<typename T>
-void TConfigNode::GetItemAs( is_enum_tag, String Id, T& Val, Operation Op )
+void TConfigNode::GetItemAs( is_enum_tag, TKeyRef Id, T& Val, Operation Op )
 {
     // bcc64 (Clang < 15) has compatibility issues with __delphirtti and GetEnumValue on enums.
     // RSP-27417: Force integer-based enum serialization on bcc64 to work around RTTI bugs.
 #if defined(__BORLANDC__) && defined(_WIN64) && !defined(__MINGW64__) && __clang_major__ < 15
     // bcc64: use integer-based enum handling
-    auto& Result = GetItemFrom(
-        valueItems_, Id, static_cast<int>( Val ), Op
-    );
-    if ( auto* p = boost::get<int>( &Result ) ) {
+    auto const & Result = GetValue( Id, static_cast<int>( Val ), Op );
+    if ( auto p = GetIfValue<int>( &Result ) ) {
         Val = static_cast<T>( *p );
     }
 #else
     // bcc64x and bcc32c: use RTTI-based enum handling
     if ( auto Info = __delphirtti( decltype( Val ) ) ) {
-        auto& Result = GetItemFrom(
-            valueItems_, Id,
-            GetEnumName( Info, static_cast<int>( Val ) ), Op
+        auto const & Result = GetValue(
+            Id, GetEnumName( Info, static_cast<int>( Val ) ), Op
         );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        if ( auto* p = std::get_if<String>( &Result ) ) {
-#else
-        if ( auto* p = boost::get<String>( &Result ) ) {
-#endif
+        if ( auto p = GetIfValue<String>( &Result ) ) {
             Val = static_cast<T>( GetEnumValue( Info, *p ) );
         }
     }
     else {
-        auto& Result = GetItemFrom(
-            valueItems_, Id, static_cast<int>( Val ), Op
-        );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        if ( auto* p = std::get_if<int>( &Result ) ) {
-#else
-        if ( auto* p = boost::get<int>( &Result ) ) {
-#endif
+        auto const & Result = GetValue( Id, static_cast<int>( Val ), Op );
+        if ( auto p = GetIfValue<int>( &Result ) ) {
             Val = static_cast<T>( *p );
         }
     }
@@ -381,35 +880,48 @@ void TConfigNode::GetItemAs( is_enum_tag, String Id, T& Val, Operation Op )
 //---------------------------------------------------------------------------
 
 template<typename T>
-bool TConfigNode::PutItem( String Id, T Val, is_enum_tag, Operation Op )
+bool TConfigNode::TryGetAs( is_enum_tag, TKeyRef Id, T& Val ) const
+{
+    // Same encodings as GetItemAs( is_enum_tag, ... ).
+#if defined(__BORLANDC__) && defined(_WIN64) && !defined(__MINGW64__) && __clang_major__ < 15
+    if ( auto p = Find<int>( Id ) ) {
+        Val = static_cast<T>( *p );
+        return true;
+    }
+#else
+    if ( auto Info = __delphirtti( T ) ) {
+        if ( auto p = Find<String>( Id ) ) {
+            Val = static_cast<T>( GetEnumValue( Info, *p ) );
+            return true;
+        }
+    }
+    else if ( auto p = Find<int>( Id ) ) {
+        Val = static_cast<T>( *p );
+        return true;
+    }
+#endif
+    return false;
+}
+//---------------------------------------------------------------------------
+
+template<typename T>
+bool TConfigNode::PutItem( TKeyRef Id, T Val, is_enum_tag, Operation Op )
 {
     // bcc64 (Clang < 15) has compatibility issues with __delphirtti and GetEnumValue on enums.
     // RSP-27417: Force integer-based enum serialization on bcc64 to work around RTTI bugs.
 #if defined(__BORLANDC__) && defined(_WIN64) && !defined(__MINGW64__) && __clang_major__ < 15
     // bcc64: use integer-based serialization
-    return PutItemTo(
-        valueItems_, Id,
-        std::make_pair( ValueType{ static_cast<int>( Val ) }, Op )
-    );
+    return PutValue( Id, static_cast<int>( Val ), Op );
 #else
     // bcc64x and bcc32c: use RTTI-based serialization
     if ( auto Info = __delphirtti( decltype( Val ) ) ) {
         // save enum as text
 
-        return PutItemTo(
-            valueItems_, Id,
-            std::make_pair(
-                ValueType{ GetEnumName( Info, static_cast<int>( Val ) ) },
-                Op
-            )
-        );
+        return PutValue( Id, GetEnumName( Info, static_cast<int>( Val ) ), Op );
     }
     else {
         // save enum as integer
-        return PutItemTo(
-            valueItems_, Id,
-            std::make_pair( ValueType{ static_cast<int>( Val ) }, Op )
-        );
+        return PutValue( Id, static_cast<int>( Val ), Op );
     }
 #endif
 }
@@ -457,19 +969,71 @@ void TConfigNode::EnumerateValues( OutputIterator Out ) const
 /// then @c Reader.CreateNodeList to discover child nodes, and recurses
 /// into each child with an extended path.  This is the read half of the
 /// two-phase RAII lifecycle: construction loads, destruction flushes.
+/// When @p Reader has @c EnterNode / @c LeaveNode (the node cursor of
+/// @c Anafestica::TConfig), every descent is bracketed by them.
 template<typename R>
 void TConfigNode::Read( R& Reader, TConfigPath const & Path )
+{
+    TConfigPath SubPath( Path );
+    ReadSubtree( Reader, SubPath, nullptr, static_cast<std::size_t>( -1 ) );
+    if ( parent_ ) { parent_->Changed(); }
+}
+//---------------------------------------------------------------------------
+
+/// Populates this node from storage and leaves its children pending.
+///
+/// Reads the values at @p Path and the names of the child nodes, plus
+/// @p Levels further levels of descendants; the nodes below that keep a
+/// pointer to @p Loader and are loaded on first access (see
+/// @ref GetSubNode and @ref Prefetch).  Used by @c Anafestica::TConfig for
+/// the initial read in lazy mode and for every on-demand load.
+template<typename R>
+void TConfigNode::ReadLazy( R& Reader, TConfigNodeLoader& Loader,
+                            TConfigPath const & Path, std::size_t Levels )
+{
+    TConfigPath SubPath( Path );
+    ReadSubtree( Reader, SubPath, &Loader, Levels );
+}
+//---------------------------------------------------------------------------
+
+template<typename R>
+void TConfigNode::ReadSubtree( R& Reader, TConfigPath& Path,
+                               TConfigNodeLoader* Loader, std::size_t Levels )
 {
     CheckPersistencePathDepth( Path );
     valueItems_ = Reader.CreateValueList( Path );
     nodeItems_ = Reader.CreateNodeList( Path );
-    TConfigPath TmpPath;
-    TmpPath.reserve( Path.size() + 1 );
-    TmpPath = Path;
-    TmpPath.push_back({});
+    loader_ = nullptr;
+    RecountValues();
+    nodesModified_ = false;
+    ++generation_;
+    for ( auto& n : nodeItems_ ) {
+        n.second->parent_ = this;
+        n.second->name_ = n.first;
+        if ( Loader && !Levels ) {
+            n.second->loader_ = Loader;
+        }
+        else {
+            Detail::TChildScope<R> Child( Reader, Path, n.first );
+            n.second->ReadSubtree( Reader, Path, Loader, Levels - 1 );
+            nodesModified_ = nodesModified_ || n.second->IsModified();
+        }
+    }
+}
+//---------------------------------------------------------------------------
+
+inline void TConfigNode::Populate( ValueContType Values, NodeContType Nodes )
+{
+    valueItems_ = std::move( Values );
+    nodeItems_ = std::move( Nodes );
+    loader_ = nullptr;
+    RecountValues();
+    nodesModified_ = false;
+    ++generation_;
     for ( auto& n : nodeItems_ ) {
-        TmpPath.back() = n.first;
-        n.second->Read( Reader, TmpPath );
+        n.second->parent_ = this;
+        n.second->name_ = n.first;
+        nodesModified_ = nodesModified_ || n.second->IsModified();
     }
 }
 //---------------------------------------------------------------------------
@@ -479,27 +1043,54 @@ void TConfigNode::Read( R& Reader, TConfigPath const & Path )
 /// Deleted nodes are removed first.  Modified value lists are saved via
 /// @c Writer.SaveValueList.  When @c GetAlwaysFlushNodeFlag() is set
 /// (used by backends that rewrite the entire file), every node is saved
-/// regardless of its dirty state.
+/// regardless of its dirty state.  Pending (never loaded) children are
+/// skipped: storage already holds their content.  Descents are
+/// bracketed by the node cursor calls, as in @ref Read.
 template<typename W>
 void TConfigNode::Write( W& Writer, TConfigPath const & Path ) const
+{
+    TConfigPath SubPath( Path );
+    WriteSubtree( Writer, SubPath );
+}
+//---------------------------------------------------------------------------
+
+template<typename W>
+void TConfigNode::WriteSubtree( W& Writer, TConfigPath& Path ) const
 {
     CheckPersistencePathDepth( Path );
     if ( IsDeleted() ) {
         Writer.DeleteNode( Path );
     }
-    if ( Writer.GetAlwaysFlushNodeFlag() || ValueListModified() ) {
+    if ( Writer.GetAlwaysFlushNodeFlag() || valuesModified_ ) {
         Writer.SaveValueList( Path, valueItems_ );
     }
-    TConfigPath TmpPath;
-    TmpPath.reserve( Path.size() + 1 );
-    TmpPath = Path;
-    TmpPath.push_back({});
     for ( auto const & n : nodeItems_ ) {
-        TmpPath.back() = n.first;
-        if ( Writer.GetAlwaysFlushNodeFlag() || n.second->IsModified() ) {
-            n.second->Write( Writer, TmpPath );
+        if ( n.second->IsLoaded() &&
+             ( Writer.GetAlwaysFlushNodeFlag() || n.second->IsModified() ) ) {
+            Detail::TChildScope<W> Child( Writer, Path, n.first );
+            n.second->WriteSubtree( Writer, Path );
+        }
+    }
+}
+//---------------------------------------------------------------------------
+
+inline void TConfigNode::CommitWrite()
+{
+    if ( valuesModified_ ) {
+        auto i = std::remove_if(
+            std::begin( valueItems_ ), std::end( valueItems_ ), IsValueDeleted
+        );
+        valueItems_.erase( i, std::end( valueItems_ ) );
+        for ( auto& v : valueItems_ ) { v.second.second = Operation::None; }
+        valuesModified_ = false;
+    }
+    if ( nodesModified_ ) {
+        for ( auto& n : nodeItems_ ) {
+            if ( n.second->IsModified() ) { n.second->CommitWrite(); }
         }
+        nodesModified_ = false;
     }
+    deleted_ = false;
 }
 //---------------------------------------------------------------------------
 
@@ -510,7 +1101,7 @@ void TConfigNode::Write( W& Writer, TConfigPath const & Path ) const
 /// @p Value if the key does not exist (the temporary keeps the old
 /// value, and @c GetItem leaves it unchanged on mismatch/absence).
 template<typename T>
-void RestoreValue( TConfigNode& Node, String KeyName, T& Value )
+void RestoreValue( TConfigNode& Node, TKeyRef KeyName, T& Value )
 {
     std::remove_reference_t< decltype( Value )> Tmp{ Value };
     Node.GetItem( KeyName, Tmp );
@@ -520,7 +1111,7 @@ void RestoreValue( TConfigNode& Node, String KeyName, T& Value )
 //---------------------------------------------------------------------------
 
 template<typename T>
-void SaveValue( TConfigNode& Node, String KeyName, T const & Value )
+void SaveValue( TConfigNode& Node, TKeyRef KeyName, T const & Value )
 {
     Node.PutItem( KeyName, Value );
 }
@@ -529,25 +1120,28 @@ void SaveValue( TConfigNode& Node, String KeyName, T const & Value )
 } // End of namespace Anafestica
 //---------------------------------------------------------------------------
 
+// The key of each property macro is interned once per expansion site
+// (see ANA_KEY), so restoring and saving allocate nothing for the name.
+
 #define RESTORE_PROPERTY( NODE, PROPERTY ) \
 {\
     std::remove_reference_t< decltype( PROPERTY )> Tmp{ PROPERTY }; \
-    ( NODE ).GetItem( #PROPERTY, Tmp ); \
+    ( NODE ).GetItem( ANA_KEY( #PROPERTY ), Tmp ); \
     PROPERTY = Tmp; \
 }
 
 #define SAVE_PROPERTY( NODE, PROPERTY ) \
-    ( NODE ).PutItem( #PROPERTY, PROPERTY )
+    ( NODE ).PutItem( ANA_KEY( #PROPERTY ), PROPERTY )
 
 #define RESTORE_ID_PROPERTY( NODE, ID, PROPERTY ) \
 {\
     std::remove_reference_t< decltype( PROPERTY )> Tmp{ PROPERTY }; \
-    ( NODE ).GetItem( #ID, Tmp ); \
+    ( NODE ).GetItem( ANA_KEY( #ID ), Tmp ); \
     PROPERTY = Tmp; \
 }
 
 #define SAVE_ID_PROPERTY( NODE, ID, PROPERTY ) \
-    ( NODE ).PutItem( #ID, PROPERTY )
+    ( NODE ).PutItem( ANA_KEY( #ID ), PROPERTY )
 
 //---------------------------------------------------------------------------
 
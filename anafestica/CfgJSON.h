@@ -9,16 +9,28 @@
 #include <System.DateUtils.hpp>
 #include <System.NetEncoding.hpp>
 #include <System.SysUtils.hpp>
+#include <System.Classes.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
-#include <array>
-#include <functional>
 #include <iterator>
+#include <utility>
 
 #include <anafestica/FileVersionInfo.h>
 #include <anafestica/Cfg.h>
+#include <anafestica/CfgCodec.h>
+#include <anafestica/CfgNodeCursor.h>
 #include <anafestica/CfgCrypt.h>
+#include <anafestica/CfgFileStamp.h>
+#include <anafestica/CfgFlushPlan.h>
+#include <anafestica/CfgJSONSax.h>
+#include <anafestica/CfgJSONWriter.h>
 
 //---------------------------------------------------------------------------
 namespace Anafestica {
@@ -33,15 +45,14 @@ private:
 public:
     TConfig( String FileName, bool ReadOnly = false, bool Compact = true,
              bool FlushAllItems = false, bool ExplicitTypes = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, FlushAllItems )
+             Crypt::TOptions CryptOptions = {}, TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, FlushAllItems, Options )
         , fileName_{ FileName }, loadFileName_{ FileName }, compact_{ Compact }
         , explicitTypes_{ ExplicitTypes }
         , cryptOptions_{ CryptOptions }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
-            JSONObjRAII JSON{ *this };
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
         }
     }
 
@@ -56,8 +67,9 @@ public:
     /// destination.  See @ref Migrate for a named-constructor wrapper.
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false, bool Compact = true,
-             bool ExplicitTypes = false, Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true )
+             bool ExplicitTypes = false, Crypt::TOptions CryptOptions = {},
+             TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true, Options )
         , fileName_{ SaveFileName }
         , loadFileName_{
             TFile::Exists( SaveFileName ) ? SaveFileName : LoadFileName
@@ -67,8 +79,7 @@ public:
         , cryptOptions_{ CryptOptions }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
-            JSONObjRAII JSON{ *this };
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
             if ( loadFileName_ != fileName_ ) {
                 MarkForFlush();
             }
@@ -80,11 +91,12 @@ public:
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false, bool Compact = true,
                             bool ExplicitTypes = false,
-                            Crypt::TOptions CryptOptions = {} )
+                            Crypt::TOptions CryptOptions = {},
+                            TConfigOptions Options = {} )
     {
         return TConfig(
             LoadFileName, SaveFileName, ReadOnly, Compact, ExplicitTypes,
-            CryptOptions
+            CryptOptions, Options
         );
     }
 
@@ -105,7 +117,11 @@ private:
     public:
         JSONObjRAII( TConfig& Cfg ) : cfg_{ Cfg } { Cfg.CreateJSONObject(); }
         ~JSONObjRAII() {
-            try { cfg_.DestroyAndCloseJSONObject(); } catch ( ... ) {}
+            // In lazy mode the document stays open for on-demand loads,
+            // in retain mode for the next flush.
+            if ( !cfg_.GetLazyLoadFlag() && !cfg_.GetRetainDocumentFlag() ) {
+                try { cfg_.DestroyAndCloseJSONObject(); } catch ( ... ) {}
+            }
         }
         JSONObjRAII( JSONObjRAII const & ) = delete;
         JSONObjRAII& operator=( JSONObjRAII const & ) = delete;
@@ -119,6 +135,10 @@ private:
     bool compact_;
     bool explicitTypes_;
     Crypt::TOptions cryptOptions_;
+    TNodeCursor<TJSONObject*> cursor_;
+    TDocumentStamp documentStamp_;
+    Crypt::Bytes text_;                 // retained text of the streamed path
+    TDocumentStamp textStamp_;
 
     String ReadFileText( String const & FileName ) const {
         return cryptOptions_.Enabled
@@ -136,6 +156,14 @@ private:
     }
 
     void CreateJSONObject() {
+        // Retain mode: the document left by the last load or flush is
+        // reused while the file is as it was then.
+        if ( document_ && documentStamp_.Matches( loadFileName_ ) ) {
+            return;
+        }
+        if ( GetRetainDocumentFlag() ) {
+            documentStamp_.Take( loadFileName_ );
+        }
         document_.reset();
         if ( TFile::Exists( loadFileName_ ) ) {
             document_.reset(
@@ -151,26 +179,35 @@ private:
         document_.reset();
     }
 
-    TJSONObject* OpenPath( TConfigPath const & Path ) {
-        if ( auto Node = dynamic_cast<TJSONObject*>( document_.get() ) ) {
-            for ( auto const & NodeName : Path ) {
-                if ( auto NodesInner = Node->FindValue( NodesNodeName ) ) {
-                    if ( auto Inner = NodesInner->FindValue( NodeName ) ) {
-                        if ( auto NodeObj = dynamic_cast<TJSONObject*>( Inner ) ) {
-                            Node = NodeObj;
-                            continue;
-                        }
-                    }
+    // Replaces Node with its child node Name; false when there is none.
+    static bool OpenChild( TJSONObject*& Node, String const & Name ) {
+        if ( auto NodesInner = Node->FindValue( NodesNodeName ) ) {
+            if ( auto Inner = NodesInner->FindValue( Name ) ) {
+                if ( auto NodeObj = dynamic_cast<TJSONObject*>( Inner ) ) {
+                    Node = NodeObj;
+                    return true;
                 }
-                return nullptr;
             }
-            return Node;
+        }
+        return false;
+    }
+
+    // Opens the first Levels components of Path.
+    TJSONObject* OpenPath( TConfigPath const & Path, std::size_t Levels ) {
+        if ( auto Node = dynamic_cast<TJSONObject*>( document_.get() ) ) {
+            if ( cursor_.Resolve( Node, Path, Levels, &OpenChild ) ) {
+                return Node;
+            }
         }
         return nullptr;
     }
 
-    TJSONObject* OpenNodes( TConfigPath const & Path ) {
-        if ( auto Node = OpenPath( Path ) ) {
+    TJSONObject* OpenPath( TConfigPath const & Path ) {
+        return OpenPath( Path, Path.size() );
+    }
+
+    TJSONObject* OpenNodes( TConfigPath const & Path, std::size_t Levels ) {
+        if ( auto Node = OpenPath( Path, Levels ) ) {
             if ( auto Inner = Node->FindValue( NodesNodeName ) ) {
                 return dynamic_cast<TJSONObject*>( Inner );
             }
@@ -178,6 +215,10 @@ private:
         return nullptr;
     }
 
+    TJSONObject* OpenNodes( TConfigPath const & Path ) {
+        return OpenNodes( Path, Path.size() );
+    }
+
     TJSONObject* OpenValues( TConfigPath const & Path ) {
         if ( auto Node = OpenPath( Path ) ) {
             if ( auto Inner = Node->FindValue( ValuesNodeName ) ) {
@@ -187,26 +228,29 @@ private:
         return nullptr;
     }
 
+    // Returns member Name of Node, adding an empty object when it is
+    // missing.  A member that is not an object is stepped over.
+    static TJSONObject* ForceObject( TJSONObject* Node, String const & Name ) {
+        if ( auto Inner = Node->FindValue( Name ) ) {
+            if ( auto ANode = dynamic_cast<TJSONObject*>( Inner ) ) {
+                return ANode;
+            }
+            return Node;
+        }
+        auto InnerObj = std::make_unique<TJSONObject>();
+        Node->AddPair( Name, InnerObj.get() );
+        return InnerObj.release();
+    }
+
+    // Replaces Node with its child node Name, creating it when missing.
+    static bool ForceChild( TJSONObject*& Node, String const & Name ) {
+        Node = ForceObject( ForceObject( Node, NodesNodeName ), Name );
+        return true;
+    }
+
     TJSONObject* ForcePath( TConfigPath const & Path ) {
         if ( auto Node = dynamic_cast<TJSONObject*>( document_.get() ) ) {
-            TConfigPath FPath;
-            FPath.reserve( Path.size() * 2 );
-            for ( auto const & NodeName : Path ) {
-                FPath.push_back( NodesNodeName );
-                FPath.push_back( NodeName );
-            }
-            for ( auto const & NodeName : FPath ) {
-                if ( auto Inner = Node->FindValue( NodeName ) ) {
-                    if ( auto ANode = dynamic_cast<TJSONObject*>( Inner ) ) {
-                        Node = ANode;
-                    }
-                }
-                else {
-                    auto InnerObj = std::make_unique<TJSONObject>();
-                    Node->AddPair( NodeName, InnerObj.get() );
-                    Node = InnerObj.release();
-                }
-            }
+            cursor_.Resolve( Node, Path, &ForceChild );
             return Node;
         }
         return nullptr;
@@ -274,360 +318,1291 @@ private:
         }
     }
 
-    // https://www.bfilipek.com/2019/02/2lines3featuresoverload.html
-    //template<class... Ts> struct overload : Ts... { using Ts::operator()...; };
-    //template<class... Ts> overload( Ts... ) -> overload<Ts...>;
+    std::unique_ptr<TBase64Encoding> base64_ { new TBase64Encoding{ 0 } };
 
-    // https://andreasfertig.blog/2023/07/visiting-a-stdvariant-safely/
-    template<class...>
-    static constexpr bool always_false_v = false;
+    // Value codec.  A value is written as { "<tag>": <payload> }, except an
+    // int, bool or String when explicit types are off; the alternatives
+    // without a native JSON form are stored as their text form.
+    struct TValueCodec {
+        TConfig& Cfg;
 
-    template<class... Ts>
-    struct overload : Ts...
-    {
-      using Ts::operator()...;
-
-      // Prevent implicit type conversions
-      template<typename T>
-      constexpr void operator()(T) const
-      {
-        static_assert(always_false_v<T>, "Unsupported type");
-      }
-    };
+        template<typename C, typename T>
+        static void EncodeNumber( TJSONObject& Obj, String const & Name, T Val ) {
+            WriteNumber<C>( Obj, Codec::TagName<T>(), Name, Val );
+        }
 
-    template<class... Ts>
-overload(Ts...) -> overload<Ts...>;
+        template<typename T>
+        static void EncodeText( TJSONObject& Obj, String const & Name, T const & Val ) {
+            Write(
+                Obj, Codec::TagName<T>(), Name,
+                std::make_unique<TJSONString>(
+                    Codec::TTextCodec::Encode( Codec::TAs<T>{}, Val )
+                )
+            );
+        }
 
-    std::unique_ptr<TBase64Encoding> base64_ { new TBase64Encoding{ 0 } };
+        template<typename T>
+        static T DecodeText( TJSONValue& Value ) {
+            return
+                Codec::TTextCodec::Decode(
+                    Codec::TAs<T>{}, Value.GetValue<String>()
+                );
+        }
+
+        String EncodeBytes( Byte const * Data, int High ) const {
+            return Cfg.base64_->EncodeBytesToString( Data, High );
+        }
+
+        void Encode( Codec::TAs<int>, int Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            if ( Cfg.explicitTypes_ ) {
+                EncodeNumber<int>( Obj, Name, Val );
+            }
+            else {
+                Write( Obj, Name, std::make_unique<TJSONNumber>( Val ) );
+            }
+        }
+
+        void Encode( Codec::TAs<unsigned int>, unsigned int Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<long>, long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<unsigned long>, unsigned long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<char>, char Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<unsigned char>, unsigned char Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<short>, short Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<unsigned short>, unsigned short Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<int>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<long long>, long long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<__int64>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<unsigned long long>, unsigned long long Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<bool>, bool Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            if ( Cfg.explicitTypes_ ) {
+                Write(
+                    Obj, Codec::TagName<bool>(), Name,
+                    std::make_unique<TJSONBool>( Val )
+                );
+            }
+            else {
+                Write( Obj, Name, std::make_unique<TJSONBool>( Val ) );
+            }
+        }
+
+        void Encode( Codec::TAs<String>, String const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            if ( Cfg.explicitTypes_ ) {
+                Write(
+                    Obj, Codec::TagName<String>(), Name,
+                    std::make_unique<TJSONString>( Val )
+                );
+            }
+            else {
+                Write( Obj, Name, std::make_unique<TJSONString>( Val ) );
+            }
+        }
+
+        void Encode( Codec::TAs<TDateTime>, TDateTime Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<float>, float Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<double>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<double>, double Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeNumber<double>( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<Currency>, Currency Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<StringCont>, StringCont const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            WriteStrings( Obj, Codec::TagName<StringCont>(), Name, Val );
+        }
+
+        void Encode( Codec::TAs<TBytes>, TBytes Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            Write(
+                Obj, Codec::TagName<TBytes>(), Name,
+                std::make_unique<TJSONString>(
+                    Val.Length == 0 ? String() : EncodeBytes( &Val[0], Val.High )
+                )
+            );
+        }
+
+        void Encode( Codec::TAs<BytesCont>, BytesCont const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            Write(
+                Obj, Codec::TagName<BytesCont>(), Name,
+                std::make_unique<TJSONString>(
+                    Val.empty() ? String() : EncodeBytes( Val.data(), Val.size() - 1 )
+                )
+            );
+        }
+
+        void Encode( Codec::TAs<std::string>, std::string const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        void Encode( Codec::TAs<std::wstring>, std::wstring const & Val,
+                     TJSONObject& Obj, String const & Name ) const {
+            EncodeText( Obj, Name, Val );
+        }
+
+        static int Decode( Codec::TAs<int>, TJSONValue& Value ) {
+            return Value.GetValue<int>();
+        }
+
+        static unsigned int Decode( Codec::TAs<unsigned int>, TJSONValue& Value ) {
+            return Value.GetValue<unsigned>();
+        }
+
+        static long Decode( Codec::TAs<long>, TJSONValue& Value ) {
+            return static_cast<long>( Value.GetValue<__int64>() );
+        }
+
+        static unsigned long Decode( Codec::TAs<unsigned long>, TJSONValue& Value ) {
+            return static_cast<unsigned long>( Value.GetValue<__int64>() );
+        }
+
+        static char Decode( Codec::TAs<char>, TJSONValue& Value ) {
+            return static_cast<char>( Value.GetValue<int>() );
+        }
+
+        static unsigned char Decode( Codec::TAs<unsigned char>, TJSONValue& Value ) {
+            return Value.GetValue<unsigned char>();
+        }
+
+        static short Decode( Codec::TAs<short>, TJSONValue& Value ) {
+            return Value.GetValue<short>();
+        }
+
+        static unsigned short Decode( Codec::TAs<unsigned short>, TJSONValue& Value ) {
+            return Value.GetValue<unsigned short>();
+        }
+
+        static long long Decode( Codec::TAs<long long>, TJSONValue& Value ) {
+            return Value.GetValue<__int64>();
+        }
+
+        static unsigned long long Decode( Codec::TAs<unsigned long long>, TJSONValue& Value ) {
+            return DecodeText<unsigned long long>( Value );
+        }
+
+        static bool Decode( Codec::TAs<bool>, TJSONValue& Value ) {
+            return Value.GetValue<bool>();
+        }
+
+        static String Decode( Codec::TAs<String>, TJSONValue& Value ) {
+            return Value.GetValue<String>();
+        }
+
+        static TDateTime Decode( Codec::TAs<TDateTime>, TJSONValue& Value ) {
+            return DecodeText<TDateTime>( Value );
+        }
+
+        static float Decode( Codec::TAs<float>, TJSONValue& Value ) {
+            return Value.GetValue<float>();
+        }
+
+        static double Decode( Codec::TAs<double>, TJSONValue& Value ) {
+            return Value.GetValue<double>();
+        }
+
+        static Currency Decode( Codec::TAs<Currency>, TJSONValue& Value ) {
+            return DecodeText<Currency>( Value );
+        }
+
+        static StringCont Decode( Codec::TAs<StringCont>, TJSONValue& Value ) {
+            StringCont Strings;
+            if ( auto JSONArr = dynamic_cast<TJSONArray*>( &Value ) ) {
+                Strings.reserve( JSONArr->Count );
+                std::transform(
+                    System::begin( JSONArr ), System::end( JSONArr ),
+                    std::back_inserter( Strings ),
+                    []( auto Val ){ return Val->template GetValue<String>(); }
+                );
+            }
+            return Strings;
+        }
+
+        static TBytes Decode( Codec::TAs<TBytes>, TJSONValue& Value ) {
+            return DecodeText<TBytes>( Value );
+        }
+
+        static BytesCont Decode( Codec::TAs<BytesCont>, TJSONValue& Value ) {
+            return DecodeText<BytesCont>( Value );
+        }
+
+        static std::string Decode( Codec::TAs<std::string>, TJSONValue& Value ) {
+            return DecodeText<std::string>( Value );
+        }
+
+        static std::wstring Decode( Codec::TAs<std::wstring>, TJSONValue& Value ) {
+            return DecodeText<std::wstring>( Value );
+        }
+    };
 
     void SaveValue( TJSONObject& Obj, ValueContType::value_type const & v ) {
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::visit(
-#else
-        boost::apply_visitor(
-#endif
-            overload {
-                [this, &Obj, &v]( int Val ) {
-                    if ( explicitTypes_ ) {
-                        WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_I ), v.first, Val );
-                    }
-                    else {
-                        Write(
-                            Obj, v.first,
-                            std::make_unique<TJSONNumber>( Val )
-                        );
-                    }
-                },
-
-                [&Obj, &v]( unsigned int Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_U ), v.first, Val );
-                },
-
-                [&Obj, &v]( long Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_L ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned long Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_UL ), v.first, Val );
-                },
-
-                [&Obj, &v]( char Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_C ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned char Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_UC ), v.first, Val );
-                },
-
-                [&Obj, &v]( short Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_S ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned short Val ) {
-                    WriteNumber<int>( Obj, ana_cnv_xstr( ANA_TT_US ), v.first, Val );
-                },
-
-                [&Obj, &v]( long long Val ) {
-                    WriteNumber<__int64>( Obj, ana_cnv_xstr( ANA_TT_LL ), v.first, Val );
-                },
-
-                [&Obj, &v]( unsigned long long Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_ULL ), v.first,
-                        std::make_unique<TJSONString>(
-#if defined( _UNICODE )
-                            std::to_wstring( Val ).c_str()
-#else
-                            std::to_string( Val ).c_str()
-#endif
-                        )
-                    );
-                },
+        Codec::Encode( v.second.first, TValueCodec{ *this }, Obj, v.first );
+    }
 
-                [this, &Obj, &v]( bool Val ) {
-                    if ( explicitTypes_ ) {
-                        Write(
-                            Obj, ana_cnv_xstr( ANA_TT_B ), v.first,
-                            std::make_unique<TJSONBool>( Val )
-                        );
-                    }
-                    else {
-                        Write(
-                            Obj, v.first,
-                            std::make_unique<TJSONBool>( Val )
-                        );
-                    }
-                },
+    static String FromUtf8( std::string_view Text ) {
+        auto const Length = static_cast<int>( Text.size() );
+        if ( std::all_of(
+                Text.begin(), Text.end(),
+                []( char Ch ){ return static_cast<unsigned char>( Ch ) < 0x80; }
+             ) )
+        {
+            String Result;
+            Result.SetLength( Length );
+            std::copy( Text.begin(), Text.end(), Result.c_str() );
+            return Result;
+        }
+        return UTF8ToString( RawByteString( Text.data(), Length ) );
+    }
 
-                [this, &Obj, &v]( System::UnicodeString Val ) {
-                    if ( explicitTypes_ ) {
-                        Write(
-                            Obj, ana_cnv_xstr( ANA_TT_SZ ), v.first,
-                            std::make_unique<TJSONString>( Val )
-                        );
+    // Thrown by TStreamLoader and TStreamFlusher on input whose meaning
+    // they leave to the DOM reader or writer (see StreamRootNode and
+    // StreamFlush).
+    struct EStreamFallback {};
+
+    // Sax::Parse handler building the tree of an eager load directly, with
+    // the same rules as DoCreateValueList / DoCreateNodeList: the first
+    // "values" and "nodes" members of a node count, the first of two
+    // sibling nodes with the same name wins, unknown members are skipped
+    // unparsed.
+    class TStreamLoader {
+    public:
+        explicit TStreamLoader( TConfig& Cfg ) : cfg_{ Cfg } {}
+
+        bool StartObject() {
+            if ( states_.empty() ) {
+                PushNode( TConfigNodePtr{}, System::String() );
+                return true;
+            }
+            switch ( states_.back() ) {
+                case TState::Node:
+                    states_.push_back( member_ );
+                    return true;
+                case TState::Values:
+                    payload_.Pairs = 0;
+                    payload_.Kind = TKind::None;
+                    states_.push_back( TState::Wrapper );
+                    return true;
+                case TState::Nodes:
+                    TConfigNode::CheckPersistenceDepth( nodes_.size() );
+                    PushNode( cfg_.NewNode(), std::move( name_ ) );
+                    return true;
+                default:
+                    payload_.Kind = TKind::Bad;
+                    return false;
+            }
+        }
+
+        bool Key( std::string_view Name ) {
+            switch ( states_.back() ) {
+                case TState::Node: {
+                    auto& Frame = nodes_.back();
+                    if ( Name == "values" && !Frame.SeenValues ) {
+                        Frame.SeenValues = true;
+                        member_ = TState::Values;
+                        return true;
                     }
-                    else {
-                        Write(
-                            Obj, v.first,
-                            std::make_unique<TJSONString>( Val )
-                        );
+                    if ( Name == "nodes" && !Frame.SeenNodes ) {
+                        Frame.SeenNodes = true;
+                        member_ = TState::Nodes;
+                        return true;
                     }
-                },
-
-                [&Obj, &v]( System::TDateTime Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_DT ), v.first,
-                        std::make_unique<TJSONString>(
-                            DateToISO8601( Val, false )
-                        )
-                    );
-                },
-
-                [&Obj, &v]( float Val ) {
-                    WriteNumber<double>( Obj, ana_cnv_xstr( ANA_TT_FLT ), v.first, Val );
-                },
-
-                [&Obj, &v]( double Val ) {
-                    WriteNumber<double>( Obj, ana_cnv_xstr( ANA_TT_DBL ), v.first, Val );
-                },
-
-                [&Obj, &v]( System::Currency Val ) {
-                    TFormatSettings FS;
-                    FS.DecimalSeparator = _D( '.' );
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_CUR ), v.first,
-                        std::make_unique<TJSONString>( CurrToStr( Val, FS ) )
+                    return false;
+                }
+                case TState::Values:
+                    name_ = FromUtf8( Name );
+                    return true;
+                case TState::Nodes:
+                    name_ = FromUtf8( Name );
+                    return !nodes_.back().Nodes.contains( name_ );
+                case TState::Wrapper:
+                    if ( ++payload_.Pairs == 1 ) {
+                        tag_ = FindTypeTag( Name.data(), Name.size() );
+                        return tag_.has_value();
+                    }
+                    return false;
+                default:
+                    return false;
+            }
+        }
+
+        void EndObject() {
+            auto const State = states_.back();
+            states_.pop_back();
+            if ( State == TState::Wrapper ) {
+                if ( payload_.Pairs == 1 && tag_ ) {
+                    PutItemTo(
+                        nodes_.back().Values, name_,
+                        {
+                            Codec::Decode( *tag_, TStreamCodec{}, payload_ ),
+                            Operation::None
+                        }
                     );
-                },
-
-                [&Obj, &v]( StringCont const & Val ) {
-                    WriteStrings( Obj, ana_cnv_xstr( ANA_TT_SV ), v.first, Val );
-                },
-
-                [this, &Obj, &v]( TBytes Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_DAB ), v.first,
-                        std::make_unique<TJSONString>(
-                            Val.Length == 0 ?
-                              String()
-                            :
-                              base64_->EncodeBytesToString(
-                                  &Val[0], Val.High
-                              )
-                        )
+                }
+            }
+            else if ( State == TState::Node ) {
+                auto Frame = std::move( nodes_.back() );
+                nodes_.pop_back();
+                if ( nodes_.empty() ) {
+                    cfg_.GetRootNode().Populate(
+                        std::move( Frame.Values ), std::move( Frame.Nodes )
                     );
-                },
-
-                [this,&Obj, &v]( std::vector<Byte> const & Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_VB ), v.first,
-                        std::make_unique<TJSONString>(
-                            Val.empty() ?
-                              String()
-                            :
-                              //TNetEncoding::Base64->EncodeBytesToString(
-                              base64_->EncodeBytesToString(
-                                  Val.data(), Val.size() - 1
-                              )
-                        )
+                }
+                else {
+                    Frame.Node->Populate(
+                        std::move( Frame.Values ), std::move( Frame.Nodes )
                     );
-                },
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                [&Obj, &v]( std::string const & Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_STR ), v.first,
-                        std::make_unique<TJSONString>(
-                            UTF8ToString( Val.c_str() )
-                        )
+                    nodes_.back().Nodes.try_emplace(
+                        std::move( Frame.Name ), std::move( Frame.Node )
                     );
-                },
-
-                [&Obj, &v]( std::wstring const & Val ) {
-                    Write(
-                        Obj, ana_cnv_xstr( ANA_TT_WSTR ), v.first,
-                        std::make_unique<TJSONString>(
-                            String( Val.c_str() )
-                        )
+                }
+            }
+        }
+
+        bool StartArray() {
+            if ( states_.empty() ) {
+                return false;
+            }
+            switch ( states_.back() ) {
+                case TState::Wrapper:
+                    payload_.Kind = TKind::Array;
+                    payload_.Strings.clear();
+                    states_.push_back( TState::Array );
+                    return true;
+                case TState::Array:
+                    payload_.Kind = TKind::Bad;
+                    return false;
+                default:
+                    return false;
+            }
+        }
+
+        void EndArray() { states_.pop_back(); }
+
+        void String( std::string_view Text ) {
+            Scalar( TKind::Text, Text );
+        }
+
+        void Number( std::string_view Text ) {
+            Scalar( TKind::Number, Text );
+        }
+
+        void Bool( bool Value ) {
+            Scalar( TKind::Bool, Value ? "true" : "false" );
+        }
+
+        void Null() {
+            if ( !states_.empty() &&
+                 ( states_.back() == TState::Wrapper || states_.back() == TState::Array ) )
+            {
+                payload_.Kind = TKind::Bad;
+            }
+        }
+    private:
+        enum class TState { Node, Values, Nodes, Wrapper, Array };
+        enum class TKind { None, Text, Number, Bool, Array, Bad };
+
+        struct TNodeFrame {
+            TConfigNodePtr Node;    // empty for the root
+            System::String Name;
+            ValueContType Values;
+            NodeContType Nodes;
+            bool SeenValues {};
+            bool SeenNodes {};
+        };
+
+        // Payload of the { "<tag>": <payload> } wrapper being read.
+        struct TPayload {
+            TKind Kind { TKind::None };
+            int Pairs {};
+            std::string Text;
+            StringCont Strings;
+        };
+
+        // Decodes a payload as TValueCodec decodes the matching DOM value;
+        // the combinations it does not handle are left to the DOM reader.
+        struct TStreamCodec {
+            template<typename T>
+            T Decode( Codec::TAs<T> Tag, TPayload& Payload ) const {
+                switch ( Payload.Kind ) {
+                    case TKind::Text:
+                    case TKind::Number:
+                        return Codec::TTextCodec::Decode( Tag, FromUtf8( Payload.Text ) );
+                    case TKind::Bool:
+                        if constexpr ( std::is_same_v<T,bool> ) {
+                            return Payload.Text == "true";
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                throw EStreamFallback{};
+            }
+
+            StringCont Decode( Codec::TAs<StringCont>, TPayload& Payload ) const {
+                switch ( Payload.Kind ) {
+                    case TKind::Array: return std::move( Payload.Strings );
+                    case TKind::Text:
+                    case TKind::Number:
+                    case TKind::Bool:  return StringCont{};
+                    default:              throw EStreamFallback{};
+                }
+            }
+        };
+
+        TConfig& cfg_;
+        std::vector<TNodeFrame> nodes_;
+        std::vector<TState> states_;
+        TState member_ { TState::Values };  // of the member being entered
+        System::String name_;               // of the value or node being read
+        std::optional<TypeTag> tag_;
+        TPayload payload_;
+
+        void PushNode( TConfigNodePtr Node, System::String Name ) {
+            nodes_.push_back(
+                TNodeFrame{
+                    std::move( Node ), std::move( Name ),
+                    cfg_.NewValueList(), cfg_.NewNodeList()
+                }
+            );
+            states_.push_back( TState::Node );
+        }
+
+        void Scalar( TKind Kind, std::string_view Text ) {
+            if ( states_.empty() ) {
+                return;
+            }
+            switch ( states_.back() ) {
+                case TState::Values:
+                    PutItemTo(
+                        nodes_.back().Values, name_,
+                        { Implicit( Kind, Text ), Operation::None }
                     );
+                    break;
+                case TState::Wrapper:
+                    payload_.Kind = Kind;
+                    payload_.Text.assign( Text.data(), Text.size() );
+                    break;
+                case TState::Array:
+                    if ( Kind == TKind::Bool ) {
+                        payload_.Kind = TKind::Bad;
+                    }
+                    else {
+                        payload_.Strings.push_back( FromUtf8( Text ) );
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // An int, String or bool stored without a type tag.
+        static TConfigNodeValueType Implicit( TKind Kind,
+                                              std::string_view Text ) {
+            switch ( Kind ) {
+                case TKind::Text: return TConfigNodeValueType{ FromUtf8( Text ) };
+                case TKind::Bool: return TConfigNodeValueType{ Text == "true" };
+                default:             return TConfigNodeValueType{ ToInt( Text ) };
+            }
+        }
+
+        // Plain decimal integers in int range; anything else (fractions,
+        // exponents, overflow) goes through TJSONNumber::AsInt instead.
+        static int ToInt( std::string_view Text ) {
+            auto First = Text.begin();
+            bool const Negative = *First == '-';
+            if ( Negative ) { ++First; }
+            if ( Text.end() - First > 10 ) {
+                throw EStreamFallback{};
+            }
+            long long Value {};
+            for ( ; First != Text.end() ; ++First ) {
+                if ( *First < '0' || *First > '9' ) {
+                    throw EStreamFallback{};
                 }
-#endif
-            },
-            v.second.first
-        );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-#else
-#endif
+                Value = Value * 10 + ( *First - '0' );
+            }
+            if ( Negative ) { Value = -Value; }
+            if ( Value < std::numeric_limits<int>::min() ||
+                 Value > std::numeric_limits<int>::max() )
+            {
+                throw EStreamFallback{};
+            }
+            return static_cast<int>( Value );
+        }
+    };
+
+    // Eager load: parses the file straight into the tree, without
+    // building a TJSONObject document.  Returns false, with the root left
+    // empty, when the text is not UTF-8 JSON it can read on its own; the
+    // caller then loads it through the DOM.  In retain mode the text read
+    // is kept for StreamFlush.
+    bool StreamRootNode() {
+        if ( GetRetainDocumentFlag() ) {
+            textStamp_.Take( loadFileName_ );
+        }
+        auto Load = [this]( char const * First, char const * Last ) {
+            // Any failure, EStreamFallback or a decoding error, is
+            // reproduced (or handled) by the DOM reader.
+            try {
+                TStreamLoader Loader{ *this };
+                if ( Sax::Parse( First, Last, Loader ) ) {
+                    return true;
+                }
+            }
+            catch ( ... ) {
+            }
+            GetRootNode().Populate( NewValueList(), NewNodeList() );
+            textStamp_.Reset();
+            return false;
+        };
+        if ( cryptOptions_.Enabled ) {
+            auto Bytes = Crypt::LoadBytes( loadFileName_, cryptOptions_ );
+            auto const First = reinterpret_cast<char const *>( Bytes.data() );
+            if ( !Load( First, First + Bytes.size() ) ) {
+                return false;
+            }
+            if ( GetRetainDocumentFlag() ) {
+                text_ = std::move( Bytes );
+            }
+            return true;
+        }
+        auto Bytes = TFile::ReadAllBytes( loadFileName_ );
+        auto const First =
+            Bytes.Length ? reinterpret_cast<char const *>( &Bytes[0] ) : nullptr;
+        if ( !Load( First, First + Bytes.Length ) ) {
+            return false;
+        }
+        if ( GetRetainDocumentFlag() ) {
+            text_.assign( First, First + Bytes.Length );
+        }
+        return true;
     }
 
-protected:
-    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+    void LoadRootNode() {
+        if ( GetLazyLoadFlag() || !StreamRootNode() ) {
+            JSONObjRAII JSON{ *this };
+            ReadRootNode();
+        }
+    }
 
-        using Fn = std::function<TConfigNodeValueType(TJSONValue&)>;
+    // Sax::Parse handler writing the file being parsed back out, with the
+    // plan applied as DoSaveValueList and DoDeleteNode apply it to the
+    // document: the first pair of a value or node name is the one
+    // replaced or removed, what is missing is appended.  Members it has
+    // nothing to do with are copied, numbers verbatim.
+    template<typename S>
+    class TStreamFlusher {
+    public:
+        TStreamFlusher( TConfig& Cfg, TFlushPlan const & Plan, S& Sink )
+            : cfg_{ Cfg }, out_{ Sink, Cfg.compact_ ? 0 : 2 }
+            , next_{ TState::Node, &Plan }, nextForced_{ true } {}
 
-        static std::array<Fn,
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::variant_size<TConfigNodeValueType>::value
-#else
-            TConfigNodeValueType::types::size::value
-#endif
-        > Builders {
-            // TT_I
-            []( TJSONValue& Value ) {
-                return Value.GetValue<int>();
-            },
-
-            // TT_U
-            []( TJSONValue& Value ) {
-                return Value.GetValue<unsigned>();
-            },
-
-            // TT_L
-            []( TJSONValue& Value ) {
-                return static_cast<long>( Value.GetValue<__int64>() );
-            },
-
-            // TT_UL
-            []( TJSONValue& Value ) {
-                return static_cast<unsigned long>( Value.GetValue<__int64>() );
-            },
-
-            // TT_C
-            []( TJSONValue& Value ) {
-                return static_cast<char>( Value.GetValue<int>() );
-            },
-
-            // TT_UC
-            []( TJSONValue& Value ) {
-                return Value.GetValue<unsigned char>();
-            },
-
-            // TT_S
-            []( TJSONValue& Value ) {
-                return Value.GetValue<short>();
-            },
-
-            // TT_US
-            []( TJSONValue& Value ) {
-                return Value.GetValue<unsigned short>();
-            },
-
-            // TT_LL
-            []( TJSONValue& Value ) {
-                return Value.GetValue<__int64>();
-            },
-
-            // TT_ULL
-            []( TJSONValue& Value ) {
-                return std::stoull( Value.GetValue<String>().c_str() );
-            },
-
-            // TT_B
-            []( TJSONValue& Value ) {
-                return Value.GetValue<bool>();
-            },
-
-            // TT_SZ
-            []( TJSONValue& Value ) {
-                return Value.GetValue<String>();
-            },
-
-            // TT_DT
-            []( TJSONValue& Value ) {
-                return ISO8601ToDate( Value.GetValue<String>(), false );
-            },
-
-            // TT_FLT
-            []( TJSONValue& Value ) {
-                return Value.GetValue<float>();
-            },
-
-            // TT_DBL
-            []( TJSONValue& Value ) {
-                return Value.GetValue<double>();
-            },
-
-            // TT_CUR
-            []( TJSONValue& Value ) {
-                TFormatSettings FS;
-                FS.DecimalSeparator = _D( '.' );
-                return StrToCurr( Value.GetValue<String>(), FS );
-            },
-
-            // TT_SV
-            []( TJSONValue& Value ) {
-                StringCont Strings;
-                if ( auto JSONArr = dynamic_cast<TJSONArray*>( &Value ) ) {
-                    Strings.reserve( JSONArr->Count );
-                    std::transform(
-                        System::begin( JSONArr ), System::end( JSONArr ),
-                        std::back_inserter( Strings ),
-                        []( auto Val ){ return Val->template GetValue<String>(); }
-                    );
+        /// Writes the plan as a new document (there is no file yet).
+        void WriteDocument() { WriteNode( *next_.Plan ); }
+
+        bool StartObject() {
+            frames_.push_back( TakeNext( true ) );
+            out_.BeginObject();
+            return true;
+        }
+
+        bool Key( std::string_view Name ) {
+            auto& Frame = frames_.back();
+            switch ( Frame.State ) {
+                case TState::Node:
+                    if ( Name == "values" && !Frame.SeenValues ) {
+                        Frame.SeenValues = true;
+                        if ( Frame.Plan->Values ) {
+                            SetNext( TState::Values, Frame.Plan, Frame.Plan->Values->size() );
+                        }
+                    }
+                    else if ( Name == "nodes" && !Frame.SeenNodes ) {
+                        Frame.SeenNodes = true;
+                        if ( !Frame.Plan->Children.empty() ) {
+                            SetNext( TState::Nodes, Frame.Plan, Frame.Plan->Children.size() );
+                            nextForced_ = Frame.Plan->ChildForces;
+                        }
+                    }
+                    break;
+                case TState::Values:
+                    if ( !KeepValue( Frame, Name ) ) {
+                        return false;
+                    }
+                    break;
+                case TState::Nodes:
+                    if ( !KeepNode( Frame, Name ) ) {
+                        return false;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            out_.Name( Quote( Name, key_ ) );
+            return true;
+        }
+
+        void EndObject() {
+            auto const Frame = std::move( frames_.back() );
+            frames_.pop_back();
+            switch ( Frame.State ) {
+                case TState::Node:
+                    if ( Frame.Plan->Values && !Frame.SeenValues ) {
+                        WriteValues( *Frame.Plan );
+                    }
+                    if ( Frame.Plan->ChildForces && !Frame.SeenNodes ) {
+                        WriteNodes( *Frame.Plan );
+                    }
+                    break;
+                case TState::Values: {
+                    auto It = Frame.Plan->Values->begin();
+                    for ( auto Done : Frame.Marks ) {
+                        if ( !Done ) { WriteValue( *It ); }
+                        ++It;
+                    }
+                    break;
                 }
-                return Strings;
-            },
-
-            // TT_DAB
-            []( TJSONValue& Value ) {
-                return
-                    TNetEncoding::Base64->DecodeStringToBytes(
-                        Value.GetValue<String>()
-                    );
-            },
+                case TState::Nodes:
+                    for ( std::size_t Idx = 0 ; Idx < Frame.Marks.size() ; ++Idx ) {
+                        auto const & Child = Frame.Plan->Children[Idx];
+                        if ( Child.Forces && !( Frame.Marks[Idx] & Merged ) ) {
+                            out_.Name( Quote( Child.Name, key_ ) );
+                            WriteNode( Child );
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+            out_.EndObject();
+        }
+
+        bool StartArray() {
+            TakeNext( false );
+            frames_.emplace_back();
+            out_.BeginArray();
+            return true;
+        }
+
+        void EndArray() {
+            frames_.pop_back();
+            out_.EndArray();
+        }
+
+        void String( std::string_view Text ) {
+            TakeNext( false );
+            out_.Scalar( Quote( Text, token_ ) );
+        }
+
+        void Number( std::string_view Text ) {
+            TakeNext( false );
+            out_.Scalar( Text );
+        }
+
+        void Bool( bool Value ) {
+            TakeNext( false );
+            out_.Scalar( Value ? "true" : "false" );
+        }
+
+        void Null() {
+            TakeNext( false );
+            out_.Scalar( "null" );
+        }
+    private:
+        enum class TState { Copy, Node, Values, Nodes };
+
+        // Marks of a child in a Nodes frame.
+        static constexpr unsigned char Seen = 1;
+        static constexpr unsigned char Merged = 2;
+
+        struct TFrame {
+            TState State { TState::Copy };
+            TFlushPlan const * Plan {};
+            std::vector<unsigned char> Marks;   // per value or child of Plan
+            bool SeenValues {};
+            bool SeenNodes {};
+        };
+
+        TConfig& cfg_;
+        TTextWriter<S> out_;
+        std::vector<TFrame> frames_;
+        TFrame next_;               // frame of the object value coming next
+        bool nextForced_ {};        // that value must be an object
+        std::string key_;
+        std::string token_;
+
+        void SetNext( TState State, TFlushPlan const * Plan, std::size_t Marks ) {
+            next_.State = State;
+            next_.Plan = Plan;
+            next_.Marks.assign( Marks, 0 );
+        }
 
-            // TT_VB
-            []( TJSONValue& Value ) {
-                auto Bytes = TNetEncoding::Base64->DecodeStringToBytes(
-                    Value.GetValue<String>()
+        // Where the DOM writer would force a node or "nodes" object and
+        // finds another kind of value, it goes astray; so does this.
+        TFrame TakeNext( bool IsObject ) {
+            if ( nextForced_ && !IsObject ) {
+                throw EStreamFallback{};
+            }
+            nextForced_ = false;
+            return std::exchange( next_, TFrame{} );
+        }
+
+        // The first pair of a value in the list is replaced, when it is
+        // written, or dropped, when it is erased.
+        bool KeepValue( TFrame& Frame, std::string_view Name ) {
+            auto const & Values = *Frame.Plan->Values;
+            auto const It = Values.find( FromUtf8( Name ) );
+            if ( It == Values.end() ) {
+                return true;
+            }
+            auto& Done = Frame.Marks[It - Values.begin()];
+            if ( Done ) {
+                return true;
+            }
+            Done = 1;
+            if ( IsWritten( *It ) ) {
+                out_.Name( Quote( Name, key_ ) );
+                Codec::Encode( It->second.first, TTokenCodec{ *this } );
+                return false;
+            }
+            return It->second.second != Operation::Erase;
+        }
+
+        // The first pair of a child is dropped when the child is deleted,
+        // or else merged with it.
+        bool KeepNode( TFrame& Frame, std::string_view Name ) {
+            auto const & Children = Frame.Plan->Children;
+            auto const Key = FromUtf8( Name );
+            auto const It =
+                std::lower_bound(
+                    Children.begin(), Children.end(), Key,
+                    []( TFlushPlan const & Lhs, System::String const & Rhs ) {
+                        return TKeyLess{}( Lhs.Name, Rhs );
+                    }
                 );
-                std::vector<Byte> VBytes;
-                VBytes.reserve( Bytes.Length );
-                std::copy(
-                    std::begin( Bytes ),
-                    std::end( Bytes ),
-                    std::back_inserter( VBytes )
+            if ( It == Children.end() || TKeyLess{}( Key, It->Name ) ) {
+                return true;
+            }
+            auto& Marks = Frame.Marks[It - Children.begin()];
+            if ( Marks & Seen ) {
+                // Once the first pair is removed, the DOM writer takes this
+                // one for the rest of a deleted child's changes.
+                if ( It->Deleted && ( It->Forces || !It->Children.empty() ) ) {
+                    throw EStreamFallback{};
+                }
+                return true;
+            }
+            Marks |= Seen;
+            if ( It->Deleted ) {
+                return false;
+            }
+            Marks |= Merged;
+            SetNext( TState::Node, &*It, 0 );
+            nextForced_ = It->Forces;
+            return true;
+        }
+
+        bool IsWritten( ValueContType::value_type const & Value ) const {
+            return cfg_.GetAlwaysFlushNodeFlag() ||
+                   Value.second.second == Operation::Write;
+        }
+
+        void WriteValue( ValueContType::value_type const & Value ) {
+            if ( IsWritten( Value ) ) {
+                out_.Name( Quote( Value.first, key_ ) );
+                Codec::Encode( Value.second.first, TTokenCodec{ *this } );
+            }
+        }
+
+        void WriteValues( TFlushPlan const & Plan ) {
+            out_.Name( "\"values\"" );
+            out_.BeginObject();
+            for ( auto const & Value : *Plan.Values ) {
+                WriteValue( Value );
+            }
+            out_.EndObject();
+        }
+
+        void WriteNodes( TFlushPlan const & Plan ) {
+            out_.Name( "\"nodes\"" );
+            out_.BeginObject();
+            for ( auto const & Child : Plan.Children ) {
+                if ( Child.Forces ) {
+                    out_.Name( Quote( Child.Name, key_ ) );
+                    WriteNode( Child );
+                }
+            }
+            out_.EndObject();
+        }
+
+        void WriteNode( TFlushPlan const & Plan ) {
+            out_.BeginObject();
+            if ( Plan.Values ) {
+                WriteValues( Plan );
+            }
+            if ( Plan.ChildForces ) {
+                WriteNodes( Plan );
+            }
+            out_.EndObject();
+        }
+
+        // Renders a string as TJSONString does: printable ASCII other than
+        // '/' is quoted here, anything needing escapes is left to the RTL.
+        template<typename C>
+        std::string_view Quote( C const * First, C const * Last,
+                                std::string& Buffer ) {
+            if ( std::all_of(
+                    First, Last,
+                    []( C Ch ){ return Ch >= 0x20 && Ch < 0x7F && Ch != '/'; }
+                 ) )
+            {
+                Buffer.assign( 1, '"' );
+                for ( ; First != Last ; ++First ) {
+                    if ( *First == '"' || *First == '\\' ) {
+                        Buffer += '\\';
+                    }
+                    Buffer += static_cast<char>( *First );
+                }
+                Buffer += '"';
+            }
+            else if constexpr ( std::is_same_v<C,char> ) {
+                cfg_.RenderString( FromUtf8( std::string_view( First, Last - First ) ), Buffer );
+            }
+            else {
+                cfg_.RenderString( System::String( First, Last - First ), Buffer );
+            }
+            return Buffer;
+        }
+
+        std::string_view Quote( std::string_view Text, std::string& Buffer ) {
+            return Quote( Text.data(), Text.data() + Text.size(), Buffer );
+        }
+
+        std::string_view Quote( System::String const & Text, std::string& Buffer ) {
+            auto const First = Text.c_str();
+            return Quote( First, First + Text.Length(), Buffer );
+        }
+
+        std::string_view Quote( char const * Tag ) {
+            return Quote( std::string_view( Tag ), key_ );
+        }
+
+        std::string_view Integer( long long Value ) {
+            char Digits[24];
+            auto const Last = std::end( Digits );
+            auto First = Last;
+            auto Magnitude =
+                Value < 0
+                    ? 0ULL - static_cast<unsigned long long>( Value )
+                    : static_cast<unsigned long long>( Value );
+            do {
+                *--First = static_cast<char>( '0' + Magnitude % 10 );
+                Magnitude /= 10;
+            } while ( Magnitude );
+            if ( Value < 0 ) { *--First = '-'; }
+            token_.assign( First, Last );
+            return token_;
+        }
+
+        void Tagged( char const * Tag, std::string_view Payload ) {
+            out_.BeginObject();
+            out_.Name( Quote( Tag ) );
+            out_.Scalar( Payload );
+            out_.EndObject();
+        }
+
+        // Renders a new value as TValueCodec encodes it.
+        struct TTokenCodec {
+            TStreamFlusher& F;
+
+            template<typename T>
+            void EncodeNumber( long long Val ) const {
+                F.Tagged( Codec::TagName<T>(), F.Integer( Val ) );
+            }
+
+            template<typename T>
+            void EncodeText( T const & Val ) const {
+                F.Tagged(
+                    Codec::TagName<T>(),
+                    F.Quote( Codec::TTextCodec::Encode( Codec::TAs<T>{}, Val ), F.token_ )
                 );
-                return VBytes;
-            },
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            // TT_STR  – JSON string decoded as UTF-8 std::string (bcc64x only)
-            []( TJSONValue& Value ) {
-                return std::string(
-                    UTF8Encode( Value.GetValue<String>() ).c_str()
+            }
+
+            template<typename T>
+            void EncodeReal( T Val ) const {
+                F.cfg_.RenderDouble( Val, F.token_ );
+                F.Tagged( Codec::TagName<T>(), F.token_ );
+            }
+
+            void EncodeBytes( char const * Tag, Byte const * Data, int High ) const {
+                F.Tagged(
+                    Tag,
+                    F.Quote(
+                        High < 0 ? System::String() : TValueCodec{ F.cfg_ }.EncodeBytes( Data, High ),
+                        F.token_
+                    )
                 );
-            },
+            }
 
-            // TT_WSTR – JSON string decoded as UTF-16 std::wstring (bcc64x only)
-            []( TJSONValue& Value ) {
-                auto s = Value.GetValue<String>();
-                return std::wstring( s.c_str() );
-            },
-#endif
+            void Encode( Codec::TAs<int>, int Val ) const {
+                if ( F.cfg_.explicitTypes_ ) { EncodeNumber<int>( Val ); }
+                else { F.out_.Scalar( F.Integer( Val ) ); }
+            }
+
+            void Encode( Codec::TAs<unsigned int>, unsigned int Val ) const {
+                EncodeNumber<unsigned int>( Val );
+            }
+
+            void Encode( Codec::TAs<long>, long Val ) const {
+                EncodeNumber<long>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned long>, unsigned long Val ) const {
+                EncodeNumber<unsigned long>( Val );
+            }
+
+            void Encode( Codec::TAs<char>, char Val ) const {
+                EncodeNumber<char>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned char>, unsigned char Val ) const {
+                EncodeNumber<unsigned char>( Val );
+            }
+
+            void Encode( Codec::TAs<short>, short Val ) const {
+                EncodeNumber<short>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned short>, unsigned short Val ) const {
+                EncodeNumber<unsigned short>( Val );
+            }
+
+            void Encode( Codec::TAs<long long>, long long Val ) const {
+                EncodeNumber<long long>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned long long>, unsigned long long Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<bool>, bool Val ) const {
+                auto const Token = Val ? "true" : "false";
+                if ( F.cfg_.explicitTypes_ ) { F.Tagged( Codec::TagName<bool>(), Token ); }
+                else { F.out_.Scalar( Token ); }
+            }
+
+            void Encode( Codec::TAs<System::String>, System::String const & Val ) const {
+                auto const Token = F.Quote( Val, F.token_ );
+                if ( F.cfg_.explicitTypes_ ) { F.Tagged( Codec::TagName<System::String>(), Token ); }
+                else { F.out_.Scalar( Token ); }
+            }
+
+            void Encode( Codec::TAs<TDateTime>, TDateTime Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<float>, float Val ) const {
+                EncodeReal( Val );
+            }
+
+            void Encode( Codec::TAs<double>, double Val ) const {
+                EncodeReal( Val );
+            }
+
+            void Encode( Codec::TAs<Currency>, Currency Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<StringCont>, StringCont const & Val ) const {
+                F.out_.BeginObject();
+                F.out_.Name( F.Quote( Codec::TagName<StringCont>() ) );
+                F.out_.BeginArray();
+                for ( auto const & Item : Val ) {
+                    F.out_.Scalar( F.Quote( Item, F.token_ ) );
+                }
+                F.out_.EndArray();
+                F.out_.EndObject();
+            }
+
+            void Encode( Codec::TAs<TBytes>, TBytes Val ) const {
+                EncodeBytes(
+                    Codec::TagName<TBytes>(),
+                    Val.Length ? &Val[0] : nullptr, Val.Length ? Val.High : -1
+                );
+            }
+
+            void Encode( Codec::TAs<BytesCont>, BytesCont const & Val ) const {
+                EncodeBytes(
+                    Codec::TagName<BytesCont>(),
+                    Val.data(), static_cast<int>( Val.size() ) - 1
+                );
+            }
+
+            void Encode( Codec::TAs<std::string>, std::string const & Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<std::wstring>, std::wstring const & Val ) const {
+                EncodeText( Val );
+            }
         };
+    };
+
+    // A string or number rendered as the document would render it.
+    void RenderScalar( TJSONValue& Value, std::string& Buffer ) const {
+        auto const Text = UTF8Encode( compact_ ? Value.ToJSON() : Value.Format( 2 ) );
+        Buffer.assign( Text.c_str(), Text.Length() );
+    }
+
+    void RenderString( String const & Text, std::string& Buffer ) const {
+        RenderScalar( *std::make_unique<TJSONString>( Text ), Buffer );
+    }
+
+    void RenderDouble( double Number, std::string& Buffer ) const {
+        RenderScalar( *std::make_unique<TJSONNumber>( Number ), Buffer );
+    }
+
+    // Buffered output to a new file.
+    class TFileSink {
+    public:
+        explicit TFileSink( String const & FileName )
+            : stream_{ new TFileStream( FileName, fmCreate ) }
+        {
+            buffer_.reserve( Capacity );
+        }
+
+        void Append( char const * Data, std::size_t Length ) {
+            if ( buffer_.size() + Length > Capacity ) {
+                Flush();
+                if ( Length >= Capacity ) {
+                    stream_->WriteBuffer( Data, static_cast<NativeInt>( Length ) );
+                    return;
+                }
+            }
+            buffer_.insert( buffer_.end(), Data, Data + Length );
+        }
 
-        ValueContType Values;
+        void Flush() {
+            if ( !buffer_.empty() ) {
+                stream_->WriteBuffer(
+                    buffer_.data(), static_cast<NativeInt>( buffer_.size() )
+                );
+                buffer_.clear();
+            }
+        }
+    private:
+        static constexpr std::size_t Capacity = 64 * 1024;
+
+        std::unique_ptr<TFileStream> stream_;
+        std::vector<char> buffer_;
+    };
+
+    // Input of Sax::ParseStream: a file read a buffer at a time.
+    class TFileSource {
+    public:
+        explicit TFileSource( String const & FileName )
+            : stream_{ new TFileStream( FileName, fmOpenRead | fmShareDenyWrite ) } {}
+
+        std::size_t Read( char* Buffer, std::size_t Size ) {
+            return
+                static_cast<std::size_t>(
+                    stream_->Read( Buffer, static_cast<int>( Size ) )
+                );
+        }
+    private:
+        std::unique_ptr<TFileStream> stream_;
+    };
+
+    void ForceFileDirectory() const {
+        if ( !TFile::Exists( fileName_ ) ) {
+            auto Path = TPath::GetFullPath( TPath::GetDirectoryName( fileName_ ) );
+            if ( !TDirectory::Exists( Path ) ) {
+                TDirectory::CreateDirectory( Path );
+            }
+        }
+    }
+
+    // Creates an empty file with a name of its own in the directory of the
+    // target, for the flush to write into before it replaces the target;
+    // another flush of the same file, or a file the user left there, is
+    // never overwritten.  Empty when none can be made there.
+    String MakeTempFileName() const {
+        auto const Dir = TPath::GetDirectoryName( TPath::GetFullPath( fileName_ ) );
+        wchar_t Name[MAX_PATH];
+        if ( !::GetTempFileNameW( Dir.c_str(), L"ana", 0, Name ) ) {
+            return String();
+        }
+        return Name;
+    }
+
+    // Moves the file written next to the target over it in one step, so
+    // that a failure leaves either the old file or the new one.
+    static void MoveOverFile( String const & From, String const & To ) {
+        Win32Check(
+            ::MoveFileExW(
+                From.c_str(), To.c_str(),
+                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH
+            )
+        );
+    }
+
+    // Eager flush: writes the file as DoFlush through the document would,
+    // without building the document.  The file as loaded is parsed again,
+    // a buffer at a time, and copied out with the changes merged in, in a
+    // single pass: into a temporary file next to the target, which then
+    // replaces it, or into memory when the text is to be encrypted or
+    // retained.  An encrypted file is decrypted as a whole first.  Returns
+    // false, with the target untouched, when it leaves the flush to the
+    // DOM writer.  In retain mode the text written is kept as the next
+    // flush's input, which then reads the file only if it has changed
+    // since.  The layout is TTextWriter's, which follows the RTL's.
+    bool StreamFlush() {
+        TFlushPlanner Planner{ GetAlwaysFlushNodeFlag() };
+        GetRootNode().Write( Planner, TConfigPath{} );
+        if ( !Planner.IsPortable() ) {
+            return false;
+        }
+
+        bool const Retain = GetRetainDocumentFlag();
+        bool const HasFile = TFile::Exists( loadFileName_ );
+        bool const Retained = textStamp_.Matches( loadFileName_ );
+
+        // False when the text is not one this flush can rewrite.
+        auto Render = [&]( auto& Sink ) {
+            using SinkType = std::remove_reference_t<decltype( Sink )>;
+            try {
+                TStreamFlusher<SinkType> Flusher{ *this, Planner.GetPlan(), Sink };
+                if ( !HasFile ) {
+                    Flusher.WriteDocument();
+                    return true;
+                }
+                if ( Retained || cryptOptions_.Enabled ) {
+                    Crypt::Bytes Crypted;
+                    if ( !Retained ) {
+                        Crypted = Crypt::LoadBytes( loadFileName_, cryptOptions_ );
+                    }
+                    auto const & Text = Retained ? text_ : Crypted;
+                    auto const First = reinterpret_cast<char const *>( Text.data() );
+                    return
+                        static_cast<bool>(
+                            Sax::Parse( First, First + Text.size(), Flusher )
+                        );
+                }
+                TFileSource Source{ loadFileName_ };
+                return static_cast<bool>( Sax::ParseStream( Source, Flusher ) );
+            }
+            catch ( EStreamFallback const & ) {
+                return false;
+            }
+        };
+
+        Crypt::Bytes Text;
+        if ( cryptOptions_.Enabled || Retain ) {
+            TMemorySink<Crypt::Bytes> Sink{ Text };
+            if ( !Render( Sink ) ) {
+                return false;
+            }
+        }
+
+        // From here on the file no longer matches anything retained.
+        textStamp_.Reset();
+        documentStamp_.Reset();
+        ForceFileDirectory();
+        if ( cryptOptions_.Enabled ) {
+            Crypt::SaveBytes( fileName_, Text, cryptOptions_ );
+        }
+        else {
+            auto const TempFileName = MakeTempFileName();
+            if ( TempFileName.IsEmpty() ) {
+                return false;
+            }
+            try {
+                bool Rendered {};
+                {
+                    TFileSink Sink{ TempFileName };
+                    if ( Retain ) {
+                        Sink.Append(
+                            reinterpret_cast<char const *>( Text.data() ), Text.size()
+                        );
+                        Rendered = true;
+                    }
+                    else {
+                        Rendered = Render( Sink );
+                    }
+                    if ( Rendered ) {
+                        Sink.Flush();
+                    }
+                }
+                if ( !Rendered ) {
+                    TFile::Delete( TempFileName );
+                    return false;
+                }
+                MoveOverFile( TempFileName, fileName_ );
+            }
+            catch ( ... ) {
+                ::DeleteFileW( TempFileName.c_str() );
+                throw;
+            }
+        }
+        if ( Retain ) {
+            document_.reset();
+            text_ = std::move( Text );
+            textStamp_.Take( fileName_ );
+        }
+        return true;
+    }
+
+protected:
+    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+
+        auto Values = NewValueList();
 
         if ( auto Key = OpenValues( Path ) ) {
             for ( int Idx = 0 ; Idx < Key->Count ; ++Idx ) {
@@ -642,7 +1617,8 @@ protected:
                                 PutItemTo(
                                     Values, Pair->JsonString->Value(),
                                     {
-                                        Builders[static_cast<size_t>( Result.value() )](
+                                        Codec::Decode(
+                                            Result.value(), TValueCodec{ *this },
                                             *InnerPair->JsonValue
                                         ),
                                         Operation::None
@@ -686,14 +1662,14 @@ protected:
     }
 
     virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
-        NodeContType Nodes;
+        auto Nodes = NewNodeList();
 
         if ( auto Node = OpenNodes( Path ) ) {
             for ( int Idx = 0 ; Idx < Node->Count ; ++Idx ) {
                 auto const & Pair = Node->Pairs[Idx];
                 if ( dynamic_cast<TJSONObject*>( Pair->JsonValue ) ) {
                     auto NodeName = Pair->JsonString->Value();
-                    Nodes[NodeName] = std::move( std::make_unique<TConfigNode>() );
+                    Nodes[NodeName] = NewNode();
                 }
             }
         }
@@ -718,29 +1694,43 @@ protected:
 
     virtual void DoDeleteNode( TConfigPath const & Path ) override {
         if ( !Path.empty() ) {
-            auto Last = std::end( Path );
-            std::advance( Last, -1 );
-            TConfigPath TmpPath( std::begin( Path ), Last );
-            if ( auto Node = OpenNodes( TmpPath ) ) {
+            if ( auto Node = OpenNodes( Path, Path.size() - 1 ) ) {
                 Node->RemovePair( Path.back() );
             }
+            cursor_.Invalidate( Path );
         }
     }
 
+    virtual void DoEnterNode( String const & Name ) override {
+        cursor_.Enter( Name );
+    }
+
+    virtual void DoLeaveNode() noexcept override { cursor_.Leave(); }
+
+    virtual void DoBeginLazyRead() override {
+        if ( !document_ ) { CreateJSONObject(); }
+    }
+
     virtual void DoFlush() override {
+        if ( !GetLazyLoadFlag() && StreamFlush() ) {
+            return;
+        }
+
         JSONObjRAII JSON{ *this };
+        // Until it is saved, the document no longer mirrors the file.
+        documentStamp_.Reset();
         GetRootNode().Write( *this, TConfigPath{} );
 
-        if ( !TFile::Exists( fileName_ ) ) {
-            auto Path = TPath::GetFullPath( TPath::GetDirectoryName( fileName_ ) );
-            if ( !TDirectory::Exists( Path ) ) {
-                TDirectory::CreateDirectory( Path );
-            }
-        }
+        ForceFileDirectory();
         WriteFileText(
             fileName_,
             compact_ ? document_->ToJSON() : document_->Format( 2 )
         );
+        if ( GetRetainDocumentFlag() ) {
+            textStamp_.Reset();
+            text_ = Crypt::Bytes{};
+            documentStamp_.Take( fileName_ );
+        }
     }
 
     virtual bool DoGetForcedWritesFlag() const {
@@ -15,30 +15,34 @@ class TConfig : public JSON::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false, bool Compact = true,
              bool FlushAllItems = false, bool ExplicitTypes = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             TConfigOptions CfgOptions = {} )
         : JSON::TConfig(
-            FileName, ReadOnly, Compact, FlushAllItems, ExplicitTypes, Options
+            FileName, ReadOnly, Compact, FlushAllItems, ExplicitTypes, Options,
+            CfgOptions
           )
     {}
 
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false, bool Compact = true,
              bool ExplicitTypes = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             TConfigOptions CfgOptions = {} )
         : JSON::TConfig(
             LoadFileName, SaveFileName, ReadOnly, Compact, ExplicitTypes,
-            Options
+            Options, CfgOptions
           )
     {}
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false, bool Compact = true,
                             bool ExplicitTypes = false,
-                            Crypt::TOptions Options = Crypt::TOptions::Default() )
+                            Crypt::TOptions Options = Crypt::TOptions::Default(),
+                            TConfigOptions CfgOptions = {} )
     {
         return TConfig(
             LoadFileName, SaveFileName, ReadOnly, Compact, ExplicitTypes,
-            Options
+            Options, CfgOptions
         );
     }
 };
@@ -0,0 +1,521 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgJSONSaxH
+#define CfgJSONSaxH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_json_sax.cpp).
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace JSON {
+//---------------------------------------------------------------------------
+namespace Sax {
+//---------------------------------------------------------------------------
+
+/// Nesting limit used by @ref Parse unless the caller passes another.
+inline constexpr std::size_t DefaultMaxDepth = 512;
+
+/// Size of the buffer @ref ParseStream reads into unless the caller
+/// passes another.
+inline constexpr std::size_t DefaultBufferSize = 64 * 1024;
+
+/// Outcome of @ref Parse.
+struct TResult {
+    char const * Error {};      ///< static message; @c nullptr on success
+    std::size_t Offset {};      ///< byte offset at which parsing stopped
+
+    explicit operator bool() const noexcept { return !Error; }
+};
+
+namespace Detail {
+
+// Source of a parse over text that is all in memory.
+struct TNoSource {};
+
+template<typename H, typename S = TNoSource>
+class TParser {
+public:
+    TParser( char const * First, char const * Last, H& Handler,
+             std::size_t MaxDepth )
+      : first_{ First }, cur_{ First }, last_{ Last }
+      , handler_{ Handler }, maxDepth_{ MaxDepth }
+    {}
+
+    TParser( S& Source, std::size_t BufferSize, H& Handler,
+             std::size_t MaxDepth )
+      : handler_{ Handler }, maxDepth_{ MaxDepth }
+      , source_{ &Source }, buffer_( BufferSize ? BufferSize : 1 )
+    {
+        first_ = cur_ = last_ = buffer_.data();
+    }
+
+    TResult Run() {
+        while ( last_ - cur_ < 3 && Refill() ) {
+        }
+        if ( last_ - cur_ >= 3 &&
+             static_cast<unsigned char>( cur_[0] ) == 0xEF &&
+             static_cast<unsigned char>( cur_[1] ) == 0xBB &&
+             static_cast<unsigned char>( cur_[2] ) == 0xBF )
+        {
+            cur_ += 3;
+        }
+        SkipSpace();
+        if ( Value<true>() ) {
+            SkipSpace();
+            if ( cur_ != last_ ) {
+                Fail( "unexpected data after the document" );
+            }
+        }
+        return
+            TResult{
+                error_, consumed_ + static_cast<std::size_t>( cur_ - first_ )
+            };
+    }
+private:
+    static constexpr bool Streamed = !std::is_same_v<S,TNoSource>;
+
+    char const * first_ {};
+    char const * cur_ {};
+    char const * last_ {};
+    H& handler_;
+    std::size_t maxDepth_;
+    std::size_t depth_ {};
+    char const * error_ {};
+    std::string scratch_;       // unescaped text of the last string
+    S* source_ {};
+    std::vector<char> buffer_;  // streamed input
+    std::size_t consumed_ {};   // bytes of it dropped from the buffer
+    bool exhausted_ {};
+
+    bool Fail( char const * Error ) {
+        if ( !error_ ) { error_ = Error; }
+        return false;
+    }
+
+    // Streamed input: moves what is left of the buffer to its front,
+    // doubling the buffer when that is all of it, and reads more behind
+    // it.  Called only between tokens, or by Prepare before a scalar is
+    // read, so no view handed to the handler is still in use.
+    bool Refill() {
+        if constexpr ( Streamed ) {
+            if ( exhausted_ ) {
+                return false;
+            }
+            auto const Left = static_cast<std::size_t>( last_ - cur_ );
+            consumed_ += static_cast<std::size_t>( cur_ - first_ );
+            std::memmove( buffer_.data(), cur_, Left );
+            if ( Left == buffer_.size() ) {
+                buffer_.resize( buffer_.size() * 2 );
+            }
+            auto const Read =
+                source_->Read( buffer_.data() + Left, buffer_.size() - Left );
+            first_ = cur_ = buffer_.data();
+            last_ = cur_ + Left + Read;
+            exhausted_ = !Read;
+            return Read != 0;
+        }
+        else {
+            return false;
+        }
+    }
+
+    // Streamed input: brings the whole scalar starting at cur_ into the
+    // buffer, so that it is read, and handed out, in one piece.
+    void Prepare() {
+        if constexpr ( Streamed ) {
+            if ( *cur_ == '{' || *cur_ == '[' ) {
+                return;
+            }
+            bool const Quoted = *cur_ == '"';
+            std::size_t Scanned = 1;
+            for ( ;; ) {
+                auto Pos = cur_ + Scanned;
+                if ( Quoted ) {
+                    for ( ; Pos != last_ ; ++Pos ) {
+                        if ( *Pos == '"' ) {
+                            return;
+                        }
+                        if ( *Pos == '\\' ) {
+                            if ( last_ - Pos < 2 ) { break; }
+                            ++Pos;
+                        }
+                    }
+                }
+                else {
+                    while ( Pos != last_ && IsScalarChar( *Pos ) ) { ++Pos; }
+                    if ( Pos != last_ ) {
+                        return;
+                    }
+                }
+                Scanned = static_cast<std::size_t>( Pos - cur_ );
+                if ( !Refill() ) {
+                    return;
+                }
+            }
+        }
+    }
+
+    static bool IsScalarChar( char Ch ) noexcept {
+        return
+            ( Ch >= '0' && Ch <= '9' ) || ( Ch >= 'a' && Ch <= 'z' ) ||
+            ( Ch >= 'A' && Ch <= 'Z' ) || Ch == '-' || Ch == '+' || Ch == '.';
+    }
+
+    void SkipSpace() {
+        for ( ;; ) {
+            while ( cur_ != last_ &&
+                    ( *cur_ == ' ' || *cur_ == '\n' || *cur_ == '\r' || *cur_ == '\t' ) )
+            {
+                ++cur_;
+            }
+            if ( cur_ != last_ || !Refill() ) {
+                return;
+            }
+        }
+    }
+
+    bool Consume( char Ch ) noexcept {
+        if ( cur_ != last_ && *cur_ == Ch ) {
+            ++cur_;
+            return true;
+        }
+        return false;
+    }
+
+    // Emit selects between reporting to the handler and only validating
+    // (for containers the handler asked to skip).
+    template<bool Emit>
+    bool Value() {
+        if ( cur_ == last_ ) {
+            return Fail( "unexpected end of data" );
+        }
+        Prepare();
+        switch ( *cur_ ) {
+            case '{': return Object<Emit>();
+            case '[': return Array<Emit>();
+            case '"': {
+                std::string_view Text;
+                if ( !String( Text ) ) { return false; }
+                if constexpr ( Emit ) { handler_.String( Text ); }
+                return true;
+            }
+            case 't': return Literal<Emit>( "true", 4 );
+            case 'f': return Literal<Emit>( "false", 5 );
+            case 'n': return Literal<Emit>( "null", 4 );
+            default:  return Number<Emit>();
+        }
+    }
+
+    template<bool Emit>
+    bool Object() {
+        if ( ++depth_ > maxDepth_ ) {
+            return Fail( "nesting too deep" );
+        }
+        ++cur_;
+        bool Report = Emit;
+        if constexpr ( Emit ) { Report = handler_.StartObject(); }
+        return Report ? Members<true>() : Members<false>();
+    }
+
+    template<bool Emit>
+    bool Members() {
+        SkipSpace();
+        if ( !Consume( '}' ) ) {
+            for ( ;; ) {
+                if ( cur_ == last_ || *cur_ != '"' ) {
+                    return Fail( "expected a member name" );
+                }
+                Prepare();
+                std::string_view Name;
+                if ( !String( Name ) ) { return false; }
+                // Reported before the input moves on, which for streamed
+                // input may overwrite the name.
+                bool Member = Emit;
+                if constexpr ( Emit ) { Member = handler_.Key( Name ); }
+                SkipSpace();
+                if ( !Consume( ':' ) ) {
+                    return Fail( "expected ':'" );
+                }
+                SkipSpace();
+                if ( !( Member ? Value<Emit>() : Value<false>() ) ) {
+                    return false;
+                }
+                SkipSpace();
+                if ( Consume( '}' ) ) { break; }
+                if ( !Consume( ',' ) ) {
+                    return Fail( "expected ',' or '}'" );
+                }
+                SkipSpace();
+            }
+        }
+        --depth_;
+        if constexpr ( Emit ) { handler_.EndObject(); }
+        return true;
+    }
+
+    template<bool Emit>
+    bool Array() {
+        if ( ++depth_ > maxDepth_ ) {
+            return Fail( "nesting too deep" );
+        }
+        ++cur_;
+        bool Report = Emit;
+        if constexpr ( Emit ) { Report = handler_.StartArray(); }
+        return Report ? Elements<true>() : Elements<false>();
+    }
+
+    template<bool Emit>
+    bool Elements() {
+        SkipSpace();
+        if ( !Consume( ']' ) ) {
+            for ( ;; ) {
+                if ( !Value<Emit>() ) { return false; }
+                SkipSpace();
+                if ( Consume( ']' ) ) { break; }
+                if ( !Consume( ',' ) ) {
+                    return Fail( "expected ',' or ']'" );
+                }
+                SkipSpace();
+            }
+        }
+        --depth_;
+        if constexpr ( Emit ) { handler_.EndArray(); }
+        return true;
+    }
+
+    template<bool Emit>
+    bool Literal( char const * Text, std::size_t Length ) {
+        if ( static_cast<std::size_t>( last_ - cur_ ) < Length ||
+             std::string_view( cur_, Length ) != std::string_view( Text, Length ) )
+        {
+            return Fail( "invalid literal" );
+        }
+        cur_ += Length;
+        if constexpr ( Emit ) {
+            if ( *Text == 'n' ) { handler_.Null(); }
+            else { handler_.Bool( *Text == 't' ); }
+        }
+        return true;
+    }
+
+    bool Digits() noexcept {
+        auto const Start = cur_;
+        while ( cur_ != last_ && *cur_ >= '0' && *cur_ <= '9' ) { ++cur_; }
+        return cur_ != Start;
+    }
+
+    template<bool Emit>
+    bool Number() {
+        auto const Start = cur_;
+        Consume( '-' );
+        if ( Consume( '0' ) ) {
+        }
+        else if ( !Digits() ) {
+            return Fail( "invalid value" );
+        }
+        if ( Consume( '.' ) && !Digits() ) {
+            return Fail( "invalid number" );
+        }
+        if ( cur_ != last_ && ( *cur_ == 'e' || *cur_ == 'E' ) ) {
+            ++cur_;
+            if ( !Consume( '+' ) ) { Consume( '-' ); }
+            if ( !Digits() ) {
+                return Fail( "invalid number" );
+            }
+        }
+        if constexpr ( Emit ) {
+            handler_.Number(
+                std::string_view( Start, static_cast<std::size_t>( cur_ - Start ) )
+            );
+        }
+        return true;
+    }
+
+    static int HexDigit( char Ch ) noexcept {
+        if ( Ch >= '0' && Ch <= '9' ) { return Ch - '0'; }
+        if ( Ch >= 'a' && Ch <= 'f' ) { return Ch - 'a' + 10; }
+        if ( Ch >= 'A' && Ch <= 'F' ) { return Ch - 'A' + 10; }
+        return -1;
+    }
+
+    // Stops at the first character that is not a hex digit.
+    bool Hex4( std::uint32_t& Unit ) noexcept {
+        Unit = 0;
+        for ( int Idx = 0 ; Idx < 4 ; ++Idx ) {
+            auto const Digit = cur_ != last_ ? HexDigit( *cur_ ) : -1;
+            if ( Digit < 0 ) { return false; }
+            ++cur_;
+            Unit = Unit * 16 + static_cast<std::uint32_t>( Digit );
+        }
+        return true;
+    }
+
+    void AppendUtf8( std::uint32_t Code ) {
+        if ( Code < 0x80 ) {
+            scratch_ += static_cast<char>( Code );
+        }
+        else if ( Code < 0x800 ) {
+            scratch_ += static_cast<char>( 0xC0 | ( Code >> 6 ) );
+            scratch_ += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else if ( Code < 0x10000 ) {
+            scratch_ += static_cast<char>( 0xE0 | ( Code >> 12 ) );
+            scratch_ += static_cast<char>( 0x80 | ( ( Code >> 6 ) & 0x3F ) );
+            scratch_ += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else {
+            scratch_ += static_cast<char>( 0xF0 | ( Code >> 18 ) );
+            scratch_ += static_cast<char>( 0x80 | ( ( Code >> 12 ) & 0x3F ) );
+            scratch_ += static_cast<char>( 0x80 | ( ( Code >> 6 ) & 0x3F ) );
+            scratch_ += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+    }
+
+    bool Escape() {
+        if ( cur_ == last_ ) {
+            return Fail( "unterminated string" );
+        }
+        switch ( *cur_++ ) {
+            case '"':  scratch_ += '"';  return true;
+            case '\\': scratch_ += '\\'; return true;
+            case '/':  scratch_ += '/';  return true;
+            case 'b':  scratch_ += '\b'; return true;
+            case 'f':  scratch_ += '\f'; return true;
+            case 'n':  scratch_ += '\n'; return true;
+            case 'r':  scratch_ += '\r'; return true;
+            case 't':  scratch_ += '\t'; return true;
+            case 'u': {
+                std::uint32_t Code;
+                if ( !Hex4( Code ) ) {
+                    return Fail( "invalid \\u escape" );
+                }
+                if ( Code >= 0xD800 && Code < 0xDC00 ) {
+                    std::uint32_t Low {};
+                    auto const Save = cur_;
+                    if ( Consume( '\\' ) && Consume( 'u' ) && Hex4( Low ) &&
+                         Low >= 0xDC00 && Low < 0xE000 )
+                    {
+                        Code = 0x10000 + ( ( Code - 0xD800 ) << 10 ) + ( Low - 0xDC00 );
+                    }
+                    else {
+                        cur_ = Save;
+                        Code = 0xFFFD;
+                    }
+                }
+                else if ( Code >= 0xDC00 && Code < 0xE000 ) {
+                    Code = 0xFFFD;
+                }
+                AppendUtf8( Code );
+                return true;
+            }
+            default:
+                return Fail( "invalid escape" );
+        }
+    }
+
+    // On success Text views the UTF-8 content: the source itself when the
+    // string has no escapes, otherwise scratch_ (valid until the next
+    // string is read).
+    bool String( std::string_view& Text ) {
+        auto const Start = ++cur_;
+        while ( cur_ != last_ && *cur_ != '"' && *cur_ != '\\' ) {
+            if ( static_cast<unsigned char>( *cur_ ) < 0x20 ) {
+                return Fail( "control character in string" );
+            }
+            ++cur_;
+        }
+        if ( cur_ == last_ ) {
+            return Fail( "unterminated string" );
+        }
+        if ( *cur_ == '"' ) {
+            Text = std::string_view( Start, static_cast<std::size_t>( cur_ - Start ) );
+            ++cur_;
+            return true;
+        }
+        scratch_.assign( Start, cur_ );
+        while ( cur_ != last_ && *cur_ != '"' ) {
+            if ( *cur_ == '\\' ) {
+                ++cur_;
+                if ( !Escape() ) { return false; }
+            }
+            else if ( static_cast<unsigned char>( *cur_ ) < 0x20 ) {
+                return Fail( "control character in string" );
+            }
+            else {
+                scratch_ += *cur_++;
+            }
+        }
+        if ( cur_ == last_ ) {
+            return Fail( "unterminated string" );
+        }
+        ++cur_;
+        Text = scratch_;
+        return true;
+    }
+};
+
+} // End of namespace Detail
+
+/// Parses the UTF-8 JSON text [@p First, @p Last) in one pass and reports
+/// it to @p Handler, SAX style, without building a document.
+///
+/// @p Handler provides:
+/// @code
+/// bool StartObject();                  // false: skip the object
+/// bool Key( std::string_view Name );   // false: skip the member's value
+/// void EndObject();
+/// bool StartArray();                   // false: skip the array
+/// void EndArray();
+/// void String( std::string_view Text );
+/// void Number( std::string_view Text ); // the literal, e.g. "-1.5e3"
+/// void Bool( bool Value );
+/// void Null();
+/// @endcode
+/// Skipped containers are still validated but produce no events (not even
+/// their @c End* call).  Views are only valid during the call.  A leading
+/// UTF-8 byte order mark is ignored; lone surrogates in @c \\u escapes
+/// become U+FFFD.  Exceptions thrown by @p Handler propagate.  A member's
+/// @c Key is reported as soon as its name is read, so on malformed input
+/// it may come just before the error.
+template<typename H>
+TResult Parse( char const * First, char const * Last, H& Handler,
+               std::size_t MaxDepth = DefaultMaxDepth )
+{
+    return Detail::TParser<H>( First, Last, Handler, MaxDepth ).Run();
+}
+
+/// As @ref Parse, for text read from @p Source a buffer at a time, so
+/// that the memory used does not grow with the text.  @p Source provides
+/// @code
+/// std::size_t Read( char* Buffer, std::size_t Size ); // 0: end of text
+/// @endcode
+/// The buffer holds @p BufferSize bytes, or twice as many as the longest
+/// string or number when that does not fit.  @c TResult::Offset counts
+/// from the start of the text.
+template<typename S, typename H>
+TResult ParseStream( S& Source, H& Handler,
+                     std::size_t BufferSize = DefaultBufferSize,
+                     std::size_t MaxDepth = DefaultMaxDepth )
+{
+    return Detail::TParser<H,S>( Source, BufferSize, Handler, MaxDepth ).Run();
+}
+
+//---------------------------------------------------------------------------
+} // End of namespace Sax
+//---------------------------------------------------------------------------
+} // End of namespace JSON
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
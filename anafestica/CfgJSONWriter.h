@@ -0,0 +1,119 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgJSONWriterH
+#define CfgJSONWriterH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and tested on any C++17 toolchain.
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace JSON {
+//---------------------------------------------------------------------------
+
+/// Sink that collects its input in memory.
+template<typename C = std::string>
+struct TMemorySink {
+    C& Out;
+
+    void Append( char const * Data, std::size_t Length ) {
+        Out.insert( Out.end(), Data, Data + Length );
+    }
+};
+
+/// Lays out JSON tokens, compact or indented, straight into a sink.
+///
+/// Only the structure is handled here: names and scalars are passed in
+/// already rendered (quoted and escaped strings, number literals).  With
+/// @p Indentation 0 the output is compact, as @c TJSONAncestor::ToJSON
+/// renders it: no whitespace at all.  Otherwise it follows
+/// @c TJSONAncestor::Format: every member and element on its own line,
+/// indented by @p Indentation spaces per level, @c ": " after names, CR LF
+/// line breaks, and @c {} / @c [] for empty containers.
+///
+/// @tparam S  Sink type, with <tt>void Append( char const *, std::size_t )</tt>.
+template<typename S>
+class TTextWriter {
+public:
+    TTextWriter( S& Sink, int Indentation ) noexcept
+        : sink_{ Sink }, indentation_{ Indentation } {}
+
+    void BeginObject() { Open( '{' ); }
+    void EndObject() { Close( '}' ); }
+    void BeginArray() { Open( '[' ); }
+    void EndArray() { Close( ']' ); }
+
+    /// Starts a member of the current object; @p Quoted is the rendered
+    /// name, quotes included.
+    void Name( std::string_view Quoted ) {
+        Item();
+        Append( Quoted );
+        if ( indentation_ ) { Append( ": " ); }
+        else { Append( ":" ); }
+        afterName_ = true;
+    }
+
+    /// Writes a rendered scalar: a quoted string, a number or a literal.
+    void Scalar( std::string_view Text ) {
+        Value();
+        Append( Text );
+    }
+private:
+    S& sink_;
+    int indentation_;
+    std::vector<bool> hasItems_;    // per open container
+    bool afterName_ {};
+
+    void Append( std::string_view Text ) { sink_.Append( Text.data(), Text.size() ); }
+
+    // Separator, line break and indentation before a member or element.
+    void Item() {
+        if ( hasItems_.empty() ) {
+            return;
+        }
+        if ( hasItems_.back() ) { Append( "," ); }
+        hasItems_.back() = true;
+        if ( indentation_ ) { NewLine( hasItems_.size() ); }
+    }
+
+    void Value() {
+        if ( afterName_ ) { afterName_ = false; }
+        else { Item(); }
+    }
+
+    void Open( char Bracket ) {
+        Value();
+        Append( std::string_view( &Bracket, 1 ) );
+        hasItems_.push_back( false );
+    }
+
+    void Close( char Bracket ) {
+        bool const HadItems = hasItems_.back();
+        hasItems_.pop_back();
+        if ( HadItems && indentation_ ) { NewLine( hasItems_.size() ); }
+        Append( std::string_view( &Bracket, 1 ) );
+    }
+
+    void NewLine( std::size_t Depth ) {
+        static constexpr char Spaces[] = "                                ";
+        Append( "\r\n" );
+        for ( auto Count = Depth * indentation_ ; Count ; ) {
+            auto const Chunk = Count < sizeof Spaces - 1 ? Count : sizeof Spaces - 1;
+            sink_.Append( Spaces, Chunk );
+            Count -= Chunk;
+        }
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace JSON
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,120 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgKeyAtomH
+#define CfgKeyAtomH
+
+#include <System.Classes.hpp>
+#include <System.SysUtils.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+/// 32-bit FNV-1a over the UTF-16 code units of @p Id.
+constexpr std::uint32_t KeyHash( std::wstring_view Id ) noexcept
+{
+    std::uint32_t h = 2166136261u;
+    for ( auto c : Id ) {
+        h ^= static_cast<std::uint16_t>( c );
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/// Interned configuration key.
+///
+/// A @c TKeyAtom refers to the single @c String kept for its text in a
+/// process-wide intern table.  Passing an atom to
+/// @ref TConfigNode::GetItem, @c PutItem, @c ItemExists or @c DeleteItem
+/// neither builds nor copies a @c String buffer.  A key inserted into a
+/// node with an atom shares the interned buffer (a reference-count
+/// increment), and so does an equal key already in the node once
+/// @c GetItem or @c PutItem has found it with the atom; from then on a
+/// search with the atom tells its match by address (see @ref TKeyLess)
+/// and only compares characters with the keys it passes on the way.
+///
+/// Atoms are normally obtained with @ref ANA_KEY, which interns a literal
+/// once per call site.  The run-time constructor is available for keys
+/// that are only known at run time but are reused many times.
+///
+/// The intern table is never pruned, so atoms (and references to them)
+/// remain valid until the process exits.  Interning is serialised by an
+/// internal mutex; using an atom afterwards is lock-free.
+class TKeyAtom {
+public:
+    explicit TKeyAtom( std::wstring_view Id ) : str_( &Intern( Id ) ) {}
+
+    [[nodiscard]] String const & Str() const noexcept { return *str_; }
+
+    [[nodiscard]] std::wstring_view View() const noexcept {
+        return {
+            str_->c_str(),
+            static_cast<std::wstring_view::size_type>( str_->Length() )
+        };
+    }
+
+    /// Atoms with the same text always share the interned @c String, so
+    /// equality is a pointer comparison.
+    friend bool operator==( TKeyAtom const & Lhs, TKeyAtom const & Rhs ) noexcept {
+        return Lhs.str_ == Rhs.str_;
+    }
+
+    friend bool operator!=( TKeyAtom const & Lhs, TKeyAtom const & Rhs ) noexcept {
+        return !( Lhs == Rhs );
+    }
+
+private:
+    String const * str_;
+
+    static String const & Intern( std::wstring_view Id ) {
+        // Node-based container: references to stored Strings survive
+        // rehashing.  Function-local statics avoid any dependency on the
+        // initialisation order of other translation units.
+        static std::mutex Mutex;
+        static std::unordered_multimap<std::uint32_t,String> Table;
+
+        auto const Hash = KeyHash( Id );
+        std::lock_guard<std::mutex> Lock( Mutex );
+        auto Range = Table.equal_range( Hash );
+        for ( auto i = Range.first ; i != Range.second ; ++i ) {
+            auto const & s = i->second;
+            if ( std::wstring_view( s.c_str(), s.Length() ) == Id ) {
+                return s;
+            }
+        }
+        return
+            Table.emplace(
+                Hash, String( Id.data(), static_cast<int>( Id.size() ) )
+            )->second;
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+/// Yields a @c TKeyAtom const & for the literal @p ID.
+///
+/// @p ID may be a narrow or a wide string literal (a narrow literal is
+/// widened by concatenation with @c L"").  The literal is interned the
+/// first time the expression is evaluated; later evaluations cost one
+/// initialisation guard check.
+///
+/// @code
+/// Node.PutItem( ANA_KEY( "Left" ), Left );
+/// Node.GetItem( ANA_KEY( "Left" ), Left );
+/// @endcode
+#define ANA_KEY( ID ) \
+    ( []() -> ::Anafestica::TKeyAtom const & { \
+        static ::Anafestica::TKeyAtom const Atom_( L"" ID ); \
+        return Atom_; \
+    }() )
+
+//---------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,115 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgNodeCursorH
+#define CfgNodeCursorH
+
+#include <System.SysUtils.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <anafestica/CfgItems.h>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+/// Storage side of the node cursor protocol (see @c TConfig::DoEnterNode).
+///
+/// Keeps one frame per entered node: its name and, once resolved, the
+/// backend's handle for it (a DOM element, a section name, ...).
+/// @ref Resolve for the path the cursor is on resumes from the deepest
+/// resolved frame, so a load or flush resolves every node once, from its
+/// parent, instead of walking each path from the document root.  Any other
+/// path is walked from the root as before, which keeps direct
+/// @c CreateValueList / @c SaveValueList calls working.
+///
+/// @tparam H  Backend handle type; copied into every frame, so it should
+///            be cheap to copy (a pointer, an interface, a String).
+template<typename H>
+class TNodeCursor {
+public:
+    void Enter( String const & Name ) {
+        frames_.push_back( TFrame{ Name, H{}, false } );
+    }
+
+    void Leave() noexcept { frames_.pop_back(); }
+
+    [[nodiscard]] std::size_t GetDepth() const noexcept { return frames_.size(); }
+
+    /// @c true when @p Path names the node the cursor is on.  Only the
+    /// depth and the last component are compared: a traversal enters every
+    /// component, so the others match by construction.
+    [[nodiscard]] bool IsAt( TConfigPath const & Path ) const {
+        return
+            Path.size() == frames_.size() &&
+            ( frames_.empty() || Path.back() == frames_.back().Name );
+    }
+
+    /// Forgets the handle of the node at @p Path, if the cursor is on it.
+    /// Backends call it after removing that node from storage.
+    void Invalidate( TConfigPath const & Path ) {
+        if ( !frames_.empty() && IsAt( Path ) ) {
+            auto& Frame = frames_.back();
+            Frame.Handle = H{};
+            Frame.Resolved = false;
+        }
+    }
+
+    /// Resolves the first @p Levels components of @p Path.
+    ///
+    /// On entry @p Node holds the handle of the root; on success it holds
+    /// the handle of the resolved node.  @p Step is called as
+    /// <tt>bool Step( H& Node, String const & Name )</tt>: it replaces
+    /// @c Node with its child @c Name and returns @c false when there is
+    /// none (an opening step) or creates it (a forcing step).  Only handles
+    /// that were successfully resolved are cached, so a failed opening step
+    /// is retried by a later forcing one.
+    template<typename F>
+    bool Resolve( H& Node, TConfigPath const & Path, std::size_t Levels, F&& Step ) {
+        if ( !IsAt( Path ) ) {
+            for ( std::size_t Idx {} ; Idx < Levels ; ++Idx ) {
+                if ( !Step( Node, Path[Idx] ) ) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        auto First = Levels;
+        while ( First && !frames_[First - 1].Resolved ) {
+            --First;
+        }
+        if ( First ) {
+            Node = frames_[First - 1].Handle;
+        }
+        for ( ; First < Levels ; ++First ) {
+            auto& Frame = frames_[First];
+            if ( !Step( Node, Frame.Name ) ) {
+                return false;
+            }
+            Frame.Handle = Node;
+            Frame.Resolved = true;
+        }
+        return true;
+    }
+
+    /// Resolves the whole of @p Path (see above).
+    template<typename F>
+    bool Resolve( H& Node, TConfigPath const & Path, F&& Step ) {
+        return Resolve( Node, Path, Path.size(), std::forward<F>( Step ) );
+    }
+private:
+    struct TFrame {
+        String Name;
+        H Handle;
+        bool Resolved;
+    };
+
+    std::vector<TFrame> frames_;
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
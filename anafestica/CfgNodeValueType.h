@@ -6,40 +6,26 @@
 #include <System.Classes.hpp>
 #include <System.SysUtils.hpp>
 
-#include <memory>
-#include <vector>
-#include <string>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include <optional>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <algorithm>
 
-// Compiler detection for variant selection.
-//
-//   bcc64x  (_WIN64, Clang >= 15): std::variant works correctly — selected automatically.
-//   bcc64   (_WIN64, Clang <  15): std::variant has an assignment bug (RSP-27418); boost::variant used.
-//   bcc32c  (_WIN32, Clang       ): boost::variant used.
-//   BCC32   (non-Clang           ): not supported.
-//
-// ANAFESTICA_USE_STD_VARIANT is the internal flag that switches between the two;
-// it is set here automatically and should not need to be defined manually.
+#include <anafestica/CfgTypeTag.h>
+
+// Values are held in TConfigNodeValueType (below), which is the same on
+// bcc32c, bcc64 and bcc64x and needs neither Boost nor std::variant (whose
+// assignment is broken on bcc64, RSP-27418).
 #if !defined(__clang__)
   #error "Old legacy BCC32 is not supported. Use bcc32c, bcc64, or bcc64x."
-#elif defined(_WIN64)
-  #if __clang_major__ >= 15
-    // bcc64x: std::variant is fully functional
-    #define ANAFESTICA_USE_STD_VARIANT
-  #endif
-  // bcc64 (Clang < 15): falls through — boost::variant is used below
-#endif
-// bcc32c (_WIN32 + Clang): falls through — boost::variant is used below
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-# include <variant>
-#else
-  // boost::variant path (bcc64/bcc32c): 19 types, within Boost 1.70's
-  // hardcoded mpl::list limit of 20. No limit overrides needed.
-# include <boost/variant.hpp>
 #endif
 
 //---------------------------------------------------------------------------
@@ -49,23 +35,72 @@ namespace Anafestica {
 using StringCont = std::vector<String>;
 using BytesCont = std::vector<Byte>;
 
-/// Heterogeneous variant holding any single configuration value.
-///
-/// Each alternative corresponds to a unique type tag (see @ref TypeTag).
-/// Backends encode the tag into the storage format (e.g. a suffix in the
-/// value name for Registry/INI, a "type" attribute for XML, a nested key
-/// for JSON) so that the correct alternative can be reconstructed on read.
-///
-/// Because every C++ type occupies a distinct alternative, reading a value
-/// with a type that differs from the one stored will cause @c std::get_if
-/// (or @c boost::get) to return @c nullptr, and @ref TConfigNode::GetItem
-/// will silently return @c T{}.
-using TConfigNodeValueType =
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-    std::variant<
+namespace Detail {
+
+template<typename... T>
+struct TTypeList {
+    static constexpr std::size_t Size = sizeof...( T );
+};
+
+template<typename T, typename L>
+struct TIndexOf;
+
+template<typename T, typename... R>
+struct TIndexOf<T,TTypeList<T,R...>>
+    : std::integral_constant<std::size_t,0> {};
+
+template<typename T, typename H, typename... R>
+struct TIndexOf<T,TTypeList<H,R...>>
+    : std::integral_constant<std::size_t,1 + TIndexOf<T,TTypeList<R...>>::value> {};
+
+template<typename T, typename L>
+struct TContains;
+
+template<typename T, typename... A>
+struct TContains<T,TTypeList<A...>>
+    : std::disjunction<std::is_same<T,A>...> {};
+
+template<std::size_t I, typename L>
+struct TTypeAt;
+
+template<typename H, typename... R>
+struct TTypeAt<0,TTypeList<H,R...>> { using type = H; };
+
+template<std::size_t I, typename H, typename... R>
+struct TTypeAt<I,TTypeList<H,R...>> : TTypeAt<I - 1,TTypeList<R...>> {};
+
+// Overload set with one Select per alternative: the alternative a
+// non-exact argument converts to is chosen by ordinary overload
+// resolution, as a variant's converting constructor does.
+template<typename T>
+struct TSelectOne { static T Select( T ); };
+
+template<typename L>
+struct TSelectAll;
+
+template<typename... A>
+struct TSelectAll<TTypeList<A...>> : TSelectOne<A>... {
+    using TSelectOne<A>::Select...;
+};
+
+template<typename T>
+struct TTypeId { using type = T; };
+
+template<typename T>
+constexpr T* Launder( T* Ptr ) noexcept
+{
+#if defined( __cpp_lib_launder )
+    return std::launder( Ptr );
 #else
-    boost::variant<
+    return Ptr;
 #endif
+}
+
+} // End of namespace Detail
+
+/// The alternatives of @ref TConfigNodeValueType, in @ref TypeTag order.
+using TValueAlternatives =
+    Detail::TTypeList<
         int                         // TT_I   i
       , unsigned int                // TT_U   u
       , long                        // TT_L   l
@@ -85,146 +120,398 @@ using TConfigNodeValueType =
       , StringCont                  // TT_SV  sv
       , System::Sysutils::TBytes    // TT_DAB dab
       , BytesCont                   // TT_VB  vb
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-      // std::string and std::wstring require std::variant (bcc64x only).
-      // Boost 1.70's mpl::list is hardcoded to 20 types, and we already
-      // use 19 above, so adding two more would exceed the limit on bcc64/bcc32c.
       , std::string                 // TT_STR str  (UTF-8)
       , std::wstring                // TT_WSTR wstr (UTF-16)
-#endif
     >;
 
-// Type identifiers -- prefixed to avoid macro namespace pollution
-
-#define ANA_TT_I    i        // int
-#define ANA_TT_U    u        // unsigned int
-#define ANA_TT_L    l        // long
-#define ANA_TT_UL   ul       // unsigned long
-#define ANA_TT_C    c        // char
-#define ANA_TT_UC   uc       // unsigned char
-#define ANA_TT_S    s        // short
-#define ANA_TT_US   us       // unsigned short
-#define ANA_TT_LL   ll       // long long
-#define ANA_TT_ULL  ull      // unsigned long long
-#define ANA_TT_B    b        // bool
-#define ANA_TT_SZ   sz       // System::String
-#define ANA_TT_DT   dt       // System::TDateTime
-#define ANA_TT_FLT  flt      // float
-#define ANA_TT_DBL  dbl      // double
-#define ANA_TT_CUR  cur      // System::Currency
-#define ANA_TT_SV   sv       // StringCont aka std::vector<String>
-#define ANA_TT_DAB  dab      // System::Sysutils::TBytes
-#define ANA_TT_VB   vb       // BytesCont aka std::vector<Byte>
-// ANA_TT_STR and ANA_TT_WSTR are only available on bcc64x (std::variant path).
-// On bcc64/bcc32c, std::string and std::wstring are not variant alternatives.
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-#define ANA_TT_STR  str      // std::string  (UTF-8)
-#define ANA_TT_WSTR wstr     // std::wstring (UTF-16)
-#endif
+/// @c true when @c T is exactly one of the alternatives of
+/// @ref TConfigNodeValueType (so it can be probed and assigned without
+/// building a value first).
+template<typename T>
+struct is_value_alternative : Detail::TContains<T,TValueAlternatives> {};
 
-/// Identifies the variant alternative stored in @ref TConfigNodeValueType.
-///
-/// Each enumerator maps 1:1 to an alternative in the variant and to a
-/// short text tag (e.g. @c "i", @c "sz", @c "dbl") used by backends to
-/// encode the type in the storage format.  See @ref GetTypeTag for the
-/// reverse mapping from text to enumerator.
-enum class TypeTag : size_t {
-    TT_I,   // int
-    TT_U,   // unsigned int
-    TT_L,   // long
-    TT_UL,  // unsigned long
-    TT_C,   // char
-    TT_UC,  // unsigned char
-    TT_S,   // short
-    TT_US,  // unsigned short
-    TT_LL,  // long long
-    TT_ULL, // unsigned long long
-    TT_B,   // bool
-    TT_SZ,  // System::String
-    TT_DT,  // System::TDateTime
-    TT_FLT, // float
-    TT_DBL, // double
-    TT_CUR, // System::Currency
-    TT_SV,  // StringCont aka std::vector<String>
-    TT_DAB, // System::Sysutils::TBytes
-    TT_VB,  // BytesCont aka std::vector<Byte>
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-    TT_STR, // std::string  (UTF-8)  — bcc64x only
-    TT_WSTR // std::wstring (UTF-16) — bcc64x only
-#endif
+template<typename T>
+inline constexpr bool is_value_alternative_v = is_value_alternative<T>::value;
+
+namespace Detail {
+
+template<typename U>
+inline constexpr bool is_text_pointer_v =
+    std::is_same_v<U,wchar_t const *> || std::is_same_v<U,wchar_t*> ||
+    std::is_same_v<U,char const *> || std::is_same_v<U,char*>;
+
+template<typename T, typename = void>
+struct TSelectAlternative {};
+
+template<typename T>
+struct TSelectAlternative<
+    T,
+    std::void_t<decltype( TSelectAll<TValueAlternatives>::Select( std::declval<T>() ) )>
+>
+{
+    using type =
+        decltype( TSelectAll<TValueAlternatives>::Select( std::declval<T>() ) );
 };
 
-#define ana_cnv_xstr( s ) ana_cnv_str( s )
-#define ana_cnv_str( s )  #s
+// Alternative stored for an argument of type T: T itself when it is an
+// alternative, String for character pointers and literals (rather than
+// the bool a pointer would otherwise convert to), else the best overload.
+template<typename T, typename U = std::decay_t<T>,
+         bool = is_value_alternative_v<U>, bool = is_text_pointer_v<U>>
+struct TValueTarget : TSelectAlternative<T> {};
 
-/// Maps a type-tag string (e.g. @c "i", @c "sz", @c "dbl") to its
-/// @ref TypeTag enumerator.
+template<typename T, typename U, bool P>
+struct TValueTarget<T,U,true,P> { using type = U; };
+
+template<typename T, typename U>
+struct TValueTarget<T,U,false,true> { using type = System::String; };
+
+} // End of namespace Detail
+
+/// Compact cell holding any single configuration value.
 ///
-/// Uses binary search over a sorted @c constexpr array of tag strings.
-/// On bcc64x (std::variant path) the array has 21 entries including
-/// @c "str" and @c "wstr".  On bcc64/bcc32c (boost::variant path) those
-/// two tags are absent and the array has 19 entries.
-/// Returns @c std::nullopt when @p Val does not match any known tag,
-/// which backends use to skip unrecognised entries.
-[[nodiscard]] inline
-std::optional<TypeTag> GetTypeTag( String Val )
-{
-    using Cont =
-        std::array<
-            std::pair<LPCTSTR,TypeTag>,
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::variant_size<TConfigNodeValueType>::value
-#else
-            TConfigNodeValueType::types::size::value
-#endif
-        >;
-
-    // Keys must be sorted for std::lower_bound.
-    // bcc64x  (21 entries): b c cur dab dbl dt flt i l ll s str sv sz u uc ul ull us vb wstr
-    // bcc64/bcc32c (19 entries): b c cur dab dbl dt flt i l ll s sv sz u uc ul ull us vb
-    static constexpr Cont TypeIds {
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_B ),    TypeTag::TT_B    ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_C ),    TypeTag::TT_C    ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_CUR ),  TypeTag::TT_CUR  ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_DAB ),  TypeTag::TT_DAB  ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_DBL ),  TypeTag::TT_DBL  ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_DT ),   TypeTag::TT_DT   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_FLT ),  TypeTag::TT_FLT  ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_I ),    TypeTag::TT_I    ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_L ),    TypeTag::TT_L    ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_LL ),   TypeTag::TT_LL   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_S ),    TypeTag::TT_S    ),
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_STR ),  TypeTag::TT_STR  ),
-#endif
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_SV ),   TypeTag::TT_SV   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_SZ ),   TypeTag::TT_SZ   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_U ),    TypeTag::TT_U    ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_UC ),   TypeTag::TT_UC   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_UL ),   TypeTag::TT_UL   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_ULL ),  TypeTag::TT_ULL  ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_US ),   TypeTag::TT_US   ),
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_VB ),   TypeTag::TT_VB   ),
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::make_pair( _D( "" ) ana_cnv_xstr( ANA_TT_WSTR ), TypeTag::TT_WSTR ),
-#endif
+/// Each alternative corresponds to a unique type tag (see @ref TypeTag).
+/// Backends encode the tag into the storage format (e.g. a suffix in the
+/// value name for Registry/INI, a "type" attribute for XML, a nested key
+/// for JSON) so that the correct alternative can be reconstructed on read.
+///
+/// Because every C++ type occupies a distinct alternative, reading a value
+/// with a type that differs from the one stored makes @ref GetIfValue
+/// return @c nullptr, and @ref TConfigNode::GetItem will silently return
+/// @c T{}.
+///
+/// The cell is 16 bytes on every toolchain: an 8-byte payload and the
+/// alternative index.  Scalars, @c String and @c TBytes (both already
+/// reference-counted handles) live in the payload.  @c StringCont,
+/// @c BytesCont, @c std::string and @c std::wstring live in a
+/// reference-counted box, so copying a cell never copies them; a box
+/// shared by several cells is duplicated only when one of them is
+/// modified through a non-const @ref GetIfValue (copy-on-write).
+///
+/// The interface is a subset of @c std::variant's: construction and
+/// assignment from any alternative (or anything convertible to exactly
+/// one), @c index, @ref GetIfValue, @ref Visit and equality.
+class TConfigNodeValueType {
+public:
+    static constexpr std::size_t AlternativeCount = TValueAlternatives::Size;
+
+    /// Holds @c int @c 0, like a default-constructed variant.
+    TConfigNodeValueType() noexcept { ::new( data_ ) int{}; }
+
+    template<typename T,
+             typename A = typename Detail::TValueTarget<T>::type>
+    TConfigNodeValueType( T&& Val )
+        : tag_( static_cast<std::uint8_t>( IndexOf<A>() ) )
+    {
+        Construct<A>( std::forward<T>( Val ) );
+    }
+
+    TConfigNodeValueType( TConfigNodeValueType const & Rhs ) noexcept
+        : tag_( Rhs.tag_ )
+    {
+        CopyFrom( Rhs );
+    }
+
+    TConfigNodeValueType( TConfigNodeValueType&& Rhs ) noexcept
+        : tag_( Rhs.tag_ )
+    {
+        MoveFrom( Rhs );
+    }
+
+    ~TConfigNodeValueType() { Destroy(); }
+
+    TConfigNodeValueType& operator=( TConfigNodeValueType const & Rhs ) noexcept {
+        if ( this != &Rhs ) {
+            Destroy();
+            tag_ = Rhs.tag_;
+            CopyFrom( Rhs );
+        }
+        return *this;
+    }
+
+    TConfigNodeValueType& operator=( TConfigNodeValueType&& Rhs ) noexcept {
+        if ( this != &Rhs ) {
+            Destroy();
+            tag_ = Rhs.tag_;
+            MoveFrom( Rhs );
+        }
+        return *this;
+    }
+
+    template<typename T,
+             typename A = typename Detail::TValueTarget<T>::type>
+    TConfigNodeValueType& operator=( T&& Val ) {
+        return *this = TConfigNodeValueType( std::forward<T>( Val ) );
+    }
+
+    /// Position of the held alternative in @ref TValueAlternatives
+    /// (the numeric value of its @ref TypeTag).
+    [[nodiscard]] std::size_t index() const noexcept { return tag_; }
+
+    /// @c false when the payload is a box shared with other cells.
+    [[nodiscard]] bool IsUnique() const noexcept {
+        return
+            Dispatch(
+                tag_,
+                [&]( auto Id ) -> bool {
+                    using T = typename decltype( Id )::type;
+                    if constexpr ( IsInline<T>() ) {
+                        return true;
+                    }
+                    else {
+                        return
+                            GetBoxPtr()->Refs.load( std::memory_order_acquire ) == 1;
+                    }
+                }
+            );
+    }
+
+    template<typename T>
+    [[nodiscard]] bool Holds() const noexcept {
+        return tag_ == IndexOf<T>();
+    }
+
+    /// The held @c T, or @c nullptr when another alternative is held.
+    template<typename T>
+    [[nodiscard]] T const * GetIf() const noexcept {
+        return Holds<T>() ? &Ref<T>() : nullptr;
+    }
+
+    /// As above, for modification: a box shared with other cells is
+    /// copied first, so the change is not seen through them.
+    template<typename T>
+    [[nodiscard]] T* GetIf() {
+        if ( !Holds<T>() ) { return nullptr; }
+        if constexpr ( !IsInline<T>() ) {
+            auto& Box = GetBox<T>();
+            if ( Box.Refs.load( std::memory_order_acquire ) != 1 ) {
+                auto Copy = new TBoxOf<T>( Box.Value );
+                Release<T>();
+                SetBox( Copy );
+            }
+        }
+        return &const_cast<T&>( Ref<T>() );
+    }
+
+    /// Calls @p Visitor with the held alternative (a @c const reference);
+    /// every call must return the same type.
+    template<typename F>
+    decltype( auto ) Visit( F&& Visitor ) const {
+        return Dispatch(
+            tag_,
+            [&]( auto Id ) -> decltype( auto ) {
+                using T = typename decltype( Id )::type;
+                return Visitor( Ref<T>() );
+            }
+        );
+    }
+
+    friend bool operator==( TConfigNodeValueType const & Lhs,
+                            TConfigNodeValueType const & Rhs ) {
+        if ( Lhs.tag_ != Rhs.tag_ ) { return false; }
+        return Dispatch(
+            Lhs.tag_,
+            [&]( auto Id ) -> bool {
+                using T = typename decltype( Id )::type;
+                if constexpr ( !IsInline<T>() ) {
+                    if ( Lhs.GetBoxPtr() == Rhs.GetBoxPtr() ) { return true; }
+                }
+                return Lhs.Ref<T>() == Rhs.Ref<T>();
+            }
+        );
+    }
+
+    friend bool operator!=( TConfigNodeValueType const & Lhs,
+                            TConfigNodeValueType const & Rhs ) {
+        return !( Lhs == Rhs );
+    }
+
+private:
+    static constexpr std::size_t PayloadSize = 8;
+
+    struct TBox {
+        std::atomic<std::size_t> Refs { 1 };
     };
 
-    auto TypeIdIt =
-        std::lower_bound(
-            std::begin( TypeIds ), std::end( TypeIds ),
-            Val,
-            []( auto const & Lhs, auto const & Rhs ) {
-                return String( Lhs.first ) < Rhs;
+    template<typename T>
+    struct TBoxOf : TBox {
+        template<typename... A>
+        explicit TBoxOf( A&&... Args ) : Value( std::forward<A>( Args )... ) {}
+        T Value;
+    };
+
+    alignas( 8 ) unsigned char data_[PayloadSize];
+    std::uint8_t tag_ {};
+
+    template<typename T>
+    static constexpr std::size_t IndexOf() noexcept {
+        return Detail::TIndexOf<T,TValueAlternatives>::value;
+    }
+
+    template<typename T>
+    static constexpr bool IsInline() noexcept {
+        return sizeof( T ) <= PayloadSize && alignof( T ) <= 8;
+    }
+
+    template<typename F>
+    using DispatchResult = decltype( std::declval<F&>()( Detail::TTypeId<int>{} ) );
+
+    template<typename R, typename F, typename T>
+    static R Thunk( F& Fn ) { return Fn( Detail::TTypeId<T>{} ); }
+
+    // Calls Fn( TTypeId<T>{} ) for the alternative T at position Tag,
+    // through a table of one thunk per alternative.
+    template<typename F, std::size_t... I>
+    static DispatchResult<F> DispatchImpl( std::size_t Tag, F& Fn,
+                                           std::index_sequence<I...> ) {
+        using Thunks = DispatchResult<F>(*)( F& );
+        static constexpr Thunks Table[] = {
+            &Thunk<
+                DispatchResult<F>, F,
+                typename Detail::TTypeAt<I,TValueAlternatives>::type
+            >...
+        };
+        return Table[Tag]( Fn );
+    }
+
+    template<typename F>
+    static DispatchResult<F> Dispatch( std::size_t Tag, F&& Fn ) {
+        return
+            DispatchImpl(
+                Tag, Fn, std::make_index_sequence<AlternativeCount>{}
+            );
+    }
+
+    template<typename T>
+    T const & Ref() const noexcept {
+        if constexpr ( IsInline<T>() ) {
+            return *Detail::Launder( reinterpret_cast<T const *>( data_ ) );
+        }
+        else {
+            return GetBox<T>().Value;
+        }
+    }
+
+    TBox* GetBoxPtr() const noexcept {
+        return *Detail::Launder( reinterpret_cast<TBox* const *>( data_ ) );
+    }
+
+    template<typename T>
+    TBoxOf<T>& GetBox() const noexcept {
+        return *static_cast<TBoxOf<T>*>( GetBoxPtr() );
+    }
+
+    void SetBox( TBox* Box ) noexcept { ::new( data_ ) TBox*( Box ); }
+
+    template<typename T, typename V>
+    void Construct( V&& Val ) {
+        if constexpr ( IsInline<T>() ) {
+            ::new( data_ ) T( std::forward<V>( Val ) );
+        }
+        else {
+            SetBox( new TBoxOf<T>( std::forward<V>( Val ) ) );
+        }
+    }
+
+    template<typename T>
+    void Release() noexcept {
+        auto& Box = GetBox<T>();
+        if ( Box.Refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+            delete &Box;
+        }
+    }
+
+    void CopyFrom( TConfigNodeValueType const & Rhs ) noexcept {
+        Dispatch(
+            tag_,
+            [&]( auto Id ) {
+                using T = typename decltype( Id )::type;
+                if constexpr ( IsInline<T>() ) {
+                    ::new( data_ ) T( Rhs.Ref<T>() );
+                }
+                else {
+                    auto Box = Rhs.GetBoxPtr();
+                    Box->Refs.fetch_add( 1, std::memory_order_relaxed );
+                    SetBox( Box );
+                }
             }
         );
+    }
 
-    if ( TypeIdIt != std::end( TypeIds ) && String( TypeIdIt->first ) == Val ) {
-        return std::optional<TypeTag>(
-            TypeIds[std::distance( std::begin( TypeIds ), TypeIdIt )].second
+    // Leaves Rhs holding int 0 when its box is taken over.
+    void MoveFrom( TConfigNodeValueType& Rhs ) noexcept {
+        Dispatch(
+            tag_,
+            [&]( auto Id ) {
+                using T = typename decltype( Id )::type;
+                if constexpr ( IsInline<T>() ) {
+                    ::new( data_ ) T( std::move( const_cast<T&>( Rhs.Ref<T>() ) ) );
+                }
+                else {
+                    SetBox( Rhs.GetBoxPtr() );
+                    Rhs.tag_ = static_cast<std::uint8_t>( IndexOf<int>() );
+                    ::new( Rhs.data_ ) int{};
+                }
+            }
         );
     }
-    return std::nullopt;
+
+    void Destroy() noexcept {
+        Dispatch(
+            tag_,
+            [&]( auto Id ) {
+                using T = typename decltype( Id )::type;
+                if constexpr ( IsInline<T>() ) {
+                    Ref<T>().~T();
+                }
+                else {
+                    Release<T>();
+                }
+            }
+        );
+    }
+};
+
+static_assert( sizeof( TConfigNodeValueType ) == 16, "value cell must stay 16 bytes" );
+
+/// The @c T held by @p Val, or @c nullptr when it holds another
+/// alternative.
+template<typename T>
+[[nodiscard]] T const * GetIfValue( TConfigNodeValueType const * Val ) noexcept
+{
+    return Val->GetIf<T>();
+}
+
+template<typename T>
+[[nodiscard]] T* GetIfValue( TConfigNodeValueType* Val )
+{
+    return Val->GetIf<T>();
+}
+
+/// Calls @p Visitor with the alternative held by @p Val
+/// (the counterpart of @c std::visit).
+template<typename F>
+decltype( auto ) Visit( F&& Visitor, TConfigNodeValueType const & Val )
+{
+    return Val.Visit( std::forward<F>( Visitor ) );
+}
+
+static_assert(
+    TConfigNodeValueType::AlternativeCount == TypeTagCount,
+    "Every value alternative needs a TypeTag (see CfgTypeTag.h)"
+);
+
+/// Maps a type-tag string (e.g. @c "i", @c "sz", @c "dbl") to its
+/// @ref TypeTag enumerator.
+///
+/// Probes the compile-time perfect hash of @ref FindTypeTag directly on
+/// the string's characters.
+/// Returns @c std::nullopt when @p Val does not match any known tag,
+/// which backends use to skip unrecognised entries.
+[[nodiscard]] inline
+std::optional<TypeTag> GetTypeTag( String const & Val )
+{
+    return FindTypeTag( Val.c_str(), static_cast<std::size_t>( Val.Length() ) );
 }
 
 //---------------------------------------------------------------------------
@@ -5,9 +5,11 @@
 
 #include <memory>
 #include <vector>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
 #include <iterator>
-#include <regex>
+#include <string_view>
 #include <functional>
 #include <type_traits>
 #include <array>
@@ -20,6 +22,7 @@
 #include <System.RTLConsts.hpp>
 
 #include <anafestica/Cfg.h>
+#include <anafestica/CfgRegistryStore.h>
 #include <anafestica/FileVersionInfo.h>
 
 //---------------------------------------------------------------------------
@@ -452,22 +455,281 @@ void TRegistry::WriteStrings( String Name, InIt Begin, InIt End )
         throw ERegistryException( &_SRegSetDataFailed, ARRAYOFCONST(( Name )) );
     }
 }
+//---------------------------------------------------------------------------
+
+/// Store over the Windows registry, rooted at a predefined key such as
+/// @c HKEY_CURRENT_USER.  Values are enumerated with @c RegEnumValue,
+/// which returns name, type and data in one call, into buffers sized once
+/// per key by @c RegQueryInfoKey.  A key's stamp is its last write time
+/// and its value and subkey counts, also from @c RegQueryInfoKey.
+class TWinStore : public Store::TStore {
+public:
+    TWinStore( HKEY Root, bool ReadOnly ) noexcept
+        : root_{ Root }, access_{ ReadOnly ? KEY_READ : KEY_ALL_ACCESS } {}
+
+    std::unique_ptr<Store::TKey> Open( Store::TStringView Path ) override {
+        auto const SubKey = MakeSubKey( Path );
+        HKEY Key {};
+        if ( ::RegOpenKeyExW( root_, SubKey.c_str(), 0, KEY_READ, &Key ) != ERROR_SUCCESS ) {
+            return nullptr;
+        }
+        return std::make_unique<TKey>( Key, SubKey );
+    }
+
+    std::unique_ptr<Store::TKey> Create( Store::TStringView Path ) override {
+        auto const SubKey = MakeSubKey( Path );
+        HKEY Key {};
+        if ( ::RegCreateKeyExW(
+               root_, SubKey.c_str(), 0, nullptr, REG_OPTION_NON_VOLATILE,
+               access_, nullptr, &Key, nullptr
+             ) != ERROR_SUCCESS )
+        {
+            return nullptr;
+        }
+        return std::make_unique<TKey>( Key, SubKey );
+    }
+
+    bool Delete( Store::TStringView Path ) override {
+        auto const SubKey = MakeSubKey( Path );
+        return !SubKey.empty() &&
+               ::RegDeleteTreeW( root_, SubKey.c_str() ) == ERROR_SUCCESS;
+    }
+private:
+    class TKey : public Store::TKey {
+    public:
+        TKey( HKEY Key, Store::TString Path ) noexcept
+            : key_{ Key }, path_{ std::move( Path ) } {}
+
+        ~TKey() override { ::RegCloseKey( key_ ); }
+
+        TKey( TKey const & ) = delete;
+        TKey& operator=( TKey const & ) = delete;
+
+        void EnumValues( Store::TValueVisitor& Visitor ) override {
+            DWORD NameMax {};
+            DWORD DataMax {};
+            Check(
+                ::RegQueryInfoKeyW(
+                    key_, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                    nullptr, &NameMax, &DataMax, nullptr, nullptr
+                )
+            );
+            for ( DWORD Idx {} ; ; ) {
+                name_.resize( NameMax + 1 );
+                data_.resize( std::max<DWORD>( DataMax, 1 ) );
+                auto NameLength = static_cast<DWORD>( name_.size() );
+                auto Size = static_cast<DWORD>( data_.size() );
+                DWORD Type {};
+                auto const Ret =
+                    ::RegEnumValueW(
+                        key_, Idx, name_.data(), &NameLength, nullptr, &Type,
+                        data_.data(), &Size
+                    );
+                if ( Ret == ERROR_NO_MORE_ITEMS ) {
+                    break;
+                }
+                if ( Ret == ERROR_MORE_DATA ) {
+                    // The value grew since the key was queried: retry it
+                    // with the longest name a value can have and the
+                    // size reported for its data.
+                    NameMax = MaxValueNameLength;
+                    DataMax = std::max( DataMax, Size );
+                    continue;
+                }
+                Check( Ret );
+                Visitor.Visit(
+                    {
+                        Store::TStringView( name_.data(), NameLength ),
+                        static_cast<Store::TType>( Type ), data_.data(), Size
+                    }
+                );
+                ++Idx;
+            }
+        }
+
+        void EnumKeys( Store::TKeyVisitor& Visitor ) override {
+            DWORD NameMax {};
+            Check(
+                ::RegQueryInfoKeyW(
+                    key_, nullptr, nullptr, nullptr, nullptr, &NameMax, nullptr,
+                    nullptr, nullptr, nullptr, nullptr, nullptr
+                )
+            );
+            for ( DWORD Idx {} ; ; ) {
+                name_.resize( NameMax + 1 );
+                auto NameLength = static_cast<DWORD>( name_.size() );
+                auto const Ret =
+                    ::RegEnumKeyExW(
+                        key_, Idx, name_.data(), &NameLength, nullptr, nullptr,
+                        nullptr, nullptr
+                    );
+                if ( Ret == ERROR_NO_MORE_ITEMS ) {
+                    break;
+                }
+                if ( Ret == ERROR_MORE_DATA ) {
+                    NameMax = MaxKeyNameLength;
+                    continue;
+                }
+                Check( Ret );
+                Visitor.Visit( Store::TStringView( name_.data(), NameLength ) );
+                ++Idx;
+            }
+        }
+
+        bool Query( Store::TStringView Name, Store::TValueVisitor& Visitor ) override {
+            Store::TString const ValueName( Name );
+            data_.resize( std::max<std::size_t>( data_.size(), 1 ) );
+            for ( ;; ) {
+                auto Size = static_cast<DWORD>( data_.size() );
+                DWORD Type {};
+                auto const Ret =
+                    ::RegQueryValueExW(
+                        key_, ValueName.c_str(), nullptr, &Type, data_.data(), &Size
+                    );
+                if ( Ret == ERROR_FILE_NOT_FOUND ) {
+                    return false;
+                }
+                if ( Ret == ERROR_MORE_DATA ) {
+                    data_.resize( Size );
+                    continue;
+                }
+                Check( Ret );
+                Visitor.Visit( { Name, static_cast<Store::TType>( Type ), data_.data(), Size } );
+                return true;
+            }
+        }
+
+        void Apply( Store::TBatch const & Batch ) override {
+            Batch.ForEach( [this]( Store::TValue const & Value, bool Erase ) {
+                // Batch names are null-terminated.
+                if ( Erase ) {
+                    ::RegDeleteValueW( key_, Value.Name.data() );
+                }
+                else if ( ::RegSetValueExW(
+                            key_, Value.Name.data(), 0, static_cast<DWORD>( Value.Type ),
+                            Value.Data, static_cast<DWORD>( Value.Size )
+                          ) != ERROR_SUCCESS )
+                {
+                    throw ERegistryException(
+                        &_SRegSetDataFailed,
+                        ARRAYOFCONST(( String( Value.Name.data(), Value.Name.size() ) ))
+                    );
+                }
+            } );
+        }
+
+        Store::TStamp GetStamp() override {
+            DWORD Keys {};
+            DWORD Values {};
+            FILETIME WriteTime {};
+            Check(
+                ::RegQueryInfoKeyW(
+                    key_, nullptr, nullptr, nullptr, &Keys, nullptr, nullptr,
+                    &Values, nullptr, nullptr, nullptr, &WriteTime
+                )
+            );
+            return {
+                static_cast<std::uint64_t>( WriteTime.dwHighDateTime ) << 32 |
+                WriteTime.dwLowDateTime,
+                Values, Keys
+            };
+        }
+    private:
+        static constexpr DWORD MaxValueNameLength = 16383;
+        static constexpr DWORD MaxKeyNameLength = 255;
+
+        HKEY key_;
+        Store::TString path_;
+        std::vector<wchar_t> name_;
+        std::vector<BYTE> data_;
+
+        void Check( LONG Ret ) const {
+            if ( Ret != ERROR_SUCCESS ) {
+                throw ERegistryException(
+                    &_SRegGetDataFailed, ARRAYOFCONST(( String( path_.c_str() ) ))
+                );
+            }
+        }
+    };
+
+    HKEY root_;
+    REGSAM access_;
+
+    // Without the leading backslash TRegistry allowed for.
+    static Store::TString MakeSubKey( Store::TStringView Path ) {
+        while ( !Path.empty() && Path.front() == L'\\' ) {
+            Path.remove_prefix( 1 );
+        }
+        return Store::TString( Path );
+    }
+};
 
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 
-
+/// Keeps the configuration under @p RootPath of @p HKey.
+///
+/// A non-empty @p SnapshotFile names a file that holds an image of the
+/// keys under the root path (see @ref Store::TSnapshot), so that a start
+/// reads the keys that did not change since from the file instead of the
+/// registry:
+///
+/// @code
+/// Registry::TConfig Cfg(
+///     HKEY_CURRENT_USER, Key, false, false,
+///     TPath::Combine( CacheDir, _D( "App.snapshot" ) )
+/// );
+/// @endcode
+///
+/// Every key is still opened, and checked against the stamp it had when
+/// the image was taken (its last write time and its numbers of values and
+/// subkeys, see @ref Store::TStamp): only a key whose stamp moved, because
+/// this object, another one or any other program wrote it, is read.  The
+/// object loads the file before reading the tree; after reading it, and
+/// after every flush, it checks the keys it wrote again (unless it is
+/// read-only) and writes the file back whenever the image changed, as it
+/// does on destruction.  A missing, damaged or foreign file only means a
+/// full read; a file that cannot be written is left as it is.  Each object
+/// needs a file of its own.
 class TConfig : public Anafestica::TConfig {
 public:
     TConfig( HKEY HKey, String RootPath, bool ReadOnly = false,
-             bool FlushAllItems = false )
-        : Anafestica::TConfig( ReadOnly, FlushAllItems )
-        , rootPath_( RootPath ) , hKey_( HKey )
+             bool FlushAllItems = false, String SnapshotFile = String(),
+             TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, FlushAllItems, Options )
+        , rootPath_( RootPath )
+        , snapshotFile_( SnapshotFile )
+        , ownStore_( std::make_unique<TWinStore>( HKey, ReadOnly ) )
+        , snapshot_( MakeSnapshot( *ownStore_ ) )
+        , store_( snapshot_ ? *snapshot_ : *ownStore_ )
     {
-        RegObjRAII Reg{ *this };
-        GetRootNode().Read( *this, TConfigPath{} );
+        LoadSnapshot();
+        {
+            KeyRAII Key{ *this };
+            ReadRootNode();
+        }
+        SealSnapshot();
+    }
+
+    /// Keeps the configuration under @p RootPath of @p KeyStore (for
+    /// example a Store::TMemoryHive), which must outlive the object.
+    TConfig( Store::TStore& KeyStore, String RootPath, bool ReadOnly = false,
+             bool FlushAllItems = false, String SnapshotFile = String(),
+             TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, FlushAllItems, Options )
+        , rootPath_( RootPath )
+        , snapshotFile_( SnapshotFile )
+        , snapshot_( MakeSnapshot( KeyStore ) )
+        , store_( snapshot_ ? *snapshot_ : KeyStore )
+    {
+        LoadSnapshot();
+        {
+            KeyRAII Key{ *this };
+            ReadRootNode();
+        }
+        SealSnapshot();
     }
 
     ~TConfig() {
@@ -475,6 +737,7 @@ public:
             if ( ShouldFlushOnDestruction() ) {
                 DoFlush();
             }
+            SaveSnapshot();
         }
         catch ( ... ) {
         }
@@ -483,191 +746,215 @@ public:
     TConfig( TConfig const & ) = delete;
     TConfig& operator=( TConfig const & ) = delete;
 private:
-    #if !defined(_UNICODE)
-      using regex_type = std::regex;
-      using cmatch_type = std::cmatch;
-      using std_string = std::string;
-    #else
-      using regex_type = std::wregex;
-      using cmatch_type = std::wcmatch;
-      using std_string = std::wstring;
-    #endif
-
-    template<typename PairType>
-    void DeleteValue( PairType const & v ) { registry_->DeleteValue( v.first ); }
-
     void DeleteKey( TConfigPath const & Path ) {
-        auto const Key = GetKeyName( Path, rootPath_ );
-        if ( !registry_->CurrentPath.IsEmpty() ) {
-            if ( registry_->CurrentPath == Key ) {
-                registry_->CloseKey();
-            }
+        CloseKey();
+        store_.Delete( View( GetKeyName( Path, rootPath_ ) ) );
+    }
+
+    static Store::TStringView View( String const & Val ) noexcept {
+        return Store::TStringView( Val.c_str(), Val.Length() );
+    }
+
+    static String ToString( Store::TStringView Val ) {
+        return String( Val.data(), static_cast<int>( Val.size() ) );
+    }
+
+    // Checks the type, and the size when it is fixed, as the TRegistry
+    // read methods do.
+    static Store::TValue const & Expect( Store::TValue const & Val, Store::TType Type,
+                                         std::size_t Size = 0 )
+    {
+        if ( Val.Type != Type ) {
+            throw ERegistryException(
+                &_SInvalidRegType, ARRAYOFCONST(( ToString( Val.Name ) ))
+            );
         }
-        registry_->DeleteKey( Key );
+        if ( Size && Val.Size != Size ) {
+            throw ERegistryException(
+                &_SRegGetDataFailed, ARRAYOFCONST(( ToString( Val.Name ) ))
+            );
+        }
+        return Val;
     }
-protected:
-    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
-        regex_type re(
-            _D( "" )
-            "^(.*\?)(\?::(\\((\?:"
-                "(" ana_cnv_xstr( ANA_TT_I )   ")|(" ana_cnv_xstr( ANA_TT_U )   ")|"
-                "(" ana_cnv_xstr( ANA_TT_L )   ")|(" ana_cnv_xstr( ANA_TT_UL )  ")|"
-                "(" ana_cnv_xstr( ANA_TT_C )   ")|(" ana_cnv_xstr( ANA_TT_UC )  ")|"
-                "(" ana_cnv_xstr( ANA_TT_S )   ")|(" ana_cnv_xstr( ANA_TT_US )  ")|"
-                "(" ana_cnv_xstr( ANA_TT_LL )  ")|(" ana_cnv_xstr( ANA_TT_ULL ) ")|"
-                "(" ana_cnv_xstr( ANA_TT_B )   ")|(" ana_cnv_xstr( ANA_TT_SZ )  ")|"
-                "(" ana_cnv_xstr( ANA_TT_DT )  ")|(" ana_cnv_xstr( ANA_TT_FLT ) ")|"
-                "(" ana_cnv_xstr( ANA_TT_DBL ) ")|(" ana_cnv_xstr( ANA_TT_CUR ) ")|"
-                "(" ana_cnv_xstr( ANA_TT_SV )   ")|(" ana_cnv_xstr( ANA_TT_DAB )  ")|"
-                "(" ana_cnv_xstr( ANA_TT_VB )   ")"
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                "|(" ana_cnv_xstr( ANA_TT_STR )  ")"
-                "|(" ana_cnv_xstr( ANA_TT_WSTR ) ")"
-#endif
-            "))\\))\?$"
+
+    static int ReadInteger( Store::TValue const & Val ) {
+        return static_cast<int>( Expect( Val, Store::TType::Dword, 4 ).GetDword() );
+    }
+
+    template<typename T>
+    static T ReadQWORD( Store::TValue const & Val ) {
+        return static_cast<T>( Expect( Val, Store::TType::Qword, 8 ).GetQword() );
+    }
+
+    // TDateTime, float, double and Currency: 8 bytes of REG_BINARY.
+    template<typename T>
+    static T ReadBinary8( Store::TValue const & Val ) {
+        static_assert( sizeof( T ) == 8 );
+        T Result;
+        std::memcpy( &Result, Expect( Val, Store::TType::Binary, 8 ).Data, 8 );
+        return Result;
+    }
+
+    static String ReadString( Store::TValue const & Val ) {
+        if ( Val.Type != Store::TType::Sz && Val.Type != Store::TType::ExpandSz ) {
+            Expect( Val, Store::TType::Sz );
+        }
+        return ToString( Val.GetString() );
+    }
+
+    static String ReadExpandString( Store::TValue const & Val ) {
+        std::array<TCHAR,32767> Buffer;
+
+        auto const Ret = ::ExpandEnvironmentStrings(
+            ReadString( Val ).c_str(),
+            Buffer.data(), Buffer.size()
         );
 
-        using RegObjType = std::remove_reference_t<decltype( *registry_ )>;
+        if ( Ret && Ret <= Buffer.size() ) {
+            // Ret includes the null terminator; exclude it
+            return String( Buffer.data(), Ret - 1 );
+        }
 
+        throw ERegistryException(
+            &_SRegGetDataFailed, ARRAYOFCONST(( ToString( Val.Name ) ))
+        );
+    }
+
+    static StringCont ReadStrings( Store::TValue const & Val ) {
+        StringCont Strings;
+        Expect( Val, Store::TType::MultiSz ).ForEachString(
+            [&Strings]( Store::TStringView Item ) { Strings.push_back( ToString( Item ) ); }
+        );
+        return Strings;
+    }
+
+    static TBytes ReadBinaryData( Store::TValue const & Val ) {
+        Expect( Val, Store::TType::Binary );
+        TBytes Data;
+        Data.Length = static_cast<int>( Val.Size );
+        if ( Val.Size ) {
+            std::memcpy( &Data[0], Val.Data, Val.Size );
+        }
+        return Data;
+    }
+protected:
+    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
         using ValueBuilder =
-            std::function<
-                TConfigNodeValueType (
-                    RegObjType &, // Registry Object
-                    String        // Key Name
-                )
-            >;
+            std::function<TConfigNodeValueType ( Store::TValue const & )>;
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        static std::array<ValueBuilder,std::variant_size<TConfigNodeValueType>::value> Builders {
-#else
-        static std::array<ValueBuilder,TConfigNodeValueType::types::size::value> Builders {
-#endif
+        static std::array<ValueBuilder,TConfigNodeValueType::AlternativeCount> Builders {
 
             // CLASS  TAG         REG_DYPE      API
             // -----  -------     ------------  ----------------
 
             // i32    (TT_I)      REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadInteger( KeyName );
+            []( Store::TValue const & Val ) {
+                return ReadInteger( Val );
             },
 
             // u32    (TT_U)      REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<unsigned>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<unsigned>( ReadInteger( Val ) );
             },
 
             // i32    (TT_L)      REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<long>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<long>( ReadInteger( Val ) );
             },
 
             // u32    (TT_UL)     REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<unsigned long>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<unsigned long>( ReadInteger( Val ) );
             },
 
             // i8     (TT_C)      REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<char>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<char>( ReadInteger( Val ) );
             },
 
             // u8     (TT_UC)     REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<unsigned char>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<unsigned char>( ReadInteger( Val ) );
             },
 
             // i16    (TT_S)      REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<short>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<short>( ReadInteger( Val ) );
             },
 
             // u16    (TT_US)     REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<unsigned short>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<unsigned short>( ReadInteger( Val ) );
             },
 
             // i64    (TT_LL)     REG_QWORD     ReadQWORD
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadQWORD<long long>( KeyName );
+            []( Store::TValue const & Val ) {
+                return ReadQWORD<long long>( Val );
             },
 
             // u64    (TT_ULL)    REG_QWORD     ReadQWORD
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadQWORD<unsigned long long>( KeyName );
+            []( Store::TValue const & Val ) {
+                return ReadQWORD<unsigned long long>( Val );
             },
 
             // u8     (TT_B)      REG_DWORD     ReadInteger
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<bool>( Reg.ReadInteger( KeyName ) );
+            []( Store::TValue const & Val ) {
+                return static_cast<bool>( ReadInteger( Val ) );
             },
 
             // sz     (TT_SZ)     REG_SZ        ReadString
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadString( KeyName );
+            []( Store::TValue const & Val ) {
+                return ReadString( Val );
             },
 
-            // b8     (TT_DT)     REG_BINARY    ReadDateTime
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadDateTime( KeyName );
+            // b8     (TT_DT)     REG_BINARY    ReadBinary8
+            []( Store::TValue const & Val ) {
+                return System::TDateTime( ReadBinary8<double>( Val ) );
             },
 
-            // b8     (TT_FLT)    REG_BINARY    ReadFloat
-            []( RegObjType& Reg, String KeyName ) {
-                return static_cast<float>( Reg.ReadFloat( KeyName ) );
+            // b8     (TT_FLT)    REG_BINARY    ReadBinary8
+            []( Store::TValue const & Val ) {
+                return static_cast<float>( ReadBinary8<double>( Val ) );
             },
 
-            // b8     (TT_DBL)    REG_BINARY    ReadFloat
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadFloat( KeyName );
+            // b8     (TT_DBL)    REG_BINARY    ReadBinary8
+            []( Store::TValue const & Val ) {
+                return ReadBinary8<double>( Val );
             },
 
-            // b8     (TT_CUR)    REG_BINARY    ReadCurrency
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadCurrency( KeyName );
+            // b8     (TT_CUR)    REG_BINARY    ReadBinary8
+            []( Store::TValue const & Val ) {
+                System::Currency Result;
+                Result.Val = ReadBinary8<__int64>( Val );
+                return Result;
             },
 
-            // sv     (TT_SV)     REG_MULTI_SZ  ReadStringsTo
-            []( RegObjType& Reg, String KeyName ) {
-                StringCont Strings;
-                Reg.ReadStringsTo( KeyName, std::back_inserter( Strings ) );
-                return std::move( Strings );
+            // sv     (TT_SV)     REG_MULTI_SZ  ReadStrings
+            []( Store::TValue const & Val ) {
+                return ReadStrings( Val );
             },
 
             // dab    (TT_DAB)    REG_BINARY    ReadBinaryData
-            []( RegObjType& Reg, String KeyName ) {
-                return Reg.ReadBinaryData( KeyName );
+            []( Store::TValue const & Val ) {
+                return ReadBinaryData( Val );
             },
 
-            // vb     (TT_VB)     REG_BINARY    ReadBinaryDataTo
-            []( RegObjType& Reg, String KeyName ) {
-                auto Size = Reg.GetDataSize( KeyName );
-                if ( Size < 0 ) {
-                    throw Exception(
-                        _D( "Registry Key %s\\%s has invalid data size" ),
-                        ARRAYOFCONST((
-                            Reg.CurrentPath,
-                            KeyName
-                        ))
-                    );
-                }
-                std::vector<Byte> Bytes;
-                Bytes.reserve( Size );
-                Reg.ReadBinaryDataTo( KeyName, std::back_inserter( Bytes ) );
-                return std::move( Bytes );
+            // vb     (TT_VB)     REG_BINARY    Data
+            []( Store::TValue const & Val ) {
+                Expect( Val, Store::TType::Binary );
+                return std::vector<Byte>( Val.Data, Val.Data + Val.Size );
             },
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            // str    (TT_STR)    REG_SZ        ReadString → std::string (UTF-8)  bcc64x only
-            []( RegObjType& Reg, String KeyName ) {
-                return std::string( UTF8Encode( Reg.ReadString( KeyName ) ).c_str() );
+            // str    (TT_STR)    REG_SZ        ReadString → std::string (UTF-8)
+            []( Store::TValue const & Val ) {
+                return std::string( UTF8Encode( ReadString( Val ) ).c_str() );
             },
 
-            // wstr   (TT_WSTR)   REG_SZ        ReadString → std::wstring (UTF-16) bcc64x only
-            []( RegObjType& Reg, String KeyName ) {
-                auto s = Reg.ReadString( KeyName );
+            // wstr   (TT_WSTR)   REG_SZ        ReadString → std::wstring (UTF-16)
+            []( Store::TValue const & Val ) {
+                auto s = ReadString( Val );
                 return std::wstring( s.c_str() );
             },
-#endif
         };
 
         struct PutItem {
@@ -682,115 +969,81 @@ protected:
             }
         };
 
-        ValueContType Values;
-        if ( OpenKeyReadOnly( GetKeyName( Path ) ) ) {
-            auto RegValues = std::make_unique<TStringList>();
-            registry_->GetValueNames( RegValues.get() );
-            cmatch_type ms;
-            for ( auto ValueName : RegValues.get() ) {
-                if ( regex_match( ValueName.c_str(), ms, re ) ) {
-                    auto It = std::begin( ms );
-                    std::advance( It, 1 );
-                    String const Name = It->str().c_str();
-                    std::advance( It, 2 );
-                    It =
-                        find_if(
-                            It, std::end( ms ),
-                            []( auto const & m ) { return m.matched; }
+        auto Values = NewValueList();
+        if ( auto const Key = OpenKeyReadOnly( GetKeyName( Path ) ) ) {
+            // One pass: name, type and data of each value come together.
+            Store::ForEachValue( *Key, [&]( Store::TValue const & Val ) {
+                // Value names are encoded as "Name:(TypeTag)"; anything
+                // else is read by its registry data type, under its own name.
+                auto NameView = Val.Name;
+                if ( auto const Tag = DecodeTagSuffix( NameView, ":(", NameView ) ) {
+                    PutItem{}(
+                        Values, ToString( NameView ),
+                        Builders[static_cast<size_t>( *Tag )]( Val )
+                    );
+                    return;
+                }
+                auto const ValueName = ToString( Val.Name );
+                switch ( Val.Type ) {
+                    case Store::TType::Binary:
+                        PutItem{}( Values, ValueName, ReadBinaryData( Val ) );
+                        break;
+                    case Store::TType::Dword:
+                        PutItem{}( Values, ValueName, ReadInteger( Val ) );
+                        break;
+                    case Store::TType::MultiSz:
+                        PutItem{}( Values, ValueName, ReadStrings( Val ) );
+                        break;
+                    case Store::TType::Qword:
+                        PutItem{}( Values, ValueName, ReadQWORD<long long>( Val ) );
+                        break;
+                    case Store::TType::Sz:
+                        PutItem{}( Values, ValueName, ReadString( Val ) );
+                        break;
+                    case Store::TType::ExpandSz:
+                        PutItem{}( Values, ValueName, ReadExpandString( Val ) );
+                        break;
+                    default:
+                        throw Exception(
+                            _D( "Registry Key %s\\%s has an invalid data type" ),
+                            ARRAYOFCONST((
+                                keyPath_,
+                                ValueName
+                            ))
                         );
-                    if ( It != std::end( ms ) ) {
-                        auto const Idx = distance( std::begin( ms ), It ) - 3;
-                        if ( Idx < 0 ||
-                             static_cast<size_t>( Idx ) >= Builders.size() )
-                        {
-                            continue; // skip malformed value names
-                        }
-                        auto Val = Builders[Idx]( *registry_, ValueName );
-                        PutItem{}( Values, Name, Val );
-                    }
-                    else {
-                        auto [Type,Size] = registry_->GetExDataType( ValueName );
-                        switch ( Type ) {
-                            case TExRegDataType::Binary:
-                                PutItem{}(
-                                    Values, Name,
-                                    registry_->ReadBinaryData( ValueName )
-                                );
-                                break;
-                            case TExRegDataType::Dword:
-                                PutItem{}(
-                                    Values, Name,
-                                    registry_->ReadInteger( ValueName )
-                                );
-                                break;
-                            case TExRegDataType::MultiSz: {
-                                    StringCont Strings;
-                                    registry_->ReadStringsTo(
-                                        ValueName,
-                                        std::back_inserter( Strings )
-                                    );
-                                    PutItem{}( Values, Name, Strings );
-                                }
-                                break;
-                            case TExRegDataType::Qword:
-                                PutItem{}(
-                                    Values, Name,
-                                    registry_->ReadQWORD<long long>( ValueName )
-                                );
-                                break;
-                            case TExRegDataType::Sz:
-                                PutItem{}(
-                                    Values, Name,
-                                    registry_->ReadString( ValueName )
-                                );
-                                break;
-                            case TExRegDataType::ExpandSz:
-                                PutItem{}(
-                                    Values, Name,
-                                    registry_->ReadExpandString( ValueName )
-                                );
-                                break;
-                            default:
-                                throw Exception(
-                                    _D( "Registry Key %s\\%s has an invalid data type" ),
-                                    ARRAYOFCONST((
-                                        registry_->CurrentPath,
-                                        ValueName
-                                    ))
-                                );
-                        }
-                    }
                 }
-            }
+            } );
         }
         return Values;
     }
 
     virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
-        NodeContType Nodes;
+        auto Nodes = NewNodeList();
 
-        if ( OpenKeyReadOnly( GetKeyName( Path ) ) ) {
-            auto RegKeys = std::make_unique<TStringList>();
-            registry_->GetKeyNames( RegKeys.get() );
-            for ( auto const & Key : RegKeys.get() ) {
-                Nodes[Key] = std::move( std::make_unique<TConfigNode>() );
-            }
+        if ( auto const Key = OpenKeyReadOnly( GetKeyName( Path ) ) ) {
+            Store::ForEachKey( *Key, [&]( Store::TStringView Name ) {
+                Nodes[ToString( Name )] = NewNode();
+            } );
         }
         return Nodes;
     }
 
     virtual void DoSaveValueList( TConfigPath const & Path, ValueContType const & Values ) override {
         if ( !Values.empty() ) {
-            if ( OpenKey( GetKeyName( Path ), true ) ) {
+            if ( auto const Key = OpenKey( GetKeyName( Path ), true ) ) {
+                batch_.Clear();
                 for ( auto& v : Values ) {
                     auto const ValueState = v.second.second;
                     if ( GetAlwaysFlushNodeFlag() || ValueState == Operation::Write ) {
-                        SaveValue( *registry_, v );
+                        SaveValue( batch_, v );
                     }
                     else if ( v.second.second == Operation::Erase ) {
-                        DeleteValue( v );
+                        batch_.Delete( View( v.first ) );
                     }
                 }
+                if ( !batch_.Empty() ) {
+                    Key->Apply( batch_ );
+                }
             }
             else {
                 throw ERegistryException(
@@ -805,27 +1058,38 @@ protected:
     }
 
     virtual void DoFlush() override {
-        RegObjRAII Reg{ *this };
-        GetRootNode().Write( *this, TConfigPath{} );
+        {
+            KeyRAII Key{ *this };
+            GetRootNode().Write( *this, TConfigPath{} );
+        }
+        SealSnapshot();
     }
 
+    // Lazy mode: every on-demand load opens only the keys it reads.
+    virtual void DoEndLazyRead() override { CloseKey(); }
+
     virtual bool DoGetForcedWritesFlag() const { return false; }
 private:
-    class RegObjRAII {
+    // Closes the key kept open between calls when the operation ends.
+    class KeyRAII {
     public:
-        RegObjRAII( TConfig& Cfg ) : cfg_{ Cfg } { Cfg.CreateRegistryObject(); }
-        ~RegObjRAII() {
-            try { cfg_.DestroyAndCloseRegistryObject(); } catch ( ... ) {}
-        }
-        RegObjRAII( RegObjRAII const & ) = delete;
-        RegObjRAII& operator=( RegObjRAII const & ) = delete;
+        KeyRAII( TConfig& Cfg ) noexcept : cfg_{ Cfg } {}
+        ~KeyRAII() { cfg_.CloseKey(); }
+        KeyRAII( KeyRAII const & ) = delete;
+        KeyRAII& operator=( KeyRAII const & ) = delete;
     private:
         TConfig& cfg_;
     };
 
     String rootPath_;
-    HKEY hKey_;
-    std::unique_ptr<TRegistry> registry_;
+    String snapshotFile_;
+    std::unique_ptr<Store::TStore> ownStore_;
+    std::unique_ptr<Store::TSnapshot> snapshot_;
+    Store::TStore& store_;
+    std::unique_ptr<Store::TKey> key_;
+    String keyPath_;
+    bool keyWritable_ {};
+    Store::TBatch batch_;
 
     static void ValidatePathComponent( String const & Component ) {
         if ( Component.Pos( _D( "\\" ) ) > 0 ||
@@ -850,42 +1114,85 @@ private:
         return SB->ToString();
     }
 
-    void CreateRegistryObject() {
-        registry_ =
-            GetReadOnlyFlag() ?
-              std::make_unique<Anafestica::Registry::TRegistry>( KEY_READ )
-            :
-              std::make_unique<Anafestica::Registry::TRegistry>();
-        registry_->RootKey = hKey_;
+    void CloseKey() noexcept {
+        key_.reset();
+        keyPath_ = String();
     }
 
-    void DestroyAndCloseRegistryObject() {
-        if ( !registry_->CurrentPath.IsEmpty() ) {
-            registry_->CloseKey();
+    // The key for Path, reusing the one kept open when it is the same
+    // (and, for writing, open for writing); nullptr when it cannot be
+    // opened.
+    Store::TKey* OpenKey( String Path, bool CanCreate = false ) {
+        String const Key = ExcludeTrailingBackslash( rootPath_ + Path );
+        if ( !key_ || keyPath_ != Key || ( CanCreate && !keyWritable_ ) ) {
+            CloseKey();
+            key_ = CanCreate ? store_.Create( View( Key ) ) : store_.Open( View( Key ) );
+            if ( key_ ) {
+                keyPath_ = Key;
+                keyWritable_ = CanCreate;
+            }
         }
-        registry_.reset();
+        return key_.get();
     }
 
-    bool OpenKey( String Path, bool CanCreate = false ) {
-        String const Key = ExcludeTrailingBackslash( rootPath_ + Path );
-        if ( registry_->CurrentPath != Key ) {
-            if ( !registry_->CurrentPath.IsEmpty() ) {
-                registry_->CloseKey();
+    Store::TKey* OpenKeyReadOnly( String Path ) { return OpenKey( Path ); }
+
+    // A snapshot in front of Source when there is a snapshot file.
+    std::unique_ptr<Store::TSnapshot> MakeSnapshot( Store::TStore& Source ) const {
+        if ( snapshotFile_.IsEmpty() ) {
+            return nullptr;
+        }
+        return std::make_unique<Store::TSnapshot>( Source, View( rootPath_ ) );
+    }
+
+    // The snapshot is a cache: a file that cannot be read or written
+    // costs a full read, never a failure.
+    void LoadSnapshot() {
+        if ( !snapshot_ || !FileExists( snapshotFile_ ) ) {
+            return;
+        }
+        try {
+            auto Stream = std::make_unique<TFileStream>(
+                snapshotFile_, fmOpenRead | fmShareDenyWrite
+            );
+            std::vector<unsigned char> Bytes( static_cast<size_t>( Stream->Size ) );
+            if ( !Bytes.empty() ) {
+                Stream->ReadBuffer( Bytes.data(), static_cast<NativeInt>( Bytes.size() ) );
+                snapshot_->Load( std::move( Bytes ) );
             }
-            return registry_->OpenKey( Key, CanCreate );
         }
-        return true;
+        catch ( Exception const & ) {
+        }
     }
 
-    bool OpenKeyReadOnly( String Path ) {
-        String const Key = ExcludeTrailingBackslash( rootPath_ + Path );
-        if ( registry_->CurrentPath != Key ) {
-            if ( !registry_->CurrentPath.IsEmpty() ) {
-                registry_->CloseKey();
+    // Checks the keys written against the registry, unless read-only,
+    // then saves what changed.
+    void SealSnapshot() {
+        if ( !snapshot_ ) {
+            return;
+        }
+        if ( !GetReadOnlyFlag() ) {
+            try {
+                snapshot_->Refresh();
+            }
+            catch ( ... ) {
+                // The keys written are out of the image already.
             }
-            return registry_->OpenKeyReadOnly( Key );
         }
-        return true;
+        SaveSnapshot();
+    }
+
+    void SaveSnapshot() {
+        if ( !snapshot_ || !snapshot_->IsModified() ) {
+            return;
+        }
+        auto const Image = snapshot_->Save();
+        try {
+            auto Stream = std::make_unique<TFileStream>( snapshotFile_, fmCreate );
+            Stream->WriteBuffer( Image.data(), static_cast<NativeInt>( Image.size() ) );
+        }
+        catch ( Exception const & ) {
+        }
     }
 
     // https://andreasfertig.blog/2023/07/visiting-a-stdvariant-safely/
@@ -912,12 +1219,64 @@ private:
     // template<class... Ts> struct overload : Ts... { using Ts::operator()...; };
     // template<class... Ts> overload( Ts... ) -> overload<Ts...>;
 
-    void SaveValue( TRegistry& Reg, ValueContType::value_type const & v ) {
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::visit(
-#else
-        boost::apply_visitor(
-#endif
+    // Lays the values out in a batch as the TRegistry write methods lay
+    // them out in the registry.
+    class TBatchWriter {
+    public:
+        explicit TBatchWriter( Store::TBatch& Batch ) noexcept : batch_{ Batch } {}
+
+        void WriteInteger( String const & Name, int Val ) {
+            batch_.SetDword( View( Name ), static_cast<std::uint32_t>( Val ) );
+        }
+
+        void WriteQWORD( String const & Name, unsigned long long Val ) {
+            batch_.SetQword( View( Name ), Val );
+        }
+
+        void WriteQWORD( String const & Name, long long Val ) {
+            WriteQWORD( Name, static_cast<unsigned long long>( Val ) );
+        }
+
+        void WriteString( String const & Name, String const & Val ) {
+            batch_.SetString( View( Name ), View( Val ) );
+        }
+
+        void WriteDateTime( String const & Name, System::TDateTime Val ) {
+            WriteFloat( Name, static_cast<double>( Val ) );
+        }
+
+        void WriteFloat( String const & Name, double Val ) {
+            batch_.Set( View( Name ), Store::TType::Binary, &Val, sizeof Val );
+        }
+
+        void WriteCurrency( String const & Name, System::Currency Val ) {
+            batch_.Set( View( Name ), Store::TType::Binary, &Val.Val, sizeof Val.Val );
+        }
+
+        void WriteStrings( String const & Name, StringCont const & Val ) {
+            batch_.SetStrings(
+                View( Name ), std::begin( Val ), std::end( Val ),
+                []( String const & Item ) { return View( Item ); }
+            );
+        }
+
+        void WriteBinaryData( String const & Name, TBytes Val ) {
+            batch_.Set(
+                View( Name ), Store::TType::Binary,
+                Val.Length > 0 ? &Val[0] : nullptr, Val.Length
+            );
+        }
+
+        void WriteBinaryData( String const & Name, std::vector<Byte> const & Val ) {
+            batch_.Set( View( Name ), Store::TType::Binary, Val.data(), Val.size() );
+        }
+    private:
+        Store::TBatch& batch_;
+    };
+
+    void SaveValue( Store::TBatch& Batch, ValueContType::value_type const & v ) {
+        TBatchWriter Reg( Batch );
+        Visit(
             overload {
                 // REG_BINARY    - Binary data in any form.
                 // REG_DWORD     - 32-bit number.
@@ -1109,8 +1468,7 @@ private:
                     );
                 },
 
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                // str    (TT_STR)   REG_SZ        WriteString (UTF-8 → UTF-16) bcc64x only
+                // str    (TT_STR)   REG_SZ        WriteString (UTF-8 → UTF-16)
                 [&Reg, &v]( std::string const & Val ) {
                     Reg.WriteString(
                         Format(
@@ -1121,7 +1479,7 @@ private:
                     );
                 },
 
-                // wstr   (TT_WSTR)  REG_SZ        WriteString (UTF-16) bcc64x only
+                // wstr   (TT_WSTR)  REG_SZ        WriteString (UTF-16)
                 [&Reg, &v]( std::wstring const & Val ) {
                     Reg.WriteString(
                         Format(
@@ -1131,7 +1489,6 @@ private:
                         String( Val.c_str() )
                     );
                 }
-#endif
             },
             v.second.first
         );
@@ -0,0 +1,1198 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgRegistryStoreH
+#define CfgRegistryStoreH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL
+// or on the Windows API, so it can be compiled and benchmarked on any C++17
+// toolchain (see Bench/bench_registry_store.cpp and
+// Bench/bench_registry_snapshot.cpp).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace Registry {
+//---------------------------------------------------------------------------
+namespace Store {
+//---------------------------------------------------------------------------
+
+/// Code unit of key names, value names and string data (UTF-16 on Windows).
+using TChar = wchar_t;
+using TStringView = std::basic_string_view<TChar>;
+using TString = std::basic_string<TChar>;
+
+/// Value types, numbered as the @c REG_* constants.
+enum class TType : std::uint32_t {
+    None = 0,           // REG_NONE
+    Sz = 1,             // REG_SZ
+    ExpandSz = 2,       // REG_EXPAND_SZ
+    Binary = 3,         // REG_BINARY
+    Dword = 4,          // REG_DWORD
+    DwordBigEndian = 5, // REG_DWORD_BIG_ENDIAN
+    Link = 6,           // REG_LINK
+    MultiSz = 7,        // REG_MULTI_SZ
+    Qword = 11          // REG_QWORD
+};
+
+/// One value of a key, as views into storage owned by whoever hands it
+/// out; valid for the duration of the call it is passed to.  @ref Data is
+/// aligned for @ref TChar.
+struct TValue {
+    TStringView Name;
+    TType Type {};
+    unsigned char const * Data {};
+    std::size_t Size {};
+
+    /// Payload of a Dword value (at least 4 bytes, host order).
+    [[nodiscard]] std::uint32_t GetDword() const noexcept {
+        std::uint32_t Result;
+        std::memcpy( &Result, Data, sizeof Result );
+        return Result;
+    }
+
+    /// Payload of a Qword value (at least 8 bytes, host order).
+    [[nodiscard]] std::uint64_t GetQword() const noexcept {
+        std::uint64_t Result;
+        std::memcpy( &Result, Data, sizeof Result );
+        return Result;
+    }
+
+    /// Text of an Sz or ExpandSz value, up to its first null.
+    [[nodiscard]] TStringView GetString() const noexcept {
+        TStringView const Text( reinterpret_cast<TChar const *>( Data ), Size / sizeof( TChar ) );
+        return Text.substr( 0, Text.find( TChar {} ) );
+    }
+
+    /// Calls @p Fn with each string of a MultiSz value: every run that a
+    /// null ends, except the empty one that ends the list.
+    template<typename F>
+    void ForEachString( F&& Fn ) const {
+        auto const Units = reinterpret_cast<TChar const *>( Data );
+        auto const Count = Size / sizeof( TChar );
+        std::size_t Start {};
+        for ( std::size_t Idx {} ; Idx < Count ; ++Idx ) {
+            if ( !Units[Idx] && Idx + 1 < Count ) {
+                Fn( TStringView( Units + Start, Idx - Start ) );
+                Start = Idx + 1;
+            }
+        }
+    }
+};
+
+/// Receives the values of a key from @ref TKey::EnumValues.
+class TValueVisitor {
+public:
+    virtual void Visit( TValue const & Value ) = 0;
+protected:
+    ~TValueVisitor() = default;
+};
+
+/// Receives the subkey names of a key from @ref TKey::EnumKeys.
+class TKeyVisitor {
+public:
+    virtual void Visit( TStringView Name ) = 0;
+protected:
+    ~TKeyVisitor() = default;
+};
+
+/// The writes to one key, gathered so that @ref TKey::Apply gets them in a
+/// single call.  Names and data are copied in; the buffers are kept by
+/// @ref Clear, so a batch reused key after key stops allocating.
+class TBatch {
+public:
+    /// Sets the value @p Name to @p Size bytes at @p Data, of type @p Type.
+    void Set( TStringView Name, TType Type, void const * Data, std::size_t Size ) {
+        auto const Offset = Reserve( Size );
+        if ( Size ) {
+            std::memcpy( data_.data() + Offset, Data, Size );
+        }
+        Push( Name, Type, Offset, Size, false );
+    }
+
+    void SetDword( TStringView Name, std::uint32_t Val ) {
+        Set( Name, TType::Dword, &Val, sizeof Val );
+    }
+
+    void SetQword( TStringView Name, std::uint64_t Val ) {
+        Set( Name, TType::Qword, &Val, sizeof Val );
+    }
+
+    /// Sets a string value; the data includes the terminating null.
+    void SetString( TStringView Name, TStringView Val, TType Type = TType::Sz ) {
+        auto const Size = ( Val.size() + 1 ) * sizeof( TChar );
+        auto const Offset = Reserve( Size );
+        auto const Units = reinterpret_cast<TChar*>( data_.data() + Offset );
+        Val.copy( Units, Val.size() );
+        Units[Val.size()] = TChar {};
+        Push( Name, Type, Offset, Size, false );
+    }
+
+    /// Sets a MultiSz value to the strings @p ToView( *It ) of
+    /// [@p Begin, @p End): each one null-terminated, then an empty one.
+    template<typename It, typename P>
+    void SetStrings( TStringView Name, It Begin, It End, P ToView ) {
+        std::size_t Length = 1;
+        for ( auto Cur = Begin ; Cur != End ; ++Cur ) {
+            Length += TStringView( ToView( *Cur ) ).size() + 1;
+        }
+        auto const Offset = Reserve( Length * sizeof( TChar ) );
+        auto Units = reinterpret_cast<TChar*>( data_.data() + Offset );
+        for ( ; Begin != End ; ++Begin ) {
+            TStringView const Item = ToView( *Begin );
+            Units += Item.copy( Units, Item.size() );
+            *Units++ = TChar {};
+        }
+        *Units = TChar {};
+        Push( Name, TType::MultiSz, Offset, Length * sizeof( TChar ), false );
+    }
+
+    /// Deletes the value @p Name, if there is one.
+    void Delete( TStringView Name ) { Push( Name, TType::None, 0, 0, true ); }
+
+    [[nodiscard]] bool Empty() const noexcept { return ops_.empty(); }
+
+    /// Number of writes in the batch.
+    [[nodiscard]] std::size_t Size() const noexcept { return ops_.size(); }
+
+    void Clear() noexcept {
+        ops_.clear();
+        names_.clear();
+        data_.clear();
+    }
+
+    /// Calls <tt>Fn( TValue const & Value, bool Erase )</tt> for each
+    /// write, in the order they were made.  The names are null-terminated.
+    template<typename F>
+    void ForEach( F&& Fn ) const {
+        for ( auto const & Op : ops_ ) {
+            TValue const Value {
+                TStringView( names_.data() + Op.NameOffset, Op.NameSize ),
+                Op.Type, data_.data() + Op.DataOffset, Op.DataSize
+            };
+            Fn( Value, Op.Erase );
+        }
+    }
+private:
+    struct TOp {
+        std::size_t NameOffset;
+        std::size_t NameSize;
+        std::size_t DataOffset;
+        std::size_t DataSize;
+        TType Type;
+        bool Erase;
+    };
+
+    std::vector<TOp> ops_;
+    std::vector<TChar> names_;
+    std::vector<unsigned char> data_;
+
+    // Room for Size bytes at an offset aligned for any payload.
+    std::size_t Reserve( std::size_t Size ) {
+        auto const Offset = ( data_.size() + alignof( std::uint64_t ) - 1 ) & ~( alignof( std::uint64_t ) - 1 );
+        data_.resize( Offset + Size );
+        return Offset;
+    }
+
+    void Push( TStringView Name, TType Type, std::size_t DataOffset,
+               std::size_t DataSize, bool Erase )
+    {
+        auto const NameOffset = names_.size();
+        names_.insert( names_.end(), Name.begin(), Name.end() );
+        names_.push_back( TChar {} );
+        ops_.push_back( { NameOffset, Name.size(), DataOffset, DataSize, Type, Erase } );
+    }
+};
+
+/// What a key tells about itself without reading its values: when it was
+/// last written, and how many values and subkeys it has.
+///
+/// Two stamps of a key are equal when, as far as the store can tell, it
+/// was not written in between.  A write that keeps both counts and lands
+/// within the resolution of the write time goes unnoticed.
+struct TStamp {
+    std::uint64_t WriteTime {};
+    std::uint32_t Values {};
+    std::uint32_t Keys {};
+
+    friend bool operator==( TStamp const & Lhs, TStamp const & Rhs ) noexcept {
+        return
+            Lhs.WriteTime == Rhs.WriteTime && Lhs.Values == Rhs.Values &&
+            Lhs.Keys == Rhs.Keys;
+    }
+
+    friend bool operator!=( TStamp const & Lhs, TStamp const & Rhs ) noexcept {
+        return !( Lhs == Rhs );
+    }
+};
+
+/// An open key.  Failures other than a missing value are reported by
+/// throwing.
+class TKey {
+public:
+    virtual ~TKey() = default;
+
+    /// Visits every value, name, type and data together, in one pass.
+    virtual void EnumValues( TValueVisitor& Visitor ) = 0;
+
+    /// Visits the name of every subkey.
+    virtual void EnumKeys( TKeyVisitor& Visitor ) = 0;
+
+    /// Visits the value @p Name; @c false when there is none.
+    virtual bool Query( TStringView Name, TValueVisitor& Visitor ) = 0;
+
+    /// Makes the writes of @p Batch, in order.
+    virtual void Apply( TBatch const & Batch ) = 0;
+
+    /// The stamp of the key now.
+    virtual TStamp GetStamp() = 0;
+};
+
+/// A tree of keys, such as a registry hive.  Paths are relative to the
+/// root of the store, their names separated by backslashes; names compare
+/// case-insensitively.  The keys a store hands out must not outlive it.
+class TStore {
+public:
+    virtual ~TStore() = default;
+
+    /// Opens the existing key @p Path for reading; @c nullptr when there
+    /// is none.
+    virtual std::unique_ptr<TKey> Open( TStringView Path ) = 0;
+
+    /// Opens the key @p Path for writing, creating it and its ancestors
+    /// as needed; @c nullptr when that is not possible.
+    virtual std::unique_ptr<TKey> Create( TStringView Path ) = 0;
+
+    /// Deletes the key @p Path with its values and subkeys; @c false when
+    /// there is no such key.
+    virtual bool Delete( TStringView Path ) = 0;
+};
+
+namespace Detail {
+
+template<typename F>
+struct TValueFn final : TValueVisitor {
+    F& Fn;
+    explicit TValueFn( F& Fn ) : Fn{ Fn } {}
+    void Visit( TValue const & Value ) override { Fn( Value ); }
+};
+
+template<typename F>
+struct TKeyFn final : TKeyVisitor {
+    F& Fn;
+    explicit TKeyFn( F& Fn ) : Fn{ Fn } {}
+    void Visit( TStringView Name ) override { Fn( Name ); }
+};
+
+// Calls Fn with each non-empty name of Path while it returns true; false
+// when it stopped early.
+template<typename F>
+bool ForEachName( TStringView Path, F&& Fn )
+{
+    while ( !Path.empty() ) {
+        auto const Sep = Path.find( TChar( '\\' ) );
+        auto const Name = Path.substr( 0, Sep );
+        if ( !Name.empty() && !Fn( Name ) ) {
+            return false;
+        }
+        Path.remove_prefix( Sep == TStringView::npos ? Path.size() : Sep + 1 );
+    }
+    return true;
+}
+
+} // End of namespace Detail
+
+/// @ref TKey::EnumValues with a callable, <tt>Fn( TValue const & )</tt>.
+template<typename F>
+void ForEachValue( TKey& Key, F&& Fn )
+{
+    Detail::TValueFn<F> Visitor( Fn );
+    Key.EnumValues( Visitor );
+}
+
+/// @ref TKey::EnumKeys with a callable, <tt>Fn( TStringView )</tt>.
+template<typename F>
+void ForEachKey( TKey& Key, F&& Fn )
+{
+    Detail::TKeyFn<F> Visitor( Fn );
+    Key.EnumKeys( Visitor );
+}
+
+/// @ref TKey::Query with a callable, <tt>Fn( TValue const & )</tt>.
+template<typename F>
+bool QueryValue( TKey& Key, TStringView Name, F&& Fn )
+{
+    Detail::TValueFn<F> Visitor( Fn );
+    return Key.Query( Name, Visitor );
+}
+
+/// @p Name folded for case-insensitive comparison, as the registry does:
+/// to upper case (ASCII directly, anything else through @c std::towupper).
+inline TString FoldName( TString&& Name )
+{
+    for ( auto& Ch : Name ) {
+        if ( Ch >= 'a' && Ch <= 'z' ) {
+            Ch = static_cast<TChar>( Ch - 'a' + 'A' );
+        }
+        else if ( Ch >= 0x80 ) {
+            Ch = static_cast<TChar>( std::towupper( static_cast<std::wint_t>( Ch ) ) );
+        }
+    }
+    return std::move( Name );
+}
+
+inline TString FoldName( TStringView Name )
+{
+    return FoldName( TString( Name ) );
+}
+
+/// A registry hive held in memory, for tests and benchmarks: keys and
+/// values with case-insensitive names that keep the case they were
+/// created with, typed data, and keys that stay usable through open
+/// handles until they are deleted.  Subkeys and values enumerate in
+/// folded-name order.  The write time of a stamp is a counter that every
+/// change to a key's values or subkeys advances.  Not thread-safe.
+class TMemoryHive final : public TStore {
+public:
+    TMemoryHive() : root_{ std::make_shared<TNode>() } {}
+
+    std::unique_ptr<TKey> Open( TStringView Path ) override {
+        auto Node = Find( Path );
+        return Node ? std::make_unique<TMemoryKey>( *this, std::move( Node ) ) : nullptr;
+    }
+
+    std::unique_ptr<TKey> Create( TStringView Path ) override {
+        auto Node = root_;
+        Detail::ForEachName( Path, [&]( TStringView Name ) {
+            auto& Child = Node->Keys[FoldName( Name )];
+            if ( !Child ) {
+                Child = std::make_shared<TNode>();
+                Child->Name.assign( Name );
+                Child->WriteTime = Node->WriteTime = ++clock_;
+            }
+            Node = Child;
+            return true;
+        } );
+        return std::make_unique<TMemoryKey>( *this, std::move( Node ) );
+    }
+
+    bool Delete( TStringView Path ) override {
+        std::shared_ptr<TNode> Parent;
+        auto Node = root_;
+        TString Folded;
+        auto const Found = Detail::ForEachName( Path, [&]( TStringView Name ) {
+            Folded = FoldName( Name );
+            auto const It = Node->Keys.find( Folded );
+            if ( It == Node->Keys.end() ) {
+                return false;
+            }
+            Parent = std::move( Node );
+            Node = It->second;
+            return true;
+        } );
+        if ( !Found || !Parent ) {
+            return false;
+        }
+        MarkDeleted( *Node );
+        Parent->Keys.erase( Folded );
+        Parent->WriteTime = ++clock_;
+        return true;
+    }
+
+    /// The value @p Name of the key @p Path, copied; @c false when there
+    /// is none.
+    [[nodiscard]] bool Get( TStringView Path, TStringView Name, TType& Type,
+                            std::vector<unsigned char>& Data ) const
+    {
+        if ( auto const Node = Find( Path ) ) {
+            auto const It = Node->Values.find( FoldName( Name ) );
+            if ( It != Node->Values.end() ) {
+                Type = It->second.Type;
+                Data = It->second.Data;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool KeyExists( TStringView Path ) const { return Find( Path ) != nullptr; }
+
+    /// Values handed out by @ref TKey::EnumValues and @ref TKey::Query so
+    /// far.
+    [[nodiscard]] std::size_t GetValueReads() const noexcept { return valueReads_; }
+private:
+    struct TData {
+        TString Name;
+        TType Type {};
+        std::vector<unsigned char> Data;
+    };
+
+    struct TNode {
+        TString Name;
+        std::map<TString,TData> Values;
+        std::map<TString,std::shared_ptr<TNode>> Keys;
+        std::uint64_t WriteTime {};
+        bool Deleted {};
+    };
+
+    class TMemoryKey final : public TKey {
+    public:
+        TMemoryKey( TMemoryHive& Hive, std::shared_ptr<TNode> Node ) noexcept
+            : hive_{ Hive }, node_{ std::move( Node ) } {}
+
+        void EnumValues( TValueVisitor& Visitor ) override {
+            for ( auto const & Value : Live().Values ) {
+                ++hive_.valueReads_;
+                Visitor.Visit( View( Value.second ) );
+            }
+        }
+
+        void EnumKeys( TKeyVisitor& Visitor ) override {
+            for ( auto const & Key : Live().Keys ) {
+                Visitor.Visit( Key.second->Name );
+            }
+        }
+
+        bool Query( TStringView Name, TValueVisitor& Visitor ) override {
+            auto const & Values = Live().Values;
+            auto const It = Values.find( FoldName( Name ) );
+            if ( It == Values.end() ) {
+                return false;
+            }
+            ++hive_.valueReads_;
+            Visitor.Visit( View( It->second ) );
+            return true;
+        }
+
+        void Apply( TBatch const & Batch ) override {
+            auto& Node = Live();
+            if ( Batch.Empty() ) {
+                return;
+            }
+            Node.WriteTime = ++hive_.clock_;
+            auto& Values = Node.Values;
+            Batch.ForEach( [&]( TValue const & Value, bool Erase ) {
+                if ( Erase ) {
+                    Values.erase( FoldName( Value.Name ) );
+                }
+                else {
+                    auto& Data = Values[FoldName( Value.Name )];
+                    if ( Data.Name.empty() ) {
+                        Data.Name.assign( Value.Name );
+                    }
+                    Data.Type = Value.Type;
+                    Data.Data.assign( Value.Data, Value.Data + Value.Size );
+                }
+            } );
+        }
+
+        TStamp GetStamp() override {
+            auto const & Node = Live();
+            return {
+                Node.WriteTime,
+                static_cast<std::uint32_t>( Node.Values.size() ),
+                static_cast<std::uint32_t>( Node.Keys.size() )
+            };
+        }
+    private:
+        TMemoryHive& hive_;
+        std::shared_ptr<TNode> node_;
+
+        // As the registry answers ERROR_KEY_DELETED.
+        TNode& Live() const {
+            if ( node_->Deleted ) {
+                throw std::runtime_error(
+                    "Illegal operation attempted on a registry key that has been marked for deletion"
+                );
+            }
+            return *node_;
+        }
+
+        static TValue View( TData const & Data ) noexcept {
+            return { Data.Name, Data.Type, Data.Data.data(), Data.Data.size() };
+        }
+    };
+
+    std::shared_ptr<TNode> root_;
+    std::uint64_t clock_ {};
+    std::size_t valueReads_ {};
+
+    std::shared_ptr<TNode> Find( TStringView Path ) const {
+        auto Node = root_;
+        auto const Found = Detail::ForEachName( Path, [&]( TStringView Name ) {
+            auto const It = Node->Keys.find( FoldName( Name ) );
+            if ( It == Node->Keys.end() ) {
+                return false;
+            }
+            Node = It->second;
+            return true;
+        } );
+        return Found ? Node : nullptr;
+    }
+
+    static void MarkDeleted( TNode& Node ) noexcept {
+        Node.Deleted = true;
+        for ( auto& Key : Node.Keys ) {
+            MarkDeleted( *Key.second );
+        }
+    }
+};
+
+/// A store that answers reads of the keys under a root key from an image
+/// of them (the stamp, values and subkey names of each key) kept in front
+/// of the store it mirrors, and that can be saved to bytes and loaded back,
+/// so that a process can start from the image its last run left behind.
+///
+/// The image is never trusted as a whole.  Every key is opened in the
+/// source and checked against its own stamp (see @ref TStamp), which any
+/// writer moves on, whether it goes through the snapshot or not: a key
+/// whose stamp still matches is answered from the image without reading
+/// its values or subkeys, any other key is read, on its own, its stamp
+/// taken first so that a change racing with the read shows up as a
+/// mismatch later.  A key that is gone is dropped from the image, with
+/// everything below it.
+///
+/// Writes go straight to the source.  The keys they touch, and their
+/// ancestors under the root, are dropped from the image and checked again
+/// by @ref Refresh, which re-reads those that changed.
+///
+/// @code
+/// Store::TSnapshot Snapshot( Hive, L"Software\\Vendor\\App" );
+/// Snapshot.Load( Bytes.data(), Bytes.size() );   // false: starts empty
+/// auto Key = Snapshot.Open( L"Software\\Vendor\\App\\MainForm" );
+/// ...
+/// Snapshot.Refresh();                            // after writing
+/// Bytes = Snapshot.Save();
+/// @endcode
+class TSnapshot final : public TStore {
+public:
+    /// Keys answered from the image, and keys read from the source.
+    struct TStats {
+        std::size_t Hits {};
+        std::size_t Misses {};
+    };
+
+    /// Mirrors the keys under @p Root of @p Source, which must outlive
+    /// the snapshot; the image starts empty.
+    TSnapshot( TStore& Source, TStringView Root )
+        : source_{ Source }, root_{ Normalize( Root ) } {}
+
+    /// Replaces the image with @p Bytes, which @ref Save produced for the
+    /// same root; @c false, leaving the image empty, when they are not
+    /// (truncated, damaged, or for another root).  They are checksummed
+    /// and indexed, not parsed: each key is read from them in place when
+    /// opened.
+    bool Load( std::vector<unsigned char> Bytes ) {
+        image_.reset();
+        index_.clear();
+        next_ = 0;
+        entries_.clear();
+        touched_.clear();
+        modified_ = true;
+        auto Image = std::make_shared<std::vector<unsigned char> const>( std::move( Bytes ) );
+        TReader In{ Image->data(), Image->data() + Image->size() };
+        if ( !In.Check() || !ReadIndex( In ) ) {
+            index_.clear();
+            return false;
+        }
+        image_ = std::move( Image );
+        modified_ = false;
+        return true;
+    }
+
+    /// The image as bytes for @ref Load, with a checksum at the end.
+    [[nodiscard]] std::vector<unsigned char> Save() {
+        TWriter Out;
+        Out.Bytes.reserve( image_ ? image_->size() : 0 );
+        Out.PutBytes( Magic, sizeof Magic );
+        Out.PutU32( sizeof( TChar ) );
+        Out.PutString( root_ );
+        auto const CountAt = Out.Bytes.size();
+        Out.PutU64( 0 );
+        std::uint64_t Count {};
+        auto const Put = [&]( TStringView Path, TEntry const & Entry ) {
+            Out.PutString( Path );
+            Out.PutU64( Entry.Size );
+            Out.PutBytes( Entry.Data, Entry.Size );
+            ++Count;
+        };
+        // Both are in path order, and no path is in both.
+        auto Read = entries_.cbegin();
+        for ( auto const & Image : index_ ) {
+            if ( Image.Dropped ) {
+                continue;
+            }
+            for ( ; Read != entries_.cend() && TStringView( Read->first ) < Image.Path ; ++Read ) {
+                Put( Read->first, EntryOf( Read->second ) );
+            }
+            Put( Image.Path, TEntry{ image_, Image.Data, Image.Size } );
+        }
+        for ( ; Read != entries_.cend() ; ++Read ) {
+            Put( Read->first, EntryOf( Read->second ) );
+        }
+        std::memcpy( Out.Bytes.data() + CountAt, &Count, sizeof Count );
+        Out.PutU64( Checksum( Out.Bytes.data(), Out.Bytes.size() ) );
+        modified_ = false;
+        return std::move( Out.Bytes );
+    }
+
+    /// @c true when the image changed since it was loaded or saved.
+    [[nodiscard]] bool IsModified() const noexcept { return modified_; }
+
+    /// Checks the keys written, created or deleted through the snapshot
+    /// since the last call against the source, re-reading those whose
+    /// stamp changed and dropping those that are gone.
+    void Refresh() {
+        auto const Paths = std::move( touched_ );
+        touched_.clear();
+        // A path sorts ahead of the paths below it.
+        for ( auto const & Path : Paths ) {
+            if ( auto const Key = source_.Open( Path ) ) {
+                Validate( *Key, Path );
+            }
+            else {
+                Forget( Path );
+            }
+        }
+    }
+
+    [[nodiscard]] TStats GetStats() const noexcept { return stats_; }
+
+    std::unique_ptr<TKey> Open( TStringView Path ) override {
+        auto Folded = Normalize( Path );
+        if ( !Covers( Folded ) ) {
+            return source_.Open( Path );
+        }
+        auto Key = source_.Open( Path );
+        if ( !Key ) {
+            Forget( Folded );
+            return nullptr;
+        }
+        auto Entry = Validate( *Key, Folded );
+        return std::make_unique<TImageKey>(
+            *this, std::move( Folded ), std::move( Entry ), std::move( Key )
+        );
+    }
+
+    std::unique_ptr<TKey> Create( TStringView Path ) override {
+        auto const Folded = Normalize( Path );
+        if ( Covers( Folded ) ) {
+            Invalidate( Folded );
+        }
+        return source_.Create( Path );
+    }
+
+    bool Delete( TStringView Path ) override {
+        auto const Folded = Normalize( Path );
+        if ( Covers( Folded ) ) {
+            Forget( Folded );
+            auto const Parent = ParentOf( Folded );
+            if ( Covers( Parent ) ) {
+                Invalidate( Parent );
+            }
+        }
+        return source_.Delete( Path );
+    }
+private:
+    // An entry of the image loaded, by path, in path order.
+    struct TIndexed {
+        TStringView Path;
+        unsigned char const * Data;
+        std::size_t Size;
+        bool Dropped;
+    };
+
+    // An entry is the stamp, values and subkey names of a key, laid out
+    // as bytes that are read in place (see ReadEntry and Walk), wherever
+    // they are kept: in the image loaded, or in a block of their own for
+    // a key read from the source.  Owner keeps them alive.
+    struct TEntry {
+        std::shared_ptr<void const> Owner;
+        unsigned char const * Data {};
+        std::size_t Size {};
+
+        explicit operator bool() const noexcept { return Data != nullptr; }
+    };
+
+    using TBlock = std::shared_ptr<std::vector<unsigned char> const>;
+
+    // Reads from the image, writes through the source key; once it has
+    // written, reads go to the source key too.
+    class TImageKey final : public TKey {
+    public:
+        TImageKey( TSnapshot& Owner, TString Path, TEntry Entry,
+                   std::unique_ptr<TKey> Key ) noexcept
+            : owner_{ Owner }, path_{ std::move( Path ) }
+            , entry_{ std::move( Entry ) }, key_{ std::move( Key ) } {}
+
+        void EnumValues( TValueVisitor& Visitor ) override {
+            if ( !entry_ ) {
+                key_->EnumValues( Visitor );
+                return;
+            }
+            Walk(
+                entry_,
+                [&Visitor]( TValue const & Value ) { Visitor.Visit( Value ); },
+                []( TStringView ) {}
+            );
+        }
+
+        void EnumKeys( TKeyVisitor& Visitor ) override {
+            if ( !entry_ ) {
+                key_->EnumKeys( Visitor );
+                return;
+            }
+            Walk(
+                entry_, nullptr,
+                [&Visitor]( TStringView Name ) { Visitor.Visit( Name ); }
+            );
+        }
+
+        bool Query( TStringView Name, TValueVisitor& Visitor ) override {
+            if ( !entry_ ) {
+                return key_->Query( Name, Visitor );
+            }
+            auto const Folded = FoldName( Name );
+            TValue Found {};
+            bool Matched {};
+            Walk(
+                entry_,
+                [&]( TValue const & Value ) {
+                    if ( !Matched && FoldName( Value.Name ) == Folded ) {
+                        Found = Value;
+                        Matched = true;
+                    }
+                },
+                []( TStringView ) {}
+            );
+            if ( Matched ) {
+                Visitor.Visit( Found );
+            }
+            return Matched;
+        }
+
+        void Apply( TBatch const & Batch ) override {
+            owner_.Invalidate( path_ );
+            entry_ = TEntry {};
+            key_->Apply( Batch );
+        }
+
+        TStamp GetStamp() override { return key_->GetStamp(); }
+    private:
+        TSnapshot& owner_;
+        TString path_;
+        TEntry entry_;
+        std::unique_ptr<TKey> key_;
+    };
+
+    // Strings and payloads start on 8-byte boundaries, so that they can
+    // be read in place.
+    struct TWriter {
+        std::vector<unsigned char> Bytes;
+
+        void PutBytes( void const * Data, std::size_t Size ) {
+            auto const Offset = Bytes.size();
+            Bytes.resize( Offset + Size );
+            if ( Size ) {
+                std::memcpy( Bytes.data() + Offset, Data, Size );
+            }
+        }
+
+        void PutU32( std::uint32_t Val ) { PutBytes( &Val, sizeof Val ); }
+        void PutU64( std::uint64_t Val ) { PutBytes( &Val, sizeof Val ); }
+
+        void Align() { Bytes.resize( ( Bytes.size() + 7 ) & ~std::size_t( 7 ) ); }
+
+        void PutString( TStringView Text ) {
+            PutU32( static_cast<std::uint32_t>( Text.size() ) );
+            PutBytes( Text.data(), Text.size() * sizeof( TChar ) );
+            Align();
+        }
+
+        void PutData( void const * Data, std::size_t Size ) {
+            PutBytes( Data, Size );
+            Align();
+        }
+    };
+
+    // Every read checks the bytes left, so that a damaged image fails
+    // instead of reading past its end.  The bytes start on an 8-byte
+    // boundary.
+    struct TReader {
+        unsigned char const * Pos;
+        unsigned char const * End;
+
+        bool GetBytes( void* Data, std::size_t Size ) noexcept {
+            if ( static_cast<std::size_t>( End - Pos ) < Size ) {
+                return false;
+            }
+            std::memcpy( Data, Pos, Size );
+            Pos += Size;
+            return true;
+        }
+
+        bool GetU32( std::uint32_t& Val ) noexcept { return GetBytes( &Val, sizeof Val ); }
+        bool GetU64( std::uint64_t& Val ) noexcept { return GetBytes( &Val, sizeof Val ); }
+
+        bool Align() noexcept {
+            auto const Pad = ( 8 - reinterpret_cast<std::uintptr_t>( Pos ) % 8 ) % 8;
+            if ( static_cast<std::size_t>( End - Pos ) < Pad ) {
+                return false;
+            }
+            Pos += Pad;
+            return true;
+        }
+
+        bool GetData( unsigned char const *& Data, std::uint64_t Size ) noexcept {
+            if ( static_cast<std::uint64_t>( End - Pos ) < Size ) {
+                return false;
+            }
+            Data = Pos;
+            Pos += Size;
+            return Align();
+        }
+
+        bool GetString( TStringView& Text ) noexcept {
+            std::uint32_t Length {};
+            unsigned char const * Data {};
+            if ( !GetU32( Length ) ||
+                 !GetData( Data, std::uint64_t( Length ) * sizeof( TChar ) ) )
+            {
+                return false;
+            }
+            Text = TStringView( reinterpret_cast<TChar const *>( Data ), Length );
+            return true;
+        }
+
+        // Strips the checksum off the end when it matches the rest.
+        bool Check() noexcept {
+            std::uint64_t Sum {};
+            if ( static_cast<std::size_t>( End - Pos ) < sizeof Sum ) {
+                return false;
+            }
+            End -= sizeof Sum;
+            std::memcpy( &Sum, End, sizeof Sum );
+            return Sum == Checksum( Pos, End - Pos );
+        }
+    };
+
+    static constexpr char Magic[8] = { 'A', 'n', 'a', 'R', 'e', 'g', 'S', '3' };
+
+    TStore& source_;
+    TString root_;
+    TBlock image_;
+    std::vector<TIndexed> index_;
+    std::size_t next_ {};
+    std::map<TString,TBlock> entries_;  // read from the source since
+    std::set<TString> touched_;
+    TStats stats_;
+    bool modified_ {};
+
+    // FNV-1a over 64-bit words, in four lanes that do not wait for one
+    // another, then over the bytes after the last word: a check against
+    // damage that keeps up with reading the image.
+    static std::uint64_t Checksum( unsigned char const * Data, std::size_t Size ) noexcept {
+        std::uint64_t Lanes[4] = {
+            0xCBF29CE484222325ULL, 0xCBF29CE484222325ULL ^ 1,
+            0xCBF29CE484222325ULL ^ 2, 0xCBF29CE484222325ULL ^ 3
+        };
+        for ( ; Size >= sizeof Lanes ; Size -= sizeof Lanes ) {
+            for ( auto& Lane : Lanes ) {
+                std::uint64_t Word;
+                std::memcpy( &Word, Data, sizeof Word );
+                Lane = ( Lane ^ Word ) * 0x100000001B3ULL;
+                Data += sizeof Word;
+            }
+        }
+        std::uint64_t Hash {};
+        for ( auto const Lane : Lanes ) {
+            Hash = ( Hash ^ Lane ) * 0x100000001B3ULL;
+        }
+        while ( Size-- ) {
+            Hash = ( Hash ^ *Data++ ) * 0x100000001B3ULL;
+        }
+        return Hash;
+    }
+
+    // The header of the image, then the path and size of each entry, in
+    // strictly increasing path order.  The entries are not walked here:
+    // Walk checks the bytes of one as it reads them.
+    bool ReadIndex( TReader& In ) {
+        char Head[sizeof Magic];
+        std::uint32_t CharSize {};
+        TStringView Path;
+        std::uint64_t Count {};
+        if ( !In.GetBytes( Head, sizeof Head ) ||
+             std::memcmp( Head, Magic, sizeof Head ) ||
+             !In.GetU32( CharSize ) || CharSize != sizeof( TChar ) ||
+             !In.GetString( Path ) || Path != root_ ||
+             !In.GetU64( Count ) ||
+             Count > static_cast<std::uint64_t>( In.End - In.Pos ) )
+        {
+            return false;
+        }
+        index_.reserve( static_cast<std::size_t>( Count ) );
+        while ( Count-- ) {
+            std::uint64_t Size {};
+            unsigned char const * Data {};
+            if ( !In.GetString( Path ) || !In.GetU64( Size ) || !In.GetData( Data, Size ) ||
+                 ( !index_.empty() && !( index_.back().Path < Path ) ) )
+            {
+                return false;
+            }
+            index_.push_back( { Path, Data, static_cast<std::size_t>( Size ), false } );
+        }
+        return In.Pos == In.End;
+    }
+
+    // The stamp at the head of an entry.
+    static TStamp StampOf( TEntry const & Entry ) noexcept {
+        TStamp Stamp;
+        TReader In{ Entry.Data, Entry.Data + Entry.Size };
+        In.GetU64( Stamp.WriteTime );
+        In.GetU32( Stamp.Values );
+        In.GetU32( Stamp.Keys );
+        return Stamp;
+    }
+
+    // Calls OnValue with each value and OnKey with each subkey name of
+    // Entry, skipping the values when there is no OnValue; false when
+    // its bytes are not an entry.
+    //
+    // An entry: the stamp, the number of values and of subkeys and where
+    // the subkeys start, then each value (type, size, name and data) and
+    // each subkey name.
+    template<typename FV, typename FK>
+    static bool Walk( TEntry const & Entry, FV&& OnValue, FK&& OnKey ) {
+        TReader In{ Entry.Data, Entry.Data + Entry.Size };
+        TStamp Stamp;
+        std::uint32_t Values {};
+        std::uint32_t Keys {};
+        std::uint32_t KeysAt {};
+        std::uint32_t Pad {};
+        if ( !In.GetU64( Stamp.WriteTime ) || !In.GetU32( Stamp.Values ) ||
+             !In.GetU32( Stamp.Keys ) || !In.GetU32( Values ) || !In.GetU32( Keys ) ||
+             !In.GetU32( KeysAt ) || !In.GetU32( Pad ) )
+        {
+            return false;
+        }
+        if constexpr ( std::is_same_v<std::decay_t<FV>,std::nullptr_t> ) {
+            if ( KeysAt < static_cast<std::size_t>( In.Pos - Entry.Data ) ||
+                 KeysAt > Entry.Size || KeysAt % 8 )
+            {
+                return false;
+            }
+            In.Pos = Entry.Data + KeysAt;
+            Values = 0;
+        }
+        while ( Values-- ) {
+            TValue Value;
+            std::uint32_t Type {};
+            std::uint32_t Size {};
+            if ( !In.GetU32( Type ) || !In.GetU32( Size ) || !In.GetString( Value.Name ) ||
+                 !In.GetData( Value.Data, Size ) )
+            {
+                return false;
+            }
+            Value.Type = static_cast<TType>( Type );
+            Value.Size = Size;
+            if constexpr ( !std::is_same_v<std::decay_t<FV>,std::nullptr_t> ) {
+                OnValue( Value );
+            }
+        }
+        while ( Keys-- ) {
+            TStringView Name;
+            if ( !In.GetString( Name ) ) {
+                return false;
+            }
+            OnKey( Name );
+        }
+        return In.Pos == In.End;
+    }
+
+    // Key, stamped Stamp, as an entry.
+    static TBlock ReadEntry( TKey& Key, TStamp const & Stamp ) {
+        TWriter Out;
+        Out.PutU64( Stamp.WriteTime );
+        Out.PutU32( Stamp.Values );
+        Out.PutU32( Stamp.Keys );
+        Out.PutU32( 0 );
+        Out.PutU32( 0 );
+        Out.PutU32( 0 );
+        Out.PutU32( 0 );
+        std::uint32_t Values {};
+        ForEachValue( Key, [&]( TValue const & Value ) {
+            Out.PutU32( static_cast<std::uint32_t>( Value.Type ) );
+            Out.PutU32( static_cast<std::uint32_t>( Value.Size ) );
+            Out.PutString( Value.Name );
+            Out.PutData( Value.Data, Value.Size );
+            ++Values;
+        } );
+        auto const KeysAt = static_cast<std::uint32_t>( Out.Bytes.size() );
+        std::uint32_t Keys {};
+        ForEachKey( Key, [&]( TStringView Name ) {
+            Out.PutString( Name );
+            ++Keys;
+        } );
+        std::memcpy( Out.Bytes.data() + 16, &Values, sizeof Values );
+        std::memcpy( Out.Bytes.data() + 20, &Keys, sizeof Keys );
+        std::memcpy( Out.Bytes.data() + 24, &KeysAt, sizeof KeysAt );
+        return std::make_shared<std::vector<unsigned char> const>( std::move( Out.Bytes ) );
+    }
+
+    static TEntry EntryOf( TBlock const & Block ) noexcept {
+        return { Block, Block->data(), Block->size() };
+    }
+
+    // The image entry at Path or after it.
+    std::vector<TIndexed>::iterator LowerBound( TStringView Path ) {
+        return std::lower_bound(
+            index_.begin(), index_.end(), Path,
+            []( TIndexed const & Lhs, TStringView Rhs ) { return Lhs.Path < Rhs; }
+        );
+    }
+
+    // A tree is read in much the order its paths sort in, so the entry
+    // after the one found last is tried before searching.
+    TEntry Find( TString const & Path ) {
+        auto const Read = entries_.find( Path );
+        if ( Read != entries_.end() ) {
+            return EntryOf( Read->second );
+        }
+        auto It = index_.begin() + std::min( next_, index_.size() );
+        if ( It == index_.end() || It->Path != Path ) {
+            It = LowerBound( Path );
+        }
+        if ( It != index_.end() && It->Path == Path && !It->Dropped ) {
+            next_ = static_cast<std::size_t>( It - index_.begin() ) + 1;
+            return { image_, It->Data, It->Size };
+        }
+        return {};
+    }
+
+    // Drops Path, not what is below it, from the image.
+    void Drop( TString const & Path ) {
+        modified_ |= entries_.erase( Path ) != 0;
+        auto const It = LowerBound( Path );
+        if ( It != index_.end() && It->Path == Path && !It->Dropped ) {
+            It->Dropped = true;
+            modified_ = true;
+        }
+    }
+
+    // The path with its names folded, joined by single backslashes.
+    static TString Normalize( TStringView Path ) {
+        TString Result;
+        Result.reserve( Path.size() );
+        Detail::ForEachName( Path, [&Result]( TStringView Name ) {
+            if ( !Result.empty() ) {
+                Result += TChar( '\\' );
+            }
+            Result += Name;
+            return true;
+        } );
+        return FoldName( std::move( Result ) );
+    }
+
+    static TString ParentOf( TString const & Path ) {
+        auto const Sep = Path.rfind( TChar( '\\' ) );
+        return Sep == TString::npos ? TString() : Path.substr( 0, Sep );
+    }
+
+    // The prefix of the descendants of Path.
+    static TString BelowOf( TString const & Path ) {
+        return Path.empty() ? Path : Path + TChar( '\\' );
+    }
+
+    bool Covers( TString const & Path ) const noexcept {
+        return
+            Path.size() >= root_.size() &&
+            Path.compare( 0, root_.size(), root_ ) == 0 &&
+            ( Path.size() == root_.size() || root_.empty() ||
+              Path[root_.size()] == TChar( '\\' ) );
+    }
+
+    // The entry of Key, from the image when its stamp still matches.
+    TEntry Validate( TKey& Key, TString const & Path ) {
+        auto const Stamp = Key.GetStamp();
+        auto const Old = Find( Path );
+        if ( Old && StampOf( Old ) == Stamp ) {
+            ++stats_.Hits;
+            return Old;
+        }
+        ++stats_.Misses;
+        auto const Block = ReadEntry( Key, Stamp );
+        Drop( Path );
+        entries_.emplace( Path, Block );
+        modified_ = true;
+        auto const Entry = EntryOf( Block );
+        if ( Old ) {
+            std::set<TString> Folded;
+            Walk( Entry, nullptr, [&]( TStringView Name ) {
+                Folded.insert( FoldName( Name ) );
+            } );
+            auto const Below = BelowOf( Path );
+            Walk( Old, nullptr, [&]( TStringView Name ) {
+                auto Child = FoldName( Name );
+                if ( !Folded.count( Child ) ) {
+                    Forget( Below + Child );
+                }
+            } );
+        }
+        return Entry;
+    }
+
+    // Drops Path and everything below it from the image.
+    void Forget( TString const & Path ) {
+        Drop( Path );
+        auto const Below = BelowOf( Path );
+        auto It = entries_.lower_bound( Below );
+        while ( It != entries_.end() && It->first.compare( 0, Below.size(), Below ) == 0 ) {
+            It = entries_.erase( It );
+            modified_ = true;
+        }
+        for ( auto Image = LowerBound( Below ) ;
+              Image != index_.end() && Image->Path.substr( 0, Below.size() ) == Below ;
+              ++Image )
+        {
+            modified_ |= !Image->Dropped;
+            Image->Dropped = true;
+        }
+    }
+
+    // Drops Path from the image and has Refresh check it and its
+    // ancestors under the root.
+    void Invalidate( TString const & Path ) {
+        Drop( Path );
+        for ( auto Key = Path ; ; Key = ParentOf( Key ) ) {
+            touched_.insert( Key );
+            if ( Key.size() <= root_.size() ) {
+                break;
+            }
+        }
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Store
+//---------------------------------------------------------------------------
+} // End of namespace Registry
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
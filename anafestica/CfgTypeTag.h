@@ -0,0 +1,278 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgTypeTagH
+#define CfgTypeTagH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_type_tag.cpp).
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Type identifiers -- prefixed to avoid macro namespace pollution
+
+#define ANA_TT_I    i        // int
+#define ANA_TT_U    u        // unsigned int
+#define ANA_TT_L    l        // long
+#define ANA_TT_UL   ul       // unsigned long
+#define ANA_TT_C    c        // char
+#define ANA_TT_UC   uc       // unsigned char
+#define ANA_TT_S    s        // short
+#define ANA_TT_US   us       // unsigned short
+#define ANA_TT_LL   ll       // long long
+#define ANA_TT_ULL  ull      // unsigned long long
+#define ANA_TT_B    b        // bool
+#define ANA_TT_SZ   sz       // System::String
+#define ANA_TT_DT   dt       // System::TDateTime
+#define ANA_TT_FLT  flt      // float
+#define ANA_TT_DBL  dbl      // double
+#define ANA_TT_CUR  cur      // System::Currency
+#define ANA_TT_SV   sv       // StringCont aka std::vector<String>
+#define ANA_TT_DAB  dab      // System::Sysutils::TBytes
+#define ANA_TT_VB   vb       // BytesCont aka std::vector<Byte>
+#define ANA_TT_STR  str      // std::string  (UTF-8)
+#define ANA_TT_WSTR wstr     // std::wstring (UTF-16)
+
+#define ana_cnv_xstr( s ) ana_cnv_str( s )
+#define ana_cnv_str( s )  #s
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+
+/// Identifies the alternative stored in @ref TConfigNodeValueType.
+///
+/// Each enumerator maps 1:1 to an alternative (its value is the cell's
+/// @c index()) and to a
+/// short text tag (e.g. @c "i", @c "sz", @c "dbl") used by backends to
+/// encode the type in the storage format.  See @ref GetTypeTag for the
+/// reverse mapping from text to enumerator.
+enum class TypeTag : std::size_t {
+    TT_I,   // int
+    TT_U,   // unsigned int
+    TT_L,   // long
+    TT_UL,  // unsigned long
+    TT_C,   // char
+    TT_UC,  // unsigned char
+    TT_S,   // short
+    TT_US,  // unsigned short
+    TT_LL,  // long long
+    TT_ULL, // unsigned long long
+    TT_B,   // bool
+    TT_SZ,  // System::String
+    TT_DT,  // System::TDateTime
+    TT_FLT, // float
+    TT_DBL, // double
+    TT_CUR, // System::Currency
+    TT_SV,  // StringCont aka std::vector<String>
+    TT_DAB, // System::Sysutils::TBytes
+    TT_VB,  // BytesCont aka std::vector<Byte>
+    TT_STR, // std::string  (UTF-8)
+    TT_WSTR // std::wstring (UTF-16)
+};
+
+/// Number of @ref TypeTag enumerators.
+inline constexpr std::size_t TypeTagCount =
+    static_cast<std::size_t>( TypeTag::TT_WSTR ) + 1;
+
+/// The text tags, indexed by @ref TypeTag.  Plain ASCII, so they can be
+/// compared against narrow and wide text alike.
+inline constexpr std::array<char const *,TypeTagCount> TypeTagNames {
+    ana_cnv_xstr( ANA_TT_I ),
+    ana_cnv_xstr( ANA_TT_U ),
+    ana_cnv_xstr( ANA_TT_L ),
+    ana_cnv_xstr( ANA_TT_UL ),
+    ana_cnv_xstr( ANA_TT_C ),
+    ana_cnv_xstr( ANA_TT_UC ),
+    ana_cnv_xstr( ANA_TT_S ),
+    ana_cnv_xstr( ANA_TT_US ),
+    ana_cnv_xstr( ANA_TT_LL ),
+    ana_cnv_xstr( ANA_TT_ULL ),
+    ana_cnv_xstr( ANA_TT_B ),
+    ana_cnv_xstr( ANA_TT_SZ ),
+    ana_cnv_xstr( ANA_TT_DT ),
+    ana_cnv_xstr( ANA_TT_FLT ),
+    ana_cnv_xstr( ANA_TT_DBL ),
+    ana_cnv_xstr( ANA_TT_CUR ),
+    ana_cnv_xstr( ANA_TT_SV ),
+    ana_cnv_xstr( ANA_TT_DAB ),
+    ana_cnv_xstr( ANA_TT_VB ),
+    ana_cnv_xstr( ANA_TT_STR ),
+    ana_cnv_xstr( ANA_TT_WSTR ),
+};
+
+/// Returns the text tag of @p Tag (e.g. @c "dbl" for @c TT_DBL).
+[[nodiscard]] constexpr char const * GetTypeTagName( TypeTag Tag ) noexcept
+{
+    return TypeTagNames[static_cast<std::size_t>( Tag )];
+}
+
+namespace Detail {
+
+inline constexpr std::size_t TypeTagMaxLength = 4;
+inline constexpr std::size_t TypeTagSlots = 64;
+
+// Perfect hash over the tag set: first char, last char and length pick a
+// distinct slot for every tag (checked below).  Non-ASCII input may land
+// on an occupied slot, but then fails the compare against the tag text.
+constexpr std::size_t TypeTagHash( unsigned First, unsigned Last,
+                                   std::size_t Length ) noexcept
+{
+    return ( First + 2 * Last + 3 * Length ) & ( TypeTagSlots - 1 );
+}
+
+constexpr std::size_t TypeTagLength( char const * Name ) noexcept
+{
+    std::size_t Length {};
+    while ( Name[Length] ) { ++Length; }
+    return Length;
+}
+
+// Slot -> TypeTag + 1 (0 marks an empty slot).
+constexpr std::array<std::uint8_t,TypeTagSlots> MakeTypeTagSlots() noexcept
+{
+    std::array<std::uint8_t,TypeTagSlots> Slots {};
+    for ( std::size_t Idx {} ; Idx < TypeTagCount ; ++Idx ) {
+        auto const Name = TypeTagNames[Idx];
+        auto const Length = TypeTagLength( Name );
+        auto& Slot =
+            Slots[
+                TypeTagHash(
+                    static_cast<unsigned char>( Name[0] ),
+                    static_cast<unsigned char>( Name[Length - 1] ),
+                    Length
+                )
+            ];
+        Slot = Slot ? 0xFF : static_cast<std::uint8_t>( Idx + 1 );
+    }
+    return Slots;
+}
+
+inline constexpr auto TypeTagSlotTable = MakeTypeTagSlots();
+
+constexpr bool TypeTagHashIsPerfect() noexcept
+{
+    std::size_t Used {};
+    for ( auto Slot : TypeTagSlotTable ) {
+        if ( Slot == 0xFF ) { return false; }
+        if ( Slot ) { ++Used; }
+    }
+    for ( std::size_t Idx {} ; Idx < TypeTagCount ; ++Idx ) {
+        if ( TypeTagLength( TypeTagNames[Idx] ) > TypeTagMaxLength ) {
+            return false;
+        }
+    }
+    return Used == TypeTagCount;
+}
+
+static_assert(
+    TypeTagHashIsPerfect(),
+    "Type tags collide in TypeTagHash (or exceed TypeTagMaxLength): "
+    "adjust the hash after adding a tag"
+);
+
+} // End of namespace Detail
+
+/// Maps the type-tag text [@p Data, @p Data + @p Length) (e.g. @c "i",
+/// @c "sz", @c "dbl") to its @ref TypeTag enumerator.
+///
+/// Works on any code unit type (@c char for UTF-8, @c wchar_t or
+/// @c char16_t for UTF-16), so callers never build a string to look a tag
+/// up.  One compile-time perfect-hash probe and at most four code-unit
+/// compares; no allocation.
+/// Returns @c std::nullopt when the text does not match any known tag,
+/// which backends use to skip unrecognised entries.
+template<typename C>
+[[nodiscard]] constexpr
+std::optional<TypeTag> FindTypeTag( C const * Data, std::size_t Length ) noexcept
+{
+    if ( !Length || Length > Detail::TypeTagMaxLength ) {
+        return std::nullopt;
+    }
+    auto const Slot =
+        Detail::TypeTagSlotTable[
+            Detail::TypeTagHash(
+                static_cast<unsigned>( Data[0] ),
+                static_cast<unsigned>( Data[Length - 1] ),
+                Length
+            )
+        ];
+    if ( !Slot ) {
+        return std::nullopt;
+    }
+    auto const Name = TypeTagNames[Slot - 1u];
+    for ( std::size_t Idx {} ; Idx < Length ; ++Idx ) {
+        if ( !Name[Idx] ||
+             static_cast<unsigned>( Data[Idx] ) !=
+               static_cast<unsigned char>( Name[Idx] ) )
+        {
+            return std::nullopt;
+        }
+    }
+    if ( Name[Length] ) {
+        return std::nullopt;
+    }
+    return static_cast<TypeTag>( Slot - 1u );
+}
+
+/// Splits @p Key, <tt>Name</tt> + @p Open + <tt>Tag)</tt>, at its last
+/// @p Open (the ASCII separator with the opening parenthesis, e.g.
+/// @c "::(") into @p Name and @p Tag.  Returns @c false, leaving both
+/// untouched, when @p Key does not end with @c ')' after such a separator.
+///
+/// A single backward scan over the code units; works on narrow and wide
+/// text alike, as @ref FindTypeTag does.
+template<typename C>
+constexpr bool SplitTagSuffix( std::basic_string_view<C> Key, std::string_view Open,
+                               std::basic_string_view<C>& Name,
+                               std::basic_string_view<C>& Tag ) noexcept
+{
+    if ( Key.size() < Open.size() + 1 || Key.back() != C( ')' ) ) {
+        return false;
+    }
+    for ( auto Pos = Key.size() - Open.size() ; Pos-- ; ) {
+        std::size_t Idx {};
+        while ( Idx < Open.size() &&
+                static_cast<unsigned>( Key[Pos + Idx] ) ==
+                  static_cast<unsigned char>( Open[Idx] ) )
+        {
+            ++Idx;
+        }
+        if ( Idx == Open.size() ) {
+            Name = Key.substr( 0, Pos );
+            Tag = Key.substr( Pos + Open.size(), Key.size() - Pos - Open.size() - 1 );
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Decodes a value name with a type suffix, <tt>Name</tt> + @p Open +
+/// <tt>Tag)</tt> (see @ref SplitTagSuffix), and looks the tag up with
+/// @ref FindTypeTag.  Returns the tag, with @p Name set, or
+/// @c std::nullopt, leaving @p Name untouched, when @p Key has no suffix
+/// or the suffix names no known tag: the whole of @p Key is then the name.
+template<typename C>
+[[nodiscard]] constexpr
+std::optional<TypeTag> DecodeTagSuffix( std::basic_string_view<C> Key, std::string_view Open,
+                                        std::basic_string_view<C>& Name ) noexcept
+{
+    std::basic_string_view<C> Head;
+    std::basic_string_view<C> Tag;
+    if ( SplitTagSuffix( Key, Open, Head, Tag ) ) {
+        if ( auto const Result = FindTypeTag( Tag.data(), Tag.size() ) ) {
+            Name = Head;
+            return Result;
+        }
+    }
+    return std::nullopt;
+}
+
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
@@ -8,11 +8,21 @@
 #include <System.DateUtils.hpp>
 #include <System.NetEncoding.hpp>
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <anafestica/Cfg.h>
+#include <anafestica/CfgCodec.h>
+#include <anafestica/CfgNodeCursor.h>
 #include <anafestica/CfgCrypt.h>
+#include <anafestica/CfgFileStamp.h>
+#include <anafestica/CfgKeyAtom.h>
+#include <anafestica/CfgXMLPull.h>
 
 #pragma comment( lib, "xmlrtl" )
 
@@ -39,15 +49,14 @@ static constexpr LPCTSTR TypeAttrName = _D( "type" );
 class TConfig : public Anafestica::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false,
-             bool FlushAllItems = false, Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, FlushAllItems )
+             bool FlushAllItems = false, Crypt::TOptions CryptOptions = {},
+             TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, FlushAllItems, Options )
         , fileName_( FileName ), loadFileName_( FileName )
         , cryptOptions_( CryptOptions )
     {
         if ( FileExists( loadFileName_ ) ) {
-            XMLObjRAII XML( *this );
-            CheckDocument();
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
         }
     }
 
@@ -57,8 +66,8 @@ public:
     /// still written to the destination.  See @ref Migrate for a named
     /// wrapper that makes the load/save direction unambiguous.
     TConfig( String LoadFileName, String SaveFileName, bool ReadOnly = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true )
+             Crypt::TOptions CryptOptions = {}, TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true, Options )
         , fileName_( SaveFileName )
         , loadFileName_(
             TFile::Exists( SaveFileName ) ? SaveFileName : LoadFileName
@@ -66,9 +75,7 @@ public:
         , cryptOptions_( CryptOptions )
     {
         if ( FileExists( loadFileName_ ) ) {
-            XMLObjRAII XML( *this );
-            CheckDocument();
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
             if ( loadFileName_ != fileName_ ) {
                 MarkForFlush();
             }
@@ -77,9 +84,12 @@ public:
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false,
-                            Crypt::TOptions CryptOptions = {} )
+                            Crypt::TOptions CryptOptions = {},
+                            TConfigOptions Options = {} )
     {
-        return TConfig( LoadFileName, SaveFileName, ReadOnly, CryptOptions );
+        return TConfig(
+            LoadFileName, SaveFileName, ReadOnly, CryptOptions, Options
+        );
     }
 
     ~TConfig() {
@@ -99,7 +109,11 @@ private:
     public:
         XMLObjRAII( TConfig& Cfg ) : cfg_{ Cfg } { cfg_.CreateXMLObject(); }
         ~XMLObjRAII() {
-            try { cfg_.DestroyAndCloseXMLObject(); } catch ( ... ) {}
+            // In lazy mode the document stays open for on-demand loads,
+            // in retain mode for the next flush.
+            if ( !cfg_.GetLazyLoadFlag() && !cfg_.GetRetainDocumentFlag() ) {
+                try { cfg_.DestroyAndCloseXMLObject(); } catch ( ... ) {}
+            }
         }
         XMLObjRAII( XMLObjRAII const & ) = delete;
         XMLObjRAII& operator=( XMLObjRAII const & ) = delete;
@@ -107,10 +121,43 @@ private:
         TConfig& cfg_;
     };
 
+    struct TStringHash {
+        std::size_t operator()( String const & Val ) const noexcept {
+            return KeyHash(
+                std::wstring_view(
+                    Val.c_str(), static_cast<std::size_t>( Val.Length() )
+                )
+            );
+        }
+    };
+
+    // The "node" or "value" children of a "nodes" or "values" element by
+    // their name attribute, in document order: lookups take the first, as
+    // the scan of the siblings did, DeleteValueNodeByName the last.
+    struct TNameIndex {
+        _di_IXMLNode Owner;     // keeps the key of index_ from being reused
+        String ChildName;
+        std::unordered_map<String,std::vector<_di_IXMLNode>,TStringHash> Children;
+    };
+
+    // The children of an element that a flush has erased, left in the
+    // document until it has been written (see RemoveErased).
+    struct TErased {
+        _di_IXMLNode Owner;
+        std::vector<_di_IXMLNode> Children;
+    };
+
     _di_IXMLDocument XMLDoc_;
     String fileName_;
     String loadFileName_;
     Crypt::TOptions cryptOptions_;
+    TNodeCursor<_di_IXMLNode> cursor_;
+    TDocumentStamp documentStamp_;
+    // Built on the first lookup in an element and kept in step with the
+    // document by the functions below, which make all the changes to it;
+    // dropped with the document.
+    std::unordered_map<IXMLNode*,TNameIndex> index_;
+    std::unordered_map<IXMLNode*,TErased> erased_;
 
     String ReadFileText( String const & FileName ) const {
         return cryptOptions_.Enabled
@@ -135,6 +182,16 @@ private:
     }
 
     void CreateXMLObject() {
+        // Retain mode: the document left by the last load or flush is
+        // reused while the file is as it was then.
+        if ( XMLDoc_ && documentStamp_.Matches( loadFileName_ ) ) {
+            return;
+        }
+        index_.clear();
+        erased_.clear();
+        if ( GetRetainDocumentFlag() ) {
+            documentStamp_.Take( loadFileName_ );
+        }
         if ( TFile::Exists( loadFileName_ ) ) {
             // Mitigate XXE injection and XML Bomb (billion laughs)
             // attacks: reject documents containing DTD declarations
@@ -168,7 +225,11 @@ private:
         }
     }
 
-    void DestroyAndCloseXMLObject() { XMLDoc_.Release(); }
+    void DestroyAndCloseXMLObject() {
+        index_.clear();
+        erased_.clear();
+        XMLDoc_.Release();
+    }
 
     void CheckDocument() {
         if ( XMLDoc_->Encoding != DocumentEncoding ) {
@@ -202,38 +263,52 @@ private:
         return SB->ToString();
     }
 
-    _di_IXMLNode FindNodeByNameAndAttrValue( _di_IXMLNode Node, String NodeName,
-                                             String AttrName, String AttrValue )
-    {
-        auto NodeList = Node->ChildNodes;
-        for ( int Idx = 0 ; Idx < NodeList->Count ; ++Idx ) {
-            if ( auto Node = NodeList->Nodes[Idx] ) {
-                if ( Node->NodeName == NodeName ) {
-                    auto const ElementValue = Node->GetAttribute( AttrName );
-                    if ( !ElementValue.IsNull() && ElementValue == AttrValue ) {
-                        return Node;
+    TNameIndex& GetNameIndex( _di_IXMLNode const & Node, String const & NodeName ) {
+        auto& Index = index_[static_cast<IXMLNode*>( Node )];
+        if ( !Index.Owner || Index.ChildName != NodeName ) {
+            Index.Owner = Node;
+            Index.ChildName = NodeName;
+            Index.Children.clear();
+            auto NodeList = Node->ChildNodes;
+            for ( int Idx = 0 ; Idx < NodeList->Count ; ++Idx ) {
+                if ( auto Child = NodeList->Nodes[Idx] ) {
+                    if ( Child->NodeName == NodeName ) {
+                        auto const ElementValue = Child->GetAttribute( NameAttrName );
+                        if ( !ElementValue.IsNull() ) {
+                            Index.Children[String( ElementValue )].push_back( Child );
+                        }
                     }
                 }
             }
         }
-        return _di_IXMLNode();
+        return Index;
     }
 
-    _di_IXMLNode OpenPath( TConfigPath Path ) {
+    _di_IXMLNode FindNodeByName( _di_IXMLNode Node, String const & NodeName,
+                                 String const & Name )
+    {
+        auto const & Children = GetNameIndex( Node, NodeName ).Children;
+        auto const It = Children.find( Name );
+        return It == Children.end() ? _di_IXMLNode() : It->second.front();
+    }
+
+    _di_IXMLNode OpenPath( TConfigPath const & Path ) {
         if ( _di_IXMLNode RootNode = XMLDoc_->DocumentElement ) {
             if ( _di_IXMLNode Current = RootNode->ChildNodes->FindNode( ConfigNodeName ) ) {
-                for ( auto const & AttrName : Path ) {
-                    if ( (Current = Current->ChildNodes->FindNode( NodesNodeName )) ) {
-                        Current = FindNodeByNameAndAttrValue( Current, NodeNodeName, NameAttrName, AttrName );
-                        if ( !Current ) {
-                            break;
+                auto const Found =
+                    cursor_.Resolve(
+                        Current, Path,
+                        [this]( _di_IXMLNode& Node, String const & AttrName ) {
+                            if ( auto Nodes = Node->ChildNodes->FindNode( NodesNodeName ) ) {
+                                Node = FindNodeByName( Nodes, NodeNodeName, AttrName );
+                                return static_cast<bool>( Node );
+                            }
+                            return false;
                         }
-                    }
-                    else {
-                        break;
-                    }
+                    );
+                if ( Found ) {
+                    return Current;
                 }
-                return Current;
             }
         }
         return _di_IXMLNode{};
@@ -263,32 +338,78 @@ private:
         }
     }
 
-    _di_IXMLNode OpenOrForceNode( _di_IXMLNode Node, String NodeName,
-                                  String AttrName, String AttrValue )
+    _di_IXMLNode OpenOrForceNode( _di_IXMLNode Node, String NodeName, String Name )
     {
-        if ( auto ResultNode = FindNodeByNameAndAttrValue( Node, NodeName, AttrName, AttrValue ) ) {
-            return ResultNode;
+        auto& Children = GetNameIndex( Node, NodeName ).Children;
+        auto& Matches = Children[Name];
+        if ( Matches.empty() ) {
+            auto ResultNode = Node->AddChild( NodeName );
+            ResultNode->Attributes[NameAttrName] = Name;
+            Matches.push_back( ResultNode );
         }
-        else {
-            ResultNode = Node->AddChild( NodeName );
-            ResultNode->Attributes[AttrName] = AttrValue;
-            return ResultNode;
+        return Matches.front();
+    }
+
+    // IXMLNodeList::Remove finds the element by a scan of the list, so
+    // erasing elements one by one is quadratic in the number of siblings.
+    // The elements a flush erases leave the name index at once but stay
+    // in the document until RemoveErased drops them all, by position.
+    void Erase( _di_IXMLNode const & Node, _di_IXMLNode const & Child ) {
+        auto& Erased = erased_[static_cast<IXMLNode*>( Node )];
+        Erased.Owner = Node;
+        Erased.Children.push_back( Child );
+    }
+
+    // One pass over each element's children finds the positions of the
+    // erased ones, which are then deleted from the last to the first so
+    // that the positions left stay valid.
+    void RemoveErased() {
+        std::unordered_set<IXMLNode*> Doomed;
+        std::vector<int> Positions;
+        for ( auto const & Entry : erased_ ) {
+            auto const & Erased = Entry.second;
+            Doomed.clear();
+            for ( auto const & Child : Erased.Children ) {
+                Doomed.insert( static_cast<IXMLNode*>( Child ) );
+            }
+            auto NodeList = Erased.Owner->ChildNodes;
+            Positions.clear();
+            for ( int Idx = 0 ; Idx < NodeList->Count ; ++Idx ) {
+                if ( Doomed.count( static_cast<IXMLNode*>( NodeList->Nodes[Idx] ) ) ) {
+                    Positions.push_back( Idx );
+                }
+            }
+            for ( auto It = Positions.rbegin() ; It != Positions.rend() ; ++It ) {
+                NodeList->Delete( *It );
+            }
         }
+        erased_.clear();
     }
 
+    // Erases the last "value" element named Name.
     void DeleteValueNodeByName( _di_IXMLNode Node, String const & Name )
     {
-        auto Childs = Node->ChildNodes;
-        for ( int Idx = Childs->Count - 1 ; Idx >= 0 ; --Idx ) {
-            auto ValueNode = Childs->Get( Idx );
-            if ( ValueNode->NodeName == ValueNodeName ) {
-                auto Attributes = ValueNode->AttributeNodes;
-                if ( auto NameNode = Attributes->FindNode( NameAttrName ) ) {
-                    if ( NameNode->Text == Name ) {
-                        Childs->Remove( ValueNode );
-                        return;
-                    }
-                }
+        auto& Children = GetNameIndex( Node, ValueNodeName ).Children;
+        auto const It = Children.find( Name );
+        if ( It != Children.end() ) {
+            Erase( Node, It->second.back() );
+            It->second.pop_back();
+            if ( It->second.empty() ) {
+                Children.erase( It );
+            }
+        }
+    }
+
+    // Erases the first "node" element named Name, as OpenPath found it.
+    void DeleteNodeByName( _di_IXMLNode Node, String const & Name )
+    {
+        auto& Children = GetNameIndex( Node, NodeNodeName ).Children;
+        auto const It = Children.find( Name );
+        if ( It != Children.end() ) {
+            Erase( Node, It->second.front() );
+            It->second.erase( It->second.begin() );
+            if ( It->second.empty() ) {
+                Children.erase( It );
             }
         }
     }
@@ -296,21 +417,20 @@ private:
     _di_IXMLNode ForcePath( TConfigPath const & Path ) {
         if ( auto RootNode = XMLDoc_->DocumentElement ) {
             if ( auto Current = OpenOrForceNode( RootNode, ConfigNodeName ) ) {
-                for ( auto const & AttrName : Path ) {
-                    if ( (Current = OpenOrForceNode( Current, NodesNodeName )) ) {
-                        Current =
-                            OpenOrForceNode(
-                                Current, NodeNodeName, NameAttrName, AttrName
-                            );
-                        if ( !Current ) {
-                            break;
+                auto const Found =
+                    cursor_.Resolve(
+                        Current, Path,
+                        [this]( _di_IXMLNode& Node, String const & AttrName ) {
+                            if ( auto Nodes = OpenOrForceNode( Node, NodesNodeName ) ) {
+                                Node = OpenOrForceNode( Nodes, NodeNodeName, AttrName );
+                                return static_cast<bool>( Node );
+                            }
+                            return false;
                         }
-                    }
-                    else {
-                        break;
-                    }
+                    );
+                if ( Found ) {
+                    return Current;
                 }
-                return Current;
             }
         }
         return _di_IXMLNode{};
@@ -323,339 +443,271 @@ private:
         return _di_IXMLNode{};
     }
 
-    // https://www.bfilipek.com/2019/02/2lines3featuresoverload.html
-    //template<class... Ts> struct overload : Ts... { using Ts::operator()...; };
-    //template<class... Ts> overload( Ts... ) -> overload<Ts...>;
-    
-    // https://andreasfertig.blog/2023/07/visiting-a-stdvariant-safely/
-    template<class...>
-    static constexpr bool always_false_v = false;
-    
-    template<class... Ts>
-    struct overload : Ts...
-    {
-      using Ts::operator()...;
-    
-      // Prevent implicit type conversions
-      template<typename T>
-      constexpr void operator()(T) const
-      {
-        static_assert(always_false_v<T>, "Unsupported type");
-      }
+    // Value codec: the shared text form; a StringCont is one line per item.
+    struct TValueCodec : Codec::TTextCodec {
+        using TTextCodec::Encode;
+        using TTextCodec::Decode;
+
+        static String Encode( Codec::TAs<StringCont>, StringCont const & Val ) {
+            auto SB = std::make_unique<TStringBuilder>();
+            for ( auto const & Item : Val ) {
+                SB->AppendLine( Item );
+            }
+            return SB->ToString();
+        }
+
+        static StringCont Decode( Codec::TAs<StringCont>, String const & Val ) {
+            auto SL = std::make_unique<TStringList>();
+            SL->Text = Val;
+            StringCont Strings;
+            Strings.reserve( SL->Count );
+            for ( auto const & Line : SL.get() ) {
+                Strings.push_back( Line );
+            }
+            return Strings;
+        }
     };
-    
-    template<class... Ts>
-    overload(Ts...) -> overload<Ts...>;
 
     void SaveValue( _di_IXMLNode Node, ValueContType::value_type const & v ) {
         if ( auto ValueNode =
-                OpenOrForceNode( Node, ValueNodeName, NameAttrName, v.first ) )
+                OpenOrForceNode( Node, ValueNodeName, v.first ) )
         {
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::visit(
-#else
-            boost::apply_visitor(
-#endif
-                overload {
-                    [this, &ValueNode]( int Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_I ) );
-                        ValueNode->Text = Val;
-                    },
-
-                    [this, &ValueNode]( unsigned int Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_U ) );
-                        ValueNode->Text = static_cast<__int64>( Val );
-                    },
-
-                    [this, &ValueNode]( long Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_L ) );
-                        ValueNode->Text = Val;
-                    },
-
-                    [this, &ValueNode]( unsigned long Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_UL ) );
-                        ValueNode->Text = static_cast<__int64>( Val );
-                    },
-
-                    [this, &ValueNode]( char Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_C ) );
-                        ValueNode->Text = static_cast<int>( Val );
-                    },
-
-                    [this, &ValueNode]( unsigned char Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_UC ) );
-                        ValueNode->Text = static_cast<int>( Val );
-                    },
-
-                    [this, &ValueNode]( short Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_S ) );
-                        ValueNode->Text = static_cast<int>( Val );
-                    },
-
-                    [this, &ValueNode]( unsigned short Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_US ) );
-                        ValueNode->Text = static_cast<int>( Val );
-                    },
-
-                    [this, &ValueNode]( long long Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_LL ) );
-                        ValueNode->Text = static_cast<__int64>( Val );
-                    },
-
-                    [this, &ValueNode]( unsigned long long Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_ULL ) );
-                        ValueNode->Text =
-#if defined( _UNICODE )
-                            std::to_wstring( Val ).c_str();
-#else
-                            std::to_string( Val ).c_str();
-#endif
-                    },
-
-                    [this, &ValueNode]( bool Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_B ) );
-                        ValueNode->Text = BoolToStr( Val, true );
-                    },
-
-                    [this, &ValueNode]( System::UnicodeString Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_SZ ) );
-                        ValueNode->Text = Val;
-                    },
-
-                    [this, &ValueNode]( System::TDateTime Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_DT ) );
-                        ValueNode->Text = DateToISO8601( Val, false );
-                    },
-
-                    [this, &ValueNode]( float Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_FLT ) );
-                        TFormatSettings FS;
-                        FS.DecimalSeparator = _D( '.' );
-                        ValueNode->Text =
-                            FloatToStrF( static_cast<double>( Val ),
-                                         TFloatFormat::ffGeneral, 9, 0, FS );
-                    },
-
-                    [this, &ValueNode]( double Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_DBL ) );
-                        TFormatSettings FS;
-                        FS.DecimalSeparator = _D( '.' );
-                        ValueNode->Text =
-                            FloatToStrF( Val, TFloatFormat::ffGeneral, 17, 0, FS );
-                    },
-
-                    [this, &ValueNode]( System::Currency Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_CUR ) );
-                        TFormatSettings FS;
-                        FS.DecimalSeparator = _D( '.' );
-                        ValueNode->Text = CurrToStr( Val, FS );
-                    },
-
-                    [this, &ValueNode]( StringCont const & Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_SV ) );
-                        auto SB = std::make_unique<TStringBuilder>();
-                        for ( auto const & Item : Val ) {
-                            SB->AppendLine( Item );
-                        }
-                        ValueNode->Text = SB->ToString();
-                    },
-
-                    [this, &ValueNode]( TBytes Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_DAB ) );
-                        ValueNode->Text =
-                            Val.Length == 0 ?
-                              String()
-                            :
-                              TNetEncoding::Base64->EncodeBytesToString(
-                                  &Val[0], Val.High
-                              );
-                    },
-
-                    [this, &ValueNode]( std::vector<Byte> const & Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_VB ) );
-                        ValueNode->Text =
-                            Val.empty() ?
-                              String()
-                            :
-                              TNetEncoding::Base64->EncodeBytesToString(
-                                  Val.data(), Val.size() - 1
-                              );
-                    },
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                    [this, &ValueNode]( std::string const & Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_STR ) );
-                        ValueNode->Text = UTF8ToString( Val.c_str() );
-                    },
-
-                    [this, &ValueNode]( std::wstring const & Val ) {
-                        ValueNode->Attributes[TypeAttrName] =
-                            String( ana_cnv_xstr( ANA_TT_WSTR ) );
-                        ValueNode->Text = String( Val.c_str() );
-                    }
-#endif
-                },
-                v.second.first
-            );
+            auto const & Val = v.second.first;
+            ValueNode->Attributes[TypeAttrName] = String( Codec::TagName( Val ) );
+            ValueNode->Text = Codec::Encode( Val, TValueCodec{} );
         }
     }
 
-protected:
-    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
-        using Fn = std::function<TConfigNodeValueType(String)>;
+    static String FromUtf8( std::string_view Text ) {
+        auto const Length = static_cast<int>( Text.size() );
+        if ( std::all_of(
+                Text.begin(), Text.end(),
+                []( char Ch ){ return static_cast<unsigned char>( Ch ) < 0x80; }
+             ) )
+        {
+            String Result;
+            Result.SetLength( Length );
+            std::copy( Text.begin(), Text.end(), Result.c_str() );
+            return Result;
+        }
+        return UTF8ToString( RawByteString( Text.data(), Length ) );
+    }
 
-        static std::array<Fn,
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::variant_size<TConfigNodeValueType>::value
-#else
-            TConfigNodeValueType::types::size::value
-#endif
-        > Builders {
-            // TT_I
-            []( String Value ) {
-                return std::stoi( Value.c_str() );
-            },
-
-            // TT_U
-            []( String Value ) {
-                return static_cast<unsigned>( std::stoul( Value.c_str() ) );
-            },
-
-            // TT_L
-            []( String Value ) {
-                return std::stol( Value.c_str() );
-            },
-
-            // TT_UL
-            []( String Value ) {
-                return std::stoul( Value.c_str() );
-            },
-
-            // TT_C
-            []( String Value ) {
-                return static_cast<char>( std::stoi( Value.c_str() ) );
-            },
-
-            // TT_UC
-            []( String Value ) {
-                return static_cast<unsigned char>( std::stoul( Value.c_str() ) );
-            },
-
-            // TT_S
-            []( String Value ) {
-                return static_cast<short>( std::stoi( Value.c_str() ) );
-            },
-
-            // TT_US
-            []( String Value ) {
-                return static_cast<unsigned short>( std::stoul( Value.c_str() ) );
-            },
-
-            // TT_LL
-            []( String Value ) {
-                return std::stoll( Value.c_str() );
-            },
-
-            // TT_ULL
-            []( String Value ) {
-                return std::stoull( Value.c_str() );
-            },
-
-            // TT_B
-            []( String Value ) {
-                return StrToBool( Value.c_str() );
-            },
-
-            // TT_SZ
-            []( String Value ) {
-                return Value;
-            },
-
-            // TT_DT
-            []( String Value ) {
-                return ISO8601ToDate( Value, false );
-            },
-
-            // TT_FLT
-            []( String Value ) {
-                return std::stof( Value.c_str() );
-            },
-
-            // TT_DBL
-            []( String Value ) {
-                return std::stod( Value.c_str() );
-            },
-
-            // TT_CUR
-            []( String Value ) {
-                TFormatSettings FS;
-                FS.DecimalSeparator = _D( '.' );
-                return StrToCurr( Value, FS );
-            },
-
-            // TT_SV
-            [this]( String Value ) {
-                auto SL = std::make_unique<TStringList>();
-                SL->Text = Value;
-                StringCont Strings;
-                Strings.reserve( SL->Count );
-                for ( auto const & Line : SL.get() ) {
-                    Strings.push_back( Line );
+    // Thrown by TStreamLoader on input whose meaning it leaves to the DOM
+    // reader (see StreamRootNode).
+    struct EStreamFallback {};
+
+    // Builds the tree of an eager load with a Pull::TReader, with the same
+    // rules as DoCreateValueList / DoCreateNodeList: the first "config"
+    // element counts, in it and in each node the first "values" and
+    // "nodes" elements, the first of two sibling nodes with the same name
+    // wins, other elements are skipped.  A value whose content is more
+    // than one text node is left to the DOM reader, and so are namespaces.
+    class TStreamLoader {
+    public:
+        TStreamLoader( TConfig& Cfg, char const * First, char const * Last )
+            : cfg_{ Cfg }, reader_{ First, Last } {}
+
+        void Load() {
+            if ( Next() != Pull::TToken::StartElement ||
+                 reader_.GetName() != "application" )
+            {
+                throw EStreamFallback{};
+            }
+            auto const Encoding = reader_.GetEncoding();
+            if ( !Encoding.empty() && Encoding != "UTF-8" ) {
+                throw EStreamFallback{};
+            }
+            bool SeenConfig {};
+            for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+                if ( Token != Pull::TToken::StartElement ) {
+                    continue;
                 }
-                return Strings;
-            },
-
-            // TT_DAB
-            []( String Value ) {
-                return TNetEncoding::Base64->DecodeStringToBytes( Value );
-            },
-
-            // TT_VB
-            []( String Value ) {
-                auto Bytes = TNetEncoding::Base64->DecodeStringToBytes( Value );
-                std::vector<Byte> VBytes;
-                VBytes.reserve( Bytes.Length );
-                std::copy(
-                    std::begin( Bytes ), std::end( Bytes ),
-                    std::back_inserter( VBytes )
+                if ( !SeenConfig && reader_.GetName() == "config" ) {
+                    SeenConfig = true;
+                    ReadNode( cfg_.GetRootNode(), 0 );
+                }
+                else {
+                    Skip();
+                }
+            }
+            if ( !SeenConfig ) {
+                throw EStreamFallback{};
+            }
+            while ( Next() != Pull::TToken::End ) {}
+        }
+    private:
+        TConfig& cfg_;
+        Pull::TReader reader_;
+
+        [[noreturn]] void Raise() const {
+            if ( reader_.HasDTD() ) {
+                throw EXMLDocError(
+                    _D( "XML document rejected: DTD declarations are not allowed" )
                 );
-                return VBytes;
-            },
-
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            // TT_STR  – XML text decoded as UTF-8 std::string (bcc64x only)
-            []( String Value ) {
-                return std::string( UTF8Encode( Value ).c_str() );
-            },
-
-            // TT_WSTR – XML text decoded as UTF-16 std::wstring (bcc64x only)
-            []( String Value ) {
-                return std::wstring( Value.c_str() );
-            },
-#endif
+            }
+            throw EStreamFallback{};
+        }
+
+        Pull::TToken Next() {
+            auto const Token = reader_.Next();
+            if ( Token == Pull::TToken::Error ) {
+                Raise();
+            }
+            if ( Token == Pull::TToken::StartElement &&
+                 ( reader_.GetName().find( ':' ) != std::string_view::npos ||
+                   reader_.GetAttribute( "xmlns" ) ) )
+            {
+                throw EStreamFallback{};
+            }
+            return Token;
+        }
+
+        void Skip() {
+            if ( !reader_.Skip() ) {
+                Raise();
+            }
+        }
+
+        void ReadNode( TConfigNode& Node, std::size_t Depth ) {
+            auto Values = cfg_.NewValueList();
+            auto Nodes = cfg_.NewNodeList();
+            bool SeenValues {};
+            bool SeenNodes {};
+            for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+                if ( Token != Pull::TToken::StartElement ) {
+                    continue;
+                }
+                auto const Name = reader_.GetName();
+                if ( !SeenValues && Name == "values" ) {
+                    SeenValues = true;
+                    ReadValues( Values );
+                }
+                else if ( !SeenNodes && Name == "nodes" ) {
+                    SeenNodes = true;
+                    ReadNodes( Nodes, Depth + 1 );
+                }
+                else {
+                    Skip();
+                }
+            }
+            Node.Populate( std::move( Values ), std::move( Nodes ) );
+        }
+
+        void ReadNodes( NodeContType& Nodes, std::size_t Depth ) {
+            for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+                if ( Token != Pull::TToken::StartElement ) {
+                    continue;
+                }
+                if ( reader_.GetName() == "node" ) {
+                    if ( auto const Attr = reader_.GetAttribute( "name" ) ) {
+                        auto Name = FromUtf8( *Attr );
+                        if ( !Nodes.contains( Name ) ) {
+                            TConfigNode::CheckPersistenceDepth( Depth );
+                            auto Node = cfg_.NewNode();
+                            ReadNode( *Node, Depth );
+                            Nodes.try_emplace( std::move( Name ), std::move( Node ) );
+                            continue;
+                        }
+                    }
+                }
+                Skip();
+            }
+        }
+
+        void ReadValues( ValueContType& Values ) {
+            for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+                if ( Token != Pull::TToken::StartElement ) {
+                    continue;
+                }
+                if ( reader_.GetName() == "value" ) {
+                    auto const NameAttr = reader_.GetAttribute( "name" );
+                    auto const TypeAttr = reader_.GetAttribute( "type" );
+                    if ( NameAttr && TypeAttr ) {
+                        if ( auto const Tag = FindTypeTag( TypeAttr->data(), TypeAttr->size() ) ) {
+                            auto Name = FromUtf8( *NameAttr );
+                            auto const Text = ReadText();
+                            PutItemTo(
+                                Values, Name,
+                                {
+                                    Codec::Decode( *Tag, TValueCodec{}, Text ),
+                                    Operation::None
+                                }
+                            );
+                            continue;
+                        }
+                    }
+                }
+                Skip();
+            }
+        }
+
+        // The content of a value element, as IXMLNode::Text reads it: empty,
+        // or a single text or CDATA node (whitespace-only text is dropped by
+        // the DOM parser).
+        String ReadText() {
+            String Text;
+            bool SeenText {};
+            for ( Pull::TToken Token ; ( Token = Next() ) != Pull::TToken::EndElement ; ) {
+                auto const Data = reader_.GetText();
+                if ( Token != Pull::TToken::Text || SeenText ||
+                     ( !reader_.IsCData() &&
+                       Data.find_first_not_of( " \t\n" ) == std::string_view::npos ) )
+                {
+                    throw EStreamFallback{};
+                }
+                SeenText = true;
+                Text = FromUtf8( Data );
+            }
+            return Text;
+        }
+    };
+
+    // Eager load: parses the file straight into the tree, without building
+    // an IXMLDocument.  Returns false, with the root left empty, when the
+    // file is not one it can read on its own; the caller then loads it
+    // through the DOM.  A DTD is rejected here as CreateXMLObject rejects
+    // it.
+    bool StreamRootNode() {
+        auto Load = [this]( char const * First, char const * Last ) {
+            // Any other failure, EStreamFallback or a decoding error, is
+            // reproduced (or handled) by the DOM reader.
+            try {
+                TStreamLoader{ *this, First, Last }.Load();
+                return true;
+            }
+            catch ( EXMLDocError const & ) {
+                throw;
+            }
+            catch ( ... ) {
+            }
+            GetRootNode().Populate( NewValueList(), NewNodeList() );
+            return false;
         };
+        if ( cryptOptions_.Enabled ) {
+            auto const Bytes = Crypt::LoadBytes( loadFileName_, cryptOptions_ );
+            auto const First = reinterpret_cast<char const *>( Bytes.data() );
+            return Load( First, First + Bytes.size() );
+        }
+        auto const Bytes = TFile::ReadAllBytes( loadFileName_ );
+        auto const First =
+            Bytes.Length ? reinterpret_cast<char const *>( &Bytes[0] ) : nullptr;
+        return Load( First, First + Bytes.Length );
+    }
 
-        ValueContType Values;
+    // In retain mode the document is built anyway, to be kept for the
+    // next flush.
+    void LoadRootNode() {
+        if ( GetLazyLoadFlag() || GetRetainDocumentFlag() || !StreamRootNode() ) {
+            XMLObjRAII XML{ *this };
+            CheckDocument();
+            ReadRootNode();
+        }
+    }
+
+protected:
+    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+        auto Values = NewValueList();
 
         if ( auto Node = OpenValues( Path ) ) {
             auto Childs = Node->ChildNodes;
@@ -669,8 +721,9 @@ protected:
                                 PutItemTo(
                                     Values, NameNode->Text,
                                     {
-                                        Builders[static_cast<size_t>( Result.value() )](
-                                            ValueNode->Text
+                                        Codec::Decode(
+                                            Result.value(), TValueCodec{},
+                                            String( ValueNode->Text )
                                         ),
                                         Operation::None
                                     }
@@ -686,7 +739,7 @@ protected:
     }
 
     virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
-        NodeContType Nodes;
+        auto Nodes = NewNodeList();
         if ( auto Node = OpenNodes( Path ) ) {
             auto Childs = Node->ChildNodes;
             for ( int Idx = 0 ; Idx < Childs->Count ; ++Idx  ) {
@@ -695,7 +748,7 @@ protected:
                     auto Attributes = ANode->AttributeNodes;
                     if ( auto NameNode = Attributes->FindNode( NameAttrName ) ) {
                         Nodes[NameNode->Text] =
-                            std::move( std::make_unique<TConfigNode>() );
+                            NewNode();
                     }
                 }
             }
@@ -722,13 +775,32 @@ protected:
     virtual void DoDeleteNode( TConfigPath const & Path ) override {
         if ( auto Node = OpenPath( Path ) ) {
             auto Parent = Node->ParentNode;
-            Parent->ChildNodes->Remove( Node );
+            if ( Path.empty() ) {
+                Parent->ChildNodes->Remove( Node );
+            }
+            else {
+                DeleteNodeByName( Parent, Path.back() );
+            }
         }
+        cursor_.Invalidate( Path );
+    }
+
+    virtual void DoEnterNode( String const & Name ) override {
+        cursor_.Enter( Name );
+    }
+
+    virtual void DoLeaveNode() noexcept override { cursor_.Leave(); }
+
+    virtual void DoBeginLazyRead() override {
+        if ( !XMLDoc_ ) { CreateXMLObject(); }
     }
 
     virtual void DoFlush() override {
         XMLObjRAII XML{ *this };
+        // Until it is saved, the document no longer mirrors the file.
+        documentStamp_.Reset();
         GetRootNode().Write( *this, TConfigPath{} );
+        RemoveErased();
 
         if ( !TFile::Exists( fileName_ ) ) {
             auto DirPath = TPath::GetFullPath( TPath::GetDirectoryName( fileName_ ) );
@@ -737,6 +809,9 @@ protected:
             }
         }
         SaveXMLDocument( fileName_ );
+        if ( GetRetainDocumentFlag() ) {
+            documentStamp_.Take( fileName_ );
+        }
     }
 
     virtual bool DoGetForcedWritesFlag() const {
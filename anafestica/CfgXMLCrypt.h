@@ -15,21 +15,28 @@ class TConfig : public XML::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false,
              bool FlushAllItems = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
-        : XML::TConfig( FileName, ReadOnly, FlushAllItems, Options )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             TConfigOptions CfgOptions = {} )
+        : XML::TConfig( FileName, ReadOnly, FlushAllItems, Options, CfgOptions )
     {}
 
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
-        : XML::TConfig( LoadFileName, SaveFileName, ReadOnly, Options )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             TConfigOptions CfgOptions = {} )
+        : XML::TConfig(
+            LoadFileName, SaveFileName, ReadOnly, Options, CfgOptions
+          )
     {}
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false,
-                            Crypt::TOptions Options = Crypt::TOptions::Default() )
+                            Crypt::TOptions Options = Crypt::TOptions::Default(),
+                            TConfigOptions CfgOptions = {} )
     {
-        return TConfig( LoadFileName, SaveFileName, ReadOnly, Options );
+        return TConfig(
+            LoadFileName, SaveFileName, ReadOnly, Options, CfgOptions
+        );
     }
 };
 
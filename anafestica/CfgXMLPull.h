@@ -0,0 +1,752 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgXMLPullH
+#define CfgXMLPullH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_xml_pull.cpp).
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace XML {
+//---------------------------------------------------------------------------
+namespace Pull {
+//---------------------------------------------------------------------------
+
+/// Element nesting limit used by @ref TReader unless the caller passes
+/// another.
+inline constexpr std::size_t DefaultMaxDepth = 512;
+
+/// What @ref TReader::Next stopped on.
+enum class TToken {
+    StartElement,   ///< @c GetName, @c GetAttribute
+    EndElement,     ///< @c GetName; also reported for <tt><a/></tt>
+    Text,           ///< @c GetText: a run of character data or a CDATA section
+    Comment,        ///< @c GetText
+    Instruction,    ///< @c GetName (the target), @c GetText
+    End,            ///< after the root element and what follows it
+    Error           ///< @c GetError, @c GetOffset, @c HasDTD
+};
+
+/// Pull parser for UTF-8 XML 1.0 documents without a DTD.
+///
+/// Each call to @ref Next moves to the next token; names, text and
+/// attribute values are UTF-8 views that stay valid until the following
+/// call.  Character data is reported with entity and character references
+/// expanded and line ends normalized (CR LF and CR read as LF), attribute
+/// values are normalized too (tab, CR and LF read as a space).
+///
+/// The parser rejects rather than guesses: a byte order mark other than
+/// UTF-8's, malformed UTF-8, characters XML does not allow, non-ASCII
+/// names, undeclared entities and every other well-formedness error stop
+/// it with @ref TToken::Error.  A document type declaration stops it too,
+/// and so does the text <tt><!DOCTYPE</tt> or <tt><!ENTITY</tt> inside a
+/// comment, CDATA section or processing instruction (the only places the
+/// characters can appear raw), so that the verdict is that of a search
+/// through the whole text.  @ref HasDTD tells that case apart.
+class TReader {
+public:
+    TReader( char const * First, char const * Last,
+             std::size_t MaxDepth = DefaultMaxDepth )
+      : first_{ First }, cur_{ First }, last_{ Last }, maxDepth_{ MaxDepth }
+    {
+        if ( last_ - cur_ >= 3 &&
+             static_cast<unsigned char>( cur_[0] ) == 0xEF &&
+             static_cast<unsigned char>( cur_[1] ) == 0xBB &&
+             static_cast<unsigned char>( cur_[2] ) == 0xBF )
+        {
+            cur_ += 3;
+        }
+        start_ = cur_;
+    }
+
+    TReader( TReader const & ) = delete;
+    TReader& operator=( TReader const & ) = delete;
+
+    TToken Next() {
+        if ( token_ == TToken::End || token_ == TToken::Error ) {
+            return token_;
+        }
+        attrs_.clear();
+        if ( pendingEnd_ ) {
+            pendingEnd_ = false;
+            Pop();
+            return token_ = TToken::EndElement;
+        }
+        for ( ;; ) {
+            if ( cur_ == last_ ) {
+                if ( !stack_.empty() ) {
+                    return Fail( "unexpected end of data" );
+                }
+                if ( !rootSeen_ ) {
+                    return Fail( "no root element" );
+                }
+                return token_ = TToken::End;
+            }
+            if ( *cur_ == '<' ) {
+                return Markup();
+            }
+            if ( stack_.empty() ) {
+                if ( !IsSpace( *cur_ ) ) {
+                    return Fail( "text outside the root element" );
+                }
+                ++cur_;
+                continue;
+            }
+            return CharData();
+        }
+    }
+
+    /// Skips what is left of the element whose @c StartElement was the
+    /// last token, up to and including its end tag.  @c false on error.
+    bool Skip() {
+        auto const Depth = stack_.size();
+        while ( stack_.size() >= Depth ) {
+            auto const Token = Next();
+            if ( Token == TToken::Error || Token == TToken::End ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::string_view GetName() const noexcept { return name_; }
+    [[nodiscard]] std::string_view GetText() const noexcept { return text_; }
+    [[nodiscard]] bool IsCData() const noexcept { return cdata_; }
+
+    /// The value of attribute @p Name of the current start tag.
+    [[nodiscard]] std::optional<std::string_view>
+    GetAttribute( std::string_view Name ) const noexcept {
+        for ( auto const & Attr : attrs_ ) {
+            if ( Attr.Name == Name ) {
+                return Attr.Decoded
+                    ? std::string_view( attrText_ ).substr( Attr.Offset, Attr.Length )
+                    : Attr.Raw;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// Number of open elements, the current one included.
+    [[nodiscard]] std::size_t GetDepth() const noexcept { return stack_.size(); }
+
+    /// The encoding named by the XML declaration; empty when there is none.
+    [[nodiscard]] std::string_view GetEncoding() const noexcept { return encoding_; }
+
+    /// Static message; @c nullptr unless the last token is @c Error.
+    [[nodiscard]] char const * GetError() const noexcept { return error_; }
+
+    /// Byte offset at which parsing stopped.
+    [[nodiscard]] std::size_t GetOffset() const noexcept {
+        return static_cast<std::size_t>( cur_ - first_ );
+    }
+
+    /// @c true when the error is a document type declaration.
+    [[nodiscard]] bool HasDTD() const noexcept { return dtd_; }
+private:
+    struct TAttr {
+        std::string_view Name;
+        std::string_view Raw;       // when not Decoded
+        std::size_t Offset {};      // in attrText_, when Decoded
+        std::size_t Length {};
+        bool Decoded {};
+    };
+
+    char const * first_;
+    char const * start_;            // after the BOM
+    char const * cur_;
+    char const * last_;
+    std::size_t maxDepth_;
+    std::vector<std::string_view> stack_;
+    std::vector<TAttr> attrs_;
+    std::string attrText_;          // decoded attribute values
+    std::string scratch_;           // decoded text of the current token
+    std::string_view name_;
+    std::string_view text_;
+    std::string_view encoding_;
+    char const * error_ {};
+    TToken token_ { TToken::Comment };
+    bool cdata_ {};
+    bool pendingEnd_ {};            // <a/>: EndElement still to report
+    bool rootSeen_ {};
+    bool dtd_ {};
+
+    TToken Fail( char const * Error ) {
+        if ( !error_ ) { error_ = Error; }
+        return token_ = TToken::Error;
+    }
+
+    TToken FailDTD() {
+        dtd_ = true;
+        return Fail( "DTD declarations are not allowed" );
+    }
+
+    static bool IsSpace( char Ch ) noexcept {
+        return Ch == ' ' || Ch == '\n' || Ch == '\r' || Ch == '\t';
+    }
+
+    static bool IsNameStart( char Ch ) noexcept {
+        return
+            ( Ch >= 'a' && Ch <= 'z' ) || ( Ch >= 'A' && Ch <= 'Z' ) ||
+            Ch == '_' || Ch == ':';
+    }
+
+    static bool IsNameChar( char Ch ) noexcept {
+        return
+            IsNameStart( Ch ) || ( Ch >= '0' && Ch <= '9' ) ||
+            Ch == '-' || Ch == '.';
+    }
+
+    bool StartsWith( std::string_view Text ) const noexcept {
+        return
+            static_cast<std::size_t>( last_ - cur_ ) >= Text.size() &&
+            std::string_view( cur_, Text.size() ) == Text;
+    }
+
+    void SkipSpace() noexcept {
+        while ( cur_ != last_ && IsSpace( *cur_ ) ) { ++cur_; }
+    }
+
+    // Names are kept to ASCII: the schema's element and attribute names
+    // are, and a document using others is left to a full parser.
+    bool Name( std::string_view& Result ) {
+        auto const Begin = cur_;
+        if ( cur_ == last_ || !IsNameStart( *cur_ ) ) {
+            return false;
+        }
+        while ( ++cur_ != last_ && IsNameChar( *cur_ ) ) {}
+        Result = std::string_view( Begin, static_cast<std::size_t>( cur_ - Begin ) );
+        return true;
+    }
+
+    static bool IsChar( std::uint32_t Code ) noexcept {
+        return
+            Code == 0x9 || Code == 0xA || Code == 0xD ||
+            ( Code >= 0x20 && Code <= 0xD7FF ) ||
+            ( Code >= 0xE000 && Code <= 0xFFFD ) ||
+            ( Code >= 0x10000 && Code <= 0x10FFFF );
+    }
+
+    // Steps over one multi-byte UTF-8 sequence at cur_, which must encode
+    // a character XML allows.
+    bool Utf8Char() noexcept {
+        auto const Lead = static_cast<unsigned char>( *cur_ );
+        std::size_t Length;
+        std::uint32_t Code;
+        if ( Lead >= 0xC2 && Lead <= 0xDF ) { Length = 2; Code = Lead & 0x1F; }
+        else if ( Lead >= 0xE0 && Lead <= 0xEF ) { Length = 3; Code = Lead & 0x0F; }
+        else if ( Lead >= 0xF0 && Lead <= 0xF4 ) { Length = 4; Code = Lead & 0x07; }
+        else { return false; }
+        if ( static_cast<std::size_t>( last_ - cur_ ) < Length ) {
+            return false;
+        }
+        for ( std::size_t Idx = 1 ; Idx < Length ; ++Idx ) {
+            auto const Cont = static_cast<unsigned char>( cur_[Idx] );
+            if ( ( Cont & 0xC0 ) != 0x80 ) {
+                return false;
+            }
+            Code = Code << 6 | ( Cont & 0x3F );
+        }
+        static constexpr std::uint32_t Min[] { 0, 0, 0x80, 0x800, 0x10000 };
+        if ( Code < Min[Length] || ( Code >= 0xD800 && Code <= 0xDFFF ) || !IsChar( Code ) ) {
+            return false;
+        }
+        cur_ += Length;
+        return true;
+    }
+
+    static void AppendUtf8( std::string& Out, std::uint32_t Code ) {
+        if ( Code < 0x80 ) {
+            Out += static_cast<char>( Code );
+        }
+        else if ( Code < 0x800 ) {
+            Out += static_cast<char>( 0xC0 | Code >> 6 );
+            Out += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else if ( Code < 0x10000 ) {
+            Out += static_cast<char>( 0xE0 | Code >> 12 );
+            Out += static_cast<char>( 0x80 | ( Code >> 6 & 0x3F ) );
+            Out += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else {
+            Out += static_cast<char>( 0xF0 | Code >> 18 );
+            Out += static_cast<char>( 0x80 | ( Code >> 12 & 0x3F ) );
+            Out += static_cast<char>( 0x80 | ( Code >> 6 & 0x3F ) );
+            Out += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+    }
+
+    // A reference after its '&', appended to Out.
+    bool Reference( std::string& Out ) {
+        if ( cur_ != last_ && *cur_ == '#' ) {
+            ++cur_;
+            bool const Hex = cur_ != last_ && *cur_ == 'x';
+            if ( Hex ) { ++cur_; }
+            std::uint32_t Code {};
+            auto const Digits = cur_;
+            for ( ; cur_ != last_ && *cur_ != ';' ; ++cur_ ) {
+                unsigned Digit;
+                auto const Ch = *cur_;
+                if ( Ch >= '0' && Ch <= '9' ) { Digit = Ch - '0'; }
+                else if ( Hex && Ch >= 'a' && Ch <= 'f' ) { Digit = Ch - 'a' + 10; }
+                else if ( Hex && Ch >= 'A' && Ch <= 'F' ) { Digit = Ch - 'A' + 10; }
+                else { return false; }
+                Code = Code * ( Hex ? 16 : 10 ) + Digit;
+                if ( Code > 0x10FFFF ) {
+                    return false;
+                }
+            }
+            if ( cur_ == last_ || cur_ == Digits || !IsChar( Code ) ) {
+                return false;
+            }
+            ++cur_;
+            AppendUtf8( Out, Code );
+            return true;
+        }
+        std::string_view Entity;
+        if ( !Name( Entity ) || cur_ == last_ || *cur_ != ';' ) {
+            return false;
+        }
+        ++cur_;
+        if ( Entity == "lt" ) { Out += '<'; }
+        else if ( Entity == "gt" ) { Out += '>'; }
+        else if ( Entity == "amp" ) { Out += '&'; }
+        else if ( Entity == "apos" ) { Out += '\''; }
+        else if ( Entity == "quot" ) { Out += '"'; }
+        else { return false; }
+        return true;
+    }
+
+    // Character data up to the next '<'.  Plain text is reported in
+    // place; references and CRs make a decoded copy.
+    TToken CharData() {
+        auto const Begin = cur_;
+        bool Copy = false;
+        scratch_.clear();
+        while ( cur_ != last_ && *cur_ != '<' ) {
+            auto const Ch = *cur_;
+            if ( static_cast<unsigned char>( Ch ) >= 0x80 ) {
+                auto const From = cur_;
+                if ( !Utf8Char() ) {
+                    return Fail( "invalid UTF-8 or character" );
+                }
+                if ( Copy ) { scratch_.append( From, cur_ ); }
+                continue;
+            }
+            if ( Ch == '&' || Ch == '\r' ) {
+                if ( !Copy ) {
+                    scratch_.assign( Begin, cur_ );
+                    Copy = true;
+                }
+                ++cur_;
+                if ( Ch == '&' ) {
+                    if ( !Reference( scratch_ ) ) {
+                        return Fail( "invalid reference" );
+                    }
+                }
+                else {
+                    if ( cur_ != last_ && *cur_ == '\n' ) { ++cur_; }
+                    scratch_ += '\n';
+                }
+                continue;
+            }
+            if ( static_cast<unsigned char>( Ch ) < 0x20 && Ch != '\n' && Ch != '\t' ) {
+                return Fail( "invalid character" );
+            }
+            if ( Ch == '>' && cur_ - Begin >= 2 && cur_[-1] == ']' && cur_[-2] == ']' ) {
+                return Fail( "']]>' in character data" );
+            }
+            if ( Copy ) { scratch_ += Ch; }
+            ++cur_;
+        }
+        text_ = Copy
+            ? std::string_view( scratch_ )
+            : std::string_view( Begin, static_cast<std::size_t>( cur_ - Begin ) );
+        cdata_ = false;
+        return token_ = TToken::Text;
+    }
+
+    // Checks the raw text of a comment, CDATA section or processing
+    // instruction, where '<' may appear unescaped.  Reported with line
+    // ends normalized.
+    bool RawText( char const * Begin, char const * End, std::string_view& Result ) {
+        bool Copy = false;
+        scratch_.clear();
+        for ( cur_ = Begin ; cur_ != End ; ) {
+            auto const Ch = *cur_;
+            if ( static_cast<unsigned char>( Ch ) >= 0x80 ) {
+                auto const From = cur_;
+                if ( !Utf8Char() ) {
+                    Fail( "invalid UTF-8 or character" );
+                    return false;
+                }
+                if ( Copy ) { scratch_.append( From, cur_ ); }
+                continue;
+            }
+            if ( Ch == '<' &&
+                 ( StartsWith( "<!DOCTYPE" ) || StartsWith( "<!ENTITY" ) ) )
+            {
+                FailDTD();
+                return false;
+            }
+            if ( Ch == '\r' ) {
+                if ( !Copy ) {
+                    scratch_.assign( Begin, cur_ );
+                    Copy = true;
+                }
+                ++cur_;
+                if ( cur_ != End && *cur_ == '\n' ) { ++cur_; }
+                scratch_ += '\n';
+                continue;
+            }
+            if ( static_cast<unsigned char>( Ch ) < 0x20 && Ch != '\n' && Ch != '\t' ) {
+                Fail( "invalid character" );
+                return false;
+            }
+            if ( Copy ) { scratch_ += Ch; }
+            ++cur_;
+        }
+        Result = Copy
+            ? std::string_view( scratch_ )
+            : std::string_view( Begin, static_cast<std::size_t>( End - Begin ) );
+        return true;
+    }
+
+    // Finds Terminator from cur_; cur_ is left on it.
+    char const * Find( std::string_view Terminator ) const noexcept {
+        auto const Rest = std::string_view( cur_, static_cast<std::size_t>( last_ - cur_ ) );
+        auto const Pos = Rest.find( Terminator );
+        return Pos == std::string_view::npos ? nullptr : cur_ + Pos;
+    }
+
+    TToken Markup() {
+        if ( StartsWith( "</" ) ) {
+            return EndTag();
+        }
+        if ( StartsWith( "<!--" ) ) {
+            return Comment();
+        }
+        if ( StartsWith( "<![CDATA[" ) ) {
+            return CData();
+        }
+        if ( StartsWith( "<!" ) ) {
+            if ( StartsWith( "<!DOCTYPE" ) || StartsWith( "<!ENTITY" ) ||
+                 StartsWith( "<!ELEMENT" ) || StartsWith( "<!ATTLIST" ) ||
+                 StartsWith( "<!NOTATION" ) )
+            {
+                return FailDTD();
+            }
+            return Fail( "invalid markup" );
+        }
+        if ( StartsWith( "<?" ) ) {
+            return Instruction();
+        }
+        return StartTag();
+    }
+
+    TToken Comment() {
+        cur_ += 4;
+        auto const End = Find( "--" );
+        if ( !End || last_ - End < 3 || End[2] != '>' ) {
+            return Fail( "invalid comment" );
+        }
+        if ( !RawText( cur_, End, text_ ) ) {
+            return token_;
+        }
+        cur_ = End + 3;
+        return token_ = TToken::Comment;
+    }
+
+    TToken CData() {
+        if ( stack_.empty() ) {
+            return Fail( "CDATA section outside the root element" );
+        }
+        cur_ += 9;
+        auto const End = Find( "]]>" );
+        if ( !End ) {
+            return Fail( "unterminated CDATA section" );
+        }
+        if ( !RawText( cur_, End, text_ ) ) {
+            return token_;
+        }
+        cur_ = End + 3;
+        cdata_ = true;
+        return token_ = TToken::Text;
+    }
+
+    TToken Instruction() {
+        auto const Begin = cur_;
+        cur_ += 2;
+        std::string_view Target;
+        if ( !Name( Target ) ) {
+            return Fail( "invalid processing instruction" );
+        }
+        if ( Target.size() == 3 &&
+             ( Target[0] | 0x20 ) == 'x' && ( Target[1] | 0x20 ) == 'm' &&
+             ( Target[2] | 0x20 ) == 'l' )
+        {
+            if ( Begin != start_ || Target != "xml" ) {
+                return Fail( "misplaced XML declaration" );
+            }
+            if ( !Declaration() ) {
+                return Fail( "invalid XML declaration" );
+            }
+            return Next();
+        }
+        auto const End = Find( "?>" );
+        if ( !End ) {
+            return Fail( "unterminated processing instruction" );
+        }
+        if ( cur_ != End && !IsSpace( *cur_ ) ) {
+            return Fail( "invalid processing instruction" );
+        }
+        SkipSpace();
+        std::string_view Data;
+        if ( !RawText( cur_ < End ? cur_ : End, End, Data ) ) {
+            return token_;
+        }
+        name_ = Target;
+        text_ = Data;
+        cur_ = End + 2;
+        return token_ = TToken::Instruction;
+    }
+
+    // Name = "value" in a declaration; false when Name is not next.
+    bool Pseudo( std::string_view Name, std::string_view& Value ) {
+        auto const Begin = cur_;
+        SkipSpace();
+        if ( cur_ == Begin || !StartsWith( Name ) ) {
+            cur_ = Begin;
+            return false;
+        }
+        cur_ += Name.size();
+        SkipSpace();
+        if ( cur_ == last_ || *cur_ != '=' ) {
+            cur_ = Begin;
+            return false;
+        }
+        ++cur_;
+        SkipSpace();
+        if ( cur_ == last_ || ( *cur_ != '"' && *cur_ != '\'' ) ) {
+            cur_ = Begin;
+            return false;
+        }
+        auto const Quote = *cur_++;
+        auto const ValueBegin = cur_;
+        while ( cur_ != last_ && *cur_ != Quote ) {
+            if ( !IsNameChar( *cur_ ) ) {
+                cur_ = Begin;
+                return false;
+            }
+            ++cur_;
+        }
+        if ( cur_ == last_ ) {
+            cur_ = Begin;
+            return false;
+        }
+        Value = std::string_view( ValueBegin, static_cast<std::size_t>( cur_ - ValueBegin ) );
+        ++cur_;
+        return true;
+    }
+
+    bool Declaration() {
+        std::string_view Version;
+        if ( !Pseudo( "version", Version ) ||
+             Version.size() < 3 || Version.substr( 0, 2 ) != "1." ||
+             Version.find_first_not_of( "0123456789", 2 ) != std::string_view::npos )
+        {
+            return false;
+        }
+        std::string_view Encoding;
+        if ( Pseudo( "encoding", Encoding ) ) {
+            if ( Encoding.empty() ||
+                 !( ( Encoding[0] >= 'a' && Encoding[0] <= 'z' ) ||
+                    ( Encoding[0] >= 'A' && Encoding[0] <= 'Z' ) ) ||
+                 Encoding.find( ':' ) != std::string_view::npos )
+            {
+                return false;
+            }
+            encoding_ = Encoding;
+        }
+        std::string_view StandAlone;
+        if ( Pseudo( "standalone", StandAlone ) &&
+             StandAlone != "yes" && StandAlone != "no" )
+        {
+            return false;
+        }
+        SkipSpace();
+        if ( !StartsWith( "?>" ) ) {
+            return false;
+        }
+        cur_ += 2;
+        return true;
+    }
+
+    TToken StartTag() {
+        if ( rootSeen_ && stack_.empty() ) {
+            return Fail( "content after the root element" );
+        }
+        ++cur_;
+        std::string_view Tag;
+        if ( !Name( Tag ) ) {
+            return Fail( "invalid element name" );
+        }
+        attrText_.clear();
+        for ( ;; ) {
+            auto const Spaced = cur_ != last_ && IsSpace( *cur_ );
+            SkipSpace();
+            if ( cur_ == last_ ) {
+                return Fail( "unexpected end of data" );
+            }
+            if ( *cur_ == '>' || *cur_ == '/' ) {
+                break;
+            }
+            if ( !Spaced ) {
+                return Fail( "expected a space" );
+            }
+            TAttr Attr;
+            if ( !Name( Attr.Name ) ) {
+                return Fail( "invalid attribute name" );
+            }
+            for ( auto const & Other : attrs_ ) {
+                if ( Other.Name == Attr.Name ) {
+                    return Fail( "duplicate attribute" );
+                }
+            }
+            SkipSpace();
+            if ( cur_ == last_ || *cur_ != '=' ) {
+                return Fail( "expected '='" );
+            }
+            ++cur_;
+            SkipSpace();
+            if ( !AttributeValue( Attr ) ) {
+                return token_;
+            }
+            attrs_.push_back( Attr );
+        }
+        bool const Empty = *cur_ == '/';
+        if ( Empty ) {
+            ++cur_;
+            if ( cur_ == last_ || *cur_ != '>' ) {
+                return Fail( "expected '>'" );
+            }
+        }
+        ++cur_;
+        if ( stack_.size() >= maxDepth_ ) {
+            return Fail( "maximum nesting depth exceeded" );
+        }
+        stack_.push_back( Tag );
+        rootSeen_ = true;
+        name_ = Tag;
+        pendingEnd_ = Empty;
+        return token_ = TToken::StartElement;
+    }
+
+    bool AttributeValue( TAttr& Attr ) {
+        if ( cur_ == last_ || ( *cur_ != '"' && *cur_ != '\'' ) ) {
+            Fail( "expected a quoted value" );
+            return false;
+        }
+        auto const Quote = *cur_++;
+        auto const Begin = cur_;
+        auto const Offset = attrText_.size();
+        for ( ;; ) {
+            if ( cur_ == last_ ) {
+                Fail( "unexpected end of data" );
+                return false;
+            }
+            auto const Ch = *cur_;
+            if ( Ch == Quote ) {
+                break;
+            }
+            if ( static_cast<unsigned char>( Ch ) >= 0x80 ) {
+                auto const From = cur_;
+                if ( !Utf8Char() ) {
+                    Fail( "invalid UTF-8 or character" );
+                    return false;
+                }
+                if ( Attr.Decoded ) { attrText_.append( From, cur_ ); }
+                continue;
+            }
+            if ( Ch == '<' ) {
+                Fail( "'<' in an attribute value" );
+                return false;
+            }
+            if ( Ch == '&' || Ch == '\r' || Ch == '\n' || Ch == '\t' ) {
+                if ( !Attr.Decoded ) {
+                    attrText_.append( Begin, cur_ );
+                    Attr.Decoded = true;
+                }
+                ++cur_;
+                if ( Ch == '&' ) {
+                    if ( !Reference( attrText_ ) ) {
+                        Fail( "invalid reference" );
+                        return false;
+                    }
+                }
+                else {
+                    if ( Ch == '\r' && cur_ != last_ && *cur_ == '\n' ) { ++cur_; }
+                    attrText_ += ' ';
+                }
+                continue;
+            }
+            if ( static_cast<unsigned char>( Ch ) < 0x20 ) {
+                Fail( "invalid character" );
+                return false;
+            }
+            if ( Attr.Decoded ) { attrText_ += Ch; }
+            ++cur_;
+        }
+        if ( Attr.Decoded ) {
+            Attr.Offset = Offset;
+            Attr.Length = attrText_.size() - Offset;
+        }
+        else {
+            Attr.Raw = std::string_view( Begin, static_cast<std::size_t>( cur_ - Begin ) );
+        }
+        ++cur_;
+        return true;
+    }
+
+    TToken EndTag() {
+        cur_ += 2;
+        std::string_view Tag;
+        if ( !Name( Tag ) ) {
+            return Fail( "invalid element name" );
+        }
+        SkipSpace();
+        if ( cur_ == last_ || *cur_ != '>' ) {
+            return Fail( "expected '>'" );
+        }
+        ++cur_;
+        if ( stack_.empty() || stack_.back() != Tag ) {
+            return Fail( "mismatched end tag" );
+        }
+        Pop();
+        return token_ = TToken::EndElement;
+    }
+
+    void Pop() {
+        name_ = stack_.back();
+        stack_.pop_back();
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace Pull
+//---------------------------------------------------------------------------
+} // End of namespace XML
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
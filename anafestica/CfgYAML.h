@@ -10,11 +10,16 @@
 // explicit type tags) so that a YAML file can be inspected and round-tripped
 // against the same TConfigNode tree.
 //
-// fkYAML does not expose an erase operation on its node API. To support
-// deletion, this backend rebuilds the YAML document from the in-memory
-// TConfigNode tree on every flush; for that reason the FlushAllItems flag
+// Every flush rewrites the whole file from the in-memory TConfigNode tree,
+// which is how deletions reach it; for that reason the FlushAllItems flag
 // is forced to true regardless of what the caller passes (the parameter is
-// kept for API parity with the other file-based backends).
+// kept for API parity with the other file-based backends).  The file is
+// written in block style as the tree is walked (CfgYAMLWriter.h), without
+// an fkYAML document.
+//
+// Loads do not build the fkYAML document either, as long as the file keeps
+// to the block-style subset YAML::Sax::Parse (CfgYAMLSax.h) reads: it is
+// streamed into the tree instead, and anything else goes through fkYAML.
 //
 //---------------------------------------------------------------------------
 
@@ -27,19 +32,25 @@
 #include <System.SysUtils.hpp>
 #include <System.Classes.hpp>
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <vector>
-#include <array>
-#include <functional>
 #include <iterator>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <cstdio>
 
 #include <fkYAML/node.hpp>
 
 #include <anafestica/Cfg.h>
+#include <anafestica/CfgCodec.h>
+#include <anafestica/CfgNodeCursor.h>
 #include <anafestica/CfgCrypt.h>
+#include <anafestica/CfgYAMLSax.h>
+#include <anafestica/CfgYAMLWriter.h>
 
 //---------------------------------------------------------------------------
 namespace Anafestica {
@@ -57,15 +68,14 @@ private:
 public:
     TConfig( String FileName, bool ReadOnly = false,
              bool /*FlushAllItems*/ = false, bool ExplicitTypes = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true )
+             Crypt::TOptions CryptOptions = {}, TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true, Options )
         , fileName_{ FileName }, loadFileName_{ FileName }
         , explicitTypes_{ ExplicitTypes }
         , cryptOptions_{ CryptOptions }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
-            YAMLObjRAII YAML{ *this, /*Load*/true };
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
         }
     }
 
@@ -75,8 +85,8 @@ public:
     /// for a named wrapper that makes the load/save direction unambiguous.
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false, bool ExplicitTypes = false,
-             Crypt::TOptions CryptOptions = {} )
-        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true )
+             Crypt::TOptions CryptOptions = {}, TConfigOptions Options = {} )
+        : Anafestica::TConfig( ReadOnly, /*FlushAllItems*/ true, Options )
         , fileName_{ SaveFileName }
         , loadFileName_{
             TFile::Exists( SaveFileName ) ? SaveFileName : LoadFileName
@@ -85,8 +95,7 @@ public:
         , cryptOptions_{ CryptOptions }
     {
         if ( TFile::Exists( loadFileName_ ) ) {
-            YAMLObjRAII YAML{ *this, /*Load*/true };
-            GetRootNode().Read( *this, TConfigPath{} );
+            LoadRootNode();
             if ( loadFileName_ != fileName_ ) {
                 MarkForFlush();
             }
@@ -95,10 +104,12 @@ public:
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false, bool ExplicitTypes = false,
-                            Crypt::TOptions CryptOptions = {} )
+                            Crypt::TOptions CryptOptions = {},
+                            TConfigOptions Options = {} )
     {
         return TConfig(
-            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, CryptOptions
+            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, CryptOptions,
+            Options
         );
     }
 
@@ -138,6 +149,7 @@ private:
     bool                               explicitTypes_;
     Crypt::TOptions                    cryptOptions_;
     std::unique_ptr<TBase64Encoding>   base64_ { new TBase64Encoding{ 0 } };
+    TNodeCursor<YamlNode*>             cursor_;
 
     //-----------------------------------------------------------------------
     // Encoding helpers — fkYAML uses UTF-8 std::string internally; the
@@ -148,8 +160,19 @@ private:
         return std::string( Tmp.c_str(), static_cast<size_t>( Tmp.Length() ) );
     }
 
-    static String FromUtf8( std::string const & S ) {
-        return S.empty() ? String() : UTF8ToString( S.c_str() );
+    static String FromUtf8( std::string_view Text ) {
+        auto const Length = static_cast<int>( Text.size() );
+        if ( std::all_of(
+                Text.begin(), Text.end(),
+                []( char Ch ){ return static_cast<unsigned char>( Ch ) < 0x80; }
+             ) )
+        {
+            String Result;
+            Result.SetLength( Length );
+            std::copy( Text.begin(), Text.end(), Result.c_str() );
+            return Result;
+        }
+        return UTF8ToString( RawByteString( Text.data(), Length ) );
     }
 
     std::string ReadFileBytes( String const & FileName ) const {
@@ -172,23 +195,6 @@ private:
         return Content;
     }
 
-    void WriteFileBytes( String const & FileName, std::string const & Content ) const {
-        Crypt::Bytes Bytes( Content.begin(), Content.end() );
-        if ( cryptOptions_.Enabled ) {
-            Crypt::SaveBytes( FileName, Bytes, cryptOptions_ );
-        }
-        else {
-            std::unique_ptr<TFileStream> Stream(
-                new TFileStream( FileName, fmCreate )
-            );
-            if ( !Bytes.empty() ) {
-                Stream->WriteBuffer(
-                    Bytes.data(), static_cast<NativeInt>( Bytes.size() )
-                );
-            }
-        }
-    }
-
     //-----------------------------------------------------------------------
     // Document lifecycle.
     //-----------------------------------------------------------------------
@@ -218,24 +224,26 @@ private:
     }
 
     //-----------------------------------------------------------------------
-    // Path traversal helpers — analogous to OpenPath/ForcePath in CfgJSON.
-    // Read paths return nullptr on a missing/wrong-typed branch; force paths
-    // create the necessary intermediate mappings.
+    // Path traversal helpers — analogous to OpenPath in CfgJSON.  They
+    // return nullptr on a missing/wrong-typed branch, and resume from the
+    // node cursor, so a traversal converts each name to UTF-8 once.
     //-----------------------------------------------------------------------
+    static bool OpenChild( YamlNode*& Cur, String const & NodeName ) {
+        if ( !Cur->contains( NodesKeyU8 ) ) return false;
+        YamlNode& Inner = (*Cur)[NodesKeyU8];
+        if ( !Inner.is_mapping() ) return false;
+        std::string const SubKey = ToUtf8( NodeName );
+        if ( !Inner.contains( SubKey ) ) return false;
+        YamlNode& SubNode = Inner[SubKey];
+        if ( !SubNode.is_mapping() ) return false;
+        Cur = &SubNode;
+        return true;
+    }
+
     YamlNode* OpenPath( TConfigPath const & Path ) {
         if ( !document_ || !document_->is_mapping() ) return nullptr;
         YamlNode* Cur = document_.get();
-        for ( auto const & NodeName : Path ) {
-            if ( !Cur->contains( NodesKeyU8 ) ) return nullptr;
-            YamlNode& Inner = (*Cur)[NodesKeyU8];
-            if ( !Inner.is_mapping() ) return nullptr;
-            std::string const SubKey = ToUtf8( NodeName );
-            if ( !Inner.contains( SubKey ) ) return nullptr;
-            YamlNode& SubNode = Inner[SubKey];
-            if ( !SubNode.is_mapping() ) return nullptr;
-            Cur = &SubNode;
-        }
-        return Cur;
+        return cursor_.Resolve( Cur, Path, &OpenChild ) ? Cur : nullptr;
     }
 
     YamlNode* OpenSection( TConfigPath const & Path, char const * Section ) {
@@ -256,367 +264,715 @@ private:
         return OpenSection( Path, ValuesKeyU8 );
     }
 
-    YamlNode* ForcePath( TConfigPath const & Path ) {
-        if ( !document_ ) {
-            document_.reset( new YamlNode( ::fkyaml::node_type::MAPPING ) );
+    //-----------------------------------------------------------------------
+    // Value codec of the document reader: the payload of {Type: Inner}, as
+    // TStreamWriter writes it.
+    //-----------------------------------------------------------------------
+    struct TValueCodec {
+        TConfig& Cfg;
+
+        template<typename T>
+        static T DecodeInteger( YamlNode const & V ) {
+            return static_cast<T>( V.get_value<std::int64_t>() );
         }
-        if ( !document_->is_mapping() ) {
-            *document_ = YamlNode( ::fkyaml::node_type::MAPPING );
+
+        template<typename T>
+        static T DecodeText( YamlNode const & V ) {
+            return
+                Codec::TTextCodec::Decode(
+                    Codec::TAs<T>{}, FromUtf8( V.get_value<std::string>() )
+                );
         }
-        YamlNode* Cur = document_.get();
-        for ( auto const & NodeName : Path ) {
-            if ( !Cur->contains( NodesKeyU8 ) || !(*Cur)[NodesKeyU8].is_mapping() ) {
-                (*Cur)[NodesKeyU8] = YamlNode( ::fkyaml::node_type::MAPPING );
-            }
-            YamlNode& Inner = (*Cur)[NodesKeyU8];
-            std::string const SubKey = ToUtf8( NodeName );
-            if ( !Inner.contains( SubKey ) || !Inner[SubKey].is_mapping() ) {
-                Inner[SubKey] = YamlNode( ::fkyaml::node_type::MAPPING );
-            }
-            Cur = &Inner[SubKey];
+
+        static int Decode( Codec::TAs<int>, YamlNode const & V ) {
+            return DecodeInteger<int>( V );
+        }
+
+        static unsigned int Decode( Codec::TAs<unsigned int>, YamlNode const & V ) {
+            return DecodeInteger<unsigned int>( V );
+        }
+
+        static long Decode( Codec::TAs<long>, YamlNode const & V ) {
+            return DecodeInteger<long>( V );
+        }
+
+        static unsigned long Decode( Codec::TAs<unsigned long>, YamlNode const & V ) {
+            return DecodeInteger<unsigned long>( V );
+        }
+
+        static char Decode( Codec::TAs<char>, YamlNode const & V ) {
+            return DecodeInteger<char>( V );
         }
-        return Cur;
-    }
 
-    YamlNode* ForceValues( TConfigPath const & Path ) {
-        if ( auto Node = ForcePath( Path ) ) {
-            if ( !Node->contains( ValuesKeyU8 ) || !(*Node)[ValuesKeyU8].is_mapping() ) {
-                (*Node)[ValuesKeyU8] = YamlNode( ::fkyaml::node_type::MAPPING );
+        static unsigned char Decode( Codec::TAs<unsigned char>, YamlNode const & V ) {
+            return DecodeInteger<unsigned char>( V );
+        }
+
+        static short Decode( Codec::TAs<short>, YamlNode const & V ) {
+            return DecodeInteger<short>( V );
+        }
+
+        static unsigned short Decode( Codec::TAs<unsigned short>, YamlNode const & V ) {
+            return DecodeInteger<unsigned short>( V );
+        }
+
+        static long long Decode( Codec::TAs<long long>, YamlNode const & V ) {
+            return DecodeInteger<long long>( V );
+        }
+
+        static unsigned long long Decode( Codec::TAs<unsigned long long>, YamlNode const & V ) {
+            return std::stoull( V.get_value<std::string>() );
+        }
+
+        static bool Decode( Codec::TAs<bool>, YamlNode const & V ) {
+            return V.get_value<bool>();
+        }
+
+        static String Decode( Codec::TAs<String>, YamlNode const & V ) {
+            return FromUtf8( V.get_value<std::string>() );
+        }
+
+        static TDateTime Decode( Codec::TAs<TDateTime>, YamlNode const & V ) {
+            return DecodeText<TDateTime>( V );
+        }
+
+        static float Decode( Codec::TAs<float>, YamlNode const & V ) {
+            return std::stof( V.get_value<std::string>() );
+        }
+
+        static double Decode( Codec::TAs<double>, YamlNode const & V ) {
+            return std::stod( V.get_value<std::string>() );
+        }
+
+        static Currency Decode( Codec::TAs<Currency>, YamlNode const & V ) {
+            return DecodeText<Currency>( V );
+        }
+
+        static StringCont Decode( Codec::TAs<StringCont>, YamlNode const & V ) {
+            StringCont Strings;
+            if ( V.is_sequence() ) {
+                Strings.reserve( V.size() );
+                for ( auto It = V.begin(); It != V.end(); ++It ) {
+                    Strings.push_back( FromUtf8( It->get_value<std::string>() ) );
+                }
             }
-            return &(*Node)[ValuesKeyU8];
+            return Strings;
         }
-        return nullptr;
-    }
 
-    //-----------------------------------------------------------------------
-    // Tagged-value helper: produces a single-pair mapping {Type: Inner}.
-    //-----------------------------------------------------------------------
-    static YamlNode WrapTagged( char const * Type, YamlNode Inner ) {
-        YamlNode Wrapper( ::fkyaml::node_type::MAPPING );
-        Wrapper[Type] = std::move( Inner );
-        return Wrapper;
-    }
+        static TBytes Decode( Codec::TAs<TBytes>, YamlNode const & V ) {
+            return DecodeText<TBytes>( V );
+        }
 
-    //-----------------------------------------------------------------------
-    // Variant overload visitor (same pattern as CfgJSON / CfgBSON).
-    //-----------------------------------------------------------------------
-    template<class...>
-    static constexpr bool always_false_v = false;
+        static BytesCont Decode( Codec::TAs<BytesCont>, YamlNode const & V ) {
+            return DecodeText<BytesCont>( V );
+        }
 
-    template<class... Ts>
-    struct overload : Ts...
-    {
-        using Ts::operator()...;
-        template<typename T>
-        constexpr void operator()(T) const {
-            static_assert( always_false_v<T>, "Unsupported type" );
+        static std::string Decode( Codec::TAs<std::string>, YamlNode const & V ) {
+            return V.get_value<std::string>();
+        }
+
+        static std::wstring Decode( Codec::TAs<std::wstring>, YamlNode const & V ) {
+            return DecodeText<std::wstring>( V );
         }
     };
-    template<class... Ts> overload(Ts...) -> overload<Ts...>;
-
-    void SaveValue( YamlNode& Obj, ValueContType::value_type const & v ) {
-        std::string const Key = ToUtf8( v.first );
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-        std::visit(
-#else
-        boost::apply_visitor(
-#endif
-            overload {
-                [this, &Obj, &Key]( int Val ) {
-                    if ( explicitTypes_ ) {
-                        Obj[Key] = WrapTagged(
-                            ana_cnv_xstr( ANA_TT_I ),
-                            YamlNode( static_cast<std::int64_t>( Val ) )
+
+    // Thrown by TStreamLoader on input whose meaning it leaves to fkYAML
+    // (see StreamRootNode).
+    struct EStreamFallback {};
+
+    // Sax::Parse handler building the tree of an eager load directly, with
+    // the same rules as DoCreateValueList / DoCreateNodeList: values and
+    // nodes of an unexpected shape are skipped, and so is a tagged value
+    // that does not decode.  Scalars are resolved by the YAML 1.2 core
+    // schema, as fkYAML resolves them; keys that are not strings, untagged
+    // floats and integers in other than plain decimal form are left to
+    // fkYAML, and so is a payload of another kind than its tag's.
+    class TStreamLoader {
+    public:
+        explicit TStreamLoader( TConfig& Cfg ) : cfg_{ Cfg } {}
+
+        bool StartMapping() {
+            if ( states_.empty() ) {
+                PushNode( TConfigNodePtr{}, System::String() );
+                return true;
+            }
+            switch ( states_.back() ) {
+                case TState::Node:
+                    states_.push_back( member_ );
+                    return true;
+                case TState::Values:
+                    payload_.Pairs = 0;
+                    payload_.Shape = TShape::None;
+                    states_.push_back( TState::Wrapper );
+                    return true;
+                case TState::Nodes:
+                    TConfigNode::CheckPersistenceDepth( nodes_.size() );
+                    PushNode( cfg_.NewNode(), std::move( name_ ) );
+                    return true;
+                default:
+                    payload_.Shape = TShape::Bad;
+                    return false;
+            }
+        }
+
+        bool Key( std::string_view Name, Sax::TKind Kind ) {
+            auto const State = states_.back();
+            if ( State == TState::Node ) {
+                if ( Kind == Sax::TKind::String && Name == ValuesKeyU8 ) {
+                    member_ = TState::Values;
+                    return true;
+                }
+                if ( Kind == Sax::TKind::String && Name == NodesKeyU8 ) {
+                    member_ = TState::Nodes;
+                    return true;
+                }
+                return false;
+            }
+            if ( Kind != Sax::TKind::String ) {
+                throw EStreamFallback{};
+            }
+            switch ( State ) {
+                case TState::Values:
+                case TState::Nodes:
+                    name_ = FromUtf8( Name );
+                    return true;
+                case TState::Wrapper:
+                    if ( ++payload_.Pairs == 1 ) {
+                        tag_ = FindTypeTag( Name.data(), Name.size() );
+                        return tag_.has_value();
+                    }
+                    return false;
+                default:
+                    return false;
+            }
+        }
+
+        void EndMapping() {
+            auto const State = states_.back();
+            states_.pop_back();
+            if ( State == TState::Wrapper ) {
+                if ( payload_.Pairs == 1 && tag_ ) {
+                    try {
+                        PutItemTo(
+                            nodes_.back().Values, name_,
+                            {
+                                Codec::Decode( *tag_, TStreamCodec{}, payload_ ),
+                                Operation::None
+                            }
                         );
                     }
-                    else {
-                        Obj[Key] = YamlNode( static_cast<std::int64_t>( Val ) );
+                    catch ( EStreamFallback const & ) {
+                        throw;
                     }
-                },
-                [&Obj, &Key]( unsigned int Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_U ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
-                    );
-                },
-                [&Obj, &Key]( long Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_L ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
-                    );
-                },
-                [&Obj, &Key]( unsigned long Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_UL ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
-                    );
-                },
-                [&Obj, &Key]( char Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_C ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
-                    );
-                },
-                [&Obj, &Key]( unsigned char Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_UC ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
-                    );
-                },
-                [&Obj, &Key]( short Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_S ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
-                    );
-                },
-                [&Obj, &Key]( unsigned short Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_US ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
+                    catch ( ... ) {
+                        // Decoding failed for this entry — leave it out.
+                    }
+                }
+            }
+            else if ( State == TState::Node ) {
+                auto Frame = std::move( nodes_.back() );
+                nodes_.pop_back();
+                if ( nodes_.empty() ) {
+                    cfg_.GetRootNode().Populate(
+                        std::move( Frame.Values ), std::move( Frame.Nodes )
                     );
-                },
-                [&Obj, &Key]( long long Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_LL ),
-                        YamlNode( static_cast<std::int64_t>( Val ) )
+                }
+                else {
+                    Frame.Node->Populate(
+                        std::move( Frame.Values ), std::move( Frame.Nodes )
                     );
-                },
-                [&Obj, &Key]( unsigned long long Val ) {
-                    // Stored as decimal string to avoid 64-bit precision loss.
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_ULL ),
-                        YamlNode( std::to_string( Val ) )
+                    nodes_.back().Nodes.try_emplace(
+                        std::move( Frame.Name ), std::move( Frame.Node )
                     );
-                },
-                [this, &Obj, &Key]( bool Val ) {
-                    if ( explicitTypes_ ) {
-                        Obj[Key] = WrapTagged(
-                            ana_cnv_xstr( ANA_TT_B ),
-                            YamlNode( Val )
+                }
+            }
+        }
+
+        bool StartSequence() {
+            if ( states_.empty() ) {
+                return false;
+            }
+            switch ( states_.back() ) {
+                case TState::Wrapper:
+                    payload_.Shape = TShape::Sequence;
+                    payload_.Strings.clear();
+                    states_.push_back( TState::Sequence );
+                    return true;
+                case TState::Sequence:
+                    payload_.Shape = TShape::Bad;
+                    return false;
+                default:
+                    return false;
+            }
+        }
+
+        void EndSequence() { states_.pop_back(); }
+
+        void Scalar( std::string_view Text, Sax::TKind Kind ) {
+            if ( states_.empty() ) {
+                return;
+            }
+            switch ( states_.back() ) {
+                case TState::Values:
+                    // fkYAML nulls are not read back, nor are its floats
+                    // (which Implicit leaves to it).
+                    if ( Kind != Sax::TKind::Null ) {
+                        PutItemTo(
+                            nodes_.back().Values, name_,
+                            { Implicit( Kind, Text ), Operation::None }
                         );
                     }
+                    break;
+                case TState::Wrapper:
+                    payload_.Shape = TShape::Scalar;
+                    payload_.Kind = Kind;
+                    payload_.Text.assign( Text.data(), Text.size() );
+                    break;
+                case TState::Sequence:
+                    if ( Kind == Sax::TKind::String ) {
+                        payload_.Strings.push_back( FromUtf8( Text ) );
+                    }
                     else {
-                        Obj[Key] = YamlNode( Val );
+                        payload_.Shape = TShape::Bad;
                     }
-                },
-                [this, &Obj, &Key]( System::UnicodeString Val ) {
-                    if ( explicitTypes_ ) {
-                        Obj[Key] = WrapTagged(
-                            ana_cnv_xstr( ANA_TT_SZ ),
-                            YamlNode( ToUtf8( Val ) )
-                        );
+                    break;
+                default:
+                    break;
+            }
+        }
+    private:
+        enum class TState { Node, Values, Nodes, Wrapper, Sequence };
+        enum class TShape { None, Scalar, Sequence, Bad };
+
+        struct TNodeFrame {
+            TConfigNodePtr Node;    // empty for the root
+            System::String Name;
+            ValueContType Values;
+            NodeContType Nodes;
+        };
+
+        // Payload of the { <tag>: <payload> } wrapper being read.
+        struct TPayload {
+            TShape Shape { TShape::None };
+            Sax::TKind Kind { Sax::TKind::String };
+            int Pairs {};
+            std::string Text;
+            StringCont Strings;
+        };
+
+        // Decodes a payload as TValueCodec decodes the matching fkYAML
+        // node; the combinations it does not handle are left to fkYAML.
+        struct TStreamCodec {
+            template<typename T>
+            T Decode( Codec::TAs<T> Tag, TPayload& Payload ) const {
+                if ( Payload.Shape == TShape::Scalar ) {
+                    if constexpr ( std::is_same_v<T,bool> ) {
+                        if ( Payload.Kind == Sax::TKind::Bool ) {
+                            return ToBool( Payload.Text );
+                        }
                     }
-                    else {
-                        Obj[Key] = YamlNode( ToUtf8( Val ) );
+                    else if constexpr ( std::is_integral_v<T> &&
+                                        !std::is_same_v<T,unsigned long long> ) {
+                        if ( Payload.Kind == Sax::TKind::Int ) {
+                            return static_cast<T>( ToInt64( Payload.Text ) );
+                        }
                     }
-                },
-                [&Obj, &Key]( System::TDateTime Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_DT ),
-                        YamlNode( ToUtf8( DateToISO8601( Val, false ) ) )
-                    );
-                },
-                [&Obj, &Key]( float Val ) {
-                    // Serialised as a string: fkYAML's float emitter uses
-                    // ostringstream default precision (6 digits) which is
-                    // lossy. A string preserves the round-trip.
-                    char Buf[64];
-                    std::snprintf( Buf, sizeof Buf, "%.9g", static_cast<double>( Val ) );
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_FLT ),
-                        YamlNode( std::string( Buf ) )
-                    );
-                },
-                [&Obj, &Key]( double Val ) {
-                    // %.17g is the round-trip-safe printf format for double.
-                    char Buf[64];
-                    std::snprintf( Buf, sizeof Buf, "%.17g", Val );
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_DBL ),
-                        YamlNode( std::string( Buf ) )
-                    );
-                },
-                [&Obj, &Key]( System::Currency Val ) {
-                    TFormatSettings FS;
-                    FS.DecimalSeparator = _D( '.' );
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_CUR ),
-                        YamlNode( ToUtf8( CurrToStr( Val, FS ) ) )
-                    );
-                },
-                [&Obj, &Key]( StringCont const & Val ) {
-                    YamlNode::sequence_type Seq;
-                    Seq.reserve( Val.size() );
-                    for ( auto const & S : Val ) {
-                        Seq.emplace_back( ToUtf8( S ) );
+                    else if ( Payload.Kind == Sax::TKind::String ) {
+                        return FromText( Tag, Payload.Text );
                     }
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_SV ),
-                        YamlNode::sequence( std::move( Seq ) )
-                    );
-                },
-                [this, &Obj, &Key]( System::Sysutils::TBytes Val ) {
-                    String Encoded = Val.Length == 0
-                        ? String()
-                        : base64_->EncodeBytesToString( &Val[0], Val.High );
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_DAB ),
-                        YamlNode( ToUtf8( Encoded ) )
-                    );
-                },
-                [this, &Obj, &Key]( std::vector<Byte> const & Val ) {
-                    String Encoded = Val.empty()
-                        ? String()
-                        : base64_->EncodeBytesToString(
-                              Val.data(), Val.size() - 1
-                          );
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_VB ),
-                        YamlNode( ToUtf8( Encoded ) )
-                    );
                 }
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-                ,
-                [&Obj, &Key]( std::string const & Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_STR ),
-                        YamlNode( Val )
-                    );
-                },
-                [&Obj, &Key]( std::wstring const & Val ) {
-                    Obj[Key] = WrapTagged(
-                        ana_cnv_xstr( ANA_TT_WSTR ),
-                        YamlNode( ToUtf8( String( Val.c_str() ) ) )
-                    );
+                throw EStreamFallback{};
+            }
+
+            StringCont Decode( Codec::TAs<StringCont>, TPayload& Payload ) const {
+                switch ( Payload.Shape ) {
+                    case TShape::Sequence: return std::move( Payload.Strings );
+                    case TShape::Scalar:   return StringCont{};
+                    default:               throw EStreamFallback{};
                 }
-#endif
-            },
-            v.second.first
-        );
+            }
+
+            template<typename T>
+            static T FromText( Codec::TAs<T> Tag, std::string const & Text ) {
+                return Codec::TTextCodec::Decode( Tag, FromUtf8( Text ) );
+            }
+
+            static unsigned long long FromText( Codec::TAs<unsigned long long>,
+                                                std::string const & Text ) {
+                return std::stoull( Text );
+            }
+
+            static String FromText( Codec::TAs<String>, std::string const & Text ) {
+                return FromUtf8( Text );
+            }
+
+            static float FromText( Codec::TAs<float>, std::string const & Text ) {
+                return std::stof( Text );
+            }
+
+            static double FromText( Codec::TAs<double>, std::string const & Text ) {
+                return std::stod( Text );
+            }
+
+            static std::string FromText( Codec::TAs<std::string>,
+                                         std::string const & Text ) {
+                return Text;
+            }
+        };
+
+        TConfig& cfg_;
+        std::vector<TNodeFrame> nodes_;
+        std::vector<TState> states_;
+        TState member_ { TState::Values };  // of the member being entered
+        System::String name_;               // of the value or node being read
+        std::optional<TypeTag> tag_;
+        TPayload payload_;
+
+        void PushNode( TConfigNodePtr Node, System::String Name ) {
+            nodes_.push_back(
+                TNodeFrame{
+                    std::move( Node ), std::move( Name ),
+                    cfg_.NewValueList(), cfg_.NewNodeList()
+                }
+            );
+            states_.push_back( TState::Node );
+        }
+
+        // An int, String or bool stored without a type tag.
+        static TConfigNodeValueType Implicit( Sax::TKind Kind,
+                                              std::string_view Text ) {
+            switch ( Kind ) {
+                case Sax::TKind::String: return TConfigNodeValueType{ FromUtf8( Text ) };
+                case Sax::TKind::Bool:   return TConfigNodeValueType{ ToBool( Text ) };
+                case Sax::TKind::Int:
+                    return TConfigNodeValueType{ static_cast<int>( ToInt64( Text ) ) };
+                default:                 throw EStreamFallback{};
+            }
+        }
+
+        static bool ToBool( std::string_view Text ) {
+            if ( Text == "true" ) {
+                return true;
+            }
+            if ( Text != "false" ) {
+                throw EStreamFallback{};
+            }
+            return false;
+        }
+
+        // Plain decimal integers of up to 18 digits; signs, leading zeros,
+        // octal and hexadecimal are left to fkYAML.
+        static long long ToInt64( std::string_view Text ) {
+            auto First = Text.begin();
+            bool const Negative = *First == '-';
+            if ( Negative ) { ++First; }
+            auto const Digits = Text.end() - First;
+            if ( !Digits || Digits > 18 || ( *First == '0' && Digits > 1 ) ) {
+                throw EStreamFallback{};
+            }
+            long long Value {};
+            for ( ; First != Text.end() ; ++First ) {
+                if ( *First < '0' || *First > '9' ) {
+                    throw EStreamFallback{};
+                }
+                Value = Value * 10 + ( *First - '0' );
+            }
+            return Negative ? -Value : Value;
+        }
+    };
+
+    // Eager load: parses the file straight into the tree, without
+    // building an fkYAML document.  Returns false, with the root left
+    // empty, when the text is outside the subset Sax::Parse reads or has
+    // values TStreamLoader leaves to fkYAML; the caller then loads it
+    // through the document.
+    bool StreamRootNode() {
+        auto const Content = ReadFileBytes( loadFileName_ );
+        // Any failure, EStreamFallback or a decoding error, is
+        // reproduced (or handled) by the document reader.
+        try {
+            TStreamLoader Loader{ *this };
+            if ( Sax::Parse( Content.data(), Content.data() + Content.size(), Loader ) ) {
+                return true;
+            }
+        }
+        catch ( ... ) {
+        }
+        GetRootNode().Populate( NewValueList(), NewNodeList() );
+        return false;
     }
 
-protected:
-    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+    void LoadRootNode() {
+        if ( GetLazyLoadFlag() || !StreamRootNode() ) {
+            YAMLObjRAII YAML{ *this, /*Load*/true };
+            ReadRootNode();
+        }
+    }
 
-        using Fn = std::function<TConfigNodeValueType(YamlNode const &)>;
+    // TBufferedSink output to a file stream.
+    struct TFileWriter {
+        TStream& Stream;
 
-        static std::array<Fn,
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            std::variant_size<TConfigNodeValueType>::value
-#else
-            TConfigNodeValueType::types::size::value
-#endif
-        > Builders {
-            // TT_I
-            []( YamlNode const & V ) {
-                return static_cast<int>( V.get_value<std::int64_t>() );
-            },
-            // TT_U
-            []( YamlNode const & V ) {
-                return static_cast<unsigned int>( V.get_value<std::int64_t>() );
-            },
-            // TT_L
-            []( YamlNode const & V ) {
-                return static_cast<long>( V.get_value<std::int64_t>() );
-            },
-            // TT_UL
-            []( YamlNode const & V ) {
-                return static_cast<unsigned long>( V.get_value<std::int64_t>() );
-            },
-            // TT_C
-            []( YamlNode const & V ) {
-                return static_cast<char>( V.get_value<std::int64_t>() );
-            },
-            // TT_UC
-            []( YamlNode const & V ) {
-                return static_cast<unsigned char>( V.get_value<std::int64_t>() );
-            },
-            // TT_S
-            []( YamlNode const & V ) {
-                return static_cast<short>( V.get_value<std::int64_t>() );
-            },
-            // TT_US
-            []( YamlNode const & V ) {
-                return static_cast<unsigned short>( V.get_value<std::int64_t>() );
-            },
-            // TT_LL
-            []( YamlNode const & V ) {
-                return static_cast<long long>( V.get_value<std::int64_t>() );
-            },
-            // TT_ULL — decimal string
-            []( YamlNode const & V ) {
-                return std::stoull( V.get_value<std::string>() );
-            },
-            // TT_B
-            []( YamlNode const & V ) {
-                return V.get_value<bool>();
-            },
-            // TT_SZ
-            []( YamlNode const & V ) {
-                return FromUtf8( V.get_value<std::string>() );
-            },
-            // TT_DT
-            []( YamlNode const & V ) {
-                return ISO8601ToDate( FromUtf8( V.get_value<std::string>() ), false );
-            },
-            // TT_FLT  (string-encoded for full precision)
-            []( YamlNode const & V ) {
-                return std::stof( V.get_value<std::string>() );
-            },
-            // TT_DBL  (string-encoded for full precision)
-            []( YamlNode const & V ) {
-                return std::stod( V.get_value<std::string>() );
-            },
-            // TT_CUR
-            []( YamlNode const & V ) {
-                TFormatSettings FS;
-                FS.DecimalSeparator = _D( '.' );
-                return StrToCurr( FromUtf8( V.get_value<std::string>() ), FS );
-            },
-            // TT_SV
-            []( YamlNode const & V ) {
-                StringCont Strings;
-                if ( V.is_sequence() ) {
-                    Strings.reserve( V.size() );
-                    for ( auto It = V.begin(); It != V.end(); ++It ) {
-                        Strings.push_back( FromUtf8( It->get_value<std::string>() ) );
-                    }
+        void Write( char const * Data, std::size_t Length ) {
+            Stream.WriteBuffer( Data, static_cast<NativeInt>( Length ) );
+        }
+    };
+
+    // Writer for TConfigNode::Write rendering the file in block style,
+    // straight into a sink, with the layout the document writer gave it:
+    // a node is a mapping with "values" ahead of "nodes", and is written
+    // when it has a value to write, together with whatever is still
+    // missing of the path down to it, so that nodes with no values
+    // anywhere below are left out.  A value is written as {Type: Inner},
+    // except an int, bool or String when explicit types are off.
+    // Integers are int64 scalars; floating point and the alternatives
+    // YAML has no native form for are strings.
+    template<typename S>
+    class TStreamWriter {
+    public:
+        TStreamWriter( TConfig& Cfg, S& Sink ) : cfg_{ Cfg }, out_{ Sink } {}
+
+        bool GetAlwaysFlushNodeFlag() const noexcept {
+            return cfg_.GetAlwaysFlushNodeFlag();
+        }
+
+        // Deletion is implicit: the file is rewritten from the tree, where
+        // a node that has been Cleared has nothing left to write.
+        void DeleteNode( TConfigPath const & ) {}
+
+        void SaveValueList( TConfigPath const &, ValueContType const & Values ) {
+            auto const IsWritten = []( ValueContType::value_type const & v ) {
+                return v.second.second != Operation::Erase;
+            };
+            if ( std::none_of( Values.begin(), Values.end(), IsWritten ) ) {
+                return;
+            }
+            Open();
+            out_.Key( Depth(), ValuesKeyU8 );
+            out_.Block();
+            for ( auto const & v : Values ) {
+                if ( IsWritten( v ) ) {
+                    out_.Key( Depth() + 1, Utf8( v.first ) );
+                    Codec::Encode( v.second.first, TTokenCodec{ *this } );
                 }
-                return Strings;
-            },
-            // TT_DAB
-            []( YamlNode const & V ) {
-                return TNetEncoding::Base64->DecodeStringToBytes(
-                    FromUtf8( V.get_value<std::string>() )
+            }
+        }
+
+        void EnterNode( String const & Name ) { frames_.push_back( TFrame{ Name } ); }
+
+        void LeaveNode() noexcept { frames_.pop_back(); }
+    private:
+        struct TFrame {
+            String Name;
+            bool Written {};        // its key, and so its mapping
+            bool NodesWritten {};   // its "nodes" key
+        };
+
+        struct TTokenCodec {
+            TStreamWriter& W;
+
+            template<typename T>
+            void EncodeInteger( long long Val ) const {
+                W.Tagged( Codec::TagName<T>() );
+                W.Integer( Val );
+            }
+
+            template<typename T>
+            void EncodeText( T const & Val ) const {
+                W.Tagged( Codec::TagName<T>() );
+                W.Text( Codec::TTextCodec::Encode( Codec::TAs<T>{}, Val ) );
+            }
+
+            // As a string: 9 / 17 significant digits round-trip a float /
+            // double.
+            template<typename T>
+            void EncodeFloat( T Val, int Digits ) const {
+                char Buf[64];
+                std::snprintf( Buf, sizeof Buf, "%.*g", Digits, static_cast<double>( Val ) );
+                W.Tagged( Codec::TagName<T>() );
+                W.out_.String( Buf );
+            }
+
+            void EncodeBytes( char const * Tag, Byte const * Data, int High ) const {
+                W.Tagged( Tag );
+                W.Text(
+                    High < 0 ? String() : W.cfg_.base64_->EncodeBytesToString( Data, High )
                 );
-            },
-            // TT_VB
-            []( YamlNode const & V ) {
-                auto Bytes = TNetEncoding::Base64->DecodeStringToBytes(
-                    FromUtf8( V.get_value<std::string>() )
+            }
+
+            void Encode( Codec::TAs<int>, int Val ) const {
+                if ( W.cfg_.explicitTypes_ ) { EncodeInteger<int>( Val ); }
+                else { W.Integer( Val ); }
+            }
+
+            void Encode( Codec::TAs<unsigned int>, unsigned int Val ) const {
+                EncodeInteger<unsigned int>( Val );
+            }
+
+            void Encode( Codec::TAs<long>, long Val ) const {
+                EncodeInteger<long>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned long>, unsigned long Val ) const {
+                EncodeInteger<unsigned long>( Val );
+            }
+
+            void Encode( Codec::TAs<char>, char Val ) const {
+                EncodeInteger<char>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned char>, unsigned char Val ) const {
+                EncodeInteger<unsigned char>( Val );
+            }
+
+            void Encode( Codec::TAs<short>, short Val ) const {
+                EncodeInteger<short>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned short>, unsigned short Val ) const {
+                EncodeInteger<unsigned short>( Val );
+            }
+
+            void Encode( Codec::TAs<long long>, long long Val ) const {
+                EncodeInteger<long long>( Val );
+            }
+
+            void Encode( Codec::TAs<unsigned long long>, unsigned long long Val ) const {
+                // Stored as decimal string to avoid 64-bit precision loss.
+                char Buf[32];
+                std::snprintf( Buf, sizeof Buf, "%llu", Val );
+                W.Tagged( Codec::TagName<unsigned long long>() );
+                W.out_.String( Buf );
+            }
+
+            void Encode( Codec::TAs<bool>, bool Val ) const {
+                if ( W.cfg_.explicitTypes_ ) { W.Tagged( Codec::TagName<bool>() ); }
+                W.out_.Token( Val ? "true" : "false" );
+            }
+
+            void Encode( Codec::TAs<String>, String const & Val ) const {
+                if ( W.cfg_.explicitTypes_ ) { W.Tagged( Codec::TagName<String>() ); }
+                W.Text( Val );
+            }
+
+            void Encode( Codec::TAs<TDateTime>, TDateTime Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<float>, float Val ) const {
+                EncodeFloat( Val, 9 );
+            }
+
+            void Encode( Codec::TAs<double>, double Val ) const {
+                EncodeFloat( Val, 17 );
+            }
+
+            void Encode( Codec::TAs<Currency>, Currency Val ) const {
+                EncodeText( Val );
+            }
+
+            void Encode( Codec::TAs<StringCont>, StringCont const & Val ) const {
+                W.Tagged( Codec::TagName<StringCont>() );
+                if ( Val.empty() ) {
+                    W.out_.Token( "[]" );
+                    return;
+                }
+                W.out_.Block();
+                for ( auto const & S : Val ) {
+                    W.out_.Item( W.Depth() + 3, W.Utf8( S ) );
+                }
+            }
+
+            void Encode( Codec::TAs<TBytes>, TBytes Val ) const {
+                EncodeBytes(
+                    Codec::TagName<TBytes>(),
+                    Val.Length == 0 ? nullptr : &Val[0], Val.High
                 );
-                std::vector<Byte> VBytes;
-                VBytes.reserve( Bytes.Length );
-                std::copy(
-                    std::begin( Bytes ), std::end( Bytes ),
-                    std::back_inserter( VBytes )
+            }
+
+            void Encode( Codec::TAs<BytesCont>, BytesCont const & Val ) const {
+                EncodeBytes(
+                    Codec::TagName<BytesCont>(),
+                    Val.data(), static_cast<int>( Val.size() ) - 1
                 );
-                return VBytes;
-            },
-#if defined( ANAFESTICA_USE_STD_VARIANT )
-            // TT_STR
-            []( YamlNode const & V ) {
-                return V.get_value<std::string>();
-            },
-            // TT_WSTR
-            []( YamlNode const & V ) {
-                String Tmp = FromUtf8( V.get_value<std::string>() );
-                return std::wstring( Tmp.c_str() );
-            },
-#endif
+            }
+
+            void Encode( Codec::TAs<std::string>, std::string const & Val ) const {
+                W.Tagged( Codec::TagName<std::string>() );
+                W.out_.String( Val );
+            }
+
+            void Encode( Codec::TAs<std::wstring>, std::wstring const & Val ) const {
+                EncodeText( Val );
+            }
         };
 
-        ValueContType Values;
+        TConfig& cfg_;
+        TTextWriter<S> out_;
+        std::vector<TFrame> frames_ { TFrame{ String(), true } };
+        std::string text_;
+
+        // Of the current node's "values" and "nodes" keys.
+        std::size_t Depth() const noexcept { return 2 * ( frames_.size() - 1 ); }
+
+        // Writes the keys of the current node and of the nodes above it
+        // that are not written yet, each under its parent's "nodes".
+        void Open() {
+            auto First = frames_.size();
+            while ( !frames_[First - 1].Written ) {
+                --First;
+            }
+            for ( auto Idx = First ; Idx < frames_.size() ; ++Idx ) {
+                auto& Parent = frames_[Idx - 1];
+                if ( !Parent.NodesWritten ) {
+                    out_.Key( 2 * ( Idx - 1 ), NodesKeyU8 );
+                    out_.Block();
+                    Parent.NodesWritten = true;
+                }
+                out_.Key( 2 * Idx - 1, Utf8( frames_[Idx].Name ) );
+                out_.Block();
+                frames_[Idx].Written = true;
+            }
+        }
+
+        // Ends the line of the value's key; the value is a {Tag: Inner}
+        // mapping, whose Inner comes next.
+        void Tagged( char const * Tag ) {
+            out_.Block();
+            out_.Key( Depth() + 2, Tag );
+        }
+
+        void Integer( long long Val ) {
+            char Buf[32];
+            std::snprintf( Buf, sizeof Buf, "%lld", Val );
+            out_.Token( Buf );
+        }
+
+        void Text( String const & Val ) { out_.String( Utf8( Val ) ); }
+
+        // Valid until the next call.
+        std::string_view Utf8( String const & Text ) {
+            auto const First = Text.c_str();
+            auto const Last = First + Text.Length();
+            if ( std::all_of( First, Last, []( WideChar Ch ){ return Ch < 0x80; } ) ) {
+                text_.resize( static_cast<std::size_t>( Last - First ) );
+                std::transform(
+                    First, Last, text_.begin(),
+                    []( WideChar Ch ){ return static_cast<char>( Ch ); }
+                );
+            }
+            else {
+                auto const Encoded = UTF8Encode( Text );
+                text_.assign( Encoded.c_str(), Encoded.Length() );
+            }
+            return text_;
+        }
+    };
+
+protected:
+    virtual ValueContType DoCreateValueList( TConfigPath const & Path ) override {
+
+        auto Values = NewValueList();
 
         if ( auto Section = OpenValues( Path ) ) {
             for ( auto It = Section->begin() ; It != Section->end() ; ++It ) {
@@ -628,13 +984,14 @@ protected:
                 // Tagged form: { type: data }  (single-key mapping)
                 if ( Val.is_mapping() && Val.size() == 1 ) {
                     auto Inner = Val.begin();
-                    String TypeName = FromUtf8( Inner.key().get_value<std::string>() );
-                    if ( auto Tag = GetTypeTag( TypeName ) ) {
+                    std::string const TypeName = Inner.key().get_value<std::string>();
+                    if ( auto Tag = FindTypeTag( TypeName.data(), TypeName.size() ) ) {
                         try {
                             PutItemTo(
                                 Values, Name,
                                 {
-                                    Builders[static_cast<size_t>( Tag.value() )](
+                                    Codec::Decode(
+                                        Tag.value(), TValueCodec{ *this },
                                         Inner.value()
                                     ),
                                     Operation::None
@@ -643,7 +1000,7 @@ protected:
                             Handled = true;
                         }
                         catch ( ... ) {
-                            // Builder failed for this entry — leave it out.
+                            // Decoding failed for this entry — leave it out.
                             Handled = true;
                         }
                     }
@@ -694,46 +1051,34 @@ protected:
     }
 
     virtual NodeContType DoCreateNodeList( TConfigPath const & Path ) override {
-        NodeContType Nodes;
+        auto Nodes = NewNodeList();
         if ( auto NodesMap = OpenNodes( Path ) ) {
             for ( auto It = NodesMap->begin() ; It != NodesMap->end() ; ++It ) {
                 if ( It.value().is_mapping() ) {
                     String const NodeName =
                         FromUtf8( It.key().get_value<std::string>() );
-                    Nodes[NodeName] = std::make_unique<TConfigNode>();
+                    Nodes[NodeName] = NewNode();
                 }
             }
         }
         return Nodes;
     }
 
-    virtual void DoSaveValueList( TConfigPath const & Path,
-                                  ValueContType const & Values ) override {
-        bool HasAny = false;
-        for ( auto const & v : Values ) {
-            if ( v.second.second != Operation::Erase ) { HasAny = true; break; }
-        }
-        if ( !HasAny ) return;
-
-        if ( auto Node = ForceValues( Path ) ) {
-            for ( auto const & v : Values ) {
-                if ( v.second.second != Operation::Erase ) {
-                    SaveValue( *Node, v );
-                }
-            }
-        }
+    // DoFlush writes through TStreamWriter rather than through here.
+    virtual void DoSaveValueList( TConfigPath const & /*Path*/,
+                                  ValueContType const & /*Values*/ ) override {
     }
 
-    // Deletion is implicit: DoFlush rebuilds the document from scratch, so
-    // any TConfigNode that has been Cleared is simply not re-emitted.
     virtual void DoDeleteNode( TConfigPath const & /*Path*/ ) override {
     }
 
-    virtual void DoFlush() override {
-        // Build a fresh YAML document from the current in-memory tree.
-        YAMLObjRAII YAML{ *this, /*Load*/false };
-        GetRootNode().Write( *this, TConfigPath{} );
+    virtual void DoEnterNode( String const & Name ) override {
+        cursor_.Enter( Name );
+    }
 
+    virtual void DoLeaveNode() noexcept override { cursor_.Leave(); }
+
+    virtual void DoFlush() override {
         if ( !TFile::Exists( fileName_ ) ) {
             auto Path = TPath::GetFullPath( TPath::GetDirectoryName( fileName_ ) );
             if ( !TDirectory::Exists( Path ) ) {
@@ -741,8 +1086,24 @@ protected:
             }
         }
 
-        std::string Yaml = YamlNode::serialize( *document_ );
-        WriteFileBytes( fileName_, Yaml );
+        // The file is written as the tree is walked, through a buffer of
+        // fixed size; an encrypted file is assembled in memory first, as
+        // Crypt::SaveBytes takes it whole.
+        if ( cryptOptions_.Enabled ) {
+            Crypt::Bytes Text;
+            TMemorySink<Crypt::Bytes> Sink{ Text };
+            TStreamWriter<TMemorySink<Crypt::Bytes>> Writer{ *this, Sink };
+            GetRootNode().Write( Writer, TConfigPath{} );
+            Crypt::SaveBytes( fileName_, Text, cryptOptions_ );
+        }
+        else {
+            auto Stream = std::make_unique<TFileStream>( fileName_, fmCreate );
+            TFileWriter Out{ *Stream };
+            TBufferedSink<TFileWriter> Sink{ Out };
+            TStreamWriter<TBufferedSink<TFileWriter>> Writer{ *this, Sink };
+            GetRootNode().Write( Writer, TConfigPath{} );
+            Sink.Flush();
+        }
     }
 
     virtual bool DoGetForcedWritesFlag() const {
@@ -15,26 +15,32 @@ class TConfig : public YAML::TConfig {
 public:
     TConfig( String FileName, bool ReadOnly = false,
              bool FlushAllItems = false, bool ExplicitTypes = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             TConfigOptions CfgOptions = {} )
         : YAML::TConfig(
-            FileName, ReadOnly, FlushAllItems, ExplicitTypes, Options
+            FileName, ReadOnly, FlushAllItems, ExplicitTypes, Options,
+            CfgOptions
           )
     {}
 
     TConfig( String LoadFileName, String SaveFileName,
              bool ReadOnly = false, bool ExplicitTypes = false,
-             Crypt::TOptions Options = Crypt::TOptions::Default() )
+             Crypt::TOptions Options = Crypt::TOptions::Default(),
+             TConfigOptions CfgOptions = {} )
         : YAML::TConfig(
-            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options
+            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options,
+            CfgOptions
           )
     {}
 
     static TConfig Migrate( String LoadFileName, String SaveFileName,
                             bool ReadOnly = false, bool ExplicitTypes = false,
-                            Crypt::TOptions Options = Crypt::TOptions::Default() )
+                            Crypt::TOptions Options = Crypt::TOptions::Default(),
+                            TConfigOptions CfgOptions = {} )
     {
         return TConfig(
-            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options
+            LoadFileName, SaveFileName, ReadOnly, ExplicitTypes, Options,
+            CfgOptions
         );
     }
 };
@@ -0,0 +1,808 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgYAMLSaxH
+#define CfgYAMLSaxH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_yaml_sax.cpp).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace YAML {
+//---------------------------------------------------------------------------
+namespace Sax {
+//---------------------------------------------------------------------------
+
+/// Nesting limit used by @ref Parse unless the caller passes another.
+inline constexpr std::size_t DefaultMaxDepth = 512;
+
+/// What a scalar resolves to under the YAML 1.2 core schema.  Quoted
+/// scalars are always @c String.
+enum class TKind {
+    String,
+    Null,       ///< empty, @c ~, @c null, @c Null or @c NULL
+    Bool,       ///< @c true, @c True, @c TRUE, @c false, @c False or @c FALSE
+    Int,        ///< decimal, @c 0o octal or @c 0x hexadecimal
+    Float       ///< decimal with a fraction or an exponent, @c .inf or @c .nan
+};
+
+/// Outcome of @ref Parse.
+struct TResult {
+    char const * Error {};      ///< static message; @c nullptr on success
+    std::size_t Offset {};      ///< byte offset at which parsing stopped
+
+    explicit operator bool() const noexcept { return !Error; }
+};
+
+namespace Detail {
+
+inline bool IsDigits( std::string_view Text, bool (*Digit)( char ) ) noexcept {
+    return !Text.empty() && std::all_of( Text.begin(), Text.end(), Digit );
+}
+
+inline bool IsDecimal( char Ch ) noexcept { return Ch >= '0' && Ch <= '9'; }
+
+inline bool IsOctal( char Ch ) noexcept { return Ch >= '0' && Ch <= '7'; }
+
+inline bool IsHex( char Ch ) noexcept {
+    return IsDecimal( Ch ) || ( Ch >= 'a' && Ch <= 'f' ) || ( Ch >= 'A' && Ch <= 'F' );
+}
+
+// [-+]? ( \. [0-9]+ | [0-9]+ ( \. [0-9]* )? ) ( [eE] [-+]? [0-9]+ )?
+inline bool IsFloat( std::string_view Text ) noexcept {
+    auto Cur = Text.begin();
+    auto const Last = Text.end();
+    auto Digits = [&]{
+        auto const Start = Cur;
+        while ( Cur != Last && IsDecimal( *Cur ) ) { ++Cur; }
+        return Cur - Start;
+    };
+    if ( Cur != Last && ( *Cur == '-' || *Cur == '+' ) ) { ++Cur; }
+    auto const Whole = Digits();
+    if ( Cur != Last && *Cur == '.' ) {
+        ++Cur;
+        if ( !Digits() && !Whole ) { return false; }
+    }
+    else if ( !Whole ) {
+        return false;
+    }
+    if ( Cur != Last && ( *Cur == 'e' || *Cur == 'E' ) ) {
+        ++Cur;
+        if ( Cur != Last && ( *Cur == '-' || *Cur == '+' ) ) { ++Cur; }
+        if ( !Digits() ) { return false; }
+    }
+    return Cur == Last;
+}
+
+/// Resolves a plain scalar by the YAML 1.2 core schema.
+inline TKind Resolve( std::string_view Text ) noexcept {
+    if ( Text.empty() || Text == "~" ||
+         Text == "null" || Text == "Null" || Text == "NULL" )
+    {
+        return TKind::Null;
+    }
+    if ( Text == "true" || Text == "True" || Text == "TRUE" ||
+         Text == "false" || Text == "False" || Text == "FALSE" )
+    {
+        return TKind::Bool;
+    }
+    auto Unsigned = Text;
+    if ( Unsigned.front() == '-' || Unsigned.front() == '+' ) {
+        Unsigned.remove_prefix( 1 );
+    }
+    if ( IsDigits( Unsigned, &IsDecimal ) ||
+         ( Text.substr( 0, 2 ) == "0o" && IsDigits( Text.substr( 2 ), &IsOctal ) ) ||
+         ( Text.substr( 0, 2 ) == "0x" && IsDigits( Text.substr( 2 ), &IsHex ) ) )
+    {
+        return TKind::Int;
+    }
+    if ( IsFloat( Text ) ||
+         Unsigned == ".inf" || Unsigned == ".Inf" || Unsigned == ".INF" ||
+         Text == ".nan" || Text == ".NaN" || Text == ".NAN" )
+    {
+        return TKind::Float;
+    }
+    return TKind::String;
+}
+
+// The block-style subset of YAML that configuration files are written in,
+// read a line at a time.  Whatever is outside it is an error rather than
+// a guess, so that a caller can hand the text to a complete parser.
+template<typename H>
+class TParser {
+public:
+    TParser( char const * First, char const * Last, H& Handler,
+             std::size_t MaxDepth )
+      : first_{ First }, cur_{ First }, last_{ Last }
+      , handler_{ Handler }, maxDepth_{ MaxDepth }
+    {}
+
+    TResult Run() {
+        if ( last_ - cur_ >= 3 &&
+             static_cast<unsigned char>( cur_[0] ) == 0xEF &&
+             static_cast<unsigned char>( cur_[1] ) == 0xBB &&
+             static_cast<unsigned char>( cur_[2] ) == 0xBF )
+        {
+            cur_ += 3;
+        }
+        if ( Validate() ) {
+            while ( cur_ != last_ && Line() ) {
+            }
+            if ( !error_ ) {
+                Finish();
+            }
+        }
+        return TResult{ error_, static_cast<std::size_t>( cur_ - first_ ) };
+    }
+private:
+    struct TFrame {
+        std::size_t Indent;
+        bool Sequence;
+        bool Compact;           // block sequence at the indentation of its key
+        bool Emit;
+        std::size_t Keys;       // its first key in keys_
+    };
+
+    struct TKey {
+        std::uint64_t Hash;
+        std::string_view Name;
+
+        bool operator<( TKey const & Rhs ) const noexcept { return Hash < Rhs.Hash; }
+    };
+
+    // A key or sequence entry whose value starts on a later line.
+    struct TPending {
+        bool Active {};
+        std::size_t Indent {};  // of the key or of the '-'
+        bool Entry {};
+        bool Emit {};
+    };
+
+    char const * first_;
+    char const * cur_;
+    char const * last_;
+    char const * end_ {};       // end of the current line, before its break
+    char const * next_ {};      // start of the next line
+    H& handler_;
+    std::size_t maxDepth_;
+    std::size_t flow_ {};       // nesting of the flow collection being read
+    char const * error_ {};
+    bool started_ {};
+    std::vector<TFrame> frames_;
+    TPending pending_;
+    std::vector<TKey> keys_;                // of the open mappings
+    std::deque<std::string> escapedKeys_;   // keys_ with escapes
+    std::string scratch_;       // unescaped text of the last quoted scalar
+
+    bool Fail( char const * Error ) {
+        if ( !error_ ) { error_ = Error; }
+        return false;
+    }
+
+    // UTF-8 without control characters other than tab and line breaks,
+    // and without a carriage return on its own.
+    bool Validate() {
+        auto Cur = cur_;
+        while ( Cur != last_ ) {
+            if ( last_ - Cur >= 8 ) {
+                std::uint64_t Block;
+                std::memcpy( &Block, Cur, sizeof Block );
+                if ( !( ( ( Block - 0x2020202020202020ull ) | Block ) & 0x8080808080808080ull ) ) {
+                    Cur += 8;
+                    continue;
+                }
+            }
+            auto const Lead = static_cast<unsigned char>( *Cur );
+            if ( Lead < 0x80 ) {
+                if ( Lead < 0x20 && Lead != '\t' && Lead != '\n' &&
+                     ( Lead != '\r' || Cur + 1 == last_ || Cur[1] != '\n' ) )
+                {
+                    cur_ = Cur;
+                    return Fail( "unsupported: control character" );
+                }
+                ++Cur;
+                continue;
+            }
+            std::size_t Length;
+            std::uint32_t Code;
+            if ( Lead >= 0xC2 && Lead < 0xE0 ) { Length = 2; Code = Lead & 0x1F; }
+            else if ( Lead >= 0xE0 && Lead < 0xF0 ) { Length = 3; Code = Lead & 0x0F; }
+            else if ( Lead >= 0xF0 && Lead < 0xF5 ) { Length = 4; Code = Lead & 0x07; }
+            else { cur_ = Cur; return Fail( "invalid UTF-8" ); }
+            if ( static_cast<std::size_t>( last_ - Cur ) < Length ) {
+                cur_ = Cur;
+                return Fail( "invalid UTF-8" );
+            }
+            for ( std::size_t Idx = 1 ; Idx < Length ; ++Idx ) {
+                auto const Trail = static_cast<unsigned char>( Cur[Idx] );
+                if ( ( Trail & 0xC0 ) != 0x80 ) {
+                    cur_ = Cur;
+                    return Fail( "invalid UTF-8" );
+                }
+                Code = ( Code << 6 ) | ( Trail & 0x3F );
+            }
+            if ( ( Length == 3 && ( Code < 0x800 || ( Code >= 0xD800 && Code < 0xE000 ) ) ) ||
+                 ( Length == 4 && ( Code < 0x10000 || Code > 0x10FFFF ) ) )
+            {
+                cur_ = Cur;
+                return Fail( "invalid UTF-8" );
+            }
+            Cur += Length;
+        }
+        return true;
+    }
+
+    void SkipSpace() noexcept {
+        while ( cur_ != end_ && *cur_ == ' ' ) { ++cur_; }
+    }
+
+    bool Consume( char Ch ) noexcept {
+        if ( cur_ != end_ && *cur_ == Ch ) {
+            ++cur_;
+            return true;
+        }
+        return false;
+    }
+
+    // Whether cur_ is at Ch followed by a space or the line end.
+    bool Indicator( char Ch ) const noexcept {
+        return cur_ != end_ && *cur_ == Ch && ( cur_ + 1 == end_ || cur_[1] == ' ' );
+    }
+
+    // Skips trailing spaces and a comment; true when nothing else is left.
+    bool AtLineEnd() noexcept {
+        auto const Start = cur_;
+        SkipSpace();
+        if ( cur_ == end_ ) {
+            return true;
+        }
+        if ( *cur_ == '#' && ( cur_ == Start ? cur_[-1] == ' ' : true ) ) {
+            cur_ = end_;
+            return true;
+        }
+        return false;
+    }
+
+    bool ExpectLineEnd() {
+        return AtLineEnd() || Fail( "unsupported: text after a value" );
+    }
+
+    bool Line() {
+        auto const Break = static_cast<char const *>(
+            std::memchr( cur_, '\n', static_cast<std::size_t>( last_ - cur_ ) )
+        );
+        next_ = Break ? Break + 1 : last_;
+        end_ = Break ? Break : last_;
+        if ( end_ != cur_ && end_[-1] == '\r' ) {
+            --end_;
+        }
+        auto const Start = cur_;
+        SkipSpace();
+        auto const Indent = static_cast<std::size_t>( cur_ - Start );
+        if ( cur_ == end_ || *cur_ == '#' ) {
+            cur_ = next_;
+            return true;
+        }
+        if ( *cur_ == '\t' ) {
+            return Fail( "unsupported: tab in indentation" );
+        }
+        if ( !Indent ) {
+            if ( end_ - cur_ >= 3 &&
+                 ( std::string_view( cur_, 3 ) == "---" || std::string_view( cur_, 3 ) == "..." ) &&
+                 ( end_ - cur_ == 3 || cur_[3] == ' ' ) )
+            {
+                if ( started_ || *cur_ == '.' ) {
+                    return Fail( "unsupported: several documents" );
+                }
+                cur_ += 3;
+                if ( !AtLineEnd() ) {
+                    return Fail( "unsupported: content after ---" );
+                }
+                cur_ = next_;
+                return true;
+            }
+            if ( *cur_ == '%' ) {
+                return Fail( "unsupported: directive" );
+            }
+        }
+        bool const Entry = Indicator( '-' );
+        if ( pending_.Active ) {
+            pending_.Active = false;
+            if ( Indent > pending_.Indent ||
+                 ( Indent == pending_.Indent && Entry && !pending_.Entry ) )
+            {
+                if ( !Open( Indent, Entry, Indent == pending_.Indent, pending_.Emit ) ) {
+                    return false;
+                }
+            }
+            else if ( pending_.Emit ) {
+                handler_.Scalar( std::string_view(), TKind::Null );
+            }
+        }
+        while ( !frames_.empty() &&
+                ( Indent < frames_.back().Indent ||
+                  ( Indent == frames_.back().Indent && frames_.back().Compact && !Entry ) ) )
+        {
+            if ( !Close() ) {
+                return false;
+            }
+        }
+        if ( frames_.empty() ) {
+            if ( started_ ) {
+                return Fail( "unexpected content after the document" );
+            }
+            started_ = true;
+            if ( *cur_ == '[' || *cur_ == '{' ) {
+                if ( !Inline( true ) || !ExpectLineEnd() ) {
+                    return false;
+                }
+                cur_ = next_;
+                return true;
+            }
+            if ( !Open( Indent, Entry, false, true ) ) {
+                return false;
+            }
+        }
+        auto const & Top = frames_.back();
+        if ( Indent != Top.Indent ) {
+            return Fail( "unsupported: indentation" );
+        }
+        if ( Top.Sequence != Entry ) {
+            return Fail( Entry ? "unexpected sequence entry" : "expected a sequence entry" );
+        }
+        if ( !( Entry ? SequenceEntry() : MappingEntry() ) ) {
+            return false;
+        }
+        cur_ = next_;
+        return true;
+    }
+
+    bool Open( std::size_t Indent, bool Sequence, bool Compact, bool Emit ) {
+        if ( frames_.size() + 1 > maxDepth_ ) {
+            return Fail( "nesting too deep" );
+        }
+        bool Report = Emit;
+        if ( Emit ) {
+            Report = Sequence ? handler_.StartSequence() : handler_.StartMapping();
+        }
+        frames_.push_back( TFrame{ Indent, Sequence, Compact, Report, keys_.size() } );
+        return true;
+    }
+
+    bool Close() {
+        auto const Frame = frames_.back();
+        frames_.pop_back();
+        if ( !Frame.Sequence && !CloseKeys( Frame.Keys ) ) {
+            return false;
+        }
+        if ( Frame.Emit ) {
+            if ( Frame.Sequence ) { handler_.EndSequence(); }
+            else { handler_.EndMapping(); }
+        }
+        return true;
+    }
+
+    // Drops the keys of a mapping from keys_, failing on a duplicate.
+    // They are compared by hash, and by name only when two hashes match;
+    // a mapping of a few keys is checked pairwise rather than sorted.
+    bool CloseKeys( std::size_t First ) {
+        auto const Begin = keys_.begin() + static_cast<std::ptrdiff_t>( First );
+        auto const End = keys_.end();
+        auto Same = [&]( TKey const & Lhs, TKey const & Rhs ) {
+            return Lhs.Hash == Rhs.Hash && Lhs.Name == Rhs.Name;
+        };
+        bool Unique = true;
+        if ( End - Begin <= 8 ) {
+            for ( auto It = Begin ; Unique && It != End ; ++It ) {
+                Unique = std::none_of(
+                    std::next( It ), End, [&]( TKey const & Key ){ return Same( *It, Key ); }
+                );
+            }
+        }
+        else {
+            std::sort( Begin, End );
+            for ( auto It = Begin ; Unique && It != End ; ++It ) {
+                for ( auto Next = std::next( It ) ; Next != End && Next->Hash == It->Hash ; ++Next ) {
+                    Unique = Unique && Next->Name != It->Name;
+                }
+            }
+        }
+        keys_.erase( Begin, End );
+        return Unique || Fail( "unsupported: duplicate key" );
+    }
+
+    static std::uint64_t HashOf( std::string_view Name ) noexcept {
+        std::uint64_t Hash = 0xCBF29CE484222325ull;
+        for ( auto Ch : Name ) {
+            Hash = ( Hash ^ static_cast<unsigned char>( Ch ) ) * 0x100000001B3ull;
+        }
+        return Hash;
+    }
+
+    void Finish() {
+        if ( pending_.Active && pending_.Emit ) {
+            handler_.Scalar( std::string_view(), TKind::Null );
+        }
+        while ( !frames_.empty() && Close() ) {
+        }
+    }
+
+    bool SequenceEntry() {
+        ++cur_;
+        return Value( true, frames_.back().Emit );
+    }
+
+    bool MappingEntry() {
+        std::string_view Name;
+        TKind Kind;
+        if ( !Key( Name, Kind, false ) ) {
+            return false;
+        }
+        if ( !Consume( ':' ) || ( cur_ != end_ && *cur_ != ' ' ) ) {
+            return Fail( "expected ': '" );
+        }
+        bool const Member = frames_.back().Emit && handler_.Key( Name, Kind );
+        return Value( false, Member );
+    }
+
+    // The value after a key or a '-': on this line, or the block below.
+    bool Value( bool Entry, bool Emit ) {
+        if ( AtLineEnd() ) {
+            pending_ = TPending{ true, frames_.back().Indent, Entry, Emit };
+            return true;
+        }
+        return Inline( Emit ) && ExpectLineEnd();
+    }
+
+    // A key, up to its ':', recorded in keys_.
+    bool Key( std::string_view& Name, TKind& Kind, bool Flow ) {
+        if ( cur_ != end_ && ( *cur_ == '"' || *cur_ == '\'' ) ) {
+            if ( !Quoted( Name ) ) {
+                return false;
+            }
+            if ( Name.data() == scratch_.data() ) {
+                Name = escapedKeys_.emplace_back( scratch_ );
+            }
+            Kind = TKind::String;
+            SkipSpace();
+        }
+        else if ( !Plain( Name, Flow, true ) ) {
+            return false;
+        }
+        else {
+            Kind = Resolve( Name );
+        }
+        keys_.push_back( TKey{ HashOf( Name ), Name } );
+        return true;
+    }
+
+    // A scalar or flow collection that starts at cur_.
+    bool Inline( bool Emit ) {
+        if ( cur_ == end_ ) {
+            return Fail( "unsupported: multi-line flow collection" );
+        }
+        switch ( *cur_ ) {
+            case '[':
+            case '{': {
+                if ( frames_.size() + ++flow_ > maxDepth_ ) {
+                    return Fail( "nesting too deep" );
+                }
+                bool const Sequence = *cur_++ == '[';
+                bool Report = Emit;
+                if ( Emit ) {
+                    Report = Sequence ? handler_.StartSequence() : handler_.StartMapping();
+                }
+                if ( !( Sequence ? FlowSequence( Report ) : FlowMapping( Report ) ) ) {
+                    return false;
+                }
+                --flow_;
+                if ( Report ) {
+                    if ( Sequence ) { handler_.EndSequence(); }
+                    else { handler_.EndMapping(); }
+                }
+                return true;
+            }
+            case '"':
+            case '\'': {
+                std::string_view Text;
+                if ( !Quoted( Text ) ) {
+                    return false;
+                }
+                if ( Emit ) { handler_.Scalar( Text, TKind::String ); }
+                return true;
+            }
+            default: {
+                std::string_view Text;
+                if ( !Plain( Text, flow_ != 0, false ) ) {
+                    return false;
+                }
+                if ( Emit ) { handler_.Scalar( Text, Resolve( Text ) ); }
+                return true;
+            }
+        }
+    }
+
+    bool FlowSequence( bool Emit ) {
+        SkipSpace();
+        if ( Consume( ']' ) ) {
+            return true;
+        }
+        for ( ;; ) {
+            if ( !Inline( Emit ) ) {
+                return false;
+            }
+            SkipSpace();
+            if ( Consume( ']' ) ) {
+                return true;
+            }
+            if ( !Consume( ',' ) ) {
+                return Fail( "expected ',' or ']'" );
+            }
+            SkipSpace();
+        }
+    }
+
+    bool FlowMapping( bool Emit ) {
+        auto const Keys = keys_.size();
+        SkipSpace();
+        if ( !Consume( '}' ) ) {
+            for ( ;; ) {
+                std::string_view Name;
+                TKind Kind;
+                if ( !Key( Name, Kind, true ) ) {
+                    return false;
+                }
+                if ( !Consume( ':' ) || cur_ == end_ || *cur_ != ' ' ) {
+                    return Fail( "expected ': '" );
+                }
+                SkipSpace();
+                bool const Member = Emit && handler_.Key( Name, Kind );
+                if ( !Inline( Member ) ) {
+                    return false;
+                }
+                SkipSpace();
+                if ( Consume( '}' ) ) {
+                    break;
+                }
+                if ( !Consume( ',' ) ) {
+                    return Fail( "expected ',' or '}'" );
+                }
+                SkipSpace();
+            }
+        }
+        return CloseKeys( Keys );
+    }
+
+    // A plain scalar: a key when AsKey (ending before its ':'), otherwise
+    // a value, which ends at the line end, before a comment or, in a flow
+    // collection, before a ',' or a closing bracket.
+    bool Plain( std::string_view& Text, bool Flow, bool AsKey ) {
+        auto const Start = cur_;
+        switch ( *Start ) {
+            case '[': case ']': case '{': case '}': case ',':
+            case '#': case '&': case '*': case '!': case '|': case '>':
+            case '%': case '@': case '`': case '"': case '\'':
+                return Fail( "unsupported: indicator" );
+            case '-': case '?': case ':':
+                if ( Indicator( *Start ) ||
+                     ( Flow && end_ - Start > 1 && std::strchr( ",[]{}", Start[1] ) ) )
+                {
+                    return Fail( "unsupported: indicator" );
+                }
+                break;
+            default:
+                break;
+        }
+        for ( ;; ) {
+            if ( cur_ == end_ ) {
+                if ( AsKey ) {
+                    return Fail( "expected ': '" );
+                }
+                break;
+            }
+            auto const Ch = *cur_;
+            if ( Ch == ':' && ( cur_ + 1 == end_ || cur_[1] == ' ' ||
+                                ( Flow && std::strchr( ",[]{}", cur_[1] ) ) ) )
+            {
+                if ( AsKey ) {
+                    break;
+                }
+                return Fail( "unsupported: mapping in a value" );
+            }
+            if ( Ch == '#' && cur_[-1] == ' ' ) {
+                if ( AsKey ) {
+                    return Fail( "expected ': '" );
+                }
+                break;
+            }
+            if ( Ch == '\t' ) {
+                return Fail( "unsupported: tab" );
+            }
+            if ( Flow && ( Ch == ',' || Ch == ']' || Ch == '}' ) ) {
+                break;
+            }
+            if ( Flow && ( Ch == '[' || Ch == '{' ) ) {
+                return Fail( "unsupported: indicator" );
+            }
+            ++cur_;
+        }
+        auto Stop = cur_;
+        while ( Stop != Start && Stop[-1] == ' ' ) {
+            --Stop;
+        }
+        Text = std::string_view( Start, static_cast<std::size_t>( Stop - Start ) );
+        return true;
+    }
+
+    static int HexDigit( char Ch ) noexcept {
+        if ( Ch >= '0' && Ch <= '9' ) { return Ch - '0'; }
+        if ( Ch >= 'a' && Ch <= 'f' ) { return Ch - 'a' + 10; }
+        if ( Ch >= 'A' && Ch <= 'F' ) { return Ch - 'A' + 10; }
+        return -1;
+    }
+
+    void AppendUtf8( std::uint32_t Code ) {
+        if ( Code < 0x80 ) {
+            scratch_ += static_cast<char>( Code );
+        }
+        else if ( Code < 0x800 ) {
+            scratch_ += static_cast<char>( 0xC0 | ( Code >> 6 ) );
+            scratch_ += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else if ( Code < 0x10000 ) {
+            scratch_ += static_cast<char>( 0xE0 | ( Code >> 12 ) );
+            scratch_ += static_cast<char>( 0x80 | ( ( Code >> 6 ) & 0x3F ) );
+            scratch_ += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+        else {
+            scratch_ += static_cast<char>( 0xF0 | ( Code >> 18 ) );
+            scratch_ += static_cast<char>( 0x80 | ( ( Code >> 12 ) & 0x3F ) );
+            scratch_ += static_cast<char>( 0x80 | ( ( Code >> 6 ) & 0x3F ) );
+            scratch_ += static_cast<char>( 0x80 | ( Code & 0x3F ) );
+        }
+    }
+
+    bool Escape() {
+        if ( cur_ == end_ ) {
+            return Fail( "unsupported: multi-line scalar" );
+        }
+        std::size_t Digits {};
+        switch ( *cur_++ ) {
+            case '0':  scratch_ += '\0'; return true;
+            case 'a':  scratch_ += '\a'; return true;
+            case 'b':  scratch_ += '\b'; return true;
+            case 't':
+            case '\t': scratch_ += '\t'; return true;
+            case 'n':  scratch_ += '\n'; return true;
+            case 'v':  scratch_ += '\v'; return true;
+            case 'f':  scratch_ += '\f'; return true;
+            case 'r':  scratch_ += '\r'; return true;
+            case 'e':  scratch_ += '\x1B'; return true;
+            case ' ':  scratch_ += ' '; return true;
+            case '"':  scratch_ += '"'; return true;
+            case '/':  scratch_ += '/'; return true;
+            case '\\': scratch_ += '\\'; return true;
+            case 'N':  AppendUtf8( 0x85 ); return true;
+            case '_':  AppendUtf8( 0xA0 ); return true;
+            case 'L':  AppendUtf8( 0x2028 ); return true;
+            case 'P':  AppendUtf8( 0x2029 ); return true;
+            case 'x':  Digits = 2; break;
+            case 'u':  Digits = 4; break;
+            case 'U':  Digits = 8; break;
+            default:   return Fail( "invalid escape" );
+        }
+        if ( static_cast<std::size_t>( end_ - cur_ ) < Digits ) {
+            return Fail( "invalid escape" );
+        }
+        std::uint32_t Code {};
+        for ( std::size_t Idx = 0 ; Idx < Digits ; ++Idx ) {
+            auto const Digit = HexDigit( *cur_++ );
+            if ( Digit < 0 ) {
+                return Fail( "invalid escape" );
+            }
+            Code = Code * 16 + static_cast<std::uint32_t>( Digit );
+        }
+        if ( ( Code >= 0xD800 && Code < 0xE000 ) || Code > 0x10FFFF ) {
+            return Fail( "unsupported: escaped surrogate" );
+        }
+        AppendUtf8( Code );
+        return true;
+    }
+
+    // A single-line quoted scalar.  On success Text views its content:
+    // the source itself when it has no escapes, otherwise scratch_ (valid
+    // until the next quoted scalar is read).
+    bool Quoted( std::string_view& Text ) {
+        auto const Quote = *cur_;
+        auto const Start = ++cur_;
+        auto const Special = Quote == '"' ? '\\' : '\'';
+        while ( cur_ != end_ && *cur_ != Quote && *cur_ != Special ) {
+            ++cur_;
+        }
+        if ( cur_ == end_ ) {
+            return Fail( "unsupported: multi-line scalar" );
+        }
+        if ( *cur_ == Quote && ( Quote == '"' || cur_ + 1 == end_ || cur_[1] != '\'' ) ) {
+            Text = std::string_view( Start, static_cast<std::size_t>( cur_ - Start ) );
+            ++cur_;
+            return true;
+        }
+        scratch_.assign( Start, cur_ );
+        for ( ;; ) {
+            if ( cur_ == end_ ) {
+                return Fail( "unsupported: multi-line scalar" );
+            }
+            if ( Quote == '"' && *cur_ == '\\' ) {
+                ++cur_;
+                if ( !Escape() ) {
+                    return false;
+                }
+            }
+            else if ( *cur_ == Quote ) {
+                if ( Quote == '"' || cur_ + 1 == end_ || cur_[1] != '\'' ) {
+                    break;
+                }
+                scratch_ += '\'';
+                cur_ += 2;
+            }
+            else {
+                scratch_ += *cur_++;
+            }
+        }
+        ++cur_;
+        Text = scratch_;
+        return true;
+    }
+};
+
+} // End of namespace Detail
+
+/// Parses the UTF-8 YAML text [@p First, @p Last) in one pass and reports
+/// it to @p Handler, SAX style, without building a document.
+///
+/// @p Handler provides:
+/// @code
+/// bool StartMapping();                            // false: skip the mapping
+/// bool Key( std::string_view Name, TKind Kind );  // false: skip the value
+/// void EndMapping();
+/// bool StartSequence();                           // false: skip the sequence
+/// void EndSequence();
+/// void Scalar( std::string_view Text, TKind Kind );
+/// @endcode
+/// Skipped collections are still validated but produce no events (not
+/// even their @c End* call).  Views are only valid during the call.
+///
+/// Only the subset configuration files use is read: a single document of
+/// block mappings and sequences indented with spaces, with plain and
+/// quoted scalars and flow collections each on one line, comments and a
+/// leading @c --- and byte order mark.  Anything else (anchors, tags,
+/// block and multi-line scalars, complex keys, a mapping in a sequence
+/// entry, several documents, duplicate keys) fails, as invalid YAML does,
+/// so that the caller can fall back to a complete parser.  Exceptions
+/// thrown by @p Handler propagate.
+template<typename H>
+TResult Parse( char const * First, char const * Last, H& Handler,
+               std::size_t MaxDepth = DefaultMaxDepth )
+{
+    return Detail::TParser<H>( First, Last, Handler, MaxDepth ).Run();
+}
+
+//---------------------------------------------------------------------------
+} // End of namespace Sax
+//---------------------------------------------------------------------------
+} // End of namespace YAML
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,263 @@
+//---------------------------------------------------------------------------
+
+#ifndef CfgYAMLWriterH
+#define CfgYAMLWriterH
+
+// Portable, std-only header: nothing in here depends on the Embarcadero RTL,
+// so it can be compiled and benchmarked on any C++17 toolchain (see
+// Bench/bench_yaml_flush.cpp).
+
+#include <anafestica/CfgYAMLSax.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace Anafestica {
+//---------------------------------------------------------------------------
+namespace YAML {
+//---------------------------------------------------------------------------
+
+/// Sink that collects its input in memory.
+template<typename C = std::string>
+struct TMemorySink {
+    C& Out;
+
+    void Append( char const * Data, std::size_t Length ) {
+        Out.insert( Out.end(), Data, Data + Length );
+    }
+};
+
+/// Sink that gathers its input into blocks and passes each on to
+/// @p Out, with <tt>void Write( char const *, std::size_t )</tt>; input
+/// larger than a block goes straight through.  @ref Flush passes on what
+/// is left (the destructor does not).
+template<typename W>
+class TBufferedSink {
+public:
+    explicit TBufferedSink( W& Out, std::size_t Capacity = 64 * 1024 )
+        : out_{ Out }, capacity_{ Capacity }
+    {
+        buffer_.reserve( Capacity );
+    }
+
+    void Append( char const * Data, std::size_t Length ) {
+        if ( buffer_.size() + Length > capacity_ ) {
+            Flush();
+            if ( Length >= capacity_ ) {
+                out_.Write( Data, Length );
+                return;
+            }
+        }
+        buffer_.insert( buffer_.end(), Data, Data + Length );
+    }
+
+    void Flush() {
+        if ( !buffer_.empty() ) {
+            out_.Write( buffer_.data(), buffer_.size() );
+            buffer_.clear();
+        }
+    }
+private:
+    W& out_;
+    std::size_t capacity_;
+    std::vector<char> buffer_;
+};
+
+namespace Detail {
+
+/// Length of the UTF-8 sequence at @p Text that a plain scalar cannot
+/// hold and a double-quoted one has to escape (C1 controls, the byte
+/// order mark and the Unicode line and paragraph separators), or 0.
+inline std::size_t Unprintable( std::string_view Text ) noexcept {
+    auto const Lead = static_cast<unsigned char>( Text[0] );
+    if ( Lead == 0xC2 && Text.size() >= 2 ) {
+        auto const Trail = static_cast<unsigned char>( Text[1] );
+        return Trail >= 0x80 && Trail < 0xA0 ? 2 : 0;
+    }
+    if ( ( Text.substr( 0, 3 ) == "\xEF\xBB\xBF" ) ||
+         ( Text.substr( 0, 3 ) == "\xE2\x80\xA8" ) ||
+         ( Text.substr( 0, 3 ) == "\xE2\x80\xA9" ) )
+    {
+        return 3;
+    }
+    return 0;
+}
+
+/// Whether @p Text reads back as the same string when written plain, as
+/// a block mapping key or value, both by Sax::Parse and by a complete
+/// YAML 1.2 parser.
+inline bool IsPlain( std::string_view Text ) noexcept {
+    if ( Text.empty() || Sax::Detail::Resolve( Text ) != Sax::TKind::String ||
+         Text == "<<" )
+    {
+        return false;
+    }
+    switch ( Text.front() ) {
+        case '-': case '?': case ':': case ',': case '[': case ']':
+        case '{': case '}': case '#': case '&': case '*': case '!':
+        case '|': case '>': case '\'': case '"': case '%': case '@':
+        case '`': case ' ':
+            return false;
+        default:
+            break;
+    }
+    if ( Text.back() == ' ' || Text.back() == ':' ) {
+        return false;
+    }
+    for ( std::size_t Idx = 0 ; Idx < Text.size() ; ++Idx ) {
+        auto const Ch = static_cast<unsigned char>( Text[Idx] );
+        if ( Ch < 0x20 || Ch == 0x7F ||
+             ( Ch == ':' && Text[Idx + 1] == ' ' ) ||
+             ( Ch == '#' && Text[Idx - 1] == ' ' ) ||
+             ( Ch >= 0x80 && Unprintable( Text.substr( Idx ) ) ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // End of namespace Detail
+
+/// Lays out block-style YAML a line at a time, straight into a sink.
+///
+/// The caller drives the structure: @ref Key starts a mapping entry at a
+/// nesting depth (two spaces per level), and the entry is completed
+/// either on its line, by @ref String or @ref Token, or by the block that
+/// follows, after @ref Block.  @ref Item writes an entry of a block
+/// sequence of strings.  Strings, keys included, are written plain when
+/// @ref Detail::IsPlain allows, otherwise double-quoted and escaped, so
+/// that they read back as strings whatever they hold; lines end in LF.
+///
+/// @tparam S  Sink type, with <tt>void Append( char const *, std::size_t )</tt>.
+template<typename S>
+class TTextWriter {
+public:
+    explicit TTextWriter( S& Sink ) noexcept : sink_{ Sink } {}
+
+    /// Starts the entry @p Name of a mapping at @p Depth.
+    void Key( std::size_t Depth, std::string_view Name ) {
+        Indent( Depth );
+        Scalar( Name );
+        Append( ":" );
+    }
+
+    /// Completes the current entry with the string @p Text.
+    void String( std::string_view Text ) {
+        Append( " " );
+        Scalar( Text );
+        Append( "\n" );
+    }
+
+    /// Completes the current entry with @p Text, already a YAML token: a
+    /// number, a boolean or an empty flow collection.
+    void Token( std::string_view Text ) {
+        Append( " " );
+        Append( Text );
+        Append( "\n" );
+    }
+
+    /// Ends the current entry's line; its value is the block that follows.
+    void Block() { Append( "\n" ); }
+
+    /// Writes the string @p Text as an entry of a block sequence at
+    /// @p Depth.
+    void Item( std::size_t Depth, std::string_view Text ) {
+        Indent( Depth );
+        Append( "- " );
+        Scalar( Text );
+        Append( "\n" );
+    }
+private:
+    S& sink_;
+
+    void Append( std::string_view Text ) { sink_.Append( Text.data(), Text.size() ); }
+
+    void Indent( std::size_t Depth ) {
+        static constexpr std::string_view Spaces = "                                ";
+        for ( auto Width = 2 * Depth ; Width ; ) {
+            auto const Chunk = std::min( Width, Spaces.size() );
+            Append( Spaces.substr( 0, Chunk ) );
+            Width -= Chunk;
+        }
+    }
+
+    void Scalar( std::string_view Text ) {
+        if ( Detail::IsPlain( Text ) ) {
+            Append( Text );
+        }
+        else {
+            Quote( Text );
+        }
+    }
+
+    // Double-quoted, with the runs that need no escape appended as they
+    // are.
+    void Quote( std::string_view Text ) {
+        static constexpr char Hex[] = "0123456789ABCDEF";
+        Append( "\"" );
+        std::size_t Run = 0;
+        for ( std::size_t Idx = 0 ; Idx < Text.size() ; ) {
+            auto const Ch = static_cast<unsigned char>( Text[Idx] );
+            char const * Escape {};
+            char Code[5] = { '\\', 'x' };
+            std::size_t Length = 1;
+            switch ( Ch ) {
+                case '"':  Escape = "\\\""; break;
+                case '\\': Escape = "\\\\"; break;
+                case '\0': Escape = "\\0"; break;
+                case '\a': Escape = "\\a"; break;
+                case '\b': Escape = "\\b"; break;
+                case '\t': Escape = "\\t"; break;
+                case '\n': Escape = "\\n"; break;
+                case '\v': Escape = "\\v"; break;
+                case '\f': Escape = "\\f"; break;
+                case '\r': Escape = "\\r"; break;
+                case 0x1B: Escape = "\\e"; break;
+                default:
+                    if ( Ch < 0x20 || Ch == 0x7F ) {
+                        Code[2] = Hex[Ch >> 4];
+                        Code[3] = Hex[Ch & 0x0F];
+                        Escape = Code;
+                    }
+                    else if ( Ch >= 0x80 ) {
+                        Length = Detail::Unprintable( Text.substr( Idx ) );
+                        if ( Length == 2 ) {
+                            auto const Trail = static_cast<unsigned char>( Text[Idx + 1] );
+                            Code[2] = Hex[Trail >> 4];
+                            Code[3] = Hex[Trail & 0x0F];
+                            Escape = Code;
+                        }
+                        else if ( Length == 3 ) {
+                            Escape = Text[Idx] == '\xEF' ? "\\uFEFF"
+                                   : Text[Idx + 2] == '\xA8' ? "\\u2028" : "\\u2029";
+                        }
+                        else {
+                            Length = 1;
+                        }
+                    }
+                    break;
+            }
+            if ( Escape ) {
+                Append( Text.substr( Run, Idx - Run ) );
+                Append( Escape );
+                Run = Idx + Length;
+            }
+            Idx += Length;
+        }
+        Append( Text.substr( Run ) );
+        Append( "\"" );
+    }
+};
+
+//---------------------------------------------------------------------------
+} // End of namespace YAML
+//---------------------------------------------------------------------------
+} // End of namespace Anafestica
+//---------------------------------------------------------------------------
+
+#endif
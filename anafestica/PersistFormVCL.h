@@ -276,12 +276,12 @@ bool TPersistFormVCL<CfgSingleton>::HaveToSaveOrRestorePos( StoreOpts Val ) noex
 #define RESTORE_LOCAL_PROPERTY( PROPERTY ) \
 {\
     std::remove_reference_t< decltype( PROPERTY )> Tmp{ PROPERTY }; \
-    GetConfigNode().GetItem( #PROPERTY, Tmp ); \
+    GetConfigNode().GetItem( ANA_KEY( #PROPERTY ), Tmp ); \
     PROPERTY = Tmp; \
 }
 
 #define SAVE_LOCAL_PROPERTY( PROPERTY ) \
-    GetConfigNode().PutItem( #PROPERTY, PROPERTY )
+    GetConfigNode().PutItem( ANA_KEY( #PROPERTY ), PROPERTY )
 
 //---------------------------------------------------------------------------
 }; // End of namespace Anafestica
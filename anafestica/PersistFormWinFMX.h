@@ -243,12 +243,12 @@ bool TPersistFormWinFMX<CfgSingleton>::HaveToSaveOrRestorePos( StoreOpts Val ) n
 #define RESTORE_LOCAL_PROPERTY( PROPERTY ) \
 {\
     std::remove_reference_t< decltype( PROPERTY )> Tmp{ PROPERTY }; \
-    GetConfigNode().GetItem( #PROPERTY, Tmp ); \
+    GetConfigNode().GetItem( ANA_KEY( #PROPERTY ), Tmp ); \
     PROPERTY = Tmp; \
 }
 
 #define SAVE_LOCAL_PROPERTY( PROPERTY ) \
-    GetConfigNode().PutItem( #PROPERTY, PROPERTY )
+    GetConfigNode().PutItem( ANA_KEY( #PROPERTY ), PROPERTY )
 
 //---------------------------------------------------------------------------
 }; // End of namespace Anafestica